@@ -0,0 +1,71 @@
+struct PSInput
+{
+    float4 position : SV_POSITION;
+    float2 uv : UV0;
+    float2 local : LOCAL0;      // -1 to 1 over the quad.
+    nointerpolation float2 radiusThickness : RADIUS0;
+    nointerpolation uint shape : SHAPE0;
+    float4 color : COLOR0;
+};
+
+struct Constants
+{
+    float4x4 projection;
+};
+ConstantBuffer<Constants> constants : register(b0, space0);
+
+SamplerState texSampler : register(s0, space0);
+Texture2D texture : register(t0, space0);
+
+// Matches Shape2D.
+static const uint SHAPE_RECT = 0;
+static const uint SHAPE_CIRCLE = 1;
+
+// Two triangles per primitive: TL, TR, BL, TR, BR, BL.
+static const float2 s_Corners[6] =
+{
+    float2(-1.f, 1.f), float2(1.f, 1.f), float2(-1.f, -1.f),
+    float2(1.f, 1.f), float2(1.f, -1.f), float2(-1.f, -1.f)
+};
+
+PSInput VertexMain(float4 rect : RECT, float2 rotationThickness : ROTATION, float4 uvRect : UVRECT, uint2 colorShape : COLOR, uint vertexID : SV_VertexID)
+{
+    float2 corner = s_Corners[vertexID];
+    float2 offset = corner * rect.zw;
+    float s, c;
+    sincos(rotationThickness.x, s, c);
+    offset = float2(offset.x * c - offset.y * s, offset.x * s + offset.y * c);
+
+    uint color = colorShape.x;
+    PSInput result = (PSInput)0;
+    result.position = mul(constants.projection, float4(rect.xy + offset, 0.f, 1.0f)); // Clip space.
+    result.uv = lerp(uvRect.xy, uvRect.zw, float2(corner.x * 0.5f + 0.5f, 0.5f - corner.y * 0.5f)); // v goes down.
+    result.local = corner;
+    result.radiusThickness = float2(rect.z, rotationThickness.y);
+    result.shape = colorShape.y;
+    result.color = float4((color >> 24) & 0xFF, (color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF) / 255.f;
+    return result;
+}
+
+float4 PixelMain(PSInput input) : SV_TARGET
+{
+    float4 color = input.color;
+    if (input.shape == SHAPE_CIRCLE)
+    {
+        // Signed distance in pixels, antialiased over one pixel.
+        float radius = input.radiusThickness.x;
+        float thickness = input.radiusThickness.y;
+        float dist = length(input.local) * radius;
+        float alpha = saturate(radius - dist + 0.5f);
+        if (thickness > 0.f)
+            alpha *= saturate(dist - (radius - thickness) + 0.5f);
+        if (alpha <= 0.f)
+            discard;
+        color.a *= alpha;
+    }
+    else
+    {
+        color *= texture.Sample(texSampler, input.uv);
+    }
+    return color;
+}
@@ -20,11 +20,14 @@ void VertexMain(
 cbuffer Constants : register(b0)
 {
     float scale;
+    float flipY; // Non zero for textures that are stored top row first.
 }
 
 [RootSignature(Common_RootSig)]
 float3 PixelMain(float4 position : SV_Position, float2 uv : TexCoord0) : SV_Target0
 {
+    if (flipY != 0.f)
+        uv.y = 1.f - uv.y;
     float3 color = ATexture.SampleLevel(LinearFilter, uv*scale, 0);
     return color;
 }
\ No newline at end of file
@@ -2,31 +2,45 @@ struct PSInput
 {
     float4 position : SV_POSITION;
     float2 uv : UV0;
+    float4 color : COLOR0;
 };
 
 struct Constants
 {
     float4x4 projection;
-    float3 textColor;
     float threshold;
 };
 ConstantBuffer<Constants> constants : register(b0, space0);
 
-PSInput VertexMain(float4 position : SV_POSITION)
+SamplerState texSampler : register(s0, space0);
+Texture2D texture : register(t0, space0);
+
+// Two triangles per glyph: TL, TR, BL, TR, BR, BL. The y of the corner goes up, the v of the texture goes down.
+static const float2 s_Corners[6] =
+{
+    float2(0.f, 1.f), float2(1.f, 1.f), float2(0.f, 0.f),
+    float2(1.f, 1.f), float2(1.f, 0.f), float2(0.f, 0.f)
+};
+
+PSInput VertexMain(float4 rect : RECT, uint4 texRect : TEXRECT, uint color : COLOR, uint vertexID : SV_VertexID)
 {
+    float2 corner = s_Corners[vertexID];
+
+    // The atlas page can grow, so the glyph is placed in texels and divided by the current size here.
+    float2 textureSize;
+    texture.GetDimensions(textureSize.x, textureSize.y);
+
     PSInput result = (PSInput)0;
-    result.position = mul(constants.projection, float4(position.xy, 0.f, 1.0f)); // Clip space.
-    result.uv = position.zw;
+    result.position = mul(constants.projection, float4(rect.xy + corner * rect.zw, 0.f, 1.0f)); // Clip space.
+    result.uv = (float2(texRect.xy) + float2(corner.x, 1.f - corner.y) * float2(texRect.zw)) / textureSize;
+    result.color = float4((color >> 24) & 0xFF, (color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF) / 255.f;
     return result;
 }
 
-SamplerState texSampler : register(s0, space0);
-Texture2D texture : register(t0, space0);
-
 float4 PixelMain(PSInput input) : SV_TARGET
 {
     float dist = texture.Sample(texSampler, input.uv).r;
     if (dist < constants.threshold)
         discard;
-    return float4(constants.textColor, 1.f);
-}
\ No newline at end of file
+    return float4(input.color.rgb, 1.f);
+}
@@ -84,5 +84,5 @@ int main(int argc, char* argv[])
     RS::Display::Get()->Release();
     RS::Config::Get()->Destroy();
     RS::LaunchArguments::Release();
-    return 0;
+    return pEngineLoop->IsWithinPerfBudget() ? 0 : 1;
 }
\ No newline at end of file
@@ -130,29 +130,34 @@ void RS::AudioSystem::RemoveStream(Sound* pSoundStream)
 
 void RS::AudioSystem::LoadStreamFile(SoundHandle* pSoundHandle, const std::string& filePath)
 {
-	pSoundHandle->asEffect = false;
+	std::shared_ptr<VFSFile> pFile = VFS::Get()->Open(filePath);
+	RS_ASSERT(pFile, "Could not find sound stream file {}!", filePath.c_str());
 
-	// Get file type.
+	LoadStream(pSoundHandle, pFile, GetSoundType(filePath));
+}
 
-	std::string ext = filePath.substr(filePath.find_last_of(".") + 1);
-	if (ext == "mp3") pSoundHandle->type = SoundHandle::Type::TYPE_MP3;
-	if (ext == "wav") pSoundHandle->type = SoundHandle::Type::TYPE_WAV;
+void RS::AudioSystem::LoadStream(SoundHandle* pSoundHandle, std::shared_ptr<VFSFile> pFile, SoundHandle::Type type)
+{
+	pSoundHandle->asEffect = false;
+	pSoundHandle->type = type;
 
-	RS_ASSERT(std::filesystem::exists(filePath), "Could not find sound effect file {}!", filePath.c_str());
+	// The decoders read from the file while streaming, the handle keeps it alive.
+	pSoundHandle->pFile = pFile;
+	const std::string& filePath = pFile->GetPath();
 
 	// Load file.
 	switch (pSoundHandle->type)
 	{
 	case SoundHandle::Type::TYPE_MP3:
 	{
-		RS_ASSERT(drmp3_init_file(&pSoundHandle->mp3, filePath.c_str(), NULL), "Failed to load sound {} of type mp3!", filePath.c_str());
+		RS_ASSERT(drmp3_init_memory(&pSoundHandle->mp3, pFile->GetPtr(), pFile->GetSize(), NULL), "Failed to load sound {} of type mp3!", filePath.c_str());
 		pSoundHandle->nChannels = pSoundHandle->mp3.channels;
 		pSoundHandle->sampleRate = pSoundHandle->mp3.sampleRate;
 	}
 	break;
 	case SoundHandle::Type::TYPE_WAV:
 	{
-		RS_ASSERT(drwav_init_file(&pSoundHandle->wav, filePath.c_str(), NULL), "Failed to load sound {} of type wav!", filePath.c_str());
+		RS_ASSERT(drwav_init_memory(&pSoundHandle->wav, pFile->GetPtr(), pFile->GetSize(), NULL), "Failed to load sound {} of type wav!", filePath.c_str());
 		pSoundHandle->nChannels = pSoundHandle->wav.channels;
 		pSoundHandle->sampleRate = pSoundHandle->wav.sampleRate;
 	}
@@ -165,14 +170,20 @@ void RS::AudioSystem::LoadStreamFile(SoundHandle* pSoundHandle, const std::strin
 
 void RS::AudioSystem::LoadEffectFile(SoundHandle* pSoundHandle, const std::string& filePath, PaSampleFormat format)
 {
-	pSoundHandle->asEffect = true;
+	std::shared_ptr<VFSFile> pFile = VFS::Get()->Open(filePath);
+	RS_ASSERT(pFile, "Could not find sound effect file {}!", filePath.c_str());
 
-	// Get file type.
-	std::string ext = filePath.substr(filePath.find_last_of(".") + 1);
-	if (ext == "mp3") pSoundHandle->type = SoundHandle::Type::TYPE_MP3;
-	if (ext == "wav") pSoundHandle->type = SoundHandle::Type::TYPE_WAV;
+	LoadEffect(pSoundHandle, pFile, GetSoundType(filePath), format);
+}
 
-	RS_ASSERT(std::filesystem::exists(filePath), "Could not find sound effect file {}!", filePath.c_str());
+void RS::AudioSystem::LoadEffect(SoundHandle* pSoundHandle, std::shared_ptr<VFSFile> pFile, SoundHandle::Type type, PaSampleFormat format)
+{
+	pSoundHandle->asEffect = true;
+	pSoundHandle->type = type;
+
+	// Effects are decoded up front, the wav handle still reads from the file.
+	pSoundHandle->pFile = pFile;
+	const std::string& filePath = pFile->GetPath();
 
 	// Load file.
 	switch (pSoundHandle->type)
@@ -181,21 +192,20 @@ void RS::AudioSystem::LoadEffectFile(SoundHandle* pSoundHandle, const std::strin
 	{
 		drmp3_config config = {};
 		if (format == paFloat32)
-			pSoundHandle->directDataF32 = drmp3_open_file_and_read_pcm_frames_f32(filePath.c_str(), &config, &pSoundHandle->totalFrameCount, NULL);
+			pSoundHandle->directDataF32 = drmp3_open_memory_and_read_pcm_frames_f32(pFile->GetPtr(), pFile->GetSize(), &config, &pSoundHandle->totalFrameCount, NULL);
 		else if (format == paInt16)
-			pSoundHandle->directDataI16 = drmp3_open_file_and_read_pcm_frames_s16(filePath.c_str(), &config, &pSoundHandle->totalFrameCount, NULL);
+			pSoundHandle->directDataI16 = drmp3_open_memory_and_read_pcm_frames_s16(pFile->GetPtr(), pFile->GetSize(), &config, &pSoundHandle->totalFrameCount, NULL);
 		pSoundHandle->nChannels = config.channels;
 		pSoundHandle->sampleRate = config.sampleRate;
 	}
 	break;
 	case SoundHandle::Type::TYPE_WAV:
 	{
-		drmp3_config config = {};
 		if (format == paFloat32)
-			pSoundHandle->directDataF32 = drwav_open_file_and_read_pcm_frames_f32(filePath.c_str(), &pSoundHandle->nChannels, &pSoundHandle->sampleRate, &pSoundHandle->totalFrameCount, NULL);
+			pSoundHandle->directDataF32 = drwav_open_memory_and_read_pcm_frames_f32(pFile->GetPtr(), pFile->GetSize(), &pSoundHandle->nChannels, &pSoundHandle->sampleRate, &pSoundHandle->totalFrameCount, NULL);
 		if (format == paInt16)
-			pSoundHandle->directDataI16 = drwav_open_file_and_read_pcm_frames_s16(filePath.c_str(), &pSoundHandle->nChannels, &pSoundHandle->sampleRate, &pSoundHandle->totalFrameCount, NULL);
-		RS_ASSERT(drwav_init_file(&pSoundHandle->wav, filePath.c_str(), NULL), "Failed to load sound {} of type wav!", filePath.c_str());
+			pSoundHandle->directDataI16 = drwav_open_memory_and_read_pcm_frames_s16(pFile->GetPtr(), pFile->GetSize(), &pSoundHandle->nChannels, &pSoundHandle->sampleRate, &pSoundHandle->totalFrameCount, NULL);
+		RS_ASSERT(drwav_init_memory(&pSoundHandle->wav, pFile->GetPtr(), pFile->GetSize(), NULL), "Failed to load sound {} of type wav!", filePath.c_str());
 	}
 	break;
 	default:
@@ -204,6 +214,14 @@ void RS::AudioSystem::LoadEffectFile(SoundHandle* pSoundHandle, const std::strin
 	}
 }
 
+RS::SoundHandle::Type RS::AudioSystem::GetSoundType(const std::string& filePath)
+{
+	std::string ext = filePath.substr(filePath.find_last_of(".") + 1);
+	if (ext == "mp3") return SoundHandle::Type::TYPE_MP3;
+	if (ext == "wav") return SoundHandle::Type::TYPE_WAV;
+	return SoundHandle::Type::TYPE_NON;
+}
+
 void RS::AudioSystem::DrawAudioSettings()
 {
 	static bool my_tool_active = true;
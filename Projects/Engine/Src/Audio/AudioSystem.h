@@ -39,6 +39,11 @@ namespace RS
 		static void LoadStreamFile(SoundHandle* pSoundHandle, const std::string& filePath);
 		static void LoadEffectFile(SoundHandle* pSoundHandle, const std::string& filePath, PaSampleFormat format);
 
+		// Decodes from a file that is already open, e.g. from a pak. The handle keeps the file alive.
+		static void LoadStream(SoundHandle* pSoundHandle, std::shared_ptr<VFSFile> pFile, SoundHandle::Type type);
+		static void LoadEffect(SoundHandle* pSoundHandle, std::shared_ptr<VFSFile> pFile, SoundHandle::Type type, PaSampleFormat format);
+		static SoundHandle::Type GetSoundType(const std::string& filePath);
+
 		// Debug
 		void DrawAudioSettings();
 
@@ -4,6 +4,8 @@
 #include "dr_mp3.h"
 #include "dr_wav.h"
 
+#include "Core/VFS.h"
+
 #define DEFAULT_SAMPLE_RATE 44100
 
 namespace RS
@@ -26,5 +28,8 @@ namespace RS
 		int16* directDataI16{ nullptr };
 		uint32 nChannels{ 0 };
 		uint64 totalFrameCount{ 0 };
+
+		// The decoders read from this memory.
+		std::shared_ptr<VFSFile> pFile;
 	};
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include "PreCompiled.h"
 #include "PCMFunctions.h"
 
+#include "Utils/Timer.h"
+
 #include <limits>
 #include <glm/gtx/vector_angle.hpp>
 
@@ -25,6 +27,8 @@ void RS::PCM::SetPos(SoundHandle* pHandle, uint64 newPos)
 
 int RS::PCM::PaCallbackPCM(const void* pInputBuffer, void* pOutputBuffer, unsigned long framesPerBuffer, const PaStreamCallbackTimeInfo* pTimeInfo, PaStreamCallbackFlags statusFlags, void* pUserData)
 {
+	const uint64 begin = Timer::GetCurrentTick();
+
 	UserData* pData = (UserData*)pUserData;
 	uint64 framesRead = ReadPCM(pData, framesPerBuffer, pOutputBuffer);
 	OutputData outputData = GetOutputData(pData, pOutputBuffer);
@@ -50,7 +54,10 @@ int RS::PCM::PaCallbackPCM(const void* pInputBuffer, void* pOutputBuffer, unsign
 		ApplyToEar(pData, &outputData, { leftEar * volume, rightEar * volume });
 	}
 
-	return Finish(pData, framesRead, framesPerBuffer, shouldContinue);
+	const int result = Finish(pData, framesRead, framesPerBuffer, shouldContinue);
+	if (pData->profilerTrack)
+		Profiler::RecordZone(pData->profilerTrack, "Audio Callback", begin, Timer::GetCurrentTick(), 0);
+	return result;
 }
 
 uint64 RS::PCM::ReadPCMFrames(SoundHandle* pHandle, uint64 framesToRead, PaSampleFormat format, void* pOutBuffer)
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "PortAudio.h"
+#include "Core/Profiler.h"
 #include "DR/dr_helper.h"
 #include "Filters/Filter.h"
 #include "SoundData.h"
@@ -31,6 +32,7 @@ namespace RS
 			bool finished = false;
 			PaSampleFormat sampleFormat = paFloat32;
 			std::vector<Filter*> filters;
+			Profiler::TrackHandle profilerTrack = nullptr; // The callback times itself on this track, it must not take the profiler lock.
 		};
 
 		static void SetPos(SoundHandle* pHandle, uint64 newPos);
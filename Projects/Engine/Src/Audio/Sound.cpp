@@ -7,6 +7,7 @@
 #include "Core/LaunchArguments.h"
 
 #include "Core/CorePlatform.h"
+#include "Core/Profiler.h"
 
 RS::Sound::Sound(PortAudio* pPortAudioPtr)
     : m_pPortAudioPtr(pPortAudioPtr)
@@ -23,6 +24,10 @@ void RS::Sound::Init(PCM::UserData* pUserData)
 	m_pUserData = pUserData;
 	//m_pUserData->delayBuffer.Init(pUserData->handle.sampleRate);
 
+	// PortAudio calls back on a realtime thread, so its track is made here instead of from the callback.
+	Profiler* pProfiler = Profiler::Get();
+	m_pUserData->profilerTrack = pProfiler->GetTrackHandle(pProfiler->AddTrack("Audio Callback"));
+
 	PaStreamParameters outputParameters;
 	outputParameters.device = m_pPortAudioPtr->GetDeviceIndex();
 	outputParameters.channelCount = 2;
@@ -6,6 +6,8 @@
 #include <stb_image.h>
 
 #include "GUI/LogNotifier.h"
+#include "Core/VFS.h"
+#include "Core/Profiler.h"
 
 #include <thread>
 
@@ -62,12 +64,25 @@ std::string RS::CorePlatform::GetConfigurationAsStr() const
 std::unique_ptr<RS::CorePlatform::Image> RS::CorePlatform::LoadImageData(const std::string& path, Format requestedFormat, ImageFlags flags, bool isInternalPath)
 {
 	std::string texturePath = Engine::GetDataFilePath(isInternalPath) + RS_TEXTURE_PATH + path;
+	std::shared_ptr<VFSFile> pFile = VFS::Get()->Open(texturePath);
+	if (!pFile)
+	{
+		LOG_ERROR("Could not load texture! Cannot open file: {}", texturePath.c_str());
+		RS_NOTIFY_ERROR("Could not load texture! Cannot open file: {}", texturePath.c_str());
+		return nullptr;
+	}
+
+	return LoadImageDataFromMemory(pFile->GetData(), requestedFormat, flags);
+}
+
+std::unique_ptr<RS::CorePlatform::Image> RS::CorePlatform::LoadImageDataFromMemory(std::span<const uint8> data, Format requestedFormat, ImageFlags flags)
+{
 	FormatInfo requestedFormatInfo = GetFormatInfo(requestedFormat);
 
 	std::unique_ptr<RS::CorePlatform::Image> pImage = std::make_unique<RS::CorePlatform::Image>();
 	int width, height, channelCount;
 	const int requestedChannelCount = requestedFormatInfo.channelCount;
-	pImage->pData = stbi_load(texturePath.c_str(), &width, &height, &channelCount, requestedChannelCount);
+	pImage->pData = stbi_load_from_memory(data.data(), (int)data.size(), &width, &height, &channelCount, requestedChannelCount);
 	if (pImage->pData == nullptr)
 	{
 		LOG_ERROR("Could not load texture!Reason: {}", stbi_failure_reason());
@@ -107,24 +122,22 @@ RS::CorePlatform::BinaryFile RS::CorePlatform::LoadBinaryFile(const std::string&
 {
 	BinaryFile file;
 
-	FILE* pFile = stbi__fopen(path.c_str(), "rb");
-	uint8* pData = nullptr;
+	std::shared_ptr<VFSFile> pFile = VFS::Get()->Open(path);
 	if (!pFile)
 	{
-		LOG_ERROR("[LoadFileData] Cannot open file!");
+		LOG_ERROR("[LoadFileData] Cannot open file! File: {}", path.c_str());
 		return file;
 	}
 
-	fseek(pFile, 0, SEEK_END);
-	file.size = ftell(pFile);
-	fseek(pFile, (long)offset, SEEK_SET);
-
-	uint8* pContent = new uint8[file.size];
-	fread(pContent, 1, file.size, pFile);
-
-	fclose(pFile);
+	if (offset > pFile->GetSize())
+	{
+		LOG_ERROR("[LoadFileData] Offset is outside of the file! File: {}, Offset: {}, Size: {}", path.c_str(), offset, pFile->GetSize());
+		return file;
+	}
 
-	file.pData = std::unique_ptr<uint8>(pContent);
+	file.size = pFile->GetSize() - offset;
+	file.pData = std::make_unique_for_overwrite<uint8[]>(file.size);
+	std::memcpy(file.pData.get(), pFile->GetPtr() + offset, file.size);
 	return file;
 }
 
@@ -157,6 +170,8 @@ void RS::CorePlatform::SetCurrentThreadName(const std::string& name)
 	std::wstring wname = Utils::ToWString(name);
 	HRESULT hr = SetThreadDescription(GetCurrentThread(), wname.c_str());
 	RS_ASSERT(SUCCEEDED(hr), "Failed to set name of current thread!");
+
+	Profiler::Get()->SetThreadName(name);
 }
 
 void RS::CorePlatform::ThreadSleep(uint64 milliseconds)
@@ -171,6 +186,15 @@ uint RS::CorePlatform::GetCoreCount(uint defaultCount)
 	return hardwareCount == 0u ? defaultCount : hardwareCount;
 }
 
+#include <psapi.h> // Used for GetProcessMemoryInfo
+uint64 RS::CorePlatform::GetProcessMemoryUsage()
+{
+	PROCESS_MEMORY_COUNTERS_EX counters = {};
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), (PROCESS_MEMORY_COUNTERS*)&counters, sizeof(counters)))
+		return 0;
+	return (uint64)counters.PrivateUsage;
+}
+
 #include <shlobj.h> // Used for SHGetFolderPathW
 std::string RS::CorePlatform::CreateTemporaryPath()
 {
@@ -2,6 +2,8 @@
 
 #include "Format.h"
 
+#include <span>
+
 namespace RS
 {
 	class CorePlatform
@@ -33,10 +35,14 @@ namespace RS
 			Format format;
 		};
 		static std::unique_ptr<Image> LoadImageData(const std::string& path, Format requestedFormat, ImageFlags flags = ImageFlag::NONE, bool isInternalPath = false);
+		static std::unique_ptr<Image> LoadImageDataFromMemory(std::span<const uint8> data, Format requestedFormat, ImageFlags flags = ImageFlag::NONE);
 
+		/*
+		* Copies the file, prefer VFS::Get()->Open() when the data does not have to outlive the file.
+		*/
 		struct BinaryFile
 		{
-			std::unique_ptr<uint8> pData = nullptr;
+			std::unique_ptr<uint8[]> pData = nullptr;
 			uint64 size = 0;
 		};
 		static BinaryFile LoadBinaryFile(const std::string& path, uint32 offset = 0);
@@ -46,6 +52,8 @@ namespace RS
 		static void SetCurrentThreadName(const std::string& name);
 		static void ThreadSleep(uint64 milliseconds);
 		static uint GetCoreCount(uint defaultCount = 8);
+		// Bytes of committed memory the process uses, 0 if it could not be read.
+		static uint64 GetProcessMemoryUsage();
 
 	private:
 		std::string CreateTemporaryPath();
@@ -1,6 +1,8 @@
 #include "PreCompiled.h"
 #include "Display.h"
 
+#include "Core/LaunchArguments.h"
+
 #define GLFW_EXPOSE_NATIVE_WIN32
 #include <GLFW/glfw3native.h>
 
@@ -26,6 +28,14 @@ void RS::Display::Init(const DisplayDescription& description)
 	glfwWindowHint(GLFW_FOCUSED, GL_TRUE);
 	m_HasFocus = true;
 
+	// The swap chain still needs a window, a hidden one is as close to headless as it gets.
+	if (LaunchArguments::Contains(LaunchParams::hiddenWindow))
+	{
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		glfwWindowHint(GLFW_FOCUSED, GLFW_FALSE);
+		m_Description.Fullscreen = false;
+	}
+
 	glfwSetErrorCallback(Display::ErrorCallback);
 
 	m_PreWidth = m_Description.Width;
@@ -8,15 +8,26 @@
 //#include "Raytracing.hlsl.h"
 
 #include "DX12/Final/DXCore.h"
+#include "DX12/Final/DXPipelineCache.h"
 
 #include "Core/Console.h"
+#include "Core/Profiler.h"
+#include "Core/VFS.h"
+#include "Loaders/Texture/TextureCooker.h"
+#include "Loaders/Mesh/MeshCooker.h"
+#include "Render/GPUProfiler.h"
+#include "Render/TextureStreamer.h"
+#include "DX12/Final/DXTextureStreamingDevice.h"
 
 // TODO: Remove this when in relase build!
 #include "Render/ImGuiRenderer.h"
 
 #include "Graphics/RenderCore.h"
+#include "Graphics/InstanceStream.h"
 #include "Audio/AudioSystem.h"
 
+#include <filesystem>
+
 using namespace RS;
 
 const wchar_t* EngineLoop::c_hitGroupName = L"MyHitGroup";
@@ -33,6 +44,20 @@ std::shared_ptr<EngineLoop> EngineLoop::Get()
 void EngineLoop::Init()
 {
     Console::Get()->Init();
+
+    // Assets are read from the pak when one has been cooked, loose files are used for anything it does not have.
+    // In development builds the loose directory is mounted above the pak, edited files then win over the cooked ones and hot reload sees them.
+    for (bool isInternal : { false, true })
+    {
+        const std::string dataPath = Engine::GetDataFilePath(isInternal);
+        if (isInternal && dataPath == Engine::GetDataFilePath(false))
+            continue;
+        if (!std::filesystem::exists(dataPath + "Assets.pak") || !VFS::Get()->MountPak(dataPath, dataPath + "Assets.pak"))
+            continue;
+#ifdef RS_CONFIG_DEVELOPMENT
+        VFS::Get()->MountDirectory(dataPath, dataPath);
+#endif
+    }
     RS::Input::Get()->AlwaysListenToKey(RS::Key::MICRO); // For console.
 
     m_RenderDoc.Init();
@@ -43,6 +68,9 @@ void EngineLoop::Init()
 
     GetRenderCore()->Init();
 
+    m_pTextureStreamingDevice = std::make_shared<DX12::DXTextureStreamingDevice>();
+    m_pTextureStreamer = std::make_shared<TextureStreamer>(m_pTextureStreamingDevice, std::make_shared<DDSStreamingSource>());
+
     AudioSystem::Get()->Init();
 
     m_DebugWindowsManager.Init();
@@ -52,12 +80,22 @@ void EngineLoop::Init()
 
 void EngineLoop::Release()
 {
+    // Closes the recording, if there is one.
+    RS::Input::Get()->Release();
+
     m_DebugWindowsManager.Destory();
 
     AudioSystem::Get()->Destroy();
 
+    m_pTextureStreamer.reset();
+    m_pTextureStreamingDevice.reset();
+
     GetRenderCore()->Destory();
 
+    // Saved here since the core is not destroyed until the process ends.
+    if (RS::DX12::DXPipelineCache* pPipelineCache = RS::DX12::DXCore::GetPipelineCache())
+        pPipelineCache->Save();
+
     DX12Core3::Get()->Release();
 
     Console::Get()->Release();
@@ -68,14 +106,21 @@ void EngineLoop::Run()
     std::shared_ptr<RS::Display> pDisplay = RS::Display::Get();
 
     m_FrameTimer.Init(&m_FrameStats, 0.25f);
+    Profiler::Get()->SetThreadName("Main Thread");
     while (!pDisplay->ShouldClose())
     {
+        // A replay runs exactly one fixed update per frame, so the same input gives the same frames.
+        if (RS::Input::Get()->IsReplaying())
+            m_FrameTimer.SetFixedFrameDT(1.f / m_FrameStats.fixedUpdate.fixedFPS);
         m_FrameTimer.Begin();
 
         m_RenderDoc.StartFrameCapture();
 
-        pDisplay->PollEvents();
-        RS::Input::Get()->PreUpdate();
+        {
+            RS_PROFILE_SCOPE("Poll Events");
+            pDisplay->PollEvents();
+            RS::Input::Get()->PreUpdate();
+        }
 
         // Quit by pressing ESCAPE
         {
@@ -83,6 +128,12 @@ void EngineLoop::Run()
                 pDisplay->Close();
         }
 
+        // Quit when there is nothing more to replay
+        {
+            if (RS::Input::Get()->IsReplayFinished())
+                pDisplay->Close();
+        }
+
         // Toggle fullscreen by pressing F11
         {
             if (RS::Input::Get()->IsKeyClicked(RS::Key::F11))
@@ -103,15 +154,19 @@ void EngineLoop::Run()
 
         m_FrameTimer.FixedTick( [&]()
             {
+                RS_PROFILE_SCOPE("Fixed Tick");
                 FixedTick();
                 // TODO: Remove this when in Relase build!
                 m_DebugWindowsManager.FixedTick();
             });
         Tick(m_FrameStats);
+        m_FrameStats.upload.instanceBytes = InstanceStreamBase::TakeUploadedBytes();
+        m_FrameStats.frame.gpuMs = RS::DX12::DXCore::GetGPUProfiler()->TakeResolvedGPUMs();
 
         // TODO: Remove this when in Relase build!
         RS::ImGuiRenderer::Get()->Draw([&]()
             {
+                RS_PROFILE_SCOPE("Debug Windows");
                 m_DebugWindowsManager.Render();
             });
 
@@ -120,7 +175,10 @@ void EngineLoop::Run()
         m_RenderDoc.EndFrameCapture();
 
         m_FrameTimer.End();
+        Profiler::Get()->EndFrame();
     }
+
+    m_IsWithinPerfBudget = m_FrameTimer.FinishRun();
 }
 
 void EngineLoop::FixedTick()
@@ -131,14 +189,29 @@ void EngineLoop::FixedTick()
 
 void EngineLoop::Tick(const RS::FrameStats& frameStats)
 {
+    RS_PROFILE_SCOPE("Tick");
     m_CurrentFrameNumber++;
 
     if (additionalTickFunction)
+    {
+        RS_PROFILE_SCOPE("Game Tick");
         additionalTickFunction(frameStats);
+    }
 
-    AudioSystem::Get()->Update();
+    {
+        RS_PROFILE_SCOPE("Audio Update");
+        AudioSystem::Get()->Update();
+    }
 
-    DX12Core3::Get()->Render();
+    {
+        RS_PROFILE_SCOPE("Texture Streaming");
+        m_pTextureStreamer->Update();
+    }
+
+    {
+        RS_PROFILE_SCOPE("Render");
+        DX12Core3::Get()->Render();
+    }
 }
 
 uint64 RS::EngineLoop::GetCurrentFrameNumber()
@@ -683,10 +756,6 @@ void RS::EngineLoop::CopyRaytracingOutputToBackbuffer()
     commandList->ResourceBarrier(ARRAYSIZE(postCopyBarriers), postCopyBarriers);
 }
 
-void RS::EngineLoop::CalculateFrameStats()
-{
-}
-
 UINT RS::EngineLoop::AllocateDescriptor(D3D12_CPU_DESCRIPTOR_HANDLE* cpuDescriptor, UINT descriptorIndexToUse)
 {
     auto descriptorHeapCpuBase = m_descriptorHeap->GetCPUDescriptorHandleForHeapStart();
@@ -707,4 +776,61 @@ void RS::EngineLoop::InitConsoleCommands()
         },
         Console::Flag::NONE, "Quit the application."
     );
+
+    auto cookTextures = [](bool force)->bool
+        {
+            const std::string dataPath = Engine::GetDataFilePath(false);
+            return TextureCooker::CookDirectory(dataPath + RS_TEXTURE_PATH, dataPath + "Cooked/" + RS_TEXTURE_PATH, TextureCookSettings(), force) == 0;
+        };
+    Console::Get()->AddFunction("Textures.Cook", [cookTextures](Console::FuncArgs args)->bool { return cookTextures(false); },
+        Console::Flag::NONE, "Cook the textures that changed since they were last cooked into Cooked/Textures/ as DDS."
+    );
+    Console::Get()->AddFunction("Textures.CookAll", [cookTextures](Console::FuncArgs args)->bool { return cookTextures(true); },
+        Console::Flag::NONE, "Cook all textures into Cooked/Textures/ as DDS, even the ones that are up to date."
+    );
+
+    auto cookMeshes = [](bool force)->bool
+        {
+            const std::string dataPath = Engine::GetDataFilePath(false);
+            return MeshCooker::CookDirectory(dataPath + RS_MODEL_PATH, dataPath + "Cooked/" + RS_MODEL_PATH, MeshCookSettings(), force) == 0;
+        };
+    Console::Get()->AddFunction("Meshes.Cook", [cookMeshes](Console::FuncArgs args)->bool { return cookMeshes(false); },
+        Console::Flag::NONE, "Cook the FBX models that changed since they were last cooked into Cooked/Models/ as indexed, quantized meshes."
+    );
+    Console::Get()->AddFunction("Meshes.CookAll", [cookMeshes](Console::FuncArgs args)->bool { return cookMeshes(true); },
+        Console::Flag::NONE, "Cook all FBX models into Cooked/Models/, even the ones that are up to date."
+    );
+
+    Console::Get()->AddFunction("Textures.StreamingBudget", [this](Console::FuncArgs args)->bool
+        {
+            if (!Console::ValidateFuncArgs(args, { {Console::FuncArg::TypeFlag::Int} }, Console::ValidateFuncArgsFlag::ArgCountMustMatch | Console::ValidateFuncArgsFlag::TypeMatchOnly))
+                return false;
+
+            m_pTextureStreamer->SetBudget(args[0].value * 1024 * 1024);
+            return true;
+        },
+        Console::Flag::NONE, "Set the memory budget of streamed textures in MiB."
+    );
+    Console::Get()->AddFunction("Textures.StreamingStats", [this](Console::FuncArgs args)->bool
+        {
+            const TextureStreamerStats stats = m_pTextureStreamer->GetStats();
+            Console::Get()->Print("{} textures, {:.1f} / {:.1f} MiB resident, {:.1f} MiB pending in {} reads",
+                stats.textureCount, stats.residentBytes / (1024.0 * 1024.0), stats.budgetBytes / (1024.0 * 1024.0),
+                stats.pendingBytes / (1024.0 * 1024.0), stats.requestsInFlight);
+            Console::Get()->Print("{} mips uploaded, {} mips evicted", stats.uploadedMipCount, stats.evictedMipCount);
+            return true;
+        },
+        Console::Flag::NONE, "Print the state of the texture streamer."
+    );
+
+    Console::Get()->AddFunction("Profiler.Export", [](Console::FuncArgs args)->bool
+        {
+            const std::string path = Engine::GetDebugFilePath() + "Profile.json";
+            if (!Profiler::Get()->ExportChromeTrace(path))
+                return false;
+            Console::Get()->Print("Exported {} frames to {}, open it in chrome://tracing or Perfetto.", Profiler::Get()->GetFrameCount(), path);
+            return true;
+        },
+        Console::Flag::NONE, "Write the frames the profiler kept to Profile.json in the debug folder as a Chrome trace."
+    );
 }
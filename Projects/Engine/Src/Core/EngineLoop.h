@@ -11,6 +11,9 @@
 
 namespace RS
 {
+    class TextureStreamer;
+    namespace DX12 { class DXTextureStreamingDevice; }
+
     namespace GlobalRootSignatureParams {
         enum Value {
             OutputViewSlot = 0,
@@ -45,6 +48,13 @@ namespace RS
 
         static uint64 GetCurrentFrameNumber();
 
+        // False when Run ended over the budget given with -perfBudget, the process should exit with an error then.
+        bool IsWithinPerfBudget() const { return m_IsWithinPerfBudget; }
+
+        TextureStreamer* GetTextureStreamer() { return m_pTextureStreamer.get(); }
+        // Has the DXTexture of each streamed texture.
+        DX12::DXTextureStreamingDevice* GetTextureStreamingDevice() { return m_pTextureStreamingDevice.get(); }
+
         std::function<void(void)> additionalFixedTickFunction;
         std::function<void(const FrameStats&)> additionalTickFunction;
 	private:
@@ -71,7 +81,6 @@ namespace RS
         void BuildShaderTables();
         void UpdateForSizeChange(UINT clientWidth, UINT clientHeight);
         void CopyRaytracingOutputToBackbuffer();
-        void CalculateFrameStats();
         UINT AllocateDescriptor(D3D12_CPU_DESCRIPTOR_HANDLE* cpuDescriptor, UINT descriptorIndexToUse = UINT_MAX);
 
         void InitConsoleCommands();
@@ -79,9 +88,13 @@ namespace RS
 	private:
 		FrameStats m_FrameStats = {};
 		FrameTimer m_FrameTimer;
+		bool m_IsWithinPerfBudget = true;
 
         inline static uint64 m_CurrentFrameNumber = 0;
 
+        std::shared_ptr<DX12::DXTextureStreamingDevice> m_pTextureStreamingDevice;
+        std::shared_ptr<TextureStreamer> m_pTextureStreamer;
+
 		// ---------------- Raytracing variables ----------------
 		static const UINT                   FrameCount = 3;
 
@@ -5,6 +5,7 @@
 #include <thread>
 
 #include "Core/CorePlatform.h"
+#include "Core/Profiler.h"
 #include <chrono>
 #include <string>
 
@@ -154,6 +155,7 @@ void RS::FileWatcher::ThreadFunction(const std::string& threadName)
     {
         CorePlatform::ThreadSleep(m_Delay);
 
+        RS_PROFILE_SCOPE("File Watcher");
         std::lock_guard<std::mutex> lock(m_FileMutex);
 
         // Check if any file was removed
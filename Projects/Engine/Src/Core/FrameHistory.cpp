@@ -0,0 +1,307 @@
+#include "PreCompiled.h"
+#include "FrameHistory.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+
+namespace RS::_FrameHistoryInternal
+{
+	constexpr uint32 MaxBits = 36;
+	constexpr uint32 BucketCount = (MaxBits - DurationHistogram::SubBucketBits + 2) * DurationHistogram::SubBucketHalfCount;
+
+	bool OpenForExport(const std::string& path, std::ofstream& stream)
+	{
+		std::filesystem::path directory = std::filesystem::path(path).parent_path();
+		if (!directory.empty())
+			std::filesystem::create_directories(directory);
+
+		stream.open(path, std::ios::out | std::ios::trunc);
+		if (!stream.is_open())
+		{
+			LOG_WARNING("Failed to open {} to export the frame history!", path.c_str());
+			return false;
+		}
+		return true;
+	}
+
+	void WritePercentiles(std::ostream& stream, const char* pName, const FrameHistorySummary::Percentiles& percentiles)
+	{
+		stream << "\"" << pName << "\":{\"p50Ms\":" << percentiles.p50Ms << ",\"p95Ms\":" << percentiles.p95Ms
+			<< ",\"p99Ms\":" << percentiles.p99Ms << ",\"maxMs\":" << percentiles.maxMs << "}";
+	}
+
+	void CheckLimit(const char* pName, float value, float limit, std::vector<std::string>& failures)
+	{
+		if (limit > 0.f && value > limit)
+			failures.push_back(Utils::Format("{} {:.2f} ms is over the budget of {:.2f} ms", pName, value, limit));
+	}
+}
+
+RS::DurationHistogram::DurationHistogram()
+	: m_Buckets(std::make_unique<uint64[]>(_FrameHistoryInternal::BucketCount))
+{
+}
+
+void RS::DurationHistogram::Record(float ms)
+{
+	const uint64 us = std::min((uint64)std::llround(std::max(ms, 0.f) * 1000.0), MaxUs);
+	m_Buckets[GetBucket(us)]++;
+	m_Count++;
+	m_TotalUs += us;
+	m_MaxUs = std::max(m_MaxUs, us);
+}
+
+void RS::DurationHistogram::Reset()
+{
+	std::fill_n(m_Buckets.get(), _FrameHistoryInternal::BucketCount, (uint64)0);
+	m_Count = 0;
+	m_TotalUs = 0;
+	m_MaxUs = 0;
+}
+
+float RS::DurationHistogram::GetPercentileMs(float percent) const
+{
+	if (m_Count == 0)
+		return 0.f;
+
+	const uint64 rank = std::clamp<uint64>((uint64)std::ceil((double)percent / 100.0 * (double)m_Count), 1, m_Count);
+	uint64 count = 0;
+	for (uint32 bucket = 0; bucket < _FrameHistoryInternal::BucketCount; ++bucket)
+	{
+		count += m_Buckets[bucket];
+		if (count >= rank)
+			return UsToMs(std::min(GetBucketValue(bucket), m_MaxUs));
+	}
+	return UsToMs(m_MaxUs);
+}
+
+float RS::DurationHistogram::GetMeanOfLongestMs(float fraction) const
+{
+	if (m_Count == 0)
+		return 0.f;
+
+	const uint64 count = std::clamp<uint64>((uint64)((double)fraction * (double)m_Count), 1, m_Count);
+	uint64 remaining = count;
+	uint64 totalUs = 0;
+	for (uint32 bucket = _FrameHistoryInternal::BucketCount; bucket-- > 0 && remaining > 0;)
+	{
+		const uint64 taken = std::min(m_Buckets[bucket], remaining);
+		totalUs += taken * std::min(GetBucketValue(bucket), m_MaxUs);
+		remaining -= taken;
+	}
+	return UsToMs(totalUs) / (float)count;
+}
+
+uint32 RS::DurationHistogram::GetBucket(uint64 us)
+{
+	// Below 2 * SubBucketHalfCount every microsecond has its own bucket. Above, the top SubBucketBits bits pick it.
+	if (us < 2 * SubBucketHalfCount)
+		return (uint32)us;
+
+	const uint32 shift = (uint32)std::bit_width(us) - SubBucketBits;
+	return shift * SubBucketHalfCount + (uint32)(us >> shift);
+}
+
+uint64 RS::DurationHistogram::GetBucketValue(uint32 bucket)
+{
+	if (bucket < 2 * SubBucketHalfCount)
+		return bucket;
+
+	const uint32 shift = bucket / SubBucketHalfCount - 1;
+	const uint64 lowest = (uint64)(bucket % SubBucketHalfCount + SubBucketHalfCount) << shift;
+	return lowest + ((1ull << shift) - 1) / 2;
+}
+
+bool RS::PerfBudget::Parse(const std::string& spec, PerfBudget& budget)
+{
+	budget = PerfBudget();
+	for (const std::string& entry : Utils::Split(spec, ','))
+	{
+		const size_t separator = entry.find('=');
+		if (separator == std::string::npos)
+		{
+			LOG_WARNING("Perf budget entry '{}' is not written as key=value!", entry.c_str());
+			return false;
+		}
+
+		const std::string key = Utils::ToLower(Utils::TrimC(entry.substr(0, separator)));
+		const std::string valueStr = Utils::TrimC(entry.substr(separator + 1));
+		char* pEnd = nullptr;
+		const float value = std::strtof(valueStr.c_str(), &pEnd);
+		if (valueStr.empty() || *pEnd != '\0' || !(value >= 0.f))
+		{
+			LOG_WARNING("Perf budget '{}' has no valid value, it is '{}'!", key.c_str(), valueStr.c_str());
+			return false;
+		}
+
+		if (key == "framep95")			budget.frameP95Ms = value;
+		else if (key == "framep99")		budget.frameP99Ms = value;
+		else if (key == "cpup95")		budget.cpuP95Ms = value;
+		else if (key == "cpup99")		budget.cpuP99Ms = value;
+		else if (key == "gpup95")		budget.gpuP95Ms = value;
+		else if (key == "gpup99")		budget.gpuP99Ms = value;
+		else if (key == "lowfps")		budget.minOnePercentLowFPS = value;
+		else if (key == "memorymb")		budget.maxMemoryBytes = (uint64)((double)value * 1024.0 * 1024.0);
+		else
+		{
+			LOG_WARNING("Perf budget '{}' is not known!", key.c_str());
+			return false;
+		}
+	}
+	return true;
+}
+
+bool RS::PerfBudget::Check(const FrameHistorySummary& summary, std::vector<std::string>& failures) const
+{
+	using namespace _FrameHistoryInternal;
+
+	const size_t failureCount = failures.size();
+	CheckLimit("Frame P95", summary.frame.p95Ms, frameP95Ms, failures);
+	CheckLimit("Frame P99", summary.frame.p99Ms, frameP99Ms, failures);
+	CheckLimit("CPU P95", summary.cpu.p95Ms, cpuP95Ms, failures);
+	CheckLimit("CPU P99", summary.cpu.p99Ms, cpuP99Ms, failures);
+	CheckLimit("GPU P95", summary.gpu.p95Ms, gpuP95Ms, failures);
+	CheckLimit("GPU P99", summary.gpu.p99Ms, gpuP99Ms, failures);
+
+	if (minOnePercentLowFPS > 0.f && summary.onePercentLowFPS < minOnePercentLowFPS)
+		failures.push_back(Utils::Format("1% low {:.1f} FPS is under the budget of {:.1f} FPS", summary.onePercentLowFPS, minOnePercentLowFPS));
+	if (maxMemoryBytes > 0 && summary.peakMemoryBytes > maxMemoryBytes)
+		failures.push_back(Utils::Format("Peak memory {} MB is over the budget of {} MB", summary.peakMemoryBytes / (1024 * 1024), maxMemoryBytes / (1024 * 1024)));
+
+	// A run without frames says nothing about the budget.
+	if (summary.frameCount == 0)
+		failures.push_back("No frames were recorded");
+	// Without GPU timing the GPU percentiles are 0 and would always pass.
+	if ((gpuP95Ms > 0.f || gpuP99Ms > 0.f) && summary.gpuFrameCount == 0)
+		failures.push_back("No GPU samples were recorded");
+
+	return failures.size() == failureCount;
+}
+
+RS::FrameHistory::FrameHistory(uint32 capacity)
+	: m_Samples(capacity)
+{
+	RS_ASSERT(capacity > 0, "The frame history has to keep at least one sample!");
+}
+
+void RS::FrameHistory::Record(const FrameSample& sample)
+{
+	m_Samples[m_NextSample] = sample;
+	m_NextSample = (m_NextSample + 1) % (uint32)m_Samples.size();
+	m_SampleCount = std::min(m_SampleCount + 1, (uint32)m_Samples.size());
+
+	m_FrameTimes.Record(sample.frameMs);
+	m_CPUTimes.Record(sample.cpuMs);
+	if (sample.gpuMs > 0.f)
+		m_GPUTimes.Record(sample.gpuMs);
+	m_PeakMemoryBytes = std::max(m_PeakMemoryBytes, sample.memoryBytes);
+}
+
+void RS::FrameHistory::Reset()
+{
+	m_NextSample = 0;
+	m_SampleCount = 0;
+	m_FrameTimes.Reset();
+	m_CPUTimes.Reset();
+	m_GPUTimes.Reset();
+	m_PeakMemoryBytes = 0;
+}
+
+const RS::FrameSample& RS::FrameHistory::GetSample(uint32 framesAgo) const
+{
+	RS_ASSERT(framesAgo < m_SampleCount, "Only {} samples are kept!", m_SampleCount);
+
+	const uint32 capacity = (uint32)m_Samples.size();
+	return m_Samples[(m_NextSample + capacity - 1 - framesAgo) % capacity];
+}
+
+RS::FrameHistorySummary RS::FrameHistory::GetSummary() const
+{
+	auto GetPercentiles = [](const DurationHistogram& histogram)
+		{
+			FrameHistorySummary::Percentiles percentiles;
+			percentiles.p50Ms = histogram.GetPercentileMs(50.f);
+			percentiles.p95Ms = histogram.GetPercentileMs(95.f);
+			percentiles.p99Ms = histogram.GetPercentileMs(99.f);
+			percentiles.maxMs = histogram.GetMaxMs();
+			return percentiles;
+		};
+
+	FrameHistorySummary summary;
+	summary.frameCount = m_FrameTimes.GetCount();
+	summary.gpuFrameCount = m_GPUTimes.GetCount();
+	summary.frame = GetPercentiles(m_FrameTimes);
+	summary.cpu = GetPercentiles(m_CPUTimes);
+	summary.gpu = GetPercentiles(m_GPUTimes);
+
+	const float meanMs = m_FrameTimes.GetMeanMs();
+	const float slowestMs = m_FrameTimes.GetMeanOfLongestMs(0.01f);
+	summary.averageFPS = meanMs > 0.f ? 1000.f / meanMs : 0.f;
+	summary.onePercentLowFPS = slowestMs > 0.f ? 1000.f / slowestMs : 0.f;
+	summary.peakMemoryBytes = m_PeakMemoryBytes;
+	return summary;
+}
+
+bool RS::FrameHistory::ExportCSV(const std::string& path) const
+{
+	std::ofstream stream;
+	if (!_FrameHistoryInternal::OpenForExport(path, stream))
+		return false;
+
+	ExportCSV(stream);
+	LOG_INFO("Exported {} frame samples to {}", m_SampleCount, path.c_str());
+	return true;
+}
+
+void RS::FrameHistory::ExportCSV(std::ostream& stream) const
+{
+	stream << std::fixed << std::setprecision(3);
+	stream << "frame,frameMs,cpuMs,gpuMs,fixedTicks,memoryBytes\n";
+	for (uint32 framesAgo = m_SampleCount; framesAgo-- > 0;)
+	{
+		const FrameSample& sample = GetSample(framesAgo);
+		stream << sample.frame << "," << sample.frameMs << "," << sample.cpuMs << "," << sample.gpuMs << ","
+			<< sample.fixedTicks << "," << sample.memoryBytes << "\n";
+	}
+}
+
+bool RS::FrameHistory::ExportJSON(const std::string& path) const
+{
+	std::ofstream stream;
+	if (!_FrameHistoryInternal::OpenForExport(path, stream))
+		return false;
+
+	ExportJSON(stream);
+	LOG_INFO("Exported {} frame samples to {}", m_SampleCount, path.c_str());
+	return true;
+}
+
+void RS::FrameHistory::ExportJSON(std::ostream& stream) const
+{
+	using namespace _FrameHistoryInternal;
+
+	const FrameHistorySummary summary = GetSummary();
+	stream << std::fixed << std::setprecision(3);
+	stream << "{\"summary\":{\"frameCount\":" << summary.frameCount << ",";
+	WritePercentiles(stream, "frame", summary.frame);
+	stream << ",";
+	WritePercentiles(stream, "cpu", summary.cpu);
+	stream << ",";
+	WritePercentiles(stream, "gpu", summary.gpu);
+	stream << ",\"averageFPS\":" << summary.averageFPS << ",\"onePercentLowFPS\":" << summary.onePercentLowFPS
+		<< ",\"peakMemoryBytes\":" << summary.peakMemoryBytes << "},\n\"samples\":[";
+
+	// One sample per line.
+	for (uint32 framesAgo = m_SampleCount; framesAgo-- > 0;)
+	{
+		const FrameSample& sample = GetSample(framesAgo);
+		stream << (framesAgo + 1 == m_SampleCount ? "\n" : ",\n") << "{\"frame\":" << sample.frame << ",\"frameMs\":" << sample.frameMs
+			<< ",\"cpuMs\":" << sample.cpuMs << ",\"gpuMs\":" << sample.gpuMs << ",\"fixedTicks\":" << sample.fixedTicks
+			<< ",\"memoryBytes\":" << sample.memoryBytes << "}";
+	}
+	stream << "\n]}\n";
+}
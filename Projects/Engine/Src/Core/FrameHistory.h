@@ -0,0 +1,146 @@
+#pragma once
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace RS
+{
+	/*
+	* Durations in log-linear buckets, like an HDR histogram. Each power of two of microseconds is split into the same
+	* number of buckets, so a value is at most 1 / SubBucketHalfCount off at any size. Recording is a few instructions and
+	* the memory does not grow, so percentiles can be kept over a whole run.
+	*/
+	class DurationHistogram
+	{
+	public:
+		inline static constexpr uint32 SubBucketBits = 7;
+		inline static constexpr uint32 SubBucketHalfCount = 1u << (SubBucketBits - 1);
+		// Longer durations are counted as this, it is a bit more than 19 hours.
+		inline static constexpr uint64 MaxUs = (1ull << 36) - 1;
+
+	public:
+		DurationHistogram();
+
+		void Record(float ms);
+		void Reset();
+
+		uint64 GetCount() const { return m_Count; }
+		float GetMaxMs() const { return m_Count > 0 ? UsToMs(m_MaxUs) : 0.f; }
+		float GetMeanMs() const { return m_Count > 0 ? UsToMs(m_TotalUs) / (float)m_Count : 0.f; }
+
+		// The duration that percent of the recorded ones are at or below, 0 when nothing is recorded.
+		float GetPercentileMs(float percent) const;
+
+		// The mean of the longest fraction of the recorded durations, at least one of them.
+		float GetMeanOfLongestMs(float fraction) const;
+
+	private:
+		static uint32 GetBucket(uint64 us);
+		// The middle of the durations in the bucket.
+		static uint64 GetBucketValue(uint32 bucket);
+		static float UsToMs(uint64 us) { return (float)us / 1000.f; }
+
+	private:
+		std::unique_ptr<uint64[]>	m_Buckets;
+		uint64						m_Count = 0;
+		uint64						m_TotalUs = 0;
+		uint64						m_MaxUs = 0;
+	};
+
+	struct FrameSample
+	{
+		uint64	frame;
+		float	frameMs;		// From the start of the frame to the start of the next.
+		float	cpuMs;			// From FrameTimer::Begin to FrameTimer::End.
+		float	gpuMs;			// Work on the direct queue, 0 when it was not timed. Some frames behind the CPU times.
+		uint32	fixedTicks;
+		uint64	memoryBytes;	// Memory of the process in use at the end of the frame.
+	};
+
+	struct FrameHistorySummary
+	{
+		struct Percentiles
+		{
+			float p50Ms = 0.f;
+			float p95Ms = 0.f;
+			float p99Ms = 0.f;
+			float maxMs = 0.f;
+		};
+
+		uint64		frameCount = 0;
+		uint64		gpuFrameCount = 0;	// Frames that have a GPU time.
+		Percentiles	frame;
+		Percentiles	cpu;
+		Percentiles	gpu;
+		float		averageFPS = 0.f;
+		float		onePercentLowFPS = 0.f; // The average FPS of the slowest 1% of the frames.
+		uint64		peakMemoryBytes = 0;
+	};
+
+	/*
+	* Limits on a FrameHistorySummary, parsed from a comma separated list like "frameP99=33.3,lowFPS=30,memoryMB=2048".
+	* Each limit is optional, 0 means no limit.
+	*/
+	struct PerfBudget
+	{
+		float	frameP95Ms = 0.f;
+		float	frameP99Ms = 0.f;
+		float	cpuP95Ms = 0.f;
+		float	cpuP99Ms = 0.f;
+		float	gpuP95Ms = 0.f;
+		float	gpuP99Ms = 0.f;
+		float	minOnePercentLowFPS = 0.f;
+		uint64	maxMemoryBytes = 0;
+
+		// Keys: frameP95, frameP99, cpuP95, cpuP99, gpuP95, gpuP99, lowFPS and memoryMB.
+		static bool Parse(const std::string& spec, PerfBudget& budget);
+
+		// Adds a line for every limit that was exceeded, returns true when none was.
+		bool Check(const FrameHistorySummary& summary, std::vector<std::string>& failures) const;
+	};
+
+	/*
+	* The samples of the last frames and percentiles over every frame since the last Reset. The samples are kept in a ring,
+	* the percentiles come from histograms.
+	*/
+	class FrameHistory
+	{
+	public:
+		inline static constexpr uint32 DefaultCapacity = 3600;
+
+	public:
+		explicit FrameHistory(uint32 capacity = DefaultCapacity);
+		RS_NO_COPY_AND_MOVE(FrameHistory)
+
+		void Record(const FrameSample& sample);
+		void Reset();
+
+		uint32 GetCapacity() const { return (uint32)m_Samples.size(); }
+		uint32 GetSampleCount() const { return m_SampleCount; }
+		// 0 is the newest sample.
+		const FrameSample& GetSample(uint32 framesAgo) const;
+
+		FrameHistorySummary GetSummary() const;
+
+		/*
+		* Writes the samples that are kept, oldest first, as CSV with a header row. The JSON has the summary too.
+		* The path overloads create the directory and log what went wrong when the file can not be written.
+		*/
+		bool ExportCSV(const std::string& path) const;
+		void ExportCSV(std::ostream& stream) const;
+		bool ExportJSON(const std::string& path) const;
+		void ExportJSON(std::ostream& stream) const;
+
+	private:
+		std::vector<FrameSample>	m_Samples; // Ring, m_NextSample is where the next one goes.
+		uint32						m_NextSample = 0;
+		uint32						m_SampleCount = 0;
+
+		DurationHistogram			m_FrameTimes;
+		DurationHistogram			m_CPUTimes;
+		DurationHistogram			m_GPUTimes;
+		uint64						m_PeakMemoryBytes = 0;
+	};
+}
@@ -9,8 +9,13 @@ namespace RS
 			float currentDT = 0.0f;
 			float avgDTMs = 0.0f;
 			float avgFPS = 0.0f;
-			float minDT = 3.402823466e+38F;
-			float maxDT = 1.175494351e-38F;
+			float minDT = 0.0f;		// In ms, over the last update interval of the FrameTimer.
+			float maxDT = 0.0f;		// In ms, over the last update interval of the FrameTimer.
+			float gpuMs = 0.0f;		// Set by the loop before FrameTimer::End, 0 when no GPU frame was timed.
+			float p50Ms = 0.0f;		// Percentiles of the frame times since the FrameTimer started.
+			float p95Ms = 0.0f;
+			float p99Ms = 0.0f;
+			float onePercentLowFPS = 0.0f;
 		} frame;
 
 		struct FixedUpdate
@@ -18,6 +23,13 @@ namespace RS
 			float updateCallsRatio = 0.f;
 			float fixedFPS = 60.f;
 			uint32 maxUpdateCalls = 3;
+			float alpha = 0.f;		// How far the frame is from the last fixed update to the next one, for interpolation.
+			uint64 tickCount = 0;	// Fixed updates run so far.
 		} fixedUpdate;
+
+		struct Upload
+		{
+			uint64 instanceBytes = 0; // Written by the instance streams in the previous frame.
+		} upload;
 	};
 }
\ No newline at end of file
@@ -2,6 +2,10 @@
 #include "FrameTimer.h"
 
 #include "Core/Console.h"
+#include "Core/CorePlatform.h"
+#include "Core/LaunchArguments.h"
+
+#include <cmath>
 
 using namespace RS;
 
@@ -15,11 +19,28 @@ void FrameTimer::Init(FrameStats* pFrameStats, float updateDelay)
     Console::Get()->AddVar("FrameStats.FixedUpdate.FixedFPS", m_pFrameStats->fixedUpdate.fixedFPS, Console::Flag::NONE, "Fixed update rate.");
     Console::Get()->AddVar("FrameStats.FixedUpdate.MaxUpdateCallsPerFrame", m_pFrameStats->fixedUpdate.maxUpdateCalls, Console::Flag::NONE, "Maximum number of fixed update calls per frame.");
     Console::Get()->AddVar("FrameStats.Info.FixedUpdate.UpdateCallsRatio", m_pFrameStats->fixedUpdate.updateCallsRatio, Console::Flag::ReadOnly, "");
+    Console::Get()->AddVar("FrameStats.Info.FixedUpdate.TickCount", m_pFrameStats->fixedUpdate.tickCount, Console::Flag::ReadOnly, "Fixed updates run so far.");
     Console::Get()->AddVar("FrameStats.Info.Frame.AvrageFPS", m_pFrameStats->frame.avgFPS, Console::Flag::ReadOnly, "Average FPS [frames/s]");
     Console::Get()->AddVar("FrameStats.Info.Frame.AvrageDeltaTimeMs", m_pFrameStats->frame.avgDTMs, Console::Flag::ReadOnly, "Average delta time [ms]");
     Console::Get()->AddVar("FrameStats.Info.Frame.CurrentDeltaTime", m_pFrameStats->frame.currentDT, Console::Flag::ReadOnly, "Current delta time [s]");
-    Console::Get()->AddVar("FrameStats.Info.Frame.MinDeltaTime", m_pFrameStats->frame.minDT, Console::Flag::ReadOnly, "Minimum delta time [s]");
-    Console::Get()->AddVar("FrameStats.Info.Frame.MaxDeltaTime", m_pFrameStats->frame.maxDT, Console::Flag::ReadOnly, "Maximum delta time [s]");
+    Console::Get()->AddVar("FrameStats.Info.Frame.MinDeltaTime", m_pFrameStats->frame.minDT, Console::Flag::ReadOnly, "Minimum delta time in the last update interval [ms]");
+    Console::Get()->AddVar("FrameStats.Info.Frame.MaxDeltaTime", m_pFrameStats->frame.maxDT, Console::Flag::ReadOnly, "Maximum delta time in the last update interval [ms]");
+    Console::Get()->AddVar("FrameStats.Info.Frame.GPUTime", m_pFrameStats->frame.gpuMs, Console::Flag::ReadOnly, "GPU time of the newest frame that was read back [ms]");
+    Console::Get()->AddVar("FrameStats.Info.Frame.P50", m_pFrameStats->frame.p50Ms, Console::Flag::ReadOnly, "Median frame time of the run [ms]");
+    Console::Get()->AddVar("FrameStats.Info.Frame.P95", m_pFrameStats->frame.p95Ms, Console::Flag::ReadOnly, "95th percentile frame time of the run [ms]");
+    Console::Get()->AddVar("FrameStats.Info.Frame.P99", m_pFrameStats->frame.p99Ms, Console::Flag::ReadOnly, "99th percentile frame time of the run [ms]");
+    Console::Get()->AddVar("FrameStats.Info.Frame.OnePercentLowFPS", m_pFrameStats->frame.onePercentLowFPS, Console::Flag::ReadOnly, "Average FPS of the slowest 1% of the frames of the run [frames/s]");
+    Console::Get()->AddFunction("FrameStats.Export", [this](Console::FuncArgs args)->bool
+        {
+            const std::string path = Engine::GetDebugFilePath() + "FrameStats";
+            if (!m_History.ExportCSV(path + ".csv") || !m_History.ExportJSON(path + ".json"))
+                return false;
+            Console::Get()->Print("Exported {} frames to {}.csv and {}.json", m_History.GetSampleCount(), path, path);
+            return true;
+        },
+        Console::Flag::NONE, "Write the frame history to FrameStats.csv and FrameStats.json in the debug folder, the JSON has the percentiles too."
+    );
+    Console::Get()->AddVar("FrameStats.Info.Upload.InstanceBytes", m_pFrameStats->upload.instanceBytes, Console::Flag::ReadOnly, "Instance data written to the GPU in the previous frame [bytes]");
 
     m_Timer.Start();
 }
@@ -27,7 +48,8 @@ void FrameTimer::Init(FrameStats* pFrameStats, float updateDelay)
 void FrameTimer::Begin()
 {
     m_FrameTime = m_Timer.CalcDelta();
-    m_pFrameStats->frame.currentDT = m_FrameTime.GetDeltaTimeSec();
+    m_FrameBeginTick = Timer::GetCurrentTick();
+    m_pFrameStats->frame.currentDT = m_FixedFrameDT > 0.f ? m_FixedFrameDT : m_FrameTime.GetDeltaTimeSec();
     m_Accumulator += m_pFrameStats->frame.currentDT;
 }
 
@@ -36,19 +58,43 @@ void FrameTimer::FixedTick(std::function<void(void)> fixedTickFunction)
     m_FixedDT = 1.f / m_pFrameStats->fixedUpdate.fixedFPS;
 
     m_UpdateCalls = 0;
-    while (m_Accumulator > m_FixedDT && m_UpdateCalls < m_pFrameStats->fixedUpdate.maxUpdateCalls)
+    while (m_Accumulator >= m_FixedDT && m_UpdateCalls < m_pFrameStats->fixedUpdate.maxUpdateCalls)
     {
         fixedTickFunction();
         m_Accumulator -= m_FixedDT;
         m_UpdateCalls++;
+        m_pFrameStats->fixedUpdate.tickCount++;
     }
     m_AccUpdateCalls += m_UpdateCalls;
+
+    // Time that could not be simulated this frame is dropped, or a slow frame would make every frame after it slower.
+    if (m_Accumulator >= m_FixedDT)
+        m_Accumulator = std::fmod(m_Accumulator, m_FixedDT);
+
+    m_pFrameStats->fixedUpdate.alpha = m_Accumulator / m_FixedDT;
+}
+
+void FrameTimer::SetFixedFrameDT(float dt)
+{
+    m_FixedFrameDT = dt;
 }
 
 void FrameTimer::End()
 {
-    m_pFrameStats->frame.minDT = std::min(m_pFrameStats->frame.minDT, m_pFrameStats->frame.currentDT * 1000.f);
-    m_pFrameStats->frame.maxDT = std::max(m_pFrameStats->frame.maxDT, m_pFrameStats->frame.currentDT * 1000.f);
+    // The measured frame time, even when the frames step with a fixed one. That is the time a budget is about.
+    FrameSample sample = {};
+    sample.frame = m_FrameCount++;
+    sample.frameMs = m_FrameTime.GetDeltaTimeMS();
+    sample.cpuMs = (float)(Timer::CalcTimeIntervalInSeconds(m_FrameBeginTick, Timer::GetCurrentTick()) * 1000.0);
+    sample.gpuMs = m_pFrameStats->frame.gpuMs;
+    sample.fixedTicks = m_UpdateCalls;
+    sample.memoryBytes = CorePlatform::GetProcessMemoryUsage();
+    m_History.Record(sample);
+    m_UpdateCalls = 0;
+
+    const float currentDTMs = m_pFrameStats->frame.currentDT * 1000.f;
+    m_pFrameStats->frame.minDT = m_DebugFrameCounter == 0 ? currentDTMs : std::min(m_pFrameStats->frame.minDT, currentDTMs);
+    m_pFrameStats->frame.maxDT = m_DebugFrameCounter == 0 ? currentDTMs : std::max(m_pFrameStats->frame.maxDT, currentDTMs);
     m_DebugFrameCounter++;
     m_DebugTimer += m_pFrameStats->frame.currentDT;
     if (m_DebugTimer >= m_UpdateFrameDataTime)
@@ -56,8 +102,53 @@ void FrameTimer::End()
         m_pFrameStats->frame.avgFPS = 1.0f / (m_DebugTimer / (float)m_DebugFrameCounter);
         m_pFrameStats->frame.avgDTMs = (m_DebugTimer / (float)m_DebugFrameCounter) * 1000.f;
         m_pFrameStats->fixedUpdate.updateCallsRatio = ((float)m_AccUpdateCalls / (float)m_DebugFrameCounter) * 100.f;
+
+        const FrameHistorySummary summary = m_History.GetSummary();
+        m_pFrameStats->frame.p50Ms = summary.frame.p50Ms;
+        m_pFrameStats->frame.p95Ms = summary.frame.p95Ms;
+        m_pFrameStats->frame.p99Ms = summary.frame.p99Ms;
+        m_pFrameStats->frame.onePercentLowFPS = summary.onePercentLowFPS;
+
         m_DebugTimer = 0.0f;
         m_DebugFrameCounter = 0;
         m_AccUpdateCalls = 0;
     }
 }
+
+bool FrameTimer::FinishRun() const
+{
+    const FrameHistorySummary summary = m_History.GetSummary();
+    LOG_INFO("Frame stats of {} frames: P50 {:.2f} ms, P95 {:.2f} ms, P99 {:.2f} ms, 1% low {:.1f} FPS", summary.frameCount,
+        summary.frame.p50Ms, summary.frame.p95Ms, summary.frame.p99Ms, summary.onePercentLowFPS);
+
+    const std::vector<std::string>& statsArgs = LaunchArguments::GetArgs(LaunchParams::frameStats);
+    if (!statsArgs.empty())
+    {
+        if (Utils::EndsWith(statsArgs[0], ".json"))
+            m_History.ExportJSON(statsArgs[0]);
+        else
+            m_History.ExportCSV(statsArgs[0]);
+    }
+
+    const std::vector<std::string>& budgetArgs = LaunchArguments::GetArgs(LaunchParams::perfBudget);
+    if (budgetArgs.empty())
+        return true;
+
+    PerfBudget budget;
+    if (!PerfBudget::Parse(budgetArgs[0], budget))
+    {
+        LOG_ERROR("The perf budget '{}' could not be read!", budgetArgs[0].c_str());
+        return false;
+    }
+
+    std::vector<std::string> failures;
+    if (budget.Check(summary, failures))
+    {
+        LOG_INFO("The run is within the perf budget.");
+        return true;
+    }
+
+    for (const std::string& failure : failures)
+        LOG_ERROR("Perf budget: {}", failure.c_str());
+    return false;
+}
@@ -1,6 +1,7 @@
 #pragma once
 #pragma once
 
+#include "Core/FrameHistory.h"
 #include "Core/FrameStats.h"
 #include "Utils/Timer.h"
 
@@ -11,7 +12,9 @@ namespace RS
     class FrameTimer
     {
     public:
-        RS_DEFAULT_CONSTRUCTORS(FrameTimer);
+        FrameTimer() = default;
+        ~FrameTimer() = default;
+        RS_NO_COPY_AND_MOVE(FrameTimer)
 
         void Init(FrameStats* pFrameStats, float updateDelay);
 
@@ -19,13 +22,33 @@ namespace RS
         void FixedTick(std::function<void(void)> fixedTickFunction);
         void End();
 
+        /*
+        * Every frame takes dt seconds instead of the measured time, 0 goes back to measuring. For replays and benchmarks
+        * that have to run the same frames every time, however fast the machine is.
+        */
+        void SetFixedFrameDT(float dt);
+
+        // The last frames, and percentiles of every frame since Init.
+        const FrameHistory& GetHistory() const { return m_History; }
+
+        /*
+        * Call once the loop is done. Writes the history to the file given with -frameStats and checks it against the
+        * budget given with -perfBudget. Returns false when the run went over the budget, so a headless run can fail.
+        */
+        bool FinishRun() const;
+
     private:
         FrameStats* m_pFrameStats = nullptr;
 
         float       m_FixedDT = 0.f;  // In seconds
+        float       m_FixedFrameDT = 0.f;  // In seconds, 0 when the frame time is measured.
         float       m_UpdateFrameDataTime = 0.f;  // In seconds
         Timer       m_Timer;
         TimeStamp   m_FrameTime;
+        uint64      m_FrameBeginTick = 0;
+        uint64      m_FrameCount = 0;
+
+        FrameHistory m_History;
 
         float   m_Accumulator = 0.0f;
         float   m_DebugTimer = 0.0f;
@@ -2,6 +2,7 @@
 #include "Input.h"
 
 #include "Core/Display.h"
+#include "Core/LaunchArguments.h"
 
 #include "GUI/ImGuiAdapter.h"
 #include "Render/ImGuiRenderer.h"
@@ -43,10 +44,29 @@ void Input::Init()
     glfwSetCursorPosCallback(wnd, Input::CursorPositionCallback);
     glfwSetMouseButtonCallback(wnd, Input::MouseButtonCallback);
     glfwSetScrollCallback(wnd, Input::MouseScrollCallback);
+
+    const std::vector<std::string>& replayArgs = LaunchArguments::GetArgs(LaunchParams::replayInput);
+    const std::vector<std::string>& recordArgs = LaunchArguments::GetArgs(LaunchParams::recordInput);
+    if (!replayArgs.empty())
+        StartReplay(replayArgs[0]);
+    else if (!recordArgs.empty())
+        StartRecording(recordArgs[0]);
+}
+
+void Input::Release()
+{
+    StopRecording();
+    s_IsReplaying = false;
 }
 
 void Input::PreUpdate()
 {
+    if (s_IsReplaying)
+    {
+        for (const InputEvent& event : s_Player.Advance(s_Frame))
+            ApplyEvent(event);
+    }
+
     s_MouseDelta = s_MousePos - s_MousePosPre;
 }
 
@@ -59,6 +79,57 @@ void Input::PostUpdate(float dt)
 
     s_MousePosPre = s_MousePos;
     s_ScrollDelta = glm::vec2(0.f);
+    s_Frame++;
+}
+
+bool Input::StartRecording(const std::string& path)
+{
+    RS_ASSERT(!s_IsReplaying, "Cannot record input while replaying it!");
+
+    if (!s_Recorder.Open(path))
+        return false;
+
+    // The frame of the events is relative to the start of the recording.
+    s_Frame = 0;
+    LOG_INFO("Recording input to {}", path.c_str());
+    return true;
+}
+
+void Input::StopRecording()
+{
+    if (s_Recorder.IsOpen())
+        s_Recorder.Close(s_Frame);
+}
+
+bool Input::IsRecording() const
+{
+    return s_Recorder.IsOpen();
+}
+
+bool Input::StartReplay(const std::string& path)
+{
+    StopRecording();
+
+    if (!s_Player.Load(path))
+        return false;
+
+    // Replays start from nothing being pressed, like the recording did.
+    s_KeyMap.clear();
+    s_MBMap.clear();
+    s_Frame = 0;
+    s_IsReplaying = true;
+    LOG_INFO("Replaying {} input events from {}, {} frames", s_Player.GetEventCount(), path.c_str(), s_Player.GetFrameCount());
+    return true;
+}
+
+bool Input::IsReplaying() const
+{
+    return s_IsReplaying;
+}
+
+bool Input::IsReplayFinished() const
+{
+    return s_IsReplaying && s_Player.IsFinished();
 }
 
 bool Input::IsKeyPressed(const Key& key, ModFlags mods) const
@@ -269,55 +340,118 @@ void Input::UpdateKeyInfo(KeyInfo& keyInfo, float dt)
         keyInfo.TimeHeld = 0.f;
 }
 
+void Input::OnEvent(const InputEvent& event)
+{
+    if (s_Recorder.IsOpen())
+        s_Recorder.Write(event);
+    ApplyEvent(event);
+}
+
+void Input::ApplyEvent(const InputEvent& event)
+{
+    switch (event.type)
+    {
+    case InputEvent::Type::Key:
+    {
+        Key rsKey = (Key)event.code;
+        if (event.action == GLFW_PRESS)
+            s_KeyMap[rsKey].State = KeyState::FIRST_PRESSED;
+        if (event.action == GLFW_RELEASE)
+            s_KeyMap[rsKey].State = KeyState::FIRST_RELEASED;
+        s_KeyMap[rsKey].Mods = event.mods;
+        //ImGui::InsertNotification({ ImGuiToastType_Info, "Listening to key {} with new state {}", key, KeyStateToStr(s_KeyMap[rsKey].State).c_str()});
+        break;
+    }
+    case InputEvent::Type::MouseButton:
+    {
+        MB ymButton = (MB)event.code;
+        if (event.action == GLFW_PRESS)
+            s_MBMap[ymButton].State = KeyState::FIRST_PRESSED;
+        if (event.action == GLFW_RELEASE)
+            s_MBMap[ymButton].State = KeyState::FIRST_RELEASED;
+        s_MBMap[ymButton].Mods = event.mods;
+        break;
+    }
+    case InputEvent::Type::CursorPosition:
+        s_MousePos.x = event.x;
+        s_MousePos.y = event.y;
+        break;
+    case InputEvent::Type::Scroll:
+        s_ScrollDelta.x = event.x;
+        s_ScrollDelta.y = event.y;
+        break;
+    default:
+        break;
+    }
+}
+
 void Input::KeyCallback(GLFWwindow* wnd, int key, int scancode, int action, int mods)
 {
     //ImGui::InsertNotification({ ImGuiToastType_Info, "Called Key {}", key });
     Key rsKey = (Key)key;
     RS_UNREFERENCED_VARIABLE(wnd);
     RS_UNREFERENCED_VARIABLE(scancode);
-    RS_UNREFERENCED_VARIABLE(mods);
+    if (s_IsReplaying)
+        return;
+
     if (Input::Get()->ShouldAlwaysListenToKey(rsKey)
         || !ImGuiRenderer::Get()->WantKeyInput())
     {
-        if (action == GLFW_PRESS)
-            s_KeyMap[rsKey].State = KeyState::FIRST_PRESSED;
-        if (action == GLFW_RELEASE)
-            s_KeyMap[rsKey].State = KeyState::FIRST_RELEASED;
-        s_KeyMap[rsKey].Mods = mods;
-        //ImGui::InsertNotification({ ImGuiToastType_Info, "Listening to key {} with new state {}", key, KeyStateToStr(s_KeyMap[rsKey].State).c_str()});
+        InputEvent event;
+        event.frame = s_Frame;
+        event.type = InputEvent::Type::Key;
+        event.code = key;
+        event.action = action;
+        event.mods = mods;
+        OnEvent(event);
     }
 }
 
 void Input::CursorPositionCallback(GLFWwindow* window, double xpos, double ypos)
 {
     RS_UNREFERENCED_VARIABLE(window);
-    {
-        s_MousePos.x = (float)xpos;
-        s_MousePos.y = (float)ypos;
-    }
+    if (s_IsReplaying)
+        return;
+
+    InputEvent event;
+    event.frame = s_Frame;
+    event.type = InputEvent::Type::CursorPosition;
+    event.x = (float)xpos;
+    event.y = (float)ypos;
+    OnEvent(event);
 }
 
 void Input::MouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
 {
     RS_UNREFERENCED_VARIABLE(window);
-    RS_UNREFERENCED_VARIABLE(mods);
+    if (s_IsReplaying)
+        return;
+
     if (!ImGuiRenderer::Get()->WantKeyInput())
     {
-        MB ymButton = (MB)button;
-        if (action == GLFW_PRESS)
-            s_MBMap[ymButton].State = KeyState::FIRST_PRESSED;
-        if (action == GLFW_RELEASE)
-            s_MBMap[ymButton].State = KeyState::FIRST_RELEASED;
-        s_MBMap[ymButton].Mods = mods;
+        InputEvent event;
+        event.frame = s_Frame;
+        event.type = InputEvent::Type::MouseButton;
+        event.code = button;
+        event.action = action;
+        event.mods = mods;
+        OnEvent(event);
     }
 }
 
 void Input::MouseScrollCallback(GLFWwindow* window, double xOffset, double yOffset)
 {
     RS_UNREFERENCED_VARIABLE(window);
+    if (s_IsReplaying)
+        return;
+
     if (!ImGuiRenderer::Get()->WantKeyInput())
     {
-        s_ScrollDelta.x = (float)xOffset;
-        s_ScrollDelta.y = (float)yOffset;
+        InputEvent event;
+        event.frame = s_Frame;
+        event.type = InputEvent::Type::Scroll;
+        event.x = (float)xOffset;
+        event.y = (float)yOffset;
+        OnEvent(event);
     }
 }
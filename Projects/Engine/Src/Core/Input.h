@@ -2,6 +2,7 @@
 #pragma once
 
 #include "Core/Key.h"
+#include "Core/InputRecording.h"
 #include "Utils/Maths.h"
 
 struct GLFWwindow;
@@ -40,10 +41,29 @@ namespace RS
 
 		static std::shared_ptr<Input> Get();
 
+		/*
+		* Starts recording or replaying when launched with -recordInput or -replayInput.
+		*/
 		void Init();
+		void Release();
 		void PreUpdate();
 		void PostUpdate(float dt);
 
+		/*
+		* Writes every event Input applies to the file, until StopRecording or Release.
+		*/
+		bool StartRecording(const std::string& path);
+		void StopRecording();
+		bool IsRecording() const;
+
+		/*
+		* Feeds Input from the file instead of the window. PreUpdate applies the events of one recorded frame each frame, so a press
+		* and a release stay in the frames they were recorded in. Run with a fixed frame time to get the same frames every time.
+		*/
+		bool StartReplay(const std::string& path);
+		bool IsReplaying() const;
+		bool IsReplayFinished() const;
+
 		/*
 		* Returns true if the key was pressed (held down) otherwise false.
 		*/
@@ -164,6 +184,10 @@ namespace RS
 
 		void UpdateKeyInfo(KeyInfo& keyInfo, float dt);
 
+		// Every event from the window goes through here, after the UI had its chance to take it.
+		static void OnEvent(const InputEvent& event);
+		static void ApplyEvent(const InputEvent& event);
+
 		static void KeyCallback(GLFWwindow* wnd, int key, int scancode, int action, int mods);
 		static void CursorPositionCallback(GLFWwindow* window, double xpos, double ypos);
 		static void MouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
@@ -177,6 +201,11 @@ namespace RS
 		inline static glm::vec2 s_MouseDelta = glm::vec2(0.f);
 		inline static glm::vec2 s_ScrollDelta = glm::vec2(0.f);
 
+		inline static uint64 s_Frame = 0; // Frames since the recording or replay started, the frame of recorded events.
+		inline static InputRecorder s_Recorder;
+		inline static InputPlayer s_Player;
+		inline static bool s_IsReplaying = false;
+
 		// Keys which will bypass the UI system.
 		// TODO: Change this to a unordered set? Or at least something that uses a hash.
 		inline static std::vector<Key> s_AllwaysListenedKeys = std::vector<Key>();
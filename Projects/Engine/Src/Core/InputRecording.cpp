@@ -0,0 +1,110 @@
+#include "PreCompiled.h"
+#include "InputRecording.h"
+
+#include <filesystem>
+
+RS::InputRecorder::~InputRecorder()
+{
+	if (IsOpen())
+		Close(m_LastFrame);
+}
+
+bool RS::InputRecorder::Open(const std::string& path)
+{
+	if (IsOpen())
+		Close(m_LastFrame);
+
+	std::filesystem::path directory = std::filesystem::path(path).parent_path();
+	if (!directory.empty())
+		std::filesystem::create_directories(directory);
+
+	m_Stream.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!m_Stream.is_open())
+	{
+		LOG_WARNING("Failed to open {} to record input!", path.c_str());
+		return false;
+	}
+
+	const InputLogHeader header;
+	m_Stream.write((const char*)&header, sizeof(header));
+	m_LastFrame = 0;
+	return true;
+}
+
+void RS::InputRecorder::Close(uint64 frame)
+{
+	RS_ASSERT(IsOpen(), "There is no recording to close!");
+
+	InputEvent end;
+	end.frame = frame;
+	end.type = InputEvent::Type::End;
+	Write(end);
+	m_Stream.close();
+}
+
+void RS::InputRecorder::Write(const InputEvent& event)
+{
+	RS_ASSERT(IsOpen(), "There is no recording to write to!");
+	RS_ASSERT(event.frame >= m_LastFrame, "Input events have to be written in order!");
+
+	m_Stream.write((const char*)&event, sizeof(event));
+	m_LastFrame = event.frame;
+}
+
+bool RS::InputPlayer::Load(const std::string& path)
+{
+	m_Events.clear();
+	m_NextEvent = 0;
+
+	std::ifstream stream(path, std::ios::binary | std::ios::ate);
+	if (!stream.is_open())
+	{
+		LOG_WARNING("Failed to open input log {}!", path.c_str());
+		return false;
+	}
+
+	const uint64 fileSize = (uint64)stream.tellg();
+	stream.seekg(0);
+
+	InputLogHeader header;
+	if (fileSize < sizeof(header) || !stream.read((char*)&header, sizeof(header)))
+	{
+		LOG_WARNING("Input log {} is too small!", path.c_str());
+		return false;
+	}
+
+	if (header.magic != InputLogHeader::Magic || header.version != InputLogHeader::Version)
+	{
+		LOG_WARNING("Input log {} has the wrong magic or version! Version: {}", path.c_str(), header.version);
+		return false;
+	}
+
+	// A partly written last event, from a run that crashed, is dropped.
+	const uint64 eventCount = (fileSize - sizeof(header)) / sizeof(InputEvent);
+	m_Events.resize(eventCount);
+	if (eventCount > 0 && !stream.read((char*)m_Events.data(), eventCount * sizeof(InputEvent)))
+	{
+		LOG_WARNING("Failed to read input log {}!", path.c_str());
+		m_Events.clear();
+		return false;
+	}
+
+	for (uint64 i = 1; i < m_Events.size(); ++i)
+	{
+		if (m_Events[i].frame < m_Events[i - 1].frame)
+		{
+			LOG_WARNING("Input log {} has events out of order!", path.c_str());
+			m_Events.clear();
+			return false;
+		}
+	}
+	return true;
+}
+
+std::span<const RS::InputEvent> RS::InputPlayer::Advance(uint64 frame)
+{
+	const uint64 first = m_NextEvent;
+	while (m_NextEvent < m_Events.size() && m_Events[m_NextEvent].frame <= frame)
+		++m_NextEvent;
+	return std::span<const InputEvent>(m_Events.data() + first, m_NextEvent - first);
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <fstream>
+#include <span>
+
+namespace RS
+{
+	/*
+	* Input log layout:
+	*	InputLogHeader
+	*	InputEvent, one after another in the order Input applied them.
+	* Events are written as they happen, so a log from a run that crashed still has everything up to the crash. Each event has the
+	* frame it was applied in, a replay applies the events of one recorded frame per frame, whatever the frame times were.
+	*/
+	struct InputLogHeader
+	{
+		inline static constexpr uint32 Magic = 0x4E495352; // "RSIN"
+		inline static constexpr uint32 Version = 2;
+
+		uint32 magic = Magic;
+		uint32 version = Version;
+	};
+
+	struct InputEvent
+	{
+		enum class Type : uint32
+		{
+			Key = 0,
+			MouseButton,
+			CursorPosition,
+			Scroll,
+			End // When the recording stopped, a replay runs until then.
+		};
+
+		uint64	frame = 0;		// Frames since the recording started, before the one the event was applied in.
+		Type	type = Type::Key;
+		int32	code = 0;		// Key or mouse button.
+		int32	action = 0;		// GLFW_PRESS or GLFW_RELEASE.
+		int32	mods = 0;
+		float	x = 0.f;		// Cursor position or scroll offset.
+		float	y = 0.f;
+	};
+
+	class InputRecorder
+	{
+	public:
+		InputRecorder() = default;
+		~InputRecorder();
+		RS_NO_COPY_AND_MOVE(InputRecorder)
+
+		bool Open(const std::string& path);
+
+		/*
+		* Writes an End event in the frame, then closes the file.
+		*/
+		void Close(uint64 frame);
+
+		void Write(const InputEvent& event);
+
+		bool IsOpen() const { return m_Stream.is_open(); }
+
+	private:
+		std::ofstream	m_Stream;
+		uint64			m_LastFrame = 0;
+	};
+
+	class InputPlayer
+	{
+	public:
+		InputPlayer() = default;
+		RS_NO_COPY_AND_MOVE(InputPlayer)
+
+		/*
+		* Returns false if the file is missing or is not an input log. A log without an End event, from a run that did
+		* not stop cleanly, is replayed until its last event.
+		*/
+		bool Load(const std::string& path);
+
+		/*
+		* The events up to and including the frame that were not returned before.
+		*/
+		std::span<const InputEvent> Advance(uint64 frame);
+
+		bool IsFinished() const { return m_NextEvent >= m_Events.size(); }
+		uint64 GetFrameCount() const { return m_Events.empty() ? 0 : m_Events.back().frame; }
+		uint64 GetEventCount() const { return m_Events.size(); }
+
+	private:
+		std::vector<InputEvent>	m_Events;
+		uint64					m_NextEvent = 0;
+	};
+}
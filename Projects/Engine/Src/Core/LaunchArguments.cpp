@@ -4,6 +4,7 @@
 std::unordered_map<std::string, RS::LaunchArguments::Param>	RS::LaunchArguments::m_Params;
 std::unordered_map<std::string, RS::ParamID> RS::LaunchArguments::m_FixedParamsNameToIDMap;
 std::array<bool, RS::LaunchParams::_Internal::c_NumFixedParams>	RS::LaunchArguments::m_FixedParamsUsage;
+std::array<std::vector<std::string>, RS::LaunchParams::_Internal::c_NumFixedParams>	RS::LaunchArguments::m_FixedParamsArgs;
 std::string RS::LaunchArguments::m_ProgramName;
 std::string RS::LaunchArguments::m_FullLaunchArgumentsStr;
 
@@ -48,6 +49,15 @@ bool RS::LaunchArguments::ContainsAny(std::vector<ParamID> paramIDs)
     return false;
 }
 
+const std::vector<std::string>& RS::LaunchArguments::GetArgs(ParamID paramID)
+{
+    static const std::vector<std::string> s_NoArgs;
+    if (paramID >= LaunchParams::_Internal::c_NumFixedParams)
+        return s_NoArgs;
+
+    return m_FixedParamsArgs[paramID];
+}
+
 void RS::LaunchArguments::ParseArgs(int argc, char* argv[])
 {
     m_FullLaunchArgumentsStr = "";
@@ -64,6 +74,7 @@ void RS::LaunchArguments::ParseArgs(int argc, char* argv[])
             AddParam(shouldAdd, param);
 
             param.name = arg+1;
+            param.args.clear();
             shouldAdd = true;
         }
         else
@@ -90,6 +101,7 @@ void RS::LaunchArguments::AddParam(bool shouldAdd, const Param& param)
         else if (auto it = m_FixedParamsNameToIDMap.find(paramNameLowercase); it != m_FixedParamsNameToIDMap.end())
         {
             m_FixedParamsUsage[it->second] = true;
+            m_FixedParamsArgs[it->second] = param.args;
         }
     }
 }
@@ -103,5 +115,6 @@ void RS::LaunchArguments::FillFixedParamsList()
         name = Utils::ToLower(name);
         m_FixedParamsNameToIDMap[name] = i;
         m_FixedParamsUsage[i] = false;
+        m_FixedParamsArgs[i].clear();
     }
 }
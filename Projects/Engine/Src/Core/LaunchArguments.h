@@ -60,6 +60,11 @@ namespace RS
 		static bool ContainsAll(std::vector<ParamID> paramIDs);
 		static bool ContainsAny(std::vector<ParamID> paramIDs);
 
+		/*
+		* The arguments given after a fixed launch param, empty if it was not used.
+		*/
+		static const std::vector<std::string>& GetArgs(ParamID paramID);
+
 	private:
 		struct Param
 		{
@@ -74,6 +79,7 @@ namespace RS
 		static std::unordered_map<std::string, Param>						m_Params;
 		static std::unordered_map<std::string, ParamID>						m_FixedParamsNameToIDMap; // All names are lowercase.
 		static std::array<bool, LaunchParams::_Internal::c_NumFixedParams>	m_FixedParamsUsage;
+		static std::array<std::vector<std::string>, LaunchParams::_Internal::c_NumFixedParams>	m_FixedParamsArgs;
 		static std::string													m_ProgramName;
 		static std::string													m_FullLaunchArgumentsStr;
 	};
@@ -4,4 +4,11 @@ DEF_LAUNCH_PARAM(logDXNamedObjects, 0, "Logs all calls to when a DirectX object
 DEF_LAUNCH_PARAM(logShaderDebug, 0, "Logs extra info when compiling shader sources.")
 DEF_LAUNCH_PARAM(logResources, 0, "Logs info about the GPU resources.")
 DEF_LAUNCH_PARAM(injectRenderDoc, 0, "Enable RenderDoc to inject automatically into the process at startup.")
-DEF_LAUNCH_PARAM(noSound, 0, "Disable all types of sounds.")
\ No newline at end of file
+DEF_LAUNCH_PARAM(noSound, 0, "Disable all types of sounds.")
+DEF_LAUNCH_PARAM(noPipelineCache, 0, "Do not load or save the pipeline state cache.")
+DEF_LAUNCH_PARAM(recordInput, 1, "Records all input to the given file.")
+DEF_LAUNCH_PARAM(replayInput, 1, "Replays the input in the given file with a fixed frame time, the window input is ignored. Closes when the recording ends.")
+DEF_LAUNCH_PARAM(hiddenWindow, 0, "Creates the window hidden, for runs that do not need to be watched.")
+DEF_LAUNCH_PARAM(frameStats, 1, "Writes the frame times, percentiles and memory of the run to the given file on exit. JSON when it ends with .json, else CSV.")
+DEF_LAUNCH_PARAM(perfBudget, 1, "Fails the run with exit code 1 when the frame stats go over the budget, like frameP99=33.3,cpuP95=12,gpuP95=12,lowFPS=30,memoryMB=2048.")
+DEF_LAUNCH_PARAM(renderer2D, 0, "Draws a graph of the last frame times over Game1's image with Renderer2D.")
\ No newline at end of file
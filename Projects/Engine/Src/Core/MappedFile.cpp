@@ -0,0 +1,65 @@
+#include "PreCompiled.h"
+#include "MappedFile.h"
+
+RS::MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool RS::MappedFile::Open(const std::string& path)
+{
+	Close();
+
+	std::wstring widePath = Utils::ToWString(path);
+	// Editors and tools have to be able to write to the file while it is open, hot reload depends on it.
+	m_File = CreateFileW(widePath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (m_File == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(m_File, &fileSize))
+	{
+		Close();
+		return false;
+	}
+	m_Size = (uint64)fileSize.QuadPart;
+
+	// Empty files cannot be mapped, they are still valid files.
+	if (m_Size > 0)
+	{
+		m_Mapping = CreateFileMappingW(m_File, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (m_Mapping == nullptr)
+		{
+			LOG_WARNING("Failed to create file mapping for {}! Error: {}", path.c_str(), GetLastError());
+			Close();
+			return false;
+		}
+
+		m_pData = (const uint8*)MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0);
+		if (m_pData == nullptr)
+		{
+			LOG_WARNING("Failed to map view of {}! Error: {}", path.c_str(), GetLastError());
+			Close();
+			return false;
+		}
+	}
+
+	m_IsOpen = true;
+	return true;
+}
+
+void RS::MappedFile::Close()
+{
+	if (m_pData)
+		UnmapViewOfFile(m_pData);
+	if (m_Mapping)
+		CloseHandle(m_Mapping);
+	if (m_File != INVALID_HANDLE_VALUE)
+		CloseHandle(m_File);
+
+	m_pData = nullptr;
+	m_Mapping = nullptr;
+	m_File = INVALID_HANDLE_VALUE;
+	m_Size = 0;
+	m_IsOpen = false;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+namespace RS
+{
+	/*
+	* Read only memory mapping of a whole file. The pages are loaded by the OS when touched, nothing is copied.
+	* Other processes can still write to the file, the mapped data then changes with it.
+	*/
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		~MappedFile();
+		RS_NO_COPY_AND_MOVE(MappedFile)
+
+		bool Open(const std::string& path);
+		void Close();
+
+		bool IsOpen() const { return m_IsOpen; }
+		const uint8* GetData() const { return m_pData; }
+		uint64 GetSize() const { return m_Size; }
+
+	private:
+		HANDLE m_File = INVALID_HANDLE_VALUE;
+		HANDLE m_Mapping = nullptr;
+		const uint8* m_pData = nullptr;
+		uint64 m_Size = 0;
+		bool m_IsOpen = false;
+	};
+}
@@ -0,0 +1,236 @@
+#include "PreCompiled.h"
+#include "PakFile.h"
+
+#include "Core/MappedFile.h"
+#include "Utils/Misc/LZ4Utils.h"
+#include "Utils/Misc/xxhash.h"
+
+#include <fstream>
+#include <filesystem>
+
+void RS::PakWriter::SetAlignment(uint32 alignment)
+{
+	RS_ASSERT(alignment > 0 && (alignment & (alignment - 1)) == 0, "Pak alignment has to be a power of two!");
+	m_Alignment = alignment;
+}
+
+void RS::PakWriter::AddData(const std::string& path, std::span<const uint8> data, PakCompression compression)
+{
+	Entry entry;
+	entry.path = VFS::NormalizePath(path);
+	entry.size = data.size();
+	entry.compression = PakCompression::None;
+
+	if (compression == PakCompression::LZ4 && !data.empty())
+	{
+		entry.storedData.resize(Utils::LZ4CompressBound(data.size()));
+		uint64 compressedSize = Utils::LZ4Compress(data.data(), data.size(), entry.storedData.data(), entry.storedData.size());
+		if (compressedSize > 0 && compressedSize < data.size())
+		{
+			entry.storedData.resize(compressedSize);
+			entry.compression = PakCompression::LZ4;
+		}
+	}
+
+	if (entry.compression == PakCompression::None)
+		entry.storedData.assign(data.begin(), data.end());
+
+	auto it = m_PathToIndex.find(entry.path);
+	if (it != m_PathToIndex.end())
+	{
+		m_Entries[it->second] = std::move(entry);
+		return;
+	}
+
+	m_PathToIndex[entry.path] = m_Entries.size();
+	m_Entries.push_back(std::move(entry));
+}
+
+bool RS::PakWriter::AddFile(const std::string& path, const std::string& diskPath, PakCompression compression)
+{
+	MappedFile file;
+	if (!file.Open(diskPath))
+	{
+		LOG_WARNING("Cannot add {} to pak, failed to open the file!", diskPath.c_str());
+		return false;
+	}
+
+	AddData(path, std::span<const uint8>(file.GetData(), file.GetSize()), compression);
+	return true;
+}
+
+bool RS::PakWriter::AddDirectory(const std::string& directoryPath, PakCompression compression)
+{
+	std::error_code error;
+	if (!std::filesystem::is_directory(directoryPath, error))
+		return false;
+
+	bool result = true;
+	for (const std::filesystem::directory_entry& dirEntry : std::filesystem::recursive_directory_iterator(directoryPath))
+	{
+		if (!dirEntry.is_regular_file())
+			continue;
+
+		std::string relativePath = std::filesystem::relative(dirEntry.path(), directoryPath).generic_string();
+		result &= AddFile(relativePath, dirEntry.path().generic_string(), compression);
+	}
+	return result;
+}
+
+bool RS::PakWriter::Write(const std::string& pakPath) const
+{
+	std::ofstream stream(pakPath, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!stream.is_open())
+	{
+		LOG_WARNING("Failed to open {} for writing!", pakPath.c_str());
+		return false;
+	}
+
+	auto alignUp = [&](uint64 offset) { return (offset + m_Alignment - 1) & ~((uint64)m_Alignment - 1); };
+	const std::vector<char> zeros(m_Alignment, 0);
+
+	PakHeader header;
+	header.entryCount = (uint32)m_Entries.size();
+	header.alignment = m_Alignment;
+	stream.write((const char*)&header, sizeof(header));
+
+	std::vector<PakEntry> toc(m_Entries.size());
+	std::string paths;
+	uint64 offset = sizeof(PakHeader);
+	for (uint64 i = 0; i < m_Entries.size(); ++i)
+	{
+		const Entry& entry = m_Entries[i];
+
+		const uint64 alignedOffset = alignUp(offset);
+		stream.write(zeros.data(), alignedOffset - offset);
+		stream.write((const char*)entry.storedData.data(), entry.storedData.size());
+		offset = alignedOffset + entry.storedData.size();
+
+		PakEntry& pakEntry = toc[i];
+		pakEntry.dataOffset = alignedOffset;
+		pakEntry.storedSize = entry.storedData.size();
+		pakEntry.size = entry.size;
+		pakEntry.pathOffset = (uint32)paths.size();
+		pakEntry.pathLength = (uint32)entry.path.size();
+		pakEntry.compression = entry.compression;
+		paths += entry.path;
+	}
+
+	std::vector<uint8> tocData(toc.size() * sizeof(PakEntry) + paths.size());
+	if (!toc.empty())
+		std::memcpy(tocData.data(), toc.data(), toc.size() * sizeof(PakEntry));
+	if (!paths.empty())
+		std::memcpy(tocData.data() + toc.size() * sizeof(PakEntry), paths.data(), paths.size());
+
+	header.tocOffset = alignUp(offset);
+	header.tocSize = tocData.size();
+	header.tocChecksum = xxh::xxhash3<64>(tocData.data(), tocData.size());
+	stream.write(zeros.data(), header.tocOffset - offset);
+	stream.write((const char*)tocData.data(), tocData.size());
+
+	stream.seekp(0, std::ios::beg);
+	stream.write((const char*)&header, sizeof(header));
+	return stream.good();
+}
+
+RS::PakFileProvider::PakFileProvider() = default;
+RS::PakFileProvider::~PakFileProvider() = default;
+
+bool RS::PakFileProvider::Load(const std::string& pakPath)
+{
+	m_PakPath = pakPath;
+	m_Entries.clear();
+	m_PathToIndex.clear();
+
+	m_pMappedFile = std::make_shared<MappedFile>();
+	if (!m_pMappedFile->Open(pakPath))
+	{
+		LOG_WARNING("Failed to open pak {}!", pakPath.c_str());
+		return false;
+	}
+
+	const uint8* pData = m_pMappedFile->GetData();
+	const uint64 fileSize = m_pMappedFile->GetSize();
+
+	PakHeader header;
+	if (fileSize < sizeof(PakHeader))
+	{
+		LOG_WARNING("Pak {} is too small!", pakPath.c_str());
+		return false;
+	}
+	std::memcpy(&header, pData, sizeof(header));
+
+	if (header.magic != PakHeader::Magic || header.version != PakHeader::Version)
+	{
+		LOG_WARNING("Pak {} has the wrong magic or version! Version: {}", pakPath.c_str(), header.version);
+		return false;
+	}
+
+	const uint64 entriesSize = (uint64)header.entryCount * sizeof(PakEntry);
+	if (header.tocOffset > fileSize || header.tocSize > fileSize - header.tocOffset || entriesSize > header.tocSize
+		|| header.tocChecksum != xxh::xxhash3<64>(pData + header.tocOffset, header.tocSize))
+	{
+		LOG_WARNING("Pak {} has a corrupt table of contents!", pakPath.c_str());
+		return false;
+	}
+
+	const uint8* pToc = pData + header.tocOffset;
+	const char* pPaths = (const char*)(pToc + entriesSize);
+	const uint64 pathsSize = header.tocSize - entriesSize;
+
+	m_Entries.resize(header.entryCount);
+	if (entriesSize > 0)
+		std::memcpy(m_Entries.data(), pToc, entriesSize);
+
+	for (uint64 i = 0; i < m_Entries.size(); ++i)
+	{
+		const PakEntry& entry = m_Entries[i];
+		const bool isValid = (uint64)entry.pathOffset + entry.pathLength <= pathsSize
+			&& entry.dataOffset <= fileSize && entry.storedSize <= fileSize - entry.dataOffset
+			&& (entry.compression == PakCompression::LZ4 || (entry.compression == PakCompression::None && entry.storedSize == entry.size));
+		if (!isValid)
+		{
+			LOG_WARNING("Pak {} has a corrupt entry at index {}!", pakPath.c_str(), i);
+			m_Entries.clear();
+			m_PathToIndex.clear();
+			return false;
+		}
+
+		m_PathToIndex[std::string(pPaths + entry.pathOffset, entry.pathLength)] = i;
+	}
+
+	return true;
+}
+
+std::shared_ptr<RS::VFSFile> RS::PakFileProvider::Open(const std::string& path)
+{
+	const PakEntry* pEntry = FindEntry(path);
+	if (!pEntry)
+		return nullptr;
+
+	const uint8* pStoredData = m_pMappedFile->GetData() + pEntry->dataOffset;
+	const std::string debugPath = m_PakPath + ":" + path;
+	if (pEntry->compression == PakCompression::None)
+		return std::make_shared<VFSFile>(debugPath, std::span<const uint8>(pStoredData, pEntry->size), m_pMappedFile);
+
+	std::shared_ptr<std::vector<uint8>> pBuffer = std::make_shared<std::vector<uint8>>(pEntry->size);
+	if (!Utils::LZ4Decompress(pStoredData, pEntry->storedSize, pBuffer->data(), pBuffer->size()))
+	{
+		LOG_ERROR("Failed to decompress {}!", debugPath.c_str());
+		return nullptr;
+	}
+	return std::make_shared<VFSFile>(debugPath, std::span<const uint8>(pBuffer->data(), pBuffer->size()), pBuffer);
+}
+
+bool RS::PakFileProvider::Exists(const std::string& path) const
+{
+	return FindEntry(path) != nullptr;
+}
+
+const RS::PakEntry* RS::PakFileProvider::FindEntry(const std::string& path) const
+{
+	auto it = m_PathToIndex.find(path);
+	if (it == m_PathToIndex.end())
+		return nullptr;
+	return &m_Entries[it->second];
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "Core/VFS.h"
+
+#include <unordered_map>
+
+namespace RS
+{
+	class MappedFile;
+
+	/*
+	* Pak file layout:
+	*	PakHeader
+	*	Entry data, each entry starts at a multiple of the alignment.
+	*	Table of contents: PakEntry[entryCount] followed by all paths (not null terminated).
+	* The table of contents is written last so files can be streamed into the pak. It has a checksum, the entry data does not.
+	*/
+	enum class PakCompression : uint32
+	{
+		None = 0,
+		LZ4
+	};
+
+	struct PakHeader
+	{
+		inline static constexpr uint32 Magic = 0x4B415052; // "RPAK"
+		inline static constexpr uint32 Version = 1;
+
+		uint32 magic = Magic;
+		uint32 version = Version;
+		uint32 entryCount = 0;
+		uint32 alignment = 0;
+		uint64 tocOffset = 0;
+		uint64 tocSize = 0;
+		uint64 tocChecksum = 0;
+	};
+
+	struct PakEntry
+	{
+		uint64 dataOffset = 0;
+		uint64 storedSize = 0;	// Size in the pak.
+		uint64 size = 0;		// Size after decompression.
+		uint32 pathOffset = 0;	// Offset into the path block of the table of contents.
+		uint32 pathLength = 0;
+		PakCompression compression = PakCompression::None;
+		uint32 padding = 0;
+	};
+
+	class PakWriter
+	{
+	public:
+		PakWriter() = default;
+		RS_NO_COPY_AND_MOVE(PakWriter)
+
+		// Entry data starts at a multiple of this. Has to be a power of two.
+		void SetAlignment(uint32 alignment);
+
+		/*
+		* Compressed entries that would not get smaller are stored uncompressed instead. Adding a path twice replaces the old data.
+		*/
+		void AddData(const std::string& path, std::span<const uint8> data, PakCompression compression = PakCompression::None);
+		bool AddFile(const std::string& path, const std::string& diskPath, PakCompression compression = PakCompression::None);
+
+		/*
+		* Adds every file in the directory, with paths relative to it.
+		*/
+		bool AddDirectory(const std::string& directoryPath, PakCompression compression = PakCompression::None);
+
+		bool Write(const std::string& pakPath) const;
+
+		uint64 GetEntryCount() const { return m_Entries.size(); }
+
+	private:
+		struct Entry
+		{
+			std::string path;
+			std::vector<uint8> storedData;
+			uint64 size = 0;
+			PakCompression compression = PakCompression::None;
+		};
+
+		uint32 m_Alignment = 16;
+		std::vector<Entry> m_Entries;
+		std::unordered_map<std::string, uint64> m_PathToIndex;
+	};
+
+	/*
+	* Memory maps a pak. Uncompressed entries are handed out as views into the mapping, compressed entries are decompressed into a buffer on Open.
+	*/
+	class PakFileProvider : public IFileProvider
+	{
+	public:
+		PakFileProvider();
+		~PakFileProvider();
+
+		bool Load(const std::string& pakPath);
+
+		std::shared_ptr<VFSFile> Open(const std::string& path) override;
+		bool Exists(const std::string& path) const override;
+		std::string GetName() const override { return "Pak: " + m_PakPath; }
+
+		const PakEntry* FindEntry(const std::string& path) const;
+		uint64 GetEntryCount() const { return m_Entries.size(); }
+
+	private:
+		std::string m_PakPath;
+		std::shared_ptr<MappedFile> m_pMappedFile;
+		std::vector<PakEntry> m_Entries;
+		std::unordered_map<std::string, uint64> m_PathToIndex;
+	};
+}
@@ -0,0 +1,388 @@
+#include "PreCompiled.h"
+#include "Profiler.h"
+
+#include "Utils/Timer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <string_view>
+#include <unordered_map>
+
+namespace RS::_ProfilerInternal
+{
+	struct OpenZone
+	{
+		const char*	pName;
+		uint64		begin;
+	};
+
+	/*
+	* A zone in the ring. EndFrame can read a slot while its thread writes the next zone into it, so the fields are atomic
+	* and generation says which zone they belong to: the index in the ring plus one, 0 while it is being written.
+	*/
+	struct ZoneSlot
+	{
+		std::atomic<uint64>			generation;
+		std::atomic<const char*>	pName;
+		std::atomic<uint64>			begin;
+		std::atomic<uint64>			end;
+		std::atomic<uint32>			depth;
+	};
+
+	struct ThreadBuffer
+	{
+		std::unique_ptr<ZoneSlot[]>	zones = std::make_unique<ZoneSlot[]>(Profiler::RingSize);
+		std::atomic<uint64>			written = 0;	// Only the owning thread, or the one recording on the track, writes it.
+		uint64						read = 0;		// Only EndFrame uses it.
+
+		OpenZone					open[Profiler::MaxDepth];
+		uint32						depth = 0;
+		uint32						index = 0;
+		std::string					name;			// Guarded by the threads mutex.
+	};
+
+	// Gives the buffer of the thread back to the profiler when the thread exits.
+	struct ThreadBufferReleaser
+	{
+		~ThreadBufferReleaser() { Profiler::ReleaseThreadBuffer(); }
+	};
+	thread_local ThreadBufferReleaser t_ThreadBufferReleaser;
+
+	void WriteEscaped(std::ostream& stream, const char* pString)
+	{
+		for (const char* pChar = pString; *pChar != '\0'; ++pChar)
+		{
+			if (*pChar == '"' || *pChar == '\\')
+				stream << '\\';
+			if ((uint8)*pChar >= 0x20)
+				stream << *pChar;
+		}
+	}
+}
+
+RS::Profiler::~Profiler()
+{
+	s_IsDestroyed.store(true, std::memory_order_relaxed);
+}
+
+RS::Profiler* RS::Profiler::Get()
+{
+	static Profiler s_Profiler;
+	return &s_Profiler;
+}
+
+void RS::Profiler::BeginZone(const char* pName)
+{
+	_ProfilerInternal::ThreadBuffer* pBuffer = GetThreadBuffer();
+	const uint32 depth = pBuffer->depth++;
+	if (depth < MaxDepth)
+		pBuffer->open[depth] = { pName, Timer::GetCurrentTick() };
+}
+
+void RS::Profiler::EndZone()
+{
+	const uint64 end = Timer::GetCurrentTick();
+
+	_ProfilerInternal::ThreadBuffer* pBuffer = s_pThreadBuffer;
+	const uint32 depth = --pBuffer->depth;
+	if (depth >= MaxDepth)
+	{
+		s_DroppedZoneCount.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	const _ProfilerInternal::OpenZone& open = pBuffer->open[depth];
+	WriteZone(pBuffer, { open.pName, open.begin, end, depth, pBuffer->index });
+}
+
+void RS::Profiler::SetThreadName(const std::string& name)
+{
+	_ProfilerInternal::ThreadBuffer* pBuffer = GetThreadBuffer();
+	std::lock_guard<std::mutex> lock(m_ThreadsMutex);
+	pBuffer->name = name;
+}
+
+std::vector<std::string> RS::Profiler::GetThreadNames() const
+{
+	std::lock_guard<std::mutex> lock(m_ThreadsMutex);
+	std::vector<std::string> names;
+	names.reserve(m_Threads.size());
+	for (const std::unique_ptr<_ProfilerInternal::ThreadBuffer>& pBuffer : m_Threads)
+		names.push_back(pBuffer->name);
+	return names;
+}
+
+uint32 RS::Profiler::AddTrack(const std::string& name)
+{
+	std::lock_guard<std::mutex> lock(m_ThreadsMutex);
+	auto pBuffer = std::make_unique<_ProfilerInternal::ThreadBuffer>();
+	pBuffer->index = (uint32)m_Threads.size();
+	pBuffer->name = name;
+	m_Threads.push_back(std::move(pBuffer));
+	return m_Threads.back()->index;
+}
+
+void RS::Profiler::RecordZone(uint32 track, const char* pName, uint64 begin, uint64 end, uint32 depth)
+{
+	RecordZone(GetTrackHandle(track), pName, begin, end, depth);
+}
+
+RS::Profiler::TrackHandle RS::Profiler::GetTrackHandle(uint32 track) const
+{
+	std::lock_guard<std::mutex> lock(m_ThreadsMutex);
+	RS_ASSERT(track < (uint32)m_Threads.size(), "There is no track {}!", track);
+	return m_Threads[track].get();
+}
+
+void RS::Profiler::RecordZone(TrackHandle track, const char* pName, uint64 begin, uint64 end, uint32 depth)
+{
+	WriteZone(track, { pName, begin, end, depth, track->index });
+}
+
+void RS::Profiler::EndFrame()
+{
+	const uint64 now = Timer::GetCurrentTick();
+
+	Frame* pFrame = nullptr;
+	if (!m_IsPaused)
+	{
+		if (m_Frames.size() < m_FrameHistorySize)
+		{
+			m_NewestFrame = (uint32)m_Frames.size();
+			m_Frames.emplace_back();
+		}
+		else
+		{
+			m_NewestFrame = (m_NewestFrame + 1) % (uint32)m_Frames.size();
+		}
+		pFrame = &m_Frames[m_NewestFrame];
+		pFrame->index = m_FrameIndex;
+		pFrame->begin = m_LastFrameEnd == 0 ? now : m_LastFrameEnd;
+		pFrame->end = now;
+		pFrame->zones.clear();
+	}
+	m_FrameIndex++;
+	m_LastFrameEnd = now;
+
+	std::lock_guard<std::mutex> lock(m_ThreadsMutex);
+	for (const std::unique_ptr<_ProfilerInternal::ThreadBuffer>& pBuffer : m_Threads)
+	{
+		const uint64 written = pBuffer->written.load(std::memory_order_acquire);
+		if (written - pBuffer->read > RingSize)
+		{
+			s_DroppedZoneCount.fetch_add(written - RingSize - pBuffer->read, std::memory_order_relaxed);
+			pBuffer->read = written - RingSize;
+		}
+
+		if (pFrame)
+		{
+			// The thread keeps going while the zones are copied, the ones it writes over in the meantime are dropped.
+			Zone zone;
+			for (uint64 i = pBuffer->read; i < written; ++i)
+			{
+				if (ReadZone(pBuffer.get(), i, zone))
+					pFrame->zones.push_back(zone);
+				else
+					s_DroppedZoneCount.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+		pBuffer->read = written;
+	}
+
+	if (pFrame)
+	{
+		std::sort(pFrame->zones.begin(), pFrame->zones.end(), [](const Zone& a, const Zone& b)
+			{
+				if (a.thread != b.thread)
+					return a.thread < b.thread;
+				if (a.begin != b.begin)
+					return a.begin < b.begin;
+				return a.depth < b.depth;
+			});
+	}
+}
+
+void RS::Profiler::SetFrameHistorySize(uint32 frameCount)
+{
+	RS_ASSERT(frameCount > 0, "The profiler has to keep at least one frame!");
+
+	m_FrameHistorySize = frameCount;
+	ClearFrames();
+}
+
+void RS::Profiler::ClearFrames()
+{
+	m_Frames.clear();
+	m_NewestFrame = 0;
+}
+
+const RS::Profiler::Frame& RS::Profiler::GetFrame(uint32 framesAgo) const
+{
+	RS_ASSERT(framesAgo < (uint32)m_Frames.size(), "Only {} frames are kept!", m_Frames.size());
+
+	const uint32 frameCount = (uint32)m_Frames.size();
+	return m_Frames[(m_NewestFrame + frameCount - framesAgo) % frameCount];
+}
+
+bool RS::Profiler::ExportChromeTrace(const std::string& path) const
+{
+	std::filesystem::path directory = std::filesystem::path(path).parent_path();
+	if (!directory.empty())
+		std::filesystem::create_directories(directory);
+
+	std::ofstream stream(path, std::ios::out | std::ios::trunc);
+	if (!stream.is_open())
+	{
+		LOG_WARNING("Failed to open {} to export the profiler frames!", path.c_str());
+		return false;
+	}
+
+	ExportChromeTrace(stream);
+	LOG_INFO("Exported {} profiler frames to {}", m_Frames.size(), path.c_str());
+	return true;
+}
+
+void RS::Profiler::ExportChromeTrace(std::ostream& stream) const
+{
+	using namespace _ProfilerInternal;
+
+	// Times are in microseconds from the start of the oldest frame.
+	const uint32 frameCount = GetFrameCount();
+	const uint64 start = frameCount > 0 ? GetFrame(frameCount - 1).begin : 0;
+	auto ToUs = [&](uint64 tick) { return TicksToMs(tick - std::min(tick, start)) * 1000.0; };
+
+	stream << std::fixed << std::setprecision(3);
+	stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+	const std::vector<std::string> threadNames = GetThreadNames();
+	bool isFirst = true;
+	for (uint32 thread = 0; thread < (uint32)threadNames.size(); ++thread)
+	{
+		stream << (isFirst ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << thread << ",\"args\":{\"name\":\"";
+		WriteEscaped(stream, threadNames[thread].empty() ? Utils::Format("Thread {}", thread).c_str() : threadNames[thread].c_str());
+		stream << "\"}}";
+		isFirst = false;
+	}
+
+	for (uint32 framesAgo = frameCount; framesAgo-- > 0;)
+	{
+		const Frame& frame = GetFrame(framesAgo);
+		stream << (isFirst ? "" : ",\n") << "{\"name\":\"Frame " << frame.index << "\",\"cat\":\"Frame\",\"ph\":\"X\",\"pid\":0,\"tid\":\"Frames\",\"ts\":"
+			<< ToUs(frame.begin) << ",\"dur\":" << TicksToMs(frame.end - frame.begin) * 1000.0 << "}";
+		isFirst = false;
+
+		for (const Zone& zone : frame.zones)
+		{
+			stream << ",\n{\"name\":\"";
+			WriteEscaped(stream, zone.pName);
+			stream << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << zone.thread << ",\"ts\":" << ToUs(zone.begin)
+				<< ",\"dur\":" << TicksToMs(zone.end - zone.begin) * 1000.0 << "}";
+		}
+	}
+	stream << "\n]}\n";
+}
+
+void RS::Profiler::GetZoneStats(const Frame& frame, std::vector<ZoneStats>& stats)
+{
+	stats.clear();
+
+	// The same name can be at different addresses, every translation unit can have its own copy of a literal.
+	std::unordered_map<std::string_view, uint32> statsIndices;
+	for (const Zone& zone : frame.zones)
+	{
+		auto [it, isNew] = statsIndices.try_emplace(zone.pName, (uint32)stats.size());
+		if (isNew)
+			stats.push_back({ zone.pName, 0, 0.0, 0.0 });
+
+		ZoneStats& zoneStats = stats[it->second];
+		const double ms = TicksToMs(zone.end - zone.begin);
+		zoneStats.count++;
+		zoneStats.totalMs += ms;
+		zoneStats.maxMs = std::max(zoneStats.maxMs, ms);
+	}
+
+	std::sort(stats.begin(), stats.end(), [](const ZoneStats& a, const ZoneStats& b) { return a.totalMs > b.totalMs; });
+}
+
+double RS::Profiler::TicksToMs(uint64 ticks)
+{
+	// Timer::GetCurrentTick counts in steady clock ticks.
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::duration((std::chrono::steady_clock::rep)ticks)).count();
+}
+
+void RS::Profiler::WriteZone(_ProfilerInternal::ThreadBuffer* pBuffer, const Zone& zone)
+{
+	const uint64 written = pBuffer->written.load(std::memory_order_relaxed);
+	_ProfilerInternal::ZoneSlot& slot = pBuffer->zones[written & (RingSize - 1)];
+
+	// A seqlock per slot. The fence keeps the fields from being written before the slot is marked, so a reader that sees
+	// any of the new fields also sees the new generation when it checks it again.
+	slot.generation.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.pName.store(zone.pName, std::memory_order_relaxed);
+	slot.begin.store(zone.begin, std::memory_order_relaxed);
+	slot.end.store(zone.end, std::memory_order_relaxed);
+	slot.depth.store(zone.depth, std::memory_order_relaxed);
+	slot.generation.store(written + 1, std::memory_order_release);
+
+	// Publishes the zone to EndFrame, which reads up to the written count it loads.
+	pBuffer->written.store(written + 1, std::memory_order_release);
+}
+
+bool RS::Profiler::ReadZone(const _ProfilerInternal::ThreadBuffer* pBuffer, uint64 index, Zone& zone)
+{
+	const _ProfilerInternal::ZoneSlot& slot = pBuffer->zones[index & (RingSize - 1)];
+	if (slot.generation.load(std::memory_order_acquire) != index + 1)
+		return false;
+
+	zone.pName = slot.pName.load(std::memory_order_relaxed);
+	zone.begin = slot.begin.load(std::memory_order_relaxed);
+	zone.end = slot.end.load(std::memory_order_relaxed);
+	zone.depth = slot.depth.load(std::memory_order_relaxed);
+	zone.thread = pBuffer->index;
+
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return slot.generation.load(std::memory_order_relaxed) == index + 1;
+}
+
+RS::_ProfilerInternal::ThreadBuffer* RS::Profiler::GetThreadBuffer()
+{
+	if (s_pThreadBuffer)
+		return s_pThreadBuffer;
+
+	// Constructs the releaser of this thread, which runs when it exits.
+	(void)_ProfilerInternal::t_ThreadBufferReleaser;
+
+	// The buffers outlive their threads, a thread that is gone can still have zones to collect.
+	Profiler* pProfiler = Get();
+	std::lock_guard<std::mutex> lock(pProfiler->m_ThreadsMutex);
+	if (!pProfiler->m_FreeThreads.empty())
+	{
+		s_pThreadBuffer = pProfiler->m_FreeThreads.back();
+		pProfiler->m_FreeThreads.pop_back();
+		s_pThreadBuffer->name.clear();
+		return s_pThreadBuffer;
+	}
+
+	auto pBuffer = std::make_unique<_ProfilerInternal::ThreadBuffer>();
+	pBuffer->index = (uint32)pProfiler->m_Threads.size();
+	s_pThreadBuffer = pBuffer.get();
+	pProfiler->m_Threads.push_back(std::move(pBuffer));
+	return s_pThreadBuffer;
+}
+
+void RS::Profiler::ReleaseThreadBuffer()
+{
+	if (!s_pThreadBuffer || s_IsDestroyed.load(std::memory_order_relaxed))
+		return;
+
+	// The zones it has written stay in the ring until EndFrame collects them, the next thread writes after them.
+	Profiler* pProfiler = Get();
+	std::lock_guard<std::mutex> lock(pProfiler->m_ThreadsMutex);
+	s_pThreadBuffer->depth = 0;
+	pProfiler->m_FreeThreads.push_back(s_pThreadBuffer);
+	s_pThreadBuffer = nullptr;
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <ostream>
+
+/*
+* Times the rest of the scope as a zone in the Profiler. Only the pointer of the name is stored, use a string literal.
+*/
+#define RS_PROFILE_SCOPE(name) RS::ProfileScope CONCAT(_profileScope, __LINE__)(name)
+
+namespace RS
+{
+	namespace _ProfilerInternal
+	{
+		struct ThreadBuffer;
+		struct ThreadBufferReleaser;
+	}
+
+	/*
+	* Scoped CPU zones, nested per thread. Every thread writes the zones it ends into its own ring buffer, which no other
+	* thread writes to, so recording a zone takes no locks. EndFrame collects the zones of all threads into a frame and
+	* keeps the last frames around to look at or export as a Chrome trace, which Perfetto opens too.
+	* The buffer of a thread that exits is given to the next new thread, so its row in the trace can show several threads
+	* one after the other.
+	*/
+	class Profiler
+	{
+	public:
+		// Zones a thread can end between two EndFrame calls before the oldest ones are dropped.
+		inline static constexpr uint32 RingSize = 1u << 14;
+		// Deeper zones are not recorded.
+		inline static constexpr uint32 MaxDepth = 32;
+		inline static constexpr uint32 DefaultFrameHistorySize = 300;
+
+		struct Zone
+		{
+			const char*	pName;
+			uint64		begin;	// In Timer::GetCurrentTick ticks.
+			uint64		end;
+			uint32		depth;	// Zones that were open on the thread when it began.
+			uint32		thread;	// Index into GetThreadNames.
+		};
+
+		struct Frame
+		{
+			uint64				index = 0;
+			uint64				begin = 0;
+			uint64				end = 0;
+			std::vector<Zone>	zones; // Sorted by thread, then by begin.
+		};
+
+		// Zones of one frame with the same name, summed up.
+		struct ZoneStats
+		{
+			const char*	pName;
+			uint32		count;
+			double		totalMs; // Including the zones inside of them.
+			double		maxMs;
+		};
+
+	public:
+		Profiler() = default;
+		~Profiler();
+		RS_NO_COPY_AND_MOVE(Profiler)
+
+		static Profiler* Get();
+
+		static void BeginZone(const char* pName);
+		static void EndZone();
+
+		/*
+		* Names the calling thread in the profiler, CorePlatform::SetCurrentThreadName calls this.
+		*/
+		void SetThreadName(const std::string& name);
+		std::vector<std::string> GetThreadNames() const;
+
+		/*
+		* A named row for zones that are not timed on a thread, like GPU work. Returns the index to record them with,
+		* which is also the index of its name in GetThreadNames.
+		*/
+		uint32 AddTrack(const std::string& name);
+
+		/*
+		* Records a zone that was timed some other way on a track from AddTrack. Only one thread at a time may record on
+		* a track. The times are in Timer::GetCurrentTick ticks.
+		*/
+		void RecordZone(uint32 track, const char* pName, uint64 begin, uint64 end, uint32 depth);
+
+		/*
+		* A track to record on without the lock, for threads that must never block like the audio callback. Look it up
+		* once, outside of that thread. Recording on it does not allocate.
+		*/
+		using TrackHandle = _ProfilerInternal::ThreadBuffer*;
+		TrackHandle GetTrackHandle(uint32 track) const;
+		static void RecordZone(TrackHandle track, const char* pName, uint64 begin, uint64 end, uint32 depth);
+
+		/*
+		* Collects the zones that ended since the last call as one frame. Call it once per frame, the frames may only be
+		* read from the thread that calls this.
+		*/
+		void EndFrame();
+
+		/*
+		* Paused, EndFrame drops the zones and the frames that are kept stay the same.
+		*/
+		void SetPaused(bool isPaused) { m_IsPaused = isPaused; }
+		bool IsPaused() const { return m_IsPaused; }
+
+		void SetFrameHistorySize(uint32 frameCount);
+		void ClearFrames();
+
+		uint32 GetFrameCount() const { return (uint32)m_Frames.size(); }
+
+		// 0 is the newest frame.
+		const Frame& GetFrame(uint32 framesAgo) const;
+
+		// Zones that were lost because a ring buffer was full or a zone was too deep.
+		uint64 GetDroppedZoneCount() const { return s_DroppedZoneCount.load(std::memory_order_relaxed); }
+
+		/*
+		* Writes the frames that are kept in the Chrome trace event format, oldest first.
+		*/
+		bool ExportChromeTrace(const std::string& path) const;
+		void ExportChromeTrace(std::ostream& stream) const;
+
+		// Sorted by total time, highest first.
+		static void GetZoneStats(const Frame& frame, std::vector<ZoneStats>& stats);
+
+		static double TicksToMs(uint64 ticks);
+
+	private:
+		friend struct _ProfilerInternal::ThreadBufferReleaser;
+
+		static _ProfilerInternal::ThreadBuffer* GetThreadBuffer();
+		static void ReleaseThreadBuffer();
+		static void WriteZone(_ProfilerInternal::ThreadBuffer* pBuffer, const Zone& zone);
+		// False when the zone was written over while it was read.
+		static bool ReadZone(const _ProfilerInternal::ThreadBuffer* pBuffer, uint64 index, Zone& zone);
+
+	private:
+		mutable std::mutex												m_ThreadsMutex;
+		std::vector<std::unique_ptr<_ProfilerInternal::ThreadBuffer>>	m_Threads;
+		std::vector<_ProfilerInternal::ThreadBuffer*>					m_FreeThreads; // Of threads that exited.
+
+		std::vector<Frame>		m_Frames; // Ring, m_NewestFrame is the newest.
+		uint32					m_NewestFrame = 0;
+		uint32					m_FrameHistorySize = DefaultFrameHistorySize;
+		uint64					m_FrameIndex = 0;
+		uint64					m_LastFrameEnd = 0;
+		bool					m_IsPaused = false;
+
+		inline static std::atomic<uint64> s_DroppedZoneCount = 0;
+		inline static std::atomic<bool> s_IsDestroyed = false; // Threads can exit after the profiler is gone.
+		inline static thread_local _ProfilerInternal::ThreadBuffer* s_pThreadBuffer = nullptr;
+	};
+
+	class ProfileScope
+	{
+	public:
+		explicit ProfileScope(const char* pName) { Profiler::BeginZone(pName); }
+		~ProfileScope() { Profiler::EndZone(); }
+		RS_NO_COPY_AND_MOVE(ProfileScope)
+	};
+}
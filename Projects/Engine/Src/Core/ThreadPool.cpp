@@ -0,0 +1,160 @@
+#include "PreCompiled.h"
+#include "ThreadPool.h"
+
+#include "Core/CorePlatform.h"
+
+#include <atomic>
+#include <exception>
+
+RS::ThreadPool::ThreadPool()
+	: m_Running(false)
+{
+}
+
+RS::ThreadPool::~ThreadPool()
+{
+	Release();
+}
+
+std::shared_ptr<RS::ThreadPool> RS::ThreadPool::Get()
+{
+	static std::shared_ptr<ThreadPool> s_ThreadPool = []()
+	{
+		std::shared_ptr<ThreadPool> pThreadPool = std::make_shared<ThreadPool>();
+		pThreadPool->Init(CorePlatform::GetCoreCount(), "Worker");
+		return pThreadPool;
+	}();
+	return s_ThreadPool;
+}
+
+void RS::ThreadPool::Init(uint threadCount, const std::string& threadName)
+{
+	Release();
+
+	m_Running = true;
+	m_Threads.reserve(threadCount);
+	for (uint i = 0; i < threadCount; ++i)
+		m_Threads.emplace_back(&RS::ThreadPool::ThreadFunction, this, i, Utils::Format("{} {}", threadName, i));
+}
+
+void RS::ThreadPool::Release()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Running = false;
+	}
+	m_Condition.notify_all();
+
+	for (std::thread& thread : m_Threads)
+		thread.join();
+	m_Threads.clear();
+
+	// Jobs that never got to run will break their promises, which the futures will report.
+	m_Jobs.clear();
+}
+
+void RS::ThreadPool::ParallelFor(uint64 count, const std::function<void(uint64)>& func, uint maxThreads)
+{
+	if (count == 0)
+		return;
+
+	uint threadCount = GetThreadCount() + 1; // Workers and the calling thread.
+	if (maxThreads != 0 && maxThreads < threadCount)
+		threadCount = maxThreads;
+	if ((uint64)threadCount > count)
+		threadCount = (uint)count;
+
+	if (threadCount <= 1)
+	{
+		for (uint64 i = 0; i < count; ++i)
+			func(i);
+		return;
+	}
+
+	// Shared with the helper jobs, they might start after this function has returned.
+	struct State
+	{
+		std::function<void(uint64)> func;
+		uint64 count = 0;
+		std::atomic<uint64> nextIndex = 0;
+		std::atomic<uint64> doneCount = 0;
+		std::atomic<bool> hasFailed = false;
+		std::exception_ptr pException; // The first one that was thrown, guarded by the mutex.
+		std::mutex mutex;
+		std::condition_variable condition;
+	};
+	std::shared_ptr<State> pState = std::make_shared<State>();
+	pState->func = func;
+	pState->count = count;
+
+	auto work = [](State& state)
+	{
+		uint64 index = 0;
+		while ((index = state.nextIndex.fetch_add(1)) < state.count)
+		{
+			// An index always counts as done, or the caller would wait forever. After a throw the rest are skipped.
+			if (!state.hasFailed.load(std::memory_order_relaxed))
+			{
+				try
+				{
+					state.func(index);
+				}
+				catch (...)
+				{
+					std::lock_guard<std::mutex> lock(state.mutex);
+					if (!state.pException)
+						state.pException = std::current_exception();
+					state.hasFailed.store(true, std::memory_order_relaxed);
+				}
+			}
+
+			if (state.doneCount.fetch_add(1) + 1 == state.count)
+			{
+				std::lock_guard<std::mutex> lock(state.mutex);
+				state.condition.notify_all();
+			}
+		}
+	};
+
+	for (uint i = 0; i < threadCount - 1; ++i)
+		Enqueue([pState, work]() { work(*pState); });
+
+	work(*pState);
+
+	// Every index that was taken is being worked on, so this cannot wait on a job that sits in the queue.
+	std::unique_lock<std::mutex> lock(pState->mutex);
+	pState->condition.wait(lock, [&]() { return pState->doneCount.load() == pState->count; });
+
+	if (pState->pException)
+		std::rethrow_exception(pState->pException);
+}
+
+void RS::ThreadPool::Enqueue(Job&& job)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Jobs.push_back(std::move(job));
+	}
+	m_Condition.notify_one();
+}
+
+void RS::ThreadPool::ThreadFunction(uint threadIndex, const std::string& threadName)
+{
+	CorePlatform::SetCurrentThreadName(threadName);
+	s_ThreadIndex = threadIndex;
+
+	while (true)
+	{
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Condition.wait(lock, [&]() { return !m_Running || !m_Jobs.empty(); });
+			if (!m_Running)
+				return;
+
+			job = std::move(m_Jobs.front());
+			m_Jobs.pop_front();
+		}
+		job();
+	}
+}
@@ -2,14 +2,83 @@
 
 #include <thread>
 #include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <deque>
+#include <vector>
 
 namespace RS
 {
 	class ThreadPool
 	{
 	public:
+		using Job = std::function<void()>;
+
+		inline static constexpr uint InvalidThreadIndex = ~0u;
+
+	public:
+		ThreadPool();
+		~ThreadPool();
+		RS_NO_COPY_AND_MOVE(ThreadPool)
+
+		/*
+		* Engine wide pool. It is initialized on first use with one worker per core.
+		*/
+		static std::shared_ptr<ThreadPool> Get();
+
+		void Init(uint threadCount, const std::string& threadName);
+		void Release();
+
+		/*
+		* Queue a job and get a future for its result.
+		*/
+		template<typename Func>
+		auto Submit(Func&& func) -> std::future<std::invoke_result_t<Func>>;
+
+		/*
+		* Calls func(index) for every index in [0, count) and blocks until all of them are done.
+		* The calling thread takes part in the work, which makes it safe to call from a job.
+		* maxThreads limits how many threads (including the calling thread) that are used, 0 means all of them.
+		* If func throws, the indices that did not start yet are skipped and the first exception is rethrown here.
+		*/
+		void ParallelFor(uint64 count, const std::function<void(uint64)>& func, uint maxThreads = 0);
+
+		uint GetThreadCount() const { return (uint)m_Threads.size(); }
+
+		/*
+		* Index of the worker thread calling this function, InvalidThreadIndex if it is not a worker of any pool.
+		*/
+		static uint GetCurrentThreadIndex() { return s_ThreadIndex; }
+
+	private:
+		void Enqueue(Job&& job);
+		void ThreadFunction(uint threadIndex, const std::string& threadName);
 
 	private:
+		std::vector<std::thread>	m_Threads;
+		std::mutex					m_Mutex;
+		std::condition_variable		m_Condition;
+		std::deque<Job>				m_Jobs;
+		bool						m_Running;
 
+		inline static thread_local uint s_ThreadIndex = InvalidThreadIndex;
 	};
-}
\ No newline at end of file
+
+	template<typename Func>
+	inline auto ThreadPool::Submit(Func&& func) -> std::future<std::invoke_result_t<Func>>
+	{
+		using ReturnType = std::invoke_result_t<Func>;
+
+		// std::function needs a copyable target, packaged_task is move only.
+		auto pTask = std::make_shared<std::packaged_task<ReturnType()>>(std::forward<Func>(func));
+		std::future<ReturnType> future = pTask->get_future();
+
+		if (m_Threads.empty())
+			(*pTask)();
+		else
+			Enqueue([pTask]() { (*pTask)(); });
+
+		return future;
+	}
+}
@@ -0,0 +1,139 @@
+#include "PreCompiled.h"
+#include "VFS.h"
+
+#include "Core/MappedFile.h"
+#include "Core/PakFile.h"
+
+#include <filesystem>
+
+RS::LooseFileProvider::LooseFileProvider(const std::string& rootDirectory)
+	: m_RootDirectory(rootDirectory)
+{
+	if (!m_RootDirectory.empty() && m_RootDirectory.back() != '/')
+		m_RootDirectory += '/';
+}
+
+std::shared_ptr<RS::VFSFile> RS::LooseFileProvider::Open(const std::string& path)
+{
+	const std::string diskPath = m_RootDirectory + path;
+	std::shared_ptr<MappedFile> pMappedFile = std::make_shared<MappedFile>();
+	if (!pMappedFile->Open(diskPath))
+		return nullptr;
+
+	std::span<const uint8> data(pMappedFile->GetData(), pMappedFile->GetSize());
+	return std::make_shared<VFSFile>(diskPath, data, pMappedFile);
+}
+
+bool RS::LooseFileProvider::Exists(const std::string& path) const
+{
+	std::error_code error;
+	return std::filesystem::is_regular_file(m_RootDirectory + path, error);
+}
+
+RS::VFS::VFS()
+{
+	m_pDiskProvider = std::make_shared<LooseFileProvider>("");
+}
+
+std::shared_ptr<RS::VFS> RS::VFS::Get()
+{
+	static std::shared_ptr<VFS> s_VFS = std::make_shared<VFS>();
+	return s_VFS;
+}
+
+void RS::VFS::Mount(const std::string& mountPoint, std::shared_ptr<IFileProvider> pProvider)
+{
+	std::string path = NormalizePath(mountPoint);
+	if (!path.empty() && path.back() != '/')
+		path += '/';
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_MountPoints.push_back(MountPoint{ .path = path, .pProvider = pProvider });
+	LOG_INFO("Mounted '{}' at '{}'", pProvider->GetName(), path);
+}
+
+bool RS::VFS::MountDirectory(const std::string& mountPoint, const std::string& directoryPath)
+{
+	std::error_code error;
+	if (!std::filesystem::is_directory(directoryPath, error))
+	{
+		LOG_WARNING("Cannot mount directory {}, it does not exist!", directoryPath.c_str());
+		return false;
+	}
+
+	Mount(mountPoint, std::make_shared<LooseFileProvider>(NormalizePath(directoryPath)));
+	return true;
+}
+
+bool RS::VFS::MountPak(const std::string& mountPoint, const std::string& pakPath)
+{
+	std::shared_ptr<PakFileProvider> pPak = std::make_shared<PakFileProvider>();
+	if (!pPak->Load(pakPath))
+		return false;
+
+	Mount(mountPoint, pPak);
+	return true;
+}
+
+void RS::VFS::Unmount(const std::string& mountPoint)
+{
+	std::string path = NormalizePath(mountPoint);
+	if (!path.empty() && path.back() != '/')
+		path += '/';
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	std::erase_if(m_MountPoints, [&](const MountPoint& mount) { return mount.path == path; });
+}
+
+void RS::VFS::UnmountAll()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_MountPoints.clear();
+}
+
+std::shared_ptr<RS::VFSFile> RS::VFS::Open(const std::string& path)
+{
+	const std::string normalizedPath = NormalizePath(path);
+
+	// The providers are called without the lock, opening a file can take a while.
+	for (auto& [pProvider, relativePath] : FindProviders(normalizedPath))
+	{
+		if (std::shared_ptr<VFSFile> pFile = pProvider->Open(relativePath))
+			return pFile;
+	}
+
+	if (m_UseDiskFallback)
+		return m_pDiskProvider->Open(normalizedPath);
+	return nullptr;
+}
+
+bool RS::VFS::Exists(const std::string& path)
+{
+	const std::string normalizedPath = NormalizePath(path);
+	for (auto& [pProvider, relativePath] : FindProviders(normalizedPath))
+	{
+		if (pProvider->Exists(relativePath))
+			return true;
+	}
+	return m_UseDiskFallback && m_pDiskProvider->Exists(normalizedPath);
+}
+
+std::string RS::VFS::NormalizePath(const std::string& path)
+{
+	if (path.empty())
+		return path;
+	return std::filesystem::path(path).lexically_normal().generic_string();
+}
+
+std::vector<std::pair<std::shared_ptr<RS::IFileProvider>, std::string>> RS::VFS::FindProviders(const std::string& normalizedPath)
+{
+	std::vector<std::pair<std::shared_ptr<IFileProvider>, std::string>> providers;
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	for (auto it = m_MountPoints.rbegin(); it != m_MountPoints.rend(); ++it)
+	{
+		if (normalizedPath.starts_with(it->path))
+			providers.emplace_back(it->pProvider, normalizedPath.substr(it->path.size()));
+	}
+	return providers;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <span>
+#include <mutex>
+#include <atomic>
+
+namespace RS
+{
+	/*
+	* A file opened through the VFS. The data is a view into a memory mapping or into a buffer owned by the file, it is valid as long as the file is alive.
+	*/
+	class VFSFile
+	{
+	public:
+		VFSFile(const std::string& path, std::span<const uint8> data, std::shared_ptr<const void> pOwner)
+			: m_Path(path), m_Data(data), m_pOwner(pOwner) {}
+		RS_NO_COPY_AND_MOVE(VFSFile)
+
+		const std::string& GetPath() const { return m_Path; }
+		std::span<const uint8> GetData() const { return m_Data; }
+		const uint8* GetPtr() const { return m_Data.data(); }
+		uint64 GetSize() const { return m_Data.size(); }
+
+	private:
+		std::string m_Path;
+		std::span<const uint8> m_Data;
+		std::shared_ptr<const void> m_pOwner; // Mapping or buffer that m_Data points into.
+	};
+
+	class IFileProvider
+	{
+	public:
+		virtual ~IFileProvider() = default;
+
+		// Returns nullptr if the file does not exist. The path is relative to the mount point.
+		virtual std::shared_ptr<VFSFile> Open(const std::string& path) = 0;
+		virtual bool Exists(const std::string& path) const = 0;
+		virtual std::string GetName() const = 0;
+	};
+
+	/*
+	* Files in a directory on disk, each file is memory mapped when opened.
+	*/
+	class LooseFileProvider : public IFileProvider
+	{
+	public:
+		LooseFileProvider(const std::string& rootDirectory);
+
+		std::shared_ptr<VFSFile> Open(const std::string& path) override;
+		bool Exists(const std::string& path) const override;
+		std::string GetName() const override { return "Loose: " + m_RootDirectory; }
+
+	private:
+		std::string m_RootDirectory;
+	};
+
+	/*
+	* Virtual file system, all asset loading should go through this.
+	* Providers are mounted at a path prefix and a path is looked up in the latest mounted provider first. Paths that no mount has are read
+	* from disk as they are, which means existing paths like Engine::GetDataFilePath() + "Textures/x.png" work without any mounts, and
+	* mounting a pak at Engine::GetDataFilePath() will make the same paths read from the pak.
+	*/
+	class VFS
+	{
+	public:
+		VFS();
+		RS_NO_COPY_AND_MOVE(VFS)
+
+		static std::shared_ptr<VFS> Get();
+
+		void Mount(const std::string& mountPoint, std::shared_ptr<IFileProvider> pProvider);
+		bool MountDirectory(const std::string& mountPoint, const std::string& directoryPath);
+		bool MountPak(const std::string& mountPoint, const std::string& pakPath);
+		void Unmount(const std::string& mountPoint);
+		void UnmountAll();
+
+		std::shared_ptr<VFSFile> Open(const std::string& path);
+		bool Exists(const std::string& path);
+
+		/*
+		* Only used when no mount has the file.
+		*/
+		void SetDiskFallback(bool enabled) { m_UseDiskFallback = enabled; }
+
+		// Forward slashes, no "./" or "a/../". Mount points also end with a '/'.
+		static std::string NormalizePath(const std::string& path);
+
+	private:
+		struct MountPoint
+		{
+			std::string path;
+			std::shared_ptr<IFileProvider> pProvider;
+		};
+
+		// Matching providers, latest mount first, with the path relative to each mount point.
+		std::vector<std::pair<std::shared_ptr<IFileProvider>, std::string>> FindProviders(const std::string& normalizedPath);
+
+	private:
+		std::mutex m_Mutex;
+		std::vector<MountPoint> m_MountPoints;
+		std::shared_ptr<LooseFileProvider> m_pDiskProvider;
+		std::atomic<bool> m_UseDiskFallback = true;
+	};
+}
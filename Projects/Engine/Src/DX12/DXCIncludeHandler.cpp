@@ -0,0 +1,37 @@
+#include "PreCompiled.h"
+#include "DXCIncludeHandler.h"
+
+#include "Core/VFS.h"
+
+HRESULT STDMETHODCALLTYPE RS::DXCIncludeHandler::LoadSource(_In_z_ LPCWSTR pFilename, _COM_Outptr_result_maybenull_ IDxcBlob** ppIncludeSource)
+{
+	*ppIncludeSource = nullptr;
+
+	// DXC tries each include directory in turn, a file that is not there is not an error until all have been tried.
+	const std::string path = std::filesystem::path(pFilename).lexically_normal().string();
+	std::shared_ptr<VFSFile> pFile = VFS::Get()->Open(path);
+	if (!pFile)
+		return HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND);
+
+	// The blob gets its own copy, the file can be unmapped when this returns.
+	IDxcBlobEncoding* pBlob = nullptr;
+	HRESULT hr = m_pUtils->CreateBlob(pFile->GetPtr(), (UINT32)pFile->GetSize(), DXC_CP_UTF8, &pBlob);
+	if (FAILED(hr))
+		return hr;
+
+	m_IncludedFiles.insert(path);
+	*ppIncludeSource = pBlob;
+	return S_OK;
+}
+
+HRESULT STDMETHODCALLTYPE RS::DXCIncludeHandler::QueryInterface(REFIID riid, _COM_Outptr_ void __RPC_FAR* __RPC_FAR* ppvObject)
+{
+	if (riid == __uuidof(IDxcIncludeHandler) || riid == __uuidof(IUnknown))
+	{
+		*ppvObject = static_cast<IDxcIncludeHandler*>(this);
+		AddRef();
+		return S_OK;
+	}
+	*ppvObject = nullptr;
+	return E_NOINTERFACE;
+}
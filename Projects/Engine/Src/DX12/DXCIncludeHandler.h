@@ -0,0 +1,29 @@
+#pragma once
+
+#include <dxcapi.h>
+#include <set>
+
+namespace RS
+{
+	/*
+	* Reads the files a shader includes through the VFS, so shaders compile from a pak as well as from disk, and records every file that was
+	* included. Lives on the stack for one compilation, the ref counting is only there to satisfy COM.
+	*/
+	class DXCIncludeHandler : public IDxcIncludeHandler
+	{
+	public:
+		DXCIncludeHandler(IDxcUtils* pUtils) : m_pUtils(pUtils) {}
+
+		HRESULT STDMETHODCALLTYPE LoadSource(_In_z_ LPCWSTR pFilename, _COM_Outptr_result_maybenull_ IDxcBlob** ppIncludeSource) override;
+		HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, _COM_Outptr_ void __RPC_FAR* __RPC_FAR* ppvObject) override;
+		ULONG STDMETHODCALLTYPE AddRef() override { return ++m_RefCount; }
+		ULONG STDMETHODCALLTYPE Release() override { return --m_RefCount; }
+
+		std::vector<std::string> GetIncludedFiles() const { return std::vector<std::string>(m_IncludedFiles.begin(), m_IncludedFiles.end()); }
+
+	private:
+		IDxcUtils* m_pUtils;
+		std::set<std::string> m_IncludedFiles;
+		ULONG m_RefCount = 1;
+	};
+}
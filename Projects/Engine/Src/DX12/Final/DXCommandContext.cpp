@@ -29,6 +29,9 @@
 //#pragma warning(pop)
 
 #include "DX12/Final/DXCore.h"
+#include "DX12/Final/DXGPUTimestampQueue.h"
+#include "DX12/Final/DXShaderDependencyGraph.h"
+#include "Core/ThreadPool.h"
 
 using namespace RS::DX12;
 
@@ -38,6 +41,153 @@ void DXContextManager::DestroyAllContexts(void)
         sm_ContextPool[i].clear();
 }
 
+void DXContextManager::WatchShaderFiles(const std::shared_ptr<ShaderRecompileState>& pState)
+{
+    std::shared_ptr<DXShaderDependencyGraph> pDependencyGraph = DXShaderDependencyGraph::Get();
+    const uint64 version = pDependencyGraph->GetVersion();
+    if (pState->m_WatchedDependencyVersion.exchange(version) == version)
+        return;
+
+    const uint64 psoID = pState->m_PSOID;
+    for (auto& [shaderPath, entry] : pState->m_Shaders)
+    {
+        // Changes to the shader itself always recompile the PSO.
+        if (!m_ShaderFileWatcher.HasExactListener(shaderPath, psoID))
+        {
+            m_ShaderFileWatcher.AddFileListener(shaderPath, psoID, [this](std::filesystem::path, uint64 userKey, FileWatcher::FileStatus)
+                {
+                    QueueRecompile(userKey);
+                });
+        }
+
+        for (const std::string& includePath : pDependencyGraph->GetDependencies(shaderPath))
+        {
+            if (!m_ShaderFileWatcher.HasExactListener(includePath, psoID))
+            {
+                m_ShaderFileWatcher.AddFileListener(includePath, psoID, [this](std::filesystem::path path, uint64 userKey, FileWatcher::FileStatus)
+                    {
+                        OnIncludeFileChanged(userKey, path);
+                    });
+            }
+        }
+    }
+}
+
+void DXContextManager::OnIncludeFileChanged(uint64 psoID, const std::filesystem::path& includePath)
+{
+    // The listener might be from an older include set, ask the graph which shaders that still depend on the file.
+    std::vector<std::string> dependents = DXShaderDependencyGraph::Get()->GetDependents(includePath.string());
+    if (dependents.empty())
+        return;
+
+    bool isAffected = false;
+    {
+        std::lock_guard<std::mutex> lock(m_ShaderRecompileMutex);
+        auto it = m_ShaderRecompileStates.find(psoID);
+        if (it == m_ShaderRecompileStates.end())
+            return;
+
+        for (auto& [shaderPath, entry] : it->second->m_Shaders)
+        {
+            std::string normalizedShaderPath = DXShaderDependencyGraph::NormalizePath(shaderPath);
+            if (std::find(dependents.begin(), dependents.end(), normalizedShaderPath) != dependents.end())
+            {
+                isAffected = true;
+                break;
+            }
+        }
+    }
+
+    if (isAffected)
+        QueueRecompile(psoID);
+}
+
+void DXContextManager::QueueRecompile(uint64 psoID)
+{
+    std::shared_ptr<ShaderRecompileState> pState;
+    {
+        std::lock_guard<std::mutex> lock(m_ShaderRecompileMutex);
+        auto it = m_ShaderRecompileStates.find(psoID);
+        if (it == m_ShaderRecompileStates.end())
+            return;
+
+        pState = it->second;
+        if (pState->m_IsRecompiling)
+        {
+            pState->m_IsDirty = true;
+            return;
+        }
+        pState->m_IsRecompiling = true;
+    }
+
+    ThreadPool::Get()->Submit([this, pState]() { RecompileShaders(pState); });
+}
+
+void DXContextManager::RecompileShaders(std::shared_ptr<ShaderRecompileState> pState)
+{
+    while (true)
+    {
+        std::unordered_map<std::string, ShaderRecompileState::ShaderEntry> shaderEntries;
+        {
+            std::lock_guard<std::mutex> lock(m_ShaderRecompileMutex);
+            pState->m_IsDirty = false;
+            shaderEntries = pState->m_Shaders;
+        }
+
+        // All shaders of the PSO are recompiled. The PSO description points at the blobs of the previous compile, which have been released.
+        std::vector<std::unique_ptr<DXShader>> shaders;
+        bool succeeded = true;
+        for (auto& [shaderPath, entry] : shaderEntries)
+        {
+            std::unique_ptr<DXShader> pShader = std::make_unique<DXShader>();
+            if (!pShader->Create(entry.description))
+            {
+                succeeded = false;
+                break;
+            }
+
+            if (!pShader->GetTypes().Has(entry.types))
+            {
+                LOG_ERROR("Recompiled shader is missing one or more of the types used by the PSO! Path: {}", shaderPath);
+                pShader->Release();
+                succeeded = false;
+                break;
+            }
+            shaders.push_back(std::move(pShader));
+        }
+
+        if (succeeded)
+        {
+            // The main thread keeps using the PSO, the new pipeline is built from a copy of its description.
+            std::unique_ptr<DXPSO> pPSO;
+            {
+                std::lock_guard<std::mutex> lock(m_ShaderRecompileMutex);
+                pPSO = pState->m_pPSO->Clone();
+            }
+
+            uint32 shaderIndex = 0;
+            for (auto& [shaderPath, entry] : shaderEntries)
+                pPSO->SetShaderTypes(entry.types, *shaders[shaderIndex++]);
+
+            // Finalize the copy but do not set the internal PSO of the original yet, the main thread swaps it in the next time it is used.
+            ID3D12PipelineState* pCompiledPSO = pPSO->Finalize(true);
+
+            std::lock_guard<std::mutex> lock(m_ShaderRecompileMutex);
+            pState->m_pCompiledPSO = pCompiledPSO;
+        }
+
+        for (std::unique_ptr<DXShader>& pShader : shaders)
+            pShader->Release();
+
+        std::lock_guard<std::mutex> lock(m_ShaderRecompileMutex);
+        if (!pState->m_IsDirty)
+        {
+            pState->m_IsRecompiling = false;
+            return;
+        }
+    }
+}
+
 DXCommandContext* DXContextManager::AllocateContext(D3D12_COMMAND_LIST_TYPE Type)
 {
     std::lock_guard<std::mutex> LockGuard(sm_ContextAllocationMutex);
@@ -135,6 +285,7 @@ uint64_t DXCommandContext::Flush(bool WaitForCompletion)
 uint64_t DXCommandContext::Finish(bool WaitForCompletion)
 {
     RS_ASSERT(m_Type == D3D12_COMMAND_LIST_TYPE_DIRECT || m_Type == D3D12_COMMAND_LIST_TYPE_COMPUTE);
+    RS_ASSERT(m_EventDepth == 0, "The context has {} events that were not ended!", m_EventDepth);
 
     FlushResourceBarriers();
 
@@ -214,63 +365,31 @@ void DXCommandContext::Reset(void)
 
 void RS::DX12::DXCommandContext::HotShaderReloading(DXPSO& pso)
 {
-    std::unique_lock<std::mutex> lock(m_ShaderRecompileMutex);
-    auto it = m_IDToPSOIndexMap.find(pso.GetID());
-    if (it == m_IDToPSOIndexMap.end())
-    {
-        m_IDToPSOIndexMap[pso.GetID()] = (uint32)m_PSOs.size();
-        m_PSOs.emplace_back(&pso, pso.GetShaderFlags());
-    }
-    ShaderRecompileState& state = m_PSOs[m_IDToPSOIndexMap[pso.GetID()]];
-    if (state.m_pPSO != &pso)
-        state.m_pPSO = &pso;
-
-    if (state.m_FinishedShaderTypes == pso.GetShaderFlags())
-    {
-        // Reset state and assign the detached PSO to the original again.
-        state.m_FinishedShaderTypes = 0u;
-        state.m_pPSO->SetPipelineStateObject(state.m_pCompiledPSO);
-        state.m_pCompiledPSO = nullptr;
-    }
-    lock.unlock();
+    DXContextManager* pManager = DXCore::GetContextManager();
 
-    for (auto& entry : pso.m_ShaderDescs)
+    std::shared_ptr<DXContextManager::ShaderRecompileState> pState;
     {
-        if (!DXCore::GetContextManager()->m_ShaderFileWatcher.HasExactListener(entry.first, pso.GetID()))
+        std::lock_guard<std::mutex> lock(pManager->m_ShaderRecompileMutex);
+        std::shared_ptr<DXContextManager::ShaderRecompileState>& pEntry = pManager->m_ShaderRecompileStates[pso.GetID()];
+        if (!pEntry)
         {
-            DXCore::GetContextManager()->m_ShaderFileWatcher.AddFileListener(entry.first, pso.GetID(), [entry, this](std::filesystem::path, uint64 userKey, FileWatcher::FileStatus status)
-                {
-                    DXShader* pShader = new DXShader();
-                    bool succeeded = pShader->Create(entry.second.description);
-                    if (!succeeded)
-                        return;
-
-                    RS_ASSERT(pShader->GetTypes() == entry.second.types);
-
-                    std::unique_lock<std::mutex> lock(m_ShaderRecompileMutex);
-                    ShaderRecompileState& state = m_PSOs[m_IDToPSOIndexMap[userKey]];
-                    state.m_pPSO->SetShader(*pShader);
-                    state.m_pShadersToRelease.push_back(std::shared_ptr<DXShader>(pShader));
-                    lock.unlock();
+            pEntry = std::make_shared<DXContextManager::ShaderRecompileState>();
+            pEntry->m_PSOID = pso.GetID();
+            for (auto& entry : pso.m_ShaderDescs)
+                pEntry->m_Shaders[entry.first] = { .description = entry.second.description, .types = entry.second.types };
+        }
+        pState = pEntry;
+        pState->m_pPSO = &pso;
 
-                    uint64 finishedShaderTypes = state.m_FinishedShaderTypes | entry.second.types;
-                    if (state.m_ShaderTypes == finishedShaderTypes)
-                    {
-                        // Finalize the PSO but do not set its internal PSO yet.
-                        // We do this such that we can finalize it in this thread without affecting the main thread.
-                        state.m_pCompiledPSO = state.m_pPSO->Finalize(true);
-                        for (std::shared_ptr<DXShader>& pShaderToRelease : state.m_pShadersToRelease)
-                            pShaderToRelease->Release();
-                        state.m_pShadersToRelease.clear();
-                    }
-
-                    // Updating finished state last such that next time the HotShaderReloading function is called we can assign the detached PSO to it.
-                    lock.lock();
-                    state.m_FinishedShaderTypes = finishedShaderTypes;
-                    lock.unlock();
-                });
+        if (pState->m_pCompiledPSO)
+        {
+            // The recompiled PSO is ready, swap it in. The old one is still owned by the PSO hash map.
+            pso.SetPipelineStateObject(pState->m_pCompiledPSO);
+            pState->m_pCompiledPSO = nullptr;
         }
     }
+
+    pManager->WatchShaderFiles(pState);
 }
 
 void DXCommandContext::BindDescriptorHeaps(void)
@@ -723,6 +842,32 @@ void DXCommandContext::InitializeTextureArraySlice(DXGPUResource& Dest, UINT Sli
     Context.Finish(true);
 }
 
+uint64_t DXCommandContext::InitializeTextureMips(DXGPUResource& Dest, UINT NumSubresources, D3D12_SUBRESOURCE_DATA SubData[], DXGPUResource* pSrc, UINT SrcFirstMip)
+{
+    DXCommandContext& Context = DXCommandContext::Begin();
+
+    if (NumSubresources > 0)
+    {
+        UINT64 uploadBufferSize = GetRequiredIntermediateSize(Dest.GetResource(), 0, NumSubresources);
+        DXDynAlloc mem = Context.ReserveUploadMemory(uploadBufferSize);
+        UpdateSubresources(Context.m_CommandList, Dest.GetResource(), mem.Buffer.GetResource(), 0, 0, NumSubresources, SubData);
+    }
+
+    if (pSrc != nullptr)
+    {
+        Context.TransitionResource(*pSrc, D3D12_RESOURCE_STATE_COPY_SOURCE);
+        Context.FlushResourceBarriers();
+
+        const D3D12_RESOURCE_DESC& DestDesc = Dest.GetResource()->GetDesc();
+        for (UINT i = NumSubresources; i < DestDesc.MipLevels; ++i)
+            Context.CopySubresource(Dest, i, *pSrc, SrcFirstMip + i - NumSubresources);
+    }
+
+    // Work on the same queue after this sees the new mips, the upload memory is recycled by the fence.
+    Context.TransitionResource(Dest, D3D12_RESOURCE_STATE_GENERIC_READ);
+    return Context.Finish();
+}
+
 uint32_t DXCommandContext::ReadbackTexture(DXReadbackBuffer& DstBuffer, DXPixelBuffer& SrcBuffer)
 {
     uint64_t CopySize = 0;
@@ -778,6 +923,37 @@ void DXCommandContext::InitializeBuffer(DXGPUBuffer& Dest, const DXUploadBuffer&
     InitContext.Finish(true);
 }
 
+void DXCommandContext::BeginEvent(const char* pLabel)
+{
+    RS_ASSERT(m_EventDepth < MaxEventDepth, "Events can only be nested {} deep!", MaxEventDepth);
+
+    m_CommandList->BeginEvent(1, pLabel, (UINT)strlen(pLabel) + 1);
+
+    uint32 query = GPUProfiler::InvalidQuery;
+    GPUProfiler* pGPUProfiler = DXCore::GetGPUProfiler();
+    if (pGPUProfiler && m_Type == D3D12_COMMAND_LIST_TYPE_DIRECT)
+    {
+        query = pGPUProfiler->BeginZone(pLabel);
+        if (query != GPUProfiler::InvalidQuery)
+            InsertTimeStamp(DXCore::GetGPUTimestampQueue()->GetQueryHeap(), query);
+    }
+    m_EventQueries[m_EventDepth++] = query;
+}
+
+void DXCommandContext::EndEvent()
+{
+    RS_ASSERT(m_EventDepth > 0, "There is no event to end!");
+
+    const uint32 query = m_EventQueries[--m_EventDepth];
+    if (query != GPUProfiler::InvalidQuery)
+    {
+        InsertTimeStamp(DXCore::GetGPUTimestampQueue()->GetQueryHeap(), query + 1);
+        DXCore::GetGPUProfiler()->EndZone(query);
+    }
+
+    m_CommandList->EndEvent();
+}
+
 void DXCommandContext::PIXBeginEvent(const wchar_t* label)
 {
 #ifdef RS_CONFIG_DEVELOPMENT
@@ -38,6 +38,7 @@
 #include <vector>
 #include <queue>
 #include <mutex>
+#include <atomic>
 
 //class Texture;
 class RS::DX12::DXGraphicsContext;
@@ -87,12 +88,43 @@ namespace RS::DX12
         void FreeContext(DXCommandContext*);
         void DestroyAllContexts();
 
+    private:
+        // --------- Debug Hot-shader reloading ---------
+        struct ShaderRecompileState
+        {
+            struct ShaderEntry
+            {
+                DXShader::Description description;
+                DXShader::TypeFlag types = DXShader::TypeFlag::NONE;
+            };
+
+            uint64 m_PSOID = 0;
+            DXPSO* m_pPSO = nullptr;
+            std::unordered_map<std::string, ShaderEntry> m_Shaders; // Key is the disk path of the shader.
+            ID3D12PipelineState* m_pCompiledPSO = nullptr; // Set when a recompile is done, swapped in by the next SetPipelineState.
+            std::atomic<uint64> m_WatchedDependencyVersion = UINT64_MAX;
+            bool m_IsRecompiling = false;
+            bool m_IsDirty = false; // A file changed while recompiling, do it again when done.
+        };
+
+        /*
+        * Registers listeners for the shader files of the PSO and every file they include.
+        * Only does work when the dependency graph has changed since the last call.
+        */
+        void WatchShaderFiles(const std::shared_ptr<ShaderRecompileState>& pState);
+        void OnIncludeFileChanged(uint64 psoID, const std::filesystem::path& includePath);
+        void QueueRecompile(uint64 psoID);
+        // Runs on the ThreadPool. The old PSO is kept until the new one has been finalized from a copy of its description.
+        void RecompileShaders(std::shared_ptr<ShaderRecompileState> pState);
+
     private:
         std::vector<std::unique_ptr<DXCommandContext> > sm_ContextPool[4];
         std::queue<DXCommandContext*> sm_AvailableContexts[4];
         std::mutex sm_ContextAllocationMutex;
 
         FileWatcher m_ShaderFileWatcher;
+        std::unordered_map<uint64, std::shared_ptr<ShaderRecompileState>> m_ShaderRecompileStates;
+        std::mutex m_ShaderRecompileMutex;
     };
 
     struct NonCopyable
@@ -162,6 +194,9 @@ namespace RS::DX12
         static void InitializeBuffer(DXGPUBuffer& Dest, const void* Data, size_t NumBytes, size_t DestOffset = 0);
         static void InitializeBuffer(DXGPUBuffer& Dest, const DXUploadBuffer& Src, size_t SrcOffset, size_t NumBytes = -1, size_t DestOffset = 0);
         static void InitializeTextureArraySlice(DXGPUResource& Dest, UINT SliceIndex, DXGPUResource& Src);
+        // Uploads SubData to the first NumSubresources mips of Dest and copies the rest of its mips from pSrc, starting at SrcFirstMip.
+        // Does not wait for the GPU, returns the fence value after which Dest is written and pSrc is no longer read.
+        static uint64_t InitializeTextureMips(DXGPUResource& Dest, UINT NumSubresources, D3D12_SUBRESOURCE_DATA SubData[], DXGPUResource* pSrc, UINT SrcFirstMip);
 
         void WriteBuffer(DXGPUResource& Dest, size_t DestOffset, const void* Data, size_t NumBytes);
         void FillBuffer(DXGPUResource& Dest, size_t DestOffset, DXDWParam Value, size_t NumBytes);
@@ -175,6 +210,10 @@ namespace RS::DX12
         void InsertTimeStamp(ID3D12QueryHeap* pQueryHeap, uint32_t QueryIdx);
         void ResolveTimeStamps(ID3D12Resource* pReadbackHeap, ID3D12QueryHeap* pQueryHeap, uint32_t NumQueries);
 
+        /*
+        * Marks a range of the commands for graphics debuggers. On the direct queue the range is also timed as a zone
+        * of the GPU profiler, so only the pointer of the label is kept. Use a string literal.
+        */
         void BeginEvent(const char* pLabel);
         void EndEvent();
 
@@ -214,22 +253,12 @@ namespace RS::DX12
         std::wstring m_ID;
         void SetID(const std::wstring& ID) { m_ID = ID; }
 
-        D3D12_COMMAND_LIST_TYPE m_Type;
+        // Begin queries of the GPU profiler zones of the open events, GPUProfiler::InvalidQuery if one is not timed.
+        static constexpr uint32 MaxEventDepth = 16;
+        uint32 m_EventQueries[MaxEventDepth] = {};
+        uint32 m_EventDepth = 0;
 
-        // --------- Debug Hot-shader reloading ---------
-        struct ShaderRecompileState
-        {
-            ID3D12PipelineState* m_pCompiledPSO = nullptr;
-            DXPSO* m_pPSO = nullptr;
-            DXShader::TypeFlag m_FinishedShaderTypes = DXShader::TypeFlag::NONE;
-            DXShader::TypeFlag m_ShaderTypes = DXShader::TypeFlag::NONE;
-            std::vector<std::shared_ptr<DXShader>> m_pShadersToRelease;
-            ShaderRecompileState() {}
-            ShaderRecompileState(DXPSO* pPSO, DXShader::TypeFlag shaderTypes) : m_pPSO(pPSO), m_ShaderTypes(shaderTypes), m_FinishedShaderTypes(0u) {}
-        };
-        std::vector<ShaderRecompileState> m_PSOs;
-        std::unordered_map<uint64, uint32> m_IDToPSOIndexMap;
-        std::mutex m_ShaderRecompileMutex;
+        D3D12_COMMAND_LIST_TYPE m_Type;
     };
 
     class DXGraphicsContext : public DXCommandContext
@@ -348,6 +377,20 @@ namespace RS::DX12
     private:
     };
 
+    // An event on the context for the rest of the scope, see DXCommandContext::BeginEvent.
+    class DXScopedEvent
+    {
+    public:
+        DXScopedEvent(DXCommandContext& context, const char* pLabel) : m_Context(context) { m_Context.BeginEvent(pLabel); }
+        ~DXScopedEvent() { m_Context.EndEvent(); }
+        RS_NO_COPY_AND_MOVE(DXScopedEvent)
+
+    private:
+        DXCommandContext& m_Context;
+    };
+
+#define RS_GPU_PROFILE_SCOPE(context, name) RS::DX12::DXScopedEvent CONCAT(_gpuProfileScope, __LINE__)(context, name)
+
     inline void DXCommandContext::FlushResourceBarriers(void)
     {
         if (m_NumBarriersToFlush > 0)
@@ -733,15 +776,5 @@ namespace RS::DX12
     {
         m_CommandList->ResolveQueryData(pQueryHeap, D3D12_QUERY_TYPE_TIMESTAMP, 0, NumQueries, pReadbackHeap, 0);
     }
-
-    inline void DXCommandContext::BeginEvent(const char* pLabel)
-    {
-        m_CommandList->BeginEvent(1, pLabel, sizeof(pLabel));
-    }
-
-    inline void DXCommandContext::EndEvent()
-    {
-        m_CommandList->EndEvent();
-    }
 }
 
@@ -4,6 +4,8 @@
 #include "DXCommandContext.h"
 #include "DXRootSignature.h"
 #include "DXDescriptorHeap.h"
+#include "DXPipelineCache.h"
+#include "DXGPUTimestampQueue.h"
 
 #include "DX12/Final/DXDisplay.h"
 #include "Graphics/RenderCore.h"
@@ -18,11 +20,23 @@ void RS::DX12::DXCore::Init()
 	m_sDevice.Init(d3dMinFeatureLevel, dxgiFlags);
 
 	m_sCommandListManager.Create(GetDevice());
+
+	m_spPipelineCache = new DXPipelineCache();
+	m_spPipelineCache->Init(Engine::GetTempFilePath() + "PipelineCache/");
+	m_spPipelineCache->Prewarm();
+
 	RenderCore::InitCommonStates();
 
 	if (!m_pDisplay)
 		m_pDisplay = new DXDisplay();
 
+	GPUProfilerSettings gpuProfilerSettings;
+	gpuProfilerSettings.framesInFlight = DXDisplay::BufferCount;
+	gpuProfilerSettings.trackName = "GPU Direct Queue";
+	auto pGPUTimestampQueue = std::make_shared<DXGPUTimestampQueue>(D3D12_COMMAND_LIST_TYPE_DIRECT, GPUProfiler::GetQueryCount(gpuProfilerSettings));
+	m_spGPUTimestampQueue = pGPUTimestampQueue.get();
+	m_spGPUProfiler = new GPUProfiler(pGPUTimestampQueue, gpuProfilerSettings);
+
 	std::shared_ptr<RS::Display> pDisplay = RS::Display::Get();
 	m_pDisplay->Init(pDisplay->GetHWND(), pDisplay->GetWidth(), pDisplay->GetHeight());
 	pDisplay->AddOnSizeChangeCallback("Display SizeChangeCallback", dynamic_cast<RS::IDisplaySizeChange*>(m_pDisplay));
@@ -44,11 +58,18 @@ void RS::DX12::DXCore::Destroy()
 
 	m_sCommandListManager.IdleGPU();
 
+	delete m_spGPUProfiler;
+	m_spGPUProfiler = nullptr;
+	m_spGPUTimestampQueue = nullptr;
+
 	DXCommandContext::DestroyAllContexts();
 	m_sCommandListManager.Shutdown();
 	DXRootSignature::DestroyAll();
 	DXDescriptorAllocator::DestroyAll();
 
+	delete m_spPipelineCache;
+	m_spPipelineCache = nullptr;
+
 	m_pDisplay->Remove();
 	delete m_pDisplay;
 	m_pDisplay = nullptr;
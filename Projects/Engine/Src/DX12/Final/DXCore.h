@@ -7,10 +7,17 @@
 #include <mutex>
 #include <vector>
 
+namespace RS
+{
+	class GPUProfiler;
+}
+
 namespace RS::DX12
 {
 	class DXDisplay;
+	class DXGPUTimestampQueue;
 	class DXContextManager;
+	class DXPipelineCache;
 	class DXCore
 	{
 	public:
@@ -35,11 +42,28 @@ namespace RS::DX12
 			return &m_sCommandListManager;
 		}
 
+		// Null if the core is not initialized.
+		static DXPipelineCache* GetPipelineCache()
+		{
+			return m_spPipelineCache;
+		}
+
 		inline static D3D12_CPU_DESCRIPTOR_HANDLE AllocateDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE type, UINT count = 1)
 		{
 			return m_sDescriptorAllocator[type].Allocate(count);
 		}
 
+		// Times the zones of the direct queue. Null if the core is not initialized.
+		static GPUProfiler* GetGPUProfiler()
+		{
+			return m_spGPUProfiler;
+		}
+
+		static DXGPUTimestampQueue* GetGPUTimestampQueue()
+		{
+			return m_spGPUTimestampQueue;
+		}
+
 		// Thread safe!
 		static void FreeResource(Microsoft::WRL::ComPtr<ID3D12Resource> pResource);
 
@@ -47,7 +71,10 @@ namespace RS::DX12
 		inline static DXDevice m_sDevice;
 		inline static DXCommandListManager m_sCommandListManager;
 		inline static DXContextManager* m_spContextManager = nullptr;
+		inline static DXPipelineCache* m_spPipelineCache = nullptr;
 		inline static DXDisplay* m_pDisplay = nullptr;
+		inline static GPUProfiler* m_spGPUProfiler = nullptr;
+		inline static DXGPUTimestampQueue* m_spGPUTimestampQueue = nullptr; // Owned by the GPU profiler.
 
 		inline static DXDescriptorAllocator m_sDescriptorAllocator[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES] =
 		{
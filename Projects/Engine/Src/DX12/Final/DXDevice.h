@@ -22,6 +22,7 @@ namespace RS::DX12
 
 		DX12_DEVICE_PTR GetD3D12Device() const { return m_pDevice; }
 		DX12_FACTORY_PTR GetDXGIFactory() const { return m_pFactory; }
+		IDXGIAdapter1* GetAdapter() const { return m_pAdapter; }
 
 		DXGIFlags GetDXGIFlags() const { return m_DxgiFlags; }
 
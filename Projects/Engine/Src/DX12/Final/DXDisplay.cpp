@@ -1,6 +1,8 @@
 #include "PreCompiled.h"
 #include "DXDisplay.h"
 
+#include "Render/GPUProfiler.h"
+
 #include "DXCore.h"
 #include "Graphics/RenderCore.h"
 
@@ -157,6 +159,9 @@ uint RS::DX12::DXDisplay::Present(DXColorBuffer* pBase, DXGraphicsContext* pCont
     //else
         PresentSDR(pBase, pContext);
 
+    // The work of the frame has been submitted, its timestamps are resolved after it.
+    DXCore::GetGPUProfiler()->EndFrame();
+
     uint32 presentInterval = m_EnableVSync ? std::min(4u, (uint32)std::roundf(m_FrameTime * 60.0f)) : 0u;
     m_pSwapChain1->Present(presentInterval, 0);
 
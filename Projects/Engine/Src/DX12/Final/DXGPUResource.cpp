@@ -14,6 +14,15 @@ void RS::DX12::DXGPUResource::Destroy()
     }
 }
 
+Microsoft::WRL::ComPtr<ID3D12Resource> RS::DX12::DXGPUResource::Detach()
+{
+    Microsoft::WRL::ComPtr<ID3D12Resource> pResource = std::move(m_pResource);
+    m_GpuVirtualAddress = D3D12_GPU_VIRTUAL_ADDRESS_NULL;
+    ++m_VersionID;
+    m_Alive = false;
+    return pResource;
+}
+
 bool RS::DX12::DXGPUResource::Map(uint32 subresource, const D3D12_RANGE* pReadRange, void** ppData, DataAccess access)
 {
     // Debug
@@ -52,6 +52,9 @@ namespace RS::DX12
 
         virtual void Destroy();
 
+        // Takes the resource without freeing it through DXCore, the caller keeps it alive until the GPU is done with it.
+        Microsoft::WRL::ComPtr<ID3D12Resource> Detach();
+
         ID3D12Resource* operator->() { return m_pResource.Get(); }
         const ID3D12Resource* operator->() const { return m_pResource.Get(); }
 
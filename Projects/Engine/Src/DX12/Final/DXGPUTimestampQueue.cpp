@@ -0,0 +1,71 @@
+#include "PreCompiled.h"
+#include "DXGPUTimestampQueue.h"
+
+#include "DX12/Final/DXCore.h"
+#include "DX12/Final/DXCommandContext.h"
+
+#include <chrono>
+
+RS::DX12::DXGPUTimestampQueue::DXGPUTimestampQueue(D3D12_COMMAND_LIST_TYPE type, uint32 queryCount)
+	: m_Type(type)
+{
+	RS_ASSERT(type == D3D12_COMMAND_LIST_TYPE_DIRECT || type == D3D12_COMMAND_LIST_TYPE_COMPUTE, "Timestamps are only resolved on direct and compute queues!");
+
+	D3D12_QUERY_HEAP_DESC desc = {};
+	desc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+	desc.Count = queryCount;
+	desc.NodeMask = 0;
+	DXCall(DXCore::GetDevice()->CreateQueryHeap(&desc, IID_PPV_ARGS(&m_pQueryHeap)));
+#ifdef RS_CONFIG_DEVELOPMENT
+	m_pQueryHeap->SetName(L"GPU Profiler Timestamps");
+#endif
+
+	m_ReadbackBuffer.Create(L"GPU Profiler Timestamp Readback", queryCount, sizeof(uint64));
+
+	DXCall(DXCore::GetCommandListManager()->GetQueue(m_Type).GetCommandQueue()->GetTimestampFrequency(&m_TimestampFrequency));
+
+	LARGE_INTEGER qpcFrequency;
+	QueryPerformanceFrequency(&qpcFrequency);
+	m_QPCFrequency = (uint64)qpcFrequency.QuadPart;
+}
+
+uint64 RS::DX12::DXGPUTimestampQueue::GetTimestampFrequency() const
+{
+	return m_TimestampFrequency;
+}
+
+void RS::DX12::DXGPUTimestampQueue::GetClockCalibration(uint64& gpuTimestamp, uint64& cpuTick) const
+{
+	uint64 qpcTick = 0;
+	DXCall(DXCore::GetCommandListManager()->GetQueue(m_Type).GetCommandQueue()->GetClockCalibration(&gpuTimestamp, &qpcTick));
+
+	// The steady clock counts the performance counter in its own period, split up the same way so it does not overflow.
+	using Period = std::chrono::steady_clock::period;
+	const uint64 seconds = qpcTick / m_QPCFrequency;
+	const uint64 remainder = qpcTick % m_QPCFrequency;
+	cpuTick = seconds * Period::den / Period::num + remainder * Period::den / Period::num / m_QPCFrequency;
+}
+
+uint64 RS::DX12::DXGPUTimestampQueue::Resolve(uint32 firstQuery, uint32 count)
+{
+	DXCommandContext& context = m_Type == D3D12_COMMAND_LIST_TYPE_COMPUTE ? DXComputeContext::Begin(L"", true) : DXCommandContext::Begin();
+	context.GetCommandList()->ResolveQueryData(m_pQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, firstQuery, count,
+		m_ReadbackBuffer.GetResource(), (uint64)firstQuery * sizeof(uint64));
+	return context.Finish();
+}
+
+bool RS::DX12::DXGPUTimestampQueue::IsComplete(uint64 fenceValue) const
+{
+	return DXCore::GetCommandListManager()->IsFenceComplete(fenceValue);
+}
+
+const uint64* RS::DX12::DXGPUTimestampQueue::MapTimestamps(uint32 firstQuery, uint32 count)
+{
+	RS_ASSERT(firstQuery + count <= m_ReadbackBuffer.GetElementCount(), "Queries [{}, {}) are not in the heap!", firstQuery, firstQuery + count);
+	return (const uint64*)m_ReadbackBuffer.Map() + firstQuery;
+}
+
+void RS::DX12::DXGPUTimestampQueue::UnmapTimestamps()
+{
+	m_ReadbackBuffer.Unmap();
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "DX12/Final/DXReadbackBuffer.h"
+#include "Render/GPUProfiler.h"
+
+namespace RS::DX12
+{
+	/*
+	* Timestamp queries on one of the command queues of the DXCommandListManager. The queries are resolved with a
+	* context of the same type, so the copy runs after everything that was submitted to the queue before.
+	*/
+	class DXGPUTimestampQueue : public IGPUTimestampQueue
+	{
+	public:
+		DXGPUTimestampQueue(D3D12_COMMAND_LIST_TYPE type, uint32 queryCount);
+
+		uint64 GetTimestampFrequency() const override;
+		void GetClockCalibration(uint64& gpuTimestamp, uint64& cpuTick) const override;
+
+		uint64 Resolve(uint32 firstQuery, uint32 count) override;
+		bool IsComplete(uint64 fenceValue) const override;
+
+		const uint64* MapTimestamps(uint32 firstQuery, uint32 count) override;
+		void UnmapTimestamps() override;
+
+		ID3D12QueryHeap* GetQueryHeap() const { return m_pQueryHeap.Get(); }
+
+	private:
+		D3D12_COMMAND_LIST_TYPE					m_Type;
+		Microsoft::WRL::ComPtr<ID3D12QueryHeap>	m_pQueryHeap;
+		DXReadbackBuffer						m_ReadbackBuffer;
+		uint64									m_TimestampFrequency = 1;
+		uint64									m_QPCFrequency = 1;
+	};
+}
@@ -0,0 +1,312 @@
+#include "PreCompiled.h"
+#include "DXPipelineCache.h"
+
+#include "DX12/Final/DXCore.h"
+#include "Core/ThreadPool.h"
+
+#include <fstream>
+#include <filesystem>
+
+RS::DX12::DXPipelineCache::~DXPipelineCache()
+{
+	Release();
+}
+
+void RS::DX12::DXPipelineCache::Init(const std::string& directoryPath)
+{
+	if (LaunchArguments::Contains(LaunchParams::noPipelineCache))
+	{
+		LOG_INFO("Pipeline cache is disabled.");
+		return;
+	}
+
+	m_DirectoryPath = directoryPath;
+	m_DeviceIdentity = GetDeviceIdentity();
+
+	std::vector<uint8> indexData = ReadFile(GetIndexFilePath());
+	std::vector<uint8> libraryData;
+	if (!indexData.empty())
+	{
+		if (m_Index.Deserialize(indexData.data(), indexData.size(), m_DeviceIdentity))
+			libraryData = ReadFile(GetLibraryFilePath());
+		else
+			LOG_INFO("Pipeline cache is from another device, driver or version. Starting with an empty cache.");
+	}
+
+	CreateLibrary(libraryData);
+	if (m_pLibrary)
+		LOG_INFO("Pipeline cache loaded with {} pipelines. Path: {}", m_Index.GetCount(), m_DirectoryPath);
+}
+
+void RS::DX12::DXPipelineCache::Release()
+{
+	WaitForPrewarm();
+	Save();
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_PrewarmedPipelines.clear();
+	m_pLibrary.Reset();
+	m_LibraryData.clear();
+	m_Index.Clear();
+}
+
+void RS::DX12::DXPipelineCache::Save()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	if (!m_pLibrary || !m_IsDirty)
+		return;
+
+	std::vector<uint8> libraryData(m_pLibrary->GetSerializedSize());
+	HRESULT hr = m_pLibrary->Serialize(libraryData.data(), libraryData.size());
+	if (FAILED(hr))
+	{
+		LOG_WARNING("Failed to serialize the pipeline library!");
+		return;
+	}
+
+	std::filesystem::create_directories(m_DirectoryPath);
+	std::vector<uint8> indexData = m_Index.Serialize(m_DeviceIdentity);
+	if (!WriteFile(GetLibraryFilePath(), libraryData.data(), libraryData.size()) || !WriteFile(GetIndexFilePath(), indexData.data(), indexData.size()))
+	{
+		// Remove the index, a library without a matching index will not be used.
+		std::error_code error;
+		std::filesystem::remove(GetIndexFilePath(), error);
+		LOG_WARNING("Failed to write the pipeline cache! Path: {}", m_DirectoryPath);
+		return;
+	}
+
+	m_IsDirty = false;
+}
+
+void RS::DX12::DXPipelineCache::Prewarm()
+{
+	if (!m_pLibrary || m_PrewarmFuture.valid())
+		return;
+
+	m_PrewarmFuture = ThreadPool::Get()->Submit([this]()
+		{
+			// The index is not changed by the prewarm, the entries can be read without holding the lock.
+			std::vector<DXPipelineCacheIndex::Entry> entries;
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				entries = m_Index.GetEntries();
+			}
+
+			ThreadPool::Get()->ParallelFor(entries.size(), [&](uint64 index) { PrewarmEntry(entries[index]); });
+			LOG_INFO("Pipeline cache prewarmed {} pipelines.", entries.size());
+		});
+}
+
+void RS::DX12::DXPipelineCache::WaitForPrewarm()
+{
+	if (m_PrewarmFuture.valid())
+		m_PrewarmFuture.get();
+}
+
+ID3D12PipelineState* RS::DX12::DXPipelineCache::CreateGraphicsPipeline(const DXPipelineKey& key, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, ID3DBlob* pRootSignatureBlob, const wchar_t* name)
+{
+	ID3D12PipelineState* pPSO = nullptr;
+
+	std::vector<uint8> description;
+	if (!m_pLibrary || !pRootSignatureBlob
+		|| !DXPipelineDescSerializer::SerializeGraphics(desc, pRootSignatureBlob->GetBufferPointer(), pRootSignatureBlob->GetBufferSize(), description))
+	{
+		DXCall(DXCore::GetDevice()->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(&pPSO)));
+		return pPSO;
+	}
+
+	pPSO = FindPrewarmed(key);
+	if (pPSO)
+		return pPSO;
+
+	const std::wstring libraryName = DXPipelineCacheIndex::GetLibraryName(key.GetHash());
+	{
+		std::lock_guard<std::mutex> lock(GetLoadMutex(key.GetHash()));
+		if (SUCCEEDED(m_pLibrary->LoadGraphicsPipeline(libraryName.c_str(), &desc, IID_PPV_ARGS(&pPSO))))
+			return pPSO;
+	}
+
+	// Compile outside the lock, other pipelines can be created meanwhile.
+	DXCall(DXCore::GetDevice()->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(&pPSO)));
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	if (SUCCEEDED(m_pLibrary->StorePipeline(libraryName.c_str(), pPSO)))
+	{
+		m_Index.Add(key.GetHash(), DXPipelineCacheIndex::PipelineType::Graphics, Utils::ToString(name), description);
+		m_IsDirty = true;
+	}
+	return pPSO;
+}
+
+ID3D12PipelineState* RS::DX12::DXPipelineCache::CreateComputePipeline(const DXPipelineKey& key, const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc, ID3DBlob* pRootSignatureBlob, const wchar_t* name)
+{
+	ID3D12PipelineState* pPSO = nullptr;
+
+	std::vector<uint8> description;
+	if (!m_pLibrary || !pRootSignatureBlob
+		|| !DXPipelineDescSerializer::SerializeCompute(desc, pRootSignatureBlob->GetBufferPointer(), pRootSignatureBlob->GetBufferSize(), description))
+	{
+		DXCall(DXCore::GetDevice()->CreateComputePipelineState(&desc, IID_PPV_ARGS(&pPSO)));
+		return pPSO;
+	}
+
+	pPSO = FindPrewarmed(key);
+	if (pPSO)
+		return pPSO;
+
+	const std::wstring libraryName = DXPipelineCacheIndex::GetLibraryName(key.GetHash());
+	{
+		std::lock_guard<std::mutex> lock(GetLoadMutex(key.GetHash()));
+		if (SUCCEEDED(m_pLibrary->LoadComputePipeline(libraryName.c_str(), &desc, IID_PPV_ARGS(&pPSO))))
+			return pPSO;
+	}
+
+	// Compile outside the lock, other pipelines can be created meanwhile.
+	DXCall(DXCore::GetDevice()->CreateComputePipelineState(&desc, IID_PPV_ARGS(&pPSO)));
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	if (SUCCEEDED(m_pLibrary->StorePipeline(libraryName.c_str(), pPSO)))
+	{
+		m_Index.Add(key.GetHash(), DXPipelineCacheIndex::PipelineType::Compute, Utils::ToString(name), description);
+		m_IsDirty = true;
+	}
+	return pPSO;
+}
+
+RS::DX12::DXPipelineCacheIndex::DeviceIdentity RS::DX12::DXPipelineCache::GetDeviceIdentity()
+{
+	DXPipelineCacheIndex::DeviceIdentity identity;
+
+	IDXGIAdapter1* pAdapter = DXCore::GetDXDevice()->GetAdapter();
+	if (!pAdapter)
+		return identity;
+
+	DXGI_ADAPTER_DESC1 desc;
+	if (SUCCEEDED(pAdapter->GetDesc1(&desc)))
+	{
+		identity.vendorID = desc.VendorId;
+		identity.deviceID = desc.DeviceId;
+		identity.subSysID = desc.SubSysId;
+		identity.revision = desc.Revision;
+	}
+
+	LARGE_INTEGER driverVersion;
+	if (SUCCEEDED(pAdapter->CheckInterfaceSupport(__uuidof(IDXGIDevice), &driverVersion)))
+		identity.driverVersion = (uint64)driverVersion.QuadPart;
+
+	return identity;
+}
+
+std::vector<uint8> RS::DX12::DXPipelineCache::ReadFile(const std::string& path)
+{
+	std::ifstream stream(path, std::ios::binary | std::ios::ate);
+	if (!stream.is_open())
+		return {};
+
+	std::vector<uint8> data((uint64)stream.tellg());
+	stream.seekg(0, std::ios::beg);
+	if (!stream.read((char*)data.data(), data.size()))
+		return {};
+	return data;
+}
+
+bool RS::DX12::DXPipelineCache::WriteFile(const std::string& path, const void* pData, uint64 size)
+{
+	std::ofstream stream(path, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!stream.is_open())
+		return false;
+	stream.write((const char*)pData, size);
+	return stream.good();
+}
+
+void RS::DX12::DXPipelineCache::CreateLibrary(const std::vector<uint8>& libraryData)
+{
+	m_LibraryData = libraryData;
+	if (!m_LibraryData.empty())
+	{
+		// Fails with D3D12_ERROR_DRIVER_VERSION_MISMATCH or D3D12_ERROR_ADAPTER_NOT_FOUND if the blob is stale.
+		HRESULT hr = DXCore::GetDevice()->CreatePipelineLibrary(m_LibraryData.data(), m_LibraryData.size(), IID_PPV_ARGS(m_pLibrary.ReleaseAndGetAddressOf()));
+		if (SUCCEEDED(hr))
+			return;
+
+		LOG_INFO("Pipeline library on disk was rejected by the driver. Starting with an empty cache.");
+		m_LibraryData.clear();
+		m_Index.Clear();
+	}
+
+	HRESULT hr = DXCore::GetDevice()->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(m_pLibrary.ReleaseAndGetAddressOf()));
+	if (FAILED(hr))
+	{
+		LOG_WARNING("Pipeline libraries are not supported, the pipeline cache is disabled.");
+		m_pLibrary.Reset();
+		m_Index.Clear();
+		return;
+	}
+
+	// Everything has to be written again since the library is empty.
+	m_IsDirty = !m_Index.GetEntries().empty();
+}
+
+ID3D12PipelineState* RS::DX12::DXPipelineCache::FindPrewarmed(const DXPipelineKey& key)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	auto it = m_PrewarmedPipelines.find(key.GetHash());
+	if (it == m_PrewarmedPipelines.end() || it->second.key != key)
+		return nullptr;
+
+	ID3D12PipelineState* pPSO = it->second.pPSO.Get();
+	pPSO->AddRef();
+	return pPSO;
+}
+
+void RS::DX12::DXPipelineCache::PrewarmEntry(const DXPipelineCacheIndex::Entry& entry)
+{
+	const std::wstring libraryName = DXPipelineCacheIndex::GetLibraryName(entry.key);
+	DXPipelineKey key;
+	ComPtr<ID3D12PipelineState> pPSO;
+	ComPtr<ID3D12RootSignature> pRootSignature;
+
+	if (entry.type == DXPipelineCacheIndex::PipelineType::Graphics)
+	{
+		DXPipelineDescSerializer::GraphicsDesc desc;
+		if (!DXPipelineDescSerializer::DeserializeGraphics(entry.description, desc))
+			return;
+
+		// An entry whose key does not match its own description cannot be trusted.
+		key = DXPipelineKey::FromGraphics(desc.desc, desc.rootSignature.data(), desc.rootSignature.size());
+		if (key.GetHash() != entry.key)
+			return;
+
+		if (FAILED(DXCore::GetDevice()->CreateRootSignature(1, desc.rootSignature.data(), desc.rootSignature.size(), IID_PPV_ARGS(&pRootSignature))))
+			return;
+		desc.desc.pRootSignature = pRootSignature.Get();
+
+		std::lock_guard<std::mutex> lock(GetLoadMutex(entry.key));
+		if (FAILED(m_pLibrary->LoadGraphicsPipeline(libraryName.c_str(), &desc.desc, IID_PPV_ARGS(&pPSO))))
+			return;
+	}
+	else
+	{
+		DXPipelineDescSerializer::ComputeDesc desc;
+		if (!DXPipelineDescSerializer::DeserializeCompute(entry.description, desc))
+			return;
+
+		// An entry whose key does not match its own description cannot be trusted.
+		key = DXPipelineKey::FromCompute(desc.desc, desc.rootSignature.data(), desc.rootSignature.size());
+		if (key.GetHash() != entry.key)
+			return;
+
+		if (FAILED(DXCore::GetDevice()->CreateRootSignature(1, desc.rootSignature.data(), desc.rootSignature.size(), IID_PPV_ARGS(&pRootSignature))))
+			return;
+		desc.desc.pRootSignature = pRootSignature.Get();
+
+		std::lock_guard<std::mutex> lock(GetLoadMutex(entry.key));
+		if (FAILED(m_pLibrary->LoadComputePipeline(libraryName.c_str(), &desc.desc, IID_PPV_ARGS(&pPSO))))
+			return;
+	}
+
+	pPSO->SetName(Utils::ToWString(entry.name).c_str());
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_PrewarmedPipelines[entry.key] = PrewarmedPipeline{ .key = std::move(key), .pPSO = pPSO };
+}
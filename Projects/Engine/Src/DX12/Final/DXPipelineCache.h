@@ -0,0 +1,86 @@
+#pragma once
+
+#include "DX12/Final/DX12Defines.h"
+#include "DX12/Final/DXPipelineCacheIndex.h"
+
+#include <array>
+#include <mutex>
+#include <future>
+#include <map>
+
+namespace RS::DX12
+{
+	/*
+	* Pipeline states that survive between runs. The descriptions are kept in a DXPipelineCacheIndex and the driver compiled
+	* blobs in an ID3D12PipelineLibrary, both are written to disk on Save.
+	* On Init the files are only used if they were written by the same adapter and driver.
+	*/
+	class DXPipelineCache
+	{
+	public:
+		DXPipelineCache() = default;
+		~DXPipelineCache();
+		RS_NO_COPY_AND_MOVE(DXPipelineCache)
+
+		void Init(const std::string& directoryPath);
+		void Release();
+
+		/*
+		* Writes the index and library to disk if any new pipeline has been added since the last save.
+		*/
+		void Save();
+
+		/*
+		* Creates every pipeline in the index on the ThreadPool. Finalize of a PSO that has been prewarmed will not compile anything.
+		*/
+		void Prewarm();
+		void WaitForPrewarm();
+
+		/*
+		* Returns a new reference to a pipeline state matching the description. It is loaded from the prewarmed pipelines or the library
+		* if it exists, otherwise it is created and stored in the cache. The key has to be built from the same description.
+		*/
+		ID3D12PipelineState* CreateGraphicsPipeline(const DXPipelineKey& key, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, ID3DBlob* pRootSignatureBlob, const wchar_t* name);
+		ID3D12PipelineState* CreateComputePipeline(const DXPipelineKey& key, const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc, ID3DBlob* pRootSignatureBlob, const wchar_t* name);
+
+		bool IsEnabled() const { return m_pLibrary != nullptr; }
+
+		static DXPipelineCacheIndex::DeviceIdentity GetDeviceIdentity();
+
+	private:
+		std::string GetIndexFilePath() const { return m_DirectoryPath + "Pipelines.idx"; }
+		std::string GetLibraryFilePath() const { return m_DirectoryPath + "Pipelines.lib"; }
+
+		static std::vector<uint8> ReadFile(const std::string& path);
+		static bool WriteFile(const std::string& path, const void* pData, uint64 size);
+
+		void CreateLibrary(const std::vector<uint8>& libraryData);
+		ID3D12PipelineState* FindPrewarmed(const DXPipelineKey& key);
+		void PrewarmEntry(const DXPipelineCacheIndex::Entry& entry);
+
+		/*
+		* The library synchronizes itself except when the same pipeline is loaded from several threads at once. Loads lock one of
+		* these, picked by the hash, instead of m_Mutex so the prewarm workers and the render thread do not wait on each other.
+		*/
+		std::mutex& GetLoadMutex(const DXPipelineHash& key) { return m_LoadMutexes[key.low % m_LoadMutexes.size()]; }
+
+	private:
+		std::string m_DirectoryPath;
+		DXPipelineCacheIndex::DeviceIdentity m_DeviceIdentity;
+
+		std::mutex m_Mutex; // Guards the index, the prewarmed pipelines and stores to the library.
+		std::array<std::mutex, 16> m_LoadMutexes;
+		DXPipelineCacheIndex m_Index;
+		ComPtr<ID3D12PipelineLibrary> m_pLibrary;
+		std::vector<uint8> m_LibraryData; // Has to stay alive as long as the library.
+		bool m_IsDirty = false;
+
+		struct PrewarmedPipeline
+		{
+			DXPipelineKey key;
+			ComPtr<ID3D12PipelineState> pPSO;
+		};
+		std::map<DXPipelineHash, PrewarmedPipeline> m_PrewarmedPipelines;
+		std::future<void> m_PrewarmFuture;
+	};
+}
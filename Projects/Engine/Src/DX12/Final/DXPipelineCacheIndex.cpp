@@ -0,0 +1,366 @@
+#include "PreCompiled.h"
+#include "DXPipelineCacheIndex.h"
+
+#include "Utils/Misc/xxhash.h"
+
+namespace RS::DX12::_PipelineCacheInternal
+{
+	class Writer
+	{
+	public:
+		Writer(std::vector<uint8>& data) : m_Data(data) {}
+
+		template<typename T>
+		void Write(const T& value)
+		{
+			static_assert(std::is_trivially_copyable_v<T>);
+			WriteBytes(&value, sizeof(T));
+		}
+
+		void WriteBytes(const void* pData, uint64 size)
+		{
+			if (size == 0)
+				return;
+			const uint8* pBytes = (const uint8*)pData;
+			m_Data.insert(m_Data.end(), pBytes, pBytes + size);
+		}
+
+		void WriteBlob(const void* pData, uint64 size)
+		{
+			Write<uint64>(size);
+			WriteBytes(pData, size);
+		}
+
+		void WriteString(const char* pString)
+		{
+			uint32 length = pString ? (uint32)std::strlen(pString) : 0;
+			Write<uint32>(length);
+			WriteBytes(pString, length);
+		}
+
+	private:
+		std::vector<uint8>& m_Data;
+	};
+
+	class Reader
+	{
+	public:
+		Reader(const uint8* pData, uint64 size) : m_pData(pData), m_Size(size) {}
+
+		template<typename T>
+		bool Read(T& value)
+		{
+			static_assert(std::is_trivially_copyable_v<T>);
+			return ReadBytes(&value, sizeof(T));
+		}
+
+		bool ReadBytes(void* pData, uint64 size)
+		{
+			if (size > m_Size - m_Offset)
+				return false;
+			if (size > 0)
+				std::memcpy(pData, m_pData + m_Offset, size);
+			m_Offset += size;
+			return true;
+		}
+
+		bool ReadBlob(std::vector<uint8>& blob)
+		{
+			uint64 size = 0;
+			if (!Read(size) || size > m_Size - m_Offset)
+				return false;
+			blob.assign(m_pData + m_Offset, m_pData + m_Offset + size);
+			m_Offset += size;
+			return true;
+		}
+
+		bool ReadString(std::string& str)
+		{
+			uint32 length = 0;
+			if (!Read(length) || length > m_Size - m_Offset)
+				return false;
+			str.assign((const char*)(m_pData + m_Offset), length);
+			m_Offset += length;
+			return true;
+		}
+
+		uint64 GetOffset() const { return m_Offset; }
+		bool IsAtEnd() const { return m_Offset == m_Size; }
+
+	private:
+		const uint8* m_pData;
+		uint64 m_Size;
+		uint64 m_Offset = 0;
+	};
+
+	// D3D12_DEPTH_STENCIL_DESC has padding after the stencil masks, write it member by member.
+	void WriteDepthStencilOp(Writer& writer, const D3D12_DEPTH_STENCILOP_DESC& op)
+	{
+		writer.Write(op.StencilFailOp);
+		writer.Write(op.StencilDepthFailOp);
+		writer.Write(op.StencilPassOp);
+		writer.Write(op.StencilFunc);
+	}
+
+	bool ReadDepthStencilOp(Reader& reader, D3D12_DEPTH_STENCILOP_DESC& op)
+	{
+		return reader.Read(op.StencilFailOp) && reader.Read(op.StencilDepthFailOp) && reader.Read(op.StencilPassOp) && reader.Read(op.StencilFunc);
+	}
+
+	void WriteDepthStencil(Writer& writer, const D3D12_DEPTH_STENCIL_DESC& desc)
+	{
+		writer.Write(desc.DepthEnable);
+		writer.Write(desc.DepthWriteMask);
+		writer.Write(desc.DepthFunc);
+		writer.Write(desc.StencilEnable);
+		writer.Write(desc.StencilReadMask);
+		writer.Write(desc.StencilWriteMask);
+		WriteDepthStencilOp(writer, desc.FrontFace);
+		WriteDepthStencilOp(writer, desc.BackFace);
+	}
+
+	bool ReadDepthStencil(Reader& reader, D3D12_DEPTH_STENCIL_DESC& desc)
+	{
+		return reader.Read(desc.DepthEnable) && reader.Read(desc.DepthWriteMask) && reader.Read(desc.DepthFunc)
+			&& reader.Read(desc.StencilEnable) && reader.Read(desc.StencilReadMask) && reader.Read(desc.StencilWriteMask)
+			&& ReadDepthStencilOp(reader, desc.FrontFace) && ReadDepthStencilOp(reader, desc.BackFace);
+	}
+}
+
+bool RS::DX12::DXPipelineDescSerializer::SerializeGraphics(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, const void* pRootSignatureBlob, uint64 rootSignatureSize, std::vector<uint8>& dataOut)
+{
+	using namespace _PipelineCacheInternal;
+
+	if (desc.StreamOutput.NumEntries > 0 || desc.CachedPSO.CachedBlobSizeInBytes > 0)
+		return false;
+
+	dataOut.clear();
+	Writer writer(dataOut);
+	writer.Write(DXPipelineCacheIndex::PipelineType::Graphics);
+	writer.WriteBlob(pRootSignatureBlob, rootSignatureSize);
+
+	const D3D12_SHADER_BYTECODE* shaders[] = { &desc.VS, &desc.PS, &desc.DS, &desc.HS, &desc.GS };
+	for (const D3D12_SHADER_BYTECODE* pShader : shaders)
+		writer.WriteBlob(pShader->pShaderBytecode, pShader->BytecodeLength);
+
+	writer.Write(desc.BlendState);
+	writer.Write(desc.SampleMask);
+	writer.Write(desc.RasterizerState);
+	WriteDepthStencil(writer, desc.DepthStencilState);
+
+	writer.Write<uint32>(desc.InputLayout.NumElements);
+	for (uint32 i = 0; i < desc.InputLayout.NumElements; ++i)
+	{
+		const D3D12_INPUT_ELEMENT_DESC& element = desc.InputLayout.pInputElementDescs[i];
+		writer.WriteString(element.SemanticName);
+		writer.Write(element.SemanticIndex);
+		writer.Write(element.Format);
+		writer.Write(element.InputSlot);
+		writer.Write(element.AlignedByteOffset);
+		writer.Write(element.InputSlotClass);
+		writer.Write(element.InstanceDataStepRate);
+	}
+
+	writer.Write(desc.IBStripCutValue);
+	writer.Write(desc.PrimitiveTopologyType);
+	writer.Write(desc.NumRenderTargets);
+	writer.Write(desc.RTVFormats);
+	writer.Write(desc.DSVFormat);
+	writer.Write(desc.SampleDesc);
+	writer.Write(desc.NodeMask);
+	writer.Write(desc.Flags);
+	return true;
+}
+
+bool RS::DX12::DXPipelineDescSerializer::SerializeCompute(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc, const void* pRootSignatureBlob, uint64 rootSignatureSize, std::vector<uint8>& dataOut)
+{
+	using namespace _PipelineCacheInternal;
+
+	if (desc.CachedPSO.CachedBlobSizeInBytes > 0)
+		return false;
+
+	dataOut.clear();
+	Writer writer(dataOut);
+	writer.Write(DXPipelineCacheIndex::PipelineType::Compute);
+	writer.WriteBlob(pRootSignatureBlob, rootSignatureSize);
+	writer.WriteBlob(desc.CS.pShaderBytecode, desc.CS.BytecodeLength);
+	writer.Write(desc.NodeMask);
+	writer.Write(desc.Flags);
+	return true;
+}
+
+bool RS::DX12::DXPipelineDescSerializer::DeserializeGraphics(const std::vector<uint8>& data, GraphicsDesc& descOut)
+{
+	using namespace _PipelineCacheInternal;
+
+	descOut = GraphicsDesc();
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc = descOut.desc;
+
+	Reader reader(data.data(), data.size());
+	DXPipelineCacheIndex::PipelineType type;
+	if (!reader.Read(type) || type != DXPipelineCacheIndex::PipelineType::Graphics)
+		return false;
+
+	if (!reader.ReadBlob(descOut.rootSignature))
+		return false;
+
+	D3D12_SHADER_BYTECODE* shaders[] = { &desc.VS, &desc.PS, &desc.DS, &desc.HS, &desc.GS };
+	for (uint32 i = 0; i < _countof(shaders); ++i)
+	{
+		if (!reader.ReadBlob(descOut.shaders[i]))
+			return false;
+		shaders[i]->pShaderBytecode = descOut.shaders[i].empty() ? nullptr : descOut.shaders[i].data();
+		shaders[i]->BytecodeLength = descOut.shaders[i].size();
+	}
+
+	if (!reader.Read(desc.BlendState) || !reader.Read(desc.SampleMask) || !reader.Read(desc.RasterizerState) || !ReadDepthStencil(reader, desc.DepthStencilState))
+		return false;
+
+	uint32 elementCount = 0;
+	if (!reader.Read(elementCount))
+		return false;
+
+	// The names are read first, the element pointers cannot be taken before the name vector is done growing.
+	descOut.semanticNames.resize(elementCount);
+	descOut.inputElements.resize(elementCount);
+	for (uint32 i = 0; i < elementCount; ++i)
+	{
+		D3D12_INPUT_ELEMENT_DESC& element = descOut.inputElements[i];
+		if (!reader.ReadString(descOut.semanticNames[i])
+			|| !reader.Read(element.SemanticIndex) || !reader.Read(element.Format) || !reader.Read(element.InputSlot)
+			|| !reader.Read(element.AlignedByteOffset) || !reader.Read(element.InputSlotClass) || !reader.Read(element.InstanceDataStepRate))
+			return false;
+	}
+	for (uint32 i = 0; i < elementCount; ++i)
+		descOut.inputElements[i].SemanticName = descOut.semanticNames[i].c_str();
+	desc.InputLayout.NumElements = elementCount;
+	desc.InputLayout.pInputElementDescs = elementCount > 0 ? descOut.inputElements.data() : nullptr;
+
+	if (!reader.Read(desc.IBStripCutValue) || !reader.Read(desc.PrimitiveTopologyType) || !reader.Read(desc.NumRenderTargets)
+		|| !reader.Read(desc.RTVFormats) || !reader.Read(desc.DSVFormat) || !reader.Read(desc.SampleDesc)
+		|| !reader.Read(desc.NodeMask) || !reader.Read(desc.Flags))
+		return false;
+
+	return reader.IsAtEnd();
+}
+
+bool RS::DX12::DXPipelineDescSerializer::DeserializeCompute(const std::vector<uint8>& data, ComputeDesc& descOut)
+{
+	using namespace _PipelineCacheInternal;
+
+	descOut = ComputeDesc();
+	D3D12_COMPUTE_PIPELINE_STATE_DESC& desc = descOut.desc;
+
+	Reader reader(data.data(), data.size());
+	DXPipelineCacheIndex::PipelineType type;
+	if (!reader.Read(type) || type != DXPipelineCacheIndex::PipelineType::Compute)
+		return false;
+
+	if (!reader.ReadBlob(descOut.rootSignature) || !reader.ReadBlob(descOut.shader))
+		return false;
+	desc.CS.pShaderBytecode = descOut.shader.empty() ? nullptr : descOut.shader.data();
+	desc.CS.BytecodeLength = descOut.shader.size();
+
+	if (!reader.Read(desc.NodeMask) || !reader.Read(desc.Flags))
+		return false;
+
+	return reader.IsAtEnd();
+}
+
+bool RS::DX12::DXPipelineCacheIndex::Add(const DXPipelineHash& key, PipelineType type, const std::string& name, const std::vector<uint8>& description)
+{
+	if (m_KeyToIndex.contains(key))
+		return false;
+
+	m_KeyToIndex[key] = m_Entries.size();
+	m_Entries.push_back(Entry{ .key = key, .type = type, .name = name, .description = description });
+	return true;
+}
+
+const RS::DX12::DXPipelineCacheIndex::Entry* RS::DX12::DXPipelineCacheIndex::Find(const DXPipelineHash& key) const
+{
+	auto it = m_KeyToIndex.find(key);
+	if (it == m_KeyToIndex.end())
+		return nullptr;
+	return &m_Entries[it->second];
+}
+
+void RS::DX12::DXPipelineCacheIndex::Clear()
+{
+	m_Entries.clear();
+	m_KeyToIndex.clear();
+}
+
+std::vector<uint8> RS::DX12::DXPipelineCacheIndex::Serialize(const DeviceIdentity& identity) const
+{
+	using namespace _PipelineCacheInternal;
+
+	std::vector<uint8> data;
+	Writer writer(data);
+	writer.Write(FileMagic);
+	writer.Write(FileVersion);
+	writer.Write(identity);
+	writer.Write<uint64>(m_Entries.size());
+	for (const Entry& entry : m_Entries)
+	{
+		writer.Write(entry.key);
+		writer.Write(entry.type);
+		writer.WriteString(entry.name.c_str());
+		writer.WriteBlob(entry.description.data(), entry.description.size());
+	}
+
+	// Checksum of everything before it, to catch files that were only partly written.
+	uint64 checksum = xxh::xxhash3<64>(data.data(), data.size());
+	writer.Write(checksum);
+	return data;
+}
+
+bool RS::DX12::DXPipelineCacheIndex::Deserialize(const uint8* pData, uint64 size, const DeviceIdentity& identity)
+{
+	using namespace _PipelineCacheInternal;
+
+	Clear();
+
+	if (pData == nullptr || size < sizeof(uint64))
+		return false;
+
+	uint64 checksum = 0;
+	std::memcpy(&checksum, pData + size - sizeof(uint64), sizeof(uint64));
+	if (checksum != xxh::xxhash3<64>(pData, size - sizeof(uint64)))
+		return false;
+
+	Reader reader(pData, size - sizeof(uint64));
+	uint32 magic = 0;
+	uint32 version = 0;
+	DeviceIdentity fileIdentity;
+	uint64 entryCount = 0;
+	if (!reader.Read(magic) || magic != FileMagic || !reader.Read(version) || version != FileVersion)
+		return false;
+	if (!reader.Read(fileIdentity) || fileIdentity != identity)
+		return false;
+	if (!reader.Read(entryCount))
+		return false;
+
+	for (uint64 i = 0; i < entryCount; ++i)
+	{
+		Entry entry;
+		if (!reader.Read(entry.key) || !reader.Read(entry.type) || !reader.ReadString(entry.name) || !reader.ReadBlob(entry.description))
+		{
+			Clear();
+			return false;
+		}
+		Add(entry.key, entry.type, entry.name, entry.description);
+	}
+
+	if (!reader.IsAtEnd())
+	{
+		Clear();
+		return false;
+	}
+	return true;
+}
+
+std::wstring RS::DX12::DXPipelineCacheIndex::GetLibraryName(const DXPipelineHash& key)
+{
+	return Utils::ToWString("PSO_" + key.ToString());
+}
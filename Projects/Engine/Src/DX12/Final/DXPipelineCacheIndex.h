@@ -0,0 +1,114 @@
+#pragma once
+
+#include "DX12/Final/DX12Defines.h"
+#include "DX12/Final/DXPipelineKey.h"
+
+#include <map>
+
+namespace RS::DX12
+{
+	/*
+	* Serializes the content of pipeline state descriptions. Pointers are followed and the data they point to is written instead,
+	* which makes the result the same between runs and usable as a description on disk.
+	* Nothing here needs a device, the root signature is passed in as its serialized blob.
+	*/
+	class DXPipelineDescSerializer
+	{
+	public:
+		RS_STATIC_CLASS(DXPipelineDescSerializer)
+
+		// Owns everything the description points to. The root signature has to be created from rootSignature and set by the caller.
+		struct GraphicsDesc
+		{
+			D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = {};
+			std::vector<D3D12_INPUT_ELEMENT_DESC> inputElements;
+			std::vector<std::string> semanticNames;
+			std::vector<uint8> shaders[5]; // VS, PS, DS, HS, GS
+			std::vector<uint8> rootSignature;
+		};
+
+		struct ComputeDesc
+		{
+			D3D12_COMPUTE_PIPELINE_STATE_DESC desc = {};
+			std::vector<uint8> shader;
+			std::vector<uint8> rootSignature;
+		};
+
+		/*
+		* Returns false if the description uses something that cannot be serialized, like stream output.
+		* The data is not used as a key, use DXPipelineKey for that.
+		*/
+		static bool SerializeGraphics(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, const void* pRootSignatureBlob, uint64 rootSignatureSize, std::vector<uint8>& dataOut);
+		static bool SerializeCompute(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc, const void* pRootSignatureBlob, uint64 rootSignatureSize, std::vector<uint8>& dataOut);
+
+		static bool DeserializeGraphics(const std::vector<uint8>& data, GraphicsDesc& descOut);
+		static bool DeserializeCompute(const std::vector<uint8>& data, ComputeDesc& descOut);
+	};
+
+	/*
+	* The description part of the pipeline cache. Maps a DXPipelineKey hash to a serialized pipeline description and can be written to and read from disk.
+	* The file is only accepted if it was written on the same adapter with the same driver, otherwise the driver blobs would be rejected anyway.
+	*/
+	class DXPipelineCacheIndex
+	{
+	public:
+		enum class PipelineType : uint32
+		{
+			Graphics = 0,
+			Compute
+		};
+
+		struct DeviceIdentity
+		{
+			uint32 vendorID = 0;
+			uint32 deviceID = 0;
+			uint32 subSysID = 0;
+			uint32 revision = 0;
+			uint64 driverVersion = 0;
+
+			bool operator==(const DeviceIdentity&) const = default;
+		};
+
+		struct Entry
+		{
+			DXPipelineHash key;
+			PipelineType type = PipelineType::Graphics;
+			std::string name;
+			std::vector<uint8> description; // From DXPipelineDescSerializer.
+		};
+
+		inline static constexpr uint32 FileMagic = 0x43505352; // "RSPC"
+		inline static constexpr uint32 FileVersion = 2;
+
+	public:
+		DXPipelineCacheIndex() = default;
+		~DXPipelineCacheIndex() = default;
+		RS_DEFAULT_COPY(DXPipelineCacheIndex)
+
+		/*
+		* Returns false if the key already exists.
+		*/
+		bool Add(const DXPipelineHash& key, PipelineType type, const std::string& name, const std::vector<uint8>& description);
+		const Entry* Find(const DXPipelineHash& key) const;
+		void Clear();
+
+		const std::vector<Entry>& GetEntries() const { return m_Entries; }
+		uint64 GetCount() const { return m_Entries.size(); }
+
+		std::vector<uint8> Serialize(const DeviceIdentity& identity) const;
+
+		/*
+		* Replaces the content with the data. Returns false and leaves the index empty if the data is corrupt or from another device or driver.
+		*/
+		bool Deserialize(const uint8* pData, uint64 size, const DeviceIdentity& identity);
+
+		/*
+		* Name of the pipeline in the ID3D12PipelineLibrary.
+		*/
+		static std::wstring GetLibraryName(const DXPipelineHash& key);
+
+	private:
+		std::vector<Entry> m_Entries;
+		std::map<DXPipelineHash, uint64> m_KeyToIndex;
+	};
+}
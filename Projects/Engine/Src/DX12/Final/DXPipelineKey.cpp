@@ -0,0 +1,149 @@
+#include "PreCompiled.h"
+#include "DXPipelineKey.h"
+
+#include "Utils/Misc/xxhash.h"
+
+std::string RS::DX12::DXPipelineHash::ToString() const
+{
+	return Utils::Format("{:016x}{:016x}", high, low);
+}
+
+RS::DX12::DXPipelineKey RS::DX12::DXPipelineKey::FromGraphics(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, const void* pRootSignatureBlob, uint64 rootSignatureSize)
+{
+	DXPipelineKey key;
+	key.Append<uint32>(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VS); // Graphics and compute keys can never be equal.
+	key.AppendBlobHash(pRootSignatureBlob, rootSignatureSize);
+	key.AppendBlobHash(desc.VS.pShaderBytecode, desc.VS.BytecodeLength);
+	key.AppendBlobHash(desc.PS.pShaderBytecode, desc.PS.BytecodeLength);
+	key.AppendBlobHash(desc.DS.pShaderBytecode, desc.DS.BytecodeLength);
+	key.AppendBlobHash(desc.HS.pShaderBytecode, desc.HS.BytecodeLength);
+	key.AppendBlobHash(desc.GS.pShaderBytecode, desc.GS.BytecodeLength);
+	key.AppendStreamOutput(desc.StreamOutput);
+	key.AppendBlendState(desc.BlendState);
+	key.Append(desc.SampleMask);
+	key.Append(desc.RasterizerState);
+	key.AppendDepthStencilState(desc.DepthStencilState);
+	key.AppendInputLayout(desc.InputLayout);
+	key.Append(desc.IBStripCutValue);
+	key.Append(desc.PrimitiveTopologyType);
+	key.Append(desc.NumRenderTargets);
+	for (uint32 i = 0; i < desc.NumRenderTargets; ++i)
+		key.Append(desc.RTVFormats[i]);
+	key.Append(desc.DSVFormat);
+	key.Append(desc.SampleDesc.Count);
+	key.Append(desc.SampleDesc.Quality);
+	key.Append(desc.NodeMask);
+	key.Append(desc.Flags);
+	key.Finish();
+	return key;
+}
+
+RS::DX12::DXPipelineKey RS::DX12::DXPipelineKey::FromCompute(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc, const void* pRootSignatureBlob, uint64 rootSignatureSize)
+{
+	DXPipelineKey key;
+	key.Append<uint32>(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_CS);
+	key.AppendBlobHash(pRootSignatureBlob, rootSignatureSize);
+	key.AppendBlobHash(desc.CS.pShaderBytecode, desc.CS.BytecodeLength);
+	key.Append(desc.NodeMask);
+	key.Append(desc.Flags);
+	key.Finish();
+	return key;
+}
+
+void RS::DX12::DXPipelineKey::AppendBlobHash(const void* pData, uint64 size)
+{
+	Append(size);
+	if (pData == nullptr || size == 0)
+		return;
+
+	xxh::hash128_t hash = xxh::xxhash3<128>(pData, size);
+	Append(hash.low64);
+	Append(hash.high64);
+}
+
+void RS::DX12::DXPipelineKey::AppendString(const char* pString)
+{
+	uint32 length = pString ? (uint32)std::strlen(pString) : 0;
+	Append(length);
+	m_Data.insert(m_Data.end(), (const uint8*)pString, (const uint8*)pString + length);
+}
+
+void RS::DX12::DXPipelineKey::AppendBlendState(const D3D12_BLEND_DESC& desc)
+{
+	// D3D12_RENDER_TARGET_BLEND_DESC ends with a UINT8 and is padded, write it member by member.
+	Append(desc.AlphaToCoverageEnable);
+	Append(desc.IndependentBlendEnable);
+	for (const D3D12_RENDER_TARGET_BLEND_DESC& target : desc.RenderTarget)
+	{
+		Append(target.BlendEnable);
+		Append(target.LogicOpEnable);
+		Append(target.SrcBlend);
+		Append(target.DestBlend);
+		Append(target.BlendOp);
+		Append(target.SrcBlendAlpha);
+		Append(target.DestBlendAlpha);
+		Append(target.BlendOpAlpha);
+		Append(target.LogicOp);
+		Append(target.RenderTargetWriteMask);
+	}
+}
+
+void RS::DX12::DXPipelineKey::AppendDepthStencilState(const D3D12_DEPTH_STENCIL_DESC& desc)
+{
+	Append(desc.DepthEnable);
+	Append(desc.DepthWriteMask);
+	Append(desc.DepthFunc);
+	Append(desc.StencilEnable);
+	Append(desc.StencilReadMask);
+	Append(desc.StencilWriteMask);
+	for (const D3D12_DEPTH_STENCILOP_DESC* pOp : { &desc.FrontFace, &desc.BackFace })
+	{
+		Append(pOp->StencilFailOp);
+		Append(pOp->StencilDepthFailOp);
+		Append(pOp->StencilPassOp);
+		Append(pOp->StencilFunc);
+	}
+}
+
+void RS::DX12::DXPipelineKey::AppendInputLayout(const D3D12_INPUT_LAYOUT_DESC& desc)
+{
+	Append(desc.NumElements);
+	for (uint32 i = 0; i < desc.NumElements; ++i)
+	{
+		const D3D12_INPUT_ELEMENT_DESC& element = desc.pInputElementDescs[i];
+		AppendString(element.SemanticName);
+		Append(element.SemanticIndex);
+		Append(element.Format);
+		Append(element.InputSlot);
+		Append(element.AlignedByteOffset);
+		Append(element.InputSlotClass);
+		Append(element.InstanceDataStepRate);
+	}
+}
+
+void RS::DX12::DXPipelineKey::AppendStreamOutput(const D3D12_STREAM_OUTPUT_DESC& desc)
+{
+	Append(desc.NumEntries);
+	for (uint32 i = 0; i < desc.NumEntries; ++i)
+	{
+		const D3D12_SO_DECLARATION_ENTRY& entry = desc.pSODeclaration[i];
+		Append(entry.Stream);
+		AppendString(entry.SemanticName);
+		Append(entry.SemanticIndex);
+		Append(entry.StartComponent);
+		Append(entry.ComponentCount);
+		Append(entry.OutputSlot);
+	}
+
+	Append(desc.NumStrides);
+	for (uint32 i = 0; i < desc.NumStrides; ++i)
+		Append(desc.pBufferStrides[i]);
+	Append(desc.RasterizedStream);
+}
+
+void RS::DX12::DXPipelineKey::Finish()
+{
+	xxh::hash128_t hash = xxh::xxhash3<128>(m_Data.data(), m_Data.size());
+	m_Hash.low = hash.low64;
+	m_Hash.high = hash.high64;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "DX12/Final/DX12Defines.h"
+
+#include <compare>
+
+namespace RS::DX12
+{
+	struct DXPipelineHash
+	{
+		uint64 low = 0;
+		uint64 high = 0;
+
+		auto operator<=>(const DXPipelineHash&) const = default;
+
+		// 32 hex characters.
+		std::string ToString() const;
+	};
+
+	/*
+	* Identifies a pipeline state by its content and not by the addresses in the description. Shader bytecode and the root signature blob
+	* are replaced by their hashes, input layout and stream output semantics by their strings and the state blocks are written member by member to skip padding.
+	* The hash is a 128 bit xxhash3 of that data. Two keys are only equal if the data is equal too, a matching hash is not enough.
+	*/
+	class DXPipelineKey
+	{
+	public:
+		DXPipelineKey() = default;
+
+		static DXPipelineKey FromGraphics(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, const void* pRootSignatureBlob, uint64 rootSignatureSize);
+		static DXPipelineKey FromCompute(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc, const void* pRootSignatureBlob, uint64 rootSignatureSize);
+
+		const DXPipelineHash& GetHash() const { return m_Hash; }
+		const std::vector<uint8>& GetData() const { return m_Data; }
+		bool IsValid() const { return !m_Data.empty(); }
+
+		bool operator==(const DXPipelineKey& other) const { return m_Hash == other.m_Hash && m_Data == other.m_Data; }
+
+	private:
+		template<typename T>
+		void Append(const T& value)
+		{
+			static_assert(std::is_trivially_copyable_v<T>);
+			const uint8* pBytes = (const uint8*)&value;
+			m_Data.insert(m_Data.end(), pBytes, pBytes + sizeof(T));
+		}
+
+		void AppendBlobHash(const void* pData, uint64 size);
+		void AppendString(const char* pString);
+		void AppendBlendState(const D3D12_BLEND_DESC& desc);
+		void AppendDepthStencilState(const D3D12_DEPTH_STENCIL_DESC& desc);
+		void AppendInputLayout(const D3D12_INPUT_LAYOUT_DESC& desc);
+		void AppendStreamOutput(const D3D12_STREAM_OUTPUT_DESC& desc);
+		void Finish();
+
+	private:
+		DXPipelineHash m_Hash;
+		std::vector<uint8> m_Data;
+	};
+}
@@ -16,19 +16,20 @@
 #include "DXPipelineState.h"
 
 #include "DX12/Final/DXCore.h"
+#include "DX12/Final/DXPipelineCache.h"
+#include "DX12/Final/DXPipelineStateMap.h"
 #include "Utils/Misc/HashUtils.h"
 
-#include <map>
 #include <thread>
 #include <mutex>
 
-static std::map< size_t, ComPtr<ID3D12PipelineState> > s_GraphicsPSOHashMap;
-static std::map< size_t, ComPtr<ID3D12PipelineState> > s_ComputePSOHashMap;
+static RS::DX12::DXPipelineStateMap s_GraphicsPSOHashMap;
+static RS::DX12::DXPipelineStateMap s_ComputePSOHashMap;
 
 void RS::DX12::DXPSO::DestroyAll(void)
 {
-    s_GraphicsPSOHashMap.clear();
-    s_ComputePSOHashMap.clear();
+    s_GraphicsPSOHashMap.Clear();
+    s_ComputePSOHashMap.Clear();
 }
 
 void RS::DX12::DXPSO::SetShader(DXShader& shader)
@@ -65,10 +66,6 @@ void RS::DX12::DXPSO::SetShaderDescription(const DXShader::Description& desc, co
     else
         m_ShaderDescs[key] = ShaderBundle{.description = desc, .types = type.GetConst()};
 
-    const uint32 index = Utils::IndexOfPow2Bit(type.GetConst());
-    m_HashCodeShaders[index] = Utils::Hash64(desc.path);
-    m_HashCodeShaders[index] = Utils::Hash64(desc.isInternalPath, m_HashCodeShaders[index]);
-
     m_ShaderFlags |= type;
 }
 
@@ -85,32 +82,27 @@ RS::DX12::DXGraphicsPSO::DXGraphicsPSO(const wchar_t* Name)
 void RS::DX12::DXGraphicsPSO::SetBlendState(const D3D12_BLEND_DESC& BlendDesc)
 {
     m_PSODesc.BlendState = BlendDesc;
-    m_HashCodeBlendState = Utils::Hash64State(&BlendDesc);
 }
 
 void RS::DX12::DXGraphicsPSO::SetRasterizerState(const D3D12_RASTERIZER_DESC& RasterizerDesc)
 {
     m_PSODesc.RasterizerState = RasterizerDesc;
-    m_HashCodeRasterizerState = Utils::Hash64State(&RasterizerDesc);
 }
 
 void RS::DX12::DXGraphicsPSO::SetDepthStencilState(const D3D12_DEPTH_STENCIL_DESC& DepthStencilDesc)
 {
     m_PSODesc.DepthStencilState = DepthStencilDesc;
-    m_HashCodeDepthStencilState = Utils::Hash64State(&DepthStencilDesc);
 }
 
 void RS::DX12::DXGraphicsPSO::SetSampleMask(UINT SampleMask)
 {
     m_PSODesc.SampleMask = SampleMask;
-    m_HashCodeSampleMask = Utils::Hash64(SampleMask);
 }
 
 void RS::DX12::DXGraphicsPSO::SetPrimitiveTopologyType(D3D12_PRIMITIVE_TOPOLOGY_TYPE TopologyType)
 {
     RS_ASSERT(TopologyType != D3D12_PRIMITIVE_TOPOLOGY_TYPE_UNDEFINED, "Can't draw with undefined topology");
     m_PSODesc.PrimitiveTopologyType = TopologyType;
-    m_HashCodePrimitiveTopologyType = Utils::Hash64State(&TopologyType);
 }
 
 void RS::DX12::DXGraphicsPSO::SetDepthTargetFormat(DXGI_FORMAT DSVFormat, UINT MsaaCount, UINT MsaaQuality)
@@ -137,12 +129,6 @@ void RS::DX12::DXGraphicsPSO::SetRenderTargetFormats(UINT NumRTVs, const DXGI_FO
     m_PSODesc.DSVFormat = DSVFormat;
     m_PSODesc.SampleDesc.Count = MsaaCount;
     m_PSODesc.SampleDesc.Quality = MsaaQuality;
-
-    m_HashCodeRenderTargetFormats = Utils::Hash64State(&m_PSODesc.RTVFormats[0], 8);
-    m_HashCodeRenderTargetFormats = Utils::Hash64(m_PSODesc.NumRenderTargets, m_HashCodeRenderTargetFormats);
-    m_HashCodeRenderTargetFormats = Utils::Hash64(m_PSODesc.DSVFormat, m_HashCodeRenderTargetFormats);
-    m_HashCodeRenderTargetFormats = Utils::Hash64(m_PSODesc.SampleDesc.Count, m_HashCodeRenderTargetFormats);
-    m_HashCodeRenderTargetFormats = Utils::Hash64(m_PSODesc.SampleDesc.Quality, m_HashCodeRenderTargetFormats);
 }
 
 void RS::DX12::DXGraphicsPSO::SetInputLayout(UINT NumElements, const D3D12_INPUT_ELEMENT_DESC* pInputElementDescs)
@@ -157,14 +143,11 @@ void RS::DX12::DXGraphicsPSO::SetInputLayout(UINT NumElements, const D3D12_INPUT
     }
     else
         m_InputLayouts = nullptr;
-
-    m_HashCodeInputLayout = Utils::Hash64State(pInputElementDescs, NumElements);
 }
 
 void RS::DX12::DXGraphicsPSO::SetPrimitiveRestart(D3D12_INDEX_BUFFER_STRIP_CUT_VALUE IBProps)
 {
     m_PSODesc.IBStripCutValue = IBProps;
-    m_HashCodePrimitiveRestart = Utils::Hash64State(&IBProps);
 }
 
 void RS::DX12::DXGraphicsPSO::SetShaderType(DXShader::TypeFlag type, DXShader& shader)
@@ -215,54 +198,31 @@ ID3D12PipelineState* RS::DX12::DXGraphicsPSO::Finalize(bool detach)
     // Make sure the root signature is finalized first
     m_PSODesc.pRootSignature = m_RootSignature->GetSignature();
     RS_ASSERT(m_PSODesc.pRootSignature != nullptr);
+    ID3DBlob* pRootSignatureBlob = m_RootSignature->GetSerializedSignature();
 
-    m_PSODesc.InputLayout.pInputElementDescs = nullptr;
-    m_HashCode = Utils::Hash64State(&m_PSODesc);
-    m_HashCode = Utils::Hash64State(m_InputLayouts.get(), m_PSODesc.InputLayout.NumElements, m_HashCode);
     m_PSODesc.InputLayout.pInputElementDescs = m_InputLayouts.get();
+    m_Key = DXPipelineKey::FromGraphics(m_PSODesc, pRootSignatureBlob->GetBufferPointer(), pRootSignatureBlob->GetBufferSize());
 
-    //m_HashCode = Utils::Hash64State(&m_HashCodeShaders[0], DXShader::TypeFlag::COUNT - 1, m_HashCodeRootSignature);
-    //m_HashCode = Utils::Hash64(m_HashCodeBlendState, m_HashCode);
-    //m_HashCode = Utils::Hash64(m_HashCodeRasterizerState, m_HashCode);
-    //m_HashCode = Utils::Hash64(m_HashCodeDepthStencilState, m_HashCode);
-    //m_HashCode = Utils::Hash64(m_HashCodeDepthTargetFormat, m_HashCode);
-    //m_HashCode = Utils::Hash64(m_HashCodeInputLayout, m_HashCode);
-    //m_HashCode = Utils::Hash64(m_HashCodePrimitiveRestart, m_HashCode);
-    //m_HashCode = Utils::Hash64(m_HashCodePrimitiveTopologyType, m_HashCode);
-    //m_HashCode = Utils::Hash64(m_HashCodeRenderTargetFormats, m_HashCode);
-    //m_HashCode = Utils::Hash64(m_HashCodeSampleMask, m_HashCode);
-
-    ID3D12PipelineState** PSORef = nullptr;
     bool firstCompile = false;
-    {
-        static std::mutex s_HashMapMutex;
-        std::lock_guard<std::mutex> CS(s_HashMapMutex);
-        auto iter = s_GraphicsPSOHashMap.find(m_HashCode);
-
-        // Reserve space so the next inquiry will find that someone got here first.
-        if (iter == s_GraphicsPSOHashMap.end())
-        {
-            firstCompile = true;
-            PSORef = s_GraphicsPSOHashMap[m_HashCode].GetAddressOf();
-        }
-        else
-            PSORef = iter->second.GetAddressOf();
-    }
+    ComPtr<ID3D12PipelineState>* pPSORef = s_GraphicsPSOHashMap.FindOrReserve(m_Key, m_Name, firstCompile);
 
     ID3D12PipelineState* pPSO = nullptr;
 
     if (firstCompile)
     {
         RS_ASSERT(m_PSODesc.DepthStencilState.DepthEnable != (m_PSODesc.DSVFormat == DXGI_FORMAT_UNKNOWN));
-        DXCall(DXCore::GetDevice()->CreateGraphicsPipelineState(&m_PSODesc, IID_PPV_ARGS(&pPSO)));
-        s_GraphicsPSOHashMap[m_HashCode].Attach(pPSO);
+        if (DXPipelineCache* pPipelineCache = DXCore::GetPipelineCache())
+            pPSO = pPipelineCache->CreateGraphicsPipeline(m_Key, m_PSODesc, pRootSignatureBlob, m_Name);
+        else
+            DXCall(DXCore::GetDevice()->CreateGraphicsPipelineState(&m_PSODesc, IID_PPV_ARGS(&pPSO)));
+        pPSORef->Attach(pPSO);
         pPSO->SetName(m_Name);
     }
     else
     {
-        while (*PSORef == nullptr)
+        while (pPSORef->Get() == nullptr)
             std::this_thread::yield();
-        pPSO = *PSORef;
+        pPSO = pPSORef->Get();
     }
 
     if (!detach)
@@ -288,39 +248,28 @@ ID3D12PipelineState* RS::DX12::DXComputePSO::Finalize(bool detach)
     // Make sure the root signature is finalized first
     m_PSODesc.pRootSignature = m_RootSignature->GetSignature();
     RS_ASSERT(m_PSODesc.pRootSignature != nullptr);
+    ID3DBlob* pRootSignatureBlob = m_RootSignature->GetSerializedSignature();
 
-    m_HashCode = Utils::Hash64State(&m_PSODesc);
-    //m_HashCode = Utils::Hash64State(&m_HashCodeShaders[0], DXShader::TypeFlag::COUNT - 1, m_HashCodeRootSignature);
+    m_Key = DXPipelineKey::FromCompute(m_PSODesc, pRootSignatureBlob->GetBufferPointer(), pRootSignatureBlob->GetBufferSize());
 
-    ID3D12PipelineState** PSORef = nullptr;
     bool firstCompile = false;
-    {
-        static std::mutex s_HashMapMutex;
-        std::lock_guard<std::mutex> CS(s_HashMapMutex);
-        auto iter = s_ComputePSOHashMap.find(m_HashCode);
-
-        // Reserve space so the next inquiry will find that someone got here first.
-        if (iter == s_ComputePSOHashMap.end())
-        {
-            firstCompile = true;
-            PSORef = s_ComputePSOHashMap[m_HashCode].GetAddressOf();
-        }
-        else
-            PSORef = iter->second.GetAddressOf();
-    }
+    ComPtr<ID3D12PipelineState>* pPSORef = s_ComputePSOHashMap.FindOrReserve(m_Key, m_Name, firstCompile);
 
     ID3D12PipelineState* pPSO = nullptr;
     if (firstCompile)
     {
-        DXCall(DXCore::GetDevice()->CreateComputePipelineState(&m_PSODesc, IID_PPV_ARGS(&pPSO)));
-        s_ComputePSOHashMap[m_HashCode].Attach(pPSO);
+        if (DXPipelineCache* pPipelineCache = DXCore::GetPipelineCache())
+            pPSO = pPipelineCache->CreateComputePipeline(m_Key, m_PSODesc, pRootSignatureBlob, m_Name);
+        else
+            DXCall(DXCore::GetDevice()->CreateComputePipelineState(&m_PSODesc, IID_PPV_ARGS(&pPSO)));
+        pPSORef->Attach(pPSO);
         pPSO->SetName(m_Name);
     }
     else
     {
-        while (*PSORef == nullptr)
+        while (pPSORef->Get() == nullptr)
             std::this_thread::yield();
-        pPSO = *PSORef;
+        pPSO = pPSORef->Get();
     }
 
     if (!detach)
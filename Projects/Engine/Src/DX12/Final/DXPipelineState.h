@@ -17,6 +17,7 @@
 #include "DX12/Final/DX12Defines.h"
 #include "DX12/Final/DXRootSignature.h"
 #include "DX12/Final/DXShader.h"
+#include "DX12/Final/DXPipelineKey.h"
 
 namespace RS::DX12
 {
@@ -28,19 +29,16 @@ namespace RS::DX12
 
         DXPSO(const wchar_t* Name) : m_Name(Name), m_RootSignature(nullptr), m_PSO(nullptr)
         {
-            for (uint64& hash : m_HashCodeShaders)
-                hash = 0u;
-
             static uint64 s_Generator = 0u;
             m_ID = ++s_Generator;
         }
+        virtual ~DXPSO() = default;
 
         static void DestroyAll(void);
 
         void SetRootSignature(const DXRootSignature& BindMappings)
         {
             m_RootSignature = &BindMappings;
-            m_HashCodeRootSignature = Utils::Hash64(m_RootSignature);
         }
 
         const DXRootSignature& GetRootSignature(void) const
@@ -55,8 +53,12 @@ namespace RS::DX12
         void SetShaderTypes(DXShader::TypeFlag types, DXShader& shader);
         virtual void SetShaderType(DXShader::TypeFlag type, DXShader& shader) = 0;
         virtual ID3D12PipelineState* Finalize(bool detach = false) = 0;
+        // A copy of the description, to finalize a new version of the PSO without touching this one.
+        virtual std::unique_ptr<DXPSO> Clone() const = 0;
 
         uint64 GetID() const { return m_ID; }
+        // Content key of the last Finalize.
+        const DXPipelineKey& GetKey() const { return m_Key; }
         DXShader::TypeFlag GetShaderFlags() const { return m_ShaderFlags; }
 
         bool IsValid() const { return m_PSO != nullptr; }
@@ -71,11 +73,7 @@ namespace RS::DX12
 
         const DXRootSignature* m_RootSignature;
 
-        // Hash code for each settable state.
-        uint64 m_HashCodeRootSignature = 0u;
-        uint64 m_HashCodeShaders[DXShader::TypeFlags::COUNT-1];
-        // Main hash code
-        uint64 m_HashCode = 0u;
+        DXPipelineKey m_Key;
         ID3D12PipelineState* m_PSO;
         uint64 m_ID = 0u;
         DXShader::TypeFlag m_ShaderFlags = DXShader::TypeFlag::NONE;
@@ -117,6 +115,7 @@ namespace RS::DX12
 
         // Perform validation and compute a hash value for fast state block comparisons
         ID3D12PipelineState* Finalize(bool detach = false) override;
+        std::unique_ptr<DXPSO> Clone() const override { return std::make_unique<DXGraphicsPSO>(*this); }
 
     private:
         // These const_casts shouldn't be necessary, but we need to fix the API to accept "const void* pShaderBytecode"
@@ -130,17 +129,6 @@ namespace RS::DX12
 
         D3D12_GRAPHICS_PIPELINE_STATE_DESC m_PSODesc;
         std::shared_ptr<const D3D12_INPUT_ELEMENT_DESC> m_InputLayouts;
-
-        // Hashes
-        uint64 m_HashCodeBlendState = 0u;
-        uint64 m_HashCodeRasterizerState = 0u;
-        uint64 m_HashCodeDepthStencilState = 0u;
-        uint64 m_HashCodeSampleMask = 0u;
-        uint64 m_HashCodePrimitiveTopologyType = 0u;
-        uint64 m_HashCodeDepthTargetFormat = 0u;
-        uint64 m_HashCodeRenderTargetFormats = 0u;
-        uint64 m_HashCodeInputLayout = 0u;
-        uint64 m_HashCodePrimitiveRestart = 0u;
     };
 
 
@@ -155,6 +143,7 @@ namespace RS::DX12
         void SetShaderType(DXShader::TypeFlag type, DXShader& shader) override;
 
         ID3D12PipelineState* Finalize(bool detatch = false) override;
+        std::unique_ptr<DXPSO> Clone() const override { return std::make_unique<DXComputePSO>(*this); }
 
     private:
         void SetComputeShader(const void* Binary, size_t Size) { m_PSODesc.CS = CD3DX12_SHADER_BYTECODE(const_cast<void*>(Binary), Size); }
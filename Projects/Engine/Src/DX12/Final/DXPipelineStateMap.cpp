@@ -0,0 +1,39 @@
+#include "PreCompiled.h"
+#include "DXPipelineStateMap.h"
+
+ComPtr<ID3D12PipelineState>* RS::DX12::DXPipelineStateMap::FindOrReserve(const DXPipelineKey& key, const wchar_t* name, bool& reservedOut)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	std::list<Entry>& entries = m_Entries[key.GetHash()];
+	for (Entry& entry : entries)
+	{
+		if (entry.key == key)
+		{
+			reservedOut = false;
+			return &entry.pPSO;
+		}
+	}
+
+	if (!entries.empty())
+		LOG_WARNING("PSO hash collision for '{}' with hash {}!", Utils::ToString(name), key.GetHash().ToString());
+
+	// Reserve space so the next inquiry will find that someone got here first.
+	reservedOut = true;
+	entries.push_back(Entry{ .key = key });
+	return &entries.back().pPSO;
+}
+
+void RS::DX12::DXPipelineStateMap::Clear()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Entries.clear();
+}
+
+uint64 RS::DX12::DXPipelineStateMap::GetCount()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	uint64 count = 0;
+	for (const auto& [hash, entries] : m_Entries)
+		count += entries.size();
+	return count;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "DX12/Final/DX12Defines.h"
+#include "DX12/Final/DXPipelineKey.h"
+
+#include <list>
+#include <map>
+#include <mutex>
+
+namespace RS::DX12
+{
+	/*
+	* The pipeline states that have been created this run, looked up by DXPipelineKey. Keys with the same hash but other content
+	* get their own slot. Slot addresses are handed out and stay valid until Clear.
+	*/
+	class DXPipelineStateMap
+	{
+	public:
+		DXPipelineStateMap() = default;
+		RS_NO_COPY_AND_MOVE(DXPipelineStateMap)
+
+		/*
+		* Returns the slot of the key. reservedOut is true if the slot was added by this call, the caller then has to create the
+		* pipeline and attach it. Other callers get the same slot and have to wait until it is set.
+		*/
+		ComPtr<ID3D12PipelineState>* FindOrReserve(const DXPipelineKey& key, const wchar_t* name, bool& reservedOut);
+
+		void Clear();
+		uint64 GetCount();
+
+	private:
+		struct Entry
+		{
+			DXPipelineKey key;
+			ComPtr<ID3D12PipelineState> pPSO;
+		};
+
+		std::mutex m_Mutex;
+		// A list is used since the slot address is handed out.
+		std::map<DXPipelineHash, std::list<Entry>> m_Entries;
+	};
+}
@@ -130,14 +130,14 @@ void RS::DX12::DXRootSignature::Finalize(const std::wstring& name, D3D12_ROOT_SI
             RSRef = iter->second.GetAddressOf();
     }
 
+    // The serialized blob is kept even if the signature already exists, the pipeline cache stores it with the PSO descriptions.
+    ComPtr<ID3DBlob> pErrorBlob;
+    DXCall(D3D12SerializeRootSignature(&RootDesc, D3D_ROOT_SIGNATURE_VERSION_1,
+        m_pSerializedSignature.ReleaseAndGetAddressOf(), pErrorBlob.GetAddressOf()));
+
     if (firstCompile)
     {
-        ComPtr<ID3DBlob> pOutBlob, pErrorBlob;
-
-        DXCall(D3D12SerializeRootSignature(&RootDesc, D3D_ROOT_SIGNATURE_VERSION_1,
-            pOutBlob.GetAddressOf(), pErrorBlob.GetAddressOf()));
-
-        DXCall(DXCore::GetDevice()->CreateRootSignature(1, pOutBlob->GetBufferPointer(), pOutBlob->GetBufferSize(), IID_PPV_ARGS(&m_Signature)));
+        DXCall(DXCore::GetDevice()->CreateRootSignature(1, m_pSerializedSignature->GetBufferPointer(), m_pSerializedSignature->GetBufferSize(), IID_PPV_ARGS(&m_Signature)));
 
         m_Signature->SetName(name.c_str());
 
@@ -165,6 +165,7 @@ namespace RS::DX12
         void Finalize(const std::wstring& name, D3D12_ROOT_SIGNATURE_FLAGS Flags = D3D12_ROOT_SIGNATURE_FLAG_NONE);
 
         ID3D12RootSignature* GetSignature() const { return m_Signature; }
+        ID3DBlob* GetSerializedSignature() const { return m_pSerializedSignature.Get(); }
 
     protected:
 
@@ -178,5 +179,6 @@ namespace RS::DX12
         std::unique_ptr<DXRootParameter[]> m_ParamArray;
         std::unique_ptr<D3D12_STATIC_SAMPLER_DESC[]> m_SamplerArray;
         ID3D12RootSignature* m_Signature;
+        ComPtr<ID3DBlob> m_pSerializedSignature;
     };
 }
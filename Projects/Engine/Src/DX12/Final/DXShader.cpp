@@ -3,10 +3,16 @@
 
 #include "Utils/Utils.h"
 #include "Core/LaunchArguments.h"
+#include "Core/Profiler.h"
+#include "Core/ThreadPool.h"
+#include "Core/VFS.h"
+#include "DX12/Final/DXShaderDependencyGraph.h"
+#include "DX12/DXCIncludeHandler.h"
 
 #include <fstream>
 #include <sstream>
 #include <unordered_set>
+#include <set>
 
 namespace RS::DX12::_ShaderInternal
 {
@@ -49,6 +55,24 @@ namespace RS::DX12::_ShaderInternal
 #include "DXShaderTypes.h"
 	};
 #undef DEF_SHADER_TYPE
+
+	// The DXC objects are not thread safe, each thread that compiles shaders gets its own set.
+	struct DXCInstance
+	{
+		Microsoft::WRL::ComPtr<IDxcUtils> utils;
+		Microsoft::WRL::ComPtr<IDxcCompiler3> pCompiler;
+	};
+
+	DXCInstance& GetThreadDXCInstance()
+	{
+		thread_local DXCInstance s_Instance;
+		if (!s_Instance.pCompiler)
+		{
+			DXCallVerbose(DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(s_Instance.utils.ReleaseAndGetAddressOf())));
+			DXCallVerbose(DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(s_Instance.pCompiler.ReleaseAndGetAddressOf())));
+		}
+		return s_Instance;
+	}
 }
 
 RS::DX12::DXShader::~DXShader()
@@ -68,6 +92,8 @@ std::string RS::DX12::DXShader::GetDiskPathFromVirtualPath(const std::string& vi
 
 bool RS::DX12::DXShader::Create(const Description& description)
 {
+	RS_PROFILE_SCOPE("Shader Create");
+
 	if (!ValidateShaderTypes(description.typeFlags))
 		return false;
 
@@ -79,6 +105,46 @@ bool RS::DX12::DXShader::Create(const Description& description)
 
 	EntryPointsStringArray entryPointsStringArray = ConstructEntryPointsArray(description.customEntryPoints);
 
+	TypeFlags types = TypeFlag::NONE;
+	std::vector<File> files;
+	std::vector<CompileJob> jobs;
+	std::vector<PartData> shaderParts;
+
+	bool succeeded = GatherShaderParts(shaderPath, description, entryPointsStringArray, types, files, jobs);
+	if (succeeded)
+		succeeded = CompileShaderParts(files, jobs, entryPointsStringArray, shaderPath, shaderParts);
+
+	for (File& file : files)
+		file.Release();
+
+	if (!succeeded)
+		return false;
+
+	{
+		std::vector<std::string> includedFiles;
+		for (const PartData& part : shaderParts)
+			includedFiles.insert(includedFiles.end(), part.includedFiles.begin(), part.includedFiles.end());
+		DXShaderDependencyGraph::Get()->SetDependencies(shaderPath, includedFiles);
+	}
+
+	// Update current state
+	{
+		if (m_ShaderParts.empty() == false)
+			Release();
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_ShaderParts = shaderParts;
+		m_ShaderVirtualPath = shaderVirtualPath;
+		m_ShaderPath = shaderPath; // Mainly for debug purposes.
+		m_Types = types;
+		m_EntryPointStrings = entryPointsStringArray;
+		m_Description = description;
+	}
+	return true;
+}
+
+bool RS::DX12::DXShader::GatherShaderParts(const std::string& shaderPath, const Description& description, const EntryPointsStringArray& entryPointStrings,
+	TypeFlags& typesOut, std::vector<File>& filesOut, std::vector<CompileJob>& jobsOut)
+{
 	// Path can be a path to a folder or a path with a filename (including or excluding the extension). Like this:
 	// shaderPasses/coolShaderPass or shaderPasses/coolShaderPass.ps (for pixel shader) or a generic shaderPasses/coolShaderPass.hlsl
 	// In this case 'coolShaderPass' migh be a folder, or it might be the name of the shader files, all of which uses the same name.
@@ -86,9 +152,6 @@ bool RS::DX12::DXShader::Create(const Description& description)
 
 	TypeFlags remainingTypesToCompile = description.typeFlags;
 	TypeFlags totalTypesSeen = TypeFlag::NONE;
-	TypeFlags types = TypeFlag::NONE;
-
-	std::vector<PartData> shaderParts;
 
 	auto path = std::filesystem::path(shaderPath);
 	if (std::filesystem::is_directory(path)) // Folder with multiple shader files, with different names and extensions.
@@ -101,20 +164,20 @@ bool RS::DX12::DXShader::Create(const Description& description)
 
 		for (const auto& entry : std::filesystem::directory_iterator(path))
 		{
-			if (!CreateShaderPartsFromFile(entry.path(), remainingTypesToCompile,
-				types, totalTypesSeen, false, entryPointsStringArray, shaderPath, shaderParts, description.defines))
+			if (!GatherShaderPartsFromFile(entry.path(), remainingTypesToCompile,
+				typesOut, totalTypesSeen, false, entryPointStrings, shaderPath, filesOut, jobsOut, description.defines))
 				return false;
 		}
 
-		if (!ValidateShaderTypesMatches(remainingTypesToCompile, types, totalTypesSeen, shaderPath))
+		if (!ValidateShaderTypesMatches(remainingTypesToCompile, typesOut, totalTypesSeen, shaderPath))
 			return false;
 	}
 	else if (path.extension().empty() == false) // Single file.
 	{
-		if (std::filesystem::exists(path))
+		if (VFS::Get()->Exists(path.string()))
 		{
-			if (!CreateShaderPartsFromFile(path, remainingTypesToCompile,
-				types, totalTypesSeen, true, entryPointsStringArray, shaderPath, shaderParts, description.defines))
+			if (!GatherShaderPartsFromFile(path, remainingTypesToCompile,
+				typesOut, totalTypesSeen, true, entryPointStrings, shaderPath, filesOut, jobsOut, description.defines))
 				return false;
 		}
 		else
@@ -133,29 +196,17 @@ bool RS::DX12::DXShader::Create(const Description& description)
 			auto eStem = filePath.stem();
 			if (eStem == stem)
 			{
-				if (!CreateShaderPartsFromFile(filePath, remainingTypesToCompile,
-					types, totalTypesSeen, false, entryPointsStringArray, shaderPath, shaderParts, description.defines))
+				if (!GatherShaderPartsFromFile(filePath, remainingTypesToCompile,
+					typesOut, totalTypesSeen, false, entryPointStrings, shaderPath, filesOut, jobsOut, description.defines))
 					return false;
 			}
 		}
 
-		if (!ValidateShaderTypesMatches(remainingTypesToCompile, types, totalTypesSeen, shaderPath))
+		if (!ValidateShaderTypesMatches(remainingTypesToCompile, typesOut, totalTypesSeen, shaderPath))
 			return false;
 
 	}
 
-	// Update current state
-	{
-		if (m_ShaderParts.empty() == false)
-			Release();
-		std::lock_guard<std::mutex> lock(m_Mutex);
-		m_ShaderParts = shaderParts;
-		m_ShaderVirtualPath = shaderVirtualPath;
-		m_ShaderPath = shaderPath; // Mainly for debug purposes.
-		m_Types = types;
-		m_EntryPointStrings = entryPointsStringArray;
-		m_Description = description;
-	}
 	return true;
 }
 
@@ -169,6 +220,7 @@ void RS::DX12::DXShader::Release()
 		DX12_RELEASE(part.pReflection);
 		DX12_RELEASE(part.pShaderObject);
 		part.type = TypeFlag::NONE;
+		part.includedFiles.clear();
 	}
 	m_ShaderPath = "";
 }
@@ -183,6 +235,7 @@ void RS::DX12::DXShader::Invalidate()
 		part.pReflection = nullptr;
 		part.pShaderObject = nullptr;
 		part.type = TypeFlag::NONE;
+		part.includedFiles.clear();
 	}
 	m_ShaderPath = "";
 }
@@ -211,6 +264,15 @@ bool RS::DX12::DXShader::Combine(DXShader& other)
 	return true;
 }
 
+std::vector<std::string> RS::DX12::DXShader::GetIncludedFiles()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	std::set<std::string> includedFiles;
+	for (const PartData& part : m_ShaderParts)
+		includedFiles.insert(part.includedFiles.begin(), part.includedFiles.end());
+	return std::vector<std::string>(includedFiles.begin(), includedFiles.end());
+}
+
 D3D12_SHADER_BYTECODE RS::DX12::DXShader::GetShaderByteCode(TypeFlags type, bool supressWarnings)
 {
 	IDxcBlob* pShaderObject = GetShaderBlob(type, supressWarnings);
@@ -259,10 +321,10 @@ ID3D12ShaderReflection* RS::DX12::DXShader::GetReflection(TypeFlags type, bool s
 	return nullptr;
 }
 
-bool RS::DX12::DXShader::CreateShaderPartsFromFile(const std::filesystem::path& filePath, TypeFlags& remainingTypesToCompile,
+bool RS::DX12::DXShader::GatherShaderPartsFromFile(const std::filesystem::path& filePath, TypeFlags& remainingTypesToCompile,
 	TypeFlags& finalTypes, TypeFlags& totalTypesSeen, bool isTheOnlyFile,
-	const EntryPointsStringArray& entryPointStrings, const std::string& shaderPath, std::vector<PartData>& shaderPartsOut,
-	const std::vector<std::string>& defines)
+	const EntryPointsStringArray& entryPointStrings, const std::string& shaderPath,
+	std::vector<File>& filesOut, std::vector<CompileJob>& jobsOut, const std::vector<std::string>& defines)
 {
 	// Load shader and its types.
 	if (!CheckValidExtension(filePath))
@@ -292,41 +354,89 @@ bool RS::DX12::DXShader::CreateShaderPartsFromFile(const std::filesystem::path&
 		currentTypes = typesInFile;
 
 		if (isTheOnlyFile && !ValidateShaderTypes(currentTypes))
+		{
+			file.Release();
 			return false;
+		}
 	}
 
 	// Can validate the types earlier for single file shaders.
 	if (isTheOnlyFile && !ValidateSingleFileTypes(currentTypes, typesInFile, shaderPath))
+	{
+		file.Release();
 		return false;
+	}
 
-	// Compile shaders.
-	// TODO: Use a TriBool instead.
-	uint8 result = 3; // 2: true
+	// Queue the parts. The types are marked as done here, if any of the parts fails to compile the whole shader fails anyway.
+	const uint32 fileIndex = (uint32)filesOut.size();
+	const uint64 jobCountBefore = jobsOut.size();
 	for (uint32 typeIndex = 0; typeIndex < TypeFlag::COUNT; typeIndex++)
 	{
 		TypeFlags typeToCheck = 1 << typeIndex;
 		if ((typeToCheck & currentTypes) & typesInFile)
 		{
-			std::optional<PartData> partData = CompileShaderPart(file, typeToCheck, entryPointStrings, shaderPath);
-			if (partData.has_value())
-				shaderPartsOut.push_back(partData.value());
+			jobsOut.push_back({ .fileIndex = fileIndex, .type = typeToCheck });
 
-			result &= partData.has_value() ? 1 : 0;
-			if (result)
-			{
-				if (remainingTypesToCompile != TypeFlag::Auto)
-					remainingTypesToCompile = remainingTypesToCompile & ~typeToCheck;
-				finalTypes |= typeToCheck;
-			}
+			if (remainingTypesToCompile != TypeFlag::Auto)
+				remainingTypesToCompile = remainingTypesToCompile & ~typeToCheck;
+			finalTypes |= typeToCheck;
 		}
 	}
 
-	file.Release();
+	if (jobsOut.size() == jobCountBefore)
+	{
+		if (LaunchArguments::Contains(LaunchParams::logShaderDebug))
+			LOG_WARNING("No match of types in shader file! Path: {}", filePath.string());
+		file.Release();
+		return true;
+	}
+
+	filesOut.push_back(file);
+	return true;
+}
+
+bool RS::DX12::DXShader::CompileShaderParts(const std::vector<File>& files, const std::vector<CompileJob>& jobs,
+	const EntryPointsStringArray& entryPointStrings, const std::string& shaderPath, std::vector<PartData>& shaderPartsOut)
+{
+	// Each job writes to its own slot, which keeps the result in job order.
+	std::vector<std::optional<PartData>> results(jobs.size());
+	std::vector<std::string> errors(jobs.size());
+
+	ThreadPool::Get()->ParallelFor(jobs.size(), [&](uint64 jobIndex)
+		{
+			const CompileJob& job = jobs[jobIndex];
+			results[jobIndex] = CompileShaderPart(files[job.fileIndex], job.type, entryPointStrings, shaderPath, errors[jobIndex]);
+		}, s_CompileThreadCount);
+
+	uint32 failedCount = 0;
+	for (uint64 jobIndex = 0; jobIndex < jobs.size(); ++jobIndex)
+	{
+		if (!results[jobIndex].has_value())
+		{
+			LOG_ERROR("{}", errors[jobIndex]);
+			failedCount++;
+		}
+	}
 
-	if (result == 3 && LaunchArguments::Contains(LaunchParams::logShaderDebug))
-		LOG_WARNING("No match of types in shader file! Path: {}", filePath.string());
+	if (failedCount > 0)
+	{
+		LOG_ERROR("Failed to compile {} of {} shader parts! Path: {}", failedCount, jobs.size(), shaderPath);
+		for (std::optional<PartData>& result : results)
+		{
+			if (!result.has_value())
+				continue;
+			DX12_RELEASE(result->pPDBData);
+			DX12_RELEASE(result->pPDBPathFromCompiler);
+			DX12_RELEASE(result->pReflection);
+			DX12_RELEASE(result->pShaderObject);
+		}
+		return false;
+	}
 
-	return result != 0;
+	shaderPartsOut.reserve(shaderPartsOut.size() + results.size());
+	for (std::optional<PartData>& result : results)
+		shaderPartsOut.push_back(result.value());
+	return true;
 }
 
 RS::DX12::DXShader::TypeFlags RS::DX12::DXShader::GetShaderTypesFromFile(const File& file, const EntryPointsStringArray& entryPointStrings)
@@ -474,24 +584,23 @@ bool RS::DX12::DXShader::CheckIfOnlyOneTypeIsSet(TypeFlags type)
 }
 
 std::optional<RS::DX12::DXShader::PartData> RS::DX12::DXShader::CompileShaderPart(const File& file, TypeFlags type,
-	const EntryPointsStringArray& entryPointStrings, const std::string& shaderPath)
+	const EntryPointsStringArray& entryPointStrings, const std::string& shaderPath, std::string& errorOut)
 {
+	RS_PROFILE_SCOPE("Shader Compile Part");
+
 	std::string typeStr = TypesToString(type);
 	if (!CheckIfOnlyOneTypeIsSet(type))
 	{
-		LOG_ERROR("Cannot compile a shader part with multiple types! Types passed: {}, Path: {}", typeStr, shaderPath);
+		errorOut = Utils::Format("Cannot compile a shader part with multiple types! Types passed: {}, Path: {}", typeStr, shaderPath);
 		return {};
 	}
 
-	// These objects are not thread safe, create a speparate instance for each thread.
-	Microsoft::WRL::ComPtr<IDxcUtils> utils;
-	Microsoft::WRL::ComPtr<IDxcIncludeHandler> includeHandler;
-	Microsoft::WRL::ComPtr<IDxcCompiler3> pCompiler;
-	{ // TODO: Move this outside of here and in to an initialize function that all shaders uses. Shader library class?
-		DXCallVerbose(DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(utils.ReleaseAndGetAddressOf())));
-		DXCallVerbose(utils->CreateDefaultIncludeHandler(includeHandler.ReleaseAndGetAddressOf()));
-		DXCallVerbose(DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&pCompiler)));
-	}
+	_ShaderInternal::DXCInstance& dxc = _ShaderInternal::GetThreadDXCInstance();
+	IDxcUtils* utils = dxc.utils.Get();
+	IDxcCompiler3* pCompiler = dxc.pCompiler.Get();
+
+	// The handler records what it has included, so a new one is needed for each compilation.
+	DXCIncludeHandler includeHandler(utils);
 
 	std::filesystem::path path(file.name);
 	std::wstring directory = path.parent_path().wstring();
@@ -555,7 +664,7 @@ std::optional<RS::DX12::DXShader::PartData> RS::DX12::DXShader::CompileShaderPar
 	sourceBuffer.Encoding = 0;
 
 	ComPtr<IDxcResult> pCompileResult;
-	DXCall(pCompiler->Compile(&sourceBuffer, arguments.data(), (uint32)arguments.size(), includeHandler.Get(), IID_PPV_ARGS(pCompileResult.GetAddressOf())));
+	DXCall(pCompiler->Compile(&sourceBuffer, arguments.data(), (uint32)arguments.size(), &includeHandler, IID_PPV_ARGS(pCompileResult.GetAddressOf())));
 
 	{
 		HRESULT hr;
@@ -568,19 +677,20 @@ std::optional<RS::DX12::DXShader::PartData> RS::DX12::DXShader::CompileShaderPar
 		if (errorMsgs && errorMsgs->GetStringLength())
 		{
 			const char* compileErrors = (const char*)errorMsgs->GetStringPointer();
-			LOG_ERROR("Failed to compile shader part! Type: {}, Path: {}\nCompile returned HRESULT: {:#10x}, Errors/Warnings:\n{}", typeStr, file.name, hr, compileErrors);
+			errorOut = Utils::Format("Failed to compile shader part! Type: {}, Path: {}\nCompile returned HRESULT: {:#10x}, Errors/Warnings:\n{}", typeStr, file.name, hr, compileErrors);
 			return {};
 		}
 
 		if (FAILED(hr))
 		{
-			LOG_ERROR("Failed to compile shader! Type: {}, Path: {}", typeStr, file.name);
+			errorOut = Utils::Format("Failed to compile shader! Type: {}, Path: {}", typeStr, file.name);
 			return {};
 		}
 	}
 
 	PartData partData;
 	partData.type = type;
+	partData.includedFiles = includeHandler.GetIncludedFiles();
 
 	// Get shader object that should be passed to DX12.
 	DXCallVerbose(pCompileResult->GetOutput(DXC_OUT_OBJECT, IID_PPV_ARGS(&partData.pShaderObject), nullptr));
@@ -642,7 +752,8 @@ RS::DX12::DXShader::EntryPointsStringArray RS::DX12::DXShader::ConstructEntryPoi
 RS::DX12::DXShader::File RS::DX12::DXShader::ReadFile(const std::string& path, const std::vector<std::string>& defines)
 {
 	File file;
-	if (std::filesystem::exists(path) == false)
+	std::shared_ptr<VFSFile> pFile = VFS::Get()->Open(path);
+	if (!pFile)
 	{
 		LOG_ERROR("Shader file does not exist! Path: {}", path.c_str());
 		return file;
@@ -651,32 +762,20 @@ RS::DX12::DXShader::File RS::DX12::DXShader::ReadFile(const std::string& path, c
 	// For debug purposes.
 	file.name = path;
 
-	std::ifstream stream(path, std::ios::binary | std::ios::ate);
-	if (stream.is_open())
-	{
-		file.size = stream.tellg();
-		stream.seekg(0, std::ios::beg);
-
-		// Get defines string
-		std::string definesStr;
-		for (const std::string& define : defines)
-			definesStr += Utils::Format("#define {}\n", define);
-		uint64 defSize = definesStr.size();
-
-		file.pData = new uint8[defSize+file.size];
-		stream.read((char*)(file.pData+defSize), file.size);
+	// Get defines string
+	std::string definesStr;
+	for (const std::string& define : defines)
+		definesStr += Utils::Format("#define {}\n", define);
+	uint64 defSize = definesStr.size();
 
-		// Add defines string to data
-		RS_ASSERT(definesStr.copy((char*)file.pData, defSize, 0) == defSize);
-		file.size += defSize;
+	// The defines have to be in front of the source, so this is the one copy of the file.
+	file.size = pFile->GetSize();
+	file.pData = new uint8[defSize+file.size];
+	std::memcpy(file.pData+defSize, pFile->GetPtr(), file.size);
 
-		return file;
-	}
-	else
-	{
-		LOG_ERROR("Failed to read file!");
-		return file;
-	}
+	// Add defines string to data
+	RS_ASSERT(definesStr.copy((char*)file.pData, defSize, 0) == defSize);
+	file.size += defSize;
 
 	return file;
 }
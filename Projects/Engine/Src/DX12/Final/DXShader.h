@@ -4,6 +4,7 @@
 
 #include <dxcapi.h>
 #include <filesystem>
+#include <atomic>
 
 namespace RS::DX12
 {
@@ -37,6 +38,12 @@ namespace RS::DX12
 
 		static std::string GetDiskPathFromVirtualPath(const std::string& virtualPath, bool isInternal);
 
+		/*
+		* Limits how many threads that are used when compiling the parts of a shader. 0 uses every thread in the ThreadPool, 1 compiles on the calling thread.
+		*/
+		static void SetCompileThreadCount(uint threadCount) { s_CompileThreadCount = threadCount; }
+		static uint GetCompileThreadCount() { return s_CompileThreadCount; }
+
 		/*
 		* If succeeds, it will create the shader. If not, it will keep the state as it were before calling Create!
 		*/
@@ -60,6 +67,11 @@ namespace RS::DX12
 
 		TypeFlag GetTypes() const { return m_Types; }
 
+		/*
+		* All files that were included when compiling the parts, used to hot reload the shader when an include file changes.
+		*/
+		std::vector<std::string> GetIncludedFiles();
+
 	private:
 		struct PartData
 		{
@@ -68,6 +80,7 @@ namespace RS::DX12
 			ID3D12ShaderReflection* pReflection = nullptr;
 			IDxcBlob* pPDBData = nullptr;
 			IDxcBlobUtf16* pPDBPathFromCompiler = nullptr;
+			std::vector<std::string> includedFiles;
 		};
 
 		struct File
@@ -85,12 +98,31 @@ namespace RS::DX12
 			}
 		};
 
+		// One shader part to compile, fileIndex points into the files that were gathered.
+		struct CompileJob
+		{
+			uint32		fileIndex = 0;
+			TypeFlags	type = TypeFlag::NONE;
+		};
+
 		using EntryPointsStringArray = std::array<std::string, TypeFlag::COUNT - 1>;
 
-		bool CreateShaderPartsFromFile(const std::filesystem::path& filePath, TypeFlags& remainingTypesToCompile,
+		/*
+		* Reads the shader files and finds which parts to compile. Nothing is compiled here, the parts are returned as jobs instead.
+		*/
+		static bool GatherShaderParts(const std::string& shaderPath, const Description& description, const EntryPointsStringArray& entryPointStrings,
+			TypeFlags& typesOut, std::vector<File>& filesOut, std::vector<CompileJob>& jobsOut);
+		static bool GatherShaderPartsFromFile(const std::filesystem::path& filePath, TypeFlags& remainingTypesToCompile,
 			TypeFlags& finalTypes, TypeFlags& totalTypesSeen, bool isTheOnlyFile,
 			const EntryPointsStringArray& entryPointStrings, const std::string& shaderPath,
-			std::vector<PartData>& shaderPartsOut, const std::vector<std::string>& defines);
+			std::vector<File>& filesOut, std::vector<CompileJob>& jobsOut, const std::vector<std::string>& defines);
+
+		/*
+		* Compiles the jobs in parallel. The parts are returned in the same order as the jobs, no matter which thread finished first.
+		* If any of the parts fails, all parts are released and false is returned.
+		*/
+		static bool CompileShaderParts(const std::vector<File>& files, const std::vector<CompileJob>& jobs,
+			const EntryPointsStringArray& entryPointStrings, const std::string& shaderPath, std::vector<PartData>& shaderPartsOut);
 
 		/*
 		* Parse file to find the entry points. It will use the default entry points if not a custom one was specified.
@@ -102,7 +134,7 @@ namespace RS::DX12
 		static bool ValidateShaderTypesMatches(TypeFlags remainingTypesToCompile, TypeFlags finalTypes, TypeFlags totalTypesSeen, const std::string& shaderPath);
 		static bool CheckValidExtension(const std::filesystem::path& path);
 		static bool CheckIfOnlyOneTypeIsSet(TypeFlags types);
-		static std::optional<PartData> CompileShaderPart(const File& file, TypeFlags type, const EntryPointsStringArray& entryPointStrings, const std::string& shaderPath);
+		static std::optional<PartData> CompileShaderPart(const File& file, TypeFlags type, const EntryPointsStringArray& entryPointStrings, const std::string& shaderPath, std::string& errorOut);
 
 		static EntryPointsStringArray ConstructEntryPointsArray(const std::vector<std::pair<TypeFlags, std::string>>& customEntryPoints);
 
@@ -122,5 +154,7 @@ namespace RS::DX12
 
 		// Temp data
 		EntryPointsStringArray m_EntryPointStrings;
+
+		inline static std::atomic<uint> s_CompileThreadCount = 0;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,87 @@
+#include "PreCompiled.h"
+#include "DXShaderDependencyGraph.h"
+
+#include <filesystem>
+
+std::shared_ptr<RS::DX12::DXShaderDependencyGraph> RS::DX12::DXShaderDependencyGraph::Get()
+{
+	static std::shared_ptr<DXShaderDependencyGraph> s_DependencyGraph = std::make_shared<DXShaderDependencyGraph>();
+	return s_DependencyGraph;
+}
+
+void RS::DX12::DXShaderDependencyGraph::SetDependencies(const std::string& shaderPath, const std::vector<std::string>& includePaths)
+{
+	std::string shader = NormalizePath(shaderPath);
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	RemoveShaderInternal(shader);
+
+	std::set<std::string>& dependencies = m_Dependencies[shader];
+	for (const std::string& includePath : includePaths)
+	{
+		std::string include = NormalizePath(includePath);
+		if (include == shader)
+			continue;
+
+		dependencies.insert(include);
+		m_Dependents[include].insert(shader);
+	}
+	m_Version++;
+}
+
+void RS::DX12::DXShaderDependencyGraph::RemoveShader(const std::string& shaderPath)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	RemoveShaderInternal(NormalizePath(shaderPath));
+	m_Version++;
+}
+
+void RS::DX12::DXShaderDependencyGraph::Clear()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Dependencies.clear();
+	m_Dependents.clear();
+	m_Version++;
+}
+
+std::vector<std::string> RS::DX12::DXShaderDependencyGraph::GetDependencies(const std::string& shaderPath) const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	auto it = m_Dependencies.find(NormalizePath(shaderPath));
+	if (it == m_Dependencies.end())
+		return {};
+	return std::vector<std::string>(it->second.begin(), it->second.end());
+}
+
+std::vector<std::string> RS::DX12::DXShaderDependencyGraph::GetDependents(const std::string& includePath) const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	auto it = m_Dependents.find(NormalizePath(includePath));
+	if (it == m_Dependents.end())
+		return {};
+	return std::vector<std::string>(it->second.begin(), it->second.end());
+}
+
+std::string RS::DX12::DXShaderDependencyGraph::NormalizePath(const std::string& path)
+{
+	return std::filesystem::path(path).lexically_normal().generic_string();
+}
+
+void RS::DX12::DXShaderDependencyGraph::RemoveShaderInternal(const std::string& normalizedShaderPath)
+{
+	auto it = m_Dependencies.find(normalizedShaderPath);
+	if (it == m_Dependencies.end())
+		return;
+
+	for (const std::string& include : it->second)
+	{
+		auto dependentIt = m_Dependents.find(include);
+		if (dependentIt == m_Dependents.end())
+			continue;
+
+		dependentIt->second.erase(normalizedShaderPath);
+		if (dependentIt->second.empty())
+			m_Dependents.erase(dependentIt);
+	}
+	m_Dependencies.erase(it);
+}
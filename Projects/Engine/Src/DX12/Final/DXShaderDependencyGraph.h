@@ -0,0 +1,52 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <set>
+#include <unordered_map>
+
+namespace RS::DX12
+{
+	/*
+	* Keeps track of which files each shader includes and the reverse, which shaders that include a file.
+	* The hot reloading uses it to only recompile the shaders that are affected when an include file changes.
+	* Paths are normalized, so "Core/./A.hlsli" and "Core/A.hlsli" are the same file.
+	*/
+	class DXShaderDependencyGraph
+	{
+	public:
+		DXShaderDependencyGraph() = default;
+		~DXShaderDependencyGraph() = default;
+		RS_NO_COPY_AND_MOVE(DXShaderDependencyGraph)
+
+		static std::shared_ptr<DXShaderDependencyGraph> Get();
+
+		/*
+		* Replaces the include set of the shader. The includes are expected to be the full (transitive) set.
+		*/
+		void SetDependencies(const std::string& shaderPath, const std::vector<std::string>& includePaths);
+		void RemoveShader(const std::string& shaderPath);
+		void Clear();
+
+		// Files that the shader includes.
+		std::vector<std::string> GetDependencies(const std::string& shaderPath) const;
+		// Shaders that include the file.
+		std::vector<std::string> GetDependents(const std::string& includePath) const;
+
+		/*
+		* Increases each time the graph changes. Can be used to check if the dependencies need to be fetched again.
+		*/
+		uint64 GetVersion() const { return m_Version; }
+
+		static std::string NormalizePath(const std::string& path);
+
+	private:
+		void RemoveShaderInternal(const std::string& normalizedShaderPath);
+
+	private:
+		mutable std::mutex m_Mutex;
+		std::unordered_map<std::string, std::set<std::string>> m_Dependencies; // Shader -> Includes
+		std::unordered_map<std::string, std::set<std::string>> m_Dependents; // Include -> Shaders
+		std::atomic<uint64> m_Version = 0;
+	};
+}
@@ -2,6 +2,8 @@
 #include "DXTexture.h"
 
 #include "DX12/Final/DXCore.h"
+#include "Core/VFS.h"
+#include "Loaders/Texture/DDSFile.h"
 #include "DX12/Final/DXCommandContext.h" // TODO: Should not include this here. We most likely want the command context to take in DXTexture!
 
 namespace RS::DX12::DXTexture_Private
@@ -10,6 +12,18 @@ namespace RS::DX12::DXTexture_Private
     {
         return (UINT)BitsPerPixel(Format) / 8;
     };
+
+    static DXGI_FORMAT ToSRGB(DXGI_FORMAT Format)
+    {
+        switch (Format)
+        {
+        case DXGI_FORMAT_R8G8B8A8_UNORM: return DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+        case DXGI_FORMAT_BC1_UNORM: return DXGI_FORMAT_BC1_UNORM_SRGB;
+        case DXGI_FORMAT_BC3_UNORM: return DXGI_FORMAT_BC3_UNORM_SRGB;
+        case DXGI_FORMAT_BC7_UNORM: return DXGI_FORMAT_BC7_UNORM_SRGB;
+        default: return Format;
+        }
+    }
 }
 
 void RS::DX12::DXTexture::Create2D(size_t RowPitchBytes, size_t Width, size_t Height, DXGI_FORMAT Format, const void* InitialData)
@@ -168,15 +182,133 @@ void RS::DX12::DXTexture::CreateTGAFromMemory(const void* pMemBuffer, size_t fil
 
 bool RS::DX12::DXTexture::CreateDDSFromMemory(const void* memBuffer, size_t fileSize, bool sRGB)
 {
-    RS_ASSERT(false, "Not implemented!");
-    //if (m_hCpuDescriptorHandle.ptr == D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN)
-    //    m_hCpuDescriptorHandle = AllocateDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-    //
-    //HRESULT hr = CreateDDSTextureFromMemory(Graphics::g_Device,
-    //    (const uint8_t*)filePtr, fileSize, 0, sRGB, &m_pResource, m_hCpuDescriptorHandle);
-    //
-    //return SUCCEEDED(hr);
-    return false;
+    DDSTexture dds;
+    if (!DDSFile::Parse(std::span<const uint8>((const uint8*)memBuffer, fileSize), dds))
+        return false;
+
+    if (DDSFile::IsBlockCompressed(dds.dxgiFormat) && (dds.width % 4 != 0 || dds.height % 4 != 0))
+    {
+        LOG_ERROR("Block compressed DDS texture is {}x{}, it has to be a multiple of 4. Cook it again.", dds.width, dds.height);
+        return false;
+    }
+
+    DXGI_FORMAT Format = (DXGI_FORMAT)dds.dxgiFormat;
+    if (sRGB)
+        Format = DXTexture_Private::ToSRGB(Format);
+
+    Destroy();
+
+    m_UsageState = D3D12_RESOURCE_STATE_COPY_DEST;
+
+    m_Width = dds.width;
+    m_Height = dds.height;
+    m_Depth = 1;
+
+    D3D12_RESOURCE_DESC texDesc = {};
+    texDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+    texDesc.Width = dds.width;
+    texDesc.Height = dds.height;
+    texDesc.DepthOrArraySize = 1;
+    texDesc.MipLevels = (UINT16)dds.mips.size();
+    texDesc.Format = Format;
+    texDesc.SampleDesc.Count = 1;
+    texDesc.SampleDesc.Quality = 0;
+    texDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+    texDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+    D3D12_HEAP_PROPERTIES HeapProps;
+    HeapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
+    HeapProps.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+    HeapProps.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+    HeapProps.CreationNodeMask = 1;
+    HeapProps.VisibleNodeMask = 1;
+
+    DXCall(DXCore::GetDevice()->CreateCommittedResource(&HeapProps, D3D12_HEAP_FLAG_NONE, &texDesc,
+        m_UsageState, nullptr, IID_PPV_ARGS(m_pResource.ReleaseAndGetAddressOf())));
+    m_Alive = true;
+
+    m_pResource->SetName(L"Texture");
+
+    // The mips point straight into the file, UpdateSubresources copies them into upload memory with no other copy in between.
+    std::vector<D3D12_SUBRESOURCE_DATA> subresources(dds.mips.size());
+    for (size_t i = 0; i < dds.mips.size(); ++i)
+    {
+        subresources[i].pData = dds.mips[i].data.data();
+        subresources[i].RowPitch = (LONG_PTR)dds.mips[i].rowPitch;
+        subresources[i].SlicePitch = (LONG_PTR)dds.mips[i].data.size();
+    }
+
+    DXCommandContext::InitializeTexture(*this, (UINT)subresources.size(), subresources.data());
+
+    if (m_hCpuDescriptorHandle.ptr == D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN)
+        m_hCpuDescriptorHandle = DXCore::AllocateDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    DXCore::GetDevice()->CreateShaderResourceView(m_pResource.Get(), nullptr, m_hCpuDescriptorHandle);
+    return true;
+}
+
+bool RS::DX12::DXTexture::CreateDDSFromFile(const std::string& path, bool sRGB)
+{
+    std::shared_ptr<VFSFile> pFile = VFS::Get()->Open(path);
+    if (!pFile)
+    {
+        LOG_ERROR("Failed to open texture {}!", path.c_str());
+        return false;
+    }
+
+    return CreateDDSFromMemory(pFile->GetPtr(), pFile->GetSize(), sRGB);
+}
+
+uint64_t RS::DX12::DXTexture::CreateStreamed(size_t Width, size_t Height, DXGI_FORMAT Format, uint32_t MipCount, uint32_t FirstMip, UINT NumNewMips, D3D12_SUBRESOURCE_DATA NewMips[],
+    Microsoft::WRL::ComPtr<ID3D12Resource>& pOldResourceOut)
+{
+    RS_ASSERT(FirstMip < MipCount, "A streamed texture needs at least one mip!");
+
+    // The copy source of the mips that stay, it is handed to the caller instead of being freed.
+    std::unique_ptr<DXGPUResource> pOldResource;
+    if (m_pResource)
+        pOldResource = std::make_unique<DXGPUResource>(m_pResource.Get(), m_UsageState);
+    const uint32_t OldFirstMip = m_FirstMip;
+
+    m_UsageState = D3D12_RESOURCE_STATE_COPY_DEST;
+
+    m_Width = std::max(1u, (uint32_t)Width >> FirstMip);
+    m_Height = std::max(1u, (uint32_t)Height >> FirstMip);
+    m_Depth = 1;
+    m_FirstMip = FirstMip;
+
+    D3D12_RESOURCE_DESC texDesc = {};
+    texDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+    texDesc.Width = m_Width;
+    texDesc.Height = m_Height;
+    texDesc.DepthOrArraySize = 1;
+    texDesc.MipLevels = (UINT16)(MipCount - FirstMip);
+    texDesc.Format = Format;
+    texDesc.SampleDesc.Count = 1;
+    texDesc.SampleDesc.Quality = 0;
+    texDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+    texDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+    D3D12_HEAP_PROPERTIES HeapProps;
+    HeapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
+    HeapProps.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+    HeapProps.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+    HeapProps.CreationNodeMask = 1;
+    HeapProps.VisibleNodeMask = 1;
+
+    DXCall(DXCore::GetDevice()->CreateCommittedResource(&HeapProps, D3D12_HEAP_FLAG_NONE, &texDesc,
+        m_UsageState, nullptr, IID_PPV_ARGS(m_pResource.ReleaseAndGetAddressOf())));
+    m_Alive = true;
+    ++m_VersionID;
+
+    m_pResource->SetName(L"Streamed Texture");
+
+    const uint64_t FenceValue = DXCommandContext::InitializeTextureMips(*this, NumNewMips, NewMips, pOldResource.get(), FirstMip + NumNewMips - OldFirstMip);
+    pOldResourceOut = pOldResource ? pOldResource->Detach() : nullptr;
+
+    if (m_hCpuDescriptorHandle.ptr == D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN)
+        m_hCpuDescriptorHandle = DXCore::AllocateDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    DXCore::GetDevice()->CreateShaderResourceView(m_pResource.Get(), nullptr, m_hCpuDescriptorHandle);
+    return FenceValue;
 }
 
 void RS::DX12::DXTexture::CreatePIXImageFromMemory(const void* memBuffer, size_t fileSize)
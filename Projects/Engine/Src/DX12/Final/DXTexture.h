@@ -33,7 +33,14 @@ namespace RS::DX12
         void CreateCube(size_t RowPitchBytes, size_t Width, size_t Height, DXGI_FORMAT Format, const void* InitialData);
 
         void CreateTGAFromMemory(const void* memBuffer, size_t fileSize, bool sRGB);
+        // Cooked textures from the TextureCooker, with all mips in the file. sRGB picks the sRGB view of a UNORM format.
         bool CreateDDSFromMemory(const void* memBuffer, size_t fileSize, bool sRGB);
+        bool CreateDDSFromFile(const std::string& path, bool sRGB);
+        // Streaming: the resource only holds mips [FirstMip, MipCount) of a Width x Height texture. The mips it already has are copied over
+        // from the previous resource, NewMips are the ones in front of them. The SRV keeps its descriptor.
+        // Nothing waits for the upload. The previous resource is moved to pOldResourceOut and has to be kept until the returned fence value completes.
+        uint64_t CreateStreamed(size_t Width, size_t Height, DXGI_FORMAT Format, uint32_t MipCount, uint32_t FirstMip, UINT NumNewMips, D3D12_SUBRESOURCE_DATA NewMips[],
+            Microsoft::WRL::ComPtr<ID3D12Resource>& pOldResourceOut);
         void CreatePIXImageFromMemory(const void* memBuffer, size_t fileSize);
 
         virtual void Destroy() override
@@ -47,12 +54,14 @@ namespace RS::DX12
         uint32_t GetWidth() const { return m_Width; }
         uint32_t GetHeight() const { return m_Height; }
         uint32_t GetDepth() const { return m_Depth; }
+        uint32_t GetFirstMip() const { return m_FirstMip; }
 
     protected:
 
         uint32_t m_Width;
         uint32_t m_Height;
         uint32_t m_Depth;
+        uint32_t m_FirstMip = 0;
 
         D3D12_CPU_DESCRIPTOR_HANDLE m_hCpuDescriptorHandle;
     };
@@ -0,0 +1,80 @@
+#include "PreCompiled.h"
+#include "DXTextureStreamingDevice.h"
+
+#include "DX12/Final/DXCore.h"
+#include "Loaders/Texture/DDSFile.h"
+
+RS::DX12::DXTextureStreamingDevice::~DXTextureStreamingDevice()
+{
+	// The resources can still be read by a copy, the GPU has to be done before they are released.
+	if (!m_RetiredResources.empty())
+		DXCore::GetCommandListManager()->WaitForFence(m_RetiredResources.back().fenceValue);
+}
+
+void RS::DX12::DXTextureStreamingDevice::BeginUpdate()
+{
+	// Retired in submission order, so the fence values only grow.
+	auto it = m_RetiredResources.begin();
+	while (it != m_RetiredResources.end() && DXCore::GetCommandListManager()->IsFenceComplete(it->fenceValue))
+		++it;
+	m_RetiredResources.erase(m_RetiredResources.begin(), it);
+}
+
+void RS::DX12::DXTextureStreamingDevice::CreateTexture(StreamedTextureID id, const StreamedTextureInfo& info)
+{
+	Texture& texture = m_Textures[id];
+	texture.info = info;
+	texture.pTexture = std::make_shared<DXTexture>();
+}
+
+void RS::DX12::DXTextureStreamingDevice::UploadMips(StreamedTextureID id, uint32 firstMip, const std::vector<std::vector<uint8>>& mips)
+{
+	auto it = m_Textures.find(id);
+	RS_ASSERT(it != m_Textures.end(), "Streamed texture {} does not exist!", id);
+
+	const StreamedTextureInfo& info = it->second.info;
+	std::vector<D3D12_SUBRESOURCE_DATA> subresources(mips.size());
+	for (uint32 i = 0; i < (uint32)mips.size(); ++i)
+	{
+		const DDSTexture::Mip layout = DDSFile::GetMipLayout(info.width, info.height, info.format, firstMip + i);
+		subresources[i].pData = mips[i].data();
+		subresources[i].RowPitch = (LONG_PTR)layout.rowPitch;
+		subresources[i].SlicePitch = (LONG_PTR)mips[i].size();
+	}
+
+	Microsoft::WRL::ComPtr<ID3D12Resource> pOldResource;
+	const uint64 fenceValue = it->second.pTexture->CreateStreamed(info.width, info.height, (DXGI_FORMAT)info.format, (uint32)info.mipSizes.size(), firstMip,
+		(UINT)subresources.size(), subresources.data(), pOldResource);
+	Retire(pOldResource, fenceValue);
+}
+
+void RS::DX12::DXTextureStreamingDevice::EvictMips(StreamedTextureID id, uint32 firstMip)
+{
+	auto it = m_Textures.find(id);
+	RS_ASSERT(it != m_Textures.end(), "Streamed texture {} does not exist!", id);
+
+	const StreamedTextureInfo& info = it->second.info;
+	Microsoft::WRL::ComPtr<ID3D12Resource> pOldResource;
+	const uint64 fenceValue = it->second.pTexture->CreateStreamed(info.width, info.height, (DXGI_FORMAT)info.format, (uint32)info.mipSizes.size(), firstMip,
+		0, nullptr, pOldResource);
+	Retire(pOldResource, fenceValue);
+}
+
+void RS::DX12::DXTextureStreamingDevice::DestroyTexture(StreamedTextureID id)
+{
+	m_Textures.erase(id);
+}
+
+void RS::DX12::DXTextureStreamingDevice::Retire(Microsoft::WRL::ComPtr<ID3D12Resource> pResource, uint64 fenceValue)
+{
+	if (pResource)
+		m_RetiredResources.push_back(RetiredResource{ .pResource = std::move(pResource), .fenceValue = fenceValue });
+}
+
+std::shared_ptr<RS::DX12::DXTexture> RS::DX12::DXTextureStreamingDevice::GetTexture(StreamedTextureID id) const
+{
+	auto it = m_Textures.find(id);
+	if (it == m_Textures.end() || !it->second.pTexture->IsValid())
+		return nullptr;
+	return it->second.pTexture;
+}
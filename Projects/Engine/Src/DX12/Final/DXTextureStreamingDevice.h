@@ -0,0 +1,47 @@
+#pragma once
+
+#include "DX12/Final/DXTexture.h"
+#include "Render/TextureStreamer.h"
+
+#include <unordered_map>
+
+namespace RS::DX12
+{
+	/*
+	* Streamed textures for the TextureStreamer. Each texture is a committed resource with only the resident mips, it is created again
+	* when the resident range changes so that evicted mips give their memory back. The DXTexture and its SRV stay the same.
+	* Uploads are not waited for, the replaced resources are released once the fence of the copy out of them has completed.
+	*/
+	class DXTextureStreamingDevice : public ITextureStreamingDevice
+	{
+	public:
+		~DXTextureStreamingDevice();
+
+		void BeginUpdate() override;
+		void CreateTexture(StreamedTextureID id, const StreamedTextureInfo& info) override;
+		void UploadMips(StreamedTextureID id, uint32 firstMip, const std::vector<std::vector<uint8>>& mips) override;
+		void EvictMips(StreamedTextureID id, uint32 firstMip) override;
+		void DestroyTexture(StreamedTextureID id) override;
+
+		// nullptr until the mip tail has been uploaded.
+		std::shared_ptr<DXTexture> GetTexture(StreamedTextureID id) const;
+
+	private:
+		void Retire(Microsoft::WRL::ComPtr<ID3D12Resource> pResource, uint64 fenceValue);
+
+	private:
+		struct Texture
+		{
+			StreamedTextureInfo info;
+			std::shared_ptr<DXTexture> pTexture;
+		};
+		std::unordered_map<StreamedTextureID, Texture> m_Textures;
+
+		struct RetiredResource
+		{
+			Microsoft::WRL::ComPtr<ID3D12Resource> pResource;
+			uint64 fenceValue;
+		};
+		std::vector<RetiredResource> m_RetiredResources;
+	};
+}
@@ -3,6 +3,9 @@
 
 #include "Utils/Utils.h"
 #include "Core/LaunchArguments.h"
+#include "Core/Profiler.h"
+#include "Core/VFS.h"
+#include "DX12/DXCIncludeHandler.h"
 
 #include <fstream>
 #include <sstream>
@@ -63,6 +66,8 @@ RS::Shader::~Shader()
 
 bool RS::Shader::Create(const Description& description)
 {
+	RS_PROFILE_SCOPE("Shader Create");
+
 	if (!ValidateShaderTypes(description.typeFlags))
 		return false;
 
@@ -106,7 +111,7 @@ bool RS::Shader::Create(const Description& description)
 	}
 	else if (path.extension().empty() == false) // Single file.
 	{
-		if (std::filesystem::exists(path))
+		if (VFS::Get()->Exists(path.string()))
 		{
 			if (!CreateShaderPartsFromFile(path, remainingTypesToCompile,
 				types, totalTypesSeen, true, entryPointsStringArray, shaderPath, shaderParts))
@@ -470,6 +475,8 @@ bool RS::Shader::CheckIfOnlyOneTypeIsSet(TypeFlags type)
 std::optional<RS::Shader::PartData> RS::Shader::CompileShaderPart(const File& file, TypeFlags type,
 	const EntryPointsStringArray& entryPointStrings, const std::string& shaderPath)
 {
+	RS_PROFILE_SCOPE("Shader Compile Part");
+
 	std::string typeStr = TypesToString(type);
 	if (!CheckIfOnlyOneTypeIsSet(type))
 	{
@@ -479,14 +486,14 @@ std::optional<RS::Shader::PartData> RS::Shader::CompileShaderPart(const File& fi
 
 	// These objects are not thread safe, create a speparate instance for each thread.
 	Microsoft::WRL::ComPtr<IDxcUtils> utils;
-	Microsoft::WRL::ComPtr<IDxcIncludeHandler> includeHandler;
 	Microsoft::WRL::ComPtr<IDxcCompiler3> pCompiler;
 	{ // TODO: Move this outside of here and in to an initialize function that all shaders uses. Shader library class?
 		DXCallVerbose(DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(utils.ReleaseAndGetAddressOf())));
-		DXCallVerbose(utils->CreateDefaultIncludeHandler(includeHandler.ReleaseAndGetAddressOf()));
 		DXCallVerbose(DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&pCompiler)));
 	}
+	DXCIncludeHandler includeHandler(utils.Get());
 
+	std::wstring directory = std::filesystem::path(file.name).parent_path().wstring();
 	std::wstring sourceName = file.name.empty() ? L"" : Utils::ToWString(file.name);
 	std::wstring entryPoint = L"Main";
 	std::wstring version = L"6_0";
@@ -523,6 +530,9 @@ std::optional<RS::Shader::PartData> RS::Shader::CompileShaderPart(const File& fi
 	//arguments.push_back(L"<reflectionPath>");
 	arguments.push_back(DXC_ARG_PACK_MATRIX_ROW_MAJOR); //-Zp
 
+	arguments.push_back(L"-I");
+	arguments.push_back(directory.c_str());
+
 	if (!file.name.empty())
 	{
 		arguments.push_back(DXC_ARG_DEBUG_NAME_FOR_SOURCE);
@@ -544,7 +554,7 @@ std::optional<RS::Shader::PartData> RS::Shader::CompileShaderPart(const File& fi
 	sourceBuffer.Encoding = 0;
 
 	ComPtr<IDxcResult> pCompileResult;
-	DXCall(pCompiler->Compile(&sourceBuffer, arguments.data(), (uint32)arguments.size(), includeHandler.Get(), IID_PPV_ARGS(pCompileResult.GetAddressOf())));
+	DXCall(pCompiler->Compile(&sourceBuffer, arguments.data(), (uint32)arguments.size(), &includeHandler, IID_PPV_ARGS(pCompileResult.GetAddressOf())));
 
 	{
 		HRESULT hr;
@@ -631,7 +641,8 @@ RS::Shader::EntryPointsStringArray RS::Shader::ConstructEntryPointsArray(const s
 RS::Shader::File RS::Shader::ReadFile(const std::string& path)
 {
 	File file;
-	if (std::filesystem::exists(path) == false)
+	std::shared_ptr<VFSFile> pFile = VFS::Get()->Open(path);
+	if (!pFile)
 	{
 		LOG_ERROR("Shader file does not exist! Path: {}", path.c_str());
 		return file;
@@ -640,22 +651,9 @@ RS::Shader::File RS::Shader::ReadFile(const std::string& path)
 	// For debug purposes.
 	file.name = path;
 
-	std::ifstream stream(path, std::ios::binary | std::ios::ate);
-	if (stream.is_open())
-	{
-		file.size = stream.tellg();
-		stream.seekg(0, std::ios::beg);
-
-		file.pData = new uint8[file.size];
-		stream.read((char*)file.pData, file.size);
-		return file;
-	}
-	else
-	{
-		LOG_ERROR("Failed to read file!");
-		return file;
-	}
-
+	file.size = pFile->GetSize();
+	file.pData = new uint8[file.size];
+	std::memcpy(file.pData, pFile->GetPtr(), file.size);
 	return file;
 }
 
@@ -0,0 +1,348 @@
+#include "PreCompiled.h"
+#include "EntityStore.h"
+
+#include <algorithm>
+#include <new>
+
+namespace RS::ECS::_EntityStoreInternal
+{
+	// Each array in a chunk starts on its own cache line.
+	constexpr uint32 ArrayAlignment = 64;
+
+	struct ComponentInfo
+	{
+		uint32 size;
+	};
+
+	std::mutex g_ComponentInfoMutex;
+	std::vector<ComponentInfo> g_ComponentInfos;
+
+	ComponentInfo GetComponentInfo(ComponentID id)
+	{
+		std::lock_guard<std::mutex> lock(g_ComponentInfoMutex);
+		return g_ComponentInfos[id];
+	}
+
+	uint32 AlignUp(uint32 value, uint32 alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+}
+
+RS::ECS::ComponentID RS::ECS::_EntityStoreInternal::RegisterComponent(uint32 size, uint32 alignment)
+{
+	std::lock_guard<std::mutex> lock(g_ComponentInfoMutex);
+	RS_ASSERT(g_ComponentInfos.size() < MaxComponentTypes, "Too many component types, only {} are supported!", MaxComponentTypes);
+	RS_ASSERT(alignment <= ArrayAlignment, "Components cannot be aligned to more than {} bytes!", ArrayAlignment);
+
+	g_ComponentInfos.push_back({ size });
+	return (ComponentID)(g_ComponentInfos.size() - 1);
+}
+
+uint64 RS::ECS::EntityStoreSnapshot::GetSize() const
+{
+	return m_RowCounts.size() * EntityStore::ChunkSize + m_Slots.size() * sizeof(_EntityStoreInternal::Slot) + m_FreeSlots.size() * sizeof(uint32);
+}
+
+RS::ECS::EntityStore::~EntityStore()
+{
+	FreeChunks();
+}
+
+bool RS::ECS::EntityStore::Destroy(EntityHandle entity)
+{
+	using namespace _EntityStoreInternal;
+
+	RS_ASSERT(m_IterationDepth == 0, "Entities cannot be destroyed while iterating, use QueueDestroy!");
+	if (!IsAlive(entity))
+		return false;
+
+	Slot& slot = m_Slots[entity.index];
+	Archetype& archetype = *m_Archetypes[slot.archetype];
+	Chunk& chunk = archetype.chunks[slot.chunk];
+	Chunk& lastChunk = archetype.chunks.back();
+	const uint32 lastRow = lastChunk.m_Count - 1;
+
+	// Fill the hole with the last entity of the archetype, which keeps the arrays packed.
+	if (&chunk != &lastChunk || slot.row != lastRow)
+	{
+		for (const Column& column : archetype.columns)
+		{
+			uint8* pDst = chunk.m_pData + column.offset + (uint64)slot.row * column.size;
+			const uint8* pSrc = lastChunk.m_pData + column.offset + (uint64)lastRow * column.size;
+			std::memcpy(pDst, pSrc, column.size);
+		}
+
+		Slot& movedSlot = m_Slots[lastChunk.GetEntities()[lastRow].index];
+		movedSlot.chunk = slot.chunk;
+		movedSlot.row = slot.row;
+	}
+
+	--lastChunk.m_Count;
+	--archetype.count;
+	--m_Count;
+	if (lastChunk.m_Count == 0)
+	{
+		FreeChunk(lastChunk);
+		archetype.chunks.pop_back();
+	}
+
+	++slot.generation;
+	slot.archetype = ~0u;
+	m_FreeSlots.push_back(entity.index);
+	return true;
+}
+
+void RS::ECS::EntityStore::QueueDestroy(EntityHandle entity)
+{
+	std::lock_guard<std::mutex> lock(m_DestroyQueueMutex);
+	m_DestroyQueue.push_back(entity);
+}
+
+uint64 RS::ECS::EntityStore::FlushDestroyed(const std::function<void(EntityHandle)>& onDestroy)
+{
+	std::vector<EntityHandle> queue;
+	{
+		std::lock_guard<std::mutex> lock(m_DestroyQueueMutex);
+		queue.swap(m_DestroyQueue);
+	}
+
+	// Sorted, so the order of the entities afterwards does not depend on which thread queued first.
+	std::sort(queue.begin(), queue.end(), [](EntityHandle a, EntityHandle b) { return a.index < b.index; });
+
+	uint64 destroyedCount = 0;
+	for (EntityHandle entity : queue)
+	{
+		if (!IsAlive(entity))
+			continue;
+
+		if (onDestroy)
+			onDestroy(entity);
+		Destroy(entity);
+		++destroyedCount;
+	}
+
+	return destroyedCount;
+}
+
+void RS::ECS::EntityStore::Clear()
+{
+	RS_ASSERT(m_IterationDepth == 0, "Entities cannot be destroyed while iterating!");
+
+	FreeChunks();
+
+	for (uint32 index = 0; index < (uint32)m_Slots.size(); ++index)
+	{
+		Slot& slot = m_Slots[index];
+		if (slot.archetype == ~0u)
+			continue;
+
+		++slot.generation;
+		slot.archetype = ~0u;
+		m_FreeSlots.push_back(index);
+	}
+	m_Count = 0;
+
+	std::lock_guard<std::mutex> lock(m_DestroyQueueMutex);
+	m_DestroyQueue.clear();
+}
+
+bool RS::ECS::EntityStore::IsAlive(EntityHandle entity) const
+{
+	return entity.index < (uint32)m_Slots.size() && m_Slots[entity.index].generation == entity.generation && m_Slots[entity.index].archetype != ~0u;
+}
+
+void RS::ECS::EntityStore::SaveSnapshot(EntityStoreSnapshot& snapshot) const
+{
+	RS_ASSERT(m_IterationDepth == 0, "A snapshot cannot be saved while iterating!");
+
+	snapshot.m_pStore = this;
+	snapshot.m_ChunkCounts.clear();
+	snapshot.m_RowCounts.clear();
+	for (const std::unique_ptr<_EntityStoreInternal::Archetype>& pArchetype : m_Archetypes)
+	{
+		snapshot.m_ChunkCounts.push_back((uint32)pArchetype->chunks.size());
+		for (const Chunk& chunk : pArchetype->chunks)
+			snapshot.m_RowCounts.push_back(chunk.m_Count);
+	}
+
+	// Only grows, resize would clear the bytes it adds for nothing.
+	const uint64 size = (uint64)snapshot.m_RowCounts.size() * ChunkSize;
+	if (snapshot.m_Chunks.size() < size)
+		snapshot.m_Chunks.resize(size);
+
+	uint8* pDst = snapshot.m_Chunks.data();
+	for (const std::unique_ptr<_EntityStoreInternal::Archetype>& pArchetype : m_Archetypes)
+	{
+		for (const Chunk& chunk : pArchetype->chunks)
+		{
+			std::memcpy(pDst, chunk.m_pData, ChunkSize);
+			pDst += ChunkSize;
+		}
+	}
+
+	snapshot.m_Slots = m_Slots;
+	snapshot.m_FreeSlots = m_FreeSlots;
+	snapshot.m_Count = m_Count;
+}
+
+void RS::ECS::EntityStore::LoadSnapshot(const EntityStoreSnapshot& snapshot)
+{
+	using namespace _EntityStoreInternal;
+
+	RS_ASSERT(m_IterationDepth == 0, "A snapshot cannot be loaded while iterating!");
+	RS_ASSERT(snapshot.m_pStore == this, "The snapshot was saved from another entity store!");
+
+	// Archetypes are never removed, the ones made after the snapshot was saved end up empty.
+	const uint8* pSrc = snapshot.m_Chunks.data();
+	const uint32* pRowCount = snapshot.m_RowCounts.data();
+	for (uint32 archetypeIndex = 0; archetypeIndex < (uint32)m_Archetypes.size(); ++archetypeIndex)
+	{
+		Archetype& archetype = *m_Archetypes[archetypeIndex];
+		const uint32 chunkCount = archetypeIndex < (uint32)snapshot.m_ChunkCounts.size() ? snapshot.m_ChunkCounts[archetypeIndex] : 0;
+		while (archetype.chunks.size() > chunkCount)
+		{
+			FreeChunk(archetype.chunks.back());
+			archetype.chunks.pop_back();
+		}
+		while (archetype.chunks.size() < chunkCount)
+		{
+			Chunk& chunk = archetype.chunks.emplace_back();
+			chunk.m_pData = static_cast<uint8*>(::operator new(ChunkSize, std::align_val_t(ArrayAlignment)));
+			chunk.m_pArchetype = &archetype;
+		}
+
+		archetype.count = 0;
+		for (Chunk& chunk : archetype.chunks)
+		{
+			std::memcpy(chunk.m_pData, pSrc, ChunkSize);
+			chunk.m_Count = *pRowCount++;
+			archetype.count += chunk.m_Count;
+			pSrc += ChunkSize;
+		}
+	}
+
+	m_Slots = snapshot.m_Slots;
+	m_FreeSlots = snapshot.m_FreeSlots;
+	m_Count = snapshot.m_Count;
+
+	std::lock_guard<std::mutex> lock(m_DestroyQueueMutex);
+	m_DestroyQueue.clear();
+}
+
+RS::ECS::EntityHandle RS::ECS::EntityStore::CreateEntity(ComponentMask mask, Chunk*& pChunk, uint32& row)
+{
+	using namespace _EntityStoreInternal;
+
+	RS_ASSERT(m_IterationDepth == 0, "Entities cannot be created while iterating!");
+
+	const uint32 archetypeIndex = GetOrCreateArchetype(mask);
+	Archetype& archetype = *m_Archetypes[archetypeIndex];
+	if (archetype.chunks.empty() || archetype.chunks.back().m_Count == archetype.chunkCapacity)
+	{
+		Chunk& chunk = archetype.chunks.emplace_back();
+		chunk.m_pData = static_cast<uint8*>(::operator new(ChunkSize, std::align_val_t(ArrayAlignment)));
+		chunk.m_pArchetype = &archetype;
+	}
+
+	EntityHandle entity;
+	if (m_FreeSlots.empty())
+	{
+		entity.index = (uint32)m_Slots.size();
+		m_Slots.emplace_back();
+	}
+	else
+	{
+		entity.index = m_FreeSlots.back();
+		m_FreeSlots.pop_back();
+	}
+
+	pChunk = &archetype.chunks.back();
+	row = pChunk->m_Count++;
+	++archetype.count;
+	++m_Count;
+
+	Slot& slot = m_Slots[entity.index];
+	entity.generation = slot.generation;
+	slot.archetype = archetypeIndex;
+	slot.chunk = (uint32)archetype.chunks.size() - 1;
+	slot.row = row;
+
+	reinterpret_cast<EntityHandle*>(pChunk->m_pData)[row] = entity;
+	return entity;
+}
+
+uint32 RS::ECS::EntityStore::GetOrCreateArchetype(ComponentMask mask)
+{
+	using namespace _EntityStoreInternal;
+
+	auto it = m_ArchetypeIndices.find(mask);
+	if (it != m_ArchetypeIndices.end())
+		return it->second;
+
+	std::unique_ptr<Archetype> pArchetype = std::make_unique<Archetype>();
+	pArchetype->mask = mask;
+	pArchetype->offsets.fill(InvalidOffset);
+
+	std::vector<std::pair<ComponentID, ComponentInfo>> components;
+	uint32 bytesPerEntity = (uint32)sizeof(EntityHandle);
+	for (ComponentMask bits = mask; bits != 0; bits &= bits - 1)
+	{
+		const ComponentID id = (ComponentID)std::countr_zero(bits);
+		const ComponentInfo info = GetComponentInfo(id);
+		components.emplace_back(id, info);
+		bytesPerEntity += info.size;
+	}
+
+	// Every array can lose up to a cache line to alignment.
+	const uint32 padding = ArrayAlignment * (uint32)components.size();
+	RS_ASSERT(bytesPerEntity + padding <= ChunkSize, "The components of an entity do not fit in a chunk!");
+	pArchetype->chunkCapacity = (ChunkSize - padding) / bytesPerEntity;
+
+	uint32 offset = 0;
+	pArchetype->columns.push_back({ offset, (uint32)sizeof(EntityHandle) });
+	offset += pArchetype->chunkCapacity * (uint32)sizeof(EntityHandle);
+	for (const auto& [id, info] : components)
+	{
+		offset = AlignUp(offset, ArrayAlignment);
+		pArchetype->offsets[id] = offset;
+		pArchetype->columns.push_back({ offset, info.size });
+		offset += pArchetype->chunkCapacity * info.size;
+	}
+	RS_ASSERT(offset <= ChunkSize, "Chunk layout overflows the chunk!");
+
+	const uint32 index = (uint32)m_Archetypes.size();
+	m_Archetypes.push_back(std::move(pArchetype));
+	m_ArchetypeIndices[mask] = index;
+	return index;
+}
+
+void RS::ECS::EntityStore::GatherChunks(ComponentMask mask, std::vector<const Chunk*>& chunks) const
+{
+	for (const std::unique_ptr<_EntityStoreInternal::Archetype>& pArchetype : m_Archetypes)
+	{
+		if ((pArchetype->mask & mask) != mask)
+			continue;
+
+		for (const Chunk& chunk : pArchetype->chunks)
+			chunks.push_back(&chunk);
+	}
+}
+
+void RS::ECS::EntityStore::FreeChunk(Chunk& chunk)
+{
+	::operator delete(chunk.m_pData, std::align_val_t(_EntityStoreInternal::ArrayAlignment));
+	chunk.m_pData = nullptr;
+	chunk.m_Count = 0;
+}
+
+void RS::ECS::EntityStore::FreeChunks()
+{
+	for (std::unique_ptr<_EntityStoreInternal::Archetype>& pArchetype : m_Archetypes)
+	{
+		for (Chunk& chunk : pArchetype->chunks)
+			FreeChunk(chunk);
+		pArchetype->chunks.clear();
+		pArchetype->count = 0;
+	}
+}
@@ -0,0 +1,310 @@
+#pragma once
+
+#include "Core/ThreadPool.h"
+
+#include <array>
+#include <bit>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+/*
+* Entities are handles to a row of components. Entities with the same set of components share an archetype, which
+* stores every component in its own array inside fixed size chunks. Systems walk those arrays one chunk at a time,
+* either on the calling thread or spread over the ThreadPool.
+*/
+namespace RS::ECS
+{
+	using ComponentID = uint32;
+	using ComponentMask = uint64;
+
+	inline static constexpr uint32 MaxComponentTypes = 64;
+
+	/*
+	* The generation of a slot is bumped every time its entity is destroyed, so old handles to it stop being alive.
+	*/
+	struct EntityHandle
+	{
+		uint32 index = ~0u;
+		uint32 generation = 0;
+
+		bool operator==(const EntityHandle& other) const = default;
+	};
+
+	inline static constexpr EntityHandle InvalidEntity = {};
+
+	// Components are moved around with memcpy when entities are destroyed.
+	template<typename Type>
+	concept ComponentType = std::is_trivially_copyable_v<Type> && std::same_as<Type, std::remove_cvref_t<Type>>;
+
+	namespace _EntityStoreInternal
+	{
+		inline static constexpr uint32 InvalidOffset = ~0u;
+
+		ComponentID RegisterComponent(uint32 size, uint32 alignment);
+
+		struct Archetype;
+	}
+
+	/*
+	* Same for every instance of the type, they are handed out the first time a type is used.
+	*/
+	template<ComponentType Type>
+	ComponentID GetComponentID()
+	{
+		static const ComponentID s_ID = _EntityStoreInternal::RegisterComponent((uint32)sizeof(Type), (uint32)alignof(Type));
+		return s_ID;
+	}
+
+	template<ComponentType... Types>
+	ComponentMask GetComponentMask()
+	{
+		return (ComponentMask(0) | ... | (ComponentMask(1) << GetComponentID<Types>()));
+	}
+
+	/*
+	* A view of up to EntityStore::ChunkSize bytes of entities from one archetype.
+	*/
+	class Chunk
+	{
+	public:
+		uint32 GetCount() const { return m_Count; }
+		const EntityHandle* GetEntities() const { return reinterpret_cast<const EntityHandle*>(m_pData); }
+
+		// Array of GetCount() components, nullptr if the archetype does not have the component.
+		template<ComponentType Type>
+		Type* Get() const;
+
+	private:
+		friend class EntityStore;
+
+		uint8* m_pData = nullptr;
+		uint32 m_Count = 0;
+		const _EntityStoreInternal::Archetype* m_pArchetype = nullptr;
+	};
+
+	namespace _EntityStoreInternal
+	{
+		struct Column
+		{
+			uint32 offset;
+			uint32 size;
+		};
+
+		/*
+		* Every chunk but the last is full. The entity handles are stored first in the chunk, then one array per component.
+		*/
+		struct Archetype
+		{
+			ComponentMask mask = 0;
+			uint32 chunkCapacity = 0;
+			std::array<uint32, MaxComponentTypes> offsets;	// Of each component array in a chunk, InvalidOffset if it is not part of it.
+			std::vector<Column> columns;					// The handles and the components.
+			std::vector<Chunk> chunks;
+			uint64 count = 0;
+		};
+
+		// Where an entity is stored.
+		struct Slot
+		{
+			uint32 generation = 0;
+			uint32 archetype = ~0u;	// ~0u when the slot is free.
+			uint32 chunk = 0;
+			uint32 row = 0;
+		};
+	}
+
+	class EntityStore;
+
+	/*
+	* The state of an EntityStore, see EntityStore::SaveSnapshot. Keeps its memory between saves, so saving every frame
+	* stops allocating once it has grown to the largest state.
+	*/
+	class EntityStoreSnapshot
+	{
+	public:
+		// Bytes of state it holds.
+		uint64 GetSize() const;
+
+	private:
+		friend class EntityStore;
+
+		const EntityStore* m_pStore = nullptr;
+		std::vector<uint32> m_ChunkCounts;		// Per archetype.
+		std::vector<uint32> m_RowCounts;		// Per chunk, in the order they are stored.
+		std::vector<uint8> m_Chunks;			// Whole chunks, copied as they are. Can be larger than needed.
+		std::vector<_EntityStoreInternal::Slot> m_Slots;
+		std::vector<uint32> m_FreeSlots;
+		uint64 m_Count = 0;
+	};
+
+	class EntityStore
+	{
+	public:
+		inline static constexpr uint32 ChunkSize = 16 * 1024;
+
+	public:
+		EntityStore() = default;
+		~EntityStore();
+		RS_NO_COPY_AND_MOVE(EntityStore)
+
+		/*
+		* Creates an entity with the given components, each type can only be used once.
+		* Not allowed while iterating.
+		*/
+		template<ComponentType... Types>
+		EntityHandle Create(const Types&... components);
+
+		/*
+		* O(1), the last entity of the archetype is moved into the hole. Not allowed while iterating, use QueueDestroy then.
+		* Returns false if the entity was not alive.
+		*/
+		bool Destroy(EntityHandle entity);
+
+		/*
+		* Thread safe. The entity is destroyed by the next call to FlushDestroyed, it can be queued more than once.
+		*/
+		void QueueDestroy(EntityHandle entity);
+
+		/*
+		* Destroys the queued entities, returns how many were alive. onDestroy is called for each of them just before it is
+		* destroyed, while its components can still be read.
+		*/
+		uint64 FlushDestroyed(const std::function<void(EntityHandle)>& onDestroy = nullptr);
+
+		void Clear();
+
+		bool IsAlive(EntityHandle entity) const;
+
+		/*
+		* Copies every chunk, slot and free slot as bytes. Loading the snapshot puts the store back exactly as it was, down
+		* to the order of the entities, so a simulation continues the same way from it.
+		* Queued destructions are not part of the snapshot, loading one drops them. Not allowed while iterating.
+		*/
+		void SaveSnapshot(EntityStoreSnapshot& snapshot) const;
+		void LoadSnapshot(const EntityStoreSnapshot& snapshot);
+
+		// nullptr if the entity is not alive or does not have the component.
+		template<ComponentType Type>
+		Type* Get(EntityHandle entity) const;
+
+		uint64 GetCount() const { return m_Count; }
+
+		/*
+		* Calls func(const Chunk&) for every chunk with all of the components in Types.
+		* Entities are visited archetype by archetype, in the order they are stored, which stays the same until the next
+		* structural change.
+		*/
+		template<ComponentType... Types, typename Func>
+		void ForEachChunk(Func&& func) const;
+
+		/*
+		* Same as ForEachChunk, with the chunks spread over the ThreadPool. func may only write to the chunk it is given,
+		* and has to use QueueDestroy. maxThreads works like it does for ThreadPool::ParallelFor.
+		*/
+		template<ComponentType... Types, typename Func>
+		void ForEachChunkParallel(Func&& func, uint maxThreads = 0) const;
+
+		/*
+		* Calls func(EntityHandle, Types&...) for every entity with all of the components in Types.
+		*/
+		template<ComponentType... Types, typename Func>
+		void ForEach(Func&& func) const;
+
+	private:
+		using Slot = _EntityStoreInternal::Slot;
+
+		EntityHandle CreateEntity(ComponentMask mask, Chunk*& pChunk, uint32& row);
+		uint32 GetOrCreateArchetype(ComponentMask mask);
+		void GatherChunks(ComponentMask mask, std::vector<const Chunk*>& chunks) const;
+		void FreeChunk(Chunk& chunk);
+		void FreeChunks();
+
+	private:
+		std::vector<std::unique_ptr<_EntityStoreInternal::Archetype>>	m_Archetypes;
+		std::unordered_map<ComponentMask, uint32>						m_ArchetypeIndices;
+		std::vector<Slot>												m_Slots;
+		std::vector<uint32>												m_FreeSlots;
+		uint64															m_Count = 0;
+
+		std::mutex														m_DestroyQueueMutex;
+		std::vector<EntityHandle>										m_DestroyQueue;
+
+		mutable uint32													m_IterationDepth = 0;
+	};
+
+	template<ComponentType Type>
+	inline Type* Chunk::Get() const
+	{
+		const uint32 offset = m_pArchetype->offsets[GetComponentID<Type>()];
+		return offset == _EntityStoreInternal::InvalidOffset ? nullptr : reinterpret_cast<Type*>(m_pData + offset);
+	}
+
+	template<ComponentType... Types>
+	inline EntityHandle EntityStore::Create(const Types&... components)
+	{
+		const ComponentMask mask = GetComponentMask<Types...>();
+		RS_ASSERT(std::popcount(mask) == (int)sizeof...(Types), "An entity can only have one component of each type!");
+
+		Chunk* pChunk = nullptr;
+		uint32 row = 0;
+		const EntityHandle entity = CreateEntity(mask, pChunk, row);
+		(std::memcpy(pChunk->Get<Types>() + row, &components, sizeof(Types)), ...);
+		return entity;
+	}
+
+	template<ComponentType Type>
+	inline Type* EntityStore::Get(EntityHandle entity) const
+	{
+		if (!IsAlive(entity))
+			return nullptr;
+
+		const Slot& slot = m_Slots[entity.index];
+		Type* pComponents = m_Archetypes[slot.archetype]->chunks[slot.chunk].Get<Type>();
+		return pComponents ? pComponents + slot.row : nullptr;
+	}
+
+	template<ComponentType... Types, typename Func>
+	inline void EntityStore::ForEachChunk(Func&& func) const
+	{
+		const ComponentMask mask = GetComponentMask<Types...>();
+
+		++m_IterationDepth;
+		for (const std::unique_ptr<_EntityStoreInternal::Archetype>& pArchetype : m_Archetypes)
+		{
+			if ((pArchetype->mask & mask) != mask)
+				continue;
+
+			for (const Chunk& chunk : pArchetype->chunks)
+				func(chunk);
+		}
+		--m_IterationDepth;
+	}
+
+	template<ComponentType... Types, typename Func>
+	inline void EntityStore::ForEachChunkParallel(Func&& func, uint maxThreads) const
+	{
+		std::vector<const Chunk*> chunks;
+		GatherChunks(GetComponentMask<Types...>(), chunks);
+
+		++m_IterationDepth;
+		ThreadPool::Get()->ParallelFor(chunks.size(), [&](uint64 index) { func(*chunks[index]); }, maxThreads);
+		--m_IterationDepth;
+	}
+
+	template<ComponentType... Types, typename Func>
+	inline void EntityStore::ForEach(Func&& func) const
+	{
+		ForEachChunk<Types...>([&](const Chunk& chunk)
+			{
+				const EntityHandle* pEntities = chunk.GetEntities();
+				const std::tuple<Types*...> arrays(chunk.Get<Types>()...);
+				for (uint32 i = 0; i < chunk.GetCount(); ++i)
+					std::apply([&](Types*... pArrays) { func(pEntities[i], pArrays[i]...); }, arrays);
+			});
+	}
+}
@@ -0,0 +1,69 @@
+#include "PreCompiled.h"
+#include "SimulationHistory.h"
+
+RS::ECS::SimulationHistory::SimulationHistory(EntityStore& entities, uint32 tickCount)
+	: m_Entities(entities)
+	, m_Ticks(tickCount)
+{
+	RS_ASSERT(tickCount > 0, "The history has to hold at least one tick!");
+}
+
+void RS::ECS::SimulationHistory::AddState(void* pState, uint64 size)
+{
+	RS_ASSERT(m_NewestTick == UINT64_MAX, "State has to be added before the first tick is saved!");
+
+	m_States.push_back({ pState, size });
+	m_StateSize += size;
+}
+
+void RS::ECS::SimulationHistory::Save(uint64 tick)
+{
+	Tick& saved = m_Ticks[tick % m_Ticks.size()];
+	saved.tick = tick;
+	m_Entities.SaveSnapshot(saved.entities);
+
+	saved.state.resize(m_StateSize);
+	uint8* pDst = saved.state.data();
+	for (const State& state : m_States)
+	{
+		std::memcpy(pDst, state.pState, state.size);
+		pDst += state.size;
+	}
+	m_NewestTick = tick;
+}
+
+bool RS::ECS::SimulationHistory::Restore(uint64 tick)
+{
+	if (!Contains(tick))
+		return false;
+
+	const Tick& saved = m_Ticks[tick % m_Ticks.size()];
+	m_Entities.LoadSnapshot(saved.entities);
+
+	const uint8* pSrc = saved.state.data();
+	for (const State& state : m_States)
+	{
+		std::memcpy(state.pState, pSrc, state.size);
+		pSrc += state.size;
+	}
+
+	for (Tick& newer : m_Ticks)
+	{
+		if (newer.tick != UINT64_MAX && newer.tick > tick)
+			newer.tick = UINT64_MAX;
+	}
+	m_NewestTick = tick;
+	return true;
+}
+
+bool RS::ECS::SimulationHistory::Contains(uint64 tick) const
+{
+	return m_Ticks[tick % m_Ticks.size()].tick == tick;
+}
+
+uint64 RS::ECS::SimulationHistory::GetSize() const
+{
+	if (m_NewestTick == UINT64_MAX)
+		return 0;
+	return m_Ticks[m_NewestTick % m_Ticks.size()].entities.GetSize() + m_StateSize;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "ECS/EntityStore.h"
+
+/*
+* Helpers for a simulation that runs in fixed ticks. Components are double buffered with Previous<Type>, so rendering
+* can interpolate between the last two ticks, and SimulationHistory keeps the state of the last ticks to go back to.
+*/
+namespace RS::ECS
+{
+	/*
+	* The value a component had at the end of the previous tick. An entity needs both Type and Previous<Type>.
+	*/
+	template<ComponentType Type>
+	struct Previous
+	{
+		Type value;
+	};
+
+	/*
+	* Copies every Type into its Previous<Type>, one memcpy per chunk. Call it at the start of each tick, before Type is
+	* changed.
+	*/
+	template<ComponentType Type>
+	void StorePrevious(const EntityStore& entities)
+	{
+		entities.ForEachChunk<Type, Previous<Type>>([](const Chunk& chunk)
+			{
+				static_assert(sizeof(Previous<Type>) == sizeof(Type));
+				std::memcpy(chunk.Get<Previous<Type>>(), chunk.Get<Type>(), (uint64)chunk.GetCount() * sizeof(Type));
+			});
+	}
+
+	/*
+	* Ring buffer with the state of the last ticks: the entities and any other state added with AddState. Restoring a tick
+	* and running the same input again gives the same bytes, which is what replays, rollback and determinism tests need.
+	*/
+	class SimulationHistory
+	{
+	public:
+		SimulationHistory(EntityStore& entities, uint32 tickCount);
+		RS_NO_COPY_AND_MOVE(SimulationHistory)
+
+		/*
+		* State outside of the entities, like timers or a random generator, copied as bytes. It has to outlive the history.
+		*/
+		template<typename Type>
+		void AddState(Type& state)
+		{
+			static_assert(std::is_trivially_copyable_v<Type>, "State is copied as bytes!");
+			AddState(&state, sizeof(Type));
+		}
+		void AddState(void* pState, uint64 size);
+
+		/*
+		* Saves the current state as the state of the tick, replacing the oldest one if the history is full.
+		*/
+		void Save(uint64 tick);
+
+		/*
+		* Puts back the state saved for the tick. Returns false if it is no longer, or never was, in the history.
+		* The ticks after it are dropped, they belong to a timeline that is being replaced.
+		*/
+		bool Restore(uint64 tick);
+
+		bool Contains(uint64 tick) const;
+		uint32 GetTickCount() const { return (uint32)m_Ticks.size(); }
+
+		// Of the state of the newest tick.
+		uint64 GetSize() const;
+
+	private:
+		struct Tick
+		{
+			uint64 tick = UINT64_MAX;
+			EntityStoreSnapshot entities;
+			std::vector<uint8> state;
+		};
+
+		struct State
+		{
+			void* pState;
+			uint64 size;
+		};
+
+		EntityStore&		m_Entities;
+		std::vector<Tick>	m_Ticks;
+		std::vector<State>	m_States;
+		uint64				m_StateSize = 0;
+		uint64				m_NewestTick = UINT64_MAX;
+	};
+}
@@ -0,0 +1,151 @@
+#include "PreCompiled.h"
+#include "Batch2D.h"
+
+namespace RS::_Batch2DInternal
+{
+	inline uint64 MakeKey(int16 layer, BlendMode2D blendMode, uint16 texture, uint32 index)
+	{
+		// The layer is biased so negative layers sort before positive ones.
+		const uint32 state = ((uint32)(uint16)(layer + 32768) << 16) | ((uint32)blendMode << 12) | texture;
+		return ((uint64)state << 32) | index;
+	}
+
+	inline BlendMode2D GetBlendMode(uint64 key) { return (BlendMode2D)((key >> 44) & 0xF); }
+	inline uint16 GetTexture(uint64 key) { return (uint16)((key >> 32) & 0xFFF); }
+
+	/*
+	* LSD radix sort of the state half of the keys, the index half keeps equal states in the order they were drawn.
+	* Bytes that are the same in every key are skipped, so a frame drawn on one layer with one texture is only counted.
+	* Returns false if the keys are the same as before.
+	*/
+	bool RadixSort(std::vector<uint64>& keys, std::vector<uint64>& scratch)
+	{
+		constexpr uint32 FIRST_BYTE = 4;
+		constexpr uint32 BYTE_COUNT = 4;
+
+		uint32 histograms[BYTE_COUNT][256] = {};
+		for (uint64 key : keys)
+		{
+			for (uint32 byte = 0; byte < BYTE_COUNT; ++byte)
+				histograms[byte][(key >> ((FIRST_BYTE + byte) * 8)) & 0xFF]++;
+		}
+
+		scratch.resize(keys.size());
+		const uint64 count = keys.size();
+		bool isReordered = false;
+		for (uint32 byte = 0; byte < BYTE_COUNT; ++byte)
+		{
+			uint32* pHistogram = histograms[byte];
+			const uint32 shift = (FIRST_BYTE + byte) * 8;
+			if (pHistogram[(keys[0] >> shift) & 0xFF] == count)
+				continue;
+			isReordered = true;
+
+			uint32 offset = 0;
+			for (uint32 bucket = 0; bucket < 256; ++bucket)
+			{
+				const uint32 bucketCount = pHistogram[bucket];
+				pHistogram[bucket] = offset;
+				offset += bucketCount;
+			}
+
+			for (uint64 key : keys)
+				scratch[pHistogram[(key >> shift) & 0xFF]++] = key;
+			keys.swap(scratch);
+		}
+		return isReordered;
+	}
+}
+
+RS::Batch2D::Batch2D(const Batch2DSettings& settings)
+	: m_Settings(settings)
+{
+	RS_ASSERT(settings.maxInstancesPerDraw > 0, "A draw needs room for at least one instance!");
+}
+
+void RS::Batch2D::Clear()
+{
+	m_Layer = 0;
+	m_BlendMode = BlendMode2D::Alpha;
+	m_IsBuilt = false;
+	m_Recorded.clear();
+	m_Keys.clear();
+	m_Instances.clear();
+	m_Draws.clear();
+}
+
+void RS::Batch2D::DrawRect(float x, float y, float width, float height, Color32 color)
+{
+	const float halfWidth = width * 0.5f;
+	const float halfHeight = height * 0.5f;
+	Add({ x + halfWidth, y + halfHeight, halfWidth, halfHeight, 0.f, 0.f, 0.f, 0.f, 1.f, 1.f, color.Data, Shape2D::Rect }, NO_TEXTURE);
+}
+
+void RS::Batch2D::DrawCircle(float x, float y, float radius, Color32 color, float thickness)
+{
+	Add({ x, y, radius, radius, 0.f, thickness, -1.f, -1.f, 1.f, 1.f, color.Data, Shape2D::Circle }, NO_TEXTURE);
+}
+
+void RS::Batch2D::DrawLine(float x0, float y0, float x1, float y1, float thickness, Color32 color)
+{
+	// A rect along the line, as long as the line and as wide as the thickness.
+	const float dx = x1 - x0;
+	const float dy = y1 - y0;
+	const float length = std::sqrt(dx * dx + dy * dy);
+	Add({ (x0 + x1) * 0.5f, (y0 + y1) * 0.5f, length * 0.5f, thickness * 0.5f, std::atan2(dy, dx), 0.f, 0.f, 0.f, 1.f, 1.f, color.Data, Shape2D::Rect }, NO_TEXTURE);
+}
+
+void RS::Batch2D::DrawSprite(uint16 texture, float x, float y, float width, float height, Color32 tint, float u0, float v0, float u1, float v1, float rotation)
+{
+	const float halfWidth = width * 0.5f;
+	const float halfHeight = height * 0.5f;
+	Add({ x + halfWidth, y + halfHeight, halfWidth, halfHeight, rotation, 0.f, u0, v0, u1, v1, tint.Data, Shape2D::Rect }, texture);
+}
+
+void RS::Batch2D::Add(const Instance2D& instance, uint16 texture)
+{
+	RS_ASSERT(!m_IsBuilt, "Clear the batch before drawing the next frame!");
+	RS_ASSERT(texture < MAX_TEXTURES, "Texture {} is out of range, a batch can use {} textures!", texture, MAX_TEXTURES);
+	RS_ASSERT(m_Recorded.size() < UINT32_MAX, "Too many primitives in one batch!");
+
+	m_Keys.push_back(_Batch2DInternal::MakeKey(m_Layer, m_BlendMode, texture, (uint32)m_Recorded.size()));
+	m_Recorded.push_back(instance);
+}
+
+void RS::Batch2D::Build()
+{
+	using namespace _Batch2DInternal;
+
+	RS_ASSERT(!m_IsBuilt, "The batch has already been built!");
+	m_IsBuilt = true;
+	if (m_Keys.empty())
+		return;
+
+	// Without any state change between primitives the recorded order is the draw order and nothing is copied.
+	m_Instances.clear();
+	if (RadixSort(m_Keys, m_SortScratch))
+	{
+		m_Instances.reserve(m_Recorded.size());
+		for (uint64 key : m_Keys)
+			m_Instances.push_back(m_Recorded[(uint32)key]);
+	}
+	else
+	{
+		m_Instances.swap(m_Recorded);
+	}
+
+	// Draws only break where the state changes, so layers that use the same texture end up in one draw.
+	Draw2D* pDraw = nullptr;
+	uint32 drawState = UINT32_MAX;
+	for (uint64 i = 0; i < m_Keys.size(); ++i)
+	{
+		const uint64 key = m_Keys[i];
+		const uint32 state = (uint32)(key >> 32) & 0xFFFF;
+		if (state != drawState || pDraw->instanceCount == m_Settings.maxInstancesPerDraw)
+		{
+			pDraw = &m_Draws.emplace_back(Draw2D{ (uint32)i, 0, GetTexture(key), GetBlendMode(key) });
+			drawState = state;
+		}
+		pDraw->instanceCount++;
+	}
+}
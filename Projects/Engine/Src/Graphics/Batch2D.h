@@ -0,0 +1,106 @@
+#pragma once
+
+#include "Graphics/Color.h"
+
+namespace RS
+{
+	enum class Shape2D : uint32
+	{
+		Rect = 0,		// Rects, lines and sprites, sampled from the texture.
+		Circle			// SDF circle in the rect, filled or as a ring.
+	};
+
+	enum class BlendMode2D : uint8
+	{
+		Alpha = 0,
+		Additive,
+		COUNT
+	};
+
+	/*
+	* One primitive, drawn as an instance of a quad. The quad is centered on the position and rotated around it.
+	*/
+	struct Instance2D
+	{
+		float x;
+		float y;
+		float halfWidth;
+		float halfHeight;
+		float rotation;			// Radians, counter-clockwise.
+		float thickness;		// Of the ring for circles, zero when filled.
+		float u0;
+		float v0;
+		float u1;
+		float v1;
+		uint32 color;			// Color32.
+		Shape2D shape;
+	};
+
+	// Instances that share a texture and blend mode and are next to each other after sorting.
+	struct Draw2D
+	{
+		uint32 firstInstance;
+		uint32 instanceCount;
+		uint16 texture;
+		BlendMode2D blendMode;
+	};
+
+	struct Batch2DSettings
+	{
+		uint32 maxInstancesPerDraw = UINT32_MAX;	// A draw is split when it is longer, e.g. to fit an upload page.
+	};
+
+	/*
+	* GPU independent core of Renderer2D. Primitives are recorded into buffers that are reused every frame, then Build
+	* sorts them by layer, blend mode and texture with a radix sort and merges runs with the same state into draws.
+	* Only the layer decides what is drawn on top. Primitives on one layer are sorted by state and may be reordered
+	* between textures, within one texture they keep the order they were drawn in.
+	*/
+	class Batch2D
+	{
+	public:
+		inline static constexpr uint16 NO_TEXTURE = 0;
+		inline static constexpr uint32 MAX_TEXTURES = 4096;
+
+	public:
+		Batch2D(const Batch2DSettings& settings = Batch2DSettings());
+
+		// Drops everything recorded and resets the layer and blend mode, keeping the memory.
+		void Clear();
+
+		// Applies to the primitives drawn after it. Higher layers are drawn on top.
+		void SetLayer(int16 layer) { m_Layer = layer; }
+		void SetBlendMode(BlendMode2D blendMode) { m_BlendMode = blendMode; }
+
+		// Positions are in pixels with y going up, rects and sprites are placed by their bottom left corner.
+		void DrawRect(float x, float y, float width, float height, Color32 color);
+		void DrawCircle(float x, float y, float radius, Color32 color, float thickness = 0.f);
+		void DrawLine(float x0, float y0, float x1, float y1, float thickness, Color32 color);
+		void DrawSprite(uint16 texture, float x, float y, float width, float height, Color32 tint = Color::WHITE,
+			float u0 = 0.f, float v0 = 0.f, float u1 = 1.f, float v1 = 1.f, float rotation = 0.f);
+
+		// Sorts the primitives and makes the draws. Nothing can be recorded until Clear.
+		void Build();
+
+		uint32 GetPrimitiveCount() const { return (uint32)m_Keys.size(); }
+
+		// Valid after Build, in draw order.
+		const std::vector<Instance2D>& GetInstances() const { return m_Instances; }
+		const std::vector<Draw2D>& GetDraws() const { return m_Draws; }
+
+	private:
+		void Add(const Instance2D& instance, uint16 texture);
+
+		Batch2DSettings m_Settings;
+		int16 m_Layer = 0;
+		BlendMode2D m_BlendMode = BlendMode2D::Alpha;
+		bool m_IsBuilt = false;
+
+		// Per frame memory, cleared but not freed.
+		std::vector<Instance2D> m_Recorded;
+		std::vector<uint64> m_Keys;			// Layer, blend mode and texture in the high half, the primitive index in the low.
+		std::vector<uint64> m_SortScratch;
+		std::vector<Instance2D> m_Instances;
+		std::vector<Draw2D> m_Draws;
+	};
+}
@@ -0,0 +1,330 @@
+#include "PreCompiled.h"
+#include "GlyphAtlas.h"
+
+#include "Utils/Misc/StringUtils.h"
+
+RS::SkylinePacker::SkylinePacker(uint32 width, uint32 height)
+	: m_Width(width), m_Height(height)
+{
+	m_Skyline.push_back({ 0, 0, width });
+}
+
+uint32 RS::SkylinePacker::GetFitHeight(uint64 nodeIndex, uint32 width) const
+{
+	const uint32 x = m_Skyline[nodeIndex].x;
+	if (x + width > m_Width)
+		return UINT32_MAX;
+
+	uint32 y = 0;
+	uint32 remaining = width;
+	for (uint64 i = nodeIndex; remaining > 0; ++i)
+	{
+		y = std::max(y, m_Skyline[i].y);
+		remaining -= std::min(remaining, m_Skyline[i].width);
+	}
+	return y;
+}
+
+bool RS::SkylinePacker::Pack(uint32 width, uint32 height, uint32& x, uint32& y)
+{
+	if (width == 0 || height == 0)
+	{
+		x = y = 0;
+		return true;
+	}
+
+	uint64 bestIndex = UINT64_MAX;
+	uint32 bestTop = UINT32_MAX;
+	uint32 bestWidth = UINT32_MAX;
+	for (uint64 i = 0; i < m_Skyline.size(); ++i)
+	{
+		const uint32 fitY = GetFitHeight(i, width);
+		if (fitY == UINT32_MAX || fitY + height > m_Height)
+			continue;
+
+		// Lowest top first, then the narrowest node to keep wide gaps for wide rectangles.
+		if (fitY + height < bestTop || (fitY + height == bestTop && m_Skyline[i].width < bestWidth))
+		{
+			bestIndex = i;
+			bestTop = fitY + height;
+			bestWidth = m_Skyline[i].width;
+		}
+	}
+
+	if (bestIndex == UINT64_MAX)
+		return false;
+
+	x = m_Skyline[bestIndex].x;
+	y = bestTop - height;
+
+	// The new node covers [x, x + width), the nodes under it are cut or removed.
+	m_Skyline.insert(m_Skyline.begin() + bestIndex, { x, bestTop, width });
+	const uint32 end = x + width;
+	uint64 i = bestIndex + 1;
+	while (i < m_Skyline.size() && m_Skyline[i].x < end)
+	{
+		Node& node = m_Skyline[i];
+		const uint32 nodeEnd = node.x + node.width;
+		if (nodeEnd <= end)
+		{
+			m_Skyline.erase(m_Skyline.begin() + i);
+			continue;
+		}
+		node.width = nodeEnd - end;
+		node.x = end;
+		break;
+	}
+
+	// Neighbours at the same height become one node.
+	for (uint64 j = 0; j + 1 < m_Skyline.size();)
+	{
+		if (m_Skyline[j].y == m_Skyline[j + 1].y)
+		{
+			m_Skyline[j].width += m_Skyline[j + 1].width;
+			m_Skyline.erase(m_Skyline.begin() + j + 1);
+		}
+		else
+		{
+			++j;
+		}
+	}
+
+	m_UsedArea += (uint64)width * height;
+	return true;
+}
+
+void RS::SkylinePacker::Grow(uint32 width, uint32 height)
+{
+	RS_ASSERT(width >= m_Width && height >= m_Height, "The packer can only grow!");
+	if (width > m_Width)
+	{
+		if (!m_Skyline.empty() && m_Skyline.back().y == 0)
+			m_Skyline.back().width += width - m_Width;
+		else
+			m_Skyline.push_back({ m_Width, 0, width - m_Width });
+	}
+	m_Width = width;
+	m_Height = height;
+}
+
+void RS::GlyphBatch::Add(const AtlasGlyph& glyph, float x, float y, float scale, uint32 color)
+{
+	if (glyph.width == 0)
+		return;
+
+	if (pages.size() <= glyph.page)
+		pages.resize(glyph.page + 1);
+
+	GlyphInstance& instance = pages[glyph.page].emplace_back();
+	instance.x = x + glyph.bearingX * scale;
+	instance.y = y - (glyph.height - glyph.bearingY) * scale;
+	instance.width = glyph.width * scale;
+	instance.height = glyph.height * scale;
+	instance.texelX = glyph.x;
+	instance.texelY = glyph.y;
+	instance.texelWidth = glyph.width;
+	instance.texelHeight = glyph.height;
+	instance.color = color;
+}
+
+void RS::GlyphBatch::Clear()
+{
+	for (std::vector<GlyphInstance>& page : pages)
+		page.clear();
+}
+
+uint64 RS::GlyphBatch::GetInstanceCount() const
+{
+	uint64 count = 0;
+	for (const std::vector<GlyphInstance>& page : pages)
+		count += page.size();
+	return count;
+}
+
+RS::GlyphAtlas::GlyphAtlas(std::unique_ptr<IGlyphRasterizer> pRasterizer, const GlyphAtlasSettings& settings)
+	: m_pRasterizer(std::move(pRasterizer)), m_Settings(settings)
+{
+	RS_ASSERT(m_pRasterizer, "A glyph atlas needs a rasterizer!");
+	RS_ASSERT(settings.initialPageSize > 0 && settings.initialPageSize <= settings.maxPageSize && settings.maxPageSize <= UINT16_MAX,
+		"Bad atlas page sizes {} and {}!", settings.initialPageSize, settings.maxPageSize);
+	m_AsciiGlyphIndices.fill(UINT32_MAX);
+}
+
+const RS::AtlasGlyph& RS::GlyphAtlas::GetGlyph(uint32 codepoint)
+{
+	const uint32 index = FindGlyphIndex(codepoint);
+	return index != UINT32_MAX ? m_Glyphs[index] : AddGlyph(codepoint);
+}
+
+void RS::GlyphAtlas::Preload(uint32 first, uint32 last)
+{
+	for (uint32 codepoint = first; codepoint <= last && codepoint >= first; ++codepoint)
+		GetGlyph(codepoint);
+}
+
+uint32 RS::GlyphAtlas::FindGlyphIndex(uint32 codepoint) const
+{
+	if (codepoint < m_AsciiGlyphIndices.size())
+		return m_AsciiGlyphIndices[codepoint];
+
+	auto it = m_GlyphIndices.find(codepoint);
+	return it != m_GlyphIndices.end() ? it->second : UINT32_MAX;
+}
+
+const RS::AtlasGlyph& RS::GlyphAtlas::AddGlyph(uint32 codepoint)
+{
+	GlyphBitmap bitmap;
+	uint32 index = UINT32_MAX;
+	if (m_pRasterizer->Rasterize(codepoint, bitmap))
+	{
+		index = (uint32)m_Glyphs.size();
+		m_Glyphs.push_back(CreateGlyph(codepoint, bitmap));
+	}
+	else
+	{
+		// Every missing codepoint shares one glyph, empty if the font has neither U+FFFD nor '?'.
+		if (m_FallbackGlyphIndex == UINT32_MAX)
+		{
+			for (uint32 fallbackCodepoint : { 0xFFFDu, (uint32)'?' })
+			{
+				if (fallbackCodepoint == codepoint)
+					continue;
+
+				m_FallbackGlyphIndex = FindGlyphIndex(fallbackCodepoint);
+				if (m_FallbackGlyphIndex != UINT32_MAX)
+					break;
+
+				GlyphBitmap fallback;
+				if (m_pRasterizer->Rasterize(fallbackCodepoint, fallback))
+				{
+					m_FallbackGlyphIndex = (uint32)m_Glyphs.size();
+					m_Glyphs.push_back(CreateGlyph(fallbackCodepoint, fallback));
+					SetGlyphIndex(fallbackCodepoint, m_FallbackGlyphIndex);
+					break;
+				}
+			}
+
+			if (m_FallbackGlyphIndex == UINT32_MAX)
+			{
+				m_FallbackGlyphIndex = (uint32)m_Glyphs.size();
+				m_Glyphs.push_back(AtlasGlyph());
+			}
+		}
+		index = m_FallbackGlyphIndex;
+	}
+
+	SetGlyphIndex(codepoint, index);
+	return m_Glyphs[index];
+}
+
+RS::AtlasGlyph RS::GlyphAtlas::CreateGlyph(uint32 codepoint, const GlyphBitmap& bitmap)
+{
+	AtlasGlyph glyph;
+	glyph.bearingX = (int16)bitmap.bearingX;
+	glyph.bearingY = (int16)bitmap.bearingY;
+	glyph.advance = bitmap.advance;
+	if (bitmap.width == 0 || bitmap.height == 0)
+		return glyph;
+
+	RS_ASSERT(bitmap.pixels.size() >= (uint64)bitmap.width * bitmap.height, "Glyph {} has too few pixels!", codepoint);
+	if (!Pack(bitmap.width, bitmap.height, glyph))
+	{
+		LOG_WARNING("Glyph {} is {}x{} which does not fit in a {}x{} atlas page!", codepoint, bitmap.width, bitmap.height, m_Settings.maxPageSize, m_Settings.maxPageSize);
+		return glyph;
+	}
+
+	Page& page = m_Pages[glyph.page];
+	for (uint32 row = 0; row < bitmap.height; ++row)
+		std::memcpy(&page.pixels[(uint64)(glyph.y + row) * page.width + glyph.x], &bitmap.pixels[(uint64)row * bitmap.width], bitmap.width);
+	page.version++;
+	return glyph;
+}
+
+void RS::GlyphAtlas::SetGlyphIndex(uint32 codepoint, uint32 index)
+{
+	if (codepoint < m_AsciiGlyphIndices.size())
+		m_AsciiGlyphIndices[codepoint] = index;
+	else
+		m_GlyphIndices[codepoint] = index;
+}
+
+bool RS::GlyphAtlas::Pack(uint32 width, uint32 height, AtlasGlyph& glyph)
+{
+	const uint32 paddedWidth = width + m_Settings.padding * 2;
+	const uint32 paddedHeight = height + m_Settings.padding * 2;
+	if (paddedWidth > m_Settings.maxPageSize || paddedHeight > m_Settings.maxPageSize)
+		return false;
+
+	// Only the last page takes new glyphs, the earlier ones are full.
+	uint32 x = 0, y = 0;
+	while (m_Pages.empty() || !m_Pages.back().packer.Pack(paddedWidth, paddedHeight, x, y))
+	{
+		if (!m_Pages.empty() && (m_Pages.back().width < m_Settings.maxPageSize || m_Pages.back().height < m_Settings.maxPageSize))
+		{
+			GrowPage(m_Pages.back());
+			continue;
+		}
+
+		Page& page = m_Pages.emplace_back();
+		page.width = page.height = m_Settings.initialPageSize;
+		page.pixels.assign((uint64)page.width * page.height, 0);
+		page.packer = SkylinePacker(page.width, page.height);
+	}
+
+	glyph.page = (uint16)(m_Pages.size() - 1);
+	glyph.x = (uint16)(x + m_Settings.padding);
+	glyph.y = (uint16)(y + m_Settings.padding);
+	glyph.width = (uint16)width;
+	glyph.height = (uint16)height;
+	return true;
+}
+
+void RS::GlyphAtlas::GrowPage(Page& page)
+{
+	// Alternating between the width and the height keeps the page square or twice as wide as it is high.
+	const uint32 width = page.width <= page.height ? std::min(page.width * 2, m_Settings.maxPageSize) : page.width;
+	const uint32 height = width == page.width ? std::min(page.height * 2, m_Settings.maxPageSize) : page.height;
+
+	std::vector<uint8> pixels((uint64)width * height, 0);
+	for (uint32 row = 0; row < page.height; ++row)
+		std::memcpy(&pixels[(uint64)row * width], &page.pixels[(uint64)row * page.width], page.width);
+
+	page.pixels = std::move(pixels);
+	page.width = width;
+	page.height = height;
+	page.packer.Grow(width, height);
+	page.version++;
+}
+
+float RS::GlyphAtlas::GetKerning(uint32 left, uint32 right)
+{
+	if (!m_pRasterizer->HasKerning())
+		return 0.f;
+
+	const uint64 key = ((uint64)left << 32) | right;
+	auto it = m_Kerning.find(key);
+	if (it != m_Kerning.end())
+		return it->second;
+
+	const float kerning = m_pRasterizer->GetKerning(left, right);
+	m_Kerning[key] = kerning;
+	return kerning;
+}
+
+float RS::GlyphAtlas::AppendText(std::string_view text, float x, float y, float scale, uint32 color, GlyphBatch& batch)
+{
+	uint32 previous = 0;
+	size_t offset = 0;
+	while (offset < text.size())
+	{
+		const uint32 codepoint = Utils::DecodeUTF8(text, offset);
+		if (previous != 0)
+			x += GetKerning(previous, codepoint) * scale;
+		previous = codepoint;
+
+		const AtlasGlyph& glyph = GetGlyph(codepoint);
+		batch.Add(glyph, x, y, scale, color);
+		x += glyph.advance * scale;
+	}
+	return x;
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <unordered_map>
+#include <array>
+#include <string_view>
+
+namespace RS
+{
+	/*
+	* Skyline bottom-left rectangle packer. The skyline is the top edge of everything packed so far, a rectangle is placed
+	* where its top ends up the lowest, so the leftover space is mostly above the skyline where later rectangles can use it.
+	*/
+	class SkylinePacker
+	{
+	public:
+		SkylinePacker() = default;
+		SkylinePacker(uint32 width, uint32 height);
+
+		bool Pack(uint32 width, uint32 height, uint32& x, uint32& y);
+
+		// The area can only grow, everything packed keeps its place.
+		void Grow(uint32 width, uint32 height);
+
+		uint32 GetWidth() const { return m_Width; }
+		uint32 GetHeight() const { return m_Height; }
+		uint64 GetUsedArea() const { return m_UsedArea; }
+
+	private:
+		// The lowest y a rectangle of the width can be placed at starting at the node, or UINT32_MAX if it does not fit.
+		uint32 GetFitHeight(uint64 nodeIndex, uint32 width) const;
+
+		struct Node
+		{
+			uint32 x;
+			uint32 y;
+			uint32 width;
+		};
+
+		uint32 m_Width = 0;
+		uint32 m_Height = 0;
+		uint64 m_UsedArea = 0;
+		std::vector<Node> m_Skyline;
+	};
+
+	struct GlyphBitmap
+	{
+		uint32 width = 0;
+		uint32 height = 0;
+		int32 bearingX = 0;		// From the pen position to the left edge of the bitmap.
+		int32 bearingY = 0;		// From the baseline up to the top edge of the bitmap.
+		float advance = 0.f;	// In pixels.
+		std::vector<uint8> pixels;
+	};
+
+	/*
+	* Makes the bitmap of one glyph, for TextRenderer that is a FreeType face rendering SDF glyphs.
+	*/
+	class IGlyphRasterizer
+	{
+	public:
+		virtual ~IGlyphRasterizer() = default;
+
+		// False if the font does not have the codepoint.
+		virtual bool Rasterize(uint32 codepoint, GlyphBitmap& bitmap) = 0;
+
+		// From one baseline to the next, in pixels.
+		virtual float GetLineHeight() const = 0;
+
+		// Added to the advance of left when right follows it, in pixels.
+		virtual bool HasKerning() const { return false; }
+		virtual float GetKerning(uint32 left, uint32 right) { return 0.f; }
+	};
+
+	struct AtlasGlyph
+	{
+		uint16 page = 0;
+		uint16 x = 0;			// Texels in the page.
+		uint16 y = 0;
+		uint16 width = 0;		// Zero for glyphs without pixels, like space.
+		uint16 height = 0;
+		int16 bearingX = 0;
+		int16 bearingY = 0;
+		float advance = 0.f;
+	};
+
+	/*
+	* One glyph quad, drawn as an instance. The texel rectangle is divided by the page size in the shader, so the
+	* instances stay valid when the page grows.
+	*/
+	struct GlyphInstance
+	{
+		float x;				// Bottom left corner, y goes up.
+		float y;
+		float width;
+		float height;
+		uint16 texelX;
+		uint16 texelY;
+		uint16 texelWidth;
+		uint16 texelHeight;
+		uint32 color;			// Color32.
+	};
+
+
+	// The instances of every atlas page, each page is one draw.
+	struct GlyphBatch
+	{
+		std::vector<std::vector<GlyphInstance>> pages;
+
+		// The pen is at (x, y) on the baseline. Glyphs without pixels add nothing.
+		void Add(const AtlasGlyph& glyph, float x, float y, float scale, uint32 color);
+		void Clear();
+		uint64 GetInstanceCount() const;
+	};
+
+	struct GlyphAtlasSettings
+	{
+		uint32 initialPageSize = 256;
+		uint32 maxPageSize = 2048;
+		uint32 padding = 1;		// Empty texels around every glyph so filtering does not pick up its neighbours.
+	};
+
+	/*
+	* SDF glyphs packed into shared pages. Glyphs are rasterised the first time they are used, and a full page grows up to
+	* maxPageSize before a new page is started. Every change to a page bumps its version so the renderer knows what to upload.
+	*/
+	class GlyphAtlas
+	{
+	public:
+		struct Page
+		{
+			uint32 width = 0;
+			uint32 height = 0;
+			uint32 version = 0;
+			std::vector<uint8> pixels;	// R8, one SDF value per texel.
+			SkylinePacker packer;
+		};
+
+	public:
+		GlyphAtlas(std::unique_ptr<IGlyphRasterizer> pRasterizer, const GlyphAtlasSettings& settings = GlyphAtlasSettings());
+
+		/*
+		* Rasterises and packs the glyph the first time. Codepoints the font does not have use U+FFFD or '?' instead.
+		* The reference is valid until the next call.
+		*/
+		const AtlasGlyph& GetGlyph(uint32 codepoint);
+
+		// Rasterises every codepoint in [first, last].
+		void Preload(uint32 first, uint32 last);
+
+		// Cached per pair, so the rasterizer is only asked once.
+		float GetKerning(uint32 left, uint32 right);
+		float GetLineHeight() const { return m_pRasterizer->GetLineHeight(); }
+
+		/*
+		* Adds the glyphs of one line of UTF-8 text to the batch, with the pen starting at (x, y) on the baseline and y going up.
+		* Returns the pen x after the text. TextLayout does wrapping and caching on top of this.
+		*/
+		float AppendText(std::string_view text, float x, float y, float scale, uint32 color, GlyphBatch& batch);
+
+		uint32 GetPageCount() const { return (uint32)m_Pages.size(); }
+		const Page& GetPage(uint32 index) const { return m_Pages[index]; }
+		uint32 GetGlyphCount() const { return (uint32)m_Glyphs.size(); }
+
+	private:
+		// UINT32_MAX if the codepoint has not been seen yet.
+		uint32 FindGlyphIndex(uint32 codepoint) const;
+		const AtlasGlyph& AddGlyph(uint32 codepoint);
+		AtlasGlyph CreateGlyph(uint32 codepoint, const GlyphBitmap& bitmap);
+		void SetGlyphIndex(uint32 codepoint, uint32 index);
+		bool Pack(uint32 width, uint32 height, AtlasGlyph& glyph);
+		void GrowPage(Page& page);
+
+		std::unique_ptr<IGlyphRasterizer> m_pRasterizer;
+		GlyphAtlasSettings m_Settings;
+		std::vector<Page> m_Pages;
+		std::vector<AtlasGlyph> m_Glyphs;
+		std::unordered_map<uint32, uint32> m_GlyphIndices;
+		std::array<uint32, 128> m_AsciiGlyphIndices;	// Most text is ASCII, so it skips the map.
+		uint32 m_FallbackGlyphIndex = UINT32_MAX;
+		std::unordered_map<uint64, float> m_Kerning;
+	};
+}
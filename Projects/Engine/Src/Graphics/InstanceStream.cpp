@@ -0,0 +1,199 @@
+#include "PreCompiled.h"
+#include "InstanceStream.h"
+
+#include "DX12/NewCore/DX12Core3.h"
+#include "DX12/NewCore/CommandList.h"
+
+#include "Maths/GLMDefines.h"
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace RS::_InstanceStreamInternal
+{
+	// Buffers grow by half of their size, and are never smaller than this many instances.
+	constexpr uint32 MinCapacity = 1024;
+}
+
+RS::PackedInstance2D RS::PackedInstance2D::Pack(float x, float y, float width, float height, float red, float green, float blue, uint8 type)
+{
+	PackedInstance2D instance;
+	instance.x = x;
+	instance.y = y;
+	instance.size = glm::packHalf2x16(glm::vec2(width, height));
+	instance.colorAndType = (glm::packUnorm4x8(glm::vec4(red, green, blue, 0.f)) & 0x00FFFFFF) | ((uint32)type << 24);
+	return instance;
+}
+
+RS::InstanceStreamData::InstanceStreamData(uint32 stride, uint32 copyCount)
+	: m_Stride(stride)
+	, m_DirtyBlocks(copyCount)
+{
+	RS_ASSERT(stride > 0, "Instances cannot be empty!");
+	RS_ASSERT(copyCount > 0, "A stream needs at least one copy!");
+}
+
+void RS::InstanceStreamData::Resize(uint32 count)
+{
+	const uint32 oldCount = m_Count;
+	m_Count = count;
+	m_Data.resize((uint64)count * m_Stride);
+
+	const uint64 wordCount = ((uint64)count + BlockSize * 64 - 1) / (BlockSize * 64);
+	for (std::vector<uint64>& blocks : m_DirtyBlocks)
+		blocks.resize(wordCount, 0);
+
+	if (count > oldCount)
+	{
+		// Shrinking and growing again leaves stale bytes behind, the new instances always start out zeroed.
+		std::memset(m_Data.data() + (uint64)oldCount * m_Stride, 0, (uint64)(count - oldCount) * m_Stride);
+		MarkDirty(oldCount, count - oldCount);
+	}
+}
+
+void RS::InstanceStreamData::Write(uint32 index, const void* pInstance)
+{
+	RS_ASSERT(index < m_Count, "Instance {} is out of range, there are {} instances!", index, m_Count);
+
+	uint8* pDestination = m_Data.data() + (uint64)index * m_Stride;
+	if (std::memcmp(pDestination, pInstance, m_Stride) == 0)
+		return;
+
+	std::memcpy(pDestination, pInstance, m_Stride);
+	SetDirty(index / BlockSize, index / BlockSize);
+}
+
+void RS::InstanceStreamData::MarkDirty(uint32 first, uint32 count)
+{
+	RS_ASSERT((uint64)first + count <= m_Count, "Instances {} to {} are out of range, there are {} instances!", first, (uint64)first + count, m_Count);
+
+	if (count > 0)
+		SetDirty(first / BlockSize, (first + count - 1) / BlockSize);
+}
+
+void RS::InstanceStreamData::MarkCopyDirty(uint32 copy)
+{
+	RS_ASSERT(copy < (uint32)m_DirtyBlocks.size(), "There are only {} copies!", m_DirtyBlocks.size());
+
+	std::fill(m_DirtyBlocks[copy].begin(), m_DirtyBlocks[copy].end(), ~0ull);
+}
+
+void RS::InstanceStreamData::TakeDirtyRanges(uint32 copy, std::vector<Range>& ranges)
+{
+	RS_ASSERT(copy < (uint32)m_DirtyBlocks.size(), "There are only {} copies!", m_DirtyBlocks.size());
+
+	ranges.clear();
+
+	const uint64 size = GetSize();
+	const uint64 blockBytes = (uint64)BlockSize * m_Stride;
+	std::vector<uint64>& blocks = m_DirtyBlocks[copy];
+	for (uint64 word = 0; word < blocks.size(); ++word)
+	{
+		uint64 bits = blocks[word];
+		blocks[word] = 0;
+		while (bits != 0)
+		{
+			const uint64 block = word * 64 + std::countr_zero(bits);
+			bits &= bits - 1;
+
+			const uint64 offset = block * blockBytes;
+			if (offset >= size)
+				break;
+
+			const uint64 blockSize = std::min(blockBytes, size - offset);
+			if (!ranges.empty() && ranges.back().offset + ranges.back().size == offset)
+				ranges.back().size += blockSize;
+			else
+				ranges.push_back({ offset, blockSize });
+		}
+	}
+}
+
+void RS::InstanceStreamData::SetDirty(uint32 firstBlock, uint32 lastBlock)
+{
+	for (std::vector<uint64>& blocks : m_DirtyBlocks)
+	{
+		for (uint32 block = firstBlock; block <= lastBlock; ++block)
+			blocks[block / 64] |= 1ull << (block % 64);
+	}
+}
+
+RS::InstanceStreamBase::InstanceStreamBase(uint32 stride, const std::string& name)
+	: m_Data(stride, FRAME_BUFFER_COUNT)
+	, m_Name(name)
+{
+}
+
+RS::InstanceStreamBase::~InstanceStreamBase()
+{
+	for (FrameBuffer& frameBuffer : m_FrameBuffers)
+	{
+		if (frameBuffer.pBuffer)
+			frameBuffer.pBuffer->Unmap(0);
+	}
+}
+
+void RS::InstanceStreamBase::Commit()
+{
+	using namespace _InstanceStreamInternal;
+
+	// Present waited for this frame index's previous frame, the GPU is done reading its buffer.
+	const uint32 frameIndex = DX12Core3::Get()->GetCurrentFrameIndex();
+	FrameBuffer& frameBuffer = m_FrameBuffers[frameIndex];
+	m_CommittedFrameIndex = frameIndex;
+	m_CommittedBytes = 0;
+
+	const uint32 count = m_Data.GetCount();
+	if (count == 0)
+		return;
+
+	if (count > frameBuffer.capacity)
+	{
+		if (frameBuffer.pBuffer)
+			frameBuffer.pBuffer->Unmap(0);
+
+		frameBuffer.capacity = std::max({ count, frameBuffer.capacity + frameBuffer.capacity / 2, MinCapacity });
+		CD3DX12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Buffer((uint64)frameBuffer.capacity * m_Data.GetStride());
+		frameBuffer.pBuffer = std::make_shared<Buffer>(desc, nullptr, Utils::Format("{} {}", m_Name, frameIndex), D3D12_HEAP_TYPE_UPLOAD);
+
+		void* pMapped = nullptr;
+		const bool isMapped = frameBuffer.pBuffer->Map(0, &pMapped);
+		RS_ASSERT(isMapped, "Failed to map the instance buffer of {}!", m_Name);
+		frameBuffer.pMapped = (uint8*)pMapped;
+
+		// The new buffer has none of the instances.
+		m_Data.MarkCopyDirty(frameIndex);
+	}
+
+	m_Data.TakeDirtyRanges(frameIndex, m_Ranges);
+	for (const InstanceStreamData::Range& range : m_Ranges)
+	{
+		std::memcpy(frameBuffer.pMapped + range.offset, m_Data.GetData() + range.offset, range.size);
+		m_CommittedBytes += range.size;
+	}
+	s_UploadedBytes += m_CommittedBytes;
+}
+
+void RS::InstanceStreamBase::Bind(const std::shared_ptr<CommandList>& pCommandList, uint32 rootParameterIndex, uint32 descriptorOffset)
+{
+	const uint32 frameIndex = DX12Core3::Get()->GetCurrentFrameIndex();
+	RS_ASSERT(m_CommittedFrameIndex == frameIndex, "{} has to be committed before it is bound!", m_Name);
+
+	FrameBuffer& frameBuffer = m_FrameBuffers[frameIndex];
+	RS_ASSERT(frameBuffer.pBuffer, "{} has no instances to bind!", m_Name);
+
+	// The view covers the whole buffer, so there is one view per buffer and not one per instance count.
+	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+	srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	srvDesc.Buffer.FirstElement = 0;
+	srvDesc.Buffer.NumElements = frameBuffer.capacity;
+	srvDesc.Buffer.StructureByteStride = m_Data.GetStride();
+	srvDesc.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_NONE;
+
+	// Upload heap resources stay in the generic read state.
+	pCommandList->BindBuffer(rootParameterIndex, descriptorOffset, frameBuffer.pBuffer, &srvDesc, D3D12_RESOURCE_STATE_GENERIC_READ);
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include "DX12/NewCore/Resources.h"
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace RS
+{
+	class CommandList;
+
+	/*
+	* Compact instance of a 2D quad, 16 bytes. Shaders unpack the size with f16tof32 and the color with shifts.
+	*/
+	struct PackedInstance2D
+	{
+		float x;
+		float y;
+		uint32 size;			// Width and height as half floats, the width in the low half.
+		uint32 colorAndType;	// Red, green and blue in the low three bytes, the type in the high byte.
+
+		static PackedInstance2D Pack(float x, float y, float width, float height, float red, float green, float blue, uint8 type);
+	};
+
+	/*
+	* The CPU side of an InstanceStream, it does not need a device. Holds the latest data of every instance and, for each
+	* of the copies on the GPU, which blocks of instances changed since that copy was last written.
+	* Not thread safe.
+	*/
+	class InstanceStreamData
+	{
+	public:
+		// Instances per dirty flag. Smaller blocks upload less but take more time to find.
+		static constexpr uint32 BlockSize = 64;
+
+		// In bytes.
+		struct Range
+		{
+			uint64 offset;
+			uint64 size;
+		};
+
+	public:
+		InstanceStreamData(uint32 stride, uint32 copyCount);
+
+		/*
+		* New instances are zeroed and flagged as changed.
+		*/
+		void Resize(uint32 count);
+
+		/*
+		* Copies the instance, it is only flagged as changed when its bytes differ. Writing every instance every frame
+		* only uploads the ones that changed.
+		*/
+		void Write(uint32 index, const void* pInstance);
+
+		/*
+		* Flags instances as changed in every copy. For when they are written through GetData.
+		*/
+		void MarkDirty(uint32 first, uint32 count);
+
+		/*
+		* Flags every instance as changed in one copy, for when the copy was recreated.
+		*/
+		void MarkCopyDirty(uint32 copy);
+
+		/*
+		* Gives the byte ranges that changed since the copy was last written, adjacent blocks merged, and clears them.
+		*/
+		void TakeDirtyRanges(uint32 copy, std::vector<Range>& ranges);
+
+		uint8* GetData() { return m_Data.data(); }
+		const uint8* GetData() const { return m_Data.data(); }
+		uint32 GetCount() const { return m_Count; }
+		uint32 GetStride() const { return m_Stride; }
+		uint64 GetSize() const { return (uint64)m_Count * m_Stride; }
+
+	private:
+		void SetDirty(uint32 firstBlock, uint32 lastBlock);
+
+	private:
+		uint32 m_Stride;
+		uint32 m_Count = 0;
+		std::vector<uint8> m_Data;
+		std::vector<std::vector<uint64>> m_DirtyBlocks; // One bit per block, per copy.
+	};
+
+	/*
+	* Instance data in an upload heap buffer per frame in flight, which stays mapped. Commit writes the instances that
+	* changed since the buffer of this frame was last used straight into it, there is no copy on the GPU.
+	* Use InstanceStream<T>.
+	*/
+	class InstanceStreamBase
+	{
+	public:
+		RS_NO_COPY_AND_MOVE(InstanceStreamBase)
+
+		/*
+		* Copies the changed instances into the buffer of the current frame, call it once per frame before Bind.
+		*/
+		void Commit();
+
+		/*
+		* Binds the buffer of the current frame as a structured buffer SRV.
+		*/
+		void Bind(const std::shared_ptr<CommandList>& pCommandList, uint32 rootParameterIndex, uint32 descriptorOffset);
+
+		uint32 GetCount() const { return m_Data.GetCount(); }
+		void Resize(uint32 count) { m_Data.Resize(count); }
+
+		// Bytes written by the last Commit.
+		uint64 GetCommittedBytes() const { return m_CommittedBytes; }
+
+		/*
+		* Bytes written by all streams since the last call, the engine loop puts it in the frame stats.
+		*/
+		static uint64 TakeUploadedBytes() { return s_UploadedBytes.exchange(0); }
+
+	protected:
+		InstanceStreamBase(uint32 stride, const std::string& name);
+		~InstanceStreamBase();
+
+	protected:
+		InstanceStreamData m_Data;
+
+	private:
+		struct FrameBuffer
+		{
+			std::shared_ptr<Buffer> pBuffer;
+			uint8* pMapped = nullptr;
+			uint32 capacity = 0;	// Instances.
+		};
+
+		std::string m_Name;
+		std::array<FrameBuffer, FRAME_BUFFER_COUNT> m_FrameBuffers;
+		std::vector<InstanceStreamData::Range> m_Ranges;
+		uint32 m_CommittedFrameIndex = UINT32_MAX;
+		uint64 m_CommittedBytes = 0;
+
+		inline static std::atomic<uint64> s_UploadedBytes = 0;
+	};
+
+	template<typename T>
+	class InstanceStream : public InstanceStreamBase
+	{
+	public:
+		static_assert(std::is_trivially_copyable_v<T>, "Instances are copied as bytes!");
+
+		explicit InstanceStream(const std::string& name)
+			: InstanceStreamBase((uint32)sizeof(T), name) {}
+
+		void Write(uint32 index, const T& instance) { m_Data.Write(index, &instance); }
+
+		const T& operator[](uint32 index) const { return reinterpret_cast<const T*>(m_Data.GetData())[index]; }
+	};
+}
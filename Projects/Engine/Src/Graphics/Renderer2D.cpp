@@ -1,63 +1,171 @@
 #include "PreCompiled.h"
 #include "Renderer2D.h"
 
+#include "Maths/GLMDefines.h"
+#include "glm/gtc/matrix_transform.hpp"
+#include "glm/ext/matrix_clip_space.hpp"
+
+#include "DX12/Final/DXCommandContext.h"
+#include "DX12/Final/DXColorBuffer.h"
+#include "DX12/Final/DXShader.h"
+
+#include "Graphics/RenderCore.h"
+
+// DXGraphicsContext::SetDynamicVB copies whole 16 byte blocks from a 16 byte aligned pointer.
+static_assert(sizeof(RS::Instance2D) % 16 == 0);
+
+std::shared_ptr<RS::Renderer2D> RS::Renderer2D::Get()
+{
+    static std::shared_ptr<Renderer2D> s_Renderer2D = std::make_shared<Renderer2D>();
+    return s_Renderer2D;
+}
+
 void RS::Renderer2D::Init()
 {
+    // One draw is uploaded as one allocation, which has to fit in a page of the upload buffer.
+    Batch2DSettings settings;
+    settings.maxInstancesPerDraw = (uint32)(_2MB / sizeof(Instance2D));
+    m_Batch = Batch2D(settings);
+
+    CreateRootSignature();
+    CreateGraphicsPSO();
+
+    const uint32 white = 0xFFFFFFFF;
+    m_pWhiteTexture = std::make_shared<DX12::DXTexture>();
+    m_pWhiteTexture->Create2D(sizeof(white), 1, 1, DXGI_FORMAT_R8G8B8A8_UNORM, &white);
+    m_Textures.push_back(m_pWhiteTexture);
 }
 
 void RS::Renderer2D::Destory()
 {
+    m_Batch.Clear();
+    m_Textures.clear();
+    m_TextureIndices.clear();
+    m_pWhiteTexture.reset();
 }
 
 void RS::Renderer2D::DrawRect(float x, float y, float width, float height, Color32 color)
 {
+    m_Batch.DrawRect(x, y, width, height, color);
+}
+
+void RS::Renderer2D::DrawCircle(float x, float y, float radius, Color32 color, float thickness)
+{
+    m_Batch.DrawCircle(x, y, radius, color, thickness);
+}
+
+void RS::Renderer2D::DrawLine(float x0, float y0, float x1, float y1, float thickness, Color32 color)
+{
+    m_Batch.DrawLine(x0, y0, x1, y1, thickness, color);
 }
 
-void RS::Renderer2D::DrawCircle(float x, float y, float radius, Color32 color)
+void RS::Renderer2D::DrawSprite(const std::shared_ptr<DX12::DXTexture>& pTexture, float x, float y, float width, float height, Color32 tint,
+    float u0, float v0, float u1, float v1, float rotation)
 {
+    m_Batch.DrawSprite(GetTextureIndex(pTexture), x, y, width, height, tint, u0, v0, u1, v1, rotation);
 }
 
-void RS::Renderer2D::Render()
+uint16 RS::Renderer2D::GetTextureIndex(const std::shared_ptr<DX12::DXTexture>& pTexture)
 {
+    if (!pTexture)
+        return Batch2D::NO_TEXTURE;
+
+    auto it = m_TextureIndices.find(pTexture.get());
+    if (it != m_TextureIndices.end())
+        return it->second;
+
+    RS_ASSERT(m_Textures.size() < Batch2D::MAX_TEXTURES, "Renderer2D can use at most {} textures in a frame!", Batch2D::MAX_TEXTURES);
+    const uint16 index = (uint16)m_Textures.size();
+    m_Textures.push_back(pTexture);
+    m_TextureIndices[pTexture.get()] = index;
+    return index;
+}
+
+void RS::Renderer2D::Render(DX12::DXGraphicsContext& context, DX12::DXColorBuffer& target)
+{
+    m_Batch.Build();
+    const std::vector<Draw2D>& draws = m_Batch.GetDraws();
+    if (!draws.empty())
+    {
+        RS_GPU_PROFILE_SCOPE(context, "Renderer2D");
+
+        glm::mat4 projection = glm::transpose(glm::orthoRH(0.f, (float)target.GetWidth(), 0.f, (float)target.GetHeight(), -10.f, 10.f));
+
+        for (const std::shared_ptr<DX12::DXTexture>& pTexture : m_Textures)
+            context.TransitionResource(*pTexture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        context.TransitionResource(target, D3D12_RESOURCE_STATE_RENDER_TARGET);
+
+        context.SetRootSignature(m_RootSignature);
+        context.SetRenderTarget(target.GetRTV());
+        context.SetViewportAndScissor(0, 0, target.GetWidth(), target.GetHeight());
+        context.SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+        context.SetDynamicConstantBufferView(0, sizeof(projection), &projection);
+
+        // Draws are in the order the batch sorted them, the instances of each go through the upload memory of the context.
+        const std::vector<Instance2D>& instances = m_Batch.GetInstances();
+        BlendMode2D blendMode = BlendMode2D::COUNT;
+        for (const Draw2D& draw : draws)
+        {
+            if (draw.blendMode != blendMode)
+            {
+                blendMode = draw.blendMode;
+                context.SetPipelineState(m_GraphicsPSOs[(uint32)blendMode]);
+            }
+
+            context.SetDynamicDescriptor(1, 0, m_Textures[draw.texture]->GetSRV());
+            context.SetDynamicVB(0, draw.instanceCount, sizeof(Instance2D), &instances[draw.firstInstance]);
+            context.DrawInstanced(6, draw.instanceCount);
+        }
+    }
+
+    m_Batch.Clear();
+    m_Textures.resize(1);
+    m_TextureIndices.clear();
 }
 
 void RS::Renderer2D::CreateRootSignature()
 {
+    m_RootSignature.Reset(2, 1);
+    m_RootSignature[0].InitAsConstantBuffer(0);
+    m_RootSignature[1].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0, 1, D3D12_SHADER_VISIBILITY_PIXEL); // Sprite Texture
+    m_RootSignature.InitStaticSampler(0, RenderCore::SamplerLinearClampDesc, D3D12_SHADER_VISIBILITY_PIXEL);
+    m_RootSignature.Finalize(L"Renderer2D_RootSignature", D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
 }
 
 void RS::Renderer2D::CreateGraphicsPSO()
 {
-    RS::Shader shader;
-    RS::Shader::Description shaderDesc{};
-    shaderDesc.path = "Game/EntityShader.hlsl";
-    shaderDesc.typeFlags = RS::Shader::TypeFlag::Pixel | RS::Shader::TypeFlag::Vertex;
+    DX12::DXShader shader;
+    DX12::DXShader::Description shaderDesc{};
+    shaderDesc.isInternalPath = true;
+    shaderDesc.path = "Core/Renderer2DShader.hlsl";
+    shaderDesc.typeFlags = DX12::DXShader::TypeFlag::Pixel | DX12::DXShader::TypeFlag::Vertex;
     shader.Create(shaderDesc);
 
-    std::vector<RS::InputElementDesc> inputElementDescs;
-    // TODO: Move this, and don't hardcode it!
+    // Everything is per primitive, see Instance2D.
+    const D3D12_INPUT_ELEMENT_DESC inputElementDescs[] =
+    {
+        { "RECT", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, offsetof(Instance2D, x), D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+        { "ROTATION", 0, DXGI_FORMAT_R32G32_FLOAT, 0, offsetof(Instance2D, rotation), D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+        { "UVRECT", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, offsetof(Instance2D, u0), D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+        { "COLOR", 0, DXGI_FORMAT_R32G32_UINT, 0, offsetof(Instance2D, color), D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+    };
+
+    const D3D12_BLEND_DESC blendDescs[] = { RenderCore::BlendTraditional, RenderCore::BlendTraditionalAdditive };
+    static_assert(_countof(blendDescs) == (uint32)BlendMode2D::COUNT);
+    for (uint32 i = 0; i < (uint32)BlendMode2D::COUNT; ++i)
     {
-        RS::InputElementDesc inputElementDesc = {};
-        inputElementDesc.SemanticName = "SV_POSITION";
-        inputElementDesc.SemanticIndex = 0;
-        inputElementDesc.Format = DXGI_FORMAT_R32G32B32_FLOAT;
-        inputElementDesc.InputSlot = 0;
-        inputElementDesc.AlignedByteOffset = 0;
-        inputElementDesc.InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA;
-        inputElementDesc.InstanceDataStepRate = 0;
-        inputElementDescs.push_back(inputElementDesc);
-
-        inputElementDescs.push_back({ "UV", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 });
+        DX12::DXGraphicsPSO& pso = m_GraphicsPSOs[i];
+        pso.SetRootSignature(m_RootSignature);
+        pso.SetRasterizerState(RenderCore::RasterizerTwoSided);
+        pso.SetBlendState(blendDescs[i]);
+        pso.SetDepthStencilState(RenderCore::DepthStateDisabled);
+        pso.SetSampleMask(0xFFFFFFFF);
+        pso.SetInputLayout(_countof(inputElementDescs), inputElementDescs);
+        pso.SetPrimitiveTopologyType(D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE);
+        pso.SetShader(shader);
+        pso.SetRenderTargetFormat(DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_UNKNOWN);
+        pso.Finalize(false);
     }
 
-    m_GraphicsPSO.SetDefaults();
-    m_GraphicsPSO.SetInputLayout(inputElementDescs);
-    m_GraphicsPSO.SetRootSignature(m_pRootSignature);
-    m_GraphicsPSO.SetShader(&shader);
-    m_GraphicsPSO.SetRTVFormats({ DXGI_FORMAT_R8G8B8A8_UNORM });
-    m_GraphicsPSO.SetDSVFormat(DXGI_FORMAT_UNKNOWN);
-    D3D12_RASTERIZER_DESC rasterizerDesc = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
-    rasterizerDesc.CullMode = D3D12_CULL_MODE_NONE;
-    rasterizerDesc.FrontCounterClockwise = false;
-    m_GraphicsPSO.SetRasterizerState(rasterizerDesc);
-    m_GraphicsPSO.Create();
+    shader.Release();
 }
@@ -1,32 +1,60 @@
 #pragma once
 
 #include "Graphics/Color.h"
-#include "DX12/NewCore/RootSignature.h"
-#include "DX12/NewCore/GraphicsPSO.h"
-#include "DX12/NewCore/Resources.h"
+#include "Graphics/Batch2D.h"
+#include "DX12/Final/DXRootSignature.h"
+#include "DX12/Final/DXPipelineState.h"
+#include "DX12/Final/DXTexture.h"
+
+#include <array>
+#include <unordered_map>
 
 namespace RS
 {
+	namespace DX12
+	{
+		class DXGraphicsContext;
+		class DXColorBuffer;
+	}
+
+	/*
+	* Immediate mode 2D renderer on the DXCore path. Everything drawn in a frame is sorted and merged into as few instanced
+	* draws as possible in Render, see Batch2D. Positions are in pixels of the render target with y going up.
+	*/
 	class Renderer2D
 	{
 	public:
+		static std::shared_ptr<Renderer2D> Get();
 
 		void Init();
 		void Destory();
 
+		void SetLayer(int16 layer) { m_Batch.SetLayer(layer); }
+		void SetBlendMode(BlendMode2D blendMode) { m_Batch.SetBlendMode(blendMode); }
+
 		void DrawRect(float x, float y, float width, float height, Color32 color);
-		void DrawCircle(float x, float y, float radius, Color32 color);
+		void DrawCircle(float x, float y, float radius, Color32 color, float thickness = 0.f);
+		void DrawLine(float x0, float y0, float x1, float y1, float thickness, Color32 color);
+		void DrawSprite(const std::shared_ptr<DX12::DXTexture>& pTexture, float x, float y, float width, float height, Color32 tint = Color::WHITE,
+			float u0 = 0.f, float v0 = 0.f, float u1 = 1.f, float v1 = 1.f, float rotation = 0.f);
 
-		void Render();
+		// Draws on top of what is in the target, which has to be DXGI_FORMAT_R8G8B8A8_UNORM.
+		void Render(DX12::DXGraphicsContext& context, DX12::DXColorBuffer& target);
 
 	private:
+		uint16 GetTextureIndex(const std::shared_ptr<DX12::DXTexture>& pTexture);
 		void CreateRootSignature();
 		void CreateGraphicsPSO();
 
 	private:
-		std::shared_ptr<RS::RootSignature> m_pRootSignature;
-		RS::GraphicsPSO m_GraphicsPSO;
-		std::shared_ptr<RS::VertexBuffer> m_pVertexBufferResource;
-		Microsoft::WRL::ComPtr<ID3D12Resource> m_ConstantBufferResource;
+		Batch2D m_Batch;
+
+		// The textures used this frame, index 0 is the white texture used by shapes.
+		std::vector<std::shared_ptr<DX12::DXTexture>> m_Textures;
+		std::unordered_map<DX12::DXTexture*, uint16> m_TextureIndices;
+		std::shared_ptr<DX12::DXTexture> m_pWhiteTexture;
+
+		DX12::DXRootSignature m_RootSignature;
+		std::array<DX12::DXGraphicsPSO, (uint32)BlendMode2D::COUNT> m_GraphicsPSOs;
 	};
 }
@@ -0,0 +1,189 @@
+#include "PreCompiled.h"
+#include "TextLayout.h"
+
+#include "Utils/Misc/StringUtils.h"
+#include "Utils/Misc/HashUtils.h"
+
+namespace RS::_TextLayoutInternal
+{
+	struct PlacedGlyph
+	{
+		AtlasGlyph glyph;
+		float x;
+		uint32 line;
+	};
+}
+
+void RS::TextLayout::AppendTo(GlyphBatch& batch, float x, float y, uint32 color) const
+{
+	if (batch.pages.size() < glyphs.pages.size())
+		batch.pages.resize(glyphs.pages.size());
+
+	for (uint64 pageIndex = 0; pageIndex < glyphs.pages.size(); ++pageIndex)
+	{
+		const std::vector<GlyphInstance>& source = glyphs.pages[pageIndex];
+		std::vector<GlyphInstance>& destination = batch.pages[pageIndex];
+		const uint64 first = destination.size();
+		destination.insert(destination.end(), source.begin(), source.end());
+		for (uint64 i = first; i < destination.size(); ++i)
+		{
+			destination[i].x += x;
+			destination[i].y += y;
+			destination[i].color = color;
+		}
+	}
+}
+
+void RS::TextLayout::Build(GlyphAtlas& atlas, std::string_view text, const TextLayoutSettings& settings, TextLayout& layout)
+{
+	using namespace _TextLayoutInternal;
+
+	layout.glyphs.Clear();
+	layout.width = 0.f;
+	layout.height = 0.f;
+	layout.lineCount = 0;
+	if (text.empty())
+		return;
+
+	const float scale = settings.scale;
+	const bool wrap = settings.maxWidth > 0.f;
+
+	// Glyphs are placed on lines first, a wrap moves the glyphs after the last space down to the next line.
+	std::vector<PlacedGlyph> placed;
+	placed.reserve(text.size());
+	float x = 0.f;
+	uint32 line = 0;
+	uint32 previous = 0;
+	uint64 lineStart = 0;
+	uint64 breakIndex = UINT64_MAX;	// The first glyph after the last space on the line.
+	float breakX = 0.f;
+	size_t offset = 0;
+	while (offset < text.size())
+	{
+		const uint32 codepoint = Utils::DecodeUTF8(text, offset);
+		if (codepoint == '\n')
+		{
+			x = 0.f;
+			line++;
+			previous = 0;
+			lineStart = placed.size();
+			breakIndex = UINT64_MAX;
+			continue;
+		}
+
+		if (previous != 0)
+			x += atlas.GetKerning(previous, codepoint) * scale;
+		previous = codepoint;
+
+		const AtlasGlyph glyph = atlas.GetGlyph(codepoint);
+		const float advance = glyph.advance * scale;
+		if (codepoint == ' ')
+		{
+			x += advance;
+			breakIndex = placed.size();
+			breakX = x;
+			continue;
+		}
+
+		if (wrap && placed.size() > lineStart && x + advance > settings.maxWidth)
+		{
+			if (breakIndex != UINT64_MAX && breakIndex > lineStart)
+			{
+				for (uint64 i = breakIndex; i < placed.size(); ++i)
+				{
+					placed[i].x -= breakX;
+					placed[i].line++;
+				}
+				x -= breakX;
+				lineStart = breakIndex;
+			}
+			else
+			{
+				// One word wider than the line, it is broken before this glyph.
+				x = 0.f;
+				lineStart = placed.size();
+			}
+			line++;
+			breakIndex = UINT64_MAX;
+		}
+
+		placed.push_back({ glyph, x, line });
+		x += advance;
+	}
+
+	const float lineHeight = atlas.GetLineHeight() * settings.lineSpacing * scale;
+	for (const PlacedGlyph& glyph : placed)
+	{
+		layout.glyphs.Add(glyph.glyph, glyph.x, -(float)glyph.line * lineHeight, scale, 0);
+		layout.width = std::max(layout.width, glyph.x + glyph.glyph.advance * scale);
+	}
+	layout.lineCount = line + 1;
+	layout.height = layout.lineCount * lineHeight;
+}
+
+RS::TextLayoutCache::TextLayoutCache(uint32 capacity)
+	: m_Capacity(capacity)
+{
+	RS_ASSERT(capacity > 0, "A layout cache needs room for at least one layout!");
+}
+
+bool RS::TextLayoutCache::IsSame(const Entry& entry, uint32 fontIndex, std::string_view text, const TextLayoutSettings& settings) const
+{
+	return entry.fontIndex == fontIndex && entry.text == text && entry.settings.scale == settings.scale &&
+		entry.settings.maxWidth == settings.maxWidth && entry.settings.lineSpacing == settings.lineSpacing;
+}
+
+const RS::TextLayout& RS::TextLayoutCache::Get(GlyphAtlas& atlas, uint32 fontIndex, std::string_view text, const TextLayoutSettings& settings)
+{
+	uint64 hash = Utils::Hash(text, fontIndex);
+	hash = Utils::CombineHash64(hash, Utils::Hash(settings.scale, settings.maxWidth));
+	hash = Utils::CombineHash64(hash, Utils::Hash(settings.lineSpacing));
+
+	auto it = m_EntryMap.find(hash);
+	if (it != m_EntryMap.end())
+	{
+		// Move it to the front, it is now the most recently used.
+		m_Entries.splice(m_Entries.begin(), m_Entries, it->second);
+		Entry& entry = m_Entries.front();
+		if (IsSame(entry, fontIndex, text, settings))
+		{
+			m_HitCount++;
+			return entry.layout;
+		}
+
+		// A different text with the same hash, the entry is reused for the new one.
+		m_MissCount++;
+		entry.text = text;
+		entry.fontIndex = fontIndex;
+		entry.settings = settings;
+		TextLayout::Build(atlas, text, settings, entry.layout);
+		return entry.layout;
+	}
+
+	m_MissCount++;
+	if (m_Entries.size() >= m_Capacity)
+	{
+		// The oldest layout makes room, its memory is reused for the new one.
+		m_EntryMap.erase(m_Entries.back().hash);
+		m_Entries.splice(m_Entries.begin(), m_Entries, std::prev(m_Entries.end()));
+	}
+	else
+	{
+		m_Entries.emplace_front();
+	}
+
+	Entry& entry = m_Entries.front();
+	entry.hash = hash;
+	entry.text = text;
+	entry.fontIndex = fontIndex;
+	entry.settings = settings;
+	TextLayout::Build(atlas, text, settings, entry.layout);
+	m_EntryMap[hash] = m_Entries.begin();
+	return entry.layout;
+}
+
+void RS::TextLayoutCache::Clear()
+{
+	m_Entries.clear();
+	m_EntryMap.clear();
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Graphics/GlyphAtlas.h"
+
+#include <list>
+#include <unordered_map>
+#include <string_view>
+
+namespace RS
+{
+	struct TextLayoutSettings
+	{
+		float scale = 1.f;
+		float maxWidth = 0.f;		// Lines are wrapped at spaces to stay within it, zero for no wrapping.
+		float lineSpacing = 1.f;	// Times the line height of the font.
+	};
+
+	/*
+	* Positioned glyphs of a text, relative to the pen start on the baseline of the first line. Following lines go down.
+	* The glyphs never move in the atlas, so a layout stays valid for as long as its atlas lives.
+	*/
+	struct TextLayout
+	{
+		GlyphBatch glyphs;			// The color is set when the layout is added to a batch.
+		float width = 0.f;			// Of the longest line.
+		float height = 0.f;			// Of all lines.
+		uint32 lineCount = 0;
+
+		// Copies the glyphs into the batch with the pen starting at (x, y).
+		void AppendTo(GlyphBatch& batch, float x, float y, uint32 color) const;
+
+		// UTF-8 text, with kerning and '\n' for new lines. Words longer than maxWidth are broken between glyphs.
+		static void Build(GlyphAtlas& atlas, std::string_view text, const TextLayoutSettings& settings, TextLayout& layout);
+	};
+
+	/*
+	* Keeps the layouts of the most recently drawn texts, so text that does not change is laid out once.
+	* The least recently used layout is dropped when the cache is full.
+	*/
+	class TextLayoutCache
+	{
+	public:
+		TextLayoutCache(uint32 capacity = 256);
+
+		// The font index tells atlases apart. The reference is valid until the next call.
+		const TextLayout& Get(GlyphAtlas& atlas, uint32 fontIndex, std::string_view text, const TextLayoutSettings& settings);
+
+		void Clear();
+
+		uint32 GetSize() const { return (uint32)m_Entries.size(); }
+		uint32 GetCapacity() const { return m_Capacity; }
+		uint64 GetHitCount() const { return m_HitCount; }
+		uint64 GetMissCount() const { return m_MissCount; }
+
+	private:
+		struct Entry
+		{
+			uint64 hash;
+			std::string text;
+			uint32 fontIndex;
+			TextLayoutSettings settings;
+			TextLayout layout;
+		};
+
+		bool IsSame(const Entry& entry, uint32 fontIndex, std::string_view text, const TextLayoutSettings& settings) const;
+
+		uint32 m_Capacity;
+		uint64 m_HitCount = 0;
+		uint64 m_MissCount = 0;
+		std::list<Entry> m_Entries;	// Most recently used first.
+		std::unordered_map<uint64, std::list<Entry>::iterator> m_EntryMap;
+	};
+}
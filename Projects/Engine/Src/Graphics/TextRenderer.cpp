@@ -12,11 +12,85 @@
 #include "Utils/Utils.h"
 
 #include "Core/Console.h"
+#include "Core/VFS.h"
 
 #include "Graphics/RenderCore.h"
 
 RS_ADD_GLOBAL_CONSOLE_VAR(float, "Core.TextRenderer.threshold", g_Threshold, 0.55f, "SDF text threshold");
 
+namespace RS::_TextRendererInternal
+{
+    /*
+    * Renders SDF glyphs from a FreeType face on demand. FreeType reads from the memory until the face is destroyed,
+    * so the file is kept open with it.
+    */
+    class FreeTypeGlyphRasterizer : public IGlyphRasterizer
+    {
+    public:
+        FreeTypeGlyphRasterizer(FT_Face pFace, std::shared_ptr<VFSFile> pFile)
+            : m_pFace(pFace), m_pFile(std::move(pFile))
+        {
+        }
+
+        ~FreeTypeGlyphRasterizer()
+        {
+            FT_Done_Face(m_pFace);
+        }
+
+        bool Rasterize(uint32 codepoint, GlyphBitmap& bitmap) override
+        {
+            if (FT_Get_Char_Index(m_pFace, codepoint) == 0)
+                return false;
+
+            FT_Error error = FT_Load_Char(m_pFace, codepoint, FT_LOAD_DEFAULT);
+            if (error != FT_Err_Ok)
+            {
+                RS_LOG_WARNING("Failed to load glyph U+{:04X}!", codepoint);
+                return false;
+            }
+
+            FT_GlyphSlot slot = m_pFace->glyph;
+            error = FT_Render_Glyph(slot, FT_RENDER_MODE_SDF);
+            if (error != FT_Err_Ok)
+            {
+                RS_LOG_WARNING("Failed to render SDF glyph U+{:04X}!", codepoint);
+                return false;
+            }
+
+            bitmap.width = slot->bitmap.width;
+            bitmap.height = slot->bitmap.rows;
+            bitmap.bearingX = slot->bitmap_left;
+            bitmap.bearingY = slot->bitmap_top;
+            bitmap.advance = slot->advance.x / 64.f;
+            bitmap.pixels.resize((uint64)bitmap.width * bitmap.height);
+            for (uint32 row = 0; row < bitmap.height; ++row)
+                std::memcpy(&bitmap.pixels[(uint64)row * bitmap.width], slot->bitmap.buffer + (int64)row * slot->bitmap.pitch, bitmap.width);
+            return true;
+        }
+
+        float GetLineHeight() const override
+        {
+            return m_pFace->size->metrics.height / 64.f;
+        }
+
+        bool HasKerning() const override
+        {
+            return FT_HAS_KERNING(m_pFace);
+        }
+
+        float GetKerning(uint32 left, uint32 right) override
+        {
+            FT_Vector delta = {};
+            FT_Get_Kerning(m_pFace, FT_Get_Char_Index(m_pFace, left), FT_Get_Char_Index(m_pFace, right), FT_KERNING_DEFAULT, &delta);
+            return delta.x / 64.f;
+        }
+
+    private:
+        FT_Face m_pFace;
+        std::shared_ptr<VFSFile> m_pFile;
+    };
+}
+
 std::shared_ptr<RS::TextRenderer> RS::TextRenderer::Get()
 {
     static std::shared_ptr<TextRenderer> s_Freetype = std::make_shared<TextRenderer>();
@@ -37,17 +111,31 @@ void RS::TextRenderer::Init()
 
 void RS::TextRenderer::Destory()
 {
+    // The atlases own the faces, which have to go before the library.
+    m_LayoutCache.Clear();
+    m_Fonts.clear();
+    m_FontNameToIndex.clear();
     FT_Done_FreeType(m_pLibrary);
     m_pRootSignature.reset();
-    m_pVertexBufferResource.reset();
+    m_pInstanceBuffer.reset();
 }
 
 bool RS::TextRenderer::AddFont(const std::string& fontPath)
 {
-    uint fontCount = (uint)m_FontNameToTextureListIndex.size();
+    using namespace _TextRendererInternal;
+
+    if (m_FontNameToIndex.contains(fontPath))
+        return true;
+
+    std::shared_ptr<VFSFile> pFile = VFS::Get()->Open(fontPath);
+    if (!pFile)
+    {
+        RS_LOG_ERROR("Coult not open font file '{}'!", fontPath);
+        return false;
+    }
 
     FT_Face pFace;
-    FT_Error error = FT_New_Face(m_pLibrary, fontPath.c_str(), 0, &pFace);
+    FT_Error error = FT_New_Memory_Face(m_pLibrary, (const FT_Byte*)pFile->GetPtr(), (FT_Long)pFile->GetSize(), 0, &pFace);
     if (error != FT_Err_Ok)
     {
         RS_LOG_ERROR("Coult not load font '{}' for freetype!", fontPath);
@@ -56,72 +144,69 @@ bool RS::TextRenderer::AddFont(const std::string& fontPath)
 
     FT_Set_Pixel_Sizes(pFace, 0, 48); // Set size of this font.
 
-    FT_GlyphSlot slot = pFace->glyph;
-
-    auto pCommandQueue = RS::DX12Core3::Get()->GetDirectCommandQueue();
-    auto pCommandList = pCommandQueue->GetCommandList();
-
-    std::unordered_map<char, std::shared_ptr<Texture>> textures;
-    m_Characters.clear();
-    for (unsigned char c = 0; c < 255; c++)
-    {
-        error = FT_Load_Char(pFace, c, FT_LOAD_RENDER);
-        if (error != FT_Err_Ok)
-        {
-            RS_LOG_WARNING("Failed to load Glyph '{}'", (char)c);
-            continue;
-        }
+    // Glyphs are added to the atlas when they are first drawn, ASCII is loaded up front as it is the most common.
+    Font font;
+    font.pAtlas = std::make_unique<GlyphAtlas>(std::make_unique<FreeTypeGlyphRasterizer>(pFace, pFile));
+    font.pAtlas->Preload(32, 126);
 
-        error = FT_Render_Glyph(slot, FT_RENDER_MODE_SDF);
-        if (error != FT_Err_Ok)
-        {
-            RS_LOG_WARNING("Failed to render SDF glyph '{}'!", (char)c);
-            continue;
-        }
+    m_FontNameToIndex.insert(std::pair<std::string, uint>(fontPath, (uint)m_Fonts.size()));
+    m_Fonts.push_back(std::move(font));
+    return true;
+}
 
-        // TODO: Render to an atlas instead of multiple textures!
-        std::string name = Utils::Format("Font {} {} Texture", fontCount, (char)c);
-        std::shared_ptr<Texture> pTexture = nullptr;// GetRenderCore()->pTextureBlack;
-        RS_ASSERT(pTexture != nullptr);
-        if (slot->bitmap.width != 0 && slot->bitmap.rows != 0)
-            pTexture = pCommandList->CreateTexture(slot->bitmap.width, slot->bitmap.rows, (const uint8*)slot->bitmap.buffer,
-            DXGI_FORMAT_R8_UNORM, name);
-        textures[(char)c] = pTexture;
-        Character character = {
-            -1,
-            slot->bitmap.width, slot->bitmap.rows,
-            slot->bitmap_left, slot->bitmap_top,
-            slot->advance.x
-        };
-        m_Characters.insert(std::pair<char, Character>((char)c, character));
-    }
+void RS::TextRenderer::RenderText(const std::string& txt, uint posX, uint posY, float scale, const glm::vec3& color)
+{
+    TextLayoutSettings settings;
+    settings.scale = scale;
+    RenderText(txt, posX, posY, settings, color);
+}
 
-    m_FontNameToTextureListIndex.insert(std::pair<std::string, uint>(fontPath, (uint)m_TextureMapList.size()));
-    m_TextureMapList.push_back(textures);
-    FT_Done_Face(pFace);
+void RS::TextRenderer::RenderText(const std::string& txt, uint posX, uint posY, const TextLayoutSettings& settings, const glm::vec3& color)
+{
+    if (m_Fonts.empty())
+        return;
 
-    // Wait for load to finish.
-    uint64 fenceValue = pCommandQueue->ExecuteCommandList(pCommandList);
-    pCommandQueue->WaitForFenceValue(fenceValue);
-    return true;
+    uint fontIndex = 0; // TODO: Make this customizable!
+    Font& font = m_Fonts[fontIndex];
+    const TextLayout& layout = m_LayoutCache.Get(*font.pAtlas, fontIndex, txt, settings);
+    layout.AppendTo(font.batch, (float)posX, (float)posY, Color::ToColor32(color).Data);
 }
 
-void RS::TextRenderer::RenderText(const std::string& txt, uint posX, uint posY, float scale, const glm::vec3& color)
+const RS::TextLayout& RS::TextRenderer::GetLayout(const std::string& txt, const TextLayoutSettings& settings)
 {
-    RenderItem item;
-    item.text = txt;
-    item.x = posX;
-    item.y = posY;
-    item.scale = scale;
-    item.color = Color::ToColor32(color);
-    m_RenderItems.push_back(item);
+    static const TextLayout s_EmptyLayout;
+    if (m_Fonts.empty())
+        return s_EmptyLayout;
+
+    uint fontIndex = 0;
+    return m_LayoutCache.Get(*m_Fonts[fontIndex].pAtlas, fontIndex, txt, settings);
 }
 
 void RS::TextRenderer::Render(std::shared_ptr<RS::CommandList> pCommandList, std::shared_ptr<RenderTarget> pRenderTarget)
 {
-    if (m_RenderItems.empty())
+    m_Instances.clear();
+    for (Font& font : m_Fonts)
+    {
+        for (const std::vector<GlyphInstance>& page : font.batch.pages)
+            m_Instances.insert(m_Instances.end(), page.begin(), page.end());
+    }
+    if (m_Instances.empty())
         return;
 
+    UploadPages(pCommandList);
+
+    // One buffer holds the instances of every page, it only grows so it is not recreated every frame.
+    const uint64 instancesSize = m_Instances.size() * sizeof(GlyphInstance);
+    if (!m_pInstanceBuffer || m_pInstanceBuffer->GetSize() < instancesSize)
+    {
+        uint64 capacity = m_pInstanceBuffer ? m_pInstanceBuffer->GetSize() : 1024 * sizeof(GlyphInstance);
+        while (capacity < instancesSize)
+            capacity *= 2;
+        m_pInstanceBuffer = pCommandList->CreateVertexBufferResource(capacity, sizeof(GlyphInstance), "Text Renderer Instance Buffer");
+    }
+    pCommandList->UploadToBuffer(m_pInstanceBuffer, instancesSize, m_Instances.data());
+    pCommandList->TransitionBarrier(m_pInstanceBuffer, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
+
     std::shared_ptr<Texture> colorTexture = pRenderTarget->GetAttachment(AttachmentPoint::Color0);
     D3D12_RESOURCE_DESC desc = colorTexture->GetD3D12ResourceDesc();
 
@@ -144,59 +229,69 @@ void RS::TextRenderer::Render(std::shared_ptr<RS::CommandList> pCommandList, std
     pCommandList->SetPipelineState(m_GraphicsPSO);
     pCommandList->SetRenderTarget(pRenderTarget, CommandList::RenderTargetMode::ColorOnly);
     pCommandList->SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    pCommandList->SetVertexBuffers(0, m_pInstanceBuffer);
 
-    for (RenderItem& item : m_RenderItems)
+    struct PixelData
     {
-        glm::vec3 color = Color::ToVec3(item.color);
-        struct PixelData
-        {
-            glm::mat4 projection;
-            glm::vec3 textColor;
-            float threshold;
-        } pixelData = {
-            projection,
-            color,
-            g_Threshold
-        };
-        pCommandList->SetGraphicsDynamicConstantBuffer(0, sizeof(pixelData), (void*)& pixelData);
+        glm::mat4 projection;
+        float threshold;
+    } pixelData = {
+        projection,
+        g_Threshold
+    };
+    pCommandList->SetGraphicsDynamicConstantBuffer(0, sizeof(pixelData), (void*)&pixelData);
 
-        uint fontIndex = 0; // TODO: Make this customizable!
-        std::unordered_map<char, std::shared_ptr<Texture>>& textureMap = m_TextureMapList[fontIndex];
-        for (char c : item.text)
+    // One instanced draw per atlas page, the quad corners come from the vertex id.
+    uint32 firstInstance = 0;
+    for (Font& font : m_Fonts)
+    {
+        for (uint32 pageIndex = 0; pageIndex < (uint32)font.batch.pages.size(); ++pageIndex)
         {
-            auto it = m_Characters.find(c);
-            if (it == m_Characters.end())
+            const uint32 instanceCount = (uint32)font.batch.pages[pageIndex].size();
+            if (instanceCount == 0)
                 continue;
 
-            Character& ch = it->second;
-
-            float xpos = item.x + ch.BearingX * item.scale;
-            float ypos = item.y - (ch.SizeY - ch.BearingY) * item.scale;
+            pCommandList->BindTexture(1, 0, font.pageTextures[pageIndex].pTexture);
+            pCommandList->DrawInstanced(6, instanceCount, 0, firstInstance);
+            firstInstance += instanceCount;
+        }
+        font.batch.Clear();
+    }
+}
 
-            float w = ch.SizeX * item.scale;
-            float h = ch.SizeY * item.scale;
+void RS::TextRenderer::UploadPages(std::shared_ptr<RS::CommandList> pCommandList)
+{
+    for (uint32 fontIndex = 0; fontIndex < (uint32)m_Fonts.size(); ++fontIndex)
+    {
+        Font& font = m_Fonts[fontIndex];
+        const GlyphAtlas& atlas = *font.pAtlas;
+        font.pageTextures.resize(atlas.GetPageCount());
+        for (uint32 pageIndex = 0; pageIndex < atlas.GetPageCount(); ++pageIndex)
+        {
+            const GlyphAtlas::Page& page = atlas.GetPage(pageIndex);
+            PageTexture& pageTexture = font.pageTextures[pageIndex];
+            if (pageTexture.pTexture && pageTexture.version == page.version)
+                continue;
 
-            glm::vec4 triangleVertices[] =
+            // A grown page needs a new texture, otherwise only the new glyphs changed and the texture is reused.
+            if (!pageTexture.pTexture || pageTexture.width != page.width || pageTexture.height != page.height)
+            {
+                std::string name = Utils::Format("Font {} Atlas Page {}", fontIndex, pageIndex);
+                pageTexture.pTexture = pCommandList->CreateTexture(page.width, page.height, page.pixels.data(), DXGI_FORMAT_R8_UNORM, name);
+                pageTexture.width = page.width;
+                pageTexture.height = page.height;
+            }
+            else
             {
-                { xpos    , ypos + h, 0.0f, 0.0f }, // TL
-                { xpos + w, ypos + h, 1.0f, 0.0f }, // TR
-                { xpos    , ypos    , 0.0f, 1.0f }, // BL
-
-                { xpos + w, ypos + h, 1.0f, 0.0f }, // TR
-                { xpos + w, ypos    , 1.0f, 1.0f }, // BR
-                { xpos    , ypos    , 0.0f, 1.0f }  // BL
-            };
-            pCommandList->UploadToBuffer(m_pVertexBufferResource, sizeof(glm::vec4) * 6, (void*)&triangleVertices[0]);
-            pCommandList->SetVertexBuffers(0, m_pVertexBufferResource);
-            std::shared_ptr<Texture>& pTexture = textureMap[c];
-            pCommandList->BindTexture(1, 0, pTexture);
-            pCommandList->DrawInstanced(6, 1, 0, 0);
-
-            item.x += (ch.Advance >> 6) * item.scale;
+                D3D12_SUBRESOURCE_DATA textureData = {};
+                textureData.pData = page.pixels.data();
+                textureData.RowPitch = page.width;
+                textureData.SlicePitch = (LONG_PTR)page.width * page.height;
+                pCommandList->UploadTextureSubresourceData(pageTexture.pTexture, 0, 1, &textureData);
+            }
+            pageTexture.version = page.version;
         }
     }
-
-    m_RenderItems.clear();
 }
 
 void RS::TextRenderer::InitRenderData()
@@ -235,15 +330,22 @@ void RS::TextRenderer::InitRenderData()
 
     std::vector<RS::InputElementDesc> inputElementDescs;
     {
-        RS::InputElementDesc inputElementDesc = {};
-        inputElementDesc.SemanticName = "SV_POSITION";
-        inputElementDesc.SemanticIndex = 0;
-        inputElementDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
-        inputElementDesc.InputSlot = 0;
-        inputElementDesc.AlignedByteOffset = 0;
-        inputElementDesc.InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA;
-        inputElementDesc.InstanceDataStepRate = 0;
-        inputElementDescs.push_back(inputElementDesc);
+        // Everything is per glyph, see GlyphInstance.
+        auto AddInstanceElement = [&](const char* pSemanticName, DXGI_FORMAT format, uint32 offset)
+        {
+            RS::InputElementDesc inputElementDesc = {};
+            inputElementDesc.SemanticName = pSemanticName;
+            inputElementDesc.SemanticIndex = 0;
+            inputElementDesc.Format = format;
+            inputElementDesc.InputSlot = 0;
+            inputElementDesc.AlignedByteOffset = offset;
+            inputElementDesc.InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA;
+            inputElementDesc.InstanceDataStepRate = 1;
+            inputElementDescs.push_back(inputElementDesc);
+        };
+        AddInstanceElement("RECT", DXGI_FORMAT_R32G32B32A32_FLOAT, offsetof(GlyphInstance, x));
+        AddInstanceElement("TEXRECT", DXGI_FORMAT_R16G16B16A16_UINT, offsetof(GlyphInstance, texelX));
+        AddInstanceElement("COLOR", DXGI_FORMAT_R32_UINT, offsetof(GlyphInstance, color));
     }
 
     m_GraphicsPSO.SetDefaults();
@@ -259,27 +361,4 @@ void RS::TextRenderer::InitRenderData()
     m_GraphicsPSO.Create();
 
     shader.Release();
-
-    auto pCommandQueue = RS::DX12Core3::Get()->GetDirectCommandQueue();
-    auto pCommandList = pCommandQueue->GetCommandList();
-
-    glm::vec2 minP(50, 500);
-    glm::vec2 maxP(600, 800);
-    glm::vec4 triangleVertices[] =
-    {
-        { minP.x, maxP.y, 0.0f, 1.0f }, // TL
-        { maxP.x, maxP.y, 1.0f, 1.0f }, // TR
-        { minP.x, minP.y, 0.0f, 0.0f }, // BL
-        { maxP.x, maxP.y, 1.0f, 1.0f }, // TR
-        { maxP.x, minP.y, 1.0f, 0.0f }, // BR
-        { minP.x, minP.y, 0.0f, 0.0f }  // BL
-    };
-    const UINT vertexBufferSize2 = sizeof(triangleVertices);
-    m_pVertexBufferResource = pCommandList->CreateVertexBufferResource(vertexBufferSize2, sizeof(glm::vec4), "Text Renderer Vertex Buffer");
-    pCommandList->UploadToBuffer(m_pVertexBufferResource, vertexBufferSize2, (void*)&triangleVertices[0]);
-
-    // Wait for load to finish.
-    uint64 fenceValue = pCommandQueue->ExecuteCommandList(pCommandList);
-    pCommandQueue->WaitForFenceValue(fenceValue);
 }
-
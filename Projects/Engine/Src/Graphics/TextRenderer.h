@@ -10,6 +10,8 @@
 #include "DX12/NewCore/RenderTarget.h"
 
 #include "Graphics/Color.h"
+#include "Graphics/GlyphAtlas.h"
+#include "Graphics/TextLayout.h"
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
@@ -18,17 +20,6 @@ namespace RS
 {
 	class TextRenderer
 	{
-	public:
-		struct Character
-		{
-			uint TextureID;
-			int SizeX;
-			int SizeY;
-			int BearingX;
-			int BearingY;
-			uint Advance;
-		};
-
 	public:
 		static std::shared_ptr<TextRenderer> Get();
 
@@ -37,32 +28,47 @@ namespace RS
 		
 		bool AddFont(const std::string& fontPath);
 
+		/*
+		* The text is UTF-8, glyphs are rasterised into the font atlas the first time they are used. The layout is cached,
+		* so drawing the same text again only copies its glyphs.
+		*/
 		void RenderText(const std::string& txt, uint posX, uint posY, float scale, const glm::vec3& color);
+		void RenderText(const std::string& txt, uint posX, uint posY, const TextLayoutSettings& settings, const glm::vec3& color);
+
+		// For measuring text before it is drawn. The reference is valid until the next call.
+		const TextLayout& GetLayout(const std::string& txt, const TextLayoutSettings& settings);
 
 		void Render(std::shared_ptr<RS::CommandList> pCommandList, std::shared_ptr<RenderTarget> pRenderTarget);
 	private:
 		void InitRenderData();
+		void UploadPages(std::shared_ptr<RS::CommandList> pCommandList);
 
 	private:
-		struct RenderItem
+		struct PageTexture
 		{
-			std::string text;
-			uint x, y;
-			float scale;
-			Color32 color;
+			std::shared_ptr<Texture> pTexture;
+			uint32 width = 0;
+			uint32 height = 0;
+			uint32 version = 0;
 		};
 
-	private:
-		std::unordered_map<char, Character> m_Characters;
-		std::vector<RenderItem> m_RenderItems;
+		struct Font
+		{
+			std::unique_ptr<GlyphAtlas> pAtlas;
+			std::vector<PageTexture> pageTextures;
+			GlyphBatch batch;
+		};
 
-		std::unordered_map<std::string, uint> m_FontNameToTextureListIndex;
-		std::vector<std::unordered_map<char, std::shared_ptr<Texture>>> m_TextureMapList;
+	private:
+		std::unordered_map<std::string, uint> m_FontNameToIndex;
+		std::vector<Font> m_Fonts;
+		TextLayoutCache m_LayoutCache;
 
 		FT_Library m_pLibrary = nullptr;
 
 		std::shared_ptr<RS::RootSignature> m_pRootSignature;
 		RS::GraphicsPSO m_GraphicsPSO;
-		std::shared_ptr<RS::VertexBuffer> m_pVertexBufferResource;
+		std::shared_ptr<RS::VertexBuffer> m_pInstanceBuffer;
+		std::vector<GlyphInstance> m_Instances;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,366 @@
+#include "PreCompiled.h"
+#include "MeshCooker.h"
+
+#include "Core/VFS.h"
+#include "Utils/Misc/xxhash.h"
+
+#include "Maths/GLMDefines.h"
+#include <glm/glm.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <chrono>
+#include <cmath>
+
+namespace RS::_MeshCookerInternal
+{
+	// Bump this when the output of the cooker changes, it makes every mesh cook again.
+	constexpr uint32 CookerVersion = 3;
+
+	struct CookHashData
+	{
+		uint64 sourceHash;
+		uint32 cookerVersion;
+		uint32 optimize;
+		uint32 cacheSize;
+		float overdrawThreshold;
+		uint32 lodCount;
+		float lodReduction;
+		float lodMaxError;
+		uint32 buildMeshlets;
+		uint32 maxMeshletVertices;
+		uint32 maxMeshletTriangles;
+		float meshletConeWeight;
+	};
+
+	bool TryNormalize(glm::vec3& v)
+	{
+		const float length = glm::length(v);
+		if (!(length > 1e-12f))
+			return false;
+		v *= 1.f / length;
+		return true;
+	}
+
+	// Any unit vector orthogonal to n, for vertices where the UVs do not define a direction.
+	glm::vec3 GetOrthogonal(const glm::vec3& n)
+	{
+		const glm::vec3 axis = std::abs(n.x) < 0.9f ? glm::vec3(1.f, 0.f, 0.f) : glm::vec3(0.f, 1.f, 0.f);
+		glm::vec3 result = glm::cross(axis, n);
+		if (!TryNormalize(result))
+			result = glm::vec3(1.f, 0.f, 0.f);
+		return result;
+	}
+
+	bool IsMeshFile(const std::filesystem::path& path)
+	{
+		std::string extension = path.extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return (char)std::tolower(c); });
+		return extension == ".fbx";
+	}
+}
+
+uint64 RS::MeshCooker::ComputeCookHash(std::span<const uint8> sourceData, const MeshCookSettings& settings)
+{
+	using namespace _MeshCookerInternal;
+	CookHashData data = {};
+	data.sourceHash = xxh::xxhash3<64>(sourceData.data(), sourceData.size());
+	data.cookerVersion = CookerVersion;
+	data.optimize = settings.optimize ? 1 : 0;
+	data.cacheSize = settings.optimizer.cacheSize;
+	data.overdrawThreshold = settings.optimizer.overdrawThreshold;
+	data.lodCount = settings.optimizer.lodCount;
+	data.lodReduction = settings.optimizer.lodReduction;
+	data.lodMaxError = settings.optimizer.lodMaxError;
+	data.buildMeshlets = settings.buildMeshlets ? 1 : 0;
+	data.maxMeshletVertices = settings.meshlets.maxVertices;
+	data.maxMeshletTriangles = settings.meshlets.maxTriangles;
+	data.meshletConeWeight = settings.meshlets.coneWeight;
+
+	// 0 means not cooked in the file header.
+	const uint64 hash = xxh::xxhash3<64>(&data, sizeof(data));
+	return hash == 0 ? 1 : hash;
+}
+
+RS::Mesh RS::MeshCooker::Index(const Mesh& mesh)
+{
+	const uint64 sourceIndexCount = mesh.indices.empty() ? mesh.vertices.size() : mesh.indices.size();
+
+	// Open addressing on the vertex bytes, the table stores indices into the output vertices.
+	uint64 tableSize = 16;
+	while (tableSize < sourceIndexCount * 2)
+		tableSize *= 2;
+	std::vector<uint32> table(tableSize, UINT32_MAX);
+
+	Mesh result;
+	result.indices.reserve(sourceIndexCount);
+	for (uint64 i = 0; i < sourceIndexCount; ++i)
+	{
+		const Vertex& vertex = mesh.vertices[mesh.indices.empty() ? i : mesh.indices[i]];
+		uint64 slot = xxh::xxhash3<64>(&vertex, sizeof(Vertex)) & (tableSize - 1);
+		while (table[slot] != UINT32_MAX && std::memcmp(&result.vertices[table[slot]], &vertex, sizeof(Vertex)) != 0)
+			slot = (slot + 1) & (tableSize - 1);
+
+		if (table[slot] == UINT32_MAX)
+		{
+			table[slot] = (uint32)result.vertices.size();
+			result.vertices.push_back(vertex);
+		}
+		result.indices.push_back(table[slot]);
+	}
+	return result;
+}
+
+void RS::MeshCooker::GenerateMissingNormals(Mesh& mesh)
+{
+	using namespace _MeshCookerInternal;
+
+	std::vector<glm::vec3> normals(mesh.vertices.size());
+	bool isAnyMissing = false;
+	for (uint64 i = 0; i < mesh.vertices.size(); ++i)
+	{
+		normals[i] = mesh.vertices[i].normal;
+		isAnyMissing |= !(glm::dot(normals[i], normals[i]) > 1e-12f);
+	}
+	if (!isAnyMissing)
+		return;
+
+	std::vector<glm::vec3> faceNormals(mesh.vertices.size(), glm::vec3(0.f));
+	for (uint64 i = 0; i + 2 < mesh.indices.size(); i += 3)
+	{
+		const uint32 i0 = mesh.indices[i], i1 = mesh.indices[i + 1], i2 = mesh.indices[i + 2];
+		const glm::vec3 p0 = mesh.vertices[i0].position;
+		// Not normalized, so larger triangles count more.
+		const glm::vec3 faceNormal = glm::cross(glm::vec3(mesh.vertices[i1].position) - p0, glm::vec3(mesh.vertices[i2].position) - p0);
+		for (uint32 index : { i0, i1, i2 })
+			faceNormals[index] += faceNormal;
+	}
+
+	for (uint64 i = 0; i < mesh.vertices.size(); ++i)
+	{
+		if (glm::dot(normals[i], normals[i]) > 1e-12f)
+			continue;
+
+		glm::vec3 normal = faceNormals[i];
+		if (!TryNormalize(normal))
+			normal = glm::vec3(0.f, 1.f, 0.f);
+		mesh.vertices[i].normal.x = normal.x;
+		mesh.vertices[i].normal.y = normal.y;
+		mesh.vertices[i].normal.z = normal.z;
+	}
+}
+
+std::vector<RS::Vec4> RS::MeshCooker::GenerateTangents(const Mesh& mesh)
+{
+	using namespace _MeshCookerInternal;
+
+	// Accumulate the UV derivatives of every triangle on its vertices, then make them orthogonal to the normal.
+	std::vector<glm::vec3> tangents(mesh.vertices.size(), glm::vec3(0.f));
+	std::vector<glm::vec3> bitangents(mesh.vertices.size(), glm::vec3(0.f));
+	for (uint64 i = 0; i + 2 < mesh.indices.size(); i += 3)
+	{
+		const uint32 i0 = mesh.indices[i], i1 = mesh.indices[i + 1], i2 = mesh.indices[i + 2];
+		const Vertex& v0 = mesh.vertices[i0];
+		const Vertex& v1 = mesh.vertices[i1];
+		const Vertex& v2 = mesh.vertices[i2];
+
+		const glm::vec3 e1 = glm::vec3(v1.position) - glm::vec3(v0.position);
+		const glm::vec3 e2 = glm::vec3(v2.position) - glm::vec3(v0.position);
+		const float du1 = v1.uv.x - v0.uv.x, dv1 = v1.uv.y - v0.uv.y;
+		const float du2 = v2.uv.x - v0.uv.x, dv2 = v2.uv.y - v0.uv.y;
+
+		const float determinant = du1 * dv2 - du2 * dv1;
+		if (std::abs(determinant) < 1e-20f)
+			continue;
+
+		// Scaling by the determinant instead of dividing weighs the triangles by their UV area, and keeps the sign.
+		const float scale = determinant > 0.f ? 1.f : -1.f;
+		const glm::vec3 tangent = (e1 * dv2 - e2 * dv1) * scale;
+		const glm::vec3 bitangent = (e2 * du1 - e1 * du2) * scale;
+		for (uint32 index : { i0, i1, i2 })
+		{
+			tangents[index] += tangent;
+			bitangents[index] += bitangent;
+		}
+	}
+
+	std::vector<Vec4> result(mesh.vertices.size());
+	for (uint64 i = 0; i < mesh.vertices.size(); ++i)
+	{
+		glm::vec3 normal = mesh.vertices[i].normal;
+		if (!TryNormalize(normal))
+			normal = glm::vec3(0.f, 1.f, 0.f);
+
+		// Gram-Schmidt.
+		glm::vec3 tangent = tangents[i] - normal * glm::dot(normal, tangents[i]);
+		if (!TryNormalize(tangent))
+			tangent = GetOrthogonal(normal);
+
+		const float handedness = glm::dot(glm::cross(normal, tangent), bitangents[i]) < 0.f ? -1.f : 1.f;
+		result[i] = Vec4(tangent.x, tangent.y, tangent.z, handedness);
+	}
+	return result;
+}
+
+std::vector<uint8> RS::MeshCooker::CookMesh(const Mesh& mesh, const MeshCookSettings& settings, uint64 cookHash, MeshOptimizerReport* pReport)
+{
+	Mesh indexedMesh = Index(mesh);
+	GenerateMissingNormals(indexedMesh);
+
+	std::vector<MeshLOD> lods;
+	if (settings.optimize)
+		lods = MeshOptimizer::Optimize(indexedMesh, settings.optimizer, pReport);
+
+	// Only LOD 0 gives the tangents, the simplified triangles would blur them.
+	std::vector<uint32> allIndices = indexedMesh.indices;
+	if (!lods.empty())
+		indexedMesh.indices.resize(lods[0].indexCount);
+	const std::vector<Vec4> tangents = GenerateTangents(indexedMesh);
+	indexedMesh.indices = std::move(allIndices);
+
+	float boundsMin[3] = { 0.f, 0.f, 0.f };
+	float boundsMax[3] = { 0.f, 0.f, 0.f };
+	if (!indexedMesh.vertices.empty())
+	{
+		for (uint32 i = 0; i < 3; ++i)
+			boundsMin[i] = boundsMax[i] = indexedMesh.vertices[0].position.values[i];
+	}
+	for (const Vertex& vertex : indexedMesh.vertices)
+	{
+		for (uint32 i = 0; i < 3; ++i)
+		{
+			boundsMin[i] = std::min(boundsMin[i], vertex.position.values[i]);
+			boundsMax[i] = std::max(boundsMax[i], vertex.position.values[i]);
+		}
+	}
+
+	std::vector<CookedVertex> vertices(indexedMesh.vertices.size());
+	for (uint64 i = 0; i < vertices.size(); ++i)
+		vertices[i] = MeshFile::EncodeVertex(indexedMesh.vertices[i], tangents[i], boundsMin, boundsMax);
+
+	if (!settings.buildMeshlets)
+		return MeshFile::Write(vertices, indexedMesh.indices, lods, boundsMin, boundsMax, cookHash);
+
+	// The meshlets are built from the quantized positions, so the culling bounds fit what the GPU draws.
+	std::vector<Vertex> quantizedVertices(vertices.size());
+	for (uint64 i = 0; i < vertices.size(); ++i)
+		quantizedVertices[i] = MeshFile::DecodeVertex(vertices[i], boundsMin, boundsMax);
+
+	if (lods.empty())
+		lods.push_back({ 0, (uint32)indexedMesh.indices.size(), 0.f });
+
+	std::vector<MeshletSource> sources;
+	for (const MeshLOD& lod : lods)
+		sources.push_back({ std::span<const uint32>(indexedMesh.indices).subspan(lod.firstIndex, lod.indexCount), quantizedVertices });
+	const std::vector<MeshletData> lodMeshlets = MeshletBuilder::Build(sources, settings.meshlets);
+
+	MeshletData meshlets;
+	for (uint64 i = 0; i < lods.size(); ++i)
+	{
+		lods[i].firstMeshlet = (uint32)meshlets.meshlets.size();
+		lods[i].meshletCount = (uint32)lodMeshlets[i].meshlets.size();
+		MeshletBuilder::Append(meshlets, lodMeshlets[i]);
+	}
+	return MeshFile::Write(vertices, indexedMesh.indices, lods, boundsMin, boundsMax, cookHash, &meshlets);
+}
+
+RS::MeshCooker::Result RS::MeshCooker::Cook(const std::string& sourcePath, const std::string& cookedPath, const MeshCookSettings& settings, bool force)
+{
+	std::shared_ptr<VFSFile> pSourceFile = VFS::Get()->Open(sourcePath);
+	if (!pSourceFile)
+	{
+		LOG_ERROR("Cannot cook mesh, failed to open {}!", sourcePath.c_str());
+		return Result::Failed;
+	}
+
+	const uint64 cookHash = ComputeCookHash(pSourceFile->GetData(), settings);
+	if (!force && MeshFile::ReadCookHash(cookedPath) == cookHash)
+		return Result::UpToDate;
+
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	std::unique_ptr<Mesh> pMesh(FBXLoader::Load(pSourceFile->GetData(), sourcePath));
+	if (!pMesh)
+	{
+		LOG_ERROR("Cannot cook mesh, failed to load {}!", sourcePath.c_str());
+		return Result::Failed;
+	}
+
+	MeshOptimizerReport report;
+	const std::vector<uint8> meshData = CookMesh(*pMesh, settings, cookHash, &report);
+
+	std::error_code error;
+	std::filesystem::create_directories(std::filesystem::path(cookedPath).parent_path(), error);
+	std::ofstream stream(cookedPath, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!stream.is_open())
+	{
+		LOG_ERROR("Cannot cook mesh, failed to open {} for writing!", cookedPath.c_str());
+		return Result::Failed;
+	}
+	stream.write((const char*)meshData.data(), meshData.size());
+	if (!stream.good())
+	{
+		LOG_ERROR("Failed to write cooked mesh {}!", cookedPath.c_str());
+		return Result::Failed;
+	}
+
+	CookedMeshView view;
+	MeshFile::Parse(meshData, view);
+	auto duration = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime);
+	LOG_INFO("Cooked {} in {:.1f} ms, {} vertices -> {}, {} KiB -> {} KiB", sourcePath.c_str(), duration.count(), pMesh->vertices.size(), view.vertices.size(),
+		pMesh->vertices.size() * sizeof(Vertex) / 1024, meshData.size() / 1024);
+	for (const MeshOptimizerReport::Stage& stage : report.stages)
+	{
+		LOG_INFO("    {}: ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}, overfetch {:.3f} -> {:.3f}", stage.name.c_str(), stage.cacheBefore.acmr, stage.cacheAfter.acmr,
+			stage.cacheBefore.atvr, stage.cacheAfter.atvr, stage.fetchBefore.overfetch, stage.fetchAfter.overfetch);
+	}
+	for (uint64 i = 1; i < view.lods.size(); ++i)
+		LOG_INFO("    LOD {}: {} triangles, error {:.4f}", i, view.lods[i].indexCount / 3, view.lods[i].error);
+	if (view.lods[0].meshletCount > 0)
+	{
+		const MeshLOD& lod = view.lods[0];
+		uint64 vertexCount = 0;
+		for (uint32 i = lod.firstMeshlet; i < lod.firstMeshlet + lod.meshletCount; ++i)
+			vertexCount += view.meshlets[i].vertexCount;
+		LOG_INFO("    Meshlets: {} for LOD 0, {:.1f} vertices and {:.1f} triangles on average", lod.meshletCount, (float)vertexCount / lod.meshletCount,
+			(float)lod.indexCount / 3.f / lod.meshletCount);
+	}
+	return Result::Cooked;
+}
+
+uint32 RS::MeshCooker::CookDirectory(const std::string& sourceDirectory, const std::string& cookedDirectory, const MeshCookSettings& settings, bool force)
+{
+	using namespace _MeshCookerInternal;
+
+	std::error_code error;
+	if (!std::filesystem::is_directory(sourceDirectory, error))
+	{
+		LOG_WARNING("Cannot cook meshes in {}, it is not a directory!", sourceDirectory.c_str());
+		return 0;
+	}
+
+	uint32 cookedCount = 0;
+	uint32 upToDateCount = 0;
+	uint32 failedCount = 0;
+	for (const std::filesystem::directory_entry& entry : std::filesystem::recursive_directory_iterator(sourceDirectory))
+	{
+		if (!entry.is_regular_file() || !IsMeshFile(entry.path()))
+			continue;
+
+		const std::string relativePath = std::filesystem::relative(entry.path(), sourceDirectory).generic_string();
+		switch (Cook(entry.path().generic_string(), GetCookedPath(cookedDirectory + "/" + relativePath), settings, force))
+		{
+		case Result::Cooked:	cookedCount++; break;
+		case Result::UpToDate:	upToDateCount++; break;
+		default:				failedCount++; break;
+		}
+	}
+
+	LOG_INFO("Mesh cooking done, {} cooked, {} up to date, {} failed", cookedCount, upToDateCount, failedCount);
+	return failedCount;
+}
+
+std::string RS::MeshCooker::GetCookedPath(const std::string& path)
+{
+	return std::filesystem::path(path).replace_extension(".rsmesh").generic_string();
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Loaders/Mesh/MeshFile.h"
+
+#include <span>
+
+namespace RS
+{
+	struct MeshCookSettings
+	{
+		bool optimize = true;	// Reorders for the vertex cache, overdraw and vertex fetch, and generates the LODs.
+		MeshOptimizerSettings optimizer;
+		bool buildMeshlets = true;	// For every LOD.
+		MeshletSettings meshlets;
+	};
+
+	/*
+	* Offline mesh cooking: loads an FBX file, merges the duplicated vertices into an index buffer, generates tangents, runs the
+	* MeshOptimizer, splits the LODs into meshlets and writes a quantized mesh file that the runtime can map and upload as it is.
+	* The cooked file stores a hash of the source data and the settings, a mesh is only cooked again when one of them changes.
+	*/
+	class MeshCooker
+	{
+	public:
+		RS_STATIC_CLASS(MeshCooker)
+
+		enum class Result
+		{
+			Cooked,
+			UpToDate,
+			Failed
+		};
+
+		static uint64 ComputeCookHash(std::span<const uint8> sourceData, const MeshCookSettings& settings);
+
+		/*
+		* Merges vertices that are bit for bit the same. The input is a triangle list, indexed or not, the output keeps the order
+		* in which the vertices are first used.
+		*/
+		static Mesh Index(const Mesh& mesh);
+
+		/*
+		* One tangent per vertex of an indexed mesh, orthogonal to the normal. w is the sign of the bitangent.
+		* Vertices without a usable UV mapping get an arbitrary tangent.
+		*/
+		static std::vector<Vec4> GenerateTangents(const Mesh& mesh);
+
+		/*
+		* Vertices without a normal get the area weighted normal of the triangles that use them.
+		*/
+		static void GenerateMissingNormals(Mesh& mesh);
+
+		/*
+		* Returns a complete mesh file. pReport gets the stats of every optimization stage.
+		*/
+		static std::vector<uint8> CookMesh(const Mesh& mesh, const MeshCookSettings& settings, uint64 cookHash = 0, MeshOptimizerReport* pReport = nullptr);
+
+		static Result Cook(const std::string& sourcePath, const std::string& cookedPath, const MeshCookSettings& settings, bool force = false);
+
+		/*
+		* Cooks every FBX file in the directory into cookedDirectory, with the same relative path and a .rsmesh extension.
+		* Returns the number of meshes that failed.
+		*/
+		static uint32 CookDirectory(const std::string& sourceDirectory, const std::string& cookedDirectory, const MeshCookSettings& settings, bool force = false);
+
+		static std::string GetCookedPath(const std::string& path);
+	};
+}
@@ -0,0 +1,430 @@
+#include "PreCompiled.h"
+#include "MeshFile.h"
+
+#include "Core/VFS.h"
+
+#include <cmath>
+
+namespace RS::_MeshFileInternal
+{
+	constexpr uint32 Magic = 0x534D5352; // "RSMS"
+	constexpr uint32 Version = 3;
+	constexpr uint64 DataAlignment = 16;
+
+	struct Header
+	{
+		uint32 magic = Magic;
+		uint32 version = Version;
+		uint64 cookHash = 0;
+		uint32 vertexCount = 0;
+		uint32 vertexStride = sizeof(CookedVertex);
+		uint32 indexCount = 0;
+		uint32 indexSize = 0;
+		float boundsMin[3] = {};
+		float boundsMax[3] = {};
+		uint64 vertexOffset = 0;
+		uint64 indexOffset = 0;
+		uint32 lodCount = 0;
+		uint32 meshletCount = 0;
+		uint32 meshletVertexCount = 0;
+		uint32 meshletTriangleCount = 0;
+		uint64 meshletOffset = 0;
+		uint64 meshletBoundsOffset = 0;
+		uint64 meshletVertexOffset = 0;
+		uint64 meshletTriangleOffset = 0;
+	};
+	static_assert(sizeof(Header) == 120);
+
+	// Stored right after the header.
+	struct LODHeader
+	{
+		uint32 firstIndex = 0;
+		uint32 indexCount = 0;
+		float error = 0.f;
+		uint32 firstMeshlet = 0;
+		uint32 meshletCount = 0;
+		uint32 padding[3] = {};
+	};
+	static_assert(sizeof(LODHeader) == 32);
+
+	uint64 AlignUp(uint64 value)
+	{
+		return (value + DataAlignment - 1) & ~(DataAlignment - 1);
+	}
+
+	bool IsInside(const std::span<const uint8> data, uint64 offset, uint64 size)
+	{
+		return offset <= data.size() && size <= data.size() - offset;
+	}
+
+	template<typename T>
+	void WriteArray(std::vector<uint8>& data, uint64 offset, const std::vector<T>& values)
+	{
+		if (!values.empty())
+			std::memcpy(data.data() + offset, values.data(), values.size() * sizeof(T));
+	}
+
+	uint16 FloatToHalf(float value)
+	{
+		uint32 bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		const uint32 sign = (bits >> 16) & 0x8000;
+		const int32 exponent = (int32)((bits >> 23) & 0xFF) - 127 + 15;
+		uint32 mantissa = bits & 0x7FFFFF;
+
+		if (((bits >> 23) & 0xFF) == 0xFF)
+			return (uint16)(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+		if (exponent >= 31)
+			return (uint16)(sign | 0x7C00);
+		if (exponent <= 0)
+		{
+			// Denormal, or zero when it is too small.
+			if (exponent < -10)
+				return (uint16)sign;
+			mantissa |= 0x800000;
+			const uint32 shift = (uint32)(14 - exponent);
+			uint32 half = mantissa >> shift;
+			const uint32 remainder = mantissa & ((1u << shift) - 1);
+			const uint32 halfway = 1u << (shift - 1);
+			if (remainder > halfway || (remainder == halfway && (half & 1)))
+				half++;
+			return (uint16)(sign | half);
+		}
+
+		// Round to nearest even, a carry into the exponent is still the right value.
+		uint32 half = ((uint32)exponent << 10) | (mantissa >> 13);
+		const uint32 remainder = mantissa & 0x1FFF;
+		if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+			half++;
+		return (uint16)(sign | half);
+	}
+
+	float HalfToFloat(uint16 value)
+	{
+		const uint32 sign = (uint32)(value & 0x8000) << 16;
+		const uint32 exponent = (value >> 10) & 0x1F;
+		uint32 mantissa = value & 0x3FF;
+
+		uint32 bits;
+		if (exponent == 0x1F)
+			bits = sign | 0x7F800000 | (mantissa << 13);
+		else if (exponent != 0)
+			bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+		else if (mantissa == 0)
+			bits = sign;
+		else
+		{
+			int32 e = -1;
+			do
+			{
+				e++;
+				mantissa <<= 1;
+			} while ((mantissa & 0x400) == 0);
+			bits = sign | ((uint32)(127 - 15 - e) << 23) | ((mantissa & 0x3FF) << 13);
+		}
+
+		float result;
+		std::memcpy(&result, &bits, sizeof(result));
+		return result;
+	}
+
+	int16 ToSnorm16(float value)
+	{
+		return (int16)std::lround(std::clamp(value, -1.f, 1.f) * 32767.f);
+	}
+
+	int8 ToSnorm8(float value)
+	{
+		return (int8)std::lround(std::clamp(value, -1.f, 1.f) * 127.f);
+	}
+
+	float FromSnorm16(int16 value)
+	{
+		return std::max((float)value / 32767.f, -1.f);
+	}
+
+	float FromSnorm8(int8 value)
+	{
+		return std::max((float)value / 127.f, -1.f);
+	}
+
+	float SignNotZero(float value)
+	{
+		return value >= 0.f ? 1.f : -1.f;
+	}
+}
+
+uint32 RS::CookedMeshView::GetIndex(uint32 index) const
+{
+	if (indexSize == 2)
+	{
+		uint16 value;
+		std::memcpy(&value, indices.data() + (uint64)index * 2, sizeof(value));
+		return value;
+	}
+
+	uint32 value;
+	std::memcpy(&value, indices.data() + (uint64)index * 4, sizeof(value));
+	return value;
+}
+
+std::vector<uint8> RS::MeshFile::Write(const std::vector<CookedVertex>& vertices, const std::vector<uint32>& indices, const std::vector<MeshLOD>& lods,
+	const float boundsMin[3], const float boundsMax[3], uint64 cookHash, const MeshletData* pMeshlets)
+{
+	using namespace _MeshFileInternal;
+
+	const MeshletData noMeshlets;
+	const MeshletData& meshlets = pMeshlets ? *pMeshlets : noMeshlets;
+	RS_ASSERT(meshlets.bounds.size() == meshlets.meshlets.size(), "Meshlets have {} bounds, but there are {} meshlets!", meshlets.bounds.size(), meshlets.meshlets.size());
+
+	std::vector<LODHeader> lodHeaders;
+	for (const MeshLOD& lod : lods)
+	{
+		RS_ASSERT((uint64)lod.firstIndex + lod.indexCount <= indices.size(), "LOD uses indices {} to {}, but there are only {}!", lod.firstIndex, lod.firstIndex + lod.indexCount, indices.size());
+		RS_ASSERT((uint64)lod.firstMeshlet + lod.meshletCount <= meshlets.meshlets.size(), "LOD uses meshlets {} to {}, but there are only {}!",
+			lod.firstMeshlet, lod.firstMeshlet + lod.meshletCount, meshlets.meshlets.size());
+		lodHeaders.push_back({ lod.firstIndex, lod.indexCount, lod.error, lod.firstMeshlet, lod.meshletCount });
+	}
+	if (lodHeaders.empty())
+		lodHeaders.push_back({ 0, (uint32)indices.size(), 0.f, 0, (uint32)meshlets.meshlets.size() });
+
+	Header header;
+	header.cookHash = cookHash;
+	header.vertexCount = (uint32)vertices.size();
+	header.indexCount = (uint32)indices.size();
+	header.indexSize = vertices.size() <= 0xFFFF ? 2 : 4;
+	std::memcpy(header.boundsMin, boundsMin, sizeof(header.boundsMin));
+	std::memcpy(header.boundsMax, boundsMax, sizeof(header.boundsMax));
+	header.lodCount = (uint32)lodHeaders.size();
+	header.vertexOffset = AlignUp(sizeof(Header) + lodHeaders.size() * sizeof(LODHeader));
+	header.indexOffset = AlignUp(header.vertexOffset + vertices.size() * sizeof(CookedVertex));
+	header.meshletCount = (uint32)meshlets.meshlets.size();
+	header.meshletVertexCount = (uint32)meshlets.vertices.size();
+	header.meshletTriangleCount = (uint32)meshlets.triangles.size();
+	header.meshletOffset = AlignUp(header.indexOffset + indices.size() * header.indexSize);
+	header.meshletBoundsOffset = AlignUp(header.meshletOffset + meshlets.meshlets.size() * sizeof(Meshlet));
+	header.meshletVertexOffset = AlignUp(header.meshletBoundsOffset + meshlets.bounds.size() * sizeof(MeshletBounds));
+	header.meshletTriangleOffset = AlignUp(header.meshletVertexOffset + meshlets.vertices.size() * sizeof(uint32));
+
+	std::vector<uint8> data(header.meshletTriangleOffset + meshlets.triangles.size() * sizeof(uint32), 0);
+	std::memcpy(data.data(), &header, sizeof(header));
+	std::memcpy(data.data() + sizeof(header), lodHeaders.data(), lodHeaders.size() * sizeof(LODHeader));
+	WriteArray(data, header.vertexOffset, vertices);
+	WriteArray(data, header.meshletOffset, meshlets.meshlets);
+	WriteArray(data, header.meshletBoundsOffset, meshlets.bounds);
+	WriteArray(data, header.meshletVertexOffset, meshlets.vertices);
+	WriteArray(data, header.meshletTriangleOffset, meshlets.triangles);
+
+	if (header.indexSize == 2)
+	{
+		uint16* pIndices = (uint16*)(data.data() + header.indexOffset);
+		for (uint64 i = 0; i < indices.size(); ++i)
+			pIndices[i] = (uint16)indices[i];
+	}
+	else if (!indices.empty())
+	{
+		std::memcpy(data.data() + header.indexOffset, indices.data(), indices.size() * sizeof(uint32));
+	}
+	return data;
+}
+
+bool RS::MeshFile::Parse(std::span<const uint8> data, CookedMeshView& view)
+{
+	using namespace _MeshFileInternal;
+
+	if (data.size() < sizeof(Header))
+	{
+		LOG_WARNING("Mesh file is too small to have a header!");
+		return false;
+	}
+
+	Header header;
+	std::memcpy(&header, data.data(), sizeof(header));
+	if (header.magic != Magic)
+	{
+		LOG_WARNING("Mesh file is not a cooked mesh!");
+		return false;
+	}
+	if (header.version != Version || header.vertexStride != sizeof(CookedVertex) || (header.indexSize != 2 && header.indexSize != 4))
+	{
+		LOG_WARNING("Mesh file has version {}, vertex stride {} and index size {}, which are not supported!", header.version, header.vertexStride, header.indexSize);
+		return false;
+	}
+
+	const uint64 vertexBytes = (uint64)header.vertexCount * sizeof(CookedVertex);
+	const uint64 indexBytes = (uint64)header.indexCount * header.indexSize;
+	const uint64 lodBytes = (uint64)header.lodCount * sizeof(LODHeader);
+	if (header.lodCount == 0 || header.vertexOffset < sizeof(Header) + lodBytes || !IsInside(data, header.vertexOffset, vertexBytes) || !IsInside(data, header.indexOffset, indexBytes))
+	{
+		LOG_WARNING("Mesh file is too small for its {} vertices and {} indices!", header.vertexCount, header.indexCount);
+		return false;
+	}
+	if (!IsInside(data, header.meshletOffset, (uint64)header.meshletCount * sizeof(Meshlet)) || !IsInside(data, header.meshletBoundsOffset, (uint64)header.meshletCount * sizeof(MeshletBounds))
+		|| !IsInside(data, header.meshletVertexOffset, (uint64)header.meshletVertexCount * sizeof(uint32)) || !IsInside(data, header.meshletTriangleOffset, (uint64)header.meshletTriangleCount * sizeof(uint32)))
+	{
+		LOG_WARNING("Mesh file is too small for its {} meshlets!", header.meshletCount);
+		return false;
+	}
+
+	std::memcpy(view.boundsMin, header.boundsMin, sizeof(view.boundsMin));
+	std::memcpy(view.boundsMax, header.boundsMax, sizeof(view.boundsMax));
+	view.cookHash = header.cookHash;
+	view.indexSize = header.indexSize;
+	view.vertices = std::span<const CookedVertex>((const CookedVertex*)(data.data() + header.vertexOffset), header.vertexCount);
+	view.indices = data.subspan(header.indexOffset, indexBytes);
+	view.meshlets = std::span<const Meshlet>((const Meshlet*)(data.data() + header.meshletOffset), header.meshletCount);
+	view.meshletBounds = std::span<const MeshletBounds>((const MeshletBounds*)(data.data() + header.meshletBoundsOffset), header.meshletCount);
+	view.meshletVertices = std::span<const uint32>((const uint32*)(data.data() + header.meshletVertexOffset), header.meshletVertexCount);
+	view.meshletTriangles = std::span<const uint32>((const uint32*)(data.data() + header.meshletTriangleOffset), header.meshletTriangleCount);
+
+	for (const Meshlet& meshlet : view.meshlets)
+	{
+		if ((uint64)meshlet.vertexOffset + meshlet.vertexCount > header.meshletVertexCount || (uint64)meshlet.triangleOffset + meshlet.triangleCount > header.meshletTriangleCount)
+		{
+			LOG_WARNING("Mesh file has a meshlet that is outside of the meshlet data!");
+			return false;
+		}
+	}
+
+	view.lods.resize(header.lodCount);
+	for (uint32 i = 0; i < header.lodCount; ++i)
+	{
+		LODHeader lod;
+		std::memcpy(&lod, data.data() + sizeof(Header) + (uint64)i * sizeof(LODHeader), sizeof(lod));
+		if ((uint64)lod.firstIndex + lod.indexCount > header.indexCount)
+		{
+			LOG_WARNING("Mesh file has a LOD that uses indices {} to {}, but there are only {}!", lod.firstIndex, lod.firstIndex + lod.indexCount, header.indexCount);
+			return false;
+		}
+		if ((uint64)lod.firstMeshlet + lod.meshletCount > header.meshletCount)
+		{
+			LOG_WARNING("Mesh file has a LOD that uses meshlets {} to {}, but there are only {}!", lod.firstMeshlet, lod.firstMeshlet + lod.meshletCount, header.meshletCount);
+			return false;
+		}
+		view.lods[i] = { lod.firstIndex, lod.indexCount, lod.error, lod.firstMeshlet, lod.meshletCount };
+	}
+	return true;
+}
+
+uint64 RS::MeshFile::ReadCookHash(const std::string& path)
+{
+	using namespace _MeshFileInternal;
+	std::shared_ptr<VFSFile> pFile = VFS::Get()->Open(path);
+	if (!pFile || pFile->GetSize() < sizeof(Header))
+		return 0;
+
+	Header header;
+	std::memcpy(&header, pFile->GetPtr(), sizeof(header));
+	return header.magic == Magic && header.version == Version ? header.cookHash : 0;
+}
+
+RS::Mesh RS::MeshFile::Decode(const CookedMeshView& view, std::vector<Vec4>* pTangents)
+{
+	Mesh mesh;
+	mesh.vertices.resize(view.vertices.size());
+	if (pTangents)
+		pTangents->resize(view.vertices.size());
+	for (uint64 i = 0; i < view.vertices.size(); ++i)
+		mesh.vertices[i] = DecodeVertex(view.vertices[i], view.boundsMin, view.boundsMax, pTangents ? &(*pTangents)[i] : nullptr);
+
+	const uint32 indexCount = view.GetIndexCount();
+	mesh.indices.resize(indexCount);
+	for (uint32 i = 0; i < indexCount; ++i)
+		mesh.indices[i] = view.GetIndex(i);
+	return mesh;
+}
+
+RS::CookedVertex RS::MeshFile::EncodeVertex(const Vertex& vertex, const Vec4& tangent, const float boundsMin[3], const float boundsMax[3])
+{
+	using namespace _MeshFileInternal;
+
+	CookedVertex result = {};
+	for (uint32 i = 0; i < 3; ++i)
+	{
+		const float extent = boundsMax[i] - boundsMin[i];
+		const float t = extent > 0.f ? (vertex.position.values[i] - boundsMin[i]) / extent : 0.f;
+		result.position[i] = (uint16)std::lround(std::clamp(t, 0.f, 1.f) * 65535.f);
+	}
+
+	// Project onto the octahedron and fold the lower half over the diagonals.
+	float x = vertex.normal.x;
+	float y = vertex.normal.y;
+	const float z = vertex.normal.z;
+	const float sum = std::abs(x) + std::abs(y) + std::abs(z);
+	if (sum > 0.f)
+	{
+		x /= sum;
+		y /= sum;
+		if (z < 0.f)
+		{
+			const float foldedX = (1.f - std::abs(y)) * SignNotZero(x);
+			y = (1.f - std::abs(x)) * SignNotZero(y);
+			x = foldedX;
+		}
+	}
+	result.normal[0] = ToSnorm16(x);
+	result.normal[1] = ToSnorm16(y);
+
+	for (uint32 i = 0; i < 3; ++i)
+		result.tangent[i] = ToSnorm8(tangent.values[i]);
+	result.tangent[3] = tangent.w < 0.f ? -127 : 127;
+
+	result.uv[0] = FloatToHalf(vertex.uv.x);
+	result.uv[1] = FloatToHalf(vertex.uv.y);
+	return result;
+}
+
+RS::Vertex RS::MeshFile::DecodeVertex(const CookedVertex& vertex, const float boundsMin[3], const float boundsMax[3], Vec4* pTangent)
+{
+	using namespace _MeshFileInternal;
+
+	Vertex result;
+	for (uint32 i = 0; i < 3; ++i)
+		result.position.values[i] = boundsMin[i] + (boundsMax[i] - boundsMin[i]) * ((float)vertex.position[i] / 65535.f);
+
+	float x = FromSnorm16(vertex.normal[0]);
+	float y = FromSnorm16(vertex.normal[1]);
+	const float z = 1.f - std::abs(x) - std::abs(y);
+	const float fold = std::max(-z, 0.f);
+	x += x >= 0.f ? -fold : fold;
+	y += y >= 0.f ? -fold : fold;
+	const float length = std::sqrt(x * x + y * y + z * z);
+	result.normal.x = x / length;
+	result.normal.y = y / length;
+	result.normal.z = z / length;
+
+	result.uv.x = HalfToFloat(vertex.uv[0]);
+	result.uv.y = HalfToFloat(vertex.uv[1]);
+
+	if (pTangent)
+	{
+		for (uint32 i = 0; i < 3; ++i)
+			pTangent->values[i] = FromSnorm8(vertex.tangent[i]);
+		pTangent->w = vertex.tangent[3] < 0 ? -1.f : 1.f;
+	}
+	return result;
+}
+
+std::shared_ptr<RS::CookedMesh> RS::CookedMesh::Load(const std::string& path)
+{
+	std::shared_ptr<VFSFile> pFile = VFS::Get()->Open(path);
+	if (!pFile)
+	{
+		LOG_ERROR("Cannot load cooked mesh, failed to open {}!", path.c_str());
+		return nullptr;
+	}
+
+	std::shared_ptr<CookedMesh> pMesh = std::make_shared<CookedMesh>();
+	if (!MeshFile::Parse(pFile->GetData(), pMesh->m_View))
+	{
+		LOG_ERROR("Cannot load cooked mesh {}!", path.c_str());
+		return nullptr;
+	}
+	pMesh->m_pFile = pFile;
+	return pMesh;
+}
+
+const std::string& RS::CookedMesh::GetPath() const
+{
+	return m_pFile->GetPath();
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "Loaders/Mesh/MeshOptimizer.h"
+#include "Loaders/Mesh/MeshletBuilder.h"
+
+#include <span>
+
+namespace RS
+{
+	class VFSFile;
+
+	/*
+	* Vertex of a cooked mesh, 20 bytes instead of the 32 of a Vertex.
+	* The matching DXGI formats are R16G16B16A16_UNORM, R16G16_SNORM, R8G8B8A8_SNORM and R16G16_FLOAT.
+	*/
+	struct CookedVertex
+	{
+		uint16 position[4];	// Unorm inside the bounds of the mesh, w is always 0.
+		int16 normal[2];	// Octahedral encoding.
+		int8 tangent[4];	// w is the sign of the bitangent.
+		uint16 uv[2];		// Half floats, UVs far outside [0, 1] lose precision.
+	};
+	static_assert(sizeof(CookedVertex) == 20);
+
+	struct CookedMeshView
+	{
+		float boundsMin[3] = {};
+		float boundsMax[3] = {};
+		uint64 cookHash = 0;	// 0 if the file was not written by the cooker.
+		uint32 indexSize = 0;	// 2 or 4 bytes.
+		std::span<const CookedVertex> vertices;
+		std::span<const uint8> indices;	// indexSize bytes per index, the LODs are stored after each other.
+		std::vector<MeshLOD> lods;		// Always at least one.
+
+		// Empty when the mesh was cooked without meshlets. The meshlets of each LOD are in the range the LOD points to.
+		std::span<const Meshlet> meshlets;
+		std::span<const MeshletBounds> meshletBounds;
+		std::span<const uint32> meshletVertices;
+		std::span<const uint32> meshletTriangles;
+
+		uint32 GetIndexCount() const { return indexSize == 0 ? 0 : (uint32)(indices.size() / indexSize); }
+		uint32 GetIndex(uint32 index) const;
+	};
+
+	/*
+	* Binary mesh format written by the MeshCooker. The vertices and the indices are stored the way the GPU reads them, so a mapped
+	* file can be uploaded without touching the data.
+	*/
+	class MeshFile
+	{
+	public:
+		RS_STATIC_CLASS(MeshFile)
+
+		/*
+		* Indices use 16 bits when every vertex can be addressed with them. Without LODs every index is LOD 0.
+		* pMeshlets is optional, the meshlet ranges of the LODs must point into it.
+		*/
+		static std::vector<uint8> Write(const std::vector<CookedVertex>& vertices, const std::vector<uint32>& indices, const std::vector<MeshLOD>& lods,
+			const float boundsMin[3], const float boundsMax[3], uint64 cookHash, const MeshletData* pMeshlets = nullptr);
+
+		/*
+		* Does not copy, the view points into data. Returns false for files that are not supported.
+		*/
+		static bool Parse(std::span<const uint8> data, CookedMeshView& view);
+
+		// Only reads the header. Returns 0 if the file is missing or is not a cooked mesh.
+		static uint64 ReadCookHash(const std::string& path);
+
+		/*
+		* Decodes the mesh back to full precision vertices, for code that works with meshes on the CPU.
+		* The indices of every LOD are kept, pTangents is optional and gets one tangent per vertex.
+		*/
+		static Mesh Decode(const CookedMeshView& view, std::vector<Vec4>* pTangents = nullptr);
+
+		static CookedVertex EncodeVertex(const Vertex& vertex, const Vec4& tangent, const float boundsMin[3], const float boundsMax[3]);
+		static Vertex DecodeVertex(const CookedVertex& vertex, const float boundsMin[3], const float boundsMax[3], Vec4* pTangent = nullptr);
+	};
+
+	/*
+	* A cooked mesh file that stays mapped, the view points straight into the mapping.
+	*/
+	class CookedMesh
+	{
+	public:
+		static std::shared_ptr<CookedMesh> Load(const std::string& path);
+
+		const CookedMeshView& GetView() const { return m_View; }
+		const std::string& GetPath() const;
+
+	private:
+		std::shared_ptr<VFSFile> m_pFile;
+		CookedMeshView m_View;
+	};
+}
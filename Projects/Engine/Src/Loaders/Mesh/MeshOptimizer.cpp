@@ -0,0 +1,774 @@
+#include "PreCompiled.h"
+#include "MeshOptimizer.h"
+
+#include "Utils/Misc/xxhash.h"
+
+#include "Maths/GLMDefines.h"
+#include <glm/glm.hpp>
+
+#include <cmath>
+#include <numeric>
+#include <unordered_map>
+
+namespace RS::_MeshOptimizerInternal
+{
+	// Tom Forsyth, Linear-Speed Vertex Cache Optimisation.
+	constexpr uint32 ForsythCacheSize = 32;
+	constexpr float ForsythCacheDecayPower = 1.5f;
+	constexpr float ForsythLastTriangleScore = 0.75f;
+	constexpr float ForsythValenceBoostScale = 2.f;
+	constexpr float ForsythValenceBoostPower = 0.5f;
+
+	constexpr uint32 FetchCacheLineSize = 64;
+	constexpr uint32 FetchCacheLineCount = 64;
+
+	float GetForsythScore(int32 cachePosition, uint32 remainingTriangles)
+	{
+		if (remainingTriangles == 0)
+			return -1.f;
+
+		float score = 0.f;
+		if (cachePosition >= 0)
+		{
+			if (cachePosition < 3)
+				score = ForsythLastTriangleScore;
+			else
+				score = std::pow(1.f - (float)(cachePosition - 3) / (ForsythCacheSize - 3), ForsythCacheDecayPower);
+		}
+		return score + ForsythValenceBoostScale * std::pow((float)remainingTriangles, -ForsythValenceBoostPower);
+	}
+
+	// Symmetric 4x4 matrix of a sum of squared distances to planes.
+	struct Quadric
+	{
+		double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+		double a11 = 0, a12 = 0, a13 = 0;
+		double a22 = 0, a23 = 0;
+		double a33 = 0;
+
+		static Quadric FromPlane(double a, double b, double c, double d, double weight)
+		{
+			Quadric q;
+			q.a00 = weight * a * a; q.a01 = weight * a * b; q.a02 = weight * a * c; q.a03 = weight * a * d;
+			q.a11 = weight * b * b; q.a12 = weight * b * c; q.a13 = weight * b * d;
+			q.a22 = weight * c * c; q.a23 = weight * c * d;
+			q.a33 = weight * d * d;
+			return q;
+		}
+
+		void Add(const Quadric& q)
+		{
+			a00 += q.a00; a01 += q.a01; a02 += q.a02; a03 += q.a03;
+			a11 += q.a11; a12 += q.a12; a13 += q.a13;
+			a22 += q.a22; a23 += q.a23;
+			a33 += q.a33;
+		}
+
+		double Evaluate(const glm::vec3& p) const
+		{
+			const double x = p.x, y = p.y, z = p.z;
+			const double result = a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z + 2 * a03 * x
+				+ a11 * y * y + 2 * a12 * y * z + 2 * a13 * y
+				+ a22 * z * z + 2 * a23 * z
+				+ a33;
+			return std::max(result, 0.0);
+		}
+	};
+
+	enum class VertexKind : uint8
+	{
+		Manifold,	// Can collapse to any neighbour.
+		Border,		// On an open edge, can only collapse along it.
+		Locked		// On a seam or a non-manifold edge.
+	};
+
+	uint64 GetEdgeKey(uint32 a, uint32 b)
+	{
+		return a < b ? ((uint64)a << 32) | b : ((uint64)b << 32) | a;
+	}
+
+	void AppendStage(MeshOptimizerReport* pReport, const std::string& name, const VertexCacheStats& cacheBefore, const VertexFetchStats& fetchBefore,
+		std::span<const uint32> indices, uint32 vertexCount, const MeshOptimizerSettings& settings)
+	{
+		if (!pReport)
+			return;
+
+		MeshOptimizerReport::Stage stage;
+		stage.name = name;
+		stage.cacheBefore = cacheBefore;
+		stage.fetchBefore = fetchBefore;
+		stage.cacheAfter = MeshOptimizer::AnalyzeVertexCache(indices, vertexCount, settings.cacheSize);
+		stage.fetchAfter = MeshOptimizer::AnalyzeVertexFetch(indices, vertexCount, sizeof(Vertex));
+		pReport->stages.push_back(stage);
+	}
+}
+
+void RS::MeshAdjacency::Build(std::span<const uint32> indices, uint32 vertexCount)
+{
+	offsets.assign(vertexCount + 1, 0);
+	counts.assign(vertexCount, 0);
+	for (uint32 index : indices)
+		counts[index]++;
+	for (uint32 v = 0; v < vertexCount; ++v)
+		offsets[v + 1] = offsets[v] + counts[v];
+
+	triangles.resize(indices.size());
+	std::fill(counts.begin(), counts.end(), 0);
+	for (uint64 i = 0; i < indices.size(); ++i)
+	{
+		const uint32 v = indices[i];
+		triangles[offsets[v] + counts[v]++] = (uint32)(i / 3);
+	}
+}
+
+RS::VertexCacheStats RS::MeshOptimizer::AnalyzeVertexCache(std::span<const uint32> indices, uint32 vertexCount, uint32 cacheSize)
+{
+	// FIFO cache, a vertex is in the cache if it was transformed less than cacheSize transforms ago.
+	std::vector<uint32> timestamps(vertexCount, 0);
+	std::vector<uint8> isUsed(vertexCount, 0);
+	uint32 timestamp = cacheSize + 1;
+	uint32 usedCount = 0;
+
+	VertexCacheStats stats;
+	for (uint32 index : indices)
+	{
+		if (timestamp - timestamps[index] > cacheSize)
+		{
+			timestamps[index] = timestamp++;
+			stats.vertexTransforms++;
+		}
+		if (!isUsed[index])
+		{
+			isUsed[index] = 1;
+			usedCount++;
+		}
+	}
+
+	const uint64 triangleCount = indices.size() / 3;
+	stats.acmr = triangleCount == 0 ? 0.f : (float)stats.vertexTransforms / triangleCount;
+	stats.atvr = usedCount == 0 ? 0.f : (float)stats.vertexTransforms / usedCount;
+	return stats;
+}
+
+RS::VertexFetchStats RS::MeshOptimizer::AnalyzeVertexFetch(std::span<const uint32> indices, uint32 vertexCount, uint32 vertexSize)
+{
+	using namespace _MeshOptimizerInternal;
+
+	// FIFO of cache lines, the same way as the transform cache.
+	std::unordered_map<uint64, uint64> lineTimestamps;
+	std::vector<uint8> isUsed(vertexCount, 0);
+	uint64 timestamp = FetchCacheLineCount + 1;
+	uint64 usedCount = 0;
+
+	VertexFetchStats stats;
+	for (uint32 index : indices)
+	{
+		const uint64 firstLine = (uint64)index * vertexSize / FetchCacheLineSize;
+		const uint64 lastLine = ((uint64)index * vertexSize + vertexSize - 1) / FetchCacheLineSize;
+		for (uint64 line = firstLine; line <= lastLine; ++line)
+		{
+			uint64& lineTimestamp = lineTimestamps[line];
+			if (timestamp - lineTimestamp > FetchCacheLineCount)
+			{
+				lineTimestamp = timestamp++;
+				stats.bytesFetched += FetchCacheLineSize;
+			}
+		}
+		if (!isUsed[index])
+		{
+			isUsed[index] = 1;
+			usedCount++;
+		}
+	}
+
+	stats.overfetch = usedCount == 0 ? 0.f : (float)((double)stats.bytesFetched / ((double)usedCount * vertexSize));
+	return stats;
+}
+
+std::vector<uint32> RS::MeshOptimizer::BuildPositionRemap(std::span<const Vertex> vertices)
+{
+	uint64 tableSize = 16;
+	while (tableSize < vertices.size() * 2)
+		tableSize *= 2;
+	std::vector<uint32> table(tableSize, UINT32_MAX);
+
+	std::vector<uint32> remap(vertices.size());
+	for (uint32 v = 0; v < (uint32)vertices.size(); ++v)
+	{
+		const Vec3& position = vertices[v].position;
+		uint64 slot = xxh::xxhash3<64>(&position, sizeof(Vec3)) & (tableSize - 1);
+		while (table[slot] != UINT32_MAX && std::memcmp(&vertices[table[slot]].position, &position, sizeof(Vec3)) != 0)
+			slot = (slot + 1) & (tableSize - 1);
+		if (table[slot] == UINT32_MAX)
+			table[slot] = v;
+		remap[v] = table[slot];
+	}
+	return remap;
+}
+
+void RS::MeshOptimizer::OptimizeVertexCache(std::span<uint32> indices, uint32 vertexCount)
+{
+	using namespace _MeshOptimizerInternal;
+
+	const uint32 triangleCount = (uint32)(indices.size() / 3);
+	if (triangleCount == 0)
+		return;
+
+	// The triangles of each vertex that have not been output, at the start of its range.
+	MeshAdjacency adjacency;
+	adjacency.Build(indices, vertexCount);
+	std::vector<uint32>& remaining = adjacency.counts;
+
+	std::vector<float> vertexScores(vertexCount);
+	for (uint32 v = 0; v < vertexCount; ++v)
+		vertexScores[v] = GetForsythScore(-1, remaining[v]);
+
+	std::vector<uint8> isEmitted(triangleCount, 0);
+	std::vector<uint32> result;
+	result.reserve(indices.size());
+
+	uint32 cache[ForsythCacheSize + 3];
+	uint32 cacheCount = 0;
+	uint32 inputCursor = 0;
+	uint32 bestTriangle = UINT32_MAX;
+
+	for (uint32 emitted = 0; emitted < triangleCount; ++emitted)
+	{
+		if (bestTriangle == UINT32_MAX)
+		{
+			// Nothing in the cache has triangles left, continue with the next triangle in the input order.
+			while (isEmitted[inputCursor])
+				inputCursor++;
+			bestTriangle = inputCursor;
+		}
+
+		const uint32 triangle = bestTriangle;
+		const uint32 triangleIndices[3] = { indices[triangle * 3], indices[triangle * 3 + 1], indices[triangle * 3 + 2] };
+		result.insert(result.end(), triangleIndices, triangleIndices + 3);
+		isEmitted[triangle] = 1;
+
+		// Remove the triangle from its vertices.
+		for (uint32 v : triangleIndices)
+		{
+			uint32* pTriangles = adjacency.triangles.data() + adjacency.offsets[v];
+			for (uint32 i = 0; i < remaining[v]; ++i)
+			{
+				if (pTriangles[i] == triangle)
+				{
+					std::swap(pTriangles[i], pTriangles[remaining[v] - 1]);
+					remaining[v]--;
+					break;
+				}
+			}
+		}
+
+		// Move the vertices of the triangle to the front of the cache.
+		uint32 newCache[ForsythCacheSize + 3];
+		uint32 newCacheCount = 0;
+		for (uint32 v : triangleIndices)
+		{
+			if (std::find(newCache, newCache + newCacheCount, v) == newCache + newCacheCount)
+				newCache[newCacheCount++] = v;
+		}
+		for (uint32 i = 0; i < cacheCount; ++i)
+		{
+			const uint32 v = cache[i];
+			if (std::find(newCache, newCache + newCacheCount, v) == newCache + newCacheCount)
+				newCache[newCacheCount++] = v;
+		}
+
+		// Vertices pushed out of the cache lose their cache score.
+		for (uint32 i = ForsythCacheSize; i < newCacheCount; ++i)
+			vertexScores[newCache[i]] = GetForsythScore(-1, remaining[newCache[i]]);
+		cacheCount = std::min(newCacheCount, ForsythCacheSize);
+		std::copy(newCache, newCache + cacheCount, cache);
+		for (uint32 i = 0; i < cacheCount; ++i)
+			vertexScores[cache[i]] = GetForsythScore((int32)i, remaining[cache[i]]);
+
+		// Only the triangles of the vertices in the cache changed score, the best one of them goes next.
+		bestTriangle = UINT32_MAX;
+		float bestScore = -1.f;
+		for (uint32 i = 0; i < cacheCount; ++i)
+		{
+			const uint32 v = cache[i];
+			for (uint32 j = 0; j < remaining[v]; ++j)
+			{
+				const uint32 t = adjacency.triangles[adjacency.offsets[v] + j];
+				const float score = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+				if (score > bestScore || (score == bestScore && t < bestTriangle))
+				{
+					bestScore = score;
+					bestTriangle = t;
+				}
+			}
+		}
+	}
+
+	std::copy(result.begin(), result.end(), indices.begin());
+}
+
+void RS::MeshOptimizer::OptimizeOverdraw(std::span<uint32> indices, const std::vector<Vertex>& vertices, float threshold, uint32 cacheSize)
+{
+	using namespace _MeshOptimizerInternal;
+
+	const uint32 triangleCount = (uint32)(indices.size() / 3);
+	if (triangleCount == 0)
+		return;
+
+	// Hard boundaries are where the cache order starts over, at triangles where every vertex is a miss.
+	std::vector<uint32> timestamps(vertices.size(), 0);
+	uint32 timestamp = cacheSize + 1;
+	auto countMisses = [&](uint32 triangle)
+	{
+		uint32 misses = 0;
+		for (uint32 i = 0; i < 3; ++i)
+		{
+			const uint32 v = indices[triangle * 3 + i];
+			if (timestamp - timestamps[v] > cacheSize)
+			{
+				timestamps[v] = timestamp++;
+				misses++;
+			}
+		}
+		return misses;
+	};
+
+	std::vector<uint32> hardClusters;
+	std::vector<uint32> hardMisses;
+	for (uint32 t = 0; t < triangleCount; ++t)
+	{
+		const uint32 misses = countMisses(t);
+		if (t == 0 || misses == 3)
+		{
+			hardClusters.push_back(t);
+			hardMisses.push_back(0);
+		}
+		hardMisses.back() += misses;
+	}
+	hardClusters.push_back(triangleCount);
+
+	// Soft boundaries split the hard clusters further, as long as the ACMR of each part stays within the threshold.
+	std::vector<uint32> clusters;
+	for (uint64 c = 0; c + 1 < hardClusters.size(); ++c)
+	{
+		const uint32 start = hardClusters[c];
+		const uint32 end = hardClusters[c + 1];
+		const float clusterACMR = (float)hardMisses[c] / (end - start);
+
+		timestamp += cacheSize + 1;
+		clusters.push_back(start);
+		uint32 misses = 0;
+		uint32 clusterStart = start;
+		for (uint32 t = start; t < end; ++t)
+		{
+			misses += countMisses(t);
+			const uint32 count = t + 1 - clusterStart;
+			if (t + 1 < end && (float)misses / count <= clusterACMR * threshold)
+			{
+				// Starting over costs the misses of refilling the cache, which the threshold pays for.
+				timestamp += cacheSize + 1;
+				clusters.push_back(t + 1);
+				clusterStart = t + 1;
+				misses = 0;
+			}
+		}
+	}
+	clusters.push_back(triangleCount);
+
+	// Clusters on the outside that face away from the center are drawn first, they are the most likely to hide the others.
+	glm::vec3 meshCentroid(0.f);
+	float meshArea = 0.f;
+	const uint32 clusterCount = (uint32)clusters.size() - 1;
+	std::vector<float> sortKeys(clusterCount);
+	std::vector<glm::vec3> clusterCentroids(clusterCount);
+	std::vector<glm::vec3> clusterNormals(clusterCount);
+	for (uint32 c = 0; c < clusterCount; ++c)
+	{
+		glm::vec3 centroid(0.f);
+		glm::vec3 normal(0.f);
+		float area = 0.f;
+		for (uint32 t = clusters[c]; t < clusters[c + 1]; ++t)
+		{
+			const glm::vec3 p0 = vertices[indices[t * 3]].position;
+			const glm::vec3 p1 = vertices[indices[t * 3 + 1]].position;
+			const glm::vec3 p2 = vertices[indices[t * 3 + 2]].position;
+			const glm::vec3 faceNormal = glm::cross(p1 - p0, p2 - p0);
+			const float faceArea = std::sqrt(glm::dot(faceNormal, faceNormal));
+			centroid = centroid + (p0 + p1 + p2) * (faceArea / 3.f);
+			normal = normal + faceNormal;
+			area += faceArea;
+		}
+		clusterCentroids[c] = area > 0.f ? centroid * (1.f / area) : centroid;
+		const float normalLength = std::sqrt(glm::dot(normal, normal));
+		clusterNormals[c] = normalLength > 0.f ? normal * (1.f / normalLength) : normal;
+		meshCentroid = meshCentroid + centroid;
+		meshArea += area;
+	}
+	if (meshArea > 0.f)
+		meshCentroid = meshCentroid * (1.f / meshArea);
+
+	std::vector<uint32> order(clusterCount);
+	std::iota(order.begin(), order.end(), 0);
+	for (uint32 c = 0; c < clusterCount; ++c)
+		sortKeys[c] = glm::dot(clusterCentroids[c] - meshCentroid, clusterNormals[c]);
+	std::stable_sort(order.begin(), order.end(), [&](uint32 a, uint32 b) { return sortKeys[a] > sortKeys[b]; });
+
+	std::vector<uint32> result;
+	result.reserve(indices.size());
+	for (uint32 c : order)
+		result.insert(result.end(), indices.begin() + (uint64)clusters[c] * 3, indices.begin() + (uint64)clusters[c + 1] * 3);
+	std::copy(result.begin(), result.end(), indices.begin());
+}
+
+void RS::MeshOptimizer::OptimizeVertexFetch(Mesh& mesh)
+{
+	std::vector<uint32> remap(mesh.vertices.size(), UINT32_MAX);
+	std::vector<Vertex> vertices;
+	vertices.reserve(mesh.vertices.size());
+	for (uint32& index : mesh.indices)
+	{
+		if (remap[index] == UINT32_MAX)
+		{
+			remap[index] = (uint32)vertices.size();
+			vertices.push_back(mesh.vertices[index]);
+		}
+		index = remap[index];
+	}
+	mesh.vertices = std::move(vertices);
+}
+
+std::vector<uint32> RS::MeshOptimizer::Simplify(std::span<const uint32> indices, const std::vector<Vertex>& vertices, uint32 targetIndexCount, float targetError, float* pResultError)
+{
+	using namespace _MeshOptimizerInternal;
+
+	std::vector<uint32> result(indices.begin(), indices.end());
+	if (pResultError)
+		*pResultError = 0.f;
+	if (result.size() <= targetIndexCount || vertices.empty())
+		return result;
+
+	const uint32 vertexCount = (uint32)vertices.size();
+	const std::vector<uint32> positionRemap = BuildPositionRemap(vertices);
+
+	// Positions scaled to the unit cube, so the error is relative to the size of the mesh.
+	glm::vec3 boundsMin = vertices[indices[0]].position;
+	glm::vec3 boundsMax = boundsMin;
+	for (uint32 index : indices)
+	{
+		const glm::vec3 p = vertices[index].position;
+		boundsMin = glm::min(boundsMin, p);
+		boundsMax = glm::max(boundsMax, p);
+	}
+	const float extent = std::max({ boundsMax.x - boundsMin.x, boundsMax.y - boundsMin.y, boundsMax.z - boundsMin.z });
+	const float scale = extent > 0.f ? 1.f / extent : 1.f;
+	std::vector<glm::vec3> positions(vertexCount);
+	for (uint32 v = 0; v < vertexCount; ++v)
+		positions[v] = (glm::vec3(vertices[v].position) - boundsMin) * scale;
+
+	// The vertices used at each position. Positions with more than one UV are on a UV seam, split normals are fine.
+	std::vector<uint32> wedgeHeads(vertexCount, UINT32_MAX);
+	std::vector<uint32> wedgeNext(vertexCount, UINT32_MAX);
+	std::vector<uint8> isOnUVSeam(vertexCount, 0);
+	std::vector<uint8> isUsed(vertexCount, 0);
+	for (uint32 index : indices)
+	{
+		if (isUsed[index])
+			continue;
+		isUsed[index] = 1;
+
+		const uint32 r = positionRemap[index];
+		if (wedgeHeads[r] != UINT32_MAX)
+		{
+			const Vec2& headUV = vertices[wedgeHeads[r]].uv;
+			isOnUVSeam[r] |= headUV.x != vertices[index].uv.x || headUV.y != vertices[index].uv.y;
+		}
+		wedgeNext[index] = wedgeHeads[r];
+		wedgeHeads[r] = index;
+	}
+
+	// Edges between positions, used by one triangle on a border and by more than two on non-manifold geometry.
+	std::unordered_map<uint64, uint32> edgeCounts;
+	edgeCounts.reserve(indices.size());
+	for (uint64 i = 0; i + 2 < indices.size(); i += 3)
+	{
+		for (uint32 e = 0; e < 3; ++e)
+		{
+			const uint32 a = positionRemap[indices[i + e]];
+			const uint32 b = positionRemap[indices[i + (e + 1) % 3]];
+			edgeCounts[GetEdgeKey(a, b)]++;
+		}
+	}
+
+	std::vector<VertexKind> kinds(vertexCount, VertexKind::Manifold);
+	std::vector<uint32> borderEdgeCounts(vertexCount, 0);
+	for (const auto& [key, count] : edgeCounts)
+	{
+		const uint32 a = (uint32)(key >> 32);
+		const uint32 b = (uint32)key;
+		if (count == 1)
+		{
+			borderEdgeCounts[a]++;
+			borderEdgeCounts[b]++;
+		}
+		else if (count > 2)
+		{
+			kinds[a] = VertexKind::Locked;
+			kinds[b] = VertexKind::Locked;
+		}
+	}
+	for (uint32 v = 0; v < vertexCount; ++v)
+	{
+		if (positionRemap[v] != v || kinds[v] == VertexKind::Locked)
+			continue;
+		if (isOnUVSeam[v] || (borderEdgeCounts[v] != 0 && borderEdgeCounts[v] != 2))
+			kinds[v] = VertexKind::Locked;
+		else if (borderEdgeCounts[v] == 2)
+			kinds[v] = VertexKind::Border;
+	}
+
+	// Area weighted plane quadrics, and planes through the border edges that keep the outline in place.
+	std::vector<Quadric> quadrics(vertexCount);
+	for (uint64 i = 0; i + 2 < indices.size(); i += 3)
+	{
+		const uint32 r[3] = { positionRemap[indices[i]], positionRemap[indices[i + 1]], positionRemap[indices[i + 2]] };
+		const glm::vec3 p0 = positions[r[0]], p1 = positions[r[1]], p2 = positions[r[2]];
+		glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+		const float doubleArea = std::sqrt(glm::dot(normal, normal));
+		if (doubleArea <= 0.f)
+			continue;
+		normal = normal * (1.f / doubleArea);
+
+		const Quadric faceQuadric = Quadric::FromPlane(normal.x, normal.y, normal.z, -glm::dot(normal, p0), doubleArea * 0.5f);
+		for (uint32 v : r)
+			quadrics[v].Add(faceQuadric);
+
+		for (uint32 e = 0; e < 3; ++e)
+		{
+			const uint32 a = r[e];
+			const uint32 b = r[(e + 1) % 3];
+			if (edgeCounts[GetEdgeKey(a, b)] != 1)
+				continue;
+
+			const glm::vec3 edge = positions[b] - positions[a];
+			const float edgeLength = std::sqrt(glm::dot(edge, edge));
+			glm::vec3 edgeNormal = glm::cross(edge, normal);
+			const float edgeNormalLength = std::sqrt(glm::dot(edgeNormal, edgeNormal));
+			if (edgeNormalLength <= 0.f)
+				continue;
+			edgeNormal = edgeNormal * (1.f / edgeNormalLength);
+
+			constexpr float BorderWeight = 10.f;
+			const Quadric edgeQuadric = Quadric::FromPlane(edgeNormal.x, edgeNormal.y, edgeNormal.z, -glm::dot(edgeNormal, positions[a]), edgeLength * edgeLength * BorderWeight);
+			quadrics[a].Add(edgeQuadric);
+			quadrics[b].Add(edgeQuadric);
+		}
+	}
+
+	struct Collapse
+	{
+		uint32 from;	// Position remapped.
+		uint32 to;
+		double cost;
+	};
+
+	const double maxCost = (double)targetError * targetError;
+	double resultCost = 0.0;
+	std::vector<uint8> isTouched(vertexCount);
+	std::vector<uint32> wedgeTargets(vertexCount);
+	MeshAdjacency adjacency;
+	std::vector<Collapse> collapses;
+
+	while (result.size() > targetIndexCount)
+	{
+		std::vector<uint32> remappedIndices(result.size());
+		for (uint64 i = 0; i < result.size(); ++i)
+			remappedIndices[i] = positionRemap[result[i]];
+		adjacency.Build(remappedIndices, vertexCount);
+
+		std::unordered_map<uint64, uint32> currentEdgeCounts;
+		currentEdgeCounts.reserve(result.size());
+		for (uint64 i = 0; i < remappedIndices.size(); i += 3)
+		{
+			for (uint32 e = 0; e < 3; ++e)
+				currentEdgeCounts[GetEdgeKey(remappedIndices[i + e], remappedIndices[i + (e + 1) % 3])]++;
+		}
+
+		collapses.clear();
+		for (uint64 i = 0; i < remappedIndices.size(); i += 3)
+		{
+			for (uint32 e = 0; e < 3; ++e)
+			{
+				const uint32 a = remappedIndices[i + e];
+				const uint32 b = remappedIndices[i + (e + 1) % 3];
+				const bool isBorderEdge = currentEdgeCounts[GetEdgeKey(a, b)] == 1;
+				for (uint32 direction = 0; direction < 2; ++direction)
+				{
+					const uint32 from = direction == 0 ? a : b;
+					const uint32 to = direction == 0 ? b : a;
+					const bool isAllowed = kinds[from] == VertexKind::Manifold
+						|| (kinds[from] == VertexKind::Border && isBorderEdge && kinds[to] != VertexKind::Manifold);
+					if (!isAllowed)
+						continue;
+
+					Quadric q = quadrics[from];
+					q.Add(quadrics[to]);
+					collapses.push_back({ from, to, q.Evaluate(positions[to]) });
+				}
+			}
+		}
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& lhs, const Collapse& rhs)
+			{
+				if (lhs.cost != rhs.cost)
+					return lhs.cost < rhs.cost;
+				return lhs.from != rhs.from ? lhs.from < rhs.from : lhs.to < rhs.to;
+			});
+
+		// Every collapse removes about two triangles.
+		const uint64 collapseGoal = (result.size() - targetIndexCount) / 6 + 1;
+		uint64 collapseCount = 0;
+		std::fill(isTouched.begin(), isTouched.end(), 0);
+		std::iota(wedgeTargets.begin(), wedgeTargets.end(), 0);
+
+		for (const Collapse& collapse : collapses)
+		{
+			if (collapse.cost > maxCost || collapseCount >= collapseGoal)
+				break;
+			if (isTouched[collapse.from] || isTouched[collapse.to])
+				continue;
+
+			// The triangles around the vertex must not flip.
+			const uint32* pTriangles = adjacency.triangles.data() + adjacency.offsets[collapse.from];
+			const uint32 triangleCount = adjacency.counts[collapse.from];
+			bool isValid = true;
+			for (uint32 j = 0; j < triangleCount && isValid; ++j)
+			{
+				const uint32* pRemapped = remappedIndices.data() + (uint64)pTriangles[j] * 3;
+				uint32 fromCorner = 0;
+				bool hasTo = false;
+				for (uint32 k = 0; k < 3; ++k)
+				{
+					if (pRemapped[k] == collapse.from)
+						fromCorner = k;
+					hasTo |= pRemapped[k] == collapse.to;
+				}
+				if (hasTo)
+					continue;
+
+				const glm::vec3 p0 = positions[pRemapped[0]], p1 = positions[pRemapped[1]], p2 = positions[pRemapped[2]];
+				glm::vec3 moved[3] = { p0, p1, p2 };
+				moved[fromCorner] = positions[collapse.to];
+				const glm::vec3 normalBefore = glm::cross(p1 - p0, p2 - p0);
+				const glm::vec3 normalAfter = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+				// Triangles that already had no area cannot flip.
+				const float lengthBefore2 = glm::dot(normalBefore, normalBefore);
+				if (lengthBefore2 > 0.f)
+					isValid &= glm::dot(normalBefore, normalAfter) > 0.25f * std::sqrt(lengthBefore2 * glm::dot(normalAfter, normalAfter));
+			}
+			if (!isValid)
+				continue;
+
+			// Each vertex at the position moves to the vertex at the target with the closest normal, the UVs are the same.
+			for (uint32 fromWedge = wedgeHeads[collapse.from]; fromWedge != UINT32_MAX; fromWedge = wedgeNext[fromWedge])
+			{
+				const glm::vec3 fromNormal = vertices[fromWedge].normal;
+				float bestDot = -FLT_MAX;
+				for (uint32 toWedge = wedgeHeads[collapse.to]; toWedge != UINT32_MAX; toWedge = wedgeNext[toWedge])
+				{
+					const float dot = glm::dot(fromNormal, glm::vec3(vertices[toWedge].normal));
+					if (dot > bestDot)
+					{
+						bestDot = dot;
+						wedgeTargets[fromWedge] = toWedge;
+					}
+				}
+			}
+			quadrics[collapse.to].Add(quadrics[collapse.from]);
+			resultCost = std::max(resultCost, collapse.cost);
+			collapseCount++;
+
+			// Moving the ring of the vertex would make the flip test above wrong.
+			for (uint32 j = 0; j < triangleCount; ++j)
+			{
+				for (uint32 k = 0; k < 3; ++k)
+					isTouched[remappedIndices[(uint64)pTriangles[j] * 3 + k]] = 1;
+			}
+		}
+
+		if (collapseCount == 0)
+			break;
+
+		uint64 writeIndex = 0;
+		for (uint64 i = 0; i < result.size(); i += 3)
+		{
+			const uint32 a = wedgeTargets[result[i]];
+			const uint32 b = wedgeTargets[result[i + 1]];
+			const uint32 c = wedgeTargets[result[i + 2]];
+			const uint32 ra = positionRemap[a], rb = positionRemap[b], rc = positionRemap[c];
+			if (ra == rb || rb == rc || ra == rc)
+				continue;
+			result[writeIndex++] = a;
+			result[writeIndex++] = b;
+			result[writeIndex++] = c;
+		}
+		result.resize(writeIndex);
+	}
+
+	if (pResultError)
+		*pResultError = (float)std::sqrt(resultCost);
+	return result;
+}
+
+std::vector<RS::MeshLOD> RS::MeshOptimizer::Optimize(Mesh& mesh, const MeshOptimizerSettings& settings, MeshOptimizerReport* pReport)
+{
+	using namespace _MeshOptimizerInternal;
+
+	const uint32 vertexCount = (uint32)mesh.vertices.size();
+	VertexCacheStats cacheBefore = AnalyzeVertexCache(mesh.indices, vertexCount, settings.cacheSize);
+	VertexFetchStats fetchBefore = AnalyzeVertexFetch(mesh.indices, vertexCount, sizeof(Vertex));
+
+	OptimizeVertexCache(mesh.indices, vertexCount);
+	AppendStage(pReport, "Vertex cache", cacheBefore, fetchBefore, mesh.indices, vertexCount, settings);
+
+	cacheBefore = AnalyzeVertexCache(mesh.indices, vertexCount, settings.cacheSize);
+	fetchBefore = AnalyzeVertexFetch(mesh.indices, vertexCount, sizeof(Vertex));
+	OptimizeOverdraw(mesh.indices, mesh.vertices, settings.overdrawThreshold, settings.cacheSize);
+	AppendStage(pReport, "Overdraw", cacheBefore, fetchBefore, mesh.indices, vertexCount, settings);
+
+	// Every LOD is simplified from LOD 0, so the errors do not add up.
+	const VertexCacheStats lod0Cache = AnalyzeVertexCache(mesh.indices, vertexCount, settings.cacheSize);
+	const VertexFetchStats lod0Fetch = AnalyzeVertexFetch(mesh.indices, vertexCount, sizeof(Vertex));
+	std::vector<MeshLOD> lods(1);
+	lods[0].indexCount = (uint32)mesh.indices.size();
+	std::vector<uint32> lodIndices = mesh.indices;
+	uint32 lastIndexCount = lods[0].indexCount;
+	for (uint32 lod = 1; lod < settings.lodCount; ++lod)
+	{
+		const uint32 targetIndexCount = (uint32)(lastIndexCount / 3 * settings.lodReduction) * 3;
+		float error = 0.f;
+		std::vector<uint32> simplified = Simplify(mesh.indices, mesh.vertices, targetIndexCount, settings.lodMaxError, &error);
+
+		// Stop when the error limit or the seams do not let the mesh get much simpler.
+		if (simplified.empty() || simplified.size() > lastIndexCount * 0.9f)
+			break;
+
+		OptimizeVertexCache(simplified, vertexCount);
+		AppendStage(pReport, Utils::Format("LOD {}", lod), lod0Cache, lod0Fetch, simplified, vertexCount, settings);
+
+		MeshLOD meshLOD;
+		meshLOD.firstIndex = (uint32)lodIndices.size();
+		meshLOD.indexCount = (uint32)simplified.size();
+		meshLOD.error = error;
+		lods.push_back(meshLOD);
+		lodIndices.insert(lodIndices.end(), simplified.begin(), simplified.end());
+		lastIndexCount = meshLOD.indexCount;
+	}
+
+	// The vertices follow LOD 0, the other LODs use a subset of them.
+	mesh.indices = std::move(lodIndices);
+	cacheBefore = AnalyzeVertexCache(std::span<const uint32>(mesh.indices.data(), lods[0].indexCount), vertexCount, settings.cacheSize);
+	fetchBefore = AnalyzeVertexFetch(std::span<const uint32>(mesh.indices.data(), lods[0].indexCount), vertexCount, sizeof(Vertex));
+	OptimizeVertexFetch(mesh);
+	AppendStage(pReport, "Vertex fetch", cacheBefore, fetchBefore, std::span<const uint32>(mesh.indices.data(), lods[0].indexCount), (uint32)mesh.vertices.size(), settings);
+
+	return lods;
+}
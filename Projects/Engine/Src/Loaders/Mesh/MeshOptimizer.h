@@ -0,0 +1,110 @@
+#pragma once
+
+#include "Loaders/openfbx/FBXLoader.h"
+
+#include <span>
+
+namespace RS
+{
+	struct VertexCacheStats
+	{
+		uint32 vertexTransforms = 0;
+		float acmr = 0.f;	// Average cache miss ratio, transforms per triangle. 0.5 is the best a regular grid can get.
+		float atvr = 0.f;	// Average transform to vertex ratio, 1 is the best possible.
+	};
+
+	struct VertexFetchStats
+	{
+		uint64 bytesFetched = 0;
+		float overfetch = 0.f;	// Bytes fetched per byte of the vertices that are used, 1 is the best possible.
+	};
+
+	struct MeshLOD
+	{
+		uint32 firstIndex = 0;
+		uint32 indexCount = 0;
+		float error = 0.f;	// Relative to the size of the mesh.
+		uint32 firstMeshlet = 0;	// Filled in by the MeshCooker when it builds meshlets.
+		uint32 meshletCount = 0;
+	};
+
+	struct MeshOptimizerSettings
+	{
+		uint32 cacheSize = 16;				// Of the FIFO cache the stats are measured with.
+		float overdrawThreshold = 1.05f;	// How much worse the ACMR is allowed to get to reduce overdraw.
+		uint32 lodCount = 4;				// Including LOD 0.
+		float lodReduction = 0.5f;			// Triangles of each LOD compared to the one before.
+		float lodMaxError = 0.02f;			// Relative to the size of the mesh.
+	};
+
+	struct MeshOptimizerReport
+	{
+		struct Stage
+		{
+			std::string name;
+			VertexCacheStats cacheBefore;
+			VertexCacheStats cacheAfter;
+			VertexFetchStats fetchBefore;
+			VertexFetchStats fetchAfter;
+		};
+		std::vector<Stage> stages;
+	};
+
+	// Triangles of each vertex, in the order they appear.
+	struct MeshAdjacency
+	{
+		std::vector<uint32> offsets;
+		std::vector<uint32> counts;
+		std::vector<uint32> triangles;
+
+		/*
+		* Build from indices that have been through BuildPositionRemap to get the triangles of each position instead.
+		*/
+		void Build(std::span<const uint32> indices, uint32 vertexCount);
+	};
+
+	/*
+	* Reorders the triangles and vertices of indexed triangle lists for the GPU, and simplifies them into LODs.
+	* Every function is deterministic, the same input always gives the same output.
+	*/
+	class MeshOptimizer
+	{
+	public:
+		RS_STATIC_CLASS(MeshOptimizer)
+
+		static VertexCacheStats AnalyzeVertexCache(std::span<const uint32> indices, uint32 vertexCount, uint32 cacheSize = 16);
+		// Simulates a small cache of 64 byte lines.
+		static VertexFetchStats AnalyzeVertexFetch(std::span<const uint32> indices, uint32 vertexCount, uint32 vertexSize);
+
+		// For every vertex the first vertex with the same position.
+		static std::vector<uint32> BuildPositionRemap(std::span<const Vertex> vertices);
+
+		/*
+		* Tom Forsyth's linear-speed vertex cache optimization. Orders the triangles so that consecutive triangles share vertices.
+		*/
+		static void OptimizeVertexCache(std::span<uint32> indices, uint32 vertexCount);
+
+		/*
+		* Splits triangles that are in vertex cache order into clusters, and sorts the clusters so that the ones facing out of the
+		* mesh are drawn first. The clusters are split where the ACMR stays within threshold of what it was.
+		*/
+		static void OptimizeOverdraw(std::span<uint32> indices, const std::vector<Vertex>& vertices, float threshold = 1.05f, uint32 cacheSize = 16);
+
+		/*
+		* Orders the vertices in the order the indices first use them and removes the ones that are not used.
+		*/
+		static void OptimizeVertexFetch(Mesh& mesh);
+
+		/*
+		* Quadric error edge collapses, keeps collapsing until the index count is at or below targetIndexCount or the next collapse
+		* would give an error larger than targetError. The error only depends on the positions. Vertices on UV seams are never moved,
+		* split normals are merged with the closest normal at the collapsed position. The result uses the same vertices as the input.
+		*/
+		static std::vector<uint32> Simplify(std::span<const uint32> indices, const std::vector<Vertex>& vertices, uint32 targetIndexCount, float targetError, float* pResultError = nullptr);
+
+		/*
+		* Runs every stage on an indexed mesh. The indices of the LODs are stored after each other, starting with LOD 0, and share the vertices.
+		*/
+		static std::vector<MeshLOD> Optimize(Mesh& mesh, const MeshOptimizerSettings& settings, MeshOptimizerReport* pReport = nullptr);
+	};
+}
@@ -0,0 +1,341 @@
+#include "PreCompiled.h"
+#include "MeshletBuilder.h"
+
+#include "Core/ThreadPool.h"
+#include "MeshOptimizer.h"
+
+#include "Maths/GLMDefines.h"
+#include <glm/glm.hpp>
+
+#include <cmath>
+
+namespace RS::_MeshletBuilderInternal
+{
+	constexpr uint32 MaxMeshletSize = 256;
+
+	bool TryNormalize(glm::vec3& v)
+	{
+		const float length = glm::length(v);
+		if (!(length > 1e-12f))
+			return false;
+		v *= 1.f / length;
+		return true;
+	}
+
+	// Ritter's bounding sphere, within a few percent of the smallest one.
+	void ComputeBoundingSphere(const std::vector<glm::vec3>& points, glm::vec3& center, float& radius)
+	{
+		uint32 minIndex[3] = {};
+		uint32 maxIndex[3] = {};
+		for (uint32 i = 1; i < (uint32)points.size(); ++i)
+		{
+			for (uint32 axis = 0; axis < 3; ++axis)
+			{
+				const float value = points[i][axis];
+				if (value < points[minIndex[axis]][axis])
+					minIndex[axis] = i;
+				if (value > points[maxIndex[axis]][axis])
+					maxIndex[axis] = i;
+			}
+		}
+
+		// Start with the pair of extremes that are the furthest apart.
+		uint32 widestAxis = 0;
+		float widestDistance = -1.f;
+		for (uint32 axis = 0; axis < 3; ++axis)
+		{
+			const glm::vec3 offset = points[maxIndex[axis]] - points[minIndex[axis]];
+			const float distance = glm::dot(offset, offset);
+			if (distance > widestDistance)
+			{
+				widestAxis = axis;
+				widestDistance = distance;
+			}
+		}
+
+		const glm::vec3& p0 = points[minIndex[widestAxis]];
+		const glm::vec3& p1 = points[maxIndex[widestAxis]];
+		center = (p0 + p1) * 0.5f;
+		radius = std::sqrt(widestDistance) * 0.5f;
+
+		for (const glm::vec3& point : points)
+		{
+			const glm::vec3 offset = point - center;
+			const float distance = std::sqrt(glm::dot(offset, offset));
+			if (distance > radius)
+			{
+				const float newRadius = (radius + distance) * 0.5f;
+				center = center + offset * ((newRadius - radius) / distance);
+				radius = newRadius;
+			}
+		}
+	}
+}
+
+RS::MeshletData RS::MeshletBuilder::Build(const MeshletSource& source, const MeshletSettings& settings)
+{
+	using namespace _MeshletBuilderInternal;
+
+	RS_ASSERT(settings.maxVertices >= 3 && settings.maxVertices <= MaxMeshletSize, "Meshlets must have between 3 and {} vertices, not {}!", MaxMeshletSize, settings.maxVertices);
+	RS_ASSERT(settings.maxTriangles >= 1 && settings.maxTriangles <= MaxMeshletSize, "Meshlets must have between 1 and {} triangles, not {}!", MaxMeshletSize, settings.maxTriangles);
+
+	MeshletData result;
+	const std::span<const uint32> indices = source.indices;
+	const uint32 triangleCount = (uint32)(indices.size() / 3);
+	if (triangleCount == 0)
+		return result;
+
+	// The triangles of each position, so the candidates are found across split vertices.
+	const std::vector<uint32> positionRemap = MeshOptimizer::BuildPositionRemap(source.vertices);
+	std::vector<uint32> positionIndices((uint64)triangleCount * 3);
+	for (uint64 i = 0; i < positionIndices.size(); ++i)
+		positionIndices[i] = positionRemap[indices[i]];
+	MeshAdjacency adjacency;
+	adjacency.Build(positionIndices, (uint32)source.vertices.size());
+
+	// Degenerate triangles get a zero normal, which makes them fit with any meshlet.
+	std::vector<glm::vec3> centroids(triangleCount);
+	std::vector<glm::vec3> normals(triangleCount);
+	for (uint32 t = 0; t < triangleCount; ++t)
+	{
+		const glm::vec3 p0 = source.vertices[indices[t * 3]].position;
+		const glm::vec3 p1 = source.vertices[indices[t * 3 + 1]].position;
+		const glm::vec3 p2 = source.vertices[indices[t * 3 + 2]].position;
+		centroids[t] = (p0 + p1 + p2) * (1.f / 3.f);
+		normals[t] = glm::cross(p1 - p0, p2 - p0);
+		if (!TryNormalize(normals[t]))
+			normals[t] = glm::vec3(0.f);
+	}
+
+	std::vector<uint8> isEmitted(triangleCount, 0);
+	std::vector<uint32> localIndices(source.vertices.size(), UINT32_MAX);
+	// Split vertices share a position, the candidates are only searched once per position.
+	std::vector<uint32> positionMeshlets(source.vertices.size(), UINT32_MAX);
+	std::vector<uint32> meshletPositions;
+	std::vector<uint32> meshletIndices;
+	Meshlet meshlet;
+	glm::vec3 centroidSum(0.f);
+	glm::vec3 normalSum(0.f);
+	uint32 emittedCount = 0;
+	uint32 nextUnemitted = 0;
+
+	auto countNewVertices = [&](uint32 triangle)
+	{
+		uint32 count = 0;
+		for (uint32 corner = 0; corner < 3; ++corner)
+			count += localIndices[indices[triangle * 3 + corner]] == UINT32_MAX ? 1 : 0;
+		return count;
+	};
+
+	auto finishMeshlet = [&]()
+	{
+		meshletIndices.clear();
+		for (uint32 i = 0; i < meshlet.triangleCount; ++i)
+		{
+			const uint32 triangle = result.triangles[meshlet.triangleOffset + i];
+			for (uint32 corner = 0; corner < 3; ++corner)
+				meshletIndices.push_back(result.vertices[meshlet.vertexOffset + UnpackIndex(triangle, corner)]);
+		}
+		for (uint32 i = 0; i < meshlet.vertexCount; ++i)
+			localIndices[result.vertices[meshlet.vertexOffset + i]] = UINT32_MAX;
+
+		result.meshlets.push_back(meshlet);
+		result.bounds.push_back(ComputeBounds(meshletIndices, source.vertices));
+		meshlet = { (uint32)result.vertices.size(), (uint32)result.triangles.size(), 0, 0 };
+		meshletPositions.clear();
+		centroidSum = glm::vec3(0.f);
+		normalSum = glm::vec3(0.f);
+	};
+
+	while (emittedCount < triangleCount)
+	{
+		// The connected triangle that adds the fewest vertices, then the closest one that faces the same way as the meshlet.
+		uint32 best = UINT32_MAX;
+		uint32 bestNewVertices = 4;
+		float bestScore = FLT_MAX;
+		if (meshlet.triangleCount > 0)
+		{
+			const glm::vec3 center = centroidSum * (1.f / (float)meshlet.triangleCount);
+			glm::vec3 axis = normalSum;
+			if (!TryNormalize(axis))
+				axis = glm::vec3(0.f);
+
+			for (uint32 position : meshletPositions)
+			{
+				for (uint32 j = adjacency.offsets[position]; j < adjacency.offsets[position + 1]; ++j)
+				{
+					const uint32 triangle = adjacency.triangles[j];
+					if (isEmitted[triangle])
+						continue;
+
+					const uint32 newVertices = countNewVertices(triangle);
+					if (newVertices > bestNewVertices || meshlet.vertexCount + newVertices > settings.maxVertices)
+						continue;
+
+					// Squared, which keeps the order.
+					const glm::vec3 offset = centroids[triangle] - center;
+					const float weight = 1.f + settings.coneWeight * (1.f - glm::dot(axis, normals[triangle]));
+					const float score = glm::dot(offset, offset) * weight * weight;
+					if (newVertices < bestNewVertices || score < bestScore || (score == bestScore && triangle < best))
+					{
+						best = triangle;
+						bestNewVertices = newVertices;
+						bestScore = score;
+					}
+				}
+			}
+		}
+
+		// Nothing connected fits, continue with the next triangle in the input order, which is close to the last ones in an optimized mesh.
+		if (best == UINT32_MAX)
+		{
+			while (isEmitted[nextUnemitted])
+				nextUnemitted++;
+			best = nextUnemitted;
+			if (meshlet.vertexCount + countNewVertices(best) > settings.maxVertices)
+				finishMeshlet();
+		}
+
+		uint32 local[3];
+		for (uint32 corner = 0; corner < 3; ++corner)
+		{
+			const uint32 index = indices[best * 3 + corner];
+			if (localIndices[index] == UINT32_MAX)
+			{
+				localIndices[index] = meshlet.vertexCount++;
+				result.vertices.push_back(index);
+
+				const uint32 position = positionRemap[index];
+				if (positionMeshlets[position] != (uint32)result.meshlets.size())
+				{
+					positionMeshlets[position] = (uint32)result.meshlets.size();
+					meshletPositions.push_back(position);
+				}
+			}
+			local[corner] = localIndices[index];
+		}
+		result.triangles.push_back(PackTriangle(local[0], local[1], local[2]));
+		meshlet.triangleCount++;
+		centroidSum = centroidSum + centroids[best];
+		normalSum = normalSum + normals[best];
+		isEmitted[best] = 1;
+		emittedCount++;
+
+		if (meshlet.triangleCount == settings.maxTriangles)
+			finishMeshlet();
+	}
+
+	if (meshlet.triangleCount > 0)
+		finishMeshlet();
+	return result;
+}
+
+std::vector<RS::MeshletData> RS::MeshletBuilder::Build(std::span<const MeshletSource> sources, const MeshletSettings& settings, uint maxThreads)
+{
+	std::vector<MeshletData> results(sources.size());
+	ThreadPool::Get()->ParallelFor(sources.size(), [&](uint64 index)
+		{
+			results[index] = Build(sources[index], settings);
+		}, maxThreads);
+	return results;
+}
+
+RS::MeshletBounds RS::MeshletBuilder::ComputeBounds(std::span<const uint32> indices, std::span<const Vertex> vertices)
+{
+	using namespace _MeshletBuilderInternal;
+
+	MeshletBounds bounds;
+	if (indices.size() < 3)
+		return bounds;
+
+	std::vector<glm::vec3> points(indices.size());
+	for (uint64 i = 0; i < indices.size(); ++i)
+		points[i] = glm::vec3(vertices[indices[i]].position);
+
+	glm::vec3 center(0.f);
+	float radius = 0.f;
+	ComputeBoundingSphere(points, center, radius);
+	bounds.center[0] = center.x;
+	bounds.center[1] = center.y;
+	bounds.center[2] = center.z;
+	bounds.radius = radius;
+	bounds.coneApex[0] = center.x;
+	bounds.coneApex[1] = center.y;
+	bounds.coneApex[2] = center.z;
+
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec3> corners;
+	glm::vec3 axis(0.f);
+	for (uint64 i = 0; i + 2 < points.size(); i += 3)
+	{
+		glm::vec3 normal = glm::cross(points[i + 1] - points[i], points[i + 2] - points[i]);
+		if (!TryNormalize(normal))
+			continue;
+		normals.push_back(normal);
+		corners.push_back(points[i]);
+		axis = axis + normal;
+	}
+	if (normals.empty() || !TryNormalize(axis))
+		return bounds;
+
+	float minDot = 1.f;
+	for (const glm::vec3& normal : normals)
+		minDot = std::min(minDot, glm::dot(axis, normal));
+
+	// A cone this wide culls almost nothing, and the apex would be far behind the meshlet.
+	if (minDot <= 0.1f)
+		return bounds;
+
+	// Move the apex back until every triangle plane is in front of it.
+	float maxDistance = 0.f;
+	for (uint64 i = 0; i < normals.size(); ++i)
+		maxDistance = std::max(maxDistance, glm::dot(center - corners[i], normals[i]) / glm::dot(axis, normals[i]));
+
+	const glm::vec3 apex = center - axis * maxDistance;
+	bounds.coneApex[0] = apex.x;
+	bounds.coneApex[1] = apex.y;
+	bounds.coneApex[2] = apex.z;
+
+	// Widen the cutoff by the rounding error of the axis, so the quantized cone never culls more than the exact one.
+	float axisError = 0.f;
+	for (uint32 i = 0; i < 3; ++i)
+	{
+		const float value = axis[i];
+		bounds.coneAxis[i] = (int8)std::lround(std::clamp(value, -1.f, 1.f) * 127.f);
+		axisError += std::abs((float)bounds.coneAxis[i] / 127.f - value);
+	}
+
+	const float cutoff = std::sqrt(1.f - minDot * minDot) + axisError;
+	bounds.coneCutoff = (int8)std::min(127.f, std::ceil(cutoff * 127.f));
+	return bounds;
+}
+
+bool RS::MeshletBuilder::IsBackfacing(const MeshletBounds& bounds, const Vec3& cameraPosition)
+{
+	using namespace _MeshletBuilderInternal;
+
+	if (bounds.coneCutoff >= 127)
+		return false;
+
+	glm::vec3 direction = glm::vec3(bounds.coneApex[0], bounds.coneApex[1], bounds.coneApex[2]) - glm::vec3(cameraPosition);
+	if (!TryNormalize(direction))
+		return false;
+
+	const glm::vec3 axis = glm::vec3((float)bounds.coneAxis[0], (float)bounds.coneAxis[1], (float)bounds.coneAxis[2]) * (1.f / 127.f);
+	return glm::dot(direction, axis) >= (float)bounds.coneCutoff / 127.f;
+}
+
+void RS::MeshletBuilder::Append(MeshletData& dst, const MeshletData& src)
+{
+	const uint32 vertexOffset = (uint32)dst.vertices.size();
+	const uint32 triangleOffset = (uint32)dst.triangles.size();
+	for (Meshlet meshlet : src.meshlets)
+	{
+		meshlet.vertexOffset += vertexOffset;
+		meshlet.triangleOffset += triangleOffset;
+		dst.meshlets.push_back(meshlet);
+	}
+	dst.bounds.insert(dst.bounds.end(), src.bounds.begin(), src.bounds.end());
+	dst.vertices.insert(dst.vertices.end(), src.vertices.begin(), src.vertices.end());
+	dst.triangles.insert(dst.triangles.end(), src.triangles.begin(), src.triangles.end());
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "Loaders/openfbx/FBXLoader.h"
+
+#include <span>
+
+namespace RS
+{
+	struct Meshlet
+	{
+		uint32 vertexOffset = 0;	// Into MeshletData::vertices.
+		uint32 triangleOffset = 0;	// Into MeshletData::triangles.
+		uint32 vertexCount = 0;
+		uint32 triangleCount = 0;
+	};
+	static_assert(sizeof(Meshlet) == 16);
+
+	/*
+	* Culling data of a meshlet, in the space of the mesh.
+	* The meshlet faces away from a camera at position p when dot(normalize(coneApex - p), coneAxis) >= coneCutoff.
+	*/
+	struct MeshletBounds
+	{
+		float center[3] = {};
+		float radius = 0.f;
+		float coneApex[3] = {};
+		int8 coneAxis[3] = {};	// Snorm.
+		int8 coneCutoff = 127;	// Snorm, 127 when the triangles face too many directions for the cone to cull anything.
+	};
+	static_assert(sizeof(MeshletBounds) == 32);
+
+	struct MeshletSettings
+	{
+		uint32 maxVertices = 64;	// At most 256, the limit of a mesh shader.
+		uint32 maxTriangles = 124;	// At most 256.
+		float coneWeight = 0.25f;	// How much the builder prefers triangles that face the same way over triangles that are close.
+	};
+
+	struct MeshletData
+	{
+		std::vector<Meshlet> meshlets;
+		std::vector<MeshletBounds> bounds;	// One per meshlet.
+		std::vector<uint32> vertices;		// Indices into the vertices of the mesh.
+		std::vector<uint32> triangles;		// Three 10 bit indices into the vertices of the meshlet, see PackTriangle.
+	};
+
+	struct MeshletSource
+	{
+		std::span<const uint32> indices;
+		std::span<const Vertex> vertices;
+	};
+
+	/*
+	* Splits indexed triangle lists into meshlets for mesh shaders. Triangles are added to a meshlet in the order that reuses the most
+	* of its vertices, then by how close they are and how much they face the same way, so the meshlets stay round and cull well.
+	* Triangles that share a position count as connected even when the vertices are split by a seam.
+	*/
+	class MeshletBuilder
+	{
+	public:
+		RS_STATIC_CLASS(MeshletBuilder)
+
+		static MeshletData Build(const MeshletSource& source, const MeshletSettings& settings = MeshletSettings());
+
+		/*
+		* Builds every source on the ThreadPool, one job per source. maxThreads works like it does for ThreadPool::ParallelFor.
+		*/
+		static std::vector<MeshletData> Build(std::span<const MeshletSource> sources, const MeshletSettings& settings = MeshletSettings(), uint maxThreads = 0);
+
+		/*
+		* Bounding sphere and normal cone of the triangles. The cone is quantized conservatively, it never culls a triangle
+		* that faces the camera.
+		*/
+		static MeshletBounds ComputeBounds(std::span<const uint32> indices, std::span<const Vertex> vertices);
+
+		// Culling test of a meshlet against a camera position, in the space of the mesh.
+		static bool IsBackfacing(const MeshletBounds& bounds, const Vec3& cameraPosition);
+
+		// Appends the meshlets of src to dst, fixing up the offsets.
+		static void Append(MeshletData& dst, const MeshletData& src);
+
+		static uint32 PackTriangle(uint32 i0, uint32 i1, uint32 i2) { return i0 | (i1 << 10) | (i2 << 20); }
+		static uint32 UnpackIndex(uint32 triangle, uint32 corner) { return (triangle >> (corner * 10)) & 0x3FF; }
+	};
+}
@@ -0,0 +1,663 @@
+#include "PreCompiled.h"
+#include "BCCompression.h"
+
+#include "Core/ThreadPool.h"
+
+#include <cmath>
+#include <cfloat>
+
+namespace RS::_BCInternal
+{
+	constexpr uint32 PixelCount = 16;
+	constexpr uint32 RefineIterations = 2;
+	constexpr uint32 BC7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	/*
+	* Principal axis of the points from the covariance matrix, found with power iteration.
+	*/
+	template<uint32 N>
+	void FindPrincipalAxis(const float (&points)[PixelCount][N], float (&mean)[N], float (&axis)[N])
+	{
+		for (uint32 c = 0; c < N; ++c)
+		{
+			mean[c] = 0.f;
+			for (uint32 i = 0; i < PixelCount; ++i)
+				mean[c] += points[i][c];
+			mean[c] /= PixelCount;
+		}
+
+		float covariance[N][N] = {};
+		for (uint32 i = 0; i < PixelCount; ++i)
+		{
+			for (uint32 a = 0; a < N; ++a)
+			{
+				for (uint32 b = 0; b < N; ++b)
+					covariance[a][b] += (points[i][a] - mean[a]) * (points[i][b] - mean[b]);
+			}
+		}
+
+		for (uint32 c = 0; c < N; ++c)
+			axis[c] = 1.f;
+		for (uint32 iteration = 0; iteration < 8; ++iteration)
+		{
+			float next[N] = {};
+			float length = 0.f;
+			for (uint32 a = 0; a < N; ++a)
+			{
+				for (uint32 b = 0; b < N; ++b)
+					next[a] += covariance[a][b] * axis[b];
+				length = std::max(length, std::abs(next[a]));
+			}
+
+			// Flat blocks have no axis, any direction works.
+			if (length < 1e-6f)
+				return;
+			for (uint32 c = 0; c < N; ++c)
+				axis[c] = next[c] / length;
+		}
+	}
+
+	template<uint32 N>
+	float Dot(const float (&a)[N], const float (&b)[N])
+	{
+		float result = 0.f;
+		for (uint32 c = 0; c < N; ++c)
+			result += a[c] * b[c];
+		return result;
+	}
+
+	// ---- BC1 ----
+
+	uint16 To565(const float (&color)[3])
+	{
+		auto quantize = [](float value, uint32 maxValue) { return (uint32)std::clamp((int32)std::lround(value * maxValue / 255.f), 0, (int32)maxValue); };
+		return (uint16)((quantize(color[0], 31) << 11) | (quantize(color[1], 63) << 5) | quantize(color[2], 31));
+	}
+
+	void From565(uint16 color, int32 (&rgb)[3])
+	{
+		const int32 r = (color >> 11) & 31;
+		const int32 g = (color >> 5) & 63;
+		const int32 b = color & 31;
+		rgb[0] = (r << 3) | (r >> 2);
+		rgb[1] = (g << 2) | (g >> 4);
+		rgb[2] = (b << 3) | (b >> 2);
+	}
+
+	void BC1Palette(uint16 color0, uint16 color1, bool forceFourColors, int32 (&palette)[4][3])
+	{
+		From565(color0, palette[0]);
+		From565(color1, palette[1]);
+		for (uint32 c = 0; c < 3; ++c)
+		{
+			if (forceFourColors || color0 > color1)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+			else
+			{
+				palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+				palette[3][c] = 0;
+			}
+		}
+	}
+
+	void CompressColorBlock(const uint8* pRGBA, uint8* pBlock)
+	{
+		float points[PixelCount][3];
+		for (uint32 i = 0; i < PixelCount; ++i)
+		{
+			for (uint32 c = 0; c < 3; ++c)
+				points[i][c] = pRGBA[i * 4 + c];
+		}
+
+		float mean[3];
+		float axis[3];
+		FindPrincipalAxis(points, mean, axis);
+
+		// Start from the two pixels that are furthest apart along the axis.
+		uint32 minIndex = 0;
+		uint32 maxIndex = 0;
+		float minProjection = FLT_MAX;
+		float maxProjection = -FLT_MAX;
+		for (uint32 i = 0; i < PixelCount; ++i)
+		{
+			const float projection = Dot(points[i], axis);
+			if (projection < minProjection) { minProjection = projection; minIndex = i; }
+			if (projection > maxProjection) { maxProjection = projection; maxIndex = i; }
+		}
+
+		float endpoints[2][3];
+		for (uint32 c = 0; c < 3; ++c)
+		{
+			endpoints[0][c] = points[maxIndex][c];
+			endpoints[1][c] = points[minIndex][c];
+		}
+
+		uint16 bestColors[2] = { 0, 0 };
+		uint32 bestIndices = 0;
+		int64 bestError = INT64_MAX;
+		for (uint32 iteration = 0; iteration <= RefineIterations; ++iteration)
+		{
+			uint16 color0 = To565(endpoints[0]);
+			uint16 color1 = To565(endpoints[1]);
+			if (color0 < color1)
+				std::swap(color0, color1);
+
+			int32 palette[4][3];
+			BC1Palette(color0, color1, true, palette);
+
+			uint32 indices = 0;
+			int64 error = 0;
+			uint32 blockIndices[PixelCount];
+			for (uint32 i = 0; i < PixelCount; ++i)
+			{
+				int32 bestDistance = INT32_MAX;
+				for (uint32 p = 0; p < 4; ++p)
+				{
+					int32 distance = 0;
+					for (uint32 c = 0; c < 3; ++c)
+					{
+						const int32 d = (int32)pRGBA[i * 4 + c] - palette[p][c];
+						distance += d * d;
+					}
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						blockIndices[i] = p;
+					}
+				}
+
+				// Equal endpoints decode as three color mode, where index 0 is still the endpoint.
+				if (color0 == color1)
+					blockIndices[i] = 0;
+				indices |= blockIndices[i] << (2 * i);
+				error += bestDistance;
+			}
+
+			if (error < bestError)
+			{
+				bestError = error;
+				bestColors[0] = color0;
+				bestColors[1] = color1;
+				bestIndices = indices;
+			}
+
+			if (iteration == RefineIterations || color0 == color1)
+				break;
+
+			// Least squares fit of the endpoints to the chosen indices.
+			constexpr float weights[4] = { 1.f, 0.f, 2.f / 3.f, 1.f / 3.f };
+			float aa = 0.f, ab = 0.f, bb = 0.f;
+			float ax[3] = {}, bx[3] = {};
+			for (uint32 i = 0; i < PixelCount; ++i)
+			{
+				const float a = weights[blockIndices[i]];
+				const float b = 1.f - a;
+				aa += a * a;
+				ab += a * b;
+				bb += b * b;
+				for (uint32 c = 0; c < 3; ++c)
+				{
+					ax[c] += a * points[i][c];
+					bx[c] += b * points[i][c];
+				}
+			}
+
+			const float determinant = aa * bb - ab * ab;
+			if (std::abs(determinant) < 1e-6f)
+				break;
+			for (uint32 c = 0; c < 3; ++c)
+			{
+				endpoints[0][c] = std::clamp((ax[c] * bb - bx[c] * ab) / determinant, 0.f, 255.f);
+				endpoints[1][c] = std::clamp((bx[c] * aa - ax[c] * ab) / determinant, 0.f, 255.f);
+			}
+		}
+
+		std::memcpy(pBlock + 0, &bestColors[0], 2);
+		std::memcpy(pBlock + 2, &bestColors[1], 2);
+		std::memcpy(pBlock + 4, &bestIndices, 4);
+	}
+
+	void DecompressColorBlock(const uint8* pBlock, bool forceFourColors, uint8* pRGBA)
+	{
+		uint16 color0, color1;
+		uint32 indices;
+		std::memcpy(&color0, pBlock + 0, 2);
+		std::memcpy(&color1, pBlock + 2, 2);
+		std::memcpy(&indices, pBlock + 4, 4);
+
+		int32 palette[4][3];
+		BC1Palette(color0, color1, forceFourColors, palette);
+		for (uint32 i = 0; i < PixelCount; ++i)
+		{
+			const uint32 index = (indices >> (2 * i)) & 3;
+			for (uint32 c = 0; c < 3; ++c)
+				pRGBA[i * 4 + c] = (uint8)palette[index][c];
+			pRGBA[i * 4 + 3] = (!forceFourColors && color0 <= color1 && index == 3) ? 0 : 255;
+		}
+	}
+
+	// ---- BC4, used for BC3 alpha and both BC5 channels ----
+
+	void BC4Palette(uint8 value0, uint8 value1, int32 (&palette)[8])
+	{
+		palette[0] = value0;
+		palette[1] = value1;
+		if (value0 > value1)
+		{
+			for (int32 i = 2; i < 8; ++i)
+				palette[i] = ((8 - i) * value0 + (i - 1) * value1 + 3) / 7;
+		}
+		else
+		{
+			for (int32 i = 2; i < 6; ++i)
+				palette[i] = ((6 - i) * value0 + (i - 1) * value1 + 2) / 5;
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+	}
+
+	void CompressChannelBlock(const uint8* pRGBA, uint32 channel, uint8* pBlock)
+	{
+		uint8 minValue = 255;
+		uint8 maxValue = 0;
+		for (uint32 i = 0; i < PixelCount; ++i)
+		{
+			minValue = std::min(minValue, pRGBA[i * 4 + channel]);
+			maxValue = std::max(maxValue, pRGBA[i * 4 + channel]);
+		}
+
+		int32 palette[8];
+		BC4Palette(maxValue, minValue, palette);
+
+		uint64 indices = 0;
+		for (uint32 i = 0; i < PixelCount; ++i)
+		{
+			const int32 value = pRGBA[i * 4 + channel];
+			uint64 bestIndex = 0;
+			int32 bestDistance = INT32_MAX;
+			for (uint32 p = 0; p < 8; ++p)
+			{
+				const int32 distance = std::abs(value - palette[p]);
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					bestIndex = p;
+				}
+			}
+			indices |= bestIndex << (3 * i);
+		}
+
+		pBlock[0] = maxValue;
+		pBlock[1] = minValue;
+		for (uint32 i = 0; i < 6; ++i)
+			pBlock[2 + i] = (uint8)(indices >> (8 * i));
+	}
+
+	void DecompressChannelBlock(const uint8* pBlock, uint32 channel, uint8* pRGBA)
+	{
+		int32 palette[8];
+		BC4Palette(pBlock[0], pBlock[1], palette);
+
+		uint64 indices = 0;
+		for (uint32 i = 0; i < 6; ++i)
+			indices |= (uint64)pBlock[2 + i] << (8 * i);
+
+		for (uint32 i = 0; i < PixelCount; ++i)
+			pRGBA[i * 4 + channel] = (uint8)palette[(indices >> (3 * i)) & 7];
+	}
+
+	// ---- BC7 mode 6 ----
+
+	class BitWriter
+	{
+	public:
+		BitWriter(uint8* pBlock) : m_pBlock(pBlock) { std::memset(pBlock, 0, 16); }
+
+		void Write(uint32 value, uint32 bitCount)
+		{
+			for (uint32 i = 0; i < bitCount; ++i, ++m_Position)
+				m_pBlock[m_Position / 8] |= (uint8)(((value >> i) & 1) << (m_Position % 8));
+		}
+
+	private:
+		uint8* m_pBlock;
+		uint32 m_Position = 0;
+	};
+
+	class BitReader
+	{
+	public:
+		BitReader(const uint8* pBlock) : m_pBlock(pBlock) {}
+
+		uint32 Read(uint32 bitCount)
+		{
+			uint32 value = 0;
+			for (uint32 i = 0; i < bitCount; ++i, ++m_Position)
+				value |= (uint32)((m_pBlock[m_Position / 8] >> (m_Position % 8)) & 1) << i;
+			return value;
+		}
+
+	private:
+		const uint8* m_pBlock;
+		uint32 m_Position = 0;
+	};
+
+	// 7 bit endpoint with a shared p-bit per endpoint.
+	uint32 QuantizeBC7(float value, uint32 pBit)
+	{
+		return (uint32)std::clamp((int32)std::lround((value - pBit) * 0.5f), 0, 127);
+	}
+
+	int32 InterpolateBC7(int32 endpoint0, int32 endpoint1, uint32 index)
+	{
+		return ((64 - (int32)BC7Weights[index]) * endpoint0 + (int32)BC7Weights[index] * endpoint1 + 32) >> 6;
+	}
+
+	void CompressBC7Block(const uint8* pRGBA, uint8* pBlock)
+	{
+		float points[PixelCount][4];
+		for (uint32 i = 0; i < PixelCount; ++i)
+		{
+			for (uint32 c = 0; c < 4; ++c)
+				points[i][c] = pRGBA[i * 4 + c];
+		}
+
+		float mean[4];
+		float axis[4];
+		FindPrincipalAxis(points, mean, axis);
+
+		float minProjection = FLT_MAX;
+		float maxProjection = -FLT_MAX;
+		for (uint32 i = 0; i < PixelCount; ++i)
+		{
+			float offset[4];
+			for (uint32 c = 0; c < 4; ++c)
+				offset[c] = points[i][c] - mean[c];
+			const float projection = Dot(offset, axis) / std::max(Dot(axis, axis), 1e-6f);
+			minProjection = std::min(minProjection, projection);
+			maxProjection = std::max(maxProjection, projection);
+		}
+
+		float endpoints[2][4];
+		for (uint32 c = 0; c < 4; ++c)
+		{
+			endpoints[0][c] = std::clamp(mean[c] + minProjection * axis[c], 0.f, 255.f);
+			endpoints[1][c] = std::clamp(mean[c] + maxProjection * axis[c], 0.f, 255.f);
+		}
+
+		uint32 bestQuantized[2][4] = {};
+		uint32 bestPBits[2] = {};
+		uint32 bestIndices[PixelCount] = {};
+		int64 bestError = INT64_MAX;
+		for (uint32 iteration = 0; iteration <= RefineIterations; ++iteration)
+		{
+			bool improved = false;
+			for (uint32 pBitCombination = 0; pBitCombination < 4; ++pBitCombination)
+			{
+				const uint32 pBits[2] = { pBitCombination & 1, pBitCombination >> 1 };
+				uint32 quantized[2][4];
+				int32 unquantized[2][4];
+				for (uint32 e = 0; e < 2; ++e)
+				{
+					for (uint32 c = 0; c < 4; ++c)
+					{
+						quantized[e][c] = QuantizeBC7(endpoints[e][c], pBits[e]);
+						unquantized[e][c] = (int32)((quantized[e][c] << 1) | pBits[e]);
+					}
+				}
+
+				int32 palette[16][4];
+				for (uint32 p = 0; p < 16; ++p)
+				{
+					for (uint32 c = 0; c < 4; ++c)
+						palette[p][c] = InterpolateBC7(unquantized[0][c], unquantized[1][c], p);
+				}
+
+				int64 error = 0;
+				uint32 indices[PixelCount];
+				for (uint32 i = 0; i < PixelCount && error < bestError; ++i)
+				{
+					int32 bestDistance = INT32_MAX;
+					for (uint32 p = 0; p < 16; ++p)
+					{
+						int32 distance = 0;
+						for (uint32 c = 0; c < 4; ++c)
+						{
+							const int32 d = (int32)pRGBA[i * 4 + c] - palette[p][c];
+							distance += d * d;
+						}
+						if (distance < bestDistance)
+						{
+							bestDistance = distance;
+							indices[i] = p;
+						}
+					}
+					error += bestDistance;
+				}
+
+				if (error < bestError)
+				{
+					bestError = error;
+					std::memcpy(bestQuantized, quantized, sizeof(quantized));
+					std::memcpy(bestPBits, pBits, sizeof(pBits));
+					std::memcpy(bestIndices, indices, sizeof(indices));
+					improved = true;
+				}
+			}
+
+			if (iteration == RefineIterations || !improved || bestError == 0)
+				break;
+
+			// Least squares fit of the endpoints to the best indices.
+			float aa = 0.f, ab = 0.f, bb = 0.f;
+			float ax[4] = {}, bx[4] = {};
+			for (uint32 i = 0; i < PixelCount; ++i)
+			{
+				const float b = BC7Weights[bestIndices[i]] / 64.f;
+				const float a = 1.f - b;
+				aa += a * a;
+				ab += a * b;
+				bb += b * b;
+				for (uint32 c = 0; c < 4; ++c)
+				{
+					ax[c] += a * points[i][c];
+					bx[c] += b * points[i][c];
+				}
+			}
+
+			const float determinant = aa * bb - ab * ab;
+			if (std::abs(determinant) < 1e-6f)
+				break;
+			for (uint32 c = 0; c < 4; ++c)
+			{
+				endpoints[0][c] = std::clamp((ax[c] * bb - bx[c] * ab) / determinant, 0.f, 255.f);
+				endpoints[1][c] = std::clamp((bx[c] * aa - ax[c] * ab) / determinant, 0.f, 255.f);
+			}
+		}
+
+		// The most significant bit of the first index is implicit zero, swap the endpoints if it is set.
+		if (bestIndices[0] & 8)
+		{
+			for (uint32 c = 0; c < 4; ++c)
+				std::swap(bestQuantized[0][c], bestQuantized[1][c]);
+			std::swap(bestPBits[0], bestPBits[1]);
+			for (uint32 i = 0; i < PixelCount; ++i)
+				bestIndices[i] = 15 - bestIndices[i];
+		}
+
+		BitWriter writer(pBlock);
+		writer.Write(1 << 6, 7); // Mode 6.
+		for (uint32 c = 0; c < 4; ++c)
+		{
+			writer.Write(bestQuantized[0][c], 7);
+			writer.Write(bestQuantized[1][c], 7);
+		}
+		writer.Write(bestPBits[0], 1);
+		writer.Write(bestPBits[1], 1);
+		writer.Write(bestIndices[0], 3);
+		for (uint32 i = 1; i < PixelCount; ++i)
+			writer.Write(bestIndices[i], 4);
+	}
+
+	void DecompressBC7Block(const uint8* pBlock, uint8* pRGBA)
+	{
+		// The mode is the position of the lowest set bit, the bit above it already belongs to the endpoints.
+		if ((pBlock[0] & 0x7F) != (1 << 6))
+		{
+			LOG_WARNING("BC7 block uses a mode that is not supported! Only mode 6 can be decoded.");
+			std::memset(pRGBA, 0, PixelCount * 4);
+			return;
+		}
+
+		BitReader reader(pBlock);
+		reader.Read(7);
+
+		uint32 quantized[2][4];
+		for (uint32 c = 0; c < 4; ++c)
+		{
+			quantized[0][c] = reader.Read(7);
+			quantized[1][c] = reader.Read(7);
+		}
+		const uint32 pBits[2] = { reader.Read(1), reader.Read(1) };
+
+		int32 endpoints[2][4];
+		for (uint32 e = 0; e < 2; ++e)
+		{
+			for (uint32 c = 0; c < 4; ++c)
+				endpoints[e][c] = (int32)((quantized[e][c] << 1) | pBits[e]);
+		}
+
+		for (uint32 i = 0; i < PixelCount; ++i)
+		{
+			const uint32 index = reader.Read(i == 0 ? 3 : 4);
+			for (uint32 c = 0; c < 4; ++c)
+				pRGBA[i * 4 + c] = (uint8)InterpolateBC7(endpoints[0][c], endpoints[1][c], index);
+		}
+	}
+}
+
+uint32 RS::BCCompressor::GetBlockSize(BCFormat format)
+{
+	return format == BCFormat::BC1 ? 8 : 16;
+}
+
+uint64 RS::BCCompressor::GetCompressedSize(BCFormat format, uint32 width, uint32 height)
+{
+	const uint64 blocksX = std::max(1u, (width + 3) / 4);
+	const uint64 blocksY = std::max(1u, (height + 3) / 4);
+	return blocksX * blocksY * GetBlockSize(format);
+}
+
+void RS::BCCompressor::CompressBlock(BCFormat format, const uint8* pRGBA, uint8* pBlock)
+{
+	using namespace _BCInternal;
+	switch (format)
+	{
+	case BCFormat::BC1:
+		CompressColorBlock(pRGBA, pBlock);
+		break;
+	case BCFormat::BC3:
+		CompressChannelBlock(pRGBA, 3, pBlock);
+		CompressColorBlock(pRGBA, pBlock + 8);
+		break;
+	case BCFormat::BC5:
+		CompressChannelBlock(pRGBA, 0, pBlock);
+		CompressChannelBlock(pRGBA, 1, pBlock + 8);
+		break;
+	case BCFormat::BC7:
+		CompressBC7Block(pRGBA, pBlock);
+		break;
+	default:
+		RS_ASSERT(false, "Unknown BC format {}!", (uint32)format);
+		break;
+	}
+}
+
+void RS::BCCompressor::DecompressBlock(BCFormat format, const uint8* pBlock, uint8* pRGBA)
+{
+	using namespace _BCInternal;
+	switch (format)
+	{
+	case BCFormat::BC1:
+		DecompressColorBlock(pBlock, false, pRGBA);
+		break;
+	case BCFormat::BC3:
+		DecompressColorBlock(pBlock + 8, true, pRGBA);
+		DecompressChannelBlock(pBlock, 3, pRGBA);
+		break;
+	case BCFormat::BC5:
+		for (uint32 i = 0; i < PixelCount; ++i)
+		{
+			pRGBA[i * 4 + 2] = 0;
+			pRGBA[i * 4 + 3] = 255;
+		}
+		DecompressChannelBlock(pBlock, 0, pRGBA);
+		DecompressChannelBlock(pBlock + 8, 1, pRGBA);
+		break;
+	case BCFormat::BC7:
+		DecompressBC7Block(pBlock, pRGBA);
+		break;
+	default:
+		RS_ASSERT(false, "Unknown BC format {}!", (uint32)format);
+		break;
+	}
+}
+
+std::vector<uint8> RS::BCCompressor::Compress(BCFormat format, const TextureImage& image, uint maxThreads)
+{
+	RS_ASSERT(image.pixels.size() == (uint64)image.width * image.height * 4, "Texture image has the wrong size! Expected RGBA8.");
+
+	const uint32 blocksX = std::max(1u, (image.width + 3) / 4);
+	const uint32 blocksY = std::max(1u, (image.height + 3) / 4);
+	const uint32 blockSize = GetBlockSize(format);
+
+	std::vector<uint8> result(GetCompressedSize(format, image.width, image.height));
+	ThreadPool::Get()->ParallelFor(blocksY, [&](uint64 blockY)
+		{
+			uint8 block[64];
+			for (uint32 blockX = 0; blockX < blocksX; ++blockX)
+			{
+				for (uint32 y = 0; y < 4; ++y)
+				{
+					const uint32 srcY = std::min((uint32)blockY * 4 + y, image.height - 1);
+					for (uint32 x = 0; x < 4; ++x)
+					{
+						const uint32 srcX = std::min(blockX * 4 + x, image.width - 1);
+						std::memcpy(block + (y * 4 + x) * 4, image.pixels.data() + ((uint64)srcY * image.width + srcX) * 4, 4);
+					}
+				}
+				CompressBlock(format, block, result.data() + ((uint64)blockY * blocksX + blockX) * blockSize);
+			}
+		}, maxThreads);
+	return result;
+}
+
+RS::TextureImage RS::BCCompressor::Decompress(BCFormat format, const uint8* pData, uint32 width, uint32 height)
+{
+	const uint32 blocksX = std::max(1u, (width + 3) / 4);
+	const uint32 blocksY = std::max(1u, (height + 3) / 4);
+	const uint32 blockSize = GetBlockSize(format);
+
+	TextureImage image;
+	image.width = width;
+	image.height = height;
+	image.pixels.resize((uint64)width * height * 4);
+
+	uint8 block[64];
+	for (uint32 blockY = 0; blockY < blocksY; ++blockY)
+	{
+		for (uint32 blockX = 0; blockX < blocksX; ++blockX)
+		{
+			DecompressBlock(format, pData + ((uint64)blockY * blocksX + blockX) * blockSize, block);
+			for (uint32 y = 0; y < 4 && blockY * 4 + y < height; ++y)
+			{
+				for (uint32 x = 0; x < 4 && blockX * 4 + x < width; ++x)
+					std::memcpy(image.pixels.data() + ((uint64)(blockY * 4 + y) * width + blockX * 4 + x) * 4, block + (y * 4 + x) * 4, 4);
+			}
+		}
+	}
+	return image;
+}
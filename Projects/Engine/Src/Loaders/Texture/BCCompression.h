@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Loaders/Texture/TextureMips.h"
+
+namespace RS
+{
+	enum class BCFormat : uint32
+	{
+		BC1 = 1,	// RGB, 4 bits per pixel. Alpha is ignored.
+		BC3 = 3,	// RGBA, 8 bits per pixel.
+		BC5 = 5,	// RG, 8 bits per pixel. For normal maps, the decoded B is 0 and A is 255.
+		BC7 = 7		// RGBA, 8 bits per pixel.
+	};
+
+	/*
+	* Block compression of RGBA8 images. A block is 4x4 pixels in row order, 64 bytes of RGBA8.
+	* BC7 only uses mode 6 (one subset, RGBA endpoints with 4 bit indices), which covers most textures well and
+	* is a lot cheaper to search than all eight modes. The decoder only supports the modes the encoder writes.
+	*/
+	class BCCompressor
+	{
+	public:
+		RS_STATIC_CLASS(BCCompressor)
+
+		static uint32 GetBlockSize(BCFormat format);
+		static uint64 GetCompressedSize(BCFormat format, uint32 width, uint32 height);
+
+		static void CompressBlock(BCFormat format, const uint8* pRGBA, uint8* pBlock);
+		static void DecompressBlock(BCFormat format, const uint8* pBlock, uint8* pRGBA);
+
+		/*
+		* Rows of blocks are compressed in parallel on the thread pool, maxThreads = 0 uses all of them.
+		* Edge blocks of images that are not a multiple of four repeat the last row and column.
+		*/
+		static std::vector<uint8> Compress(BCFormat format, const TextureImage& image, uint maxThreads = 0);
+		static TextureImage Decompress(BCFormat format, const uint8* pData, uint32 width, uint32 height);
+	};
+}
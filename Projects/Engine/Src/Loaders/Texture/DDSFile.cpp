@@ -0,0 +1,262 @@
+#include "PreCompiled.h"
+#include "DDSFile.h"
+
+#include "Core/VFS.h"
+
+namespace RS::_DDSInternal
+{
+	constexpr uint32 Magic = 0x20534444; // "DDS "
+	constexpr uint32 CookMagic = 0x43545352; // "RSTC"
+	constexpr uint32 CookVersion = 1;
+
+	// The DXGI_FORMAT values, this file does not depend on the DX headers.
+	constexpr uint32 DXGIFormatRGBA8 = 28;
+	constexpr uint32 DXGIFormatRGBA8SRGB = 29;
+	constexpr uint32 DXGIFormatBC1 = 71;
+	constexpr uint32 DXGIFormatBC1SRGB = 72;
+	constexpr uint32 DXGIFormatBC3 = 77;
+	constexpr uint32 DXGIFormatBC3SRGB = 78;
+	constexpr uint32 DXGIFormatBC5 = 83;
+	constexpr uint32 DXGIFormatBC7 = 98;
+	constexpr uint32 DXGIFormatBC7SRGB = 99;
+
+	constexpr uint32 FlagCaps = 0x1;
+	constexpr uint32 FlagHeight = 0x2;
+	constexpr uint32 FlagWidth = 0x4;
+	constexpr uint32 FlagPixelFormat = 0x1000;
+	constexpr uint32 FlagMipMapCount = 0x20000;
+	constexpr uint32 FlagLinearSize = 0x80000;
+	constexpr uint32 PixelFormatFourCC = 0x4;
+	constexpr uint32 FourCCDX10 = 0x30315844; // "DX10"
+	constexpr uint32 CapsComplex = 0x8;
+	constexpr uint32 CapsTexture = 0x1000;
+	constexpr uint32 CapsMipMap = 0x400000;
+	constexpr uint32 ResourceDimensionTexture2D = 3;
+
+	struct PixelFormat
+	{
+		uint32 size = sizeof(PixelFormat);
+		uint32 flags = 0;
+		uint32 fourCC = 0;
+		uint32 rgbBitCount = 0;
+		uint32 rBitMask = 0;
+		uint32 gBitMask = 0;
+		uint32 bBitMask = 0;
+		uint32 aBitMask = 0;
+	};
+
+	struct Header
+	{
+		uint32 size = sizeof(Header);
+		uint32 flags = 0;
+		uint32 height = 0;
+		uint32 width = 0;
+		uint32 pitchOrLinearSize = 0;
+		uint32 depth = 0;
+		uint32 mipMapCount = 0;
+		uint32 reserved1[11] = {};	// [0] CookMagic, [1] CookVersion, [2..3] cook hash.
+		PixelFormat pixelFormat;
+		uint32 caps = 0;
+		uint32 caps2 = 0;
+		uint32 caps3 = 0;
+		uint32 caps4 = 0;
+		uint32 reserved2 = 0;
+	};
+	static_assert(sizeof(Header) == 124);
+
+	struct HeaderDX10
+	{
+		uint32 dxgiFormat = 0;
+		uint32 resourceDimension = 0;
+		uint32 miscFlag = 0;
+		uint32 arraySize = 0;
+		uint32 miscFlags2 = 0;
+	};
+	static_assert(sizeof(HeaderDX10) == 20);
+
+	constexpr uint64 DataOffset = sizeof(uint32) + sizeof(Header) + sizeof(HeaderDX10);
+
+	uint64 GetCookHash(const Header& header)
+	{
+		if (header.reserved1[0] != CookMagic || header.reserved1[1] != CookVersion)
+			return 0;
+		return (uint64)header.reserved1[2] | ((uint64)header.reserved1[3] << 32);
+	}
+}
+
+uint32 RS::DDSFile::GetDXGIFormat(CookedFormat format, bool isSRGB)
+{
+	using namespace _DDSInternal;
+	switch (format)
+	{
+	case CookedFormat::RGBA8:	return isSRGB ? DXGIFormatRGBA8SRGB : DXGIFormatRGBA8;
+	case CookedFormat::BC1:		return isSRGB ? DXGIFormatBC1SRGB : DXGIFormatBC1;
+	case CookedFormat::BC3:		return isSRGB ? DXGIFormatBC3SRGB : DXGIFormatBC3;
+	case CookedFormat::BC5:		return DXGIFormatBC5; // Two channel data is never color.
+	case CookedFormat::BC7:		return isSRGB ? DXGIFormatBC7SRGB : DXGIFormatBC7;
+	default:
+		RS_ASSERT(false, "Unknown cooked format {}!", (uint32)format);
+		return 0;
+	}
+}
+
+bool RS::DDSFile::IsBlockCompressed(uint32 dxgiFormat)
+{
+	using namespace _DDSInternal;
+	return dxgiFormat != DXGIFormatRGBA8 && dxgiFormat != DXGIFormatRGBA8SRGB && GetElementSize(dxgiFormat) > 0;
+}
+
+uint32 RS::DDSFile::GetElementSize(uint32 dxgiFormat)
+{
+	using namespace _DDSInternal;
+	switch (dxgiFormat)
+	{
+	case DXGIFormatRGBA8:
+	case DXGIFormatRGBA8SRGB:
+		return 4;
+	case DXGIFormatBC1:
+	case DXGIFormatBC1SRGB:
+		return 8;
+	case DXGIFormatBC3:
+	case DXGIFormatBC3SRGB:
+	case DXGIFormatBC5:
+	case DXGIFormatBC7:
+	case DXGIFormatBC7SRGB:
+		return 16;
+	default:
+		return 0;
+	}
+}
+
+RS::DDSTexture::Mip RS::DDSFile::GetMipLayout(uint32 width, uint32 height, uint32 dxgiFormat, uint32 mip)
+{
+	DDSTexture::Mip layout;
+	layout.width = std::max(1u, width >> mip);
+	layout.height = std::max(1u, height >> mip);
+
+	const uint32 elementSize = GetElementSize(dxgiFormat);
+	if (IsBlockCompressed(dxgiFormat))
+	{
+		layout.rowPitch = (uint64)std::max(1u, (layout.width + 3) / 4) * elementSize;
+		layout.rowCount = std::max(1u, (layout.height + 3) / 4);
+	}
+	else
+	{
+		layout.rowPitch = (uint64)layout.width * elementSize;
+		layout.rowCount = layout.height;
+	}
+	return layout;
+}
+
+std::vector<uint8> RS::DDSFile::Write(uint32 width, uint32 height, uint32 dxgiFormat, const std::vector<std::vector<uint8>>& mips, uint64 cookHash)
+{
+	using namespace _DDSInternal;
+	RS_ASSERT(GetElementSize(dxgiFormat) > 0, "DDS format {} is not supported!", dxgiFormat);
+	RS_ASSERT(!mips.empty(), "A DDS file needs at least one mip!");
+
+	Header header;
+	header.flags = FlagCaps | FlagHeight | FlagWidth | FlagPixelFormat | FlagMipMapCount | FlagLinearSize;
+	header.height = height;
+	header.width = width;
+	header.pitchOrLinearSize = (uint32)mips[0].size();
+	header.depth = 1;
+	header.mipMapCount = (uint32)mips.size();
+	header.reserved1[0] = CookMagic;
+	header.reserved1[1] = CookVersion;
+	header.reserved1[2] = (uint32)cookHash;
+	header.reserved1[3] = (uint32)(cookHash >> 32);
+	header.pixelFormat.flags = PixelFormatFourCC;
+	header.pixelFormat.fourCC = FourCCDX10;
+	header.caps = CapsTexture | (mips.size() > 1 ? CapsComplex | CapsMipMap : 0);
+
+	HeaderDX10 headerDX10;
+	headerDX10.dxgiFormat = dxgiFormat;
+	headerDX10.resourceDimension = ResourceDimensionTexture2D;
+	headerDX10.arraySize = 1;
+
+	uint64 totalSize = DataOffset;
+	for (const std::vector<uint8>& mip : mips)
+		totalSize += mip.size();
+
+	std::vector<uint8> result(totalSize);
+	uint8* pDst = result.data();
+	std::memcpy(pDst, &Magic, sizeof(Magic));
+	std::memcpy(pDst + sizeof(Magic), &header, sizeof(header));
+	std::memcpy(pDst + sizeof(Magic) + sizeof(header), &headerDX10, sizeof(headerDX10));
+	pDst += DataOffset;
+
+	for (uint32 mip = 0; mip < (uint32)mips.size(); ++mip)
+	{
+		const DDSTexture::Mip layout = GetMipLayout(width, height, dxgiFormat, mip);
+		RS_ASSERT(mips[mip].size() == layout.rowPitch * layout.rowCount, "Mip {} has the wrong size!", mip);
+		std::memcpy(pDst, mips[mip].data(), mips[mip].size());
+		pDst += mips[mip].size();
+	}
+	return result;
+}
+
+bool RS::DDSFile::Parse(std::span<const uint8> data, DDSTexture& texture)
+{
+	using namespace _DDSInternal;
+	if (data.size() < DataOffset)
+		return false;
+
+	uint32 magic;
+	Header header;
+	HeaderDX10 headerDX10;
+	std::memcpy(&magic, data.data(), sizeof(magic));
+	std::memcpy(&header, data.data() + sizeof(magic), sizeof(header));
+	std::memcpy(&headerDX10, data.data() + sizeof(magic) + sizeof(header), sizeof(headerDX10));
+
+	if (magic != Magic || header.size != sizeof(Header) || !(header.pixelFormat.flags & PixelFormatFourCC) || header.pixelFormat.fourCC != FourCCDX10)
+	{
+		LOG_WARNING("Only DDS files with a DX10 header are supported!");
+		return false;
+	}
+
+	if (headerDX10.resourceDimension != ResourceDimensionTexture2D || headerDX10.arraySize != 1 || GetElementSize(headerDX10.dxgiFormat) == 0
+		|| header.width == 0 || header.height == 0)
+	{
+		LOG_WARNING("DDS file is not a supported 2D texture! Format: {}, Dimension: {}", headerDX10.dxgiFormat, headerDX10.resourceDimension);
+		return false;
+	}
+
+	texture.width = header.width;
+	texture.height = header.height;
+	texture.dxgiFormat = headerDX10.dxgiFormat;
+	texture.cookHash = GetCookHash(header);
+	texture.mips.clear();
+
+	const uint32 mipCount = (header.flags & FlagMipMapCount) ? std::max(1u, header.mipMapCount) : 1;
+	uint64 offset = DataOffset;
+	for (uint32 mip = 0; mip < mipCount; ++mip)
+	{
+		DDSTexture::Mip layout = GetMipLayout(header.width, header.height, headerDX10.dxgiFormat, mip);
+		const uint64 size = layout.rowPitch * layout.rowCount;
+		if (size > data.size() - offset)
+		{
+			LOG_WARNING("DDS file is too small for its {} mips!", mipCount);
+			texture.mips.clear();
+			return false;
+		}
+
+		layout.data = data.subspan(offset, size);
+		texture.mips.push_back(layout);
+		offset += size;
+	}
+	return true;
+}
+
+uint64 RS::DDSFile::ReadCookHash(const std::string& path)
+{
+	using namespace _DDSInternal;
+	std::shared_ptr<VFSFile> pFile = VFS::Get()->Open(path);
+	if (!pFile || pFile->GetSize() < DataOffset)
+		return 0;
+
+	uint32 magic;
+	Header header;
+	std::memcpy(&magic, pFile->GetPtr(), sizeof(magic));
+	std::memcpy(&header, pFile->GetPtr() + sizeof(magic), sizeof(header));
+	return magic == Magic ? GetCookHash(header) : 0;
+}
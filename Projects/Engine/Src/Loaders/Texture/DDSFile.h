@@ -0,0 +1,66 @@
+#pragma once
+
+#include <span>
+
+namespace RS
+{
+	/*
+	* Formats the texture cooker writes. The DDS file stores the matching DXGI_FORMAT.
+	*/
+	enum class CookedFormat : uint32
+	{
+		RGBA8 = 0,
+		BC1,
+		BC3,
+		BC5,
+		BC7
+	};
+
+	struct DDSTexture
+	{
+		uint32 width = 0;
+		uint32 height = 0;
+		uint32 dxgiFormat = 0;
+		uint64 cookHash = 0;	// 0 if the file was not written by the cooker.
+
+		struct Mip
+		{
+			uint32 width = 0;
+			uint32 height = 0;
+			uint64 rowPitch = 0;	// Bytes per row of pixels or of 4x4 blocks.
+			uint32 rowCount = 0;
+			std::span<const uint8> data;
+		};
+		std::vector<Mip> mips;	// Views into the memory that was parsed.
+	};
+
+	/*
+	* DDS with the DX10 header, 2D textures with a full or partial mip chain.
+	* The cooker stores a hash of the source and the settings in the reserved part of the header, to know when a texture has to be cooked again.
+	*/
+	class DDSFile
+	{
+	public:
+		RS_STATIC_CLASS(DDSFile)
+
+		static uint32 GetDXGIFormat(CookedFormat format, bool isSRGB);
+		static bool IsBlockCompressed(uint32 dxgiFormat);
+		// Bytes per 4x4 block for BC formats, bytes per pixel otherwise. 0 for formats that are not supported.
+		static uint32 GetElementSize(uint32 dxgiFormat);
+
+		/*
+		* Each mip has to be tightly packed, in the layout GetMipLayout gives.
+		*/
+		static std::vector<uint8> Write(uint32 width, uint32 height, uint32 dxgiFormat, const std::vector<std::vector<uint8>>& mips, uint64 cookHash);
+
+		/*
+		* Does not copy, the mips in the result point into data. Returns false for files that are not supported.
+		*/
+		static bool Parse(std::span<const uint8> data, DDSTexture& texture);
+
+		// Only reads the header. Returns 0 if the file is missing or was not written by the cooker.
+		static uint64 ReadCookHash(const std::string& path);
+
+		static DDSTexture::Mip GetMipLayout(uint32 width, uint32 height, uint32 dxgiFormat, uint32 mip);
+	};
+}
@@ -0,0 +1,193 @@
+#include "PreCompiled.h"
+#include "TextureCooker.h"
+
+#include "Core/CorePlatform.h"
+#include "Core/VFS.h"
+#include "Loaders/Texture/BCCompression.h"
+#include "Utils/Misc/xxhash.h"
+
+#include <filesystem>
+#include <fstream>
+#include <chrono>
+
+namespace RS::_TextureCookerInternal
+{
+	// Bump this when the output of the cooker changes, it makes every texture cook again.
+	constexpr uint32 CookerVersion = 2;
+
+	struct CookHashData
+	{
+		uint64 sourceHash;
+		uint32 cookerVersion;
+		uint32 format;
+		uint32 isSRGB;
+		uint32 generateMips;
+		uint32 mipFilter;
+		uint32 padding;
+	};
+
+	BCFormat ToBCFormat(CookedFormat format)
+	{
+		switch (format)
+		{
+		case CookedFormat::BC1: return BCFormat::BC1;
+		case CookedFormat::BC3: return BCFormat::BC3;
+		case CookedFormat::BC5: return BCFormat::BC5;
+		case CookedFormat::BC7: return BCFormat::BC7;
+		default:
+			RS_ASSERT(false, "Cooked format {} is not block compressed!", (uint32)format);
+			return BCFormat::BC1;
+		}
+	}
+
+	bool IsImageFile(const std::filesystem::path& path)
+	{
+		std::string extension = path.extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return (char)std::tolower(c); });
+		return extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga" || extension == ".bmp" || extension == ".ppm";
+	}
+}
+
+uint64 RS::TextureCooker::ComputeCookHash(std::span<const uint8> sourceData, const TextureCookSettings& settings)
+{
+	using namespace _TextureCookerInternal;
+	CookHashData data = {};
+	data.sourceHash = xxh::xxhash3<64>(sourceData.data(), sourceData.size());
+	data.cookerVersion = CookerVersion;
+	data.format = (uint32)settings.format;
+	data.isSRGB = settings.isSRGB ? 1 : 0;
+	data.generateMips = settings.generateMips ? 1 : 0;
+	data.mipFilter = (uint32)settings.mipFilter;
+
+	// 0 means not cooked in the DDS header.
+	const uint64 hash = xxh::xxhash3<64>(&data, sizeof(data));
+	return hash == 0 ? 1 : hash;
+}
+
+std::vector<uint8> RS::TextureCooker::CookImage(const TextureImage& image, const TextureCookSettings& settings, uint64 cookHash)
+{
+	using namespace _TextureCookerInternal;
+
+	// D3D12 only creates block compressed textures whose top mip is a whole number of blocks. Padding the image would move the texture
+	// coordinates, so those are kept uncompressed.
+	CookedFormat format = settings.format;
+	if (format != CookedFormat::RGBA8 && (image.width % 4 != 0 || image.height % 4 != 0))
+	{
+		LOG_WARNING("Cooking a {}x{} texture uncompressed, block compression needs a multiple of 4.", image.width, image.height);
+		format = CookedFormat::RGBA8;
+	}
+
+	std::vector<TextureImage> mips;
+	if (settings.generateMips)
+		mips = TextureMipGenerator::Generate(image, settings.isSRGB, settings.mipFilter, settings.maxThreads);
+	else
+		mips.push_back(image);
+
+	std::vector<std::vector<uint8>> mipData(mips.size());
+	for (uint64 mip = 0; mip < mips.size(); ++mip)
+	{
+		if (format == CookedFormat::RGBA8)
+			mipData[mip] = std::move(mips[mip].pixels);
+		else
+			mipData[mip] = BCCompressor::Compress(ToBCFormat(format), mips[mip], settings.maxThreads);
+	}
+
+	return DDSFile::Write(image.width, image.height, DDSFile::GetDXGIFormat(format, settings.isSRGB), mipData, cookHash);
+}
+
+RS::TextureCooker::Result RS::TextureCooker::Cook(const std::string& sourcePath, const std::string& cookedPath, const TextureCookSettings& settings, bool force)
+{
+	std::shared_ptr<VFSFile> pSourceFile = VFS::Get()->Open(sourcePath);
+	if (!pSourceFile)
+	{
+		LOG_ERROR("Cannot cook texture, failed to open {}!", sourcePath.c_str());
+		return Result::Failed;
+	}
+
+	const uint64 cookHash = ComputeCookHash(pSourceFile->GetData(), settings);
+	if (!force && DDSFile::ReadCookHash(cookedPath) == cookHash)
+		return Result::UpToDate;
+
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	std::unique_ptr<CorePlatform::Image> pImage = CorePlatform::LoadImageDataFromMemory(pSourceFile->GetData(), RS_FORMAT_R8G8B8A8_UNORM);
+	if (!pImage)
+	{
+		LOG_ERROR("Cannot cook texture, failed to decode {}!", sourcePath.c_str());
+		return Result::Failed;
+	}
+
+	TextureImage image;
+	image.width = pImage->width;
+	image.height = pImage->height;
+	image.pixels.assign(pImage->pData, pImage->pData + (uint64)image.width * image.height * 4);
+	pImage.reset();
+
+	const std::vector<uint8> ddsData = CookImage(image, settings, cookHash);
+
+	std::error_code error;
+	std::filesystem::create_directories(std::filesystem::path(cookedPath).parent_path(), error);
+	std::ofstream stream(cookedPath, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!stream.is_open())
+	{
+		LOG_ERROR("Cannot cook texture, failed to open {} for writing!", cookedPath.c_str());
+		return Result::Failed;
+	}
+	stream.write((const char*)ddsData.data(), ddsData.size());
+	if (!stream.good())
+	{
+		LOG_ERROR("Failed to write cooked texture {}!", cookedPath.c_str());
+		return Result::Failed;
+	}
+
+	auto duration = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime);
+	LOG_INFO("Cooked {} ({}x{}) in {:.1f} ms, {} KiB", sourcePath.c_str(), image.width, image.height, duration.count(), ddsData.size() / 1024);
+	return Result::Cooked;
+}
+
+uint32 RS::TextureCooker::CookDirectory(const std::string& sourceDirectory, const std::string& cookedDirectory, const TextureCookSettings& settings, bool force)
+{
+	using namespace _TextureCookerInternal;
+
+	std::error_code error;
+	if (!std::filesystem::is_directory(sourceDirectory, error))
+	{
+		LOG_WARNING("Cannot cook textures in {}, it is not a directory!", sourceDirectory.c_str());
+		return 0;
+	}
+
+	uint32 cookedCount = 0;
+	uint32 upToDateCount = 0;
+	uint32 failedCount = 0;
+	for (const std::filesystem::directory_entry& entry : std::filesystem::recursive_directory_iterator(sourceDirectory))
+	{
+		if (!entry.is_regular_file() || !IsImageFile(entry.path()))
+			continue;
+
+		const std::string relativePath = std::filesystem::relative(entry.path(), sourceDirectory).generic_string();
+
+		TextureCookSettings textureSettings = settings;
+		std::string lowerName = entry.path().filename().string();
+		std::transform(lowerName.begin(), lowerName.end(), lowerName.begin(), [](char c) { return (char)std::tolower(c); });
+		if (lowerName.find("normal") != std::string::npos)
+		{
+			textureSettings.format = CookedFormat::BC5;
+			textureSettings.isSRGB = false;
+		}
+
+		switch (Cook(entry.path().generic_string(), GetCookedPath(cookedDirectory + "/" + relativePath), textureSettings, force))
+		{
+		case Result::Cooked:	cookedCount++; break;
+		case Result::UpToDate:	upToDateCount++; break;
+		default:				failedCount++; break;
+		}
+	}
+
+	LOG_INFO("Texture cooking done, {} cooked, {} up to date, {} failed", cookedCount, upToDateCount, failedCount);
+	return failedCount;
+}
+
+std::string RS::TextureCooker::GetCookedPath(const std::string& path)
+{
+	return std::filesystem::path(path).replace_extension(".dds").generic_string();
+}
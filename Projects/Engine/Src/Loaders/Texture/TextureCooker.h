@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Loaders/Texture/TextureMips.h"
+#include "Loaders/Texture/DDSFile.h"
+
+#include <span>
+
+namespace RS
+{
+	struct TextureCookSettings
+	{
+		CookedFormat format = CookedFormat::BC7;
+		bool isSRGB = true;
+		bool generateMips = true;
+		MipFilter mipFilter = MipFilter::Kaiser;
+		uint maxThreads = 0;	// Does not change the result, so it is not part of the cook hash.
+	};
+
+	/*
+	* Offline texture cooking: decodes a source image, generates the mip chain, block compresses every mip and writes a DDS file.
+	* The cooked file stores a hash of the source data and the settings, a texture is only cooked again when one of them changes.
+	* Everything runs on the CPU, so it works without a device.
+	*/
+	class TextureCooker
+	{
+	public:
+		RS_STATIC_CLASS(TextureCooker)
+
+		enum class Result
+		{
+			Cooked,
+			UpToDate,
+			Failed
+		};
+
+		static uint64 ComputeCookHash(std::span<const uint8> sourceData, const TextureCookSettings& settings);
+
+		/*
+		* Returns a complete DDS file. Images that are not a multiple of 4 in both directions are written as RGBA8 even if a BC format is asked for.
+		*/
+		static std::vector<uint8> CookImage(const TextureImage& image, const TextureCookSettings& settings, uint64 cookHash = 0);
+
+		static Result Cook(const std::string& sourcePath, const std::string& cookedPath, const TextureCookSettings& settings, bool force = false);
+
+		/*
+		* Cooks every image in the directory into cookedDirectory, with the same relative path and a .dds extension.
+		* Files with "normal" in the name are cooked as linear BC5, everything else uses the settings.
+		* Returns the number of textures that failed.
+		*/
+		static uint32 CookDirectory(const std::string& sourceDirectory, const std::string& cookedDirectory, const TextureCookSettings& settings, bool force = false);
+
+		static std::string GetCookedPath(const std::string& path);
+	};
+}
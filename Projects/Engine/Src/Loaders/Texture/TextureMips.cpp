@@ -0,0 +1,298 @@
+#include "PreCompiled.h"
+#include "TextureMips.h"
+
+#include "Core/ThreadPool.h"
+
+#include <xmmintrin.h>
+#include <emmintrin.h>
+#include <array>
+#include <cmath>
+
+namespace RS::_TextureMipsInternal
+{
+	constexpr uint32 RowsPerJob = 16;
+	constexpr float KaiserRadius = 3.f;	// In destination pixels, three lobes of the sinc.
+	constexpr float KaiserAlpha = 4.f;
+	constexpr float Pi = 3.14159265358979f;
+
+	struct FloatImage
+	{
+		uint32 width = 0;
+		uint32 height = 0;
+		std::vector<__m128> pixels;
+	};
+
+	/*
+	* Every destination pixel has the same number of taps so the inner loops do not branch. Unused taps have zero weight.
+	*/
+	struct Kernel
+	{
+		uint32 tapCount = 0;
+		std::vector<uint32> indices;
+		std::vector<float> weights;
+	};
+
+	inline float SRGBToLinear(float c)
+	{
+		return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+	}
+
+	inline float LinearToSRGB(float c)
+	{
+		return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.f / 2.4f) - 0.055f;
+	}
+
+	const std::array<float, 256>& GetSRGBToLinearTable()
+	{
+		static const std::array<float, 256> s_Table = []()
+		{
+			std::array<float, 256> table;
+			for (uint32 i = 0; i < 256; ++i)
+				table[i] = SRGBToLinear(i / 255.f);
+			return table;
+		}();
+		return s_Table;
+	}
+
+	// Zeroth order modified Bessel function of the first kind, used by the Kaiser window.
+	float BesselI0(float x)
+	{
+		float sum = 1.f;
+		float term = 1.f;
+		const float halfX = x * 0.5f;
+		for (uint32 k = 1; k < 32; ++k)
+		{
+			term *= (halfX / k) * (halfX / k);
+			sum += term;
+			if (term < sum * 1e-8f)
+				break;
+		}
+		return sum;
+	}
+
+	float KaiserWeight(float t)
+	{
+		if (std::abs(t) >= KaiserRadius)
+			return 0.f;
+
+		const float sinc = t == 0.f ? 1.f : std::sin(Pi * t) / (Pi * t);
+		const float ratio = t / KaiserRadius;
+		return sinc * BesselI0(KaiserAlpha * std::sqrt(1.f - ratio * ratio)) / BesselI0(KaiserAlpha);
+	}
+
+	Kernel BuildKernel(uint32 srcSize, uint32 dstSize, MipFilter filter)
+	{
+		Kernel kernel;
+		if (srcSize == dstSize)
+		{
+			kernel.tapCount = 1;
+			for (uint32 i = 0; i < dstSize; ++i)
+			{
+				kernel.indices.push_back(i);
+				kernel.weights.push_back(1.f);
+			}
+			return kernel;
+		}
+
+		const float scale = (float)srcSize / dstSize;
+		if (filter == MipFilter::Box)
+		{
+			// Each destination pixel covers [x * scale, (x + 1) * scale) of the source, the weights are the overlap.
+			kernel.tapCount = (uint32)std::ceil(scale) + 1;
+			for (uint32 x = 0; x < dstSize; ++x)
+			{
+				const float begin = x * scale;
+				const float end = begin + scale;
+				const uint32 first = (uint32)begin;
+				for (uint32 tap = 0; tap < kernel.tapCount; ++tap)
+				{
+					const uint32 index = first + tap;
+					const float overlap = std::max(0.f, std::min(end, index + 1.f) - std::max(begin, (float)index));
+					kernel.indices.push_back(std::min(index, srcSize - 1));
+					kernel.weights.push_back(overlap / scale);
+				}
+			}
+			return kernel;
+		}
+
+		const float srcRadius = KaiserRadius * scale;
+		kernel.tapCount = 2 * (uint32)std::ceil(srcRadius) + 1;
+		for (uint32 x = 0; x < dstSize; ++x)
+		{
+			const float center = (x + 0.5f) * scale - 0.5f;
+			const int32 first = (int32)std::floor(center - srcRadius) + 1;
+
+			float weightSum = 0.f;
+			const uint64 offset = kernel.weights.size();
+			for (uint32 tap = 0; tap < kernel.tapCount; ++tap)
+			{
+				const int32 index = first + (int32)tap;
+				const float weight = KaiserWeight((index - center) / scale);
+				kernel.indices.push_back((uint32)std::clamp(index, 0, (int32)srcSize - 1));
+				kernel.weights.push_back(weight);
+				weightSum += weight;
+			}
+
+			for (uint32 tap = 0; tap < kernel.tapCount; ++tap)
+				kernel.weights[offset + tap] /= weightSum;
+		}
+		return kernel;
+	}
+
+	void ParallelRows(uint32 rowCount, uint maxThreads, const std::function<void(uint32)>& func)
+	{
+		const uint64 jobCount = (rowCount + RowsPerJob - 1) / RowsPerJob;
+		ThreadPool::Get()->ParallelFor(jobCount, [&](uint64 job)
+			{
+				const uint32 end = std::min(rowCount, (uint32)(job + 1) * RowsPerJob);
+				for (uint32 row = (uint32)job * RowsPerJob; row < end; ++row)
+					func(row);
+			}, maxThreads);
+	}
+
+	FloatImage ToFloat(const TextureImage& image, bool isSRGB, uint maxThreads)
+	{
+		const std::array<float, 256>& srgbTable = GetSRGBToLinearTable();
+		const float inv255 = 1.f / 255.f;
+
+		FloatImage result;
+		result.width = image.width;
+		result.height = image.height;
+		result.pixels.resize((uint64)image.width * image.height);
+		ParallelRows(image.height, maxThreads, [&](uint32 y)
+			{
+				const uint8* pSrc = image.pixels.data() + (uint64)y * image.width * 4;
+				__m128* pDst = result.pixels.data() + (uint64)y * image.width;
+				for (uint32 x = 0; x < image.width; ++x, pSrc += 4)
+				{
+					if (isSRGB)
+						pDst[x] = _mm_setr_ps(srgbTable[pSrc[0]], srgbTable[pSrc[1]], srgbTable[pSrc[2]], pSrc[3] * inv255);
+					else
+						pDst[x] = _mm_mul_ps(_mm_setr_ps(pSrc[0], pSrc[1], pSrc[2], pSrc[3]), _mm_set1_ps(inv255));
+				}
+			});
+		return result;
+	}
+
+	TextureImage ToRGBA8(const FloatImage& image, bool isSRGB, uint maxThreads)
+	{
+		TextureImage result;
+		result.width = image.width;
+		result.height = image.height;
+		result.pixels.resize((uint64)image.width * image.height * 4);
+		ParallelRows(image.height, maxThreads, [&](uint32 y)
+			{
+				const __m128* pSrc = image.pixels.data() + (uint64)y * image.width;
+				uint8* pDst = result.pixels.data() + (uint64)y * image.width * 4;
+				for (uint32 x = 0; x < image.width; ++x, pDst += 4)
+				{
+					__m128 pixel = pSrc[x];
+					if (isSRGB)
+					{
+						alignas(16) float values[4];
+						_mm_store_ps(values, pixel);
+						pixel = _mm_setr_ps(LinearToSRGB(values[0]), LinearToSRGB(values[1]), LinearToSRGB(values[2]), values[3]);
+					}
+
+					// The values are already in [0, 1], rounding is done by adding 0.5 before truncating.
+					__m128i rounded = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(pixel, _mm_set1_ps(255.f)), _mm_set1_ps(0.5f)));
+					rounded = _mm_packs_epi32(rounded, rounded);
+					rounded = _mm_packus_epi16(rounded, rounded);
+					const uint32 packed = (uint32)_mm_cvtsi128_si32(rounded);
+					std::memcpy(pDst, &packed, sizeof(packed));
+				}
+			});
+		return result;
+	}
+
+	FloatImage Downsample(const FloatImage& src, MipFilter filter, uint maxThreads)
+	{
+		const uint32 dstWidth = std::max(1u, src.width / 2);
+		const uint32 dstHeight = std::max(1u, src.height / 2);
+		const Kernel horizontal = BuildKernel(src.width, dstWidth, filter);
+		const Kernel vertical = BuildKernel(src.height, dstHeight, filter);
+
+		// Horizontal pass into a dstWidth x srcHeight image.
+		std::vector<__m128> temp((uint64)dstWidth * src.height);
+		ParallelRows(src.height, maxThreads, [&](uint32 y)
+			{
+				const __m128* pSrcRow = src.pixels.data() + (uint64)y * src.width;
+				__m128* pDstRow = temp.data() + (uint64)y * dstWidth;
+				for (uint32 x = 0; x < dstWidth; ++x)
+				{
+					const uint32* pIndices = horizontal.indices.data() + (uint64)x * horizontal.tapCount;
+					const float* pWeights = horizontal.weights.data() + (uint64)x * horizontal.tapCount;
+
+					__m128 sum = _mm_setzero_ps();
+					for (uint32 tap = 0; tap < horizontal.tapCount; ++tap)
+						sum = _mm_add_ps(sum, _mm_mul_ps(pSrcRow[pIndices[tap]], _mm_set1_ps(pWeights[tap])));
+					pDstRow[x] = sum;
+				}
+			});
+
+		// Vertical pass, whole rows are accumulated at a time to read the temp image linearly.
+		FloatImage dst;
+		dst.width = dstWidth;
+		dst.height = dstHeight;
+		dst.pixels.resize((uint64)dstWidth * dstHeight);
+		ParallelRows(dstHeight, maxThreads, [&](uint32 y)
+			{
+				__m128* pDstRow = dst.pixels.data() + (uint64)y * dstWidth;
+				const uint32* pIndices = vertical.indices.data() + (uint64)y * vertical.tapCount;
+				const float* pWeights = vertical.weights.data() + (uint64)y * vertical.tapCount;
+
+				for (uint32 x = 0; x < dstWidth; ++x)
+					pDstRow[x] = _mm_setzero_ps();
+
+				for (uint32 tap = 0; tap < vertical.tapCount; ++tap)
+				{
+					if (pWeights[tap] == 0.f)
+						continue;
+
+					const __m128 weight = _mm_set1_ps(pWeights[tap]);
+					const __m128* pSrcRow = temp.data() + (uint64)pIndices[tap] * dstWidth;
+					for (uint32 x = 0; x < dstWidth; ++x)
+						pDstRow[x] = _mm_add_ps(pDstRow[x], _mm_mul_ps(pSrcRow[x], weight));
+				}
+
+				// The negative lobes of the Kaiser filter can overshoot.
+				for (uint32 x = 0; x < dstWidth; ++x)
+					pDstRow[x] = _mm_min_ps(_mm_max_ps(pDstRow[x], _mm_setzero_ps()), _mm_set1_ps(1.f));
+			});
+		return dst;
+	}
+}
+
+uint32 RS::TextureMipGenerator::GetMipCount(uint32 width, uint32 height)
+{
+	uint32 size = std::max(width, height);
+	uint32 count = 1;
+	while (size > 1)
+	{
+		size /= 2;
+		count++;
+	}
+	return count;
+}
+
+std::vector<RS::TextureImage> RS::TextureMipGenerator::Generate(const TextureImage& source, bool isSRGB, MipFilter filter, uint maxThreads)
+{
+	using namespace _TextureMipsInternal;
+	RS_ASSERT(source.pixels.size() == (uint64)source.width * source.height * 4, "Texture image has the wrong size! Expected RGBA8.");
+
+	std::vector<TextureImage> mips;
+	const uint32 mipCount = GetMipCount(source.width, source.height);
+	mips.reserve(mipCount);
+	mips.push_back(source);
+	if (mipCount == 1)
+		return mips;
+
+	FloatImage current = ToFloat(source, isSRGB, maxThreads);
+	for (uint32 mip = 1; mip < mipCount; ++mip)
+	{
+		FloatImage next = Downsample(current, filter, maxThreads);
+		mips.push_back(ToRGBA8(next, isSRGB, maxThreads));
+		current = std::move(next);
+	}
+	return mips;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+namespace RS
+{
+	enum class MipFilter : uint32
+	{
+		Box = 0,
+		Kaiser		// Windowed sinc, sharper than the box filter without much ringing.
+	};
+
+	/*
+	* RGBA8 image with tightly packed rows.
+	*/
+	struct TextureImage
+	{
+		uint32 width = 0;
+		uint32 height = 0;
+		std::vector<uint8> pixels;
+	};
+
+	class TextureMipGenerator
+	{
+	public:
+		RS_STATIC_CLASS(TextureMipGenerator)
+
+		static uint32 GetMipCount(uint32 width, uint32 height);
+
+		/*
+		* Returns the full mip chain where mip 0 is a copy of the source.
+		* sRGB images are filtered in linear space, alpha is always linear. Every mip is filtered from the float
+		* data of the mip above it, so the rounding to 8 bits does not add up down the chain.
+		* The rows of each mip are filtered in parallel on the thread pool, maxThreads = 0 uses all of them.
+		*/
+		static std::vector<TextureImage> Generate(const TextureImage& source, bool isSRGB, MipFilter filter, uint maxThreads = 0);
+	};
+}
@@ -1,19 +1,39 @@
 #include "PreCompiled.h"
 #include "FBXLoader.h"
 
-#include "Core/CorePlatform.h"
+#include "Core/VFS.h"
 
 #include "Loaders/openfbx/ofbx.h"
 
 using namespace RS;
 
+namespace RS::_FBXLoaderInternal
+{
+	// Scenes are allocated by ofbx and have to be given back to it.
+	struct SceneDeleter
+	{
+		void operator()(ofbx::IScene* pScene) const { pScene->destroy(); }
+	};
+}
+
 Mesh* RS::FBXLoader::Load(const std::string& path, bool isInternalPath)
 {
 	std::string modelPath = Engine::GetDataFilePath(isInternalPath) + RS_MODEL_PATH + path;
 
-	Mesh* pMesh = new Mesh();
+	std::shared_ptr<VFSFile> pFile = VFS::Get()->Open(modelPath);
+	if (!pFile)
+	{
+		LOG_ERROR("[FBXLoader::Load] Error: Cannot open file! File: {}", modelPath.c_str());
+		return nullptr;
+	}
+
+	// The file is parsed straight from the mapping, it only has to be alive during the load.
+	return Load(pFile->GetData(), path);
+}
 
-	CorePlatform::BinaryFile pFile = CorePlatform::LoadBinaryFile(modelPath);
+Mesh* RS::FBXLoader::Load(std::span<const uint8> data, const std::string& name)
+{
+	Mesh* pMesh = new Mesh();
 
 	// Ignoring certain nodes will only stop them from being processed not tokenised(i.e.they will still be in the tree)
 	ofbx::LoadFlags flags =
@@ -32,9 +52,7 @@ Mesh* RS::FBXLoader::Load(const std::string& path, bool isInternalPath)
 //		ofbx::LoadFlags::IGNORE_MESHES |
 		ofbx::LoadFlags::IGNORE_ANIMATIONS;
 
-	ofbx::IScene* pScene = nullptr;
-
-	pScene = ofbx::load((const ofbx::u8*)pFile.pData.get(), (int)pFile.size, (ofbx::u16)flags);
+	std::unique_ptr<ofbx::IScene, _FBXLoaderInternal::SceneDeleter> pScene(ofbx::load((const ofbx::u8*)data.data(), (int)data.size(), (ofbx::u16)flags));
 
 	if (!pScene)
 	{
@@ -48,13 +66,13 @@ Mesh* RS::FBXLoader::Load(const std::string& path, bool isInternalPath)
 	int meshCount = pScene->getMeshCount();
 	if (meshCount <= 0)
 	{
-		LOG_ERROR("[FBXLoader::Loade] Error: No mesh was found in the file! File: {}", path.c_str());
+		LOG_ERROR("[FBXLoader::Loade] Error: No mesh was found in the file! File: {}", name.c_str());
 		delete pMesh;
 		return nullptr;
 	}
 
 	if (meshCount > 1)
-		LOG_WARNING("[FBXLoader::Loade] Warning: Multiple meshes was found in the file, using the first one! File: {}", path.c_str());
+		LOG_WARNING("[FBXLoader::Loade] Warning: Multiple meshes was found in the file, using the first one! File: {}", name.c_str());
 
 	const ofbx::Mesh* pFbxMesh = pScene->getMesh(0);
 	const ofbx::Geometry* pGeometry = pFbxMesh->getGeometry();
@@ -64,7 +82,8 @@ Mesh* RS::FBXLoader::Load(const std::string& path, bool isInternalPath)
 	int indices_offset = 0;
 	int mesh_count = pScene->getMeshCount();
 
-	// output unindexed geometry
+	// Output unindexed geometry, MeshCooker::Index merges the vertices.
+	std::vector<int> triIndices;
 	for (int mesh_idx = 0; mesh_idx < mesh_count; ++mesh_idx) {
 		const ofbx::Mesh& mesh = *pScene->getMesh(mesh_idx);
 		const ofbx::GeometryData& geom = mesh.getGeometryData();
@@ -83,8 +102,8 @@ Mesh* RS::FBXLoader::Load(const std::string& path, bool isInternalPath)
 			for (int polygon_idx = 0; polygon_idx < partition.polygon_count; ++polygon_idx) {
 				const ofbx::GeometryPartition::Polygon& polygon = partition.polygons[polygon_idx];
 
-				int* triIndices = new int[3 * (polygon.vertex_count - 2)];
-				int numVertices = ofbx::triangulate(geom, polygon, triIndices);
+				triIndices.resize(std::max(3 * (polygon.vertex_count - 2), 0));
+				int numVertices = ofbx::triangulate(geom, polygon, triIndices.data());
 
 				bool has_normals = normals.values != nullptr;
 				bool has_uvs = uvs.values != nullptr;
@@ -106,7 +125,6 @@ Mesh* RS::FBXLoader::Load(const std::string& path, bool isInternalPath)
 
 					pMesh->vertices.push_back(vertex);
 				}
-				delete[] triIndices;
 			}
 
 			//for (int polygon_idx = 0; polygon_idx < partition.polygon_count; ++polygon_idx) {
@@ -2,6 +2,8 @@
 
 #include "Maths/RSVector.h"
 
+#include <span>
+
 namespace RS
 {
 	struct Vertex
@@ -22,5 +24,8 @@ namespace RS
 	{
 	public:
 		static Mesh* Load(const std::string& path, bool isInternalPath = false);
+
+		// Name is only used for logging.
+		static Mesh* Load(std::span<const uint8> data, const std::string& name);
 	};
 }
\ No newline at end of file
@@ -0,0 +1,353 @@
+#include "PreCompiled.h"
+#include "BVH.h"
+
+#include "Core/ThreadPool.h"
+
+#include <array>
+#include <atomic>
+
+namespace RS::_BVHInternal
+{
+	// Deeper than this the builder splits at the median, which keeps the tree within MaxTreeDepth for any primitive count.
+	constexpr uint32 MaxSAHDepth = MaxTreeDepth / 2;
+	// Subtrees with fewer primitives are built on the thread that split them.
+	constexpr uint32 ParallelPrimitiveCount = 4096;
+	constexpr uint32 MaxBinCount = 64;
+
+	struct BinaryNode
+	{
+		AABB bounds;
+		uint32 first = 0;	// First primitive of a leaf, or the left child.
+		uint32 count = 0;	// Primitives of a leaf, 0 for a node whose right child is first + 1.
+	};
+
+	struct Bin
+	{
+		AABB bounds;
+		uint32 count = 0;
+	};
+
+	struct BuildContext
+	{
+		std::span<const AABB> primitiveBounds;
+		std::vector<float> centroids;	// Three per primitive.
+		std::vector<uint32>& primitiveIndices;
+		std::vector<BinaryNode> nodes;
+		std::atomic<uint32> nodeCount = 1;
+		const BVHBuildSettings& settings;
+
+		BuildContext(std::span<const AABB> bounds, std::vector<uint32>& indices, const BVHBuildSettings& buildSettings)
+			: primitiveBounds(bounds), primitiveIndices(indices), settings(buildSettings)
+		{
+		}
+	};
+
+	void BuildNode(BuildContext& context, uint32 nodeIndex, uint32 first, uint32 count, uint32 depth)
+	{
+		const BVHBuildSettings& settings = context.settings;
+		uint32* pIndices = context.primitiveIndices.data() + first;
+
+		AABB bounds;
+		AABB centroidBounds;
+		for (uint32 i = 0; i < count; ++i)
+		{
+			bounds.Grow(context.primitiveBounds[pIndices[i]]);
+			centroidBounds.Grow(&context.centroids[pIndices[i] * 3]);
+		}
+		BinaryNode& node = context.nodes[nodeIndex];
+		node.bounds = bounds;
+
+		if (count <= 1)
+		{
+			node.first = first;
+			node.count = count;
+			return;
+		}
+
+		// Binned SAH on every axis, the cost is relative to intersecting one primitive.
+		const uint32 binCount = std::clamp(settings.binCount, 2u, MaxBinCount);
+		const float parentArea = std::max(bounds.GetSurfaceArea(), FLT_MIN);
+		float bestCost = FLT_MAX;
+		uint32 bestAxis = 0;
+		uint32 bestSplit = 0;
+		std::array<Bin, MaxBinCount> bins;
+		std::array<float, MaxBinCount> rightAreas;
+		std::array<uint32, MaxBinCount> rightCounts;
+		for (uint32 axis = 0; axis < 3 && depth < MaxSAHDepth; ++axis)
+		{
+			const float extent = centroidBounds.max[axis] - centroidBounds.min[axis];
+			if (!(extent > 0.f))
+				continue;
+
+			const float scale = (float)binCount / extent;
+			std::fill(bins.begin(), bins.begin() + binCount, Bin());
+			for (uint32 i = 0; i < count; ++i)
+			{
+				const uint32 primitive = pIndices[i];
+				const uint32 bin = std::min((uint32)((context.centroids[primitive * 3 + axis] - centroidBounds.min[axis]) * scale), binCount - 1);
+				bins[bin].bounds.Grow(context.primitiveBounds[primitive]);
+				bins[bin].count++;
+			}
+
+			AABB rightBounds;
+			uint32 rightCount = 0;
+			for (uint32 bin = binCount - 1; bin > 0; --bin)
+			{
+				rightBounds.Grow(bins[bin].bounds);
+				rightCount += bins[bin].count;
+				rightAreas[bin] = rightBounds.GetSurfaceArea();
+				rightCounts[bin] = rightCount;
+			}
+
+			// Splitting before bin puts it and the bins after it on the right.
+			AABB leftBounds;
+			uint32 leftCount = 0;
+			for (uint32 bin = 1; bin < binCount; ++bin)
+			{
+				leftBounds.Grow(bins[bin - 1].bounds);
+				leftCount += bins[bin - 1].count;
+				if (leftCount == 0 || rightCounts[bin] == 0)
+					continue;
+
+				const float cost = settings.traversalCost + (leftBounds.GetSurfaceArea() * leftCount + rightAreas[bin] * rightCounts[bin]) / parentArea;
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = bin;
+				}
+			}
+		}
+
+		if (count <= settings.maxLeafSize && (float)count <= bestCost)
+		{
+			node.first = first;
+			node.count = count;
+			return;
+		}
+
+		uint32 leftCount = 0;
+		if (bestCost < FLT_MAX)
+		{
+			const float scale = (float)binCount / (centroidBounds.max[bestAxis] - centroidBounds.min[bestAxis]);
+			uint32* pMiddle = std::partition(pIndices, pIndices + count, [&](uint32 primitive)
+				{
+					return std::min((uint32)((context.centroids[primitive * 3 + bestAxis] - centroidBounds.min[bestAxis]) * scale), binCount - 1) < bestSplit;
+				});
+			leftCount = (uint32)(pMiddle - pIndices);
+		}
+
+		// Too deep, or every centroid is at the same spot: split at the median of the widest axis.
+		if (leftCount == 0 || leftCount == count)
+		{
+			uint32 axis = 0;
+			for (uint32 i = 1; i < 3; ++i)
+			{
+				if (centroidBounds.max[i] - centroidBounds.min[i] > centroidBounds.max[axis] - centroidBounds.min[axis])
+					axis = i;
+			}
+			leftCount = count / 2;
+			std::nth_element(pIndices, pIndices + leftCount, pIndices + count, [&](uint32 a, uint32 b)
+				{
+					const float ca = context.centroids[a * 3 + axis], cb = context.centroids[b * 3 + axis];
+					return ca < cb || (ca == cb && a < b);
+				});
+		}
+
+		const uint32 leftIndex = context.nodeCount.fetch_add(2);
+		node.first = leftIndex;
+		node.count = 0;
+
+		auto buildChild = [&context, leftIndex, first, count, leftCount, depth](uint64 child)
+		{
+			if (child == 0)
+				BuildNode(context, leftIndex, first, leftCount, depth + 1);
+			else
+				BuildNode(context, leftIndex + 1, first + leftCount, count - leftCount, depth + 1);
+		};
+		if (count >= ParallelPrimitiveCount && settings.maxThreads != 1)
+		{
+			ThreadPool::Get()->ParallelFor(2, buildChild, settings.maxThreads);
+		}
+		else
+		{
+			buildChild(0);
+			buildChild(1);
+		}
+	}
+
+	template<uint32 Width>
+	void SetChild(typename BVH<Width>::Node& node, uint32 slot, const AABB& bounds, uint32 child, uint32 count)
+	{
+		node.minX[slot] = bounds.min[0];
+		node.minY[slot] = bounds.min[1];
+		node.minZ[slot] = bounds.min[2];
+		node.maxX[slot] = bounds.max[0];
+		node.maxY[slot] = bounds.max[1];
+		node.maxZ[slot] = bounds.max[2];
+		node.children[slot] = child;
+		node.counts[slot] = count;
+	}
+
+	template<uint32 Width>
+	AABB GetChildBounds(const typename BVH<Width>::Node& node, uint32 slot)
+	{
+		AABB bounds;
+		bounds.min[0] = node.minX[slot];
+		bounds.min[1] = node.minY[slot];
+		bounds.min[2] = node.minZ[slot];
+		bounds.max[0] = node.maxX[slot];
+		bounds.max[1] = node.maxY[slot];
+		bounds.max[2] = node.maxZ[slot];
+		return bounds;
+	}
+
+	template<uint32 Width>
+	void ClearNode(typename BVH<Width>::Node& node)
+	{
+		AABB empty;
+		for (uint32 i = 0; i < 3; ++i)
+		{
+			empty.min[i] = INFINITY;
+			empty.max[i] = -INFINITY;
+		}
+		for (uint32 slot = 0; slot < Width; ++slot)
+			SetChild<Width>(node, slot, empty, BVH<Width>::EmptyChild, 0);
+	}
+
+	/*
+	* Depth first, so every child is stored after its parent. Each node opens up the binary node with the largest
+	* surface area until it has Width children.
+	*/
+	template<uint32 Width>
+	uint32 CollapseNode(const std::vector<BinaryNode>& binaryNodes, uint32 binaryIndex, uint32 depth, std::vector<typename BVH<Width>::Node>& nodes, uint32& maxDepth)
+	{
+		maxDepth = std::max(maxDepth, depth);
+		const uint32 nodeIndex = (uint32)nodes.size();
+		nodes.emplace_back();
+		ClearNode<Width>(nodes[nodeIndex]);
+
+		uint32 children[Width];
+		uint32 childCount = 0;
+		const BinaryNode& binaryNode = binaryNodes[binaryIndex];
+		if (binaryNode.count > 0)
+		{
+			children[childCount++] = binaryIndex;
+		}
+		else
+		{
+			children[childCount++] = binaryNode.first;
+			children[childCount++] = binaryNode.first + 1;
+		}
+
+		while (childCount < Width)
+		{
+			uint32 largest = UINT32_MAX;
+			float largestArea = -1.f;
+			for (uint32 i = 0; i < childCount; ++i)
+			{
+				const BinaryNode& child = binaryNodes[children[i]];
+				if (child.count == 0 && child.bounds.GetSurfaceArea() > largestArea)
+				{
+					largest = i;
+					largestArea = child.bounds.GetSurfaceArea();
+				}
+			}
+			if (largest == UINT32_MAX)
+				break;
+
+			// Keeps the children in the order of the binary tree.
+			const uint32 left = binaryNodes[children[largest]].first;
+			for (uint32 i = childCount; i > largest + 1; --i)
+				children[i] = children[i - 1];
+			children[largest] = left;
+			children[largest + 1] = left + 1;
+			childCount++;
+		}
+
+		for (uint32 slot = 0; slot < childCount; ++slot)
+		{
+			const BinaryNode& child = binaryNodes[children[slot]];
+			const uint32 childIndex = child.count > 0 ? child.first : CollapseNode<Width>(binaryNodes, children[slot], depth + 1, nodes, maxDepth);
+			SetChild<Width>(nodes[nodeIndex], slot, child.bounds, childIndex, child.count);
+		}
+		return nodeIndex;
+	}
+}
+
+template<uint32 Width>
+void RS::BVH<Width>::Build(std::span<const AABB> primitiveBounds, const BVHBuildSettings& settings)
+{
+	using namespace _BVHInternal;
+
+	m_Nodes.clear();
+	m_PrimitiveIndices.resize(primitiveBounds.size());
+	for (uint32 i = 0; i < (uint32)primitiveBounds.size(); ++i)
+		m_PrimitiveIndices[i] = i;
+	m_Bounds = AABB();
+	m_Depth = 0;
+	if (primitiveBounds.empty())
+		return;
+
+	BuildContext context(primitiveBounds, m_PrimitiveIndices, settings);
+	context.centroids.resize(primitiveBounds.size() * 3);
+	context.nodes.resize(primitiveBounds.size() * 2);
+	for (uint64 i = 0; i < primitiveBounds.size(); ++i)
+	{
+		for (uint32 axis = 0; axis < 3; ++axis)
+			context.centroids[i * 3 + axis] = (primitiveBounds[i].min[axis] + primitiveBounds[i].max[axis]) * 0.5f;
+	}
+	BuildNode(context, 0, 0, (uint32)primitiveBounds.size(), 1);
+
+	m_Bounds = context.nodes[0].bounds;
+	m_Nodes.reserve(context.nodeCount.load() / 2 + 1);
+	CollapseNode<Width>(context.nodes, 0, 1, m_Nodes, m_Depth);
+}
+
+template<uint32 Width>
+void RS::BVH<Width>::Refit(std::span<const AABB> primitiveBounds)
+{
+	using namespace _BVHInternal;
+	RS_ASSERT(primitiveBounds.size() == m_PrimitiveIndices.size(), "Cannot refit a BVH of {} primitives with {} primitives!", m_PrimitiveIndices.size(), primitiveBounds.size());
+
+	// Children are stored after their parents, so going backwards refits them first.
+	for (uint64 nodeIndex = m_Nodes.size(); nodeIndex-- > 0;)
+	{
+		Node& node = m_Nodes[nodeIndex];
+		for (uint32 slot = 0; slot < Width; ++slot)
+		{
+			if (node.children[slot] == EmptyChild)
+				continue;
+
+			AABB bounds;
+			if (node.counts[slot] > 0)
+			{
+				for (uint32 i = node.children[slot]; i < node.children[slot] + node.counts[slot]; ++i)
+					bounds.Grow(primitiveBounds[m_PrimitiveIndices[i]]);
+			}
+			else
+			{
+				const Node& child = m_Nodes[node.children[slot]];
+				for (uint32 childSlot = 0; childSlot < Width; ++childSlot)
+				{
+					if (child.children[childSlot] != EmptyChild)
+						bounds.Grow(GetChildBounds<Width>(child, childSlot));
+				}
+			}
+			SetChild<Width>(node, slot, bounds, node.children[slot], node.counts[slot]);
+		}
+	}
+
+	m_Bounds = AABB();
+	if (!m_Nodes.empty())
+	{
+		for (uint32 slot = 0; slot < Width; ++slot)
+		{
+			if (m_Nodes[0].children[slot] != EmptyChild)
+				m_Bounds.Grow(GetChildBounds<Width>(m_Nodes[0], slot));
+		}
+	}
+}
+
+template class RS::BVH<4>;
+template class RS::BVH<8>;
@@ -0,0 +1,349 @@
+#pragma once
+
+#include <bit>
+#include <span>
+#include <cfloat>
+#include <cmath>
+#include <xmmintrin.h>
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+namespace RS
+{
+	struct AABB
+	{
+		float min[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+		float max[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+		void Grow(const float point[3])
+		{
+			for (uint32 i = 0; i < 3; ++i)
+			{
+				min[i] = std::min(min[i], point[i]);
+				max[i] = std::max(max[i], point[i]);
+			}
+		}
+
+		void Grow(const AABB& other)
+		{
+			for (uint32 i = 0; i < 3; ++i)
+			{
+				min[i] = std::min(min[i], other.min[i]);
+				max[i] = std::max(max[i], other.max[i]);
+			}
+		}
+
+		bool IsEmpty() const { return min[0] > max[0] || min[1] > max[1] || min[2] > max[2]; }
+		bool Overlaps(const AABB& other) const
+		{
+			return min[0] <= other.max[0] && max[0] >= other.min[0] && min[1] <= other.max[1] && max[1] >= other.min[1] && min[2] <= other.max[2] && max[2] >= other.min[2];
+		}
+
+		float GetSurfaceArea() const
+		{
+			if (IsEmpty())
+				return 0.f;
+			const float x = max[0] - min[0], y = max[1] - min[1], z = max[2] - min[2];
+			return 2.f * (x * y + y * z + z * x);
+		}
+	};
+
+	struct Ray
+	{
+		float origin[3] = {};
+		float direction[3] = { 0.f, 0.f, 1.f };	// Does not have to be normalized, t is in lengths of the direction.
+		float tMin = 0.f;
+		float tMax = FLT_MAX;
+		bool cullBackFacing = false;			// Like RAY_FLAG_CULL_BACK_FACING_TRIANGLES, clockwise seen from the origin is the front.
+	};
+
+	struct RayHit
+	{
+		float t = FLT_MAX;
+		float u = 0.f;						// Barycentrics of the second and the third vertex of the triangle.
+		float v = 0.f;
+		uint32 primitive = UINT32_MAX;		// Triangle in the order of the source mesh.
+		uint32 instance = UINT32_MAX;		// Instance ID, only set by scene queries.
+
+		bool IsHit() const { return primitive != UINT32_MAX; }
+	};
+
+	struct BVHBuildSettings
+	{
+		uint32 binCount = 16;			// Per axis, for the SAH.
+		uint32 maxLeafSize = 4;
+		float traversalCost = 1.f;		// Relative to the cost of intersecting one primitive.
+		uint maxThreads = 0;			// Works like it does for ThreadPool::ParallelFor.
+	};
+}
+
+namespace RS::_BVHInternal
+{
+	template<uint32 Width>
+	struct SIMDFloat;
+
+	template<>
+	struct SIMDFloat<4>
+	{
+		__m128 value;
+
+		static SIMDFloat Load(const float* pData) { return { _mm_load_ps(pData) }; }
+		static SIMDFloat Set(float scalar) { return { _mm_set1_ps(scalar) }; }
+		static SIMDFloat Min(SIMDFloat a, SIMDFloat b) { return { _mm_min_ps(a.value, b.value) }; }
+		static SIMDFloat Max(SIMDFloat a, SIMDFloat b) { return { _mm_max_ps(a.value, b.value) }; }
+		static uint32 LessEqualMask(SIMDFloat a, SIMDFloat b) { return (uint32)_mm_movemask_ps(_mm_cmple_ps(a.value, b.value)); }
+		void Store(float* pData) const { _mm_storeu_ps(pData, value); }
+
+		friend SIMDFloat operator+(SIMDFloat a, SIMDFloat b) { return { _mm_add_ps(a.value, b.value) }; }
+		friend SIMDFloat operator-(SIMDFloat a, SIMDFloat b) { return { _mm_sub_ps(a.value, b.value) }; }
+		friend SIMDFloat operator*(SIMDFloat a, SIMDFloat b) { return { _mm_mul_ps(a.value, b.value) }; }
+	};
+
+#if defined(__AVX__)
+	template<>
+	struct SIMDFloat<8>
+	{
+		__m256 value;
+
+		static SIMDFloat Load(const float* pData) { return { _mm256_load_ps(pData) }; }
+		static SIMDFloat Set(float scalar) { return { _mm256_set1_ps(scalar) }; }
+		static SIMDFloat Min(SIMDFloat a, SIMDFloat b) { return { _mm256_min_ps(a.value, b.value) }; }
+		static SIMDFloat Max(SIMDFloat a, SIMDFloat b) { return { _mm256_max_ps(a.value, b.value) }; }
+		static uint32 LessEqualMask(SIMDFloat a, SIMDFloat b) { return (uint32)_mm256_movemask_ps(_mm256_cmp_ps(a.value, b.value, _CMP_LE_OQ)); }
+		void Store(float* pData) const { _mm256_storeu_ps(pData, value); }
+
+		friend SIMDFloat operator+(SIMDFloat a, SIMDFloat b) { return { _mm256_add_ps(a.value, b.value) }; }
+		friend SIMDFloat operator-(SIMDFloat a, SIMDFloat b) { return { _mm256_sub_ps(a.value, b.value) }; }
+		friend SIMDFloat operator*(SIMDFloat a, SIMDFloat b) { return { _mm256_mul_ps(a.value, b.value) }; }
+	};
+#else
+	// Two SSE halves when the build does not target AVX.
+	template<>
+	struct SIMDFloat<8>
+	{
+		SIMDFloat<4> low;
+		SIMDFloat<4> high;
+
+		static SIMDFloat Load(const float* pData) { return { SIMDFloat<4>::Load(pData), SIMDFloat<4>::Load(pData + 4) }; }
+		static SIMDFloat Set(float scalar) { return { SIMDFloat<4>::Set(scalar), SIMDFloat<4>::Set(scalar) }; }
+		static SIMDFloat Min(SIMDFloat a, SIMDFloat b) { return { SIMDFloat<4>::Min(a.low, b.low), SIMDFloat<4>::Min(a.high, b.high) }; }
+		static SIMDFloat Max(SIMDFloat a, SIMDFloat b) { return { SIMDFloat<4>::Max(a.low, b.low), SIMDFloat<4>::Max(a.high, b.high) }; }
+		static uint32 LessEqualMask(SIMDFloat a, SIMDFloat b) { return SIMDFloat<4>::LessEqualMask(a.low, b.low) | (SIMDFloat<4>::LessEqualMask(a.high, b.high) << 4); }
+		void Store(float* pData) const { low.Store(pData); high.Store(pData + 4); }
+
+		friend SIMDFloat operator+(SIMDFloat a, SIMDFloat b) { return { a.low + b.low, a.high + b.high }; }
+		friend SIMDFloat operator-(SIMDFloat a, SIMDFloat b) { return { a.low - b.low, a.high - b.high }; }
+		friend SIMDFloat operator*(SIMDFloat a, SIMDFloat b) { return { a.low * b.low, a.high * b.high }; }
+	};
+#endif
+
+	// The SAH builder limits the depth of the binary tree to 64, which bounds the traversal stacks.
+	constexpr uint32 MaxTreeDepth = 64;
+}
+
+namespace RS
+{
+	/*
+	* Bounding volume hierarchy over primitive bounds, with Width (4 or 8) children per node so one SIMD test covers all of them.
+	* Built with a binned SAH in parallel on the ThreadPool, then collapsed from a binary tree. Only the tree is stored, the
+	* primitives stay with the owner, which the traversal hands ranges of GetPrimitiveIndices() to.
+	*/
+	template<uint32 Width>
+	class BVH
+	{
+	public:
+		static_assert(Width == 4 || Width == 8, "BVH nodes have 4 or 8 children!");
+		static constexpr uint32 EmptyChild = UINT32_MAX;
+
+		// Child bounds in SoA layout. Empty slots have inverted infinite bounds, which no query overlaps.
+		struct alignas(Width * sizeof(float)) Node
+		{
+			float minX[Width];
+			float minY[Width];
+			float minZ[Width];
+			float maxX[Width];
+			float maxY[Width];
+			float maxZ[Width];
+			uint32 children[Width];	// A node, the first primitive of a leaf, or EmptyChild.
+			uint32 counts[Width];	// Primitives in a leaf, 0 for nodes.
+		};
+
+		/*
+		* The tree is the same for every thread count.
+		*/
+		void Build(std::span<const AABB> primitiveBounds, const BVHBuildSettings& settings = BVHBuildSettings());
+
+		/*
+		* Updates the bounds for primitives that moved, keeping the tree. Much faster than a build, but the tree gets worse the more they move.
+		*/
+		void Refit(std::span<const AABB> primitiveBounds);
+
+		/*
+		* leafFunc(first, count) gets the leaves the ray passes through, nearest first, and returns true to stop.
+		* It can lower tMax to skip the leaves further away.
+		*/
+		template<typename LeafFunc>
+		void Traverse(const Ray& ray, float& tMax, LeafFunc&& leafFunc) const;
+
+		// leafFunc(first, count) for the leaves that overlap the box, returns true to stop.
+		template<typename LeafFunc>
+		void Traverse(const AABB& box, LeafFunc&& leafFunc) const;
+
+		// leafFunc(first, count) for the leaves that overlap the sphere, returns true to stop.
+		template<typename LeafFunc>
+		void Traverse(const float center[3], float radius, LeafFunc&& leafFunc) const;
+
+		std::span<const uint32> GetPrimitiveIndices() const { return m_PrimitiveIndices; }
+		std::span<const Node> GetNodes() const { return m_Nodes; }
+		const AABB& GetBounds() const { return m_Bounds; }
+		uint32 GetDepth() const { return m_Depth; }	// Of the wide nodes.
+
+	private:
+		std::vector<Node> m_Nodes;
+		std::vector<uint32> m_PrimitiveIndices;
+		AABB m_Bounds;
+		uint32 m_Depth = 0;
+	};
+
+	template<uint32 Width>
+	template<typename LeafFunc>
+	inline void BVH<Width>::Traverse(const Ray& ray, float& tMax, LeafFunc&& leafFunc) const
+	{
+		using SIMD = _BVHInternal::SIMDFloat<Width>;
+		if (m_Nodes.empty())
+			return;
+
+		// Each axis tests the near plane for the sign of the direction, which also makes the empty slots miss.
+		float inverseDirection[3];
+		bool isNegative[3];
+		for (uint32 i = 0; i < 3; ++i)
+		{
+			const float direction = std::abs(ray.direction[i]) < 1e-20f ? std::copysign(1e-20f, ray.direction[i]) : ray.direction[i];
+			inverseDirection[i] = 1.f / direction;
+			isNegative[i] = inverseDirection[i] < 0.f;
+		}
+		const SIMD originX = SIMD::Set(ray.origin[0]), originY = SIMD::Set(ray.origin[1]), originZ = SIMD::Set(ray.origin[2]);
+		const SIMD inverseX = SIMD::Set(inverseDirection[0]), inverseY = SIMD::Set(inverseDirection[1]), inverseZ = SIMD::Set(inverseDirection[2]);
+		const SIMD tMinV = SIMD::Set(ray.tMin);
+
+		struct Entry
+		{
+			uint32 child;
+			uint32 count;
+			float t;
+		};
+		Entry stack[_BVHInternal::MaxTreeDepth * Width];
+		uint32 stackSize = 0;
+		stack[stackSize++] = { 0, 0, ray.tMin };
+
+		while (stackSize > 0)
+		{
+			const Entry entry = stack[--stackSize];
+			if (entry.t > tMax)
+				continue;
+			if (entry.count > 0)
+			{
+				if (leafFunc(entry.child, entry.count))
+					return;
+				continue;
+			}
+
+			const Node& node = m_Nodes[entry.child];
+			const SIMD tNearX = (SIMD::Load(isNegative[0] ? node.maxX : node.minX) - originX) * inverseX;
+			const SIMD tNearY = (SIMD::Load(isNegative[1] ? node.maxY : node.minY) - originY) * inverseY;
+			const SIMD tNearZ = (SIMD::Load(isNegative[2] ? node.maxZ : node.minZ) - originZ) * inverseZ;
+			const SIMD tFarX = (SIMD::Load(isNegative[0] ? node.minX : node.maxX) - originX) * inverseX;
+			const SIMD tFarY = (SIMD::Load(isNegative[1] ? node.minY : node.maxY) - originY) * inverseY;
+			const SIMD tFarZ = (SIMD::Load(isNegative[2] ? node.minZ : node.maxZ) - originZ) * inverseZ;
+			const SIMD tEntry = SIMD::Max(SIMD::Max(tNearX, tNearY), SIMD::Max(tNearZ, tMinV));
+			const SIMD tExit = SIMD::Min(SIMD::Min(tFarX, tFarY), SIMD::Min(tFarZ, SIMD::Set(tMax)));
+			uint32 mask = SIMD::LessEqualMask(tEntry, tExit);
+			if (mask == 0)
+				continue;
+
+			float tEntries[Width];
+			tEntry.Store(tEntries);
+
+			// Sorted far to near, so the nearest child is popped first.
+			Entry hits[Width];
+			uint32 hitCount = 0;
+			for (; mask != 0; mask &= mask - 1)
+			{
+				const uint32 slot = (uint32)std::countr_zero(mask);
+				const Entry hit = { node.children[slot], node.counts[slot], tEntries[slot] };
+				uint32 i = hitCount++;
+				for (; i > 0 && hits[i - 1].t < hit.t; --i)
+					hits[i] = hits[i - 1];
+				hits[i] = hit;
+			}
+			for (uint32 i = 0; i < hitCount; ++i)
+				stack[stackSize++] = hits[i];
+		}
+	}
+
+	template<uint32 Width>
+	template<typename LeafFunc>
+	inline void BVH<Width>::Traverse(const AABB& box, LeafFunc&& leafFunc) const
+	{
+		using SIMD = _BVHInternal::SIMDFloat<Width>;
+		if (m_Nodes.empty())
+			return;
+
+		const SIMD boxMinX = SIMD::Set(box.min[0]), boxMinY = SIMD::Set(box.min[1]), boxMinZ = SIMD::Set(box.min[2]);
+		const SIMD boxMaxX = SIMD::Set(box.max[0]), boxMaxY = SIMD::Set(box.max[1]), boxMaxZ = SIMD::Set(box.max[2]);
+
+		uint32 stack[_BVHInternal::MaxTreeDepth * Width];
+		uint32 stackSize = 0;
+		stack[stackSize++] = 0;
+		while (stackSize > 0)
+		{
+			const Node& node = m_Nodes[stack[--stackSize]];
+			uint32 mask = SIMD::LessEqualMask(SIMD::Load(node.minX), boxMaxX) & SIMD::LessEqualMask(boxMinX, SIMD::Load(node.maxX))
+				& SIMD::LessEqualMask(SIMD::Load(node.minY), boxMaxY) & SIMD::LessEqualMask(boxMinY, SIMD::Load(node.maxY))
+				& SIMD::LessEqualMask(SIMD::Load(node.minZ), boxMaxZ) & SIMD::LessEqualMask(boxMinZ, SIMD::Load(node.maxZ));
+			for (; mask != 0; mask &= mask - 1)
+			{
+				const uint32 slot = (uint32)std::countr_zero(mask);
+				if (node.counts[slot] == 0)
+					stack[stackSize++] = node.children[slot];
+				else if (leafFunc(node.children[slot], node.counts[slot]))
+					return;
+			}
+		}
+	}
+
+	template<uint32 Width>
+	template<typename LeafFunc>
+	inline void BVH<Width>::Traverse(const float center[3], float radius, LeafFunc&& leafFunc) const
+	{
+		using SIMD = _BVHInternal::SIMDFloat<Width>;
+		if (m_Nodes.empty())
+			return;
+
+		const SIMD centerX = SIMD::Set(center[0]), centerY = SIMD::Set(center[1]), centerZ = SIMD::Set(center[2]);
+		const SIMD radiusSquared = SIMD::Set(radius * radius);
+		const SIMD zero = SIMD::Set(0.f);
+
+		uint32 stack[_BVHInternal::MaxTreeDepth * Width];
+		uint32 stackSize = 0;
+		stack[stackSize++] = 0;
+		while (stackSize > 0)
+		{
+			const Node& node = m_Nodes[stack[--stackSize]];
+			// Distance from the center to the closest point of each box.
+			const SIMD dx = SIMD::Max(SIMD::Max(SIMD::Load(node.minX) - centerX, centerX - SIMD::Load(node.maxX)), zero);
+			const SIMD dy = SIMD::Max(SIMD::Max(SIMD::Load(node.minY) - centerY, centerY - SIMD::Load(node.maxY)), zero);
+			const SIMD dz = SIMD::Max(SIMD::Max(SIMD::Load(node.minZ) - centerZ, centerZ - SIMD::Load(node.maxZ)), zero);
+			uint32 mask = SIMD::LessEqualMask(dx * dx + dy * dy + dz * dz, radiusSquared);
+			for (; mask != 0; mask &= mask - 1)
+			{
+				const uint32 slot = (uint32)std::countr_zero(mask);
+				if (node.counts[slot] == 0)
+					stack[stackSize++] = node.children[slot];
+				else if (leafFunc(node.children[slot], node.counts[slot]))
+					return;
+			}
+		}
+	}
+}
@@ -0,0 +1,251 @@
+#include "PreCompiled.h"
+#include "MeshBVH.h"
+
+#include "Maths/GLMDefines.h"
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <cmath>
+
+namespace RS::_MeshBVHInternal
+{
+	// Real-Time Collision Detection 5.1.5.
+	glm::vec3 ClosestPointOnTriangle(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+	{
+		const glm::vec3 ab = b - a, ac = c - a, ap = p - a;
+		const float d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+		if (d1 <= 0.f && d2 <= 0.f)
+			return a;
+
+		const glm::vec3 bp = p - b;
+		const float d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+		if (d3 >= 0.f && d4 <= d3)
+			return b;
+
+		const float vc = d1 * d4 - d3 * d2;
+		if (vc <= 0.f && d1 >= 0.f && d3 <= 0.f)
+			return a + ab * (d1 / (d1 - d3));
+
+		const glm::vec3 cp = p - c;
+		const float d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+		if (d6 >= 0.f && d5 <= d6)
+			return c;
+
+		const float vb = d5 * d2 - d1 * d6;
+		if (vb <= 0.f && d2 >= 0.f && d6 <= 0.f)
+			return a + ac * (d2 / (d2 - d6));
+
+		const float va = d3 * d6 - d5 * d4;
+		if (va <= 0.f && (d4 - d3) >= 0.f && (d5 - d6) >= 0.f)
+			return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+		const float denominator = 1.f / (va + vb + vc);
+		return a + ab * (vb * denominator) + ac * (vc * denominator);
+	}
+}
+
+template<uint32 Width>
+void RS::MeshBVH<Width>::Build(std::span<const uint32> indices, std::span<const Vertex> vertices, const BVHBuildSettings& settings)
+{
+	if (indices.empty())
+	{
+		m_Indices.resize(vertices.size() / 3 * 3);
+		for (uint32 i = 0; i < (uint32)m_Indices.size(); ++i)
+			m_Indices[i] = i;
+	}
+	else
+	{
+		m_Indices.assign(indices.begin(), indices.begin() + indices.size() / 3 * 3);
+	}
+
+	m_BVH.Build(GetTriangleBounds(vertices), settings);
+	SetTriangles(vertices);
+}
+
+template<uint32 Width>
+void RS::MeshBVH<Width>::Refit(std::span<const Vertex> vertices)
+{
+	m_BVH.Refit(GetTriangleBounds(vertices));
+	SetTriangles(vertices);
+}
+
+template<uint32 Width>
+std::vector<RS::AABB> RS::MeshBVH<Width>::GetTriangleBounds(std::span<const Vertex> vertices) const
+{
+	std::vector<AABB> bounds(m_Indices.size() / 3);
+	for (uint64 i = 0; i < bounds.size(); ++i)
+	{
+		for (uint32 corner = 0; corner < 3; ++corner)
+			bounds[i].Grow(vertices[m_Indices[i * 3 + corner]].position.values);
+	}
+	return bounds;
+}
+
+template<uint32 Width>
+void RS::MeshBVH<Width>::SetTriangles(std::span<const Vertex> vertices)
+{
+	const std::span<const uint32> order = m_BVH.GetPrimitiveIndices();
+	m_Triangles.resize(order.size());
+	for (uint64 i = 0; i < order.size(); ++i)
+	{
+		const uint32* pIndices = &m_Indices[(uint64)order[i] * 3];
+		std::memcpy(m_Triangles[i].p0, vertices[pIndices[0]].position.values, sizeof(float) * 3);
+		std::memcpy(m_Triangles[i].p1, vertices[pIndices[1]].position.values, sizeof(float) * 3);
+		std::memcpy(m_Triangles[i].p2, vertices[pIndices[2]].position.values, sizeof(float) * 3);
+	}
+}
+
+template<uint32 Width>
+bool RS::MeshBVH<Width>::Intersect(const Ray& ray, RayHit& hit) const
+{
+	const std::span<const uint32> order = m_BVH.GetPrimitiveIndices();
+	float tMax = std::min(ray.tMax, hit.t);
+	bool isHit = false;
+	m_BVH.Traverse(ray, tMax, [&](uint32 first, uint32 count)
+		{
+			for (uint32 i = first; i < first + count; ++i)
+			{
+				const Triangle& triangle = m_Triangles[i];
+				float t, u, v;
+				if (IntersectRay(triangle.p0, triangle.p1, triangle.p2, ray, tMax, t, u, v))
+				{
+					tMax = t;
+					hit.t = t;
+					hit.u = u;
+					hit.v = v;
+					hit.primitive = order[i];
+					isHit = true;
+				}
+			}
+			return false;
+		});
+	return isHit;
+}
+
+template<uint32 Width>
+bool RS::MeshBVH<Width>::IsOccluded(const Ray& ray) const
+{
+	float tMax = ray.tMax;
+	bool isHit = false;
+	m_BVH.Traverse(ray, tMax, [&](uint32 first, uint32 count)
+		{
+			for (uint32 i = first; i < first + count && !isHit; ++i)
+			{
+				const Triangle& triangle = m_Triangles[i];
+				float t, u, v;
+				isHit = IntersectRay(triangle.p0, triangle.p1, triangle.p2, ray, tMax, t, u, v);
+			}
+			return isHit;
+		});
+	return isHit;
+}
+
+template<uint32 Width>
+void RS::MeshBVH<Width>::QueryAABB(const AABB& box, std::vector<uint32>& triangles) const
+{
+	const std::span<const uint32> order = m_BVH.GetPrimitiveIndices();
+	m_BVH.Traverse(box, [&](uint32 first, uint32 count)
+		{
+			for (uint32 i = first; i < first + count; ++i)
+			{
+				if (IntersectsAABB(m_Triangles[i].p0, m_Triangles[i].p1, m_Triangles[i].p2, box))
+					triangles.push_back(order[i]);
+			}
+			return false;
+		});
+}
+
+template<uint32 Width>
+void RS::MeshBVH<Width>::QuerySphere(const float center[3], float radius, std::vector<uint32>& triangles) const
+{
+	const std::span<const uint32> order = m_BVH.GetPrimitiveIndices();
+	m_BVH.Traverse(center, radius, [&](uint32 first, uint32 count)
+		{
+			for (uint32 i = first; i < first + count; ++i)
+			{
+				if (IntersectsSphere(m_Triangles[i].p0, m_Triangles[i].p1, m_Triangles[i].p2, center, radius))
+					triangles.push_back(order[i]);
+			}
+			return false;
+		});
+}
+
+template<uint32 Width>
+bool RS::MeshBVH<Width>::IntersectRay(const float p0[3], const float p1[3], const float p2[3], const Ray& ray, float tMax, float& t, float& u, float& v)
+{
+	using namespace _MeshBVHInternal;
+
+	const glm::vec3 origin = glm::make_vec3(ray.origin), direction = glm::make_vec3(ray.direction), corner = glm::make_vec3(p0);
+	const glm::vec3 e1 = glm::make_vec3(p1) - corner;
+	const glm::vec3 e2 = glm::make_vec3(p2) - corner;
+	const glm::vec3 p = glm::cross(direction, e2);
+	const float determinant = glm::dot(e1, p);
+	if (determinant == 0.f || (ray.cullBackFacing && determinant < 0.f))
+		return false;
+
+	const float inverseDeterminant = 1.f / determinant;
+	const glm::vec3 toOrigin = origin - corner;
+	u = glm::dot(toOrigin, p) * inverseDeterminant;
+	if (u < 0.f || u > 1.f)
+		return false;
+
+	const glm::vec3 q = glm::cross(toOrigin, e1);
+	v = glm::dot(direction, q) * inverseDeterminant;
+	if (v < 0.f || u + v > 1.f)
+		return false;
+
+	t = glm::dot(e2, q) * inverseDeterminant;
+	return t >= ray.tMin && t <= tMax;
+}
+
+template<uint32 Width>
+bool RS::MeshBVH<Width>::IntersectsAABB(const float p0[3], const float p1[3], const float p2[3], const AABB& box)
+{
+	using namespace _MeshBVHInternal;
+
+	// Separating axis test: the box axes, the triangle normal and the nine cross products of their edges.
+	for (uint32 axis = 0; axis < 3; ++axis)
+	{
+		if (std::min({ p0[axis], p1[axis], p2[axis] }) > box.max[axis] || std::max({ p0[axis], p1[axis], p2[axis] }) < box.min[axis])
+			return false;
+	}
+
+	const glm::vec3 center = (glm::make_vec3(box.min) + glm::make_vec3(box.max)) * 0.5f;
+	const glm::vec3 halfSize = (glm::make_vec3(box.max) - glm::make_vec3(box.min)) * 0.5f;
+	const glm::vec3 v0 = glm::make_vec3(p0) - center, v1 = glm::make_vec3(p1) - center, v2 = glm::make_vec3(p2) - center;
+
+	auto isSeparating = [&](const glm::vec3& axis)
+	{
+		const float d0 = glm::dot(v0, axis), d1 = glm::dot(v1, axis), d2 = glm::dot(v2, axis);
+		const float radius = halfSize.x * std::abs(axis.x) + halfSize.y * std::abs(axis.y) + halfSize.z * std::abs(axis.z);
+		return std::min({ d0, d1, d2 }) > radius || std::max({ d0, d1, d2 }) < -radius;
+	};
+
+	const glm::vec3 edges[3] = { v1 - v0, v2 - v1, v0 - v2 };
+	if (isSeparating(glm::cross(edges[0], edges[1])))
+		return false;
+
+	const glm::vec3 boxAxes[3] = { glm::vec3(1.f, 0.f, 0.f), glm::vec3(0.f, 1.f, 0.f), glm::vec3(0.f, 0.f, 1.f) };
+	for (const glm::vec3& boxAxis : boxAxes)
+	{
+		for (const glm::vec3& edge : edges)
+		{
+			if (isSeparating(glm::cross(boxAxis, edge)))
+				return false;
+		}
+	}
+	return true;
+}
+
+template<uint32 Width>
+bool RS::MeshBVH<Width>::IntersectsSphere(const float p0[3], const float p1[3], const float p2[3], const float center[3], float radius)
+{
+	using namespace _MeshBVHInternal;
+
+	const glm::vec3 c = glm::make_vec3(center);
+	const glm::vec3 offset = ClosestPointOnTriangle(c, glm::make_vec3(p0), glm::make_vec3(p1), glm::make_vec3(p2)) - c;
+	return glm::dot(offset, offset) <= radius * radius;
+}
+
+template class RS::MeshBVH<4>;
+template class RS::MeshBVH<8>;
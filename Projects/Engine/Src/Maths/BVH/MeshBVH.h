@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Maths/BVH/BVH.h"
+#include "Loaders/openfbx/FBXLoader.h"
+
+namespace RS
+{
+	/*
+	* Triangle BVH of a mesh for ray, box and sphere queries on the CPU, the counterpart of a bottom level acceleration structure.
+	* The triangles are copied in the order of the leaves, the results use the triangle order of the source mesh.
+	*/
+	template<uint32 Width>
+	class MeshBVH
+	{
+	public:
+		/*
+		* Empty indices means the vertices are a triangle list.
+		*/
+		void Build(std::span<const uint32> indices, std::span<const Vertex> vertices, const BVHBuildSettings& settings = BVHBuildSettings());
+
+		/*
+		* The vertices moved but the triangles are the same, see BVH::Refit.
+		*/
+		void Refit(std::span<const Vertex> vertices);
+
+		// Closest hit between ray.tMin and min(ray.tMax, hit.t). Both sides of a triangle are hit unless ray.cullBackFacing is set.
+		bool Intersect(const Ray& ray, RayHit& hit) const;
+		// Any hit between ray.tMin and ray.tMax, for shadow and occlusion rays.
+		bool IsOccluded(const Ray& ray) const;
+
+		// Appends every triangle that touches the box.
+		void QueryAABB(const AABB& box, std::vector<uint32>& triangles) const;
+		// Appends every triangle that touches the sphere.
+		void QuerySphere(const float center[3], float radius, std::vector<uint32>& triangles) const;
+
+		// Moller-Trumbore, a hit between ray.tMin and tMax.
+		static bool IntersectRay(const float p0[3], const float p1[3], const float p2[3], const Ray& ray, float tMax, float& t, float& u, float& v);
+		static bool IntersectsAABB(const float p0[3], const float p1[3], const float p2[3], const AABB& box);
+		static bool IntersectsSphere(const float p0[3], const float p1[3], const float p2[3], const float center[3], float radius);
+
+		uint32 GetTriangleCount() const { return (uint32)m_Triangles.size(); }
+		const AABB& GetBounds() const { return m_BVH.GetBounds(); }
+		const BVH<Width>& GetBVH() const { return m_BVH; }
+
+	private:
+		struct Triangle
+		{
+			float p0[3];
+			float p1[3];
+			float p2[3];
+		};
+
+		// In the order of the source mesh.
+		std::vector<AABB> GetTriangleBounds(std::span<const Vertex> vertices) const;
+		void SetTriangles(std::span<const Vertex> vertices);
+
+		BVH<Width> m_BVH;
+		std::vector<Triangle> m_Triangles;	// In leaf order.
+		std::vector<uint32> m_Indices;		// Three per triangle, in the order of the source mesh.
+	};
+}
@@ -0,0 +1,174 @@
+#include "PreCompiled.h"
+#include "SceneBVH.h"
+
+#include <cmath>
+
+namespace RS::_SceneBVHInternal
+{
+	bool InvertTransform(const float m[3][4], float result[3][4])
+	{
+		const float c00 = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+		const float c01 = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+		const float c02 = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+		const float determinant = m[0][0] * c00 + m[0][1] * c01 + m[0][2] * c02;
+		const float inverseDeterminant = 1.f / determinant;
+		if (determinant == 0.f || !std::isfinite(inverseDeterminant))
+			return false;
+
+		result[0][0] = c00 * inverseDeterminant;
+		result[0][1] = (m[0][2] * m[2][1] - m[0][1] * m[2][2]) * inverseDeterminant;
+		result[0][2] = (m[0][1] * m[1][2] - m[0][2] * m[1][1]) * inverseDeterminant;
+		result[1][0] = c01 * inverseDeterminant;
+		result[1][1] = (m[0][0] * m[2][2] - m[0][2] * m[2][0]) * inverseDeterminant;
+		result[1][2] = (m[0][2] * m[1][0] - m[0][0] * m[1][2]) * inverseDeterminant;
+		result[2][0] = c02 * inverseDeterminant;
+		result[2][1] = (m[0][1] * m[2][0] - m[0][0] * m[2][1]) * inverseDeterminant;
+		result[2][2] = (m[0][0] * m[1][1] - m[0][1] * m[1][0]) * inverseDeterminant;
+		for (uint32 row = 0; row < 3; ++row)
+			result[row][3] = -(result[row][0] * m[0][3] + result[row][1] * m[1][3] + result[row][2] * m[2][3]);
+		return true;
+	}
+
+	// Arvo's method, the bounds of the transformed box.
+	AABB TransformBounds(const AABB& bounds, const float transform[3][4])
+	{
+		AABB result;
+		for (uint32 row = 0; row < 3; ++row)
+		{
+			result.min[row] = result.max[row] = transform[row][3];
+			for (uint32 column = 0; column < 3; ++column)
+			{
+				const float a = transform[row][column] * bounds.min[column];
+				const float b = transform[row][column] * bounds.max[column];
+				result.min[row] += std::min(a, b);
+				result.max[row] += std::max(a, b);
+			}
+		}
+		return result;
+	}
+
+	bool OverlapsSphere(const AABB& bounds, const float center[3], float radius)
+	{
+		float distanceSquared = 0.f;
+		for (uint32 i = 0; i < 3; ++i)
+		{
+			const float d = std::max({ bounds.min[i] - center[i], center[i] - bounds.max[i], 0.f });
+			distanceSquared += d * d;
+		}
+		return distanceSquared <= radius * radius;
+	}
+}
+
+template<uint32 Width>
+void RS::SceneBVH<Width>::Build(std::span<const BVHInstance<Width>> instances, const BVHBuildSettings& settings)
+{
+	using namespace _SceneBVHInternal;
+
+	std::vector<Instance> validInstances;
+	std::vector<AABB> bounds;
+	validInstances.reserve(instances.size());
+	bounds.reserve(instances.size());
+	for (const BVHInstance<Width>& instance : instances)
+	{
+		Instance result;
+		if (!instance.pMesh || instance.pMesh->GetTriangleCount() == 0 || !InvertTransform(instance.transform, result.worldToObject))
+			continue;
+
+		result.pMesh = instance.pMesh;
+		result.worldBounds = TransformBounds(instance.pMesh->GetBounds(), instance.transform);
+		result.instanceID = instance.instanceID;
+		validInstances.push_back(result);
+		bounds.push_back(result.worldBounds);
+	}
+
+	m_BVH.Build(bounds, settings);
+	const std::span<const uint32> order = m_BVH.GetPrimitiveIndices();
+	m_Instances.resize(order.size());
+	for (uint64 i = 0; i < order.size(); ++i)
+		m_Instances[i] = validInstances[order[i]];
+}
+
+template<uint32 Width>
+RS::Ray RS::SceneBVH<Width>::ToObjectSpace(const Instance& instance, const Ray& ray) const
+{
+	// Not normalized, so t is the same in both spaces.
+	Ray result = ray;
+	const float (&m)[3][4] = instance.worldToObject;
+	for (uint32 row = 0; row < 3; ++row)
+	{
+		result.origin[row] = m[row][0] * ray.origin[0] + m[row][1] * ray.origin[1] + m[row][2] * ray.origin[2] + m[row][3];
+		result.direction[row] = m[row][0] * ray.direction[0] + m[row][1] * ray.direction[1] + m[row][2] * ray.direction[2];
+	}
+	return result;
+}
+
+template<uint32 Width>
+bool RS::SceneBVH<Width>::Intersect(const Ray& ray, RayHit& hit) const
+{
+	float tMax = std::min(ray.tMax, hit.t);
+	bool isHit = false;
+	m_BVH.Traverse(ray, tMax, [&](uint32 first, uint32 count)
+		{
+			for (uint32 i = first; i < first + count; ++i)
+			{
+				Ray objectRay = ToObjectSpace(m_Instances[i], ray);
+				objectRay.tMax = tMax;
+				RayHit objectHit;
+				if (m_Instances[i].pMesh->Intersect(objectRay, objectHit))
+				{
+					tMax = objectHit.t;
+					hit = objectHit;
+					hit.instance = m_Instances[i].instanceID;
+					isHit = true;
+				}
+			}
+			return false;
+		});
+	return isHit;
+}
+
+template<uint32 Width>
+bool RS::SceneBVH<Width>::IsOccluded(const Ray& ray) const
+{
+	float tMax = ray.tMax;
+	bool isHit = false;
+	m_BVH.Traverse(ray, tMax, [&](uint32 first, uint32 count)
+		{
+			for (uint32 i = first; i < first + count && !isHit; ++i)
+				isHit = m_Instances[i].pMesh->IsOccluded(ToObjectSpace(m_Instances[i], ray));
+			return isHit;
+		});
+	return isHit;
+}
+
+template<uint32 Width>
+void RS::SceneBVH<Width>::QueryAABB(const AABB& box, std::vector<uint32>& instanceIDs) const
+{
+	m_BVH.Traverse(box, [&](uint32 first, uint32 count)
+		{
+			for (uint32 i = first; i < first + count; ++i)
+			{
+				if (m_Instances[i].worldBounds.Overlaps(box))
+					instanceIDs.push_back(m_Instances[i].instanceID);
+			}
+			return false;
+		});
+}
+
+template<uint32 Width>
+void RS::SceneBVH<Width>::QuerySphere(const float center[3], float radius, std::vector<uint32>& instanceIDs) const
+{
+	using namespace _SceneBVHInternal;
+	m_BVH.Traverse(center, radius, [&](uint32 first, uint32 count)
+		{
+			for (uint32 i = first; i < first + count; ++i)
+			{
+				if (OverlapsSphere(m_Instances[i].worldBounds, center, radius))
+					instanceIDs.push_back(m_Instances[i].instanceID);
+			}
+			return false;
+		});
+}
+
+template class RS::SceneBVH<4>;
+template class RS::SceneBVH<8>;
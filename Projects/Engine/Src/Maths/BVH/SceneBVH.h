@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Maths/BVH/MeshBVH.h"
+
+namespace RS
+{
+	template<uint32 Width>
+	struct BVHInstance
+	{
+		const MeshBVH<Width>* pMesh = nullptr;
+		// Object to world, row major 3x4 like D3D12_RAYTRACING_INSTANCE_DESC::Transform.
+		float transform[3][4] = { { 1.f, 0.f, 0.f, 0.f }, { 0.f, 1.f, 0.f, 0.f }, { 0.f, 0.f, 1.f, 0.f } };
+		uint32 instanceID = 0;
+	};
+
+	/*
+	* BVH over transformed MeshBVHs, the counterpart of a top level acceleration structure. Building it is cheap, so scenes
+	* where instances move rebuild it every frame like a TLAS, while the meshes keep their BVHs.
+	*/
+	template<uint32 Width>
+	class SceneBVH
+	{
+	public:
+		/*
+		* Instances without a mesh, with an empty mesh or with a transform that cannot be inverted are left out.
+		* The meshes must outlive the scene. Testing an instance costs a lot more than a node, so the leaves hold one by default.
+		*/
+		void Build(std::span<const BVHInstance<Width>> instances, const BVHBuildSettings& settings = { .maxLeafSize = 1 });
+
+		// Closest hit, hit.instance gets the instance ID and t is in lengths of the world space direction.
+		bool Intersect(const Ray& ray, RayHit& hit) const;
+		bool IsOccluded(const Ray& ray) const;
+
+		// Appends the IDs of the instances whose world bounds touch the box or the sphere.
+		void QueryAABB(const AABB& box, std::vector<uint32>& instanceIDs) const;
+		void QuerySphere(const float center[3], float radius, std::vector<uint32>& instanceIDs) const;
+
+		uint32 GetInstanceCount() const { return (uint32)m_Instances.size(); }
+		const AABB& GetBounds() const { return m_BVH.GetBounds(); }
+
+	private:
+		struct Instance
+		{
+			const MeshBVH<Width>* pMesh;
+			float worldToObject[3][4];
+			AABB worldBounds;
+			uint32 instanceID;
+		};
+
+		Ray ToObjectSpace(const Instance& instance, const Ray& ray) const;
+
+		BVH<Width> m_BVH;
+		std::vector<Instance> m_Instances;	// In leaf order.
+	};
+}
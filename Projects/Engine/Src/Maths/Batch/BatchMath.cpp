@@ -0,0 +1,92 @@
+#include "PreCompiled.h"
+#include "BatchMath.h"
+#include "BatchMathKernels.h"
+
+#include "Utils/Misc/SIMDUtils.h"
+
+namespace RS::_BatchMathInternal
+{
+	// This translation unit is built for the x64 baseline, so it has the kernels every CPU can run.
+	constexpr KernelTable g_KernelsScalar = MakeKernelTable<1>();
+	constexpr KernelTable g_KernelsSSE = MakeKernelTable<4>();
+
+	const KernelTable* GetKernels(uint32 width)
+	{
+		const Utils::CPUFeatures& features = Utils::GetCPUFeatures();
+		switch (width)
+		{
+		case 1: return &g_KernelsScalar;
+		case 4: return &g_KernelsSSE;
+		case 8: return features.avx2 ? &g_KernelsAVX2 : nullptr;
+		case 16: return features.avx512 ? &g_KernelsAVX512 : nullptr;
+		default: return nullptr;
+		}
+	}
+
+	const KernelTable* GetWidestKernels()
+	{
+		for (uint32 width : { 16u, 8u, 4u })
+		{
+			if (const KernelTable* pKernels = GetKernels(width))
+				return pKernels;
+		}
+		return &g_KernelsScalar;
+	}
+
+	const KernelTable*& GetActiveKernels()
+	{
+		static const KernelTable* s_pKernels = GetWidestKernels();
+		return s_pKernels;
+	}
+
+	void CheckPlanes(std::span<const Batch::Plane> planes)
+	{
+		RS_ASSERT(!planes.empty(), "Culling needs at least one plane!");
+	}
+}
+
+void RS::Batch::ComposeTransforms(const TransformsSoA& transforms, uint64 count, void* pMatrices, uint64 stride)
+{
+	RS_ASSERT(stride >= 16 * sizeof(float), "The matrices overlap, the stride has to be at least 64 bytes!");
+	_BatchMathInternal::GetActiveKernels()->pComposeTransforms(transforms, count, (uint8*)pMatrices, stride);
+}
+
+uint64 RS::Batch::CullPoints(std::span<const Plane> planes, const BoundsSoA& points, uint64 count, uint32* pVisible)
+{
+	_BatchMathInternal::CheckPlanes(planes);
+	return _BatchMathInternal::GetActiveKernels()->pCullPoints(planes, points, count, pVisible);
+}
+
+uint64 RS::Batch::CullSpheres(std::span<const Plane> planes, const BoundsSoA& spheres, uint64 count, uint32* pVisible)
+{
+	_BatchMathInternal::CheckPlanes(planes);
+	RS_ASSERT(spheres.pRadius, "Spheres need radii!");
+	return _BatchMathInternal::GetActiveKernels()->pCullSpheres(planes, spheres, count, pVisible);
+}
+
+uint64 RS::Batch::CullAABBs(std::span<const Plane> planes, const BoundsSoA& boxes, uint64 count, uint32* pVisible)
+{
+	_BatchMathInternal::CheckPlanes(planes);
+	RS_ASSERT(boxes.pExtentX && boxes.pExtentY && boxes.pExtentZ, "Boxes need extents!");
+	return _BatchMathInternal::GetActiveKernels()->pCullAABBs(planes, boxes, count, pVisible);
+}
+
+void RS::Batch::Integrate(const BodiesSoA& bodies, uint64 count, float dt, const IntegrateSettings& settings)
+{
+	RS_ASSERT((bodies.pPositionZ == nullptr) == (bodies.pVelocityZ == nullptr), "Bodies need both a position and a velocity in z, or neither!");
+	_BatchMathInternal::GetActiveKernels()->pIntegrate(bodies, count, dt, settings);
+}
+
+uint32 RS::Batch::GetLaneWidth()
+{
+	return _BatchMathInternal::GetActiveKernels()->width;
+}
+
+bool RS::Batch::SetLaneWidth(uint32 width)
+{
+	const _BatchMathInternal::KernelTable* pKernels = width == 0 ? _BatchMathInternal::GetWidestKernels() : _BatchMathInternal::GetKernels(width);
+	if (!pKernels)
+		return false;
+	_BatchMathInternal::GetActiveKernels() = pKernels;
+	return true;
+}
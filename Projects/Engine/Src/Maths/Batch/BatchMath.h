@@ -0,0 +1,96 @@
+#pragma once
+
+#include <span>
+
+/*
+* Kernels that update and test thousands of objects stored as structures of arrays, one array per component.
+* They are written once for any lane width, see BatchMathKernels.h, and the widest one the CPU supports is picked
+* at runtime: 16 lanes with AVX-512, 8 with AVX2 and 4 with SSE. The objects that do not fill a group of lanes go
+* through the same kernel one at a time.
+*/
+namespace RS::Batch
+{
+	// A point is on the inside when dot(normal, point) + distance >= 0.
+	struct Plane
+	{
+		float normal[3];
+		float distance;
+
+		static Plane FromPointNormal(const float point[3], const float normal[3])
+		{
+			return { { normal[0], normal[1], normal[2] }, -(normal[0] * point[0] + normal[1] * point[1] + normal[2] * point[2]) };
+		}
+	};
+
+	// Rotations are unit quaternions.
+	struct TransformsSoA
+	{
+		const float* pPositionX;
+		const float* pPositionY;
+		const float* pPositionZ;
+		const float* pRotationX;
+		const float* pRotationY;
+		const float* pRotationZ;
+		const float* pRotationW;
+		const float* pScaleX;
+		const float* pScaleY;
+		const float* pScaleZ;
+	};
+
+	// Points and sphere centers, or the centers and half extents of boxes.
+	struct BoundsSoA
+	{
+		const float* pX;
+		const float* pY;
+		const float* pZ;
+		const float* pRadius = nullptr;
+		const float* pExtentX = nullptr;
+		const float* pExtentY = nullptr;
+		const float* pExtentZ = nullptr;
+	};
+
+	// 2D when the z arrays are null.
+	struct BodiesSoA
+	{
+		float* pPositionX;
+		float* pPositionY;
+		float* pPositionZ = nullptr;
+		float* pVelocityX;
+		float* pVelocityY;
+		float* pVelocityZ = nullptr;
+		const float* pFriction;		// Fraction of the velocity lost per second.
+	};
+
+	struct IntegrateSettings
+	{
+		float stopSpeedSquared = 0.005f;	// Bodies with friction that are slower than this stop.
+	};
+
+	/*
+	* Writes translation * rotation * scale as a row major 4x4 matrix for every transform, stride bytes apart,
+	* so they can go straight into instance data.
+	*/
+	void ComposeTransforms(const TransformsSoA& transforms, uint64 count, void* pMatrices, uint64 stride = 16 * sizeof(float));
+
+	/*
+	* Culling against a set of planes, usually the six of a frustum. The indices of the objects inside or touching all of
+	* them are written to pVisible in order, which needs room for count indices. Returns the number of visible objects.
+	*/
+	uint64 CullPoints(std::span<const Plane> planes, const BoundsSoA& points, uint64 count, uint32* pVisible);
+	uint64 CullSpheres(std::span<const Plane> planes, const BoundsSoA& spheres, uint64 count, uint32* pVisible);
+	uint64 CullAABBs(std::span<const Plane> planes, const BoundsSoA& boxes, uint64 count, uint32* pVisible);
+
+	/*
+	* Moves the bodies by their velocity, then slows down the ones with friction.
+	*/
+	void Integrate(const BodiesSoA& bodies, uint64 count, float dt, const IntegrateSettings& settings = IntegrateSettings());
+
+	// Lanes of the kernels that are used.
+	uint32 GetLaneWidth();
+
+	/*
+	* Makes the kernels use 1, 4, 8 or 16 lanes, for tests and benchmarks. Returns false if the CPU does not support it.
+	* Zero goes back to the widest. Not thread safe.
+	*/
+	bool SetLaneWidth(uint32 width);
+}
@@ -0,0 +1,9 @@
+#include "PreCompiled.h"
+#include "BatchMathKernels.h"
+
+// Built with /arch:AVX2, see the Engine premake5.lua. Only called when Utils::GetCPUFeatures() reports AVX2.
+#if !defined(__AVX2__)
+#error "BatchMathAVX2.cpp has to be built with AVX2 enabled!"
+#endif
+
+const RS::_BatchMathInternal::KernelTable RS::_BatchMathInternal::g_KernelsAVX2 = RS::_BatchMathInternal::MakeKernelTable<8>();
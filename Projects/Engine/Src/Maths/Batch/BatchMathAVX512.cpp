@@ -0,0 +1,9 @@
+#include "PreCompiled.h"
+#include "BatchMathKernels.h"
+
+// Built with /arch:AVX512, see the Engine premake5.lua. Only called when Utils::GetCPUFeatures() reports AVX-512.
+#if !defined(__AVX512F__)
+#error "BatchMathAVX512.cpp has to be built with AVX-512 enabled!"
+#endif
+
+const RS::_BatchMathInternal::KernelTable RS::_BatchMathInternal::g_KernelsAVX512 = RS::_BatchMathInternal::MakeKernelTable<16>();
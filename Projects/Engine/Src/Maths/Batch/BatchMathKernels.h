@@ -0,0 +1,337 @@
+#pragma once
+
+#include "Maths/Batch/BatchMath.h"
+
+#include <cfloat>
+#include <emmintrin.h>
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+/*
+* Only included by the BatchMath translation units, which are each built for their own instruction set. Everything
+* in the header is in an anonymous namespace so the inline functions of a wider instruction set never replace the
+* ones of a narrower translation unit when linking.
+*/
+namespace RS::_BatchMathInternal
+{
+	struct KernelTable
+	{
+		uint32 width;
+		void (*pComposeTransforms)(const Batch::TransformsSoA& transforms, uint64 count, uint8* pMatrices, uint64 stride);
+		uint64 (*pCullPoints)(std::span<const Batch::Plane> planes, const Batch::BoundsSoA& bounds, uint64 count, uint32* pVisible);
+		uint64 (*pCullSpheres)(std::span<const Batch::Plane> planes, const Batch::BoundsSoA& bounds, uint64 count, uint32* pVisible);
+		uint64 (*pCullAABBs)(std::span<const Batch::Plane> planes, const Batch::BoundsSoA& bounds, uint64 count, uint32* pVisible);
+		void (*pIntegrate)(const Batch::BodiesSoA& bodies, uint64 count, float dt, const Batch::IntegrateSettings& settings);
+	};
+
+	// Defined in BatchMathAVX2.cpp and BatchMathAVX512.cpp.
+	extern const KernelTable g_KernelsAVX2;
+	extern const KernelTable g_KernelsAVX512;
+
+	namespace
+	{
+		/*
+		* Width floats processed together. Masks hold one result per lane, Bits packs them with the first lane in bit 0.
+		*/
+		template<uint32 Width>
+		struct Lanes;
+
+		template<>
+		struct Lanes<1>
+		{
+			using Mask = bool;
+			float value;
+
+			static Lanes Load(const float* pData) { return { *pData }; }
+			static Lanes Set(float scalar) { return { scalar }; }
+			void Store(float* pData) const { *pData = value; }
+
+			static Mask True() { return true; }
+			static Mask And(Mask a, Mask b) { return a && b; }
+			static Mask GreaterEqual(Lanes a, Lanes b) { return a.value >= b.value; }
+			static Mask Greater(Lanes a, Lanes b) { return a.value > b.value; }
+			static Lanes Select(Mask mask, Lanes a, Lanes b) { return mask ? a : b; }
+			static uint32 Bits(Mask mask) { return mask ? 1u : 0u; }
+
+			friend Lanes operator+(Lanes a, Lanes b) { return { a.value + b.value }; }
+			friend Lanes operator-(Lanes a, Lanes b) { return { a.value - b.value }; }
+			friend Lanes operator*(Lanes a, Lanes b) { return { a.value * b.value }; }
+		};
+
+		template<>
+		struct Lanes<4>
+		{
+			using Mask = __m128;
+			__m128 value;
+
+			static Lanes Load(const float* pData) { return { _mm_loadu_ps(pData) }; }
+			static Lanes Set(float scalar) { return { _mm_set1_ps(scalar) }; }
+			void Store(float* pData) const { _mm_storeu_ps(pData, value); }
+
+			static Mask True() { return _mm_castsi128_ps(_mm_set1_epi32(-1)); }
+			static Mask And(Mask a, Mask b) { return _mm_and_ps(a, b); }
+			static Mask GreaterEqual(Lanes a, Lanes b) { return _mm_cmpge_ps(a.value, b.value); }
+			static Mask Greater(Lanes a, Lanes b) { return _mm_cmpgt_ps(a.value, b.value); }
+			static Lanes Select(Mask mask, Lanes a, Lanes b) { return { _mm_or_ps(_mm_and_ps(mask, a.value), _mm_andnot_ps(mask, b.value)) }; }
+			static uint32 Bits(Mask mask) { return (uint32)_mm_movemask_ps(mask); }
+
+			friend Lanes operator+(Lanes a, Lanes b) { return { _mm_add_ps(a.value, b.value) }; }
+			friend Lanes operator-(Lanes a, Lanes b) { return { _mm_sub_ps(a.value, b.value) }; }
+			friend Lanes operator*(Lanes a, Lanes b) { return { _mm_mul_ps(a.value, b.value) }; }
+		};
+
+#if defined(__AVX2__)
+		template<>
+		struct Lanes<8>
+		{
+			using Mask = __m256;
+			__m256 value;
+
+			static Lanes Load(const float* pData) { return { _mm256_loadu_ps(pData) }; }
+			static Lanes Set(float scalar) { return { _mm256_set1_ps(scalar) }; }
+			void Store(float* pData) const { _mm256_storeu_ps(pData, value); }
+
+			static Mask True() { return _mm256_castsi256_ps(_mm256_set1_epi32(-1)); }
+			static Mask And(Mask a, Mask b) { return _mm256_and_ps(a, b); }
+			static Mask GreaterEqual(Lanes a, Lanes b) { return _mm256_cmp_ps(a.value, b.value, _CMP_GE_OQ); }
+			static Mask Greater(Lanes a, Lanes b) { return _mm256_cmp_ps(a.value, b.value, _CMP_GT_OQ); }
+			static Lanes Select(Mask mask, Lanes a, Lanes b) { return { _mm256_blendv_ps(b.value, a.value, mask) }; }
+			static uint32 Bits(Mask mask) { return (uint32)_mm256_movemask_ps(mask); }
+
+			friend Lanes operator+(Lanes a, Lanes b) { return { _mm256_add_ps(a.value, b.value) }; }
+			friend Lanes operator-(Lanes a, Lanes b) { return { _mm256_sub_ps(a.value, b.value) }; }
+			friend Lanes operator*(Lanes a, Lanes b) { return { _mm256_mul_ps(a.value, b.value) }; }
+		};
+#endif
+
+#if defined(__AVX512F__)
+		template<>
+		struct Lanes<16>
+		{
+			using Mask = __mmask16;
+			__m512 value;
+
+			static Lanes Load(const float* pData) { return { _mm512_loadu_ps(pData) }; }
+			static Lanes Set(float scalar) { return { _mm512_set1_ps(scalar) }; }
+			void Store(float* pData) const { _mm512_storeu_ps(pData, value); }
+
+			static Mask True() { return (Mask)0xFFFF; }
+			static Mask And(Mask a, Mask b) { return (Mask)(a & b); }
+			static Mask GreaterEqual(Lanes a, Lanes b) { return _mm512_cmp_ps_mask(a.value, b.value, _CMP_GE_OQ); }
+			static Mask Greater(Lanes a, Lanes b) { return _mm512_cmp_ps_mask(a.value, b.value, _CMP_GT_OQ); }
+			static Lanes Select(Mask mask, Lanes a, Lanes b) { return { _mm512_mask_blend_ps(mask, b.value, a.value) }; }
+			static uint32 Bits(Mask mask) { return (uint32)mask; }
+
+			friend Lanes operator+(Lanes a, Lanes b) { return { _mm512_add_ps(a.value, b.value) }; }
+			friend Lanes operator-(Lanes a, Lanes b) { return { _mm512_sub_ps(a.value, b.value) }; }
+			friend Lanes operator*(Lanes a, Lanes b) { return { _mm512_mul_ps(a.value, b.value) }; }
+		};
+#endif
+
+		template<uint32 Width>
+		void ComposeTransformsGroup(const Batch::TransformsSoA& in, uint64 first, uint8* pMatrices, uint64 stride)
+		{
+			using L = Lanes<Width>;
+
+			const L qx = L::Load(in.pRotationX + first);
+			const L qy = L::Load(in.pRotationY + first);
+			const L qz = L::Load(in.pRotationZ + first);
+			const L qw = L::Load(in.pRotationW + first);
+			const L sx = L::Load(in.pScaleX + first);
+			const L sy = L::Load(in.pScaleY + first);
+			const L sz = L::Load(in.pScaleZ + first);
+			const L one = L::Set(1.f);
+
+			const L x2 = qx + qx;
+			const L y2 = qy + qy;
+			const L z2 = qz + qz;
+			const L xx = qx * x2;
+			const L yy = qy * y2;
+			const L zz = qz * z2;
+			const L xy = qx * y2;
+			const L xz = qx * z2;
+			const L yz = qy * z2;
+			const L wx = qw * x2;
+			const L wy = qw * y2;
+			const L wz = qw * z2;
+
+			// The top three rows of the matrices, row by row, then scattered to the matrices lane by lane.
+			float rows[12][Width];
+			(((one - (yy + zz)) * sx)).Store(rows[0]);
+			((xy - wz) * sy).Store(rows[1]);
+			((xz + wy) * sz).Store(rows[2]);
+			L::Load(in.pPositionX + first).Store(rows[3]);
+			((xy + wz) * sx).Store(rows[4]);
+			((one - (xx + zz)) * sy).Store(rows[5]);
+			((yz - wx) * sz).Store(rows[6]);
+			L::Load(in.pPositionY + first).Store(rows[7]);
+			((xz - wy) * sx).Store(rows[8]);
+			((yz + wx) * sy).Store(rows[9]);
+			((one - (xx + yy)) * sz).Store(rows[10]);
+			L::Load(in.pPositionZ + first).Store(rows[11]);
+
+			for (uint32 lane = 0; lane < Width; ++lane)
+			{
+				float* pMatrix = (float*)(pMatrices + (first + lane) * stride);
+				for (uint32 element = 0; element < 12; ++element)
+					pMatrix[element] = rows[element][lane];
+				pMatrix[12] = 0.f;
+				pMatrix[13] = 0.f;
+				pMatrix[14] = 0.f;
+				pMatrix[15] = 1.f;
+			}
+		}
+
+		template<uint32 Width>
+		void ComposeTransforms(const Batch::TransformsSoA& transforms, uint64 count, uint8* pMatrices, uint64 stride)
+		{
+			uint64 i = 0;
+			for (; i + Width <= count; i += Width)
+				ComposeTransformsGroup<Width>(transforms, i, pMatrices, stride);
+			for (; i < count; ++i)
+				ComposeTransformsGroup<1>(transforms, i, pMatrices, stride);
+		}
+
+		enum class CullShape
+		{
+			Point,
+			Sphere,
+			AABB
+		};
+
+		// Bits of the objects in the group that are inside all planes.
+		template<uint32 Width, CullShape Shape>
+		uint32 CullGroup(std::span<const Batch::Plane> planes, const Batch::BoundsSoA& bounds, uint64 first)
+		{
+			using L = Lanes<Width>;
+
+			const L x = L::Load(bounds.pX + first);
+			const L y = L::Load(bounds.pY + first);
+			const L z = L::Load(bounds.pZ + first);
+			L radius = L::Set(0.f);
+			L ex = L::Set(0.f);
+			L ey = L::Set(0.f);
+			L ez = L::Set(0.f);
+			if constexpr (Shape == CullShape::Sphere)
+			{
+				radius = L::Load(bounds.pRadius + first);
+			}
+			else if constexpr (Shape == CullShape::AABB)
+			{
+				ex = L::Load(bounds.pExtentX + first);
+				ey = L::Load(bounds.pExtentY + first);
+				ez = L::Load(bounds.pExtentZ + first);
+			}
+
+			const L zero = L::Set(0.f);
+			typename L::Mask inside = L::True();
+			for (const Batch::Plane& plane : planes)
+			{
+				L distance = L::Set(plane.normal[0]) * x + L::Set(plane.normal[1]) * y + L::Set(plane.normal[2]) * z + L::Set(plane.distance);
+				if constexpr (Shape == CullShape::Sphere)
+				{
+					distance = distance + radius;
+				}
+				else if constexpr (Shape == CullShape::AABB)
+				{
+					// How far the box reaches towards the plane normal from its center.
+					auto Abs = [](float value) { return value < 0.f ? -value : value; };
+					distance = distance + L::Set(Abs(plane.normal[0])) * ex + L::Set(Abs(plane.normal[1])) * ey + L::Set(Abs(plane.normal[2])) * ez;
+				}
+				inside = L::And(inside, L::GreaterEqual(distance, zero));
+			}
+			return L::Bits(inside);
+		}
+
+		template<uint32 Width, CullShape Shape>
+		uint64 Cull(std::span<const Batch::Plane> planes, const Batch::BoundsSoA& bounds, uint64 count, uint32* pVisible)
+		{
+			// Every lane writes its index, only the visible ones move the end forward.
+			uint64 visibleCount = 0;
+			uint64 i = 0;
+			for (; i + Width <= count; i += Width)
+			{
+				const uint32 bits = CullGroup<Width, Shape>(planes, bounds, i);
+				if (bits == 0)
+					continue;
+				for (uint32 lane = 0; lane < Width; ++lane)
+				{
+					pVisible[visibleCount] = (uint32)(i + lane);
+					visibleCount += (bits >> lane) & 1;
+				}
+			}
+			for (; i < count; ++i)
+			{
+				if (CullGroup<1, Shape>(planes, bounds, i))
+					pVisible[visibleCount++] = (uint32)i;
+			}
+			return visibleCount;
+		}
+
+		template<uint32 Width, bool Is3D>
+		void IntegrateGroup(const Batch::BodiesSoA& bodies, uint64 first, float dt, const Batch::IntegrateSettings& settings)
+		{
+			using L = Lanes<Width>;
+
+			const L deltaTime = L::Set(dt);
+			const L zero = L::Set(0.f);
+			const L friction = L::Load(bodies.pFriction + first);
+			const typename L::Mask hasFriction = L::Greater(friction, L::Set(FLT_EPSILON));
+
+			L vx = L::Load(bodies.pVelocityX + first);
+			L vy = L::Load(bodies.pVelocityY + first);
+			L vz = zero;
+			(L::Load(bodies.pPositionX + first) + vx * deltaTime).Store(bodies.pPositionX + first);
+			(L::Load(bodies.pPositionY + first) + vy * deltaTime).Store(bodies.pPositionY + first);
+			L speedSquared = vx * vx + vy * vy;
+			if constexpr (Is3D)
+			{
+				vz = L::Load(bodies.pVelocityZ + first);
+				(L::Load(bodies.pPositionZ + first) + vz * deltaTime).Store(bodies.pPositionZ + first);
+				speedSquared = speedSquared + vz * vz;
+			}
+
+			// Slow bodies stop, the others lose the friction fraction of their velocity per second.
+			const typename L::Mask isMoving = L::Greater(speedSquared, L::Set(settings.stopSpeedSquared));
+			auto Slow = [&](L velocity) { return L::Select(hasFriction, L::Select(isMoving, velocity - velocity * friction * deltaTime, zero), velocity); };
+			Slow(vx).Store(bodies.pVelocityX + first);
+			Slow(vy).Store(bodies.pVelocityY + first);
+			if constexpr (Is3D)
+				Slow(vz).Store(bodies.pVelocityZ + first);
+		}
+
+		template<uint32 Width, bool Is3D>
+		void IntegrateBodies(const Batch::BodiesSoA& bodies, uint64 count, float dt, const Batch::IntegrateSettings& settings)
+		{
+			uint64 i = 0;
+			for (; i + Width <= count; i += Width)
+				IntegrateGroup<Width, Is3D>(bodies, i, dt, settings);
+			for (; i < count; ++i)
+				IntegrateGroup<1, Is3D>(bodies, i, dt, settings);
+		}
+
+		template<uint32 Width>
+		void Integrate(const Batch::BodiesSoA& bodies, uint64 count, float dt, const Batch::IntegrateSettings& settings)
+		{
+			if (bodies.pPositionZ)
+				IntegrateBodies<Width, true>(bodies, count, dt, settings);
+			else
+				IntegrateBodies<Width, false>(bodies, count, dt, settings);
+		}
+
+		template<uint32 Width>
+		constexpr KernelTable MakeKernelTable()
+		{
+			return KernelTable
+			{
+				Width,
+				&ComposeTransforms<Width>,
+				&Cull<Width, CullShape::Point>,
+				&Cull<Width, CullShape::Sphere>,
+				&Cull<Width, CullShape::AABB>,
+				&Integrate<Width>
+			};
+		}
+	}
+}
@@ -0,0 +1,243 @@
+#include "PreCompiled.h"
+#include "Broadphase2D.h"
+
+#include "Core/ThreadPool.h"
+
+#include <algorithm>
+
+namespace RS::_Broadphase2DInternal
+{
+	// Proxies per job when building and finding pairs.
+	constexpr uint32 BlockSize = 4096;
+	// Buckets are filled by this many jobs, each job takes the buckets with the same remainder.
+	constexpr uint32 StripeCount = 64;
+	// Queries per job in a batch.
+	constexpr uint32 QueryBlockSize = 64;
+}
+
+RS::Broadphase2D::Broadphase2D(uint32 bucketCount)
+	: m_Buckets(bucketCount)
+{
+}
+
+uint32 RS::Broadphase2D::Insert(const AABB2D& bounds)
+{
+	uint32 proxy = 0;
+	if (m_FreeProxies.empty())
+	{
+		proxy = (uint32)m_Keys.size();
+		m_Keys.push_back(InvalidKey);
+		m_Bounds.push_back(bounds);
+	}
+	else
+	{
+		proxy = m_FreeProxies.back();
+		m_FreeProxies.pop_back();
+		m_Bounds[proxy] = bounds;
+	}
+
+	m_Keys[proxy] = ComputeKey(bounds);
+	AddToBuckets(proxy);
+	++m_ProxyCount;
+	return proxy;
+}
+
+void RS::Broadphase2D::Update(uint32 proxy, const AABB2D& bounds)
+{
+	RS_ASSERT(IsValid(proxy), "Proxy {} is not in the broadphase!", proxy);
+
+	m_Bounds[proxy] = bounds;
+	if (ComputeKey(bounds) != m_Keys[proxy])
+	{
+		std::lock_guard<std::mutex> lock(m_MovedProxiesMutex);
+		m_MovedProxies.push_back(proxy);
+	}
+}
+
+void RS::Broadphase2D::CommitUpdates()
+{
+	// Sorted, so the order in the buckets does not depend on which thread updated first.
+	std::sort(m_MovedProxies.begin(), m_MovedProxies.end());
+	m_MovedProxies.erase(std::unique(m_MovedProxies.begin(), m_MovedProxies.end()), m_MovedProxies.end());
+
+	for (uint32 proxy : m_MovedProxies)
+	{
+		// It might have been removed, or moved back, since it was updated.
+		if (!IsValid(proxy))
+			continue;
+
+		const uint64 key = ComputeKey(m_Bounds[proxy]);
+		if (key == m_Keys[proxy])
+			continue;
+
+		RemoveFromBuckets(proxy);
+		m_Keys[proxy] = key;
+		AddToBuckets(proxy);
+	}
+	m_MovedProxies.clear();
+}
+
+void RS::Broadphase2D::Remove(uint32 proxy)
+{
+	RS_ASSERT(IsValid(proxy), "Proxy {} is not in the broadphase!", proxy);
+
+	RemoveFromBuckets(proxy);
+	m_Keys[proxy] = InvalidKey;
+	m_FreeProxies.push_back(proxy);
+	--m_ProxyCount;
+}
+
+void RS::Broadphase2D::Build(std::span<const AABB2D> bounds, uint maxThreads)
+{
+	using namespace _Broadphase2DInternal;
+
+	Clear();
+
+	const uint32 count = (uint32)bounds.size();
+	m_Bounds.assign(bounds.begin(), bounds.end());
+	m_Keys.resize(count);
+	m_ProxyCount = count;
+
+	// Every block sorts its entries by the stripe of their bucket, then every stripe appends the entries of all blocks
+	// in block order. No two jobs write to the same bucket, and the buckets end up sorted by proxy.
+	struct Entry
+	{
+		uint32 bucket;
+		uint32 proxy;
+	};
+	const uint32 blockCount = (count + BlockSize - 1) / BlockSize;
+	std::vector<std::vector<Entry>> entries((uint64)blockCount * StripeCount);
+
+	ThreadPool::Get()->ParallelFor(blockCount, [&](uint64 block)
+		{
+			const uint32 first = (uint32)block * BlockSize;
+			const uint32 last = std::min(first + BlockSize, count);
+			uint32 buckets[MaxBucketsPerProxy];
+			for (uint32 proxy = first; proxy < last; ++proxy)
+			{
+				m_Keys[proxy] = ComputeKey(m_Bounds[proxy]);
+				const uint32 bucketCount = GetBuckets(m_Keys[proxy], buckets);
+				for (uint32 i = 0; i < bucketCount; ++i)
+					entries[block * StripeCount + buckets[i] % StripeCount].push_back({ buckets[i], proxy });
+			}
+		}, maxThreads);
+
+	ThreadPool::Get()->ParallelFor(StripeCount, [&](uint64 stripe)
+		{
+			for (uint32 block = 0; block < blockCount; ++block)
+			{
+				for (const Entry& entry : entries[block * StripeCount + stripe])
+					m_Buckets[entry.bucket].push_back(entry.proxy);
+			}
+		}, maxThreads);
+
+	for (uint64 key : m_Keys)
+		OnProxyAdded(key);
+}
+
+void RS::Broadphase2D::Clear()
+{
+	for (uint64 key : m_Keys)
+	{
+		if (key != InvalidKey)
+			OnProxyRemoved(key);
+	}
+
+	// The buckets keep their memory, they are often filled up again right away.
+	for (std::vector<uint32>& bucket : m_Buckets)
+		bucket.clear();
+
+	m_Bounds.clear();
+	m_Keys.clear();
+	m_FreeProxies.clear();
+	m_MovedProxies.clear();
+	m_ProxyCount = 0;
+}
+
+void RS::Broadphase2D::QueryRadius(const float center[2], float radius, std::vector<uint32>& proxies) const
+{
+	const uint64 first = proxies.size();
+	Query({ { center[0] - radius, center[1] - radius }, { center[0] + radius, center[1] + radius } }, proxies);
+
+	auto removed = std::remove_if(proxies.begin() + first, proxies.end(), [&](uint32 proxy) { return !m_Bounds[proxy].Overlaps(center, radius); });
+	proxies.erase(removed, proxies.end());
+}
+
+void RS::Broadphase2D::QueryBatch(std::span<const AABB2D> boxes, std::vector<std::vector<uint32>>& proxies, uint maxThreads) const
+{
+	using namespace _Broadphase2DInternal;
+
+	const uint64 count = boxes.size();
+	proxies.resize(count);
+	ThreadPool::Get()->ParallelFor((count + QueryBlockSize - 1) / QueryBlockSize, [&](uint64 block)
+		{
+			const uint64 last = std::min((block + 1) * QueryBlockSize, count);
+			for (uint64 i = block * QueryBlockSize; i < last; ++i)
+			{
+				proxies[i].clear();
+				Query(boxes[i], proxies[i]);
+			}
+		}, maxThreads);
+}
+
+void RS::Broadphase2D::FindOverlappingPairs(std::vector<OverlapPair>& pairs, uint maxThreads) const
+{
+	using namespace _Broadphase2DInternal;
+
+	pairs.clear();
+
+	const uint32 count = (uint32)m_Keys.size();
+	const uint32 blockCount = (count + BlockSize - 1) / BlockSize;
+	std::vector<std::vector<OverlapPair>> blockPairs(blockCount);
+	ThreadPool::Get()->ParallelFor(blockCount, [&](uint64 block)
+		{
+			const uint32 first = (uint32)block * BlockSize;
+			const uint32 last = std::min(first + BlockSize, count);
+			std::vector<uint32> candidates;
+			for (uint32 proxy = first; proxy < last; ++proxy)
+			{
+				if (m_Keys[proxy] == InvalidKey)
+					continue;
+
+				candidates.clear();
+				Query(m_Bounds[proxy], candidates);
+				std::sort(candidates.begin(), candidates.end());
+				for (uint32 other : candidates)
+				{
+					if (other > proxy)
+						blockPairs[block].push_back({ proxy, other });
+				}
+			}
+		}, maxThreads);
+
+	uint64 pairCount = 0;
+	for (const std::vector<OverlapPair>& block : blockPairs)
+		pairCount += block.size();
+	pairs.reserve(pairCount);
+	for (const std::vector<OverlapPair>& block : blockPairs)
+		pairs.insert(pairs.end(), block.begin(), block.end());
+}
+
+void RS::Broadphase2D::AddToBuckets(uint32 proxy)
+{
+	uint32 buckets[MaxBucketsPerProxy];
+	const uint32 bucketCount = GetBuckets(m_Keys[proxy], buckets);
+	for (uint32 i = 0; i < bucketCount; ++i)
+		m_Buckets[buckets[i]].push_back(proxy);
+	OnProxyAdded(m_Keys[proxy]);
+}
+
+void RS::Broadphase2D::RemoveFromBuckets(uint32 proxy)
+{
+	uint32 buckets[MaxBucketsPerProxy];
+	const uint32 bucketCount = GetBuckets(m_Keys[proxy], buckets);
+	for (uint32 i = 0; i < bucketCount; ++i)
+	{
+		std::vector<uint32>& bucket = m_Buckets[buckets[i]];
+		auto it = std::find(bucket.begin(), bucket.end(), proxy);
+		RS_ASSERT(it != bucket.end(), "Proxy {} is missing from bucket {}!", proxy, buckets[i]);
+		*it = bucket.back();
+		bucket.pop_back();
+	}
+	OnProxyRemoved(m_Keys[proxy]);
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <algorithm>
+#include <cfloat>
+#include <mutex>
+#include <span>
+#include <vector>
+
+namespace RS
+{
+	struct AABB2D
+	{
+		float min[2] = { FLT_MAX, FLT_MAX };
+		float max[2] = { -FLT_MAX, -FLT_MAX };
+
+		static AABB2D FromCenterSize(float centerX, float centerY, float sizeX, float sizeY)
+		{
+			return { { centerX - sizeX * 0.5f, centerY - sizeY * 0.5f }, { centerX + sizeX * 0.5f, centerY + sizeY * 0.5f } };
+		}
+
+		// Touching boxes overlap.
+		bool Overlaps(const AABB2D& other) const
+		{
+			return min[0] <= other.max[0] && max[0] >= other.min[0] && min[1] <= other.max[1] && max[1] >= other.min[1];
+		}
+
+		bool Overlaps(const float center[2], float radius) const
+		{
+			const float dx = std::max(std::max(min[0] - center[0], center[0] - max[0]), 0.f);
+			const float dy = std::max(std::max(min[1] - center[1], center[1] - max[1]), 0.f);
+			return dx * dx + dy * dy <= radius * radius;
+		}
+	};
+
+	// a < b
+	struct OverlapPair
+	{
+		uint32 a;
+		uint32 b;
+	};
+
+	/*
+	* Finds which boxes overlap, without testing every box against every other one. The boxes are proxies, which are
+	* either inserted, updated and removed one by one, or built all at once from an array where proxy i is box i.
+	* Proxies are put in buckets by the implementation, SpatialHashGrid2D or LooseQuadtree2D, and queries only test the
+	* proxies in the buckets they touch.
+	*
+	* Update is thread safe for different proxies. Proxies that move to other buckets are only moved by CommitUpdates,
+	* which has to be called before the next query. Everything else is not thread safe, but queries can run in parallel.
+	*/
+	class Broadphase2D
+	{
+	public:
+		static constexpr uint32 InvalidProxy = UINT32_MAX;
+
+	public:
+		virtual ~Broadphase2D() = default;
+		RS_NO_COPY_AND_MOVE(Broadphase2D)
+
+		uint32 Insert(const AABB2D& bounds);
+		void Update(uint32 proxy, const AABB2D& bounds);
+		void CommitUpdates();
+		void Remove(uint32 proxy);
+
+		/*
+		* Replaces all proxies with one per box, proxy i is bounds[i]. Runs in parallel on the ThreadPool, the result does
+		* not depend on the thread count. maxThreads works like it does for ThreadPool::ParallelFor.
+		*/
+		void Build(std::span<const AABB2D> bounds, uint maxThreads = 0);
+		void Clear();
+
+		/*
+		* Appends the proxies that overlap the box, each one once.
+		*/
+		virtual void Query(const AABB2D& box, std::vector<uint32>& proxies) const = 0;
+
+		// Appends the proxies that overlap the circle.
+		void QueryRadius(const float center[2], float radius, std::vector<uint32>& proxies) const;
+
+		// proxies[i] gets the proxies that overlap boxes[i], the queries are spread over the ThreadPool.
+		void QueryBatch(std::span<const AABB2D> boxes, std::vector<std::vector<uint32>>& proxies, uint maxThreads = 0) const;
+
+		/*
+		* Every pair of overlapping proxies once, sorted by the first proxy. Spread over the ThreadPool.
+		*/
+		void FindOverlappingPairs(std::vector<OverlapPair>& pairs, uint maxThreads = 0) const;
+
+		bool IsValid(uint32 proxy) const { return proxy < (uint32)m_Keys.size() && m_Keys[proxy] != InvalidKey; }
+		const AABB2D& GetBounds(uint32 proxy) const { return m_Bounds[proxy]; }
+		uint32 GetProxyCount() const { return m_ProxyCount; }
+
+	protected:
+		static constexpr uint64 InvalidKey = UINT64_MAX;
+		static constexpr uint32 MaxBucketsPerProxy = 16;
+
+		explicit Broadphase2D(uint32 bucketCount);
+
+		// Proxies with equal keys are in the same buckets.
+		virtual uint64 ComputeKey(const AABB2D& bounds) const = 0;
+
+		// The buckets of a key, each one once. Returns how many there are.
+		virtual uint32 GetBuckets(uint64 key, uint32 (&buckets)[MaxBucketsPerProxy]) const = 0;
+
+		// For implementations that keep track of where the proxies are.
+		virtual void OnProxyAdded(uint64 key) {}
+		virtual void OnProxyRemoved(uint64 key) {}
+
+	private:
+		void AddToBuckets(uint32 proxy);
+		void RemoveFromBuckets(uint32 proxy);
+
+	protected:
+		std::vector<std::vector<uint32>>	m_Buckets;
+		std::vector<AABB2D>					m_Bounds;
+
+	private:
+		std::vector<uint64>					m_Keys;			// InvalidKey for removed proxies.
+		std::vector<uint32>					m_FreeProxies;
+		uint32								m_ProxyCount = 0;
+
+		std::mutex							m_MovedProxiesMutex;
+		std::vector<uint32>					m_MovedProxies;
+	};
+}
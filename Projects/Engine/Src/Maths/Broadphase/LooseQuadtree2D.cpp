@@ -0,0 +1,92 @@
+#include "PreCompiled.h"
+#include "LooseQuadtree2D.h"
+
+#include <cmath>
+
+RS::LooseQuadtree2D::LooseQuadtree2D(const AABB2D& worldBounds, uint32 levelCount)
+	: Broadphase2D(GetLevelOffset(levelCount))
+	, m_WorldBounds(worldBounds)
+	, m_LevelCount(levelCount)
+	, m_WorldSize{ worldBounds.max[0] - worldBounds.min[0], worldBounds.max[1] - worldBounds.min[1] }
+{
+	RS_ASSERT(levelCount > 0 && levelCount <= MaxLevelCount, "A loose quadtree has 1 to {} levels, not {}!", MaxLevelCount, levelCount);
+	RS_ASSERT(m_WorldSize[0] > 0.f && m_WorldSize[1] > 0.f, "The world bounds are empty!");
+}
+
+void RS::LooseQuadtree2D::Query(const AABB2D& box, std::vector<uint32>& proxies) const
+{
+	// The root holds every proxy outside of the world, it is always tested.
+	for (uint32 proxy : m_Buckets[0])
+	{
+		if (box.Overlaps(m_Bounds[proxy]))
+			proxies.push_back(proxy);
+	}
+
+	for (uint32 level = 1; level < m_LevelCount; ++level)
+	{
+		if (m_LevelProxyCounts[level] == 0)
+			continue;
+
+		// The loose bounds of a node reach half a node further than its own bounds on each side. The range is rounded
+		// outwards, touching proxies overlap.
+		const int32 side = 1 << level;
+		const float nodeSizeX = m_WorldSize[0] / (float)side;
+		const float nodeSizeY = m_WorldSize[1] / (float)side;
+		const float minX = std::floor((box.min[0] - m_WorldBounds.min[0] - nodeSizeX * 1.5f) / nodeSizeX);
+		const float minY = std::floor((box.min[1] - m_WorldBounds.min[1] - nodeSizeY * 1.5f) / nodeSizeY);
+		const float maxX = std::floor((box.max[0] - m_WorldBounds.min[0] + nodeSizeX * 0.5f) / nodeSizeX);
+		const float maxY = std::floor((box.max[1] - m_WorldBounds.min[1] + nodeSizeY * 0.5f) / nodeSizeY);
+		if (maxX < 0.f || maxY < 0.f || minX >= (float)side || minY >= (float)side)
+			continue;
+
+		const int32 firstX = (int32)std::max(minX, 0.f);
+		const int32 firstY = (int32)std::max(minY, 0.f);
+		const int32 lastX = (int32)std::min(maxX, (float)(side - 1));
+		const int32 lastY = (int32)std::min(maxY, (float)(side - 1));
+		const uint32 levelOffset = GetLevelOffset(level);
+		for (int32 y = firstY; y <= lastY; ++y)
+		{
+			for (int32 x = firstX; x <= lastX; ++x)
+			{
+				for (uint32 proxy : m_Buckets[levelOffset + (uint32)(y * side + x)])
+				{
+					if (box.Overlaps(m_Bounds[proxy]))
+						proxies.push_back(proxy);
+				}
+			}
+		}
+	}
+}
+
+uint64 RS::LooseQuadtree2D::ComputeKey(const AABB2D& bounds) const
+{
+	const float sizeX = bounds.max[0] - bounds.min[0];
+	const float sizeY = bounds.max[1] - bounds.min[1];
+	const float centerX = (bounds.min[0] + bounds.max[0]) * 0.5f - m_WorldBounds.min[0];
+	const float centerY = (bounds.min[1] + bounds.max[1]) * 0.5f - m_WorldBounds.min[1];
+	if (!(centerX >= 0.f && centerX < m_WorldSize[0] && centerY >= 0.f && centerY < m_WorldSize[1]))
+		return 0;
+
+	uint32 level = m_LevelCount - 1;
+	while (level > 0 && (sizeX > m_WorldSize[0] / (float)(1u << level) || sizeY > m_WorldSize[1] / (float)(1u << level)))
+		--level;
+
+	const uint32 side = 1u << level;
+	const uint32 x = std::min((uint32)(centerX / m_WorldSize[0] * (float)side), side - 1);
+	const uint32 y = std::min((uint32)(centerY / m_WorldSize[1] * (float)side), side - 1);
+	return GetLevelOffset(level) + y * side + x;
+}
+
+uint32 RS::LooseQuadtree2D::GetBuckets(uint64 key, uint32 (&buckets)[MaxBucketsPerProxy]) const
+{
+	buckets[0] = (uint32)key;
+	return 1;
+}
+
+uint32 RS::LooseQuadtree2D::GetLevel(uint32 node) const
+{
+	uint32 level = 0;
+	while (level + 1 < m_LevelCount && node >= GetLevelOffset(level + 1))
+		++level;
+	return level;
+}
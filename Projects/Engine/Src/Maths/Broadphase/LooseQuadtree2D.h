@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Maths/Broadphase/Broadphase2D.h"
+
+namespace RS
+{
+	/*
+	* Quadtree where the bounds of every node are loosened to twice its size, so a proxy fits in the node that holds its
+	* center on the deepest level where it is not larger than the nodes. Each proxy is in one node, which is found without
+	* walking the tree, and the levels are stored as full grids of nodes.
+	* Proxies with their center outside of the world bounds go in the root. Handles proxies of very different sizes better
+	* than SpatialHashGrid2D, but needs the world bounds up front.
+	*/
+	class LooseQuadtree2D : public Broadphase2D
+	{
+	public:
+		static constexpr uint32 MaxLevelCount = 12;
+
+	public:
+		explicit LooseQuadtree2D(const AABB2D& worldBounds, uint32 levelCount = 8);
+
+		void Query(const AABB2D& box, std::vector<uint32>& proxies) const override;
+
+		const AABB2D& GetWorldBounds() const { return m_WorldBounds; }
+		uint32 GetLevelCount() const { return m_LevelCount; }
+
+	protected:
+		uint64 ComputeKey(const AABB2D& bounds) const override;
+		uint32 GetBuckets(uint64 key, uint32 (&buckets)[MaxBucketsPerProxy]) const override;
+		void OnProxyAdded(uint64 key) override { ++m_LevelProxyCounts[GetLevel((uint32)key)]; }
+		void OnProxyRemoved(uint64 key) override { --m_LevelProxyCounts[GetLevel((uint32)key)]; }
+
+	private:
+		// Nodes of the levels above it.
+		static uint32 GetLevelOffset(uint32 level) { return ((1u << (2 * level)) - 1) / 3; }
+		uint32 GetLevel(uint32 node) const;
+
+	private:
+		AABB2D	m_WorldBounds;
+		uint32	m_LevelCount;
+		float	m_WorldSize[2];
+		uint32	m_LevelProxyCounts[MaxLevelCount] = {};	// Queries skip the empty levels.
+	};
+}
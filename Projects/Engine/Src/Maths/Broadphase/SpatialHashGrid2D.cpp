@@ -0,0 +1,136 @@
+#include "PreCompiled.h"
+#include "SpatialHashGrid2D.h"
+
+#include <bit>
+#include <cmath>
+
+namespace RS::_SpatialHashGrid2DInternal
+{
+	// Cell ranges are packed as four 16 bit values, so cells are clamped to this range. 0xFFFF is never used, so a
+	// packed range is never LargeProxyKey or InvalidKey.
+	constexpr float MinCell = -32768.f;
+	constexpr float MaxCell = 32766.f;
+	constexpr int32 CellOffset = 32768;
+	constexpr uint64 LargeProxyKey = UINT64_MAX - 1;
+
+	struct CellRange
+	{
+		int32 minX;
+		int32 minY;
+		int32 maxX;
+		int32 maxY;
+
+		uint64 GetCellCount() const { return (uint64)(maxX - minX + 1) * (uint64)(maxY - minY + 1); }
+	};
+
+	uint64 PackCellRange(const CellRange& range)
+	{
+		return (uint64)(range.minX + CellOffset) | ((uint64)(range.minY + CellOffset) << 16) | ((uint64)(range.maxX + CellOffset) << 32) | ((uint64)(range.maxY + CellOffset) << 48);
+	}
+
+	CellRange UnpackCellRange(uint64 key)
+	{
+		return { (int32)(key & 0xFFFF) - CellOffset, (int32)((key >> 16) & 0xFFFF) - CellOffset, (int32)((key >> 32) & 0xFFFF) - CellOffset, (int32)(key >> 48) - CellOffset };
+	}
+}
+
+RS::SpatialHashGrid2D::SpatialHashGrid2D(float cellSize, uint32 bucketCount)
+	: Broadphase2D(bucketCount + 1)
+	, m_CellSize(cellSize)
+	, m_InverseCellSize(1.f / cellSize)
+	, m_HashBucketCount(bucketCount)
+{
+	RS_ASSERT(cellSize > 0.f, "Cell size has to be positive!");
+	RS_ASSERT(std::has_single_bit(bucketCount), "The bucket count {} is not a power of two!", bucketCount);
+}
+
+void RS::SpatialHashGrid2D::Query(const AABB2D& box, std::vector<uint32>& proxies) const
+{
+	using namespace _SpatialHashGrid2DInternal;
+
+	if (box.min[0] > box.max[0] || box.min[1] > box.max[1])
+		return;
+
+	for (uint32 proxy : m_Buckets[m_HashBucketCount])
+	{
+		if (box.Overlaps(m_Bounds[proxy]))
+			proxies.push_back(proxy);
+	}
+
+	// A proxy in more than one of the cells is only added from the cell with the lower left corner of where it
+	// overlaps the box. That cell is the same for every query, so this also holds when visiting whole buckets.
+	const CellRange range = { GetCell(box.min[0]), GetCell(box.min[1]), GetCell(box.max[0]), GetCell(box.max[1]) };
+	if (range.GetCellCount() > m_HashBucketCount)
+	{
+		// Every bucket would be visited anyway, once each is cheaper.
+		for (uint32 bucket = 0; bucket < m_HashBucketCount; ++bucket)
+		{
+			for (uint32 proxy : m_Buckets[bucket])
+			{
+				const AABB2D& bounds = m_Bounds[proxy];
+				if (box.Overlaps(bounds) && GetBucket(GetCell(std::max(box.min[0], bounds.min[0])), GetCell(std::max(box.min[1], bounds.min[1]))) == bucket)
+					proxies.push_back(proxy);
+			}
+		}
+		return;
+	}
+
+	for (int32 y = range.minY; y <= range.maxY; ++y)
+	{
+		for (int32 x = range.minX; x <= range.maxX; ++x)
+		{
+			for (uint32 proxy : m_Buckets[GetBucket(x, y)])
+			{
+				const AABB2D& bounds = m_Bounds[proxy];
+				if (box.Overlaps(bounds) && GetCell(std::max(box.min[0], bounds.min[0])) == x && GetCell(std::max(box.min[1], bounds.min[1])) == y)
+					proxies.push_back(proxy);
+			}
+		}
+	}
+}
+
+uint64 RS::SpatialHashGrid2D::ComputeKey(const AABB2D& bounds) const
+{
+	using namespace _SpatialHashGrid2DInternal;
+
+	const CellRange range = { GetCell(bounds.min[0]), GetCell(bounds.min[1]), GetCell(bounds.max[0]), GetCell(bounds.max[1]) };
+	if (range.minX > range.maxX || range.minY > range.maxY || range.GetCellCount() > MaxBucketsPerProxy)
+		return LargeProxyKey;
+	return PackCellRange(range);
+}
+
+uint32 RS::SpatialHashGrid2D::GetBuckets(uint64 key, uint32 (&buckets)[MaxBucketsPerProxy]) const
+{
+	using namespace _SpatialHashGrid2DInternal;
+
+	if (key == LargeProxyKey)
+	{
+		buckets[0] = m_HashBucketCount;
+		return 1;
+	}
+
+	// Cells can share a bucket, the proxy is only added to it once.
+	const CellRange range = UnpackCellRange(key);
+	uint32 count = 0;
+	for (int32 y = range.minY; y <= range.maxY; ++y)
+	{
+		for (int32 x = range.minX; x <= range.maxX; ++x)
+		{
+			const uint32 bucket = GetBucket(x, y);
+			if (std::find(buckets, buckets + count, bucket) == buckets + count)
+				buckets[count++] = bucket;
+		}
+	}
+	return count;
+}
+
+int32 RS::SpatialHashGrid2D::GetCell(float position) const
+{
+	using namespace _SpatialHashGrid2DInternal;
+	return (int32)std::clamp(std::floor(position * m_InverseCellSize), MinCell, MaxCell);
+}
+
+uint32 RS::SpatialHashGrid2D::GetBucket(int32 x, int32 y) const
+{
+	return (((uint32)x * 73856093u) ^ ((uint32)y * 19349663u)) & (m_HashBucketCount - 1);
+}
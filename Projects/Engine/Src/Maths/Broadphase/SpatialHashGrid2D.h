@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Maths/Broadphase/Broadphase2D.h"
+
+namespace RS
+{
+	/*
+	* Uniform grid of square cells, hashed into a fixed number of buckets so the world does not need bounds.
+	* A proxy is put in the bucket of every cell it touches, proxies that touch more cells than MaxBucketsPerProxy go
+	* into one bucket that every query tests. Works best when the cells are about the size of the largest common proxy.
+	*/
+	class SpatialHashGrid2D : public Broadphase2D
+	{
+	public:
+		// bucketCount has to be a power of two.
+		explicit SpatialHashGrid2D(float cellSize, uint32 bucketCount = 1u << 16);
+
+		void Query(const AABB2D& box, std::vector<uint32>& proxies) const override;
+
+		float GetCellSize() const { return m_CellSize; }
+
+	protected:
+		uint64 ComputeKey(const AABB2D& bounds) const override;
+		uint32 GetBuckets(uint64 key, uint32 (&buckets)[MaxBucketsPerProxy]) const override;
+
+	private:
+		int32 GetCell(float position) const;
+		uint32 GetBucket(int32 x, int32 y) const;
+
+	private:
+		float	m_CellSize;
+		float	m_InverseCellSize;
+		uint32	m_HashBucketCount;	// The bucket after them is for the large proxies.
+	};
+}
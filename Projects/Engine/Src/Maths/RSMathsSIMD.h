@@ -0,0 +1,176 @@
+#pragma once
+
+#include <concepts>
+
+// SSE2 is part of x64, so every platform the engine builds for has it. Define RS_MATHS_NO_SIMD to only use the scalar paths.
+#if !defined(RS_MATHS_NO_SIMD) && (defined(_M_X64) || defined(__SSE2__))
+#define RS_MATHS_SIMD 1
+#include <emmintrin.h>
+#else
+#define RS_MATHS_SIMD 0
+#endif
+
+// Four float vectors and 4x4 float matrices take the SIMD paths, every other vector and matrix uses the scalar loops.
+template<typename Type, auto N>
+concept SIMDFloat4 = (RS_MATHS_SIMD == 1) && std::same_as<Type, float> && (N == 4);
+
+#if RS_MATHS_SIMD
+
+// Lanes are given in memory order, x first.
+#define RS_SIMD_SWIZZLE(v, x, y, z, w) _mm_shuffle_ps((v), (v), _MM_SHUFFLE(w, z, y, x))
+#define RS_SIMD_SHUFFLE(a, b, ax, ay, bz, bw) _mm_shuffle_ps((a), (b), _MM_SHUFFLE(bw, bz, ay, ax))
+
+/*
+* Kernels on plain float arrays, shared by RS::Mat and RS_New::VecNew. The vectors and matrices have no alignment
+* requirement, so everything is loaded and stored unaligned.
+* Matrices are four vectors of four floats. The kernels do not care if those are rows or columns, as long as both
+* sides of an operation use the same order.
+*/
+namespace RS::SIMD
+{
+	inline __m128 Load(const float* pData) { return _mm_loadu_ps(pData); }
+	inline void Store(float* pData, __m128 value) { _mm_storeu_ps(pData, value); }
+
+	// Sum of all lanes, in every lane.
+	inline __m128 HorizontalSum(__m128 value)
+	{
+		const __m128 pairs = _mm_add_ps(value, RS_SIMD_SWIZZLE(value, 1, 0, 3, 2));
+		return _mm_add_ps(pairs, RS_SIMD_SWIZZLE(pairs, 2, 3, 0, 1));
+	}
+
+	inline __m128 Dot(__m128 a, __m128 b)
+	{
+		return HorizontalSum(_mm_mul_ps(a, b));
+	}
+
+	// v0 * x + v1 * y + v2 * z + v3 * w, added in the same order as the scalar loops.
+	inline __m128 Combine(__m128 v0, __m128 v1, __m128 v2, __m128 v3, __m128 weights)
+	{
+		__m128 result = _mm_mul_ps(v0, RS_SIMD_SWIZZLE(weights, 0, 0, 0, 0));
+		result = _mm_add_ps(result, _mm_mul_ps(v1, RS_SIMD_SWIZZLE(weights, 1, 1, 1, 1)));
+		result = _mm_add_ps(result, _mm_mul_ps(v2, RS_SIMD_SWIZZLE(weights, 2, 2, 2, 2)));
+		return _mm_add_ps(result, _mm_mul_ps(v3, RS_SIMD_SWIZZLE(weights, 3, 3, 3, 3)));
+	}
+
+	// Column major A * B. For row major matrices pass them swapped, as B^T * A^T = (A * B)^T. pOut may be pA or pB.
+	inline void Mul4x4(const float* pA, const float* pB, float* pOut)
+	{
+		const __m128 a0 = Load(pA + 0);
+		const __m128 a1 = Load(pA + 4);
+		const __m128 a2 = Load(pA + 8);
+		const __m128 a3 = Load(pA + 12);
+		const __m128 b0 = Load(pB + 0);
+		const __m128 b1 = Load(pB + 4);
+		const __m128 b2 = Load(pB + 8);
+		const __m128 b3 = Load(pB + 12);
+		Store(pOut + 0, Combine(a0, a1, a2, a3, b0));
+		Store(pOut + 4, Combine(a0, a1, a2, a3, b1));
+		Store(pOut + 8, Combine(a0, a1, a2, a3, b2));
+		Store(pOut + 12, Combine(a0, a1, a2, a3, b3));
+	}
+
+	inline void Transpose4x4(const float* pIn, float* pOut)
+	{
+		__m128 v0 = Load(pIn + 0);
+		__m128 v1 = Load(pIn + 4);
+		__m128 v2 = Load(pIn + 8);
+		__m128 v3 = Load(pIn + 12);
+		_MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+		Store(pOut + 0, v0);
+		Store(pOut + 4, v1);
+		Store(pOut + 8, v2);
+		Store(pOut + 12, v3);
+	}
+
+	// Column major matrix times count vectors of four floats. pOut may be pIn.
+	inline void Transform4x4(const float* pMat, const float* pIn, float* pOut, uint64 count)
+	{
+		const __m128 c0 = Load(pMat + 0);
+		const __m128 c1 = Load(pMat + 4);
+		const __m128 c2 = Load(pMat + 8);
+		const __m128 c3 = Load(pMat + 12);
+		for (uint64 i = 0; i < count; ++i)
+			Store(pOut + i * 4, Combine(c0, c1, c2, c3, Load(pIn + i * 4)));
+	}
+
+	namespace _Internal
+	{
+		// 2x2 matrices stored row by row in one register, adj(M) is the adjugate.
+		inline __m128 Mul2x2(__m128 a, __m128 b)
+		{
+			return _mm_add_ps(_mm_mul_ps(a, RS_SIMD_SWIZZLE(b, 0, 3, 0, 3)), _mm_mul_ps(RS_SIMD_SWIZZLE(a, 1, 0, 3, 2), RS_SIMD_SWIZZLE(b, 2, 1, 2, 1)));
+		}
+
+		// adj(A) * B
+		inline __m128 AdjMul2x2(__m128 a, __m128 b)
+		{
+			return _mm_sub_ps(_mm_mul_ps(RS_SIMD_SWIZZLE(a, 3, 3, 0, 0), b), _mm_mul_ps(RS_SIMD_SWIZZLE(a, 1, 1, 2, 2), RS_SIMD_SWIZZLE(b, 2, 3, 0, 1)));
+		}
+
+		// A * adj(B)
+		inline __m128 MulAdj2x2(__m128 a, __m128 b)
+		{
+			return _mm_sub_ps(_mm_mul_ps(a, RS_SIMD_SWIZZLE(b, 3, 0, 3, 0)), _mm_mul_ps(RS_SIMD_SWIZZLE(a, 1, 0, 3, 2), RS_SIMD_SWIZZLE(b, 2, 1, 2, 1)));
+		}
+	}
+
+	/*
+	* Inverse through 2x2 blocks, M = [A B; C D]. Every block of the inverse is built from adjugates of the blocks, so
+	* the only division is by the determinant. Works for both orders, as inverse(M^T) = inverse(M)^T.
+	* Returns the determinant, pOut is not written if it is zero.
+	*/
+	inline float Inverse4x4(const float* pIn, float* pOut)
+	{
+		using namespace _Internal;
+
+		const __m128 v0 = Load(pIn + 0);
+		const __m128 v1 = Load(pIn + 4);
+		const __m128 v2 = Load(pIn + 8);
+		const __m128 v3 = Load(pIn + 12);
+
+		const __m128 a = _mm_movelh_ps(v0, v1);
+		const __m128 b = _mm_movehl_ps(v1, v0);
+		const __m128 c = _mm_movelh_ps(v2, v3);
+		const __m128 d = _mm_movehl_ps(v3, v2);
+
+		// (|A|, |B|, |C|, |D|)
+		const __m128 detBlocks = _mm_sub_ps(
+			_mm_mul_ps(RS_SIMD_SHUFFLE(v0, v2, 0, 2, 0, 2), RS_SIMD_SHUFFLE(v1, v3, 1, 3, 1, 3)),
+			_mm_mul_ps(RS_SIMD_SHUFFLE(v0, v2, 1, 3, 1, 3), RS_SIMD_SHUFFLE(v1, v3, 0, 2, 0, 2)));
+		const __m128 detA = RS_SIMD_SWIZZLE(detBlocks, 0, 0, 0, 0);
+		const __m128 detB = RS_SIMD_SWIZZLE(detBlocks, 1, 1, 1, 1);
+		const __m128 detC = RS_SIMD_SWIZZLE(detBlocks, 2, 2, 2, 2);
+		const __m128 detD = RS_SIMD_SWIZZLE(detBlocks, 3, 3, 3, 3);
+
+		const __m128 adjDC = AdjMul2x2(d, c);
+		const __m128 adjAB = AdjMul2x2(a, b);
+
+		// The adjugates of the blocks of |M| * inverse(M).
+		__m128 x = _mm_sub_ps(_mm_mul_ps(detD, a), Mul2x2(b, adjDC));
+		__m128 w = _mm_sub_ps(_mm_mul_ps(detA, d), Mul2x2(c, adjAB));
+		__m128 y = _mm_sub_ps(_mm_mul_ps(detB, c), MulAdj2x2(d, adjAB));
+		__m128 z = _mm_sub_ps(_mm_mul_ps(detC, b), MulAdj2x2(a, adjDC));
+
+		// |M| = |A||D| + |B||C| - tr(adj(A)B * adj(D)C)
+		const __m128 trace = HorizontalSum(_mm_mul_ps(adjAB, RS_SIMD_SWIZZLE(adjDC, 0, 2, 1, 3)));
+		const __m128 det = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC)), trace);
+		const float determinant = _mm_cvtss_f32(det);
+		if (determinant == 0.f)
+			return determinant;
+
+		// Taking the adjugates back flips the sign of the off diagonal elements.
+		const __m128 invDet = _mm_div_ps(_mm_setr_ps(1.f, -1.f, -1.f, 1.f), det);
+		x = _mm_mul_ps(x, invDet);
+		y = _mm_mul_ps(y, invDet);
+		z = _mm_mul_ps(z, invDet);
+		w = _mm_mul_ps(w, invDet);
+
+		Store(pOut + 0, RS_SIMD_SHUFFLE(x, y, 3, 1, 3, 1));
+		Store(pOut + 4, RS_SIMD_SHUFFLE(x, y, 2, 0, 2, 0));
+		Store(pOut + 8, RS_SIMD_SHUFFLE(z, w, 3, 1, 3, 1));
+		Store(pOut + 12, RS_SIMD_SHUFFLE(z, w, 2, 0, 2, 0));
+		return determinant;
+	}
+}
+
+#endif
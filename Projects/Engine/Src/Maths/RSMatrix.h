@@ -9,6 +9,9 @@
 
 namespace RS
 {
+	template<typename Type, uint32 Row, uint32 Col>
+	concept SIMDMat4 = SIMDFloat4<Type, Row> && (Col == 4);
+
 	template<typename Type, uint32 Row, uint32 Col>
 	struct Mat
 	{
@@ -52,6 +55,7 @@ namespace RS
 
 		template<uint32 Row2, uint32 Col2>
 		Mat<Type, Row, Col2> operator*(const Mat<Type, Row2, Col2>& other) const;
+		Mat operator*(const Mat& other) const requires SIMDMat4<Type, Row, Col>;
 		Mat<Type, Row, Col>& operator*=(const Mat<Type, Row, Col>& other);
 
 		Mat operator+(const Mat& other) const;
@@ -86,6 +90,10 @@ namespace RS
 
 		Mat Identity() const;
 
+		// The elements in the order they are stored, see RS_MATHS_COLUMN_MAJOR.
+		Type* GetData() { return &data[0].values[0]; }
+		const Type* GetData() const { return &data[0].values[0]; }
+
 		static const Mat ZERO;
 		static const Mat IDENTITY;
 
@@ -109,7 +117,7 @@ namespace RS
 	template<typename Type, uint32 Row, uint32 Col>
 	inline Mat<Type, Row, Col>::Mat(const Type& value)
 	{
-		for (uint32 vecIndex = 0; DATA_VECTOR_COUNT; ++vecIndex)
+		for (uint32 vecIndex = 0; vecIndex < DATA_VECTOR_COUNT; ++vecIndex)
 			data[vecIndex] = value;
 	}
 
@@ -190,7 +198,7 @@ namespace RS
 	template<typename Type, uint32 Row, uint32 Col>
 	inline Mat<Type, Row, Col>& Mat<Type, Row, Col>::operator=(const Type& scalar)
 	{
-		for (uint32 vecIndex = 0; DATA_VECTOR_COUNT; ++vecIndex)
+		for (uint32 vecIndex = 0; vecIndex < DATA_VECTOR_COUNT; ++vecIndex)
 			data[vecIndex] = scalar;
 		return *this;
 	}
@@ -374,6 +382,18 @@ namespace RS
 		return result;
 	}
 
+	template<typename Type, uint32 Row, uint32 Col>
+	inline Mat<Type, Row, Col> Mat<Type, Row, Col>::operator*(const Mat& other) const requires SIMDMat4<Type, Row, Col>
+	{
+		Mat result;
+#if RS_MATHS_COLUMN_MAJOR
+		SIMD::Mul4x4(GetData(), other.GetData(), result.GetData());
+#else
+		SIMD::Mul4x4(other.GetData(), GetData(), result.GetData());
+#endif
+		return result;
+	}
+
 	template<typename Type, uint32 Row, uint32 Col>
 	inline Mat<Type, Row, Col>& Mat<Type, Row, Col>::operator*=(const Mat<Type, Row, Col>& other)
 	{
@@ -539,6 +559,55 @@ namespace RS
 		return result;
 	}
 
+	template<typename Type> requires SIMDMat4<Type, 4, 4>
+	inline Mat<Type, 4, 4> Transpose(const Mat<Type, 4, 4>& mat)
+	{
+		Mat<Type, 4, 4> result;
+		SIMD::Transpose4x4(mat.GetData(), result.GetData());
+		return result;
+	}
+
+	template<typename Type, uint32 Row, uint32 Col>
+	inline Vec<Type, Row> Transform(const Mat<Type, Row, Col>& mat, const Vec<Type, Col>& v)
+	{
+		// Added column by column, the same order as the SIMD path.
+		Vec<Type, Row> result;
+		for (uint32 col = 0; col < Col; ++col)
+		{
+			for (uint32 row = 0; row < Row; ++row)
+				result[row] += mat.AtConst(row, col) * v.AtConst(col);
+		}
+		return result;
+	}
+
+	// Transforms count vectors by the same matrix. pOut may be pIn.
+	template<typename Type, uint32 Row, uint32 Col>
+	inline void TransformBatch(const Mat<Type, Row, Col>& mat, const Vec<Type, Col>* pIn, Vec<Type, Row>* pOut, uint64 count)
+	{
+		for (uint64 i = 0; i < count; ++i)
+			pOut[i] = Transform(mat, pIn[i]);
+	}
+
+	template<typename Type> requires SIMDMat4<Type, 4, 4>
+	inline void TransformBatch(const Mat<Type, 4, 4>& mat, const Vec<Type, 4>* pIn, Vec<Type, 4>* pOut, uint64 count)
+	{
+		static_assert(sizeof(Vec<Type, 4>) == sizeof(Type) * 4, "The vectors need to be packed to be read as one array!");
+#if RS_MATHS_COLUMN_MAJOR
+		SIMD::Transform4x4(mat.GetData(), &pIn[0].values[0], &pOut[0].values[0], count);
+#else
+		Mat<Type, 4, 4> columns = Transpose(mat);
+		SIMD::Transform4x4(columns.GetData(), &pIn[0].values[0], &pOut[0].values[0], count);
+#endif
+	}
+
+	template<typename Type> requires SIMDMat4<Type, 4, 4>
+	inline Vec<Type, 4> Transform(const Mat<Type, 4, 4>& mat, const Vec<Type, 4>& v)
+	{
+		Vec<Type, 4> result;
+		TransformBatch(mat, &v, &result, 1);
+		return result;
+	}
+
 	template<typename Type, uint32 Row, uint32 Col>
 	inline Type Determinant(const Mat<Type, Row, Col>& mat)
 	{
@@ -656,6 +725,15 @@ namespace RS
 		return adj * (static_cast<Type>(1) / det);
 	}
 
+	template<typename Type> requires SIMDMat4<Type, 4, 4>
+	inline Mat<Type, 4, 4> Inverse(const Mat<Type, 4, 4>& mat)
+	{
+		Mat<Type, 4, 4> result;
+		Type det = SIMD::Inverse4x4(mat.GetData(), result.GetData());
+		RS_ASSERT(std::abs(det) > static_cast<Type>(FLT_EPSILON), "Cannot take inverse of this matix! Determinant is not allowed to be zero, it was {}.", det);
+		return result;
+	}
+
 	template<typename Type, uint32 Row, uint32 Col>
 	std::ostream& operator<<(std::ostream& os, const Mat<Type, Col, Row>& value)
 	{
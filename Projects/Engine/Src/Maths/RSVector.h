@@ -6,6 +6,7 @@
 #include "RSVectorDataSwizzling.h"
 #include "Utils/Misc/StringUtils.h" // Utils::Format
 #include "Maths/Maths.h"
+#include "Maths/RSMathsSIMD.h"
 
 #define RS_CONVERT_BETWEEN_GLM 1
 #if RS_CONVERT_BETWEEN_GLM
@@ -389,6 +390,13 @@ namespace RS_New
 	template<auto N, NumberType Type> requires VecSizeConstant<decltype(N)>
 	inline VecNew<N, Type>& VecNew<N, Type>::operator+=(const VecNew& other)
 	{
+#if RS_MATHS_SIMD
+		if constexpr (SIMDFloat4<Type, N>)
+		{
+			RS::SIMD::Store(this->data, _mm_add_ps(RS::SIMD::Load(this->data), RS::SIMD::Load(other.data)));
+			return *this;
+		}
+#endif
 		for (SizeType i = (SizeType)0; i < N; ++i)
 			this->data[i] += other.data[i];
 		return *this;
@@ -396,6 +404,13 @@ namespace RS_New
 	template<auto N, NumberType Type> requires VecSizeConstant<decltype(N)>
 	inline VecNew<N, Type>& VecNew<N, Type>::operator-=(const VecNew& other)
 	{
+#if RS_MATHS_SIMD
+		if constexpr (SIMDFloat4<Type, N>)
+		{
+			RS::SIMD::Store(this->data, _mm_sub_ps(RS::SIMD::Load(this->data), RS::SIMD::Load(other.data)));
+			return *this;
+		}
+#endif
 		for (SizeType i = (SizeType)0; i < N; ++i)
 			this->data[i] -= other.data[i];
 		return *this;
@@ -403,6 +418,13 @@ namespace RS_New
 	template<auto N, NumberType Type> requires VecSizeConstant<decltype(N)>
 	inline VecNew<N, Type>& VecNew<N, Type>::operator*=(const VecNew& other)
 	{
+#if RS_MATHS_SIMD
+		if constexpr (SIMDFloat4<Type, N>)
+		{
+			RS::SIMD::Store(this->data, _mm_mul_ps(RS::SIMD::Load(this->data), RS::SIMD::Load(other.data)));
+			return *this;
+		}
+#endif
 		for (SizeType i = (SizeType)0; i < N; ++i)
 			this->data[i] *= other.data[i];
 		return *this;
@@ -410,6 +432,13 @@ namespace RS_New
 	template<auto N, NumberType Type> requires VecSizeConstant<decltype(N)>
 	inline VecNew<N, Type>& VecNew<N, Type>::operator/=(const VecNew& other)
 	{
+#if RS_MATHS_SIMD
+		if constexpr (SIMDFloat4<Type, N>)
+		{
+			RS::SIMD::Store(this->data, _mm_div_ps(RS::SIMD::Load(this->data), RS::SIMD::Load(other.data)));
+			return *this;
+		}
+#endif
 		for (SizeType i = (SizeType)0; i < N; ++i)
 			this->data[i] /= other.data[i];
 		return *this;
@@ -431,6 +460,13 @@ namespace RS_New
 	template<auto N, NumberType Type> requires VecSizeConstant<decltype(N)>
 	inline VecNew<N, Type>& VecNew<N, Type>::operator*=(const Type& scalar)
 	{
+#if RS_MATHS_SIMD
+		if constexpr (SIMDFloat4<Type, N>)
+		{
+			RS::SIMD::Store(this->data, _mm_mul_ps(RS::SIMD::Load(this->data), _mm_set1_ps(scalar)));
+			return *this;
+		}
+#endif
 		for (SizeType i = (SizeType)0; i < N; ++i)
 			this->data[i] *= scalar;
 		return *this;
@@ -438,6 +474,13 @@ namespace RS_New
 	template<auto N, NumberType Type> requires VecSizeConstant<decltype(N)>
 	inline VecNew<N, Type>& VecNew<N, Type>::operator/=(const Type& scalar)
 	{
+#if RS_MATHS_SIMD
+		if constexpr (SIMDFloat4<Type, N>)
+		{
+			RS::SIMD::Store(this->data, _mm_div_ps(RS::SIMD::Load(this->data), _mm_set1_ps(scalar)));
+			return *this;
+		}
+#endif
 		for (SizeType i = (SizeType)0; i < N; ++i)
 			this->data[i] /= scalar;
 		return *this;
@@ -446,6 +489,13 @@ namespace RS_New
 	template<auto N, NumberType Type> requires VecSizeConstant<decltype(N)>
 	inline Type VecNew<N, Type>::Length2() const
 	{
+#if RS_MATHS_SIMD
+		if constexpr (SIMDFloat4<Type, N>)
+		{
+			const __m128 value = RS::SIMD::Load(this->data);
+			return _mm_cvtss_f32(RS::SIMD::Dot(value, value));
+		}
+#endif
 		Type result = (Type)0;
 		for (SizeType i = (SizeType)0; i < N; ++i)
 			result += (this->data[i] * this->data[i]);
@@ -463,6 +513,10 @@ namespace RS_New
 	template<NumberType Type2>
 	inline Type VecNew<N, Type>::Dot(const VecNew<N, Type2>& other) const
 	{
+#if RS_MATHS_SIMD
+		if constexpr (SIMDFloat4<Type, N> && std::same_as<Type, Type2>)
+			return _mm_cvtss_f32(RS::SIMD::Dot(RS::SIMD::Load(this->data), RS::SIMD::Load(other.data)));
+#endif
 		Type result = (Type)0;
 		for (SizeType i = (SizeType)0; i < N; ++i)
 			result += (this->data[i] * other.data[i]);
@@ -472,7 +526,18 @@ namespace RS_New
 	template<auto N, NumberType Type> requires VecSizeConstant<decltype(N)>
 	inline VecNew<N, Type> VecNew<N, Type>::Normalize() const
 	{
-		Type len = (Type)Length<double>();
+#if RS_MATHS_SIMD
+		if constexpr (SIMDFloat4<Type, N>)
+		{
+			const __m128 value = RS::SIMD::Load(this->data);
+			VecNew result(NoInit);
+			RS::SIMD::Store(result.data, _mm_div_ps(value, _mm_sqrt_ps(RS::SIMD::Dot(value, value))));
+			return result;
+		}
+#endif
+		// Floats stay in float, only integers and doubles need the precision of a double.
+		using LengthType = std::conditional_t<std::same_as<Type, float>, float, double>;
+		Type len = (Type)Length<LengthType>();
 		return *this / len;
 	}
 
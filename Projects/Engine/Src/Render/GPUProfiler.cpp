@@ -0,0 +1,132 @@
+#include "PreCompiled.h"
+#include "GPUProfiler.h"
+
+#include <algorithm>
+#include <chrono>
+
+RS::GPUProfiler::GPUProfiler(std::shared_ptr<IGPUTimestampQueue> pQueue, const GPUProfilerSettings& settings)
+	: m_pQueue(pQueue)
+	, m_Settings(settings)
+{
+	RS_ASSERT(m_pQueue, "The GPU profiler needs a queue!");
+	RS_ASSERT(m_Settings.framesInFlight > 0 && m_Settings.maxZonesPerFrame > 0, "The GPU profiler needs room for at least one zone!");
+
+	m_Track = Profiler::Get()->AddTrack(m_Settings.trackName);
+
+	m_Slots = std::make_unique<FrameSlot[]>(m_Settings.framesInFlight);
+	for (uint32 slot = 0; slot < m_Settings.framesInFlight; ++slot)
+		m_Slots[slot].zones = std::make_unique<ZoneRecord[]>(m_Settings.maxZonesPerFrame);
+	m_Slots[0].isRecording = true;
+}
+
+uint32 RS::GPUProfiler::BeginZone(const char* pName)
+{
+	FrameSlot& slot = m_Slots[m_CurrentSlot];
+	const uint32 zone = slot.zoneCount.fetch_add(1, std::memory_order_relaxed);
+	if (!slot.isRecording || zone >= m_Settings.maxZonesPerFrame)
+	{
+		m_DroppedZoneCount.fetch_add(1, std::memory_order_relaxed);
+		return InvalidQuery;
+	}
+
+	slot.zones[zone] = { pName, false };
+	return GetFirstQuery(m_CurrentSlot) + zone * 2;
+}
+
+void RS::GPUProfiler::EndZone(uint32 beginQuery)
+{
+	RS_ASSERT(beginQuery != InvalidQuery && beginQuery < GetQueryCount(m_Settings), "Query {} was not returned by BeginZone!", beginQuery);
+
+	const uint32 queriesPerSlot = m_Settings.maxZonesPerFrame * 2;
+	m_Slots[beginQuery / queriesPerSlot].zones[(beginQuery % queriesPerSlot) / 2].isEnded = true;
+}
+
+void RS::GPUProfiler::EndFrame()
+{
+	FrameSlot& slot = m_Slots[m_CurrentSlot];
+	if (slot.isRecording)
+	{
+		const uint32 zoneCount = slot.zoneCount.load(std::memory_order_relaxed);
+		slot.resolvedCount = std::min(zoneCount, m_Settings.maxZonesPerFrame);
+		slot.frameIndex = m_FrameIndex;
+		if (slot.resolvedCount > 0)
+		{
+			slot.fenceValue = m_pQueue->Resolve(GetFirstQuery(m_CurrentSlot), slot.resolvedCount * 2);
+			slot.isPending = true;
+		}
+	}
+	m_FrameIndex++;
+
+	// Oldest frame first, the one after the current slot.
+	for (uint32 i = 1; i <= m_Settings.framesInFlight; ++i)
+	{
+		const uint32 pendingSlot = (m_CurrentSlot + i) % m_Settings.framesInFlight;
+		if (m_Slots[pendingSlot].isPending && m_pQueue->IsComplete(m_Slots[pendingSlot].fenceValue))
+			ReadBack(pendingSlot);
+	}
+
+	// Queries the GPU has not resolved yet can not be used again, the zones of the next frame are dropped then.
+	m_CurrentSlot = (m_CurrentSlot + 1) % m_Settings.framesInFlight;
+	FrameSlot& nextSlot = m_Slots[m_CurrentSlot];
+	nextSlot.isRecording = !nextSlot.isPending;
+	nextSlot.zoneCount.store(0, std::memory_order_relaxed);
+}
+
+float RS::GPUProfiler::TakeResolvedGPUMs()
+{
+	const float ms = m_ResolvedGPUMs;
+	m_ResolvedGPUMs = 0.f;
+	return ms;
+}
+
+void RS::GPUProfiler::ReadBack(uint32 slot)
+{
+	FrameSlot& frameSlot = m_Slots[slot];
+	frameSlot.isPending = false;
+
+	uint64 gpuCalibration = 0;
+	uint64 cpuCalibration = 0;
+	m_pQueue->GetClockCalibration(gpuCalibration, cpuCalibration);
+	const double cpuTicksPerSecond = (double)std::chrono::steady_clock::period::den / (double)std::chrono::steady_clock::period::num;
+	const double cpuTicksPerGPUTick = cpuTicksPerSecond / (double)m_pQueue->GetTimestampFrequency();
+	auto ToCPUTick = [&](uint64 timestamp) { return cpuCalibration + (uint64)(int64)((double)(int64)(timestamp - gpuCalibration) * cpuTicksPerGPUTick); };
+
+	m_ResolvedZones.clear();
+	m_ResolvedFrameIndex = frameSlot.frameIndex;
+	const uint64* pTimestamps = m_pQueue->MapTimestamps(GetFirstQuery(slot), frameSlot.resolvedCount * 2);
+	for (uint32 zone = 0; zone < frameSlot.resolvedCount; ++zone)
+	{
+		const ZoneRecord& record = frameSlot.zones[zone];
+		if (!record.isEnded)
+		{
+			m_DroppedZoneCount.fetch_add(1, std::memory_order_relaxed);
+			continue;
+		}
+
+		const uint64 begin = ToCPUTick(pTimestamps[zone * 2]);
+		const uint64 end = std::max(ToCPUTick(pTimestamps[zone * 2 + 1]), begin);
+		m_ResolvedZones.push_back({ record.pName, begin, end, 0, m_Track });
+	}
+	m_pQueue->UnmapTimestamps();
+
+	// The queue runs the command lists one after the other, so the zones nest by time. The enclosing zone comes first.
+	std::sort(m_ResolvedZones.begin(), m_ResolvedZones.end(), [](const Profiler::Zone& a, const Profiler::Zone& b)
+		{
+			return a.begin != b.begin ? a.begin < b.begin : a.end > b.end;
+		});
+
+	std::vector<uint64> openZoneEnds;
+	uint64 busyTicks = 0;
+	for (Profiler::Zone& zone : m_ResolvedZones)
+	{
+		while (!openZoneEnds.empty() && openZoneEnds.back() <= zone.begin)
+			openZoneEnds.pop_back();
+		zone.depth = (uint32)openZoneEnds.size();
+		openZoneEnds.push_back(zone.end);
+		if (zone.depth == 0)
+			busyTicks += zone.end - zone.begin;
+
+		Profiler::Get()->RecordZone(m_Track, zone.pName, zone.begin, zone.end, zone.depth);
+	}
+	m_ResolvedGPUMs = (float)Profiler::TicksToMs(busyTicks);
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "Core/Profiler.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace RS
+{
+	/*
+	* The GPU side of the GPUProfiler, a timestamp query heap on one queue and the memory the timestamps are resolved to.
+	* All functions are called from the thread that calls GPUProfiler::EndFrame.
+	*/
+	class IGPUTimestampQueue
+	{
+	public:
+		virtual ~IGPUTimestampQueue() = default;
+
+		// Timestamp ticks per second.
+		virtual uint64 GetTimestampFrequency() const = 0;
+		// A timestamp and the Timer::GetCurrentTick tick taken at the same moment.
+		virtual void GetClockCalibration(uint64& gpuTimestamp, uint64& cpuTick) const = 0;
+
+		/*
+		* Copies the queries [firstQuery, firstQuery + count) to the readback memory after the work that was submitted
+		* before. Returns a fence value that is complete when the copy is done.
+		*/
+		virtual uint64 Resolve(uint32 firstQuery, uint32 count) = 0;
+		virtual bool IsComplete(uint64 fenceValue) const = 0;
+
+		// The timestamps [firstQuery, firstQuery + count) from the last completed resolve of them.
+		virtual const uint64* MapTimestamps(uint32 firstQuery, uint32 count) = 0;
+		virtual void UnmapTimestamps() = 0;
+	};
+
+	struct GPUProfilerSettings
+	{
+		uint32 framesInFlight = 3;			// Frames that can be recorded before the GPU has to be done with the oldest.
+		uint32 maxZonesPerFrame = 256;
+		std::string trackName = "GPU";		// Name of the row of the zones in the Profiler.
+	};
+
+	/*
+	* GPU zones, timed with two timestamp queries each. Each frame in flight has its own range of the query heap. EndFrame
+	* resolves the range of the frame and reads back the ranges of earlier frames the GPU is done with. Their zones are
+	* moved to CPU time and recorded on a track of the Profiler, so they are shown and exported with the CPU zones.
+	*
+	* BeginZone and EndZone can be called from any thread while a frame is recorded. EndFrame is called once per frame
+	* after the work of the frame has been submitted.
+	*/
+	class GPUProfiler
+	{
+	public:
+		inline static constexpr uint32 InvalidQuery = UINT32_MAX;
+
+	public:
+		GPUProfiler(std::shared_ptr<IGPUTimestampQueue> pQueue, const GPUProfilerSettings& settings = GPUProfilerSettings());
+		RS_NO_COPY_AND_MOVE(GPUProfiler)
+
+		// The size of the query heap the queue needs.
+		static uint32 GetQueryCount(const GPUProfilerSettings& settings) { return settings.framesInFlight * settings.maxZonesPerFrame * 2; }
+
+		/*
+		* Returns the query to write the begin timestamp to, the end timestamp goes to the one after it. Returns
+		* InvalidQuery when the frame has no room left, the zone is not timed then. Only the pointer of the name is stored.
+		*/
+		uint32 BeginZone(const char* pName);
+		// Call after the end timestamp has been written.
+		void EndZone(uint32 beginQuery);
+
+		void EndFrame();
+
+		// Zones of the newest frame that was read back, sorted by begin. The times are in Timer::GetCurrentTick ticks.
+		const std::vector<Profiler::Zone>& GetResolvedZones() const { return m_ResolvedZones; }
+		uint64 GetResolvedFrameIndex() const { return m_ResolvedFrameIndex; }
+
+		// The time the queue spent in the outermost zones of the newest frame that was read back since the last call, 0 when none was.
+		float TakeResolvedGPUMs();
+
+		// Zones that did not fit in their frame, were recorded while the queries were still in use or never ended.
+		uint64 GetDroppedZoneCount() const { return m_DroppedZoneCount.load(std::memory_order_relaxed); }
+
+		uint32 GetTrack() const { return m_Track; }
+
+	private:
+		struct ZoneRecord
+		{
+			const char*	pName = nullptr;
+			bool		isEnded = false;
+		};
+
+		struct FrameSlot
+		{
+			std::unique_ptr<ZoneRecord[]>	zones;
+			std::atomic<uint32>				zoneCount = 0;	// Can be larger than maxZonesPerFrame, the extra zones were dropped.
+			uint32							resolvedCount = 0;
+			uint64							fenceValue = 0;
+			uint64							frameIndex = 0;
+			bool							isRecording = false;
+			bool							isPending = false; // Resolved, but not read back yet.
+		};
+
+		uint32 GetFirstQuery(uint32 slot) const { return slot * m_Settings.maxZonesPerFrame * 2; }
+
+		void ReadBack(uint32 slot);
+
+	private:
+		std::shared_ptr<IGPUTimestampQueue>	m_pQueue;
+		GPUProfilerSettings					m_Settings;
+		uint32								m_Track = 0;
+
+		std::unique_ptr<FrameSlot[]>		m_Slots;
+		uint32								m_CurrentSlot = 0;
+		uint64								m_FrameIndex = 0;
+
+		std::vector<Profiler::Zone>			m_ResolvedZones;
+		uint64								m_ResolvedFrameIndex = 0;
+		float								m_ResolvedGPUMs = 0.f;
+		std::atomic<uint64>					m_DroppedZoneCount = 0;
+	};
+}
@@ -0,0 +1,412 @@
+#include "PreCompiled.h"
+#include "PathTracer.h"
+
+#include "Core/ThreadPool.h"
+
+#include "Maths/GLMDefines.h"
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <numbers>
+
+namespace RS::_PathTracerInternal
+{
+	void Store(const glm::vec3& v, float out[3])
+	{
+		out[0] = v.x;
+		out[1] = v.y;
+		out[2] = v.z;
+	}
+
+	glm::vec3 Normalize(const glm::vec3& v)
+	{
+		const float lengthSquared = glm::dot(v, v);
+		return lengthSquared > 0.f ? v * (1.f / std::sqrt(lengthSquared)) : glm::vec3(0.f);
+	}
+
+	float MaxComponent(const glm::vec3& v)
+	{
+		return std::max({ v.x, v.y, v.z });
+	}
+
+	glm::vec3 Transform(const float m[3][4], const glm::vec3& p)
+	{
+		return glm::vec3(
+			m[0][0] * p.x + m[0][1] * p.y + m[0][2] * p.z + m[0][3],
+			m[1][0] * p.x + m[1][1] * p.y + m[1][2] * p.z + m[1][3],
+			m[2][0] * p.x + m[2][1] * p.y + m[2][2] * p.z + m[2][3]);
+	}
+
+	glm::vec3 Transform(const float m[3][3], const glm::vec3& v)
+	{
+		return glm::vec3(
+			m[0][0] * v.x + m[0][1] * v.y + m[0][2] * v.z,
+			m[1][0] * v.x + m[1][1] * v.y + m[1][2] * v.z,
+			m[2][0] * v.x + m[2][1] * v.y + m[2][2] * v.z);
+	}
+
+	// PCG, seeded from the pixel and the sample so every sample gets the same numbers on any thread.
+	uint32 Hash(uint32 value)
+	{
+		const uint32 state = value * 747796405u + 2891336453u;
+		const uint32 word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+		return (word >> 22u) ^ word;
+	}
+
+	class Random
+	{
+	public:
+		Random() = default;
+		Random(uint32 pixel, uint32 sample, uint32 seed) : m_State(Hash(pixel + Hash(sample + Hash(seed)))) {}
+
+		float Next()
+		{
+			m_State = Hash(m_State);
+			return (m_State >> 8) * (1.f / 16777216.f);
+		}
+
+	private:
+		uint32 m_State = 0;
+	};
+
+	// Cosine weighted around the normal, the pdf cancels the cosine and the 1 / pi of a diffuse surface.
+	glm::vec3 SampleHemisphere(const glm::vec3& normal, Random& random)
+	{
+		const float u = random.Next(), v = random.Next();
+		const float radius = std::sqrt(u);
+		const float angle = 2.f * std::numbers::pi_v<float> * v;
+		const float x = radius * std::cos(angle), y = radius * std::sin(angle), z = std::sqrt(std::max(0.f, 1.f - u));
+
+		// Duff et al. 2017, Building an Orthonormal Basis, Revisited.
+		const float sign = std::copysign(1.f, normal.z);
+		const float a = -1.f / (sign + normal.z);
+		const float b = normal.x * normal.y * a;
+		const glm::vec3 tangent(1.f + sign * normal.x * normal.x * a, sign * b, -sign * normal.x);
+		const glm::vec3 bitangent(b, sign + normal.y * normal.y * a, -normal.y);
+		return tangent * x + bitangent * y + normal * z;
+	}
+
+	struct Path
+	{
+		Ray ray;
+		glm::vec3 throughput = glm::vec3(0.f);
+		uint32 pixel;
+		Random random;
+	};
+
+	struct ShadowRay
+	{
+		Ray ray;
+		glm::vec3 radiance = glm::vec3(0.f);
+		uint32 pixel;
+	};
+
+	void SetRay(Ray& ray, const glm::vec3& origin, const glm::vec3& direction, const PathTracerSettings& settings)
+	{
+		Store(origin, ray.origin);
+		Store(direction, ray.direction);
+		ray.tMin = settings.tMin;
+		ray.tMax = settings.tMax;
+		ray.cullBackFacing = settings.cullBackFacing;
+	}
+}
+
+uint32 RS::PathTracerScene::AddMesh(const Mesh& mesh, const BVHBuildSettings& settings)
+{
+	auto pMesh = std::make_unique<SceneMesh>();
+	pMesh->mesh = mesh;
+	pMesh->bvh.Build(pMesh->mesh.indices, pMesh->mesh.vertices, settings);
+	if (pMesh->mesh.indices.empty())
+	{
+		for (uint32 i = 0; i < pMesh->bvh.GetTriangleCount() * 3; ++i)
+			pMesh->mesh.indices.push_back(i);
+	}
+	m_Meshes.push_back(std::move(pMesh));
+	return (uint32)m_Meshes.size() - 1;
+}
+
+uint32 RS::PathTracerScene::AddMaterial(const PathTracerMaterial& material)
+{
+	m_Materials.push_back(material);
+	return (uint32)m_Materials.size() - 1;
+}
+
+uint32 RS::PathTracerScene::AddInstance(uint32 meshIndex, uint32 materialIndex, const float transform[3][4])
+{
+	RS_ASSERT(meshIndex < m_Meshes.size(), "Mesh {} has not been added!", meshIndex);
+	RS_ASSERT(materialIndex < m_Materials.size(), "Material {} has not been added!", materialIndex);
+
+	SceneInstance instance = {};
+	instance.meshIndex = meshIndex;
+	instance.materialIndex = materialIndex;
+	for (uint32 row = 0; row < 3; ++row)
+	{
+		for (uint32 column = 0; column < 4; ++column)
+			instance.transform[row][column] = transform ? transform[row][column] : (row == column ? 1.f : 0.f);
+	}
+
+	const float (&m)[3][4] = instance.transform;
+	instance.normalTransform[0][0] = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+	instance.normalTransform[0][1] = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+	instance.normalTransform[0][2] = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+	instance.normalTransform[1][0] = m[2][1] * m[0][2] - m[0][1] * m[2][2];
+	instance.normalTransform[1][1] = m[0][0] * m[2][2] - m[0][2] * m[2][0];
+	instance.normalTransform[1][2] = m[0][1] * m[2][0] - m[0][0] * m[2][1];
+	instance.normalTransform[2][0] = m[0][1] * m[1][2] - m[0][2] * m[1][1];
+	instance.normalTransform[2][1] = m[0][2] * m[1][0] - m[0][0] * m[1][2];
+	instance.normalTransform[2][2] = m[0][0] * m[1][1] - m[0][1] * m[1][0];
+
+	m_Instances.push_back(instance);
+	return (uint32)m_Instances.size() - 1;
+}
+
+void RS::PathTracerScene::Build()
+{
+	std::vector<BVHInstance<BVHWidth>> instances(m_Instances.size());
+	for (uint32 i = 0; i < (uint32)m_Instances.size(); ++i)
+	{
+		instances[i].pMesh = &m_Meshes[m_Instances[i].meshIndex]->bvh;
+		std::memcpy(instances[i].transform, m_Instances[i].transform, sizeof(instances[i].transform));
+		instances[i].instanceID = i;
+	}
+	m_SceneBVH.Build(instances);
+}
+
+void RS::PathTracerScene::GetSurface(const RayHit& hit, float position[3], float geometricNormal[3], float shadingNormal[3]) const
+{
+	using namespace _PathTracerInternal;
+
+	const SceneInstance& instance = m_Instances[hit.instance];
+	const Mesh& mesh = m_Meshes[instance.meshIndex]->mesh;
+	const Vertex* pVertices[3];
+	for (uint32 corner = 0; corner < 3; ++corner)
+		pVertices[corner] = &mesh.vertices[mesh.indices[(uint64)hit.primitive * 3 + corner]];
+
+	const glm::vec3 p0 = pVertices[0]->position, p1 = pVertices[1]->position, p2 = pVertices[2]->position;
+	const float w = 1.f - hit.u - hit.v;
+	Store(Transform(instance.transform, p0 * w + p1 * hit.u + p2 * hit.v), position);
+
+	const glm::vec3 normal = Normalize(Transform(instance.normalTransform, glm::cross(p1 - p0, p2 - p0)));
+	Store(normal, geometricNormal);
+
+	const glm::vec3 interpolated = glm::vec3(pVertices[0]->normal) * w + glm::vec3(pVertices[1]->normal) * hit.u + glm::vec3(pVertices[2]->normal) * hit.v;
+	const glm::vec3 smooth = Normalize(Transform(instance.normalTransform, interpolated));
+	Store(glm::dot(smooth, smooth) > 0.f ? smooth : normal, shadingNormal);
+}
+
+const RS::PathTracerMaterial& RS::PathTracerScene::GetMaterial(const RayHit& hit) const
+{
+	return m_Materials[m_Instances[hit.instance].materialIndex];
+}
+
+void RS::PathTracer::Resize(uint32 width, uint32 height)
+{
+	m_Width = width;
+	m_Height = height;
+	Reset();
+}
+
+void RS::PathTracer::Reset()
+{
+	m_Accumulation.assign((uint64)m_Width * m_Height * 4, 0.f);
+	m_SampleCount = 0;
+}
+
+RS::PathTracerStats RS::PathTracer::Render(const PathTracerScene& scene, const PathTracerCamera& camera, const PathTracerSettings& settings)
+{
+	RS_ASSERT(settings.tileSize > 0, "Tile size cannot be 0!");
+
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	const uint32 tileCountX = (m_Width + settings.tileSize - 1) / settings.tileSize;
+	const uint32 tileCountY = (m_Height + settings.tileSize - 1) / settings.tileSize;
+	const uint32 tileCount = tileCountX * tileCountY;
+	std::atomic<uint64> rayCount = 0;
+	ThreadPool::Get()->ParallelFor(tileCount, [&](uint64 tile)
+		{
+			rayCount += RenderTile(scene, camera, settings, (uint32)(tile % tileCountX), (uint32)(tile / tileCountX));
+		}, settings.maxThreads);
+	m_SampleCount += settings.samplesPerPixel;
+
+	const uint availableThreads = ThreadPool::Get()->GetThreadCount() + 1;
+	PathTracerStats stats;
+	stats.rayCount = rayCount;
+	stats.seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - startTime).count();
+	stats.threadCount = std::min<uint>(settings.maxThreads > 0 ? std::min(settings.maxThreads, availableThreads) : availableThreads, std::max(tileCount, 1u));
+	return stats;
+}
+
+uint64 RS::PathTracer::RenderTile(const PathTracerScene& scene, const PathTracerCamera& camera, const PathTracerSettings& settings, uint32 tileX, uint32 tileY)
+{
+	using namespace _PathTracerInternal;
+
+	const uint32 startX = tileX * settings.tileSize, endX = std::min(startX + settings.tileSize, m_Width);
+	const uint32 startY = tileY * settings.tileSize, endY = std::min(startY + settings.tileSize, m_Height);
+	const bool isPathTracing = settings.mode == PathTracerMode::PathTracing;
+	const Viewport& viewport = camera.rayGen.viewport;
+	const Viewport& stencil = camera.rayGen.stencil;
+
+	const glm::vec3 forward = Normalize(glm::make_vec3(camera.forward));
+	const glm::vec3 right = Normalize(glm::cross(glm::make_vec3(camera.up), forward));
+	const glm::vec3 up = glm::cross(forward, right);
+	const float tanHalfFov = std::tan(camera.verticalFov * 0.5f);
+	const float aspectRatio = m_Height > 0 ? (float)m_Width / m_Height : 1.f;
+
+	const glm::vec3 sunDirection = Normalize(glm::make_vec3(settings.sunDirection));
+	const glm::vec3 sunColor = glm::make_vec3(settings.sunColor);
+	const bool hasSun = MaxComponent(sunColor) > 0.f && glm::dot(sunDirection, sunDirection) > 0.f;
+
+	std::vector<Path> paths, nextPaths;
+	std::vector<ShadowRay> shadowRays;
+	paths.reserve((uint64)(endX - startX) * (endY - startY));
+	uint64 rayCount = 0;
+
+	for (uint32 sample = m_SampleCount; sample < m_SampleCount + settings.samplesPerPixel; ++sample)
+	{
+		paths.clear();
+		for (uint32 y = startY; y < endY; ++y)
+		{
+			for (uint32 x = startX; x < endX; ++x)
+			{
+				// The ray generation shader uses DispatchRaysIndex() / DispatchRaysDimensions(), the corner of the pixel.
+				const uint32 pixel = y * m_Width + x;
+				Random random(pixel, sample, settings.seed);
+				const float jitterX = isPathTracing ? random.Next() : 0.f;
+				const float jitterY = isPathTracing ? random.Next() : 0.f;
+				const float lerpX = (x + jitterX) / m_Width;
+				const float lerpY = (y + jitterY) / m_Height;
+
+				glm::vec3 origin(0.f), direction(0.f);
+				if (camera.isPerspective)
+				{
+					origin = glm::make_vec3(camera.position);
+					direction = forward + right * ((2.f * lerpX - 1.f) * tanHalfFov * aspectRatio) + up * ((1.f - 2.f * lerpY) * tanHalfFov);
+				}
+				else
+				{
+					origin = glm::vec3(std::lerp(viewport.left, viewport.right, lerpX), std::lerp(viewport.top, viewport.bottom, lerpY), 0.f);
+					direction = glm::vec3(0.f, 0.f, 1.f);
+					if (origin.x < stencil.left || origin.x > stencil.right || origin.y < stencil.top || origin.y > stencil.bottom)
+					{
+						float* pColor = &m_Accumulation[(uint64)pixel * 4];
+						pColor[0] += lerpX;
+						pColor[1] += lerpY;
+						pColor[3] += 1.f;
+						continue;
+					}
+				}
+
+				Path& path = paths.emplace_back();
+				SetRay(path.ray, origin, direction, settings);
+				path.throughput = glm::vec3(1.f, 1.f, 1.f);
+				path.pixel = pixel;
+				path.random = random;
+				m_Accumulation[(uint64)pixel * 4 + 3] += 1.f;
+			}
+		}
+
+		for (uint32 bounce = 0; !paths.empty(); ++bounce)
+		{
+			nextPaths.clear();
+			shadowRays.clear();
+			for (Path& path : paths)
+			{
+				float* pColor = &m_Accumulation[(uint64)path.pixel * 4];
+				RayHit hit;
+				rayCount++;
+				if (!scene.Intersect(path.ray, hit))
+				{
+					if (isPathTracing)
+						Store(glm::make_vec3(pColor) + path.throughput * glm::make_vec3(settings.skyColor), pColor);
+					continue;
+				}
+
+				if (!isPathTracing)
+				{
+					pColor[0] += 1.f - hit.u - hit.v;
+					pColor[1] += hit.u;
+					pColor[2] += hit.v;
+					continue;
+				}
+
+				const PathTracerMaterial& material = scene.GetMaterial(hit);
+				Store(glm::make_vec3(pColor) + path.throughput * glm::make_vec3(material.emission), pColor);
+				if (bounce >= settings.maxBounces)
+					continue;
+
+				float position[3], geometricNormalValues[3], shadingNormalValues[3];
+				scene.GetSurface(hit, position, geometricNormalValues, shadingNormalValues);
+				const glm::vec3 rayDirection = glm::make_vec3(path.ray.direction);
+				glm::vec3 geometricNormal = glm::make_vec3(geometricNormalValues), shadingNormal = glm::make_vec3(shadingNormalValues);
+				if (glm::dot(geometricNormal, rayDirection) > 0.f)
+					geometricNormal = -geometricNormal;
+				if (glm::dot(shadingNormal, geometricNormal) < 0.f)
+					shadingNormal = -shadingNormal;
+
+				// Off the surface, scaled with the position since that is what the precision depends on.
+				const glm::vec3 hitPosition = glm::make_vec3(position);
+				const float offsetScale = 1e-4f * (1.f + std::max({ std::abs(hitPosition.x), std::abs(hitPosition.y), std::abs(hitPosition.z) }));
+				const glm::vec3 origin = hitPosition + geometricNormal * offsetScale;
+				const glm::vec3 albedo = glm::make_vec3(material.albedo);
+
+				if (hasSun)
+				{
+					const float cosine = glm::dot(shadingNormal, sunDirection);
+					if (cosine > 0.f && glm::dot(geometricNormal, sunDirection) > 0.f)
+					{
+						ShadowRay& shadowRay = shadowRays.emplace_back();
+						SetRay(shadowRay.ray, origin, sunDirection, settings);
+						shadowRay.radiance = path.throughput * albedo * sunColor * (cosine / std::numbers::pi_v<float>);
+						shadowRay.pixel = path.pixel;
+					}
+				}
+
+				const glm::vec3 direction = SampleHemisphere(shadingNormal, path.random);
+				if (glm::dot(direction, geometricNormal) <= 0.f)
+					continue;
+
+				Path& nextPath = nextPaths.emplace_back(path);
+				SetRay(nextPath.ray, origin, direction, settings);
+				nextPath.throughput = path.throughput * albedo;
+
+				// Russian roulette, paths that cannot add much end early and the ones that go on make up for them.
+				if (bounce >= 2)
+				{
+					const float survival = std::clamp(MaxComponent(nextPath.throughput), 0.05f, 0.95f);
+					if (nextPath.random.Next() >= survival)
+						nextPaths.pop_back();
+					else
+						nextPath.throughput = nextPath.throughput * (1.f / survival);
+				}
+			}
+
+			for (const ShadowRay& shadowRay : shadowRays)
+			{
+				rayCount++;
+				if (!scene.IsOccluded(shadowRay.ray))
+				{
+					float* pColor = &m_Accumulation[(uint64)shadowRay.pixel * 4];
+					Store(glm::make_vec3(pColor) + shadowRay.radiance, pColor);
+				}
+			}
+			std::swap(paths, nextPaths);
+		}
+	}
+	return rayCount;
+}
+
+RS::ReferenceImage RS::PathTracer::GetImage() const
+{
+	ReferenceImage image(m_Width, m_Height);
+	if (m_SampleCount == 0)
+		return image;
+
+	const float scale = 1.f / m_SampleCount;
+	std::span<float> pixels = image.GetData();
+	for (uint64 i = 0; i < pixels.size(); ++i)
+		pixels[i] = m_Accumulation[i] * scale;
+	return image;
+}
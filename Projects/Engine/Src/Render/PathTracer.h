@@ -0,0 +1,141 @@
+#pragma once
+
+#include "Maths/BVH/SceneBVH.h"
+#include "Render/ReferenceImage.h"
+#include "DX12/RaytracingHlslCompat.h"
+
+namespace RS
+{
+	struct PathTracerMaterial
+	{
+		float albedo[3] = { 0.8f, 0.8f, 0.8f };
+		float emission[3] = {};
+	};
+
+	/*
+	* Meshes, materials and instances, the same things the DXR path builds its acceleration structures from.
+	* Meshes and instances are added first, then Build creates the top level BVH. The instance order is the instance index.
+	*/
+	class PathTracerScene
+	{
+	public:
+		static constexpr uint32 BVHWidth = 4;
+
+		uint32 AddMesh(const Mesh& mesh, const BVHBuildSettings& settings = BVHBuildSettings());
+		uint32 AddMaterial(const PathTracerMaterial& material);
+		// Object to world, row major 3x4 like D3D12_RAYTRACING_INSTANCE_DESC::Transform. nullptr is the identity.
+		uint32 AddInstance(uint32 meshIndex, uint32 materialIndex, const float transform[3][4] = nullptr);
+		void Build();
+
+		bool Intersect(const Ray& ray, RayHit& hit) const { return m_SceneBVH.Intersect(ray, hit); }
+		bool IsOccluded(const Ray& ray) const { return m_SceneBVH.IsOccluded(ray); }
+
+		/*
+		* World space position, geometric normal and shading normal of a hit. The normals are normalized but can face either way.
+		*/
+		void GetSurface(const RayHit& hit, float position[3], float geometricNormal[3], float shadingNormal[3]) const;
+		const PathTracerMaterial& GetMaterial(const RayHit& hit) const;
+
+		const AABB& GetBounds() const { return m_SceneBVH.GetBounds(); }
+
+	private:
+		struct SceneMesh
+		{
+			Mesh mesh;
+			MeshBVH<BVHWidth> bvh;
+		};
+
+		struct SceneInstance
+		{
+			uint32 meshIndex;
+			uint32 materialIndex;
+			float transform[3][4];
+			float normalTransform[3][3];	// Cofactors of the transform, normals only need the direction.
+		};
+
+		std::vector<std::unique_ptr<SceneMesh>> m_Meshes;
+		std::vector<PathTracerMaterial> m_Materials;
+		std::vector<SceneInstance> m_Instances;
+		SceneBVH<BVHWidth> m_SceneBVH;
+	};
+
+	enum class PathTracerMode
+	{
+		// What Raytracing.hlsl writes: barycentrics on a hit, black on a miss and the lerp values outside the stencil.
+		Barycentrics,
+		// Diffuse materials lit by emission, the sky and the sun.
+		PathTracing,
+	};
+
+	/*
+	* Orthographic by default, with the rays made like the ray generation shader does from a RayGenConstantBuffer:
+	* lerped over the viewport at z = 0, looking down +z. A perspective camera ignores rayGen.
+	*/
+	struct PathTracerCamera
+	{
+		RayGenConstantBuffer rayGen = { { -1.f, -1.f, 1.f, 1.f }, { -1.f, -1.f, 1.f, 1.f } };
+
+		bool isPerspective = false;
+		float position[3] = {};
+		float forward[3] = { 0.f, 0.f, 1.f };
+		float up[3] = { 0.f, 1.f, 0.f };
+		float verticalFov = 1.0471976f;		// 60 degrees.
+	};
+
+	struct PathTracerSettings
+	{
+		PathTracerMode mode = PathTracerMode::PathTracing;
+		uint32 samplesPerPixel = 1;			// Added to the accumulation by every Render call.
+		uint32 maxBounces = 4;
+		uint32 tileSize = 16;
+		uint maxThreads = 0;				// Works like it does for ThreadPool::ParallelFor.
+		uint32 seed = 0;
+
+		// The same extents and flags as the TraceRay call of the ray generation shader.
+		float tMin = 0.001f;
+		float tMax = 10000.f;
+		bool cullBackFacing = true;
+
+		float skyColor[3] = {};
+		float sunDirection[3] = { 0.f, 1.f, 0.f };	// Towards the sun.
+		float sunColor[3] = {};						// Irradiance at normal incidence, black turns the sun off.
+	};
+
+	struct PathTracerStats
+	{
+		uint64 rayCount = 0;				// Camera, bounce and shadow rays.
+		double seconds = 0.0;
+		uint threadCount = 0;
+
+		double GetRaysPerSecond() const { return seconds > 0.0 ? rayCount / seconds : 0.0; }
+		double GetRaysPerSecondPerCore() const { return threadCount > 0 ? GetRaysPerSecond() / threadCount : 0.0; }
+	};
+
+	/*
+	* CPU reference for the DXR output, to make golden images where there is no DXR device.
+	* The image is split into tiles that are traced in parallel, and every tile is traced as streams of rays: all camera rays of the
+	* tile, then all rays of the next bounce that are still alive, and so on. Every Render call adds samples to the accumulation,
+	* and the random numbers only depend on the pixel and the sample, so the image is the same for any thread count.
+	*/
+	class PathTracer
+	{
+	public:
+		// Clears the accumulation.
+		void Resize(uint32 width, uint32 height);
+		void Reset();
+
+		PathTracerStats Render(const PathTracerScene& scene, const PathTracerCamera& camera, const PathTracerSettings& settings);
+
+		// The mean of all samples so far.
+		ReferenceImage GetImage() const;
+		uint32 GetSampleCount() const { return m_SampleCount; }
+
+	private:
+		uint64 RenderTile(const PathTracerScene& scene, const PathTracerCamera& camera, const PathTracerSettings& settings, uint32 tileX, uint32 tileY);
+
+		uint32 m_Width = 0;
+		uint32 m_Height = 0;
+		uint32 m_SampleCount = 0;
+		std::vector<float> m_Accumulation;	// RGBA sums.
+	};
+}
@@ -0,0 +1,347 @@
+#include "PreCompiled.h"
+#include "ReferenceImage.h"
+
+#include "Core/VFS.h"
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+#include <filesystem>
+#include <fstream>
+#include <cmath>
+
+namespace RS::_ReferenceImageInternal
+{
+	// Sorted by name, which is how EXR wants them.
+	constexpr const char* ChannelNames[] = { "A", "B", "G", "R" };
+	constexpr uint32 ChannelOffsets[] = { 3, 2, 1, 0 };
+	constexpr int32 PixelTypeFloat = 2;
+
+	bool WriteFile(const std::string& path, std::span<const uint8> data)
+	{
+		std::error_code error;
+		std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+		std::ofstream stream(path, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!stream.is_open())
+		{
+			LOG_ERROR("Failed to open {} for writing!", path.c_str());
+			return false;
+		}
+		stream.write((const char*)data.data(), data.size());
+		if (!stream.good())
+		{
+			LOG_ERROR("Failed to write {}!", path.c_str());
+			return false;
+		}
+		return true;
+	}
+
+	template<typename T>
+	void Append(std::vector<uint8>& data, const T& value)
+	{
+		const uint8* pBytes = (const uint8*)&value;
+		data.insert(data.end(), pBytes, pBytes + sizeof(T));
+	}
+
+	void AppendString(std::vector<uint8>& data, const char* pString)
+	{
+		data.insert(data.end(), pString, pString + std::strlen(pString) + 1);
+	}
+
+	void AppendAttribute(std::vector<uint8>& data, const char* pName, const char* pType, std::span<const uint8> value)
+	{
+		AppendString(data, pName);
+		AppendString(data, pType);
+		Append(data, (int32)value.size());
+		data.insert(data.end(), value.begin(), value.end());
+	}
+
+	template<typename T>
+	void AppendAttribute(std::vector<uint8>& data, const char* pName, const char* pType, const T& value)
+	{
+		AppendAttribute(data, pName, pType, std::span<const uint8>((const uint8*)&value, sizeof(T)));
+	}
+
+	class Reader
+	{
+	public:
+		explicit Reader(std::span<const uint8> data) : m_Data(data) {}
+
+		template<typename T>
+		bool Read(T& value)
+		{
+			if (m_Offset + sizeof(T) > m_Data.size())
+				return false;
+			std::memcpy(&value, m_Data.data() + m_Offset, sizeof(T));
+			m_Offset += sizeof(T);
+			return true;
+		}
+
+		bool ReadString(std::string& value)
+		{
+			const uint8* pStart = m_Data.data() + m_Offset;
+			const uint8* pEnd = (const uint8*)std::memchr(pStart, 0, m_Data.size() - m_Offset);
+			if (!pEnd)
+				return false;
+			value.assign((const char*)pStart, pEnd - pStart);
+			m_Offset += value.size() + 1;
+			return true;
+		}
+
+		bool Skip(uint64 size)
+		{
+			if (m_Offset + size > m_Data.size())
+				return false;
+			m_Offset += size;
+			return true;
+		}
+
+		uint64 GetOffset() const { return m_Offset; }
+		void SetOffset(uint64 offset) { m_Offset = offset; }
+
+	private:
+		std::span<const uint8> m_Data;
+		uint64 m_Offset = 0;
+	};
+
+	uint8 ToUNorm8(float value, bool isSRGB)
+	{
+		value = std::clamp(value, 0.f, 1.f);
+		if (isSRGB)
+			value = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.f / 2.4f) - 0.055f;
+		return (uint8)(value * 255.f + 0.5f);
+	}
+}
+
+RS::ReferenceImage::ReferenceImage(uint32 width, uint32 height)
+	: m_Width(width), m_Height(height), m_Pixels((uint64)width * height * 4, 0.f)
+{
+}
+
+bool RS::ReferenceImage::WritePNG(const std::string& path, bool isSRGB) const
+{
+	using namespace _ReferenceImageInternal;
+
+	std::vector<uint8> pixels(m_Pixels.size());
+	for (uint64 i = 0; i < m_Pixels.size(); ++i)
+		pixels[i] = ToUNorm8(m_Pixels[i], isSRGB && (i % 4) != 3);
+
+	std::vector<uint8> png;
+	auto writeFunc = [](void* pContext, void* pData, int size)
+	{
+		std::vector<uint8>& result = *(std::vector<uint8>*)pContext;
+		result.insert(result.end(), (const uint8*)pData, (const uint8*)pData + size);
+	};
+	if (m_Pixels.empty() || !stbi_write_png_to_func(writeFunc, &png, (int)m_Width, (int)m_Height, 4, pixels.data(), (int)m_Width * 4))
+	{
+		LOG_ERROR("Failed to encode {} as PNG!", path.c_str());
+		return false;
+	}
+	return WriteFile(path, png);
+}
+
+bool RS::ReferenceImage::WriteEXR(const std::string& path) const
+{
+	return _ReferenceImageInternal::WriteFile(path, EncodeEXR());
+}
+
+std::vector<uint8> RS::ReferenceImage::EncodeEXR() const
+{
+	using namespace _ReferenceImageInternal;
+
+	std::vector<uint8> data;
+	Append(data, (uint32)20000630);		// Magic number.
+	Append(data, (uint32)2);				// Version 2, single part scanline file.
+
+	std::vector<uint8> channels;
+	for (const char* pName : ChannelNames)
+	{
+		AppendString(channels, pName);
+		Append(channels, PixelTypeFloat);
+		Append(channels, (uint32)0);		// pLinear and three reserved bytes.
+		Append(channels, (int32)1);			// x and y sampling.
+		Append(channels, (int32)1);
+	}
+	channels.push_back(0);
+	AppendAttribute(data, "channels", "chlist", std::span<const uint8>(channels));
+	AppendAttribute(data, "compression", "compression", (uint8)0);
+	const int32 window[4] = { 0, 0, (int32)m_Width - 1, (int32)m_Height - 1 };
+	AppendAttribute(data, "dataWindow", "box2i", window);
+	AppendAttribute(data, "displayWindow", "box2i", window);
+	AppendAttribute(data, "lineOrder", "lineOrder", (uint8)0);
+	AppendAttribute(data, "pixelAspectRatio", "float", 1.f);
+	const float center[2] = { 0.f, 0.f };
+	AppendAttribute(data, "screenWindowCenter", "v2f", center);
+	AppendAttribute(data, "screenWindowWidth", "float", 1.f);
+	data.push_back(0);
+
+	// One scanline per block, so the offset table has one entry per line.
+	const uint32 lineSize = m_Width * 4 * sizeof(float);
+	const uint64 firstBlock = data.size() + (uint64)m_Height * sizeof(uint64);
+	for (uint32 y = 0; y < m_Height; ++y)
+		Append(data, firstBlock + (uint64)y * (lineSize + 8));
+
+	data.reserve(data.size() + (uint64)m_Height * (lineSize + 8));
+	for (uint32 y = 0; y < m_Height; ++y)
+	{
+		Append(data, (int32)y);
+		Append(data, lineSize);
+		for (uint32 offset : ChannelOffsets)
+		{
+			for (uint32 x = 0; x < m_Width; ++x)
+				Append(data, GetPixel(x, y)[offset]);
+		}
+	}
+	return data;
+}
+
+bool RS::ReferenceImage::ReadEXR(const std::string& path, ReferenceImage& image)
+{
+	std::shared_ptr<VFSFile> pFile = VFS::Get()->Open(path);
+	if (!pFile)
+	{
+		LOG_ERROR("Failed to open {}!", path.c_str());
+		return false;
+	}
+	if (!DecodeEXR(pFile->GetData(), image))
+	{
+		LOG_ERROR("Failed to read {}, only uncompressed float EXR files are supported!", path.c_str());
+		return false;
+	}
+	return true;
+}
+
+bool RS::ReferenceImage::DecodeEXR(std::span<const uint8> data, ReferenceImage& image)
+{
+	using namespace _ReferenceImageInternal;
+
+	Reader reader(data);
+	uint32 magic = 0, version = 0;
+	if (!reader.Read(magic) || !reader.Read(version) || magic != 20000630 || (version & 0xFF) != 2 || (version & ~0xFFu) != 0)
+		return false;
+
+	// The RGBA offset of every channel in file order, UINT32_MAX for channels that are skipped.
+	std::vector<uint32> channelOffsets;
+	int32 window[4] = {};
+	bool hasWindow = false;
+	while (true)
+	{
+		std::string name, type;
+		int32 size = 0;
+		if (!reader.ReadString(name))
+			return false;
+		if (name.empty())
+			break;
+		if (!reader.ReadString(type) || !reader.Read(size) || size < 0)
+			return false;
+
+		const uint64 valueEnd = reader.GetOffset() + size;
+		if (name == "channels")
+		{
+			std::string channelName;
+			while (reader.ReadString(channelName) && !channelName.empty())
+			{
+				int32 pixelType = 0;
+				if (!reader.Read(pixelType) || pixelType != PixelTypeFloat || !reader.Skip(12))
+					return false;
+				const char* pNames = "RGBA";
+				const char* pFound = channelName.size() == 1 ? std::strchr(pNames, channelName[0]) : nullptr;
+				channelOffsets.push_back(pFound ? (uint32)(pFound - pNames) : UINT32_MAX);
+			}
+		}
+		else if (name == "compression")
+		{
+			uint8 compression = 0;
+			if (!reader.Read(compression) || compression != 0)
+				return false;
+		}
+		else if (name == "dataWindow")
+		{
+			hasWindow = reader.Read(window);
+		}
+		reader.SetOffset(valueEnd);
+		if (valueEnd > data.size())
+			return false;
+	}
+
+	if (!hasWindow || channelOffsets.empty() || window[2] < window[0] || window[3] < window[1])
+		return false;
+
+	const uint32 width = (uint32)(window[2] - window[0] + 1);
+	const uint32 height = (uint32)(window[3] - window[1] + 1);
+	const uint64 lineSize = (uint64)width * channelOffsets.size() * sizeof(float);
+	image = ReferenceImage(width, height);
+	for (uint32 y = 0; y < height; ++y)
+	{
+		for (uint32 x = 0; x < width; ++x)
+			image.GetPixel(x, y)[3] = 1.f;
+	}
+
+	for (uint32 line = 0; line < height; ++line)
+	{
+		uint64 blockOffset = 0;
+		int32 y = 0, size = 0;
+		if (!reader.Read(blockOffset))
+			return false;
+		const uint64 tableOffset = reader.GetOffset();
+		reader.SetOffset(blockOffset);
+		if (!reader.Read(y) || !reader.Read(size) || (uint64)size != lineSize || y < window[1] || y > window[3] || blockOffset + 8 + lineSize > data.size())
+			return false;
+
+		for (uint32 offset : channelOffsets)
+		{
+			for (uint32 x = 0; x < width; ++x)
+			{
+				float value = 0.f;
+				reader.Read(value);
+				if (offset != UINT32_MAX)
+					image.GetPixel(x, (uint32)(y - window[1]))[offset] = value;
+			}
+		}
+		reader.SetOffset(tableOffset);
+	}
+	return true;
+}
+
+RS::ImageDiffResult RS::ReferenceImage::Compare(const ReferenceImage& image, const ReferenceImage& reference, const ImageDiffSettings& settings, ReferenceImage* pDiffImage)
+{
+	ImageDiffResult result;
+	if (image.m_Width != reference.m_Width || image.m_Height != reference.m_Height)
+	{
+		result.isSameSize = false;
+		result.maxError = FLT_MAX;
+		result.meanError = FLT_MAX;
+		result.psnr = 0.f;
+		return result;
+	}
+
+	if (pDiffImage)
+		*pDiffImage = ReferenceImage(image.m_Width, image.m_Height);
+
+	double errorSum = 0.0, squaredErrorSum = 0.0;
+	const uint64 pixelCount = (uint64)image.m_Width * image.m_Height;
+	for (uint64 pixel = 0; pixel < pixelCount; ++pixel)
+	{
+		bool isBad = false;
+		for (uint32 channel = 0; channel < 4; ++channel)
+		{
+			const float error = std::abs(image.m_Pixels[pixel * 4 + channel] - reference.m_Pixels[pixel * 4 + channel]);
+			// Written so that NaN counts as bad.
+			isBad |= !(error <= settings.tolerance);
+			result.maxError = std::max(result.maxError, error);
+			errorSum += error;
+			squaredErrorSum += (double)error * error;
+			if (pDiffImage)
+				pDiffImage->m_Pixels[pixel * 4 + channel] = channel == 3 ? 1.f : error;
+		}
+		if (isBad)
+			result.badPixelCount++;
+	}
+
+	const uint64 valueCount = std::max<uint64>(pixelCount * 4, 1);
+	result.meanError = (float)(errorSum / valueCount);
+	if (squaredErrorSum > 0.0)
+		result.psnr = (float)(10.0 * std::log10(valueCount / squaredErrorSum));
+	result.passed = result.badPixelCount <= (uint64)(settings.maxBadPixelRatio * pixelCount);
+	return result;
+}
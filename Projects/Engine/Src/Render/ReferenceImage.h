@@ -0,0 +1,67 @@
+#pragma once
+
+#include <span>
+
+namespace RS
+{
+	struct ImageDiffSettings
+	{
+		float tolerance = 2.f / 255.f;		// Per channel, a pixel is bad when any of its channels differ by more.
+		float maxBadPixelRatio = 0.f;		// Share of the pixels that may be bad, above zero for the noise of path traced images.
+	};
+
+	struct ImageDiffResult
+	{
+		uint64 badPixelCount = 0;
+		float maxError = 0.f;
+		float meanError = 0.f;				// Mean absolute difference over all channels.
+		float psnr = FLT_MAX;				// In dB, with 1 as the peak value. FLT_MAX when the images are the same.
+		bool isSameSize = true;
+		bool passed = false;
+	};
+
+	/*
+	* Linear float RGBA image, the output of the CPU path tracer and the format golden images are compared in.
+	*/
+	class ReferenceImage
+	{
+	public:
+		ReferenceImage() = default;
+		ReferenceImage(uint32 width, uint32 height);
+
+		uint32 GetWidth() const { return m_Width; }
+		uint32 GetHeight() const { return m_Height; }
+		float* GetPixel(uint32 x, uint32 y) { return &m_Pixels[((uint64)y * m_Width + x) * 4]; }
+		const float* GetPixel(uint32 x, uint32 y) const { return &m_Pixels[((uint64)y * m_Width + x) * 4]; }
+		std::span<float> GetData() { return m_Pixels; }
+		std::span<const float> GetData() const { return m_Pixels; }
+
+		/*
+		* 8 bit PNG through stb_image_write, the channels are clamped to [0, 1] and the colors are sRGB encoded when isSRGB is set.
+		*/
+		bool WritePNG(const std::string& path, bool isSRGB = true) const;
+
+		/*
+		* OpenEXR with uncompressed 32 bit float scanlines, lossless so it is the format to keep golden images in.
+		*/
+		bool WriteEXR(const std::string& path) const;
+		std::vector<uint8> EncodeEXR() const;
+
+		/*
+		* Only reads what WriteEXR writes: uncompressed scanlines with float channels. Missing channels are 0, alpha is 1.
+		* The path is opened through the VFS.
+		*/
+		static bool ReadEXR(const std::string& path, ReferenceImage& image);
+		static bool DecodeEXR(std::span<const uint8> data, ReferenceImage& image);
+
+		/*
+		* pDiffImage gets the absolute difference of every channel, with alpha set to 1 so it can be written and viewed.
+		*/
+		static ImageDiffResult Compare(const ReferenceImage& image, const ReferenceImage& reference, const ImageDiffSettings& settings = ImageDiffSettings(), ReferenceImage* pDiffImage = nullptr);
+
+	private:
+		uint32 m_Width = 0;
+		uint32 m_Height = 0;
+		std::vector<float> m_Pixels;
+	};
+}
@@ -0,0 +1,366 @@
+#include "PreCompiled.h"
+#include "TextureStreamer.h"
+
+#include "Core/VFS.h"
+#include "Loaders/Texture/DDSFile.h"
+
+#include <cmath>
+
+bool RS::DDSStreamingSource::ReadInfo(const std::string& path, StreamedTextureInfo& info)
+{
+	std::shared_ptr<VFSFile> pFile = VFS::Get()->Open(path);
+	DDSTexture dds;
+	if (!pFile || !DDSFile::Parse(pFile->GetData(), dds))
+		return false;
+
+	info.width = dds.width;
+	info.height = dds.height;
+	info.format = dds.dxgiFormat;
+	info.blockDimension = DDSFile::IsBlockCompressed(dds.dxgiFormat) ? 4 : 1;
+	info.mipSizes.clear();
+	for (const DDSTexture::Mip& mip : dds.mips)
+		info.mipSizes.push_back(mip.data.size());
+	return true;
+}
+
+bool RS::DDSStreamingSource::ReadMip(const std::string& path, uint32 mip, std::vector<uint8>& data)
+{
+	std::shared_ptr<VFSFile> pFile = VFS::Get()->Open(path);
+	DDSTexture dds;
+	if (!pFile || !DDSFile::Parse(pFile->GetData(), dds) || mip >= dds.mips.size())
+		return false;
+
+	data.assign(dds.mips[mip].data.begin(), dds.mips[mip].data.end());
+	return true;
+}
+
+RS::TextureStreamer::TextureStreamer(std::shared_ptr<ITextureStreamingDevice> pDevice, std::shared_ptr<ITextureStreamingSource> pSource, const TextureStreamerSettings& settings)
+	: m_pDevice(pDevice)
+	, m_pSource(pSource)
+	, m_Settings(settings)
+{
+	// Without threads the pool runs the reads right away.
+	m_IOThreads.Init(m_Settings.ioThreadCount, "Texture IO");
+}
+
+RS::TextureStreamer::~TextureStreamer()
+{
+	WaitForReads();
+	m_IOThreads.Release();
+
+	for (auto& [id, texture] : m_Textures)
+		m_pDevice->DestroyTexture(id);
+}
+
+RS::StreamedTextureID RS::TextureStreamer::Register(const std::string& path)
+{
+	Texture texture;
+	texture.path = path;
+	if (!m_pSource->ReadInfo(path, texture.info) || texture.info.mipSizes.empty())
+	{
+		LOG_WARNING("Cannot stream texture {}, failed to read its header!", path.c_str());
+		return InvalidStreamedTextureID;
+	}
+
+	const uint32 mipCount = (uint32)texture.info.mipSizes.size();
+	texture.tailFirstMip = mipCount - 1;
+	while (texture.tailFirstMip > 0)
+	{
+		const uint32 mip = texture.tailFirstMip - 1;
+		if (std::max(texture.info.width >> mip, texture.info.height >> mip) > m_Settings.mipTailDimension)
+			break;
+		texture.tailFirstMip = mip;
+	}
+
+	// A resource can not start at a block compressed mip that is not a whole number of blocks, the mips below the last one that is
+	// are only resident as part of the tail.
+	const uint32 blockDimension = std::max(1u, texture.info.blockDimension);
+	while (texture.tailFirstMip > 0
+		&& ((texture.info.width >> texture.tailFirstMip) % blockDimension != 0 || (texture.info.height >> texture.tailFirstMip) % blockDimension != 0))
+		texture.tailFirstMip--;
+	texture.lastDesiredMip = texture.tailFirstMip;
+	texture.lastUsedFrame = m_FrameIndex;
+
+	const StreamedTextureID id = m_NextID++;
+	m_pDevice->CreateTexture(id, texture.info);
+	m_Textures.emplace(id, std::move(texture));
+	return id;
+}
+
+void RS::TextureStreamer::Unregister(StreamedTextureID id)
+{
+	auto it = m_Textures.find(id);
+	if (it == m_Textures.end())
+		return;
+
+	// A read that is still running is thrown away when it is done.
+	m_ResidentBytes -= GetResidentBytes(it->second);
+	m_pDevice->DestroyTexture(id);
+	m_Textures.erase(it);
+}
+
+void RS::TextureStreamer::ReportScreenSize(StreamedTextureID id, float screenSize)
+{
+	auto it = m_Textures.find(id);
+	if (it == m_Textures.end() || screenSize <= 0.f)
+		return;
+
+	// The mip with about one texel per pixel.
+	const Texture& texture = it->second;
+	const float ratio = (float)std::max(texture.info.width, texture.info.height) / screenSize;
+	const uint32 mip = ratio <= 1.f ? 0 : (uint32)std::floor(std::log2(ratio));
+	ReportDesiredMip(id, mip);
+	it->second.screenSize = std::max(it->second.screenSize, screenSize);
+}
+
+void RS::TextureStreamer::ReportDesiredMip(StreamedTextureID id, uint32 mip)
+{
+	auto it = m_Textures.find(id);
+	if (it == m_Textures.end())
+		return;
+
+	Texture& texture = it->second;
+	texture.desiredMip = std::min(texture.desiredMip, std::min(mip, texture.tailFirstMip));
+	texture.lastUsedFrame = m_FrameIndex;
+}
+
+void RS::TextureStreamer::Update()
+{
+	// Textures that were not reported this frame only want their tail.
+	for (auto& [id, texture] : m_Textures)
+	{
+		texture.lastDesiredMip = std::min(texture.desiredMip, texture.tailFirstMip);
+		texture.lastScreenSize = texture.screenSize;
+		texture.desiredMip = UINT32_MAX;
+		texture.screenSize = 0.f;
+	}
+
+	m_pDevice->BeginUpdate();
+	UploadFinishedReads();
+	ScheduleReads();
+	m_FrameIndex++;
+}
+
+void RS::TextureStreamer::WaitForReads()
+{
+	std::unique_lock<std::mutex> lock(m_ResultMutex);
+	m_ResultCondition.wait(lock, [&]() { return m_ReadsRunning == 0; });
+}
+
+void RS::TextureStreamer::SetBudget(uint64 budgetBytes)
+{
+	// Lowering it evicts in the next Update.
+	m_Settings.budgetBytes = budgetBytes;
+}
+
+RS::TextureStreamerStats RS::TextureStreamer::GetStats() const
+{
+	TextureStreamerStats stats;
+	stats.residentBytes = m_ResidentBytes;
+	stats.pendingBytes = m_PendingBytes;
+	stats.budgetBytes = m_Settings.budgetBytes;
+	stats.textureCount = (uint32)m_Textures.size();
+	stats.requestsInFlight = m_RequestsInFlight;
+	stats.uploadedMipCount = m_UploadedMipCount;
+	stats.evictedMipCount = m_EvictedMipCount;
+	return stats;
+}
+
+uint32 RS::TextureStreamer::GetFirstResidentMip(StreamedTextureID id) const
+{
+	auto it = m_Textures.find(id);
+	return it == m_Textures.end() ? UINT32_MAX : it->second.firstResidentMip;
+}
+
+uint32 RS::TextureStreamer::GetDesiredMip(StreamedTextureID id) const
+{
+	auto it = m_Textures.find(id);
+	return it == m_Textures.end() ? UINT32_MAX : GetTargetMip(it->second);
+}
+
+uint32 RS::TextureStreamer::GetTargetMip(const Texture& texture) const
+{
+	return std::min(texture.lastDesiredMip, texture.tailFirstMip);
+}
+
+uint64 RS::TextureStreamer::GetResidentBytes(const Texture& texture) const
+{
+	uint64 bytes = 0;
+	for (uint32 mip = texture.firstResidentMip; mip < (uint32)texture.info.mipSizes.size(); ++mip)
+		bytes += texture.info.mipSizes[mip];
+	return bytes;
+}
+
+void RS::TextureStreamer::StartRead(StreamedTextureID id, Texture& texture, uint32 firstMip, uint32 mipCount, uint64 bytes)
+{
+	texture.isReading = true;
+	m_PendingBytes += bytes;
+	m_RequestsInFlight++;
+	{
+		std::lock_guard<std::mutex> lock(m_ResultMutex);
+		m_ReadsRunning++;
+	}
+
+	m_IOThreads.Submit([this, pSource = m_pSource, path = texture.path, id, firstMip, mipCount, bytes]()
+		{
+			ReadResult result;
+			result.id = id;
+			result.firstMip = firstMip;
+			result.reservedBytes = bytes;
+			result.mips.resize(mipCount);
+			result.succeeded = true;
+			for (uint32 i = 0; i < mipCount && result.succeeded; ++i)
+				result.succeeded = pSource->ReadMip(path, firstMip + i, result.mips[i]);
+
+			std::lock_guard<std::mutex> lock(m_ResultMutex);
+			m_FinishedReads.push_back(std::move(result));
+			m_ReadsRunning--;
+			m_ResultCondition.notify_all();
+		});
+}
+
+bool RS::TextureStreamer::MakeRoom(uint64 bytes)
+{
+	const uint64 usedBytes = m_ResidentBytes + m_PendingBytes + bytes;
+	if (usedBytes <= m_Settings.budgetBytes)
+		return true;
+	const uint64 neededBytes = usedBytes - m_Settings.budgetBytes;
+
+	// Only mips more detailed than what a texture asked for in the last frame can go, least recently used texture first.
+	std::vector<std::pair<uint64, StreamedTextureID>> candidates;
+	for (auto& [id, texture] : m_Textures)
+	{
+		if (!texture.isReading && texture.firstResidentMip < GetTargetMip(texture))
+			candidates.emplace_back(texture.lastUsedFrame, id);
+	}
+	std::sort(candidates.begin(), candidates.end());
+
+	uint64 freedBytes = 0;
+	for (uint64 i = 0; i < candidates.size() && freedBytes < neededBytes; ++i)
+	{
+		const StreamedTextureID id = candidates[i].second;
+		Texture& texture = m_Textures[id];
+		const uint32 targetMip = GetTargetMip(texture);
+		uint32 firstMip = texture.firstResidentMip;
+		while (firstMip < targetMip && freedBytes < neededBytes)
+		{
+			freedBytes += texture.info.mipSizes[firstMip];
+			m_EvictedMipCount++;
+			firstMip++;
+		}
+
+		m_pDevice->EvictMips(id, firstMip);
+		m_ResidentBytes -= GetResidentBytes(texture);
+		texture.firstResidentMip = firstMip;
+		m_ResidentBytes += GetResidentBytes(texture);
+	}
+	return freedBytes >= neededBytes;
+}
+
+void RS::TextureStreamer::UploadFinishedReads()
+{
+	std::vector<ReadResult> results;
+	{
+		std::lock_guard<std::mutex> lock(m_ResultMutex);
+		results.swap(m_FinishedReads);
+	}
+
+	uint64 uploadedBytes = 0;
+	uint64 resultIndex = 0;
+	for (; resultIndex < results.size(); ++resultIndex)
+	{
+		ReadResult& result = results[resultIndex];
+		if (uploadedBytes > 0 && uploadedBytes + result.reservedBytes > m_Settings.maxUploadBytesPerUpdate)
+			break;
+
+		m_PendingBytes -= result.reservedBytes;
+		m_RequestsInFlight--;
+
+		auto it = m_Textures.find(result.id);
+		if (it == m_Textures.end())
+			continue;
+
+		Texture& texture = it->second;
+		texture.isReading = false;
+		if (!result.succeeded)
+		{
+			// Keeps what is resident and does not try again.
+			LOG_WARNING("Failed to read mip {} of {}!", result.firstMip, texture.path.c_str());
+			texture.hasFailed = true;
+			continue;
+		}
+
+		m_pDevice->UploadMips(result.id, result.firstMip, result.mips);
+		m_ResidentBytes -= GetResidentBytes(texture);
+		texture.firstResidentMip = result.firstMip;
+		m_ResidentBytes += GetResidentBytes(texture);
+		m_UploadedMipCount += result.mips.size();
+		uploadedBytes += result.reservedBytes;
+	}
+
+	// What did not fit this frame goes first in the next.
+	if (resultIndex < results.size())
+	{
+		std::lock_guard<std::mutex> lock(m_ResultMutex);
+		m_FinishedReads.insert(m_FinishedReads.begin(), std::make_move_iterator(results.begin() + resultIndex), std::make_move_iterator(results.end()));
+	}
+}
+
+void RS::TextureStreamer::ScheduleReads()
+{
+	// The budget might have been lowered.
+	MakeRoom(0);
+
+	// Mip tails first, they are needed before a texture can be drawn at all.
+	for (auto& [id, texture] : m_Textures)
+	{
+		if (m_RequestsInFlight >= m_Settings.maxRequestsInFlight)
+			return;
+		if (texture.isReading || texture.hasFailed || texture.firstResidentMip != UINT32_MAX)
+			continue;
+
+		uint64 bytes = 0;
+		for (uint32 mip = texture.tailFirstMip; mip < (uint32)texture.info.mipSizes.size(); ++mip)
+			bytes += texture.info.mipSizes[mip];
+		MakeRoom(bytes);
+		StartRead(id, texture, texture.tailFirstMip, (uint32)texture.info.mipSizes.size() - texture.tailFirstMip, bytes);
+	}
+
+	// Then one mip at a time, the textures that are the most levels away from what they want go first.
+	struct Candidate
+	{
+		uint32 missingMipCount;
+		float screenSize;
+		StreamedTextureID id;
+	};
+	std::vector<Candidate> candidates;
+	for (auto& [id, texture] : m_Textures)
+	{
+		const uint32 targetMip = GetTargetMip(texture);
+		if (!texture.isReading && !texture.hasFailed && texture.firstResidentMip != UINT32_MAX && texture.firstResidentMip > targetMip)
+			candidates.push_back({ texture.firstResidentMip - targetMip, texture.lastScreenSize, id });
+	}
+	std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b)
+		{
+			if (a.missingMipCount != b.missingMipCount)
+				return a.missingMipCount > b.missingMipCount;
+			if (a.screenSize != b.screenSize)
+				return a.screenSize > b.screenSize;
+			return a.id < b.id;
+		});
+
+	for (const Candidate& candidate : candidates)
+	{
+		if (m_RequestsInFlight >= m_Settings.maxRequestsInFlight)
+			return;
+
+		Texture& texture = m_Textures[candidate.id];
+		const uint32 mip = texture.firstResidentMip - 1;
+		const uint64 bytes = texture.info.mipSizes[mip];
+
+		// Stop instead of letting smaller reads with a lower priority take the space.
+		if (!MakeRoom(bytes))
+			return;
+		StartRead(candidate.id, texture, mip, 1, bytes);
+	}
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+#include "Core/ThreadPool.h"
+
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+
+namespace RS
+{
+	using StreamedTextureID = uint32;
+	inline static constexpr StreamedTextureID InvalidStreamedTextureID = 0;
+
+	struct StreamedTextureInfo
+	{
+		uint32 width = 0;
+		uint32 height = 0;
+		uint32 format = 0;				// Only used by the device, a DXGI_FORMAT for DX12.
+		std::vector<uint64> mipSizes;	// Bytes of each mip, mip 0 is the largest.
+		uint32 blockDimension = 1;		// The most detailed resident mip has to be a multiple of this in both directions, 4 for block compressed formats.
+	};
+
+	/*
+	* Where the mip data comes from. Both functions are called from the I/O threads.
+	*/
+	class ITextureStreamingSource
+	{
+	public:
+		virtual ~ITextureStreamingSource() = default;
+
+		virtual bool ReadInfo(const std::string& path, StreamedTextureInfo& info) = 0;
+		virtual bool ReadMip(const std::string& path, uint32 mip, std::vector<uint8>& data) = 0;
+	};
+
+	/*
+	* Cooked DDS files read through the VFS.
+	*/
+	class DDSStreamingSource : public ITextureStreamingSource
+	{
+	public:
+		bool ReadInfo(const std::string& path, StreamedTextureInfo& info) override;
+		bool ReadMip(const std::string& path, uint32 mip, std::vector<uint8>& data) override;
+	};
+
+	/*
+	* The GPU side of the streamer. All functions are called from the thread that calls TextureStreamer::Update.
+	* The resident mips of a texture are always one range [firstMip, mipCount), which only grows or shrinks at the detailed end.
+	*/
+	class ITextureStreamingDevice
+	{
+	public:
+		virtual ~ITextureStreamingDevice() = default;
+
+		// Called at the start of every TextureStreamer::Update.
+		virtual void BeginUpdate() {}
+		virtual void CreateTexture(StreamedTextureID id, const StreamedTextureInfo& info) = 0;
+		// mips[i] is the data of mip firstMip + i. The last one is the mip right above the previous first resident mip.
+		virtual void UploadMips(StreamedTextureID id, uint32 firstMip, const std::vector<std::vector<uint8>>& mips) = 0;
+		// Every mip above firstMip is released.
+		virtual void EvictMips(StreamedTextureID id, uint32 firstMip) = 0;
+		virtual void DestroyTexture(StreamedTextureID id) = 0;
+	};
+
+	struct TextureStreamerSettings
+	{
+		uint64 budgetBytes = 512ull * 1024 * 1024;
+		uint32 mipTailDimension = 64;		// Mips this size or smaller are the tail, it is loaded first and never evicted.
+		uint32 ioThreadCount = 2;			// 0 reads on the thread calling Update.
+		uint32 maxRequestsInFlight = 16;
+		uint64 maxUploadBytesPerUpdate = 32ull * 1024 * 1024;
+	};
+
+	struct TextureStreamerStats
+	{
+		uint64 residentBytes = 0;	// Includes the mip tails.
+		uint64 pendingBytes = 0;	// Reserved for reads that have not been uploaded yet.
+		uint64 budgetBytes = 0;
+		uint32 textureCount = 0;
+		uint32 requestsInFlight = 0;
+		uint64 uploadedMipCount = 0;
+		uint64 evictedMipCount = 0;
+	};
+
+	/*
+	* Streams the mips of textures under a memory budget.
+	* Registering a texture queues a read of its mip tail, which goes before any other read. The renderer then reports how large each
+	* texture is on screen every frame, and Update reads the next more detailed mip of the textures that are the most blurry on background
+	* threads. When the budget is full, mips that nothing asked for this frame are evicted, the least recently used texture first.
+	*
+	* The scheduling and the budget only deal with byte counts, the source and the device do the actual work.
+	* Everything except the reads runs on the thread that calls the functions, which has to be the same thread every time.
+	*/
+	class TextureStreamer
+	{
+	public:
+		TextureStreamer(std::shared_ptr<ITextureStreamingDevice> pDevice, std::shared_ptr<ITextureStreamingSource> pSource, const TextureStreamerSettings& settings = TextureStreamerSettings());
+		~TextureStreamer();
+		RS_NO_COPY_AND_MOVE(TextureStreamer)
+
+		/*
+		* Reads the header of the texture right away, the mips are read later. Returns InvalidStreamedTextureID if the header could not be read.
+		*/
+		StreamedTextureID Register(const std::string& path);
+		void Unregister(StreamedTextureID id);
+
+		/*
+		* Feedback for the current frame, the largest size reported since the last Update is used.
+		* screenSize is the number of pixels the texture covers along its longest side.
+		*/
+		void ReportScreenSize(StreamedTextureID id, float screenSize);
+		// Same as ReportScreenSize but with the mip that should be resident.
+		void ReportDesiredMip(StreamedTextureID id, uint32 mip);
+
+		/*
+		* Call once per frame. Uploads finished reads, evicts what does not fit and starts new reads.
+		*/
+		void Update();
+
+		// Blocks until every read that has been started is done. The results are uploaded by the next Update.
+		void WaitForReads();
+
+		void SetBudget(uint64 budgetBytes);
+		TextureStreamerStats GetStats() const;
+
+		// UINT32_MAX while nothing is resident.
+		uint32 GetFirstResidentMip(StreamedTextureID id) const;
+		uint32 GetDesiredMip(StreamedTextureID id) const;
+
+	private:
+		struct Texture
+		{
+			std::string path;
+			StreamedTextureInfo info;
+			uint32 tailFirstMip = 0;
+			uint32 firstResidentMip = UINT32_MAX;
+			uint32 desiredMip = UINT32_MAX;		// Mip asked for in the frame that is being built.
+			uint32 lastDesiredMip = UINT32_MAX;	// Mip asked for in the last updated frame.
+			float screenSize = 0.f;
+			float lastScreenSize = 0.f;
+			uint64 lastUsedFrame = 0;
+			bool isReading = false;
+			bool hasFailed = false;
+		};
+
+		struct ReadResult
+		{
+			StreamedTextureID id = InvalidStreamedTextureID;
+			uint32 firstMip = 0;
+			uint64 reservedBytes = 0;
+			bool succeeded = false;
+			std::vector<std::vector<uint8>> mips;
+		};
+
+		uint32 GetTargetMip(const Texture& texture) const;
+		uint64 GetResidentBytes(const Texture& texture) const;
+		void StartRead(StreamedTextureID id, Texture& texture, uint32 firstMip, uint32 mipCount, uint64 bytes);
+		bool MakeRoom(uint64 bytes);
+		void UploadFinishedReads();
+		void ScheduleReads();
+
+	private:
+		std::shared_ptr<ITextureStreamingDevice> m_pDevice;
+		std::shared_ptr<ITextureStreamingSource> m_pSource;
+		TextureStreamerSettings m_Settings;
+		ThreadPool m_IOThreads;
+
+		std::unordered_map<StreamedTextureID, Texture> m_Textures;
+		StreamedTextureID m_NextID = 1;
+		uint64 m_FrameIndex = 1;
+		uint64 m_ResidentBytes = 0;
+		uint64 m_PendingBytes = 0;
+		uint32 m_RequestsInFlight = 0;
+		uint64 m_UploadedMipCount = 0;
+		uint64 m_EvictedMipCount = 0;
+
+		// Filled by the I/O threads.
+		std::mutex m_ResultMutex;
+		std::condition_variable m_ResultCondition;
+		std::vector<ReadResult> m_FinishedReads;
+		uint32 m_ReadsRunning = 0;
+	};
+}
@@ -8,12 +8,14 @@
 #include "Core/Display.h"
 
 #include "Tools/ConsoleInspectorTool.h"
+#include "Tools/ProfilerWindow.h"
 
 #include "Core/Input.h"
 
 void RS::DebugWindowsManager::Init()
 {
     RegisterDebugWindow<DebugConsoleInspectorWindow>("Debug Console Inspector Window", Key::TAB, Input::ModFlag::CONTROL);
+    RegisterDebugWindow<ProfilerWindow>("Profiler", Key::P, Input::ModFlag::CONTROL);
 
     ImGuiIO& io = ImGui::GetIO();
     io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;
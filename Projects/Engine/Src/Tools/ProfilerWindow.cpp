@@ -0,0 +1,137 @@
+#include "PreCompiled.h"
+#include "ProfilerWindow.h"
+
+#include "Render/ImGuiRenderer.h"
+
+#include <string_view>
+
+void RS::ProfilerWindow::Render()
+{
+	Profiler* pProfiler = Profiler::Get();
+
+	bool isPaused = pProfiler->IsPaused();
+	if (ImGui::Checkbox("Pause", &isPaused))
+		pProfiler->SetPaused(isPaused);
+	ImGui::SameLine();
+	if (ImGui::Button("Export Chrome Trace"))
+		pProfiler->ExportChromeTrace(Engine::GetDebugFilePath() + "Profile.json");
+	ImGui::SameLine();
+	ImGui::Text("Dropped zones: %llu", pProfiler->GetDroppedZoneCount());
+
+	const uint32 frameCount = pProfiler->GetFrameCount();
+	if (frameCount == 0)
+	{
+		ImGui::Text("No frames yet.");
+		return;
+	}
+
+	// Oldest frame to the left.
+	m_FrameTimes.resize(frameCount);
+	float maxFrameTime = 0.f;
+	for (uint32 i = 0; i < frameCount; ++i)
+	{
+		const Profiler::Frame& frame = pProfiler->GetFrame(frameCount - 1 - i);
+		m_FrameTimes[i] = (float)Profiler::TicksToMs(frame.end - frame.begin);
+		maxFrameTime = std::max(maxFrameTime, m_FrameTimes[i]);
+	}
+	ImGui::PlotHistogram("##FrameTimes", m_FrameTimes.data(), (int)frameCount, 0, "Frame times [ms]", 0.f, maxFrameTime, ImVec2(ImGui::GetContentRegionAvail().x, 60.f));
+
+	if (!isPaused)
+		m_SelectedFrame = 0;
+	m_SelectedFrame = std::clamp(m_SelectedFrame, 0, (int)frameCount - 1);
+	if (isPaused)
+		ImGui::SliderInt("Frames ago", &m_SelectedFrame, 0, (int)frameCount - 1);
+
+	const Profiler::Frame& frame = pProfiler->GetFrame((uint32)m_SelectedFrame);
+	ImGui::Text("Frame %llu: %.3f ms, %llu zones", frame.index, Profiler::TicksToMs(frame.end - frame.begin), (uint64)frame.zones.size());
+
+	RenderFlameGraph(frame);
+	RenderStats(frame);
+}
+
+void RS::ProfilerWindow::RenderFlameGraph(const Profiler::Frame& frame)
+{
+	const std::vector<std::string> threadNames = Profiler::Get()->GetThreadNames();
+	const float rowHeight = ImGui::GetTextLineHeight() + 4.f;
+	const float width = ImGui::GetContentRegionAvail().x;
+	ImDrawList* pDrawList = ImGui::GetWindowDrawList();
+
+	// Tracks like the GPU one collect their zones frames later, the view is widened to show them too.
+	uint64 viewBegin = frame.begin;
+	uint64 viewEnd = frame.end;
+	for (const Profiler::Zone& zone : frame.zones)
+	{
+		viewBegin = std::min(viewBegin, zone.begin);
+		viewEnd = std::max(viewEnd, zone.end);
+	}
+	const double viewTicks = (double)std::max<uint64>(viewEnd - viewBegin, 1);
+
+	// The zones are sorted by thread, each thread gets a name row and then as many rows as it had depth.
+	uint64 first = 0;
+	while (first < frame.zones.size())
+	{
+		const uint32 thread = frame.zones[first].thread;
+		uint64 last = first;
+		uint32 maxDepth = 0;
+		for (; last < frame.zones.size() && frame.zones[last].thread == thread; ++last)
+			maxDepth = std::max(maxDepth, frame.zones[last].depth);
+
+		ImGui::Text("%s", thread < threadNames.size() && !threadNames[thread].empty() ? threadNames[thread].c_str() : "Unnamed Thread");
+		const ImVec2 origin = ImGui::GetCursorScreenPos();
+		ImGui::InvisibleButton(Utils::Format("##Thread{}", thread).c_str(), ImVec2(width, rowHeight * (maxDepth + 1)));
+		const bool isHovered = ImGui::IsItemHovered();
+		const ImVec2 mouse = ImGui::GetMousePos();
+
+		for (uint64 i = first; i < last; ++i)
+		{
+			const Profiler::Zone& zone = frame.zones[i];
+
+			const float x0 = origin.x + width * (float)((double)(zone.begin - viewBegin) / viewTicks);
+			const float x1 = std::max(origin.x + width * (float)((double)(zone.end - viewBegin) / viewTicks), x0 + 1.f);
+			const float y0 = origin.y + rowHeight * zone.depth;
+			const ImVec2 min(x0, y0);
+			const ImVec2 max(x1, y0 + rowHeight - 1.f);
+
+			const float hue = (float)(std::hash<std::string_view>{}(zone.pName) % 360) / 360.f;
+			pDrawList->AddRectFilled(min, max, ImColor::HSV(hue, 0.5f, 0.8f));
+
+			const ImVec2 textSize = ImGui::CalcTextSize(zone.pName);
+			if (textSize.x + 4.f < max.x - min.x)
+				pDrawList->AddText(ImVec2(min.x + 2.f, min.y + 2.f), IM_COL32(0, 0, 0, 255), zone.pName);
+
+			if (isHovered && mouse.x >= min.x && mouse.x < max.x && mouse.y >= min.y && mouse.y < max.y)
+				ImGui::SetTooltip("%s\n%.3f ms", zone.pName, Profiler::TicksToMs(zone.end - zone.begin));
+		}
+		first = last;
+	}
+}
+
+void RS::ProfilerWindow::RenderStats(const Profiler::Frame& frame)
+{
+	if (!ImGui::CollapsingHeader("Zones", ImGuiTreeNodeFlags_DefaultOpen))
+		return;
+
+	Profiler::GetZoneStats(frame, m_Stats);
+
+	const ImGuiTableFlags flags = ImGuiTableFlags_Resizable | ImGuiTableFlags_Borders | ImGuiTableFlags_SizingFixedFit | ImGuiTableFlags_NoSavedSettings;
+	if (ImGui::BeginTable("ZoneStats", 4, flags))
+	{
+		ImGui::TableSetupColumn("Name");
+		ImGui::TableSetupColumn("Count");
+		ImGui::TableSetupColumn("Total [ms]");
+		ImGui::TableSetupColumn("Max [ms]");
+		ImGui::TableHeadersRow();
+		for (const Profiler::ZoneStats& stats : m_Stats)
+		{
+			ImGui::TableNextColumn();
+			ImGui::Text("%s", stats.pName);
+			ImGui::TableNextColumn();
+			ImGui::Text("%u", stats.count);
+			ImGui::TableNextColumn();
+			ImGui::Text("%.3f", stats.totalMs);
+			ImGui::TableNextColumn();
+			ImGui::Text("%.3f", stats.maxMs);
+		}
+		ImGui::EndTable();
+	}
+}
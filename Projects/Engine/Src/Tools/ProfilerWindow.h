@@ -0,0 +1,28 @@
+#pragma once
+
+#include "Core/Profiler.h"
+#include "Tools/DebugWindow.h"
+
+namespace RS
+{
+	/*
+	* Frame times of the frames the Profiler kept and a flame graph of the zones of one of them, one row per thread and
+	* depth. Pause to pick an older frame.
+	*/
+	class ProfilerWindow : public DebugWindow
+	{
+	public:
+		ProfilerWindow(const std::string& name) : DebugWindow(name) {}
+
+		void Render() override;
+
+	private:
+		void RenderFlameGraph(const Profiler::Frame& frame);
+		void RenderStats(const Profiler::Frame& frame);
+
+	private:
+		int								m_SelectedFrame = 0; // Frames ago.
+		std::vector<float>				m_FrameTimes;
+		std::vector<Profiler::ZoneStats>	m_Stats;
+	};
+}
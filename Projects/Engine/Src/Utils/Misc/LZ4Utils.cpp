@@ -0,0 +1,184 @@
+#include "PreCompiled.h"
+#include "LZ4Utils.h"
+
+namespace RS::Utils::_LZ4Internal
+{
+	constexpr uint64 MinMatch = 4;
+	constexpr uint64 LastLiterals = 5;	// The last five bytes are always literals.
+	constexpr uint64 MatchFindLimit = 12;	// The last match has to start at least 12 bytes before the end.
+	constexpr uint64 MaxOffset = 65535;
+	constexpr uint32 HashBits = 12;
+
+	inline uint32 Read32(const uint8* p)
+	{
+		uint32 value;
+		std::memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	inline uint32 Hash(uint32 sequence)
+	{
+		return (sequence * 2654435761u) >> (32 - HashBits);
+	}
+
+	// Writes the 255 continuation bytes of a length that did not fit in the token.
+	inline bool WriteLength(uint8*& pOut, const uint8* pOutEnd, uint64 length)
+	{
+		while (length >= 255)
+		{
+			if (pOut >= pOutEnd)
+				return false;
+			*pOut++ = 255;
+			length -= 255;
+		}
+		if (pOut >= pOutEnd)
+			return false;
+		*pOut++ = (uint8)length;
+		return true;
+	}
+
+	inline bool ReadLength(const uint8*& pIn, const uint8* pInEnd, uint64& length)
+	{
+		uint8 value;
+		do
+		{
+			if (pIn >= pInEnd)
+				return false;
+			value = *pIn++;
+			length += value;
+		} while (value == 255);
+		return true;
+	}
+
+	bool WriteSequence(uint8*& pOut, const uint8* pOutEnd, const uint8* pLiterals, uint64 literalCount, uint64 offset, uint64 matchLength)
+	{
+		if (pOut >= pOutEnd)
+			return false;
+
+		uint8* pToken = pOut++;
+		const uint64 matchCode = matchLength > 0 ? matchLength - MinMatch : 0;
+		*pToken = (uint8)(((literalCount < 15 ? literalCount : 15) << 4) | (matchCode < 15 ? matchCode : 15));
+
+		if (literalCount >= 15 && !WriteLength(pOut, pOutEnd, literalCount - 15))
+			return false;
+
+		if ((uint64)(pOutEnd - pOut) < literalCount)
+			return false;
+		std::memcpy(pOut, pLiterals, literalCount);
+		pOut += literalCount;
+
+		// The last sequence has no match.
+		if (matchLength == 0)
+			return true;
+
+		if (pOutEnd - pOut < 2)
+			return false;
+		*pOut++ = (uint8)(offset & 0xFF);
+		*pOut++ = (uint8)(offset >> 8);
+
+		if (matchCode >= 15 && !WriteLength(pOut, pOutEnd, matchCode - 15))
+			return false;
+		return true;
+	}
+}
+
+uint64 RS::Utils::LZ4CompressBound(uint64 size)
+{
+	return size + size / 255 + 16;
+}
+
+uint64 RS::Utils::LZ4Compress(const uint8* pSrc, uint64 srcSize, uint8* pDst, uint64 dstCapacity)
+{
+	using namespace _LZ4Internal;
+
+	uint8* pOut = pDst;
+	const uint8* pOutEnd = pDst + dstCapacity;
+	const uint8* pIn = pSrc;
+	const uint8* pAnchor = pSrc;
+	const uint8* pInEnd = pSrc + srcSize;
+
+	if (srcSize > MatchFindLimit)
+	{
+		const uint8* pMatchLimit = pInEnd - LastLiterals;
+		const uint8* pFindLimit = pInEnd - MatchFindLimit;
+
+		// Positions are stored relative to the source, zero is also a valid position and filtered by the offset check.
+		std::vector<uint32> hashTable(1ull << HashBits, 0);
+		while (pIn < pFindLimit)
+		{
+			const uint32 sequence = Read32(pIn);
+			const uint32 hash = Hash(sequence);
+			const uint8* pRef = pSrc + hashTable[hash];
+			hashTable[hash] = (uint32)(pIn - pSrc);
+
+			if (pRef >= pIn || (uint64)(pIn - pRef) > MaxOffset || Read32(pRef) != sequence)
+			{
+				pIn++;
+				continue;
+			}
+
+			uint64 matchLength = MinMatch;
+			while (pIn + matchLength < pMatchLimit && pIn[matchLength] == pRef[matchLength])
+				matchLength++;
+
+			if (!WriteSequence(pOut, pOutEnd, pAnchor, (uint64)(pIn - pAnchor), (uint64)(pIn - pRef), matchLength))
+				return 0;
+
+			pIn += matchLength;
+			pAnchor = pIn;
+		}
+	}
+
+	if (!WriteSequence(pOut, pOutEnd, pAnchor, (uint64)(pInEnd - pAnchor), 0, 0))
+		return 0;
+	return (uint64)(pOut - pDst);
+}
+
+bool RS::Utils::LZ4Decompress(const uint8* pSrc, uint64 srcSize, uint8* pDst, uint64 dstSize)
+{
+	using namespace _LZ4Internal;
+
+	const uint8* pIn = pSrc;
+	const uint8* pInEnd = pSrc + srcSize;
+	uint8* pOut = pDst;
+	uint8* pOutEnd = pDst + dstSize;
+
+	while (pIn < pInEnd)
+	{
+		const uint8 token = *pIn++;
+
+		uint64 literalCount = token >> 4;
+		if (literalCount == 15 && !ReadLength(pIn, pInEnd, literalCount))
+			return false;
+		if ((uint64)(pInEnd - pIn) < literalCount || (uint64)(pOutEnd - pOut) < literalCount)
+			return false;
+		std::memcpy(pOut, pIn, literalCount);
+		pIn += literalCount;
+		pOut += literalCount;
+
+		if (pIn == pInEnd)
+			break;
+
+		if (pInEnd - pIn < 2)
+			return false;
+		const uint64 offset = (uint64)pIn[0] | ((uint64)pIn[1] << 8);
+		pIn += 2;
+		if (offset == 0 || offset > (uint64)(pOut - pDst))
+			return false;
+
+		uint64 matchLength = token & 15;
+		if (matchLength == 15 && !ReadLength(pIn, pInEnd, matchLength))
+			return false;
+		matchLength += MinMatch;
+		if ((uint64)(pOutEnd - pOut) < matchLength)
+			return false;
+
+		// The match can overlap the output, copy byte by byte.
+		const uint8* pMatch = pOut - offset;
+		for (uint64 i = 0; i < matchLength; ++i)
+			pOut[i] = pMatch[i];
+		pOut += matchLength;
+	}
+
+	return pOut == pOutEnd;
+}
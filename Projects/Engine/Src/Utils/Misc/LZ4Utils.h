@@ -0,0 +1,17 @@
+#pragma once
+
+namespace RS::Utils
+{
+	/*
+	* LZ4 block format (no frame header). Fast to decompress, which is what matters for assets that are compressed once when packed.
+	*/
+
+	// Worst case size of the compressed data.
+	uint64 LZ4CompressBound(uint64 size);
+
+	// Returns the compressed size, or 0 if it did not fit in dstCapacity.
+	uint64 LZ4Compress(const uint8* pSrc, uint64 srcSize, uint8* pDst, uint64 dstCapacity);
+
+	// The decompressed size has to be known and dstSize has to match it exactly. Returns false on corrupt data.
+	bool LZ4Decompress(const uint8* pSrc, uint64 srcSize, uint8* pDst, uint64 dstSize);
+}
@@ -60,6 +60,28 @@ namespace RS::Utils
 		};
 	}
 
+	/*
+	* Generator with all of its state in one integer, so it can be saved with the rest of a simulation. It gives the same
+	* numbers on every platform, which the std distributions do not promise.
+	*/
+	struct DeterministicRandom
+	{
+		uint64 state = 0;
+
+		// SplitMix64.
+		uint64 Next()
+		{
+			uint64 z = (state += 0x9E3779B97F4A7C15ull);
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+			return z ^ (z >> 31);
+		}
+
+		// [0, 1), from the top 24 bits so every value is exact.
+		float Next01() { return (float)(Next() >> 40) * (1.f / 16777216.f); }
+		float NextRad() { return Next01() * std::numbers::pi_v<float> * 2.f; }
+	};
+
 	inline float Rand01()
 	{
 		auto rState = _Internal::RandomState::Get();
@@ -4,6 +4,63 @@
 #include "Utils/Misc/BitUtils.h"
 
 #include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+namespace RS::_SIMDUtilsInternal
+{
+    void CPUID(uint32 leaf, uint32 subleaf, uint32 registers[4])
+    {
+#if defined(_MSC_VER)
+        __cpuidex((int*)registers, (int)leaf, (int)subleaf);
+#else
+        __cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+    }
+
+    // The register state the OS saves on context switches.
+    uint64 GetEnabledXSaveFeatures()
+    {
+#if defined(_MSC_VER)
+        return _xgetbv(0);
+#else
+        uint32 low, high;
+        __asm__("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+        return ((uint64)high << 32) | low;
+#endif
+    }
+
+    RS::Utils::CPUFeatures ReadCPUFeatures()
+    {
+        RS::Utils::CPUFeatures features;
+
+        uint32 registers[4];
+        CPUID(0, 0, registers);
+        const uint32 maxLeaf = registers[0];
+        if (maxLeaf < 7)
+            return features;
+
+        CPUID(1, 0, registers);
+        const bool hasOSXSave = registers[2] & (1u << 27);
+        const bool hasAVX = registers[2] & (1u << 28);
+        const bool hasFMA = registers[2] & (1u << 12);
+        if (!hasOSXSave || !hasAVX)
+            return features;
+
+        // XMM and YMM state for AVX, the opmask and ZMM state on top of that for AVX-512.
+        const uint64 xsave = GetEnabledXSaveFeatures();
+        const bool hasYMMState = (xsave & 0x6) == 0x6;
+        const bool hasZMMState = (xsave & 0xE6) == 0xE6;
+
+        CPUID(7, 0, registers);
+        features.avx2 = hasYMMState && hasFMA && (registers[1] & (1u << 5));
+        features.avx512 = features.avx2 && hasZMMState && (registers[1] & (1u << 16));
+        return features;
+    }
+}
 
 void RS::Utils::SIMDMemCopy(void* __restrict _Dest, const void* __restrict _Source, size_t NumQuadwords)
 {
@@ -123,3 +180,9 @@ void RS::Utils::SIMDMemFill(void* __restrict _Dest, __m128 FillVector, size_t Nu
 
     _mm_sfence();
 }
+
+const RS::Utils::CPUFeatures& RS::Utils::GetCPUFeatures()
+{
+    static const CPUFeatures s_Features = _SIMDUtilsInternal::ReadCPUFeatures();
+    return s_Features;
+}
@@ -4,4 +4,14 @@ namespace RS::Utils
 {
 	void SIMDMemCopy(void* __restrict Dest, const void* __restrict Source, size_t NumQuadwords);
 	void SIMDMemFill(void* __restrict Dest, __m128 FillVector, size_t NumQuadwords);
+
+	// Instruction sets past the x64 baseline that both the CPU and the OS support.
+	struct CPUFeatures
+	{
+		bool avx2 = false;		// Together with FMA.
+		bool avx512 = false;	// AVX-512F.
+	};
+
+	// Read with CPUID the first time it is called.
+	const CPUFeatures& GetCPUFeatures();
 }
@@ -18,6 +18,7 @@ namespace RS::Utils
 	*	ToString		- Converts a wide string into a normal string.
 	*	EndsWith		- Checks if the string ends with a certain substring.
 	*	StartsWith		- Checks if the string starts with a certain substring.
+	*	DecodeUTF8		- Reads one codepoint from a UTF-8 string.
 	*/
 
 	/*
@@ -273,4 +274,58 @@ namespace RS::Utils
 		std::filesystem::path fsPath(path);
 		return fsPath.extension().string();
 	}
+
+	/*
+	* Reads the codepoint at offset and moves offset past it. Invalid, overlong and truncated sequences give U+FFFD and skip one byte.
+	* Example:
+	*	size_t offset = 0;
+	*	while (offset < text.size())
+	*		uint32 codepoint = DecodeUTF8(text, offset);
+	*/
+	inline constexpr uint32 DecodeUTF8(std::string_view text, size_t& offset)
+	{
+		constexpr uint32 ReplacementCharacter = 0xFFFD;
+		const uint8 first = (uint8)text[offset++];
+		if (first < 0x80)
+			return first;
+
+		uint32 length = 0, codepoint = 0, minCodepoint = 0;
+		if ((first & 0xE0) == 0xC0)
+		{
+			length = 1;
+			codepoint = first & 0x1F;
+			minCodepoint = 0x80;
+		}
+		else if ((first & 0xF0) == 0xE0)
+		{
+			length = 2;
+			codepoint = first & 0x0F;
+			minCodepoint = 0x800;
+		}
+		else if ((first & 0xF8) == 0xF0)
+		{
+			length = 3;
+			codepoint = first & 0x07;
+			minCodepoint = 0x10000;
+		}
+		else
+		{
+			return ReplacementCharacter;
+		}
+
+		if (offset + length > text.size())
+			return ReplacementCharacter;
+		for (uint32 i = 0; i < length; ++i)
+		{
+			const uint8 next = (uint8)text[offset + i];
+			if ((next & 0xC0) != 0x80)
+				return ReplacementCharacter;
+			codepoint = (codepoint << 6) | (next & 0x3F);
+		}
+
+		if (codepoint < minCodepoint || codepoint > 0x10FFFF || (codepoint >= 0xD800 && codepoint <= 0xDFFF))
+			return ReplacementCharacter;
+		offset += length;
+		return codepoint;
+	}
 }
\ No newline at end of file
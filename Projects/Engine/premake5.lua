@@ -18,6 +18,15 @@ project "Engine"
     -- Files to include
 	files { GetFiles("Src/") }
 
+	-- The wider batch math kernels are built for their instruction set, and only called on CPUs that have it.
+	filter "files:Src/Maths/Batch/BatchMathAVX2.cpp"
+		flags { "NoPCH" }
+		buildoptions { "/arch:AVX2" }
+	filter "files:Src/Maths/Batch/BatchMathAVX512.cpp"
+		flags { "NoPCH" }
+		buildoptions { "/arch:AVX512" }
+	filter {}
+
     EngineIncludes()
 	
 	EngineLinks()
@@ -16,15 +16,12 @@ struct EnvironmentData
 };
 ConstantBuffer<EnvironmentData> env : register(b0, CBV_SPACE);
 
+// RS::PackedInstance2D, 16 bytes.
 struct InstanceData
 {
-    float4x4 transform;
-    float3 color;
-    uint type;
-    float scale;
-    uint padding0;
-    uint padding1;
-    uint padding2;
+    float2 position;
+    uint size;          // Width and height as half floats, the width in the low half.
+    uint colorAndType;  // Red, green and blue in the low three bytes, the type in the high byte.
 };
 StructuredBuffer<InstanceData> vsInstanceData : register(t0, SRV_SPACE);
 
@@ -36,11 +33,15 @@ PSInput VertexMain(float4 position : SV_POSITION, float2 uv : UV0, uint instance
 {
     PSInput result = (PSInput)0;
 
-    InstanceData instanceData = vsInstanceData[instanceIndex]; 
-    result.position = mul(mul(env.camera, instanceData.transform), float4(position.xyz * instanceData.scale , 1.0f)); // Clip space.
+    InstanceData instanceData = vsInstanceData[instanceIndex];
+    float2 size = float2(f16tof32(instanceData.size), f16tof32(instanceData.size >> 16));
+    float3 color = float3(instanceData.colorAndType & 0xFF, (instanceData.colorAndType >> 8) & 0xFF, (instanceData.colorAndType >> 16) & 0xFF) / 255.f;
+
+    float4 worldPosition = float4(position.xy * size + instanceData.position, position.z, 1.0f);
+    result.position = mul(env.camera, worldPosition); // Clip space.
     result.uv = uv;
-    result.color = instanceData.color;
-    result.type = instanceData.type;
+    result.color = color;
+    result.type = instanceData.colorAndType >> 24;
 
     return result;
 }
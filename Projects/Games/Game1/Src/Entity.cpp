@@ -1,8 +1,10 @@
 #include "Entity.h"
 
-Entity::EntityInfo Entity::GetEntityInfoFromType(Entity::Type type)
+#include <array>
+
+static Entity::EntityInfo CreateEntityInfo(Entity::Type type)
 {
-	EntityInfo info;
+	Entity::EntityInfo info;
 	switch (type)
 	{
 	case Entity::Type::EASY_ENEMY:
@@ -26,6 +28,18 @@ Entity::EntityInfo Entity::GetEntityInfoFromType(Entity::Type type)
 	}
 }
 
+const Entity::EntityInfo& Entity::GetEntityInfoFromType(Type type)
+{
+	static const std::array<EntityInfo, (uint)Type::COUNT> s_EntityInfos = []()
+	{
+		std::array<EntityInfo, (uint)Type::COUNT> infos;
+		for (uint i = 0; i < (uint)Type::COUNT; ++i)
+			infos[i] = CreateEntityInfo((Type)i);
+		return infos;
+	}();
+	return s_EntityInfos[(uint)type];
+}
+
 bool Entity::IsEnemy(Type type)
 {
 	return (uint)type < (uint)Type::ENEMY_COUNT;
@@ -24,18 +24,18 @@ public:
 		uint bitCount = 0;
 	};
 
-	static EntityInfo GetEntityInfoFromType(Type type);
+	// The info of every type is built once, so this is cheap enough to call per entity.
+	static const EntityInfo& GetEntityInfoFromType(Type type);
 
 	static bool IsEnemy(Type type);
 
 public:
-	Entity(Type type, const glm::vec2& pos, const glm::vec2& vel, float friction = 0.f, float health = 100.f)
-		: m_Type(type), m_Position(pos), m_Velocity(vel), m_Friction(friction), m_Health(health), m_Scale(1.f) {}
-
-	Type m_Type;
-	glm::vec2 m_Position;
-	glm::vec2 m_Velocity;
-	float m_Friction;
-	float m_Health;
-	float m_Scale;
+	// Components of the entities in Game1App's entity store.
+	struct Position { glm::vec2 value; };
+	struct Velocity { glm::vec2 value; };
+	struct Friction { float value = 0.f; };
+	struct Health { float value = 100.f; };
+	struct Scale { float value = 1.f; };
+	struct OverlapsPlayer { bool value = false; };
+	struct Proxy { uint32 value = 0; }; // In Game1App's broadphase.
 };
\ No newline at end of file
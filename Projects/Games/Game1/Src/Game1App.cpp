@@ -16,12 +16,54 @@
 #include <glm/gtx/norm.hpp>
 
 #include "Core/Console.h"
+#include "Maths/Batch/BatchMath.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
 
 #include "Graphics/TextRenderer.h"
 
 #include "Audio/AudioSystem.h"
 #include "Audio/Filters/LowpassFilter.h"
 
+namespace
+{
+    RS::AABB2D GetEntityBounds(Entity::Type type, const glm::vec2& position)
+    {
+        const glm::vec2 size = Entity::GetEntityInfoFromType(type).size;
+        return RS::AABB2D::FromCenterSize(position.x, position.y, size.x, size.y);
+    }
+
+    // Touching edges do not count, unlike AABB2D::Overlaps.
+    bool IsOverlappingStrictly(const RS::AABB2D& a, const RS::AABB2D& b)
+    {
+        return a.min[0] < b.max[0] && a.max[0] > b.min[0] && a.min[1] < b.max[1] && a.max[1] > b.min[1];
+    }
+
+    // The components of one chunk with an array per float, how the Batch kernels read them.
+    struct ChunkSoA
+    {
+        std::vector<float> x;
+        std::vector<float> y;
+        std::vector<float> z;
+        std::vector<float> velocityX;
+        std::vector<float> velocityY;
+        std::vector<float> friction;
+        std::vector<float> extentX;
+        std::vector<float> extentY;
+        std::vector<float> speedSquared;
+        std::vector<uint32> visible;
+
+        void Resize(uint count)
+        {
+            for (std::vector<float>* pArray : { &x, &y, &z, &velocityX, &velocityY, &friction, &extentX, &extentY, &speedSquared })
+                pArray->resize(count);
+            visible.resize(count);
+        }
+    };
+}
+
 RS_ADD_GLOBAL_CONSOLE_VAR(float, "Game1App.player.borderWidth", g_PlayerBorderWidth, 0.1f, "Player Border Width");
 RS_ADD_GLOBAL_CONSOLE_VAR(float, "Game1App.player.attackSpeed", g_PlayerAttackSpeed, 1.5f, "Player Attack Speed in Seconds");
 RS_ADD_GLOBAL_CONSOLE_VAR(float, "Game1App.player.attackDuration", g_PlayerAttackDuration, 0.4f, "Player Attack Duration in Seconds");
@@ -35,6 +77,7 @@ RS_ADD_GLOBAL_READONLY_CONSOLE_VAR(uint, "Game1App.bits.count", g_BitCount, 0, "
 
 Game1App::Game1App()
 {
+    m_History.AddState(m_State);
     Init();
 }
 
@@ -44,6 +87,13 @@ Game1App::~Game1App()
 
 void Game1App::FixedTick()
 {
+    // Saved before the tick runs, restoring it runs the tick again.
+    m_History.Save(m_State.tick);
+
+    TickInput input;
+    input.playerPosition = GetMouseWorldPosition();
+    Simulate(input, m_FixedDT);
+    m_State.tick++;
 }
 
 void Game1App::Tick(const RS::FrameStats& frameStats)
@@ -60,31 +110,20 @@ void Game1App::Tick(const RS::FrameStats& frameStats)
     //if (sCameraIsActive)
     m_Camera.Update(frameStats.frame.currentDT);
 
-    // == Update ==
+    // The ticks of the next frame use the rate that is set now.
+    m_FixedDT = 1.f / frameStats.fixedUpdate.fixedFPS;
 
-    // Update enemy positions
-    UpdateEntities(frameStats);
+    // Go back one second by pressing R.
+    if (RS::Input::Get()->IsKeyClicked(RS::Key::R))
+        RewindTo(m_State.tick > 60 ? m_State.tick - 60 : 0);
 
-    g_ActiveEntities = m_ActiveEntities;
+    g_ActiveEntities = (uint)m_Entities.GetCount();
+    g_killCount = m_State.killCount;
+    g_BitCount = m_State.bitCount;
 
     auto pCommandQueue = RS::DX12Core3::Get()->GetDirectCommandQueue();
     auto pCommandList = pCommandQueue->GetCommandList();
 
-    // Spawn new enemies
-    static float time = 0.f;
-    time += frameStats.frame.currentDT;
-    if (time > 1.f)
-    {
-        float r = RS::Utils::Rand01();
-        Entity::Type type = Entity::Type::EASY_ENEMY;
-        if (r < 0.6)
-            type = Entity::Type::EASY_ENEMY;
-        else
-            type = Entity::Type::NORMAL_ENEMY;
-        SpawnEnemy(type, 4.f, pCommandList);
-        time = 0.f;
-    }
-
     // == Render ==
     D3D12_VIEWPORT viewport{};
     viewport.MaxDepth = 0;
@@ -107,61 +146,101 @@ void Game1App::Tick(const RS::FrameStats& frameStats)
     auto pRenderTargetDepthTexture = m_RenderTarget->GetAttachment(RS::AttachmentPoint::DepthStencil);
     pCommandList->ClearDSV(pRenderTargetDepthTexture, D3D12_CLEAR_FLAG_DEPTH, pRenderTargetDepthTexture->GetClearValue()->DepthStencil.Depth, pRenderTargetDepthTexture->GetClearValue()->DepthStencil.Stencil);
 
-    UpdateEntitiesInstanceData(pCommandList);
+    UpdateEntitiesInstanceData(frameStats.fixedUpdate.alpha);
 
     DrawEntites(frameStats, pCommandList);
 
-    static bool isAttacking = false;
+    if (!m_State.isAttacking)
+        DrawPlayer(pCommandList);
+
+    std::string score = RS::Utils::Format("Kills: {}", m_State.killCount);
+    RS::TextRenderer::Get()->RenderText(score, 50, RS::Display::Get()->GetHeight() * 0.9f, 1.f, glm::vec3(0.f, 0.f, 1.f));
+    std::string health = RS::Utils::Format("Health: {}", m_State.playerCurrentHealth);
+    RS::TextRenderer::Get()->RenderText(health, 50, RS::Display::Get()->GetHeight() * 0.9f - 50, 1.f, glm::vec3(0.f, 0.f, 1.f));
+    std::string bits = RS::Utils::Format("Bits: {}", m_State.bitCount);
+    RS::TextRenderer::Get()->RenderText(bits, 50, RS::Display::Get()->GetHeight() * 0.9f - 100, 1.f, glm::vec3(0.f, 0.f, 1.f));
+
+    RS::TextRenderer::Get()->Render(pCommandList, m_RenderTarget);
+
+    // TODO: Change this to render to backbuffer instead of copy. Reason: If window gets resized this will not work.
+    auto pTexture = m_RenderTarget->GetColorTextures()[0];
+    pCommandList->CopyResource(RS::DX12Core3::Get()->GetSwapChain()->GetCurrentBackBuffer(), pTexture);
+
+    pCommandQueue->ExecuteCommandList(pCommandList);
+}
+
+void Game1App::Simulate(const TickInput& input, float dt)
+{
+    // Rendering interpolates from where the entities were at the end of the last tick.
+    RS::ECS::StorePrevious<Entity::Position>(m_Entities);
+
+    // Update enemy positions
+    UpdateEntities(dt);
+    FindOverlappingEnemiesWithPlayer(input.playerPosition);
+
+    // Spawn new enemies
+    m_State.spawnTime += dt;
+    if (m_State.spawnTime > 1.f)
+    {
+        float r = m_State.random.Next01();
+        Entity::Type type = Entity::Type::EASY_ENEMY;
+        if (r < 0.6)
+            type = Entity::Type::EASY_ENEMY;
+        else
+            type = Entity::Type::NORMAL_ENEMY;
+        SpawnEnemy(type, 4.f);
+        m_State.spawnTime = 0.f;
+    }
+
     bool firstAttackFrame = false;
-    static float attackSpeedTime = 0.f;
-    static float attackDuration = 0.f;
-    if (!isAttacking)
+    if (!m_State.isAttacking)
     {
-        attackSpeedTime += frameStats.frame.currentDT;
-        if (attackSpeedTime > g_PlayerAttackSpeed)
+        m_State.attackSpeedTime += dt;
+        if (m_State.attackSpeedTime > g_PlayerAttackSpeed)
         {
-            isAttacking = true;
-            attackSpeedTime = 0.f;
+            m_State.isAttacking = true;
+            m_State.attackSpeedTime = 0.f;
             firstAttackFrame = true;
         }
     }
     else
     {
-        attackDuration += frameStats.frame.currentDT;
-        if (attackDuration > g_PlayerAttackDuration)
+        m_State.attackDuration += dt;
+        if (m_State.attackDuration > g_PlayerAttackDuration)
         {
-            isAttacking = false;
-            attackDuration = 0.f;
+            m_State.isAttacking = false;
+            m_State.attackDuration = 0.f;
         }
     }
 
-    if (!isAttacking)
-        DrawPlayer(pCommandList);
-    
     if (firstAttackFrame)
     {
         pButtonOnSound->Play();
         // Damage entities
-        for (uint i : m_EntitiesThatOverlapPlayer)
+        for (RS::ECS::EntityHandle entity : m_EntitiesThatOverlapPlayer)
         {
-            Entity& ent = m_Entities[i];
-            if (Entity::IsEnemy(ent.m_Type))
+            const Entity::Type type = *m_Entities.Get<Entity::Type>(entity);
+            if (Entity::IsEnemy(type))
             {
-                ent.m_Health -= g_PlayerAttackDamage;
+                Entity::Health& health = *m_Entities.Get<Entity::Health>(entity);
+                health.value -= g_PlayerAttackDamage;
 
-                Entity::EntityInfo info = Entity::GetEntityInfoFromType(ent.m_Type);
+                const Entity::EntityInfo& info = Entity::GetEntityInfoFromType(type);
 
-                m_PlayerCurrentHealth -= info.attack;
-                if (m_PlayerCurrentHealth <= 0)
+                m_State.playerCurrentHealth -= info.attack;
+                if (m_State.playerCurrentHealth <= 0)
                 {
                     // Player is dead!
                 }
 
                 // Spawn Bits!
-                if (ent.m_Health <= 0)
+                if (health.value <= 0)
                 {
+                    // Read what the bits need before creating them, creating entities is a structural change.
+                    const glm::vec2 position = m_Entities.Get<Entity::Position>(entity)->value;
+                    const glm::vec2 velocity = m_Entities.Get<Entity::Velocity>(entity)->value;
                     for (uint bitIndex = 0; bitIndex < info.bitCount; bitIndex++)
-                        SpawnBit(ent.m_Position, ent.m_Velocity, pCommandList);
+                        SpawnBit(position, velocity);
                 }
             }
         }
@@ -170,33 +249,57 @@ void Game1App::Tick(const RS::FrameStats& frameStats)
     }
 
     // Gather bits
-    for (uint i : m_EntitiesThatOverlapPlayer)
+    for (RS::ECS::EntityHandle entity : m_EntitiesThatOverlapPlayer)
     {
-        Entity& ent = m_Entities[i];
-        if (ent.m_Type == Entity::Type::BIT)
+        if (*m_Entities.Get<Entity::Type>(entity) == Entity::Type::BIT)
         {
-            float v2 = glm::length2(ent.m_Velocity);
+            float v2 = glm::length2(m_Entities.Get<Entity::Velocity>(entity)->value);
             if (v2 > g_BitMaxPickupSpeed)
                 continue;
-            g_BitCount++;
-            ent.m_Health = 0;
+            m_State.bitCount++;
+            m_Entities.Get<Entity::Health>(entity)->value = 0;
         }
     }
+}
 
-    std::string score = RS::Utils::Format("Kills: {}", g_killCount);
-    RS::TextRenderer::Get()->RenderText(score, 50, RS::Display::Get()->GetHeight() * 0.9f, 1.f, glm::vec3(0.f, 0.f, 1.f));
-    std::string health = RS::Utils::Format("Health: {}", m_PlayerCurrentHealth);
-    RS::TextRenderer::Get()->RenderText(health, 50, RS::Display::Get()->GetHeight() * 0.9f - 50, 1.f, glm::vec3(0.f, 0.f, 1.f));
-    std::string bits = RS::Utils::Format("Bits: {}", g_BitCount);
-    RS::TextRenderer::Get()->RenderText(bits, 50, RS::Display::Get()->GetHeight() * 0.9f - 100, 1.f, glm::vec3(0.f, 0.f, 1.f));
+void Game1App::RewindTo(uint64 tick)
+{
+    if (!m_History.Restore(tick))
+        return;
 
-    RS::TextRenderer::Get()->Render(pCommandList, m_RenderTarget);
+    // The broadphase is not part of the history, the restored entities are added to a new one.
+    RebuildBroadphase();
 
-    // TODO: Change this to render to backbuffer instead of copy. Reason: If window gets resized this will not work.
-    auto pTexture = m_RenderTarget->GetColorTextures()[0];
-    pCommandList->CopyResource(RS::DX12Core3::Get()->GetSwapChain()->GetCurrentBackBuffer(), pTexture);
+    // The flags are restored with the entities, the list has to match them.
+    m_EntitiesThatOverlapPlayer.clear();
+    m_Entities.ForEach<Entity::OverlapsPlayer>([&](RS::ECS::EntityHandle entity, const Entity::OverlapsPlayer& overlapsPlayer)
+        {
+            if (overlapsPlayer.value)
+                m_EntitiesThatOverlapPlayer.push_back(entity);
+        });
+    std::sort(m_EntitiesThatOverlapPlayer.begin(), m_EntitiesThatOverlapPlayer.end(), [](RS::ECS::EntityHandle a, RS::ECS::EntityHandle b) { return a.index < b.index; });
+}
 
-    pCommandQueue->ExecuteCommandList(pCommandList);
+void Game1App::RebuildBroadphase()
+{
+    std::vector<RS::AABB2D> bounds;
+    m_ProxyEntities.clear();
+    m_Entities.ForEach<Entity::Type, Entity::Position, Entity::Proxy>([&](RS::ECS::EntityHandle entity, const Entity::Type& type, const Entity::Position& position, Entity::Proxy& proxy)
+        {
+            proxy.value = (uint32)bounds.size();
+            bounds.push_back(GetEntityBounds(type, position.value));
+            m_ProxyEntities.push_back(entity);
+        });
+    m_Broadphase.Build(bounds);
+}
+
+glm::vec2 Game1App::GetMouseWorldPosition() const
+{
+    glm::vec2 mousePos = RS::Input::Get()->GetMousePos() / RS::Display::Get()->GetSize();
+    mousePos.y = 1.f - mousePos.y;
+    mousePos *= m_WorldSize;
+    mousePos -= m_WorldSize * 0.5f;
+    return mousePos;
 }
 
 void Game1App::Init()
@@ -406,54 +509,84 @@ void Game1App::CreateRootSignature()
     rootSignature.Bake("Game1_RootSignature");
 }
 
-void Game1App::UpdateEntities(const RS::FrameStats& frameStats)
+void Game1App::UpdateEntities(float dt)
 {
-    for (int i = 0; i < m_ActiveEntities; i++)
-    {
-        Entity& ent = m_Entities[i];
-        ent.m_Position += ent.m_Velocity * frameStats.frame.currentDT;
-
-        float v2 = glm::length2(ent.m_Velocity);
-        if (ent.m_Friction > FLT_EPSILON)
-        {
-            if (v2 > 0.005)
-                ent.m_Velocity -= ent.m_Velocity * ent.m_Friction * frameStats.frame.currentDT;
-            else
-                ent.m_Velocity = glm::vec2(0.f, 0.f);
-        }
+    std::atomic<uint> killCount = 0;
 
-        if (ent.m_Type == Entity::Type::BIT)
+    m_Entities.ForEachChunkParallel<Entity::Type, Entity::Position, Entity::Velocity, Entity::Friction, Entity::Health, Entity::Scale, Entity::Proxy>([&](const RS::ECS::Chunk& chunk)
         {
-            ent.m_Scale = RS::Utils::Lerp(1.f, 1.5f, RS::Utils::Smoothstep(0.005f, 5.f, v2));
-        }
+            const RS::ECS::EntityHandle* pEntities = chunk.GetEntities();
+            const Entity::Type* pTypes = chunk.Get<Entity::Type>();
+            Entity::Position* pPositions = chunk.Get<Entity::Position>();
+            Entity::Velocity* pVelocities = chunk.Get<Entity::Velocity>();
+            const Entity::Friction* pFrictions = chunk.Get<Entity::Friction>();
+            const Entity::Health* pHealths = chunk.Get<Entity::Health>();
+            Entity::Scale* pScales = chunk.Get<Entity::Scale>();
+            const Entity::Proxy* pProxies = chunk.Get<Entity::Proxy>();
+            const uint count = (uint)chunk.GetCount();
+
+            // The chunks are updated in parallel, each thread splits them into its own arrays.
+            thread_local ChunkSoA bodies;
+            bodies.Resize(count);
+            for (uint i = 0; i < count; i++)
+            {
+                bodies.x[i] = pPositions[i].value.x;
+                bodies.y[i] = pPositions[i].value.y;
+                bodies.velocityX[i] = pVelocities[i].value.x;
+                bodies.velocityY[i] = pVelocities[i].value.y;
+                bodies.friction[i] = pFrictions[i].value;
+                bodies.speedSquared[i] = glm::length2(pVelocities[i].value);
+            }
 
-        // Remove entities outside of bounds and only when they are going away from the playing area.
-        bool isHeadingOutside = glm::dot(ent.m_Position, ent.m_Velocity) > 0.f;
-        bool isOutsideWorld =   std::abs(ent.m_Position.x) > m_WorldSize.x * 0.5f * 1.1f &&
-                                std::abs(ent.m_Position.y) > m_WorldSize.y * 0.5f * 1.1f;
-        bool isDead = ent.m_Health < FLT_EPSILON;
-        if (isDead)
-            g_killCount++;
+            // Moves the entities and slows down the ones with friction, the bits.
+            RS::Batch::BodiesSoA bodiesSoA{};
+            bodiesSoA.pPositionX = bodies.x.data();
+            bodiesSoA.pPositionY = bodies.y.data();
+            bodiesSoA.pVelocityX = bodies.velocityX.data();
+            bodiesSoA.pVelocityY = bodies.velocityY.data();
+            bodiesSoA.pFriction = bodies.friction.data();
+            RS::Batch::Integrate(bodiesSoA, count, dt);
 
-        bool shouldBeRemoved = (isHeadingOutside && isOutsideWorld) || isDead;
-        if (shouldBeRemoved)
-        {
-            m_ActiveEntities--;
-            if (i != m_ActiveEntities + 1)
+            for (uint i = 0; i < count; i++)
             {
-                m_Entities[i] = m_Entities[m_ActiveEntities];
-                i--;
+                glm::vec2& position = pPositions[i].value;
+                glm::vec2& velocity = pVelocities[i].value;
+                position = glm::vec2(bodies.x[i], bodies.y[i]);
+                velocity = glm::vec2(bodies.velocityX[i], bodies.velocityY[i]);
+                m_Broadphase.Update(pProxies[i].value, GetEntityBounds(pTypes[i], position));
+
+                // The speed before the friction.
+                const float v2 = bodies.speedSquared[i];
+                if (pTypes[i] == Entity::Type::BIT)
+                {
+                    pScales[i].value = RS::Utils::Lerp(1.f, 1.5f, RS::Utils::Smoothstep(0.005f, 5.f, v2));
+                }
+
+                // Remove entities outside of bounds and only when they are going away from the playing area.
+                bool isHeadingOutside = glm::dot(position, velocity) > 0.f;
+                bool isOutsideWorld =   std::abs(position.x) > m_WorldSize.x * 0.5f * 1.1f &&
+                                        std::abs(position.y) > m_WorldSize.y * 0.5f * 1.1f;
+                bool isDead = pHealths[i].value < FLT_EPSILON;
+                if (isDead)
+                    killCount++;
+
+                bool shouldBeRemoved = (isHeadingOutside && isOutsideWorld) || isDead;
+                if (shouldBeRemoved)
+                    m_Entities.QueueDestroy(pEntities[i]);
             }
-            m_Entities.pop_back();
-        }
-    }
+        });
 
-    FindOverlappingEnemiesWithPlayer();
+    m_Broadphase.CommitUpdates();
+    m_Entities.FlushDestroyed([&](RS::ECS::EntityHandle entity)
+        {
+            m_Broadphase.Remove(m_Entities.Get<Entity::Proxy>(entity)->value);
+        });
+    m_State.killCount += killCount;
 }
 
 void Game1App::DrawEntites(const RS::FrameStats& frameStats, std::shared_ptr<RS::CommandList> pCommandList)
 {
-    if (m_InstanceData.empty())
+    if (m_ActiveEntities == 0)
         return;
 
     pCommandList->SetRootSignature(m_pRootSignature);
@@ -472,7 +605,7 @@ void Game1App::DrawEntites(const RS::FrameStats& frameStats, std::shared_ptr<RS:
     vertexViewData.camera = vertexViewData.camera;
     pCommandList->SetGraphicsDynamicConstantBuffer(RootParameter::CBVs, sizeof(vertexViewData), (void*)&vertexViewData);
 
-    pCommandList->BindBuffer(RootParameter::SRVs, 0, m_InstanceBuffer, &m_InstanceDataSRVDesc);
+    m_InstanceStream.Bind(pCommandList, RootParameter::SRVs, 0);
 
     pCommandList->DrawInstanced(m_NumVertices, m_ActiveEntities, 0, 0);
 }
@@ -493,11 +626,8 @@ void Game1App::DrawPlayer(std::shared_ptr<RS::CommandList> pCommandList)
         float uvBorderWidth;
     } vertexViewData;
 
-    glm::vec2 mousePos = RS::Input::Get()->GetMousePos() / RS::Display::Get()->GetSize();
-    mousePos.y = 1.f - mousePos.y;
-    mousePos *= m_WorldSize;
-    mousePos -= m_WorldSize * 0.5f;
-    m_PlayerPosition = mousePos;
+    // Drawn where the mouse is now, not where the last tick saw it, so the player does not lag behind.
+    const glm::vec2 mousePos = GetMouseWorldPosition();
     vertexViewData.camera = glm::transpose(m_Camera.GetProjection() * m_Camera.GetView() * glm::translate(glm::vec3(mousePos, 0.f)) * glm::scale(glm::vec3(m_PlayerSize, 1.f)));
     vertexViewData.camera = vertexViewData.camera;
     vertexViewData.uvBorderWidth = g_PlayerBorderWidth;
@@ -506,162 +636,134 @@ void Game1App::DrawPlayer(std::shared_ptr<RS::CommandList> pCommandList)
     pCommandList->DrawInstanced(m_NumVertices, 1, 0, 0);
 }
 
-void Game1App::SpawnEnemy(Entity::Type type, float initialSpeed, std::shared_ptr<RS::CommandList> pCommandList)
+void Game1App::SpawnEnemy(Entity::Type type, float initialSpeed)
 {
     // == Add enemy ==
     
     // Spawn the enemy outside the view, pick position from a random angle around the unit circle.
-    float angle = RS::Utils::RandRad();
+    float angle = m_State.random.NextRad();
     glm::vec2 spawnPoint(std::cos(angle), std::sin(angle));
     spawnPoint *= std::max(m_WorldSize.x, m_WorldSize.y) * 0.5f;
     spawnPoint *= 1.1f; // Add extra distance such that we cannot see them being spawned in.
     
     // Pick the velocity to point towards an area around the center of the screen.
-    angle = RS::Utils::RandRad();
+    angle = m_State.random.NextRad();
     glm::vec2 velocity(std::cos(angle), std::sin(angle));
     velocity *= std::min(m_WorldSize.x, m_WorldSize.y) * 0.5f * 0.5f;
     velocity = glm::normalize(velocity - spawnPoint) * initialSpeed;
-    m_Entities.emplace_back(type, spawnPoint, velocity);
-
-    m_ActiveEntities++;
-    
-    // Add entity to instance data
-    Entity::EntityInfo info = Entity::GetEntityInfoFromType(type);
-    InstanceData instanceData;
-    instanceData.transform = glm::transpose(glm::translate(glm::vec3(spawnPoint, 0.f)) * glm::scale(glm::vec3(info.size, 1.f)));
-    instanceData.type = (uint)type;
-    instanceData.color = info.color;
-    
-    if (m_ActiveEntities > (uint)m_InstanceData.size())
-    {
-        m_InstanceData.push_back(instanceData);
-
-        // Update GPU buffer
-        uint newCount = (uint)m_InstanceData.size();
-        ResizeEntitiesInstanceData(newCount, pCommandList, true);
-    }
-    else
-    {
-        m_InstanceData[m_ActiveEntities - 1] = instanceData;
-    }
+    AddToBroadphase(m_Entities.Create(type, Entity::Position{ spawnPoint }, RS::ECS::Previous<Entity::Position>{ { spawnPoint } }, Entity::Velocity{ velocity }, Entity::Friction{}, Entity::Health{}, Entity::Scale{}, Entity::OverlapsPlayer{}, Entity::Proxy{}));
 }
 
-void Game1App::SpawnBit(const glm::vec2& pos, const glm::vec2& initialSpeed, std::shared_ptr<RS::CommandList> pCommandList)
+void Game1App::SpawnBit(const glm::vec2& pos, const glm::vec2& initialSpeed)
 {
     float spread = g_BitSpread; // In world space
 
     // Spawn the bit in a unit circle around the given position.
-    float angle = RS::Utils::RandRad();
+    float angle = m_State.random.NextRad();
     glm::vec2 velocity(std::cos(angle), std::sin(angle));
     velocity *= spread;
     velocity += initialSpeed;
     float friction = g_BitFriction;
-    m_Entities.emplace_back(Entity::Type::BIT, pos, velocity, friction);
-
-    m_ActiveEntities++;
-
-    // Add entity to instance data
-    Entity::EntityInfo info = Entity::GetEntityInfoFromType(Entity::Type::BIT);
-    InstanceData instanceData;
-    instanceData.transform = glm::transpose(glm::translate(glm::vec3(pos, 0.f)) * glm::scale(glm::vec3(info.size, 1.f)));
-    instanceData.type = (uint)Entity::Type::BIT;
-    instanceData.color = info.color;
-
-    if (m_ActiveEntities > (uint)m_InstanceData.size())
-    {
-        m_InstanceData.push_back(instanceData);
-
-        // Update GPU buffer
-        uint newCount = (uint)m_InstanceData.size();
-        ResizeEntitiesInstanceData(newCount, pCommandList, true);
-    }
-    else
-    {
-        m_InstanceData[m_ActiveEntities - 1] = instanceData;
-    }
+    AddToBroadphase(m_Entities.Create(Entity::Type::BIT, Entity::Position{ pos }, RS::ECS::Previous<Entity::Position>{ { pos } }, Entity::Velocity{ velocity }, Entity::Friction{ friction }, Entity::Health{}, Entity::Scale{}, Entity::OverlapsPlayer{}, Entity::Proxy{}));
 }
 
-void Game1App::ResizeEntitiesInstanceData(uint newCount, std::shared_ptr<RS::CommandList> pCommandList, bool updateData)
+void Game1App::AddToBroadphase(RS::ECS::EntityHandle entity)
 {
-    uint sizeInBytes = (uint)(m_InstanceData.size() * sizeof(InstanceData));
-    m_InstanceBuffer = pCommandList->CreateBufferResource(sizeInBytes, RS::Utils::Format("Instance Data Buffer {}", newCount));
-    
-    if (updateData)
-        pCommandList->UploadToBuffer(m_InstanceBuffer, sizeInBytes, (void*)&m_InstanceData[0]);
-
-    m_InstanceDataSRVDesc = {};
-    m_InstanceDataSRVDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
-    m_InstanceDataSRVDesc.Format = DXGI_FORMAT_UNKNOWN;
-    m_InstanceDataSRVDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-    m_InstanceDataSRVDesc.Buffer.FirstElement = 0;
-    m_InstanceDataSRVDesc.Buffer.NumElements = newCount;
-    m_InstanceDataSRVDesc.Buffer.StructureByteStride = sizeof(InstanceData);
-    m_InstanceDataSRVDesc.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_NONE;
+    const uint32 proxy = m_Broadphase.Insert(GetEntityBounds(*m_Entities.Get<Entity::Type>(entity), m_Entities.Get<Entity::Position>(entity)->value));
+    m_Entities.Get<Entity::Proxy>(entity)->value = proxy;
+    if (proxy >= m_ProxyEntities.size())
+        m_ProxyEntities.resize(proxy + 1);
+    m_ProxyEntities[proxy] = entity;
 }
 
-void Game1App::UpdateEntitiesInstanceData(std::shared_ptr<RS::CommandList> pCommandList)
+void Game1App::UpdateEntitiesInstanceData(float alpha)
 {
-    if (m_InstanceData.empty())
-        return;
-
-    //RS_ASSERT(m_InstanceData.size() == m_Enemies.size(), "Cannot update buffer if the data sizes differ!");
-
-    // Transfer enemy data
-    uint counter = 0;
-    for (uint i = 0; i < m_ActiveEntities; i++)
-    {
-        Entity& entity = m_Entities[i];
-        Entity::EntityInfo info = Entity::GetEntityInfoFromType(entity.m_Type);
-
-        InstanceData& instance = m_InstanceData[i];
-        instance.transform = glm::transpose(glm::translate(glm::vec3(entity.m_Position, 0.f)) * glm::scale(glm::vec3(info.size, 1.f)));
-        instance.type = (uint)entity.m_Type;
-        instance.scale = entity.m_Scale;
-
-        bool isOverlapping = false;
-        uint overlappingEntityIdx = counter < m_EntitiesThatOverlapPlayer.size() ? m_EntitiesThatOverlapPlayer[counter] : (uint)-1;
-        if (overlappingEntityIdx != (uint)-1)
+    // Room for every entity, only the ones in view are written and drawn.
+    m_InstanceStream.Resize((uint)m_Entities.GetCount());
+
+    const std::vector<RS::Camera2D::Plane>& cameraPlanes = m_Camera.GetPlanes();
+    std::array<RS::Batch::Plane, 6> planes;
+    RS_ASSERT(cameraPlanes.size() == planes.size(), "Expected the six planes of the camera frustum!");
+    for (uint i = 0; i < (uint)planes.size(); i++)
+        planes[i] = RS::Batch::Plane::FromPointNormal(&cameraPlanes[i].point.x, &cameraPlanes[i].normal.x);
+
+    // Transfer entity data
+    uint instanceIndex = 0;
+    m_Entities.ForEachChunk<Entity::Type, Entity::Position, RS::ECS::Previous<Entity::Position>, Entity::Scale, Entity::OverlapsPlayer>([&](const RS::ECS::Chunk& chunk)
         {
-            if (overlappingEntityIdx == i)
+            const Entity::Type* pTypes = chunk.Get<Entity::Type>();
+            const Entity::Position* pPositions = chunk.Get<Entity::Position>();
+            const RS::ECS::Previous<Entity::Position>* pPreviousPositions = chunk.Get<RS::ECS::Previous<Entity::Position>>();
+            const Entity::Scale* pScales = chunk.Get<Entity::Scale>();
+            const Entity::OverlapsPlayer* pOverlapsPlayer = chunk.Get<Entity::OverlapsPlayer>();
+            const uint count = (uint)chunk.GetCount();
+
+            // The entities are flat boxes on z = 0.
+            thread_local ChunkSoA boxes;
+            boxes.Resize(count);
+            for (uint i = 0; i < count; i++)
             {
-                isOverlapping = true;
-                counter++;
+                // Between the last two ticks, the simulation runs at a fixed rate and the frames do not.
+                const glm::vec2 position = glm::mix(pPreviousPositions[i].value.value, pPositions[i].value, alpha);
+                const glm::vec2 size = Entity::GetEntityInfoFromType(pTypes[i]).size * pScales[i].value;
+                boxes.x[i] = position.x;
+                boxes.y[i] = position.y;
+                boxes.z[i] = 0.f;
+                boxes.extentX[i] = size.x * 0.5f;
+                boxes.extentY[i] = size.y * 0.5f;
             }
-        }
 
-        instance.color = isOverlapping ? glm::vec3(1.f, 1.f, 0.f) : info.color;
-    }
+            RS::Batch::BoundsSoA boxesSoA{};
+            boxesSoA.pX = boxes.x.data();
+            boxesSoA.pY = boxes.y.data();
+            boxesSoA.pZ = boxes.z.data();
+            boxesSoA.pExtentX = boxes.extentX.data();
+            boxesSoA.pExtentY = boxes.extentY.data();
+            boxesSoA.pExtentZ = boxes.z.data();
+            const uint visibleCount = (uint)RS::Batch::CullAABBs(planes, boxesSoA, count, boxes.visible.data());
+
+            for (uint v = 0; v < visibleCount; v++)
+            {
+                const uint i = boxes.visible[v];
+                const Entity::EntityInfo& info = Entity::GetEntityInfoFromType(pTypes[i]);
+                const glm::vec2 position(boxes.x[i], boxes.y[i]);
+                const glm::vec2 size(boxes.extentX[i] * 2.f, boxes.extentY[i] * 2.f);
+                const glm::vec3 color = pOverlapsPlayer[i].value ? glm::vec3(1.f, 1.f, 0.f) : info.color;
+                m_InstanceStream.Write(instanceIndex++, RS::PackedInstance2D::Pack(position.x, position.y, size.x, size.y, color.r, color.g, color.b, (uint8)pTypes[i]));
+            }
+        });
+    m_ActiveEntities = instanceIndex;
 
-    // Upload the new data to the GPU
-    uint sizeInBytes = (uint)(m_InstanceData.size() * sizeof(InstanceData));
-    pCommandList->UploadToBuffer(m_InstanceBuffer, sizeInBytes, (void*)&m_InstanceData[0]);
+    // Writes the instances that changed straight into this frame's mapped buffer.
+    m_InstanceStream.Commit();
 }
 
-void Game1App::FindOverlappingEnemiesWithPlayer()
+void Game1App::FindOverlappingEnemiesWithPlayer(const glm::vec2& playerPosition)
 {
-    struct AABB
+    // Only the entities flagged last tick can have the flag set, the ones that were destroyed since are skipped.
+    for (RS::ECS::EntityHandle entity : m_EntitiesThatOverlapPlayer)
     {
-        glm::vec2 minP;
-        glm::vec2 maxP;
-        AABB(const glm::vec2& center, const glm::vec2& size)
-            : minP(center-size*.5f), maxP(center+size*.5f) {}
-        bool IsOverlapping(const AABB& other)
-        {
-            bool overlap = (minP.x < other.maxP.x && maxP.x > other.minP.x) && (minP.y < other.maxP.y && maxP.y > other.minP.y);
-            bool aContainsB = (minP.x < other.minP.x && maxP.x > other.maxP.x) && (minP.y < other.minP.y && maxP.y > other.maxP.y);
-            bool bContainsA = (minP.x > other.minP.x && maxP.x < other.maxP.x) && (minP.y > other.minP.y && maxP.y < other.maxP.y);
-            return overlap || aContainsB || bContainsA;
-        }
-    };
+        if (m_Entities.IsAlive(entity))
+            m_Entities.Get<Entity::OverlapsPlayer>(entity)->value = false;
+    }
+
+    // Only the entities in the cells around the player are tested.
+    const RS::AABB2D playerBounds = RS::AABB2D::FromCenterSize(playerPosition.x, playerPosition.y, m_PlayerSize.x, m_PlayerSize.y);
+    m_OverlappingProxies.clear();
+    m_Broadphase.Query(playerBounds, m_OverlappingProxies);
 
-    AABB playerAABB(m_PlayerPosition, m_PlayerSize);
     m_EntitiesThatOverlapPlayer.clear();
-    for (uint i = 0; i < (uint)m_Entities.size(); i++)
+    for (uint32 proxy : m_OverlappingProxies)
     {
-        Entity& ent = m_Entities[i];
-        Entity::EntityInfo info = Entity::GetEntityInfoFromType(ent.m_Type);
-        AABB aabb(ent.m_Position, info.size);
-        if (aabb.IsOverlapping(playerAABB))
-            m_EntitiesThatOverlapPlayer.push_back(i);
+        if (!IsOverlappingStrictly(m_Broadphase.GetBounds(proxy), playerBounds))
+            continue;
+
+        const RS::ECS::EntityHandle entity = m_ProxyEntities[proxy];
+        m_Entities.Get<Entity::OverlapsPlayer>(entity)->value = true;
+        m_EntitiesThatOverlapPlayer.push_back(entity);
     }
+
+    // The proxies depend on how the broadphase was filled, which is different after a rewind. Sorted, the overlaps are
+    // handled in the same order either way.
+    std::sort(m_EntitiesThatOverlapPlayer.begin(), m_EntitiesThatOverlapPlayer.end(), [](RS::ECS::EntityHandle a, RS::ECS::EntityHandle b) { return a.index < b.index; });
 }
@@ -4,8 +4,13 @@
 
 #include "Camera2D.h"
 #include "DX12/NewCore/GraphicsPSO.h"
+#include "Graphics/InstanceStream.h"
 
 #include "Entity.h"
+#include "ECS/EntityStore.h"
+#include "ECS/SimulationHistory.h"
+#include "Utils/Misc/RandomUtils.h"
+#include "Maths/Broadphase/SpatialHashGrid2D.h"
 
 #include "Maths/GLMDefines.h"
 #include "glm/vec2.hpp"
@@ -28,18 +33,29 @@ private:
 	void CreatePipelineStatePlayer();
 	void CreateRootSignature();
 
-	void UpdateEntities(const RS::FrameStats& frameStats);
+	// What the simulation reads from the player in one tick.
+	struct TickInput
+	{
+		glm::vec2 playerPosition = glm::vec2(0.f, 0.f);
+	};
+
+	void Simulate(const TickInput& input, float dt);
+	void UpdateEntities(float dt);
+	void RewindTo(uint64 tick);
+	void RebuildBroadphase();
+
+	glm::vec2 GetMouseWorldPosition() const;
 
 	void DrawEntites(const RS::FrameStats& frameStats, std::shared_ptr<RS::CommandList> commandList);
 	void DrawPlayer(std::shared_ptr<RS::CommandList> pCommandList);
 
-	void SpawnEnemy(Entity::Type type, float initialSpeed, std::shared_ptr<RS::CommandList> pCommandList);
-	void SpawnBit(const glm::vec2& pos, const glm::vec2& initialSpeed, std::shared_ptr<RS::CommandList> pCommandList);
+	void SpawnEnemy(Entity::Type type, float initialSpeed);
+	void SpawnBit(const glm::vec2& pos, const glm::vec2& initialSpeed);
 
-	void ResizeEntitiesInstanceData(uint newCount, std::shared_ptr<RS::CommandList> pCommandList, bool updateData);
-	void UpdateEntitiesInstanceData(std::shared_ptr<RS::CommandList> pCommandList);
+	void UpdateEntitiesInstanceData(float alpha);
 
-	void FindOverlappingEnemiesWithPlayer();
+	void FindOverlappingEnemiesWithPlayer(const glm::vec2& playerPosition);
+	void AddToBroadphase(RS::ECS::EntityHandle entity);
 
 private:
 	std::shared_ptr<RS::RootSignature> m_pRootSignature;
@@ -61,32 +77,38 @@ private:
 
 	RS::Camera2D m_Camera;
 
-	// Instande data
-	struct InstanceData
-	{
-		glm::mat4 transform;
-		glm::vec3 color;
-		uint type;
-		float scale = 1.f;
-		uint padding0;
-		uint padding1;
-		uint padding2;
-	};
-	std::shared_ptr<RS::Buffer> m_InstanceBuffer;
-	std::vector<InstanceData> m_InstanceData;
-	D3D12_SHADER_RESOURCE_VIEW_DESC m_InstanceDataSRVDesc;
+	// Instance data, only the entities that changed are written to the GPU.
+	RS::InstanceStream<RS::PackedInstance2D> m_InstanceStream{ "Game1 Entity Instances" };
 
 	// Game data
 	glm::vec2 m_WorldSize;
-	std::vector<Entity> m_Entities;
-	std::vector<uint> m_EntitiesThatOverlapPlayer;
-	uint m_ActiveEntities = 0;
+	RS::ECS::EntityStore m_Entities;
+
+	// Everything the simulation changes outside of the entities, saved with them in the history.
+	struct SimulationState
+	{
+		uint64 tick = 0;
+		RS::Utils::DeterministicRandom random = { 0x1234 };
+		float spawnTime = 0.f;
+		bool isAttacking = false;
+		float attackSpeedTime = 0.f;
+		float attackDuration = 0.f;
+		int playerCurrentHealth = 100;
+		uint killCount = 0;
+		uint bitCount = 0;
+	} m_State;
+	RS::ECS::SimulationHistory m_History{ m_Entities, 120 }; // Two seconds at 60 ticks per second.
+	float m_FixedDT = 1.f / 60.f;
+
+	std::vector<RS::ECS::EntityHandle> m_EntitiesThatOverlapPlayer;
+	RS::SpatialHashGrid2D m_Broadphase{ 2.f, 1u << 12 };
+	std::vector<RS::ECS::EntityHandle> m_ProxyEntities; // Indexed by proxy.
+	std::vector<uint32> m_OverlappingProxies;
+	uint m_ActiveEntities = 0; // Number of instances drawn, the entities in view.
 
-	glm::vec2 m_PlayerPosition;
 	glm::vec2 m_PlayerSize = glm::vec2(3.f, 3.f);
 
 	uint m_PlayerMaxHealth = 100;
-	int m_PlayerCurrentHealth = 100;
 
 	// Sounds
 	RS::Sound* pButtonOnSound = nullptr;
@@ -11,11 +11,17 @@
 
 #include "DX12/Final/DXTexture.h"
 #include "Core/CorePlatform.h"
+#include "Core/Profiler.h"
 #include "DX12/Final/DXShader.h"
 #include "Graphics/RenderCore.h"
+#include "Graphics/Renderer2D.h"
 #include "DX12/Final/DXCommandContext.h"
 
 #include "Render/ImGuiRenderer.h"
+#include "Render/GPUProfiler.h"
+#include "Render/TextureStreamer.h"
+#include "DX12/Final/DXTextureStreamingDevice.h"
+#include "Loaders/Texture/TextureCooker.h"
 
 int main(int argc, char* argv[])
 {
@@ -53,33 +59,27 @@ int main(int argc, char* argv[])
     RS::ImGuiRenderer::Get()->Init();
 
     auto pImage = RS::CorePlatform::LoadImageData("flyToYourDream.jpg", RS::Format::RS_FORMAT_R8G8B8A8_UNORM, RS::CorePlatform::ImageFlag::FLIP_Y, true);
-    RS::DX12::DXTexture texture;
-    texture.Create2D(pImage->width * 4, pImage->width, pImage->height, DXGI_FORMAT_R8G8B8A8_UNORM, pImage->pData);
+    auto pTexture = std::make_shared<RS::DX12::DXTexture>();
+    pTexture->Create2D(pImage->width * 4, pImage->width, pImage->height, DXGI_FORMAT_R8G8B8A8_UNORM, pImage->pData);
 
-    RS::DX12::DXGraphicsPSO graphicsPSO;
+    // The same image cooked and streamed, it is drawn instead of the loaded one once any of its mips are resident.
+    auto pTextureStreamingDevice = std::make_shared<RS::DX12::DXTextureStreamingDevice>();
+    auto pTextureStreamer = std::make_unique<RS::TextureStreamer>(pTextureStreamingDevice, std::make_shared<RS::DDSStreamingSource>());
+    RS::StreamedTextureID streamedTextureID = RS::InvalidStreamedTextureID;
     {
-        using namespace RS::DX12;
-        DXShader::Description shaderDesc{};
-        shaderDesc.isInternalPath = true;
-        shaderDesc.path = "Core/TestShaderPS.hlsl";
-        shaderDesc.typeFlags = DXShader::TypeFlag::Auto;
-        shaderDesc.defines = { };
-        DXShader shader;
-        shader.Create(shaderDesc);
-
-        graphicsPSO.SetRootSignature(RS::RenderCore::GetCommonRootSignature());
-        graphicsPSO.SetRasterizerState(RS::RenderCore::RasterizerTwoSided);
-        graphicsPSO.SetBlendState(RS::RenderCore::BlendDisable);
-        graphicsPSO.SetDepthStencilState(RS::RenderCore::DepthStateDisabled);
-        graphicsPSO.SetSampleMask(0xFFFFFFFF);
-        graphicsPSO.SetInputLayout(0, nullptr);
-        graphicsPSO.SetPrimitiveTopologyType(D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE);
-        graphicsPSO.SetShader(shader);
-        graphicsPSO.SetRenderTargetFormat(DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_UNKNOWN);
-        graphicsPSO.Finalize(false);
-        shader.Release();
+        RS::TextureCookSettings cookSettings;
+        cookSettings.isSRGB = false; // Same format as the loaded texture.
+        const std::string cookedPath = RS::TextureCooker::GetCookedPath(RS::Engine::GetTempFilePath() + "Cooked/" RS_TEXTURE_PATH "flyToYourDream.jpg");
+        if (RS::TextureCooker::Cook(RS::Engine::GetDataFilePath(true) + RS_TEXTURE_PATH "flyToYourDream.jpg", cookedPath, cookSettings) != RS::TextureCooker::Result::Failed)
+            streamedTextureID = pTextureStreamer->Register(cookedPath);
     }
 
+    // Everything in the frame is drawn with Renderer2D.
+    RS::Renderer2D::Get()->Init();
+    const bool showFrameGraph = RS::LaunchArguments::Contains(RS::LaunchParams::renderer2D);
+    std::array<float, 128> frameTimesMs = {};
+    uint32 nextFrameTime = 0;
+
     RS::Console::Get()->Init();
     RS::Input::Get()->AlwaysListenToKey(RS::Key::MICRO); // For console.
     RS::FrameStats frameStats;
@@ -125,23 +125,46 @@ int main(int argc, char* argv[])
         //        m_DebugWindowsManager.FixedTick();
         //    });
 
+        std::shared_ptr<RS::DX12::DXTexture> pStreamedTexture;
+        if (streamedTextureID != RS::InvalidStreamedTextureID)
+        {
+            // Covers the whole buffer, so its longest side is as many pixels as that side of the buffer.
+            const uint32 screenSize = pImage->width >= pImage->height ? buffer.GetWidth() : buffer.GetHeight();
+            pTextureStreamer->ReportScreenSize(streamedTextureID, (float)screenSize);
+            pTextureStreamer->Update();
+            pStreamedTexture = pTextureStreamingDevice->GetTexture(streamedTextureID);
+        }
         RS::DX12::DXGraphicsContext& context = RS::DX12::DXGraphicsContext::Begin(L"Color");
 
-        context.BeginEvent("Texture buffer");
-
-        context.SetRootSignature(RS::RenderCore::GetCommonRootSignature());
-        context.SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-
-        context.SetPipelineState(graphicsPSO);
-        context.SetConstant(0, 0, RS::DX12::DXDWParam(1.0f));
-        context.TransitionResource(texture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-        context.SetDynamicDescriptor(1, 0, texture.GetSRV());
-        context.TransitionResource(buffer, D3D12_RESOURCE_STATE_RENDER_TARGET);
-        context.SetRenderTarget(buffer.GetRTV());
-        context.SetViewportAndScissor(0, 0, buffer.GetWidth(), buffer.GetHeight());
-        context.Draw(3);
+        // The image covers the whole buffer. The loaded image is flipped when it is read, the cooked one is not.
+        std::shared_ptr<RS::Renderer2D> pRenderer2D = RS::Renderer2D::Get();
+        const float imageTopV = pStreamedTexture ? 0.f : 1.f;
+        pRenderer2D->DrawSprite(pStreamedTexture ? pStreamedTexture : pTexture, 0.f, 0.f, (float)buffer.GetWidth(), (float)buffer.GetHeight(),
+            RS::Color::WHITE, 0.f, imageTopV, 1.f, 1.f - imageTopV);
 
-        context.EndEvent();
+        if (showFrameGraph)
+        {
+            frameTimesMs[nextFrameTime] = frameStats.frame.currentDT * 1000.f;
+            nextFrameTime = (nextFrameTime + 1) % (uint32)frameTimesMs.size();
+
+            // Oldest to the left, the graph is 33.3 ms high and the line is at 60 FPS.
+            const float barWidth = 2.f;
+            const float graphWidth = barWidth * frameTimesMs.size();
+            const float graphHeight = 100.f;
+            const float msToPixels = graphHeight / 33.3f;
+            pRenderer2D->SetLayer(1);
+            pRenderer2D->DrawRect(10.f, 10.f, graphWidth, graphHeight, RS::Color::ToColor32(0.f, 0.f, 0.f, 0.5f));
+            pRenderer2D->SetLayer(2);
+            for (uint32 i = 0; i < (uint32)frameTimesMs.size(); ++i)
+            {
+                const float ms = frameTimesMs[(nextFrameTime + i) % frameTimesMs.size()];
+                pRenderer2D->DrawRect(10.f + barWidth * i, 10.f, barWidth, std::min(ms * msToPixels, graphHeight), ms > 1000.f / 60.f ? RS::Color::RED : RS::Color::GREEN);
+            }
+            pRenderer2D->SetLayer(3);
+            const float lineY = 10.f + 1000.f / 60.f * msToPixels;
+            pRenderer2D->DrawLine(10.f, lineY, 10.f + graphWidth, lineY, 1.f, RS::Color::WHITE);
+        }
+        pRenderer2D->Render(context, buffer);
 
         if (RS::Console::Get()->IsEnabled() || ImGui::HasToastNotifications())
         {
@@ -160,19 +183,26 @@ int main(int argc, char* argv[])
         RS::ImGuiRenderer::Get()->Render(buffer, &context);
 
         RS::DX12::DXCore::GetDXDisplay()->Present(&buffer, &context);
+        frameStats.frame.gpuMs = RS::DX12::DXCore::GetGPUProfiler()->TakeResolvedGPUMs();
 
         RS::Input::Get()->PostUpdate(frameStats.frame.currentDT);
 
         renderDoc.EndFrameCapture();
 
         frameTimer.End();
+        RS::Profiler::Get()->EndFrame();
     }
+    const bool isWithinPerfBudget = frameTimer.FinishRun();
 
     RS::ImGuiRenderer::Get()->Release();
+    RS::Renderer2D::Get()->Destory();
     buffer.Destroy();
     RS::Console::Get()->Release();
 
-    texture.Destroy();
+    // The streamer destroys its textures, the device waits for the copies out of the replaced resources.
+    pTextureStreamer.reset();
+    pTextureStreamingDevice.reset();
+    pTexture->Destroy();
     RS::DX12::DXCore::Destroy();
 
     //auto pEngineLoop = RS::EngineLoop::Get();
@@ -197,5 +227,5 @@ int main(int argc, char* argv[])
     RS::Display::Get()->Release();
     RS::Config::Get()->Destroy();
     RS::LaunchArguments::Release();
-    return 0;
+    return isWithinPerfBudget ? 0 : 1;
 }
@@ -32,5 +32,5 @@ int main(int argc, char* argv[])
 
     RS::Display::Get()->Release();
     RS::LaunchArguments::Release();
-    return 0;
+    return pEngineLook->IsWithinPerfBudget() ? 0 : 1;
 }
@@ -0,0 +1,552 @@
+#define RS_THROW_INSTEAD_OF_ASSERT
+
+#include "RSEngine.h"
+#include "Loaders/openfbx/FBXLoader.h"
+#include "Loaders/Mesh/MeshCooker.h"
+#include "Maths/BVH/SceneBVH.h"
+#include "Catch2/catch_amalgamated.hpp"
+#include "MeshTestUtils.h"
+
+#include <random>
+#include <chrono>
+
+using namespace RS;
+using namespace RS::MeshTestUtils;
+
+namespace
+{
+    using BVH4 = std::integral_constant<uint32, 4>;
+    using BVH8 = std::integral_constant<uint32, 8>;
+
+    float RandomFloat(std::mt19937& random, float min, float max)
+    {
+        return std::uniform_real_distribution<float>(min, max)(random);
+    }
+
+    AABB GetMeshBounds(const Mesh& mesh)
+    {
+        AABB bounds;
+        for (const Vertex& vertex : mesh.vertices)
+            bounds.Grow(vertex.position.values);
+        return bounds;
+    }
+
+    // From outside the bounds towards a random point inside them.
+    Ray CreateRandomRay(std::mt19937& random, const AABB& bounds)
+    {
+        Ray ray;
+        float target[3];
+        for (uint32 i = 0; i < 3; ++i)
+        {
+            const float extent = std::max(bounds.max[i] - bounds.min[i], 1e-3f);
+            ray.origin[i] = RandomFloat(random, bounds.min[i] - extent, bounds.max[i] + extent);
+            target[i] = RandomFloat(random, bounds.min[i], bounds.max[i]);
+            ray.direction[i] = target[i] - ray.origin[i];
+        }
+        return ray;
+    }
+
+    AABB CreateRandomBox(std::mt19937& random, const AABB& bounds, float maxSize)
+    {
+        AABB box;
+        for (uint32 i = 0; i < 3; ++i)
+        {
+            box.min[i] = RandomFloat(random, bounds.min[i], bounds.max[i]);
+            box.max[i] = box.min[i] + RandomFloat(random, 0.f, maxSize);
+        }
+        return box;
+    }
+
+    bool Contains(const AABB& outer, const AABB& inner)
+    {
+        for (uint32 i = 0; i < 3; ++i)
+        {
+            if (inner.min[i] < outer.min[i] || inner.max[i] > outer.max[i])
+                return false;
+        }
+        return true;
+    }
+
+    template<uint32 Width>
+    AABB GetSlotBounds(const typename BVH<Width>::Node& node, uint32 slot)
+    {
+        AABB bounds;
+        bounds.min[0] = node.minX[slot];
+        bounds.min[1] = node.minY[slot];
+        bounds.min[2] = node.minZ[slot];
+        bounds.max[0] = node.maxX[slot];
+        bounds.max[1] = node.maxY[slot];
+        bounds.max[2] = node.maxZ[slot];
+        return bounds;
+    }
+
+    // Every node is used once and after its parent, every slot contains what is under it, and every primitive is in one leaf.
+    template<uint32 Width>
+    void CheckTree(const BVH<Width>& bvh, std::span<const AABB> primitiveBounds, uint32 maxLeafSize)
+    {
+        const std::span<const typename BVH<Width>::Node> nodes = bvh.GetNodes();
+        std::vector<uint32> sortedPrimitives(bvh.GetPrimitiveIndices().begin(), bvh.GetPrimitiveIndices().end());
+        std::sort(sortedPrimitives.begin(), sortedPrimitives.end());
+        REQUIRE(sortedPrimitives.size() == primitiveBounds.size());
+        for (uint32 i = 0; i < (uint32)sortedPrimitives.size(); ++i)
+            REQUIRE(sortedPrimitives[i] == i);
+
+        std::vector<uint32> nodeUses(nodes.size(), 0);
+        std::vector<uint32> primitiveUses(primitiveBounds.size(), 0);
+        for (uint32 nodeIndex = 0; nodeIndex < (uint32)nodes.size(); ++nodeIndex)
+        {
+            const auto& node = nodes[nodeIndex];
+            for (uint32 slot = 0; slot < Width; ++slot)
+            {
+                if (node.children[slot] == BVH<Width>::EmptyChild)
+                    continue;
+
+                const AABB slotBounds = GetSlotBounds<Width>(node, slot);
+                if (node.counts[slot] > 0)
+                {
+                    REQUIRE(node.counts[slot] <= maxLeafSize);
+                    for (uint32 i = node.children[slot]; i < node.children[slot] + node.counts[slot]; ++i)
+                    {
+                        primitiveUses[i]++;
+                        REQUIRE(Contains(slotBounds, primitiveBounds[bvh.GetPrimitiveIndices()[i]]));
+                    }
+                }
+                else
+                {
+                    REQUIRE(node.children[slot] > nodeIndex);
+                    REQUIRE(node.children[slot] < nodes.size());
+                    nodeUses[node.children[slot]]++;
+                    const auto& child = nodes[node.children[slot]];
+                    for (uint32 childSlot = 0; childSlot < Width; ++childSlot)
+                    {
+                        if (child.children[childSlot] != BVH<Width>::EmptyChild)
+                            REQUIRE(Contains(slotBounds, GetSlotBounds<Width>(child, childSlot)));
+                    }
+                }
+            }
+        }
+        CHECK(std::count(nodeUses.begin() + 1, nodeUses.end(), 1) == (int64)nodes.size() - 1);
+        CHECK(std::count(primitiveUses.begin(), primitiveUses.end(), 1) == (int64)primitiveUses.size());
+        CHECK(bvh.GetDepth() <= 64);
+    }
+
+    // The closest hit of every triangle, the way MeshBVH tests them.
+    template<uint32 Width>
+    float IntersectBruteForce(const Mesh& mesh, const Ray& ray, float tMax, uint32* pTriangle = nullptr)
+    {
+        float closest = FLT_MAX;
+        for (uint32 t = 0; t < (uint32)mesh.indices.size() / 3; ++t)
+        {
+            float hitT, u, v;
+            if (MeshBVH<Width>::IntersectRay(mesh.vertices[mesh.indices[t * 3]].position.values, mesh.vertices[mesh.indices[t * 3 + 1]].position.values,
+                mesh.vertices[mesh.indices[t * 3 + 2]].position.values, ray, std::min(tMax, closest), hitT, u, v))
+            {
+                closest = hitT;
+                if (pTriangle)
+                    *pTriangle = t;
+            }
+        }
+        return closest;
+    }
+
+    template<uint32 Width>
+    void CheckMeshQueries(const MeshBVH<Width>& bvh, const Mesh& mesh, uint32 seed)
+    {
+        std::mt19937 random(seed);
+        const AABB bounds = GetMeshBounds(mesh);
+        const float size = std::max({ bounds.max[0] - bounds.min[0], bounds.max[1] - bounds.min[1], bounds.max[2] - bounds.min[2] });
+
+        uint32 hitCount = 0;
+        for (uint32 i = 0; i < 500; ++i)
+        {
+            Ray ray = CreateRandomRay(random, bounds);
+            const float expected = IntersectBruteForce<Width>(mesh, ray, ray.tMax);
+            RayHit hit;
+            REQUIRE(bvh.Intersect(ray, hit) == (expected < FLT_MAX));
+            if (!hit.IsHit())
+            {
+                CHECK_FALSE(bvh.IsOccluded(ray));
+                continue;
+            }
+
+            // Several triangles can share the closest t on an edge, the one returned has to be at it.
+            hitCount++;
+            REQUIRE(hit.t == expected);
+            const uint32* pIndices = &mesh.indices[hit.primitive * 3];
+            float t, u, v;
+            REQUIRE(MeshBVH<Width>::IntersectRay(mesh.vertices[pIndices[0]].position.values, mesh.vertices[pIndices[1]].position.values,
+                mesh.vertices[pIndices[2]].position.values, ray, FLT_MAX, t, u, v));
+            CHECK(t == hit.t);
+            CHECK(u == hit.u);
+            CHECK(v == hit.v);
+
+            CHECK(bvh.IsOccluded(ray));
+            ray.tMax = expected * 0.999f;
+            CHECK_FALSE(bvh.IsOccluded(ray));
+            ray.tMax = FLT_MAX;
+            ray.tMin = expected * 1.001f;
+            CHECK(bvh.IsOccluded(ray) == (IntersectBruteForce<Width>(mesh, ray, FLT_MAX) < FLT_MAX));
+        }
+        CHECK(hitCount > 50);
+
+        for (uint32 i = 0; i < 200; ++i)
+        {
+            const AABB box = CreateRandomBox(random, bounds, size * 0.2f);
+            float center[3];
+            for (uint32 axis = 0; axis < 3; ++axis)
+                center[axis] = RandomFloat(random, bounds.min[axis], bounds.max[axis]);
+            const float radius = RandomFloat(random, 0.f, size * 0.2f);
+
+            std::vector<uint32> expectedBox, expectedSphere;
+            for (uint32 t = 0; t < (uint32)mesh.indices.size() / 3; ++t)
+            {
+                const float* p0 = mesh.vertices[mesh.indices[t * 3]].position.values;
+                const float* p1 = mesh.vertices[mesh.indices[t * 3 + 1]].position.values;
+                const float* p2 = mesh.vertices[mesh.indices[t * 3 + 2]].position.values;
+                if (MeshBVH<Width>::IntersectsAABB(p0, p1, p2, box))
+                    expectedBox.push_back(t);
+                if (MeshBVH<Width>::IntersectsSphere(p0, p1, p2, center, radius))
+                    expectedSphere.push_back(t);
+            }
+
+            std::vector<uint32> result;
+            bvh.QueryAABB(box, result);
+            std::sort(result.begin(), result.end());
+            REQUIRE(result == expectedBox);
+
+            result.clear();
+            bvh.QuerySphere(center, radius, result);
+            std::sort(result.begin(), result.end());
+            REQUIRE(result == expectedSphere);
+        }
+    }
+}
+
+TEMPLATE_TEST_CASE("BVH building", "[BVH]", BVH4, BVH8)
+{
+    constexpr uint32 Width = TestType::value;
+
+    std::mt19937 random(42);
+    AABB space;
+    for (uint32 i = 0; i < 3; ++i)
+    {
+        space.min[i] = -100.f;
+        space.max[i] = 100.f;
+    }
+    std::vector<AABB> boxes(20000);
+    for (AABB& box : boxes)
+        box = CreateRandomBox(random, space, 5.f);
+
+    BVHBuildSettings settings;
+    BVH<Width> bvh;
+    bvh.Build(boxes, settings);
+    CheckTree(bvh, boxes, settings.maxLeafSize);
+    CHECK(Contains(bvh.GetBounds(), boxes[0]));
+
+    SECTION("The tree does not depend on the threads")
+    {
+        BVHBuildSettings serialSettings = settings;
+        serialSettings.maxThreads = 1;
+        BVH<Width> serial;
+        serial.Build(boxes, serialSettings);
+        REQUIRE(serial.GetNodes().size() == bvh.GetNodes().size());
+        CHECK(std::memcmp(serial.GetNodes().data(), bvh.GetNodes().data(), bvh.GetNodes().size_bytes()) == 0);
+        CHECK(std::equal(serial.GetPrimitiveIndices().begin(), serial.GetPrimitiveIndices().end(), bvh.GetPrimitiveIndices().begin()));
+    }
+
+    SECTION("Refit")
+    {
+        for (AABB& box : boxes)
+        {
+            const float offset = RandomFloat(random, -10.f, 10.f);
+            for (uint32 i = 0; i < 3; ++i)
+            {
+                box.min[i] += offset;
+                box.max[i] += offset;
+            }
+        }
+        bvh.Refit(boxes);
+        CheckTree(bvh, boxes, settings.maxLeafSize);
+        CHECK_THROWS(bvh.Refit(std::span<const AABB>(boxes).first(10)));
+    }
+
+    SECTION("Degenerate input")
+    {
+        // Every centroid at the same spot still gives leaves within the limit.
+        const std::vector<AABB> same(1000, boxes[0]);
+        bvh.Build(same, settings);
+        CheckTree(bvh, same, settings.maxLeafSize);
+
+        bvh.Build(std::span<const AABB>(boxes).first(1), settings);
+        CheckTree(bvh, std::span<const AABB>(boxes).first(1), settings.maxLeafSize);
+
+        bvh.Build({}, settings);
+        CHECK(bvh.GetNodes().empty());
+        float tMax = FLT_MAX;
+        bvh.Traverse(Ray(), tMax, [](uint32, uint32) { FAIL("An empty BVH has no leaves"); return true; });
+    }
+}
+
+TEST_CASE("Triangle overlap tests", "[BVH]")
+{
+    const float p0[3] = { 0.f, 0.f, 0.f };
+    const float p1[3] = { 10.f, 0.f, 0.f };
+    const float p2[3] = { 0.f, 10.f, 0.f };
+    auto makeBox = [](float x0, float y0, float z0, float x1, float y1, float z1)
+    {
+        AABB box;
+        box.min[0] = x0; box.min[1] = y0; box.min[2] = z0;
+        box.max[0] = x1; box.max[1] = y1; box.max[2] = z1;
+        return box;
+    };
+
+    CHECK(MeshBVH<4>::IntersectsAABB(p0, p1, p2, makeBox(1.f, 1.f, -1.f, 2.f, 2.f, 1.f)));
+    CHECK(MeshBVH<4>::IntersectsAABB(p0, p1, p2, makeBox(-1.f, -1.f, -1.f, 11.f, 11.f, 1.f)));
+    // Inside the bounds of the triangle, but past the long edge or above the plane.
+    CHECK_FALSE(MeshBVH<4>::IntersectsAABB(p0, p1, p2, makeBox(8.f, 8.f, -1.f, 9.f, 9.f, 1.f)));
+    CHECK_FALSE(MeshBVH<4>::IntersectsAABB(p0, p1, p2, makeBox(1.f, 1.f, 0.5f, 2.f, 2.f, 1.f)));
+
+    const float center[3] = { 6.f, 6.f, 0.f };
+    CHECK_FALSE(MeshBVH<4>::IntersectsSphere(p0, p1, p2, center, 1.f));
+    CHECK(MeshBVH<4>::IntersectsSphere(p0, p1, p2, center, 1.5f));
+    const float above[3] = { 1.f, 1.f, 2.f };
+    CHECK_FALSE(MeshBVH<4>::IntersectsSphere(p0, p1, p2, above, 1.9f));
+    CHECK(MeshBVH<4>::IntersectsSphere(p0, p1, p2, above, 2.f));
+
+    Ray ray;
+    ray.origin[0] = 1.f; ray.origin[1] = 2.f; ray.origin[2] = -5.f;
+    float t, u, v;
+    REQUIRE(MeshBVH<4>::IntersectRay(p0, p1, p2, ray, FLT_MAX, t, u, v));
+    CHECK(t == 5.f);
+    CHECK(u == Catch::Approx(0.1f));
+    CHECK(v == Catch::Approx(0.2f));
+    CHECK_FALSE(MeshBVH<4>::IntersectRay(p0, p1, p2, ray, 4.f, t, u, v));
+    ray.origin[0] = 9.f;
+    CHECK_FALSE(MeshBVH<4>::IntersectRay(p0, p1, p2, ray, FLT_MAX, t, u, v));
+}
+
+TEMPLATE_TEST_CASE("Mesh BVH queries", "[BVH]", BVH4, BVH8)
+{
+    constexpr uint32 Width = TestType::value;
+
+    for (const char* pName : { "Suzanne.fbx", "Terrain.fbx", "Boxhouse.fbx" })
+    {
+        DYNAMIC_SECTION(pName)
+        {
+            Mesh mesh = LoadIndexed(pName);
+            MeshBVH<Width> bvh;
+            bvh.Build(mesh.indices, mesh.vertices);
+            REQUIRE(bvh.GetTriangleCount() == mesh.indices.size() / 3);
+            CheckMeshQueries(bvh, mesh, 7);
+
+            // Squash and move the mesh, the refitted tree must give the same answers as a new one.
+            for (Vertex& vertex : mesh.vertices)
+            {
+                vertex.position.x = vertex.position.x * 2.f + 3.f;
+                vertex.position.y = vertex.position.y * 0.5f + std::sin(vertex.position.x);
+            }
+            bvh.Refit(mesh.vertices);
+            CheckMeshQueries(bvh, mesh, 8);
+        }
+    }
+
+    SECTION("Triangle soup")
+    {
+        std::unique_ptr<Mesh> pSoup(FBXLoader::Load("Barrel.fbx", true));
+        REQUIRE(pSoup);
+        MeshBVH<Width> bvh;
+        bvh.Build({}, pSoup->vertices);
+        CHECK(bvh.GetTriangleCount() == pSoup->vertices.size() / 3);
+
+        Mesh mesh;
+        mesh.vertices = pSoup->vertices;
+        for (uint32 i = 0; i < (uint32)mesh.vertices.size(); ++i)
+            mesh.indices.push_back(i);
+        CheckMeshQueries(bvh, mesh, 9);
+    }
+}
+
+TEMPLATE_TEST_CASE("Scene BVH queries", "[BVH]", BVH4, BVH8)
+{
+    constexpr uint32 Width = TestType::value;
+
+    const Mesh suzanne = LoadIndexed("Suzanne.fbx");
+    const Mesh boxhouse = LoadIndexed("Boxhouse.fbx");
+    MeshBVH<Width> suzanneBVH, boxhouseBVH;
+    suzanneBVH.Build(suzanne.indices, suzanne.vertices);
+    boxhouseBVH.Build(boxhouse.indices, boxhouse.vertices);
+
+    // A grid of rotated and scaled instances, plus ones that must be left out.
+    std::mt19937 random(3);
+    std::vector<BVHInstance<Width>> instances;
+    for (uint32 i = 0; i < 64; ++i)
+    {
+        BVHInstance<Width> instance;
+        instance.pMesh = i % 3 == 0 ? &boxhouseBVH : &suzanneBVH;
+        instance.instanceID = 100 + i;
+        const float angle = RandomFloat(random, 0.f, 6.28f);
+        const float scale = RandomFloat(random, 0.5f, 2.f);
+        instance.transform[0][0] = std::cos(angle) * scale;
+        instance.transform[0][2] = std::sin(angle) * scale;
+        instance.transform[1][1] = scale * RandomFloat(random, 0.5f, 1.5f);
+        instance.transform[2][0] = -std::sin(angle) * scale;
+        instance.transform[2][2] = std::cos(angle) * scale;
+        instance.transform[0][3] = (float)(i % 8) * 10.f;
+        instance.transform[1][3] = RandomFloat(random, -1.f, 1.f);
+        instance.transform[2][3] = (float)(i / 8) * 10.f;
+        instances.push_back(instance);
+    }
+    BVHInstance<Width> singular;
+    singular.pMesh = &suzanneBVH;
+    singular.transform[1][1] = 0.f;
+    instances.push_back(singular);
+    instances.push_back(BVHInstance<Width>());
+
+    SceneBVH<Width> scene;
+    scene.Build(instances);
+    REQUIRE(scene.GetInstanceCount() == 64);
+
+    // Every triangle in world space.
+    struct WorldTriangle
+    {
+        float p[3][3];
+        uint32 instanceID;
+    };
+    std::vector<WorldTriangle> triangles;
+    for (uint32 i = 0; i < 64; ++i)
+    {
+        const Mesh& mesh = instances[i].pMesh == &boxhouseBVH ? boxhouse : suzanne;
+        for (uint64 t = 0; t < mesh.indices.size(); t += 3)
+        {
+            WorldTriangle triangle;
+            triangle.instanceID = instances[i].instanceID;
+            for (uint32 corner = 0; corner < 3; ++corner)
+            {
+                const float* p = mesh.vertices[mesh.indices[t + corner]].position.values;
+                for (uint32 row = 0; row < 3; ++row)
+                {
+                    const float (&m)[4] = instances[i].transform[row];
+                    triangle.p[corner][row] = m[0] * p[0] + m[1] * p[1] + m[2] * p[2] + m[3];
+                }
+            }
+            triangles.push_back(triangle);
+        }
+    }
+
+    uint32 hitCount = 0;
+    for (uint32 i = 0; i < 300; ++i)
+    {
+        const Ray ray = CreateRandomRay(random, scene.GetBounds());
+        float expected = FLT_MAX;
+        for (const WorldTriangle& triangle : triangles)
+        {
+            float t, u, v;
+            if (MeshBVH<Width>::IntersectRay(triangle.p[0], triangle.p[1], triangle.p[2], ray, expected, t, u, v))
+                expected = t;
+        }
+
+        RayHit hit;
+        const bool isHit = scene.Intersect(ray, hit);
+        CHECK(scene.IsOccluded(ray) == isHit);
+        // Object space gives slightly different numbers, a ray that grazes an edge can go either way.
+        if (isHit != (expected < FLT_MAX))
+        {
+            WARN("Ray " << i << " grazes an edge");
+            continue;
+        }
+        if (isHit)
+        {
+            hitCount++;
+            CHECK(hit.t == Catch::Approx(expected).epsilon(1e-3));
+            CHECK(hit.instance >= 100);
+        }
+    }
+    CHECK(hitCount > 50);
+
+    // Every instance with a triangle in the query, and nothing far away from it.
+    for (uint32 i = 0; i < 100; ++i)
+    {
+        const AABB box = CreateRandomBox(random, scene.GetBounds(), 8.f);
+        std::vector<uint32> result;
+        scene.QueryAABB(box, result);
+        for (const WorldTriangle& triangle : triangles)
+        {
+            if (MeshBVH<Width>::IntersectsAABB(triangle.p[0], triangle.p[1], triangle.p[2], box))
+                REQUIRE(std::find(result.begin(), result.end(), triangle.instanceID) != result.end());
+        }
+        std::sort(result.begin(), result.end());
+        CHECK(std::adjacent_find(result.begin(), result.end()) == result.end());
+
+        const float center[3] = { box.min[0], box.min[1], box.min[2] };
+        result.clear();
+        scene.QuerySphere(center, 4.f, result);
+        for (const WorldTriangle& triangle : triangles)
+        {
+            if (MeshBVH<Width>::IntersectsSphere(triangle.p[0], triangle.p[1], triangle.p[2], center, 4.f))
+                REQUIRE(std::find(result.begin(), result.end(), triangle.instanceID) != result.end());
+        }
+    }
+
+    AABB outside;
+    for (uint32 axis = 0; axis < 3; ++axis)
+    {
+        outside.min[axis] = scene.GetBounds().max[axis] + 1.f;
+        outside.max[axis] = outside.min[axis] + 1.f;
+    }
+    std::vector<uint32> result;
+    scene.QueryAABB(outside, result);
+    CHECK(result.empty());
+}
+
+namespace
+{
+    template<uint32 Width>
+    void RunBVHBenchmark()
+    {
+        for (const char* pName : { "Terrain.fbx", "Suzanne.fbx", "Boxhouse.fbx", "Sword.fbx" })
+        {
+            const Mesh mesh = LoadIndexed(pName);
+            MeshBVH<Width> bvh;
+            bvh.Build(mesh.indices, mesh.vertices);
+
+            std::mt19937 random(1);
+            std::vector<Ray> rays(100000);
+            for (Ray& ray : rays)
+                ray = CreateRandomRay(random, bvh.GetBounds());
+
+            auto startTime = std::chrono::high_resolution_clock::now();
+            uint32 hitCount = 0;
+            for (const Ray& ray : rays)
+            {
+                RayHit hit;
+                hitCount += bvh.Intersect(ray, hit) ? 1 : 0;
+            }
+            const double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - startTime).count();
+
+            BENCHMARK(Utils::Format("BVH{} {} build, {} triangles, depth {}", Width, pName, mesh.indices.size() / 3, bvh.GetBVH().GetDepth()))
+            {
+                MeshBVH<Width> result;
+                result.Build(mesh.indices, mesh.vertices);
+                return result.GetTriangleCount();
+            };
+
+            BENCHMARK(Utils::Format("BVH{} {} 1000 closest hit rays, {:.1f} Mrays/s, {} hits of {}", Width, pName, rays.size() / seconds / 1e6, hitCount, rays.size()))
+            {
+                uint32 hits = 0;
+                for (uint32 i = 0; i < 1000; ++i)
+                {
+                    RayHit hit;
+                    hits += bvh.Intersect(rays[i], hit) ? 1 : 0;
+                }
+                return hits;
+            };
+        }
+    }
+}
+
+// Hidden by default, run with: UnitTests.exe "[benchmark]"
+TEST_CASE("BVH build and traversal", "[.][benchmark][BVH]")
+{
+    RunBVHBenchmark<4>();
+    RunBVHBenchmark<8>();
+}
@@ -0,0 +1,222 @@
+#define RS_THROW_INSTEAD_OF_ASSERT
+
+#include "RSEngine.h"
+#include "Graphics/Batch2D.h"
+#include "Catch2/catch_amalgamated.hpp"
+
+#include <random>
+
+using namespace RS;
+
+namespace
+{
+    struct Primitive
+    {
+        int16 layer;
+        BlendMode2D blendMode;
+        uint16 texture;
+        uint32 id;
+    };
+
+    // The id goes in the color, so every instance can be traced back to what was drawn.
+    void Record(Batch2D& batch, const Primitive& primitive)
+    {
+        batch.SetLayer(primitive.layer);
+        batch.SetBlendMode(primitive.blendMode);
+        batch.DrawSprite(primitive.texture, 0.f, 0.f, 1.f, 1.f, Color32(primitive.id));
+    }
+
+    std::vector<Primitive> CreateRandomPrimitives(uint32 count, uint32 layerCount, uint32 textureCount, uint32 seed)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_int_distribution<int32> layer(-(int32)layerCount / 2, (int32)layerCount / 2);
+        std::uniform_int_distribution<uint32> texture(0, textureCount - 1);
+        std::uniform_int_distribution<uint32> blendMode(0, (uint32)BlendMode2D::COUNT - 1);
+
+        std::vector<Primitive> primitives(count);
+        for (uint32 i = 0; i < count; ++i)
+            primitives[i] = { (int16)layer(rng), (BlendMode2D)blendMode(rng), (uint16)texture(rng), i };
+        return primitives;
+    }
+
+    // Draws cover the instances in order without gaps, and no two neighbouring draws could have been one.
+    void CheckDraws(const Batch2D& batch, uint32 maxInstancesPerDraw)
+    {
+        uint32 next = 0;
+        const std::vector<Draw2D>& draws = batch.GetDraws();
+        for (uint64 i = 0; i < draws.size(); ++i)
+        {
+            REQUIRE(draws[i].firstInstance == next);
+            REQUIRE(draws[i].instanceCount > 0);
+            REQUIRE(draws[i].instanceCount <= maxInstancesPerDraw);
+            next += draws[i].instanceCount;
+
+            if (i > 0 && draws[i].texture == draws[i - 1].texture && draws[i].blendMode == draws[i - 1].blendMode)
+                REQUIRE(draws[i - 1].instanceCount == maxInstancesPerDraw);
+        }
+        REQUIRE(next == batch.GetInstances().size());
+    }
+}
+
+TEST_CASE("Batch2D shapes", "[Batch2D]")
+{
+    Batch2D batch;
+    batch.DrawRect(10.f, 20.f, 30.f, 40.f, Color::RED);
+    batch.DrawCircle(5.f, 6.f, 7.f, Color::GREEN, 2.f);
+    batch.DrawLine(0.f, 0.f, 0.f, 10.f, 2.f, Color::BLUE);
+    batch.DrawSprite(3, 0.f, 0.f, 8.f, 4.f, Color::WHITE, 0.25f, 0.5f, 0.75f, 1.f, 1.f);
+    REQUIRE(batch.GetPrimitiveCount() == 4);
+    batch.Build();
+
+    // All on layer 0 with alpha blending, so shapes come first as they use no texture.
+    const std::vector<Instance2D>& instances = batch.GetInstances();
+    REQUIRE(instances.size() == 4);
+
+    const Instance2D& rect = instances[0];
+    REQUIRE(rect.shape == Shape2D::Rect);
+    REQUIRE(rect.x == 25.f);
+    REQUIRE(rect.y == 40.f);
+    REQUIRE(rect.halfWidth == 15.f);
+    REQUIRE(rect.halfHeight == 20.f);
+    REQUIRE(rect.color == Color::RED.Data);
+
+    const Instance2D& circle = instances[1];
+    REQUIRE(circle.shape == Shape2D::Circle);
+    REQUIRE(circle.x == 5.f);
+    REQUIRE(circle.halfWidth == 7.f);
+    REQUIRE(circle.halfHeight == 7.f);
+    REQUIRE(circle.thickness == 2.f);
+
+    const Instance2D& line = instances[2];
+    REQUIRE(line.x == 0.f);
+    REQUIRE(line.y == 5.f);
+    REQUIRE(line.halfWidth == 5.f);
+    REQUIRE(line.halfHeight == 1.f);
+    REQUIRE(line.rotation == Catch::Approx(3.14159265f / 2.f));
+
+    const Instance2D& sprite = instances[3];
+    REQUIRE(sprite.x == 4.f);
+    REQUIRE(sprite.u0 == 0.25f);
+    REQUIRE(sprite.v1 == 1.f);
+    REQUIRE(sprite.rotation == 1.f);
+
+    const std::vector<Draw2D>& draws = batch.GetDraws();
+    REQUIRE(draws.size() == 2);
+    REQUIRE(draws[0].texture == Batch2D::NO_TEXTURE);
+    REQUIRE(draws[0].instanceCount == 3);
+    REQUIRE(draws[1].texture == 3);
+
+    // Recording is closed until the next frame.
+    REQUIRE_THROWS(batch.DrawRect(0.f, 0.f, 1.f, 1.f, Color::RED));
+    REQUIRE_THROWS(batch.Build());
+    batch.Clear();
+    REQUIRE(batch.GetPrimitiveCount() == 0);
+    REQUIRE(batch.GetDraws().empty());
+    REQUIRE_THROWS(batch.DrawSprite(Batch2D::MAX_TEXTURES, 0.f, 0.f, 1.f, 1.f));
+}
+
+TEST_CASE("Batch2D sorts by layer and merges draws", "[Batch2D]")
+{
+    Batch2D batch;
+
+    // Two textures alternating on two layers, drawn top layer first.
+    uint32 id = 0;
+    for (int16 layer : { 1, -1 })
+    {
+        for (uint32 i = 0; i < 10; ++i)
+            Record(batch, { layer, BlendMode2D::Alpha, (uint16)(1 + i % 2), id++ });
+    }
+    batch.Build();
+
+    // Per layer one draw per texture, in the order they were drawn within a texture.
+    const std::vector<Draw2D>& draws = batch.GetDraws();
+    REQUIRE(draws.size() == 4);
+    const std::vector<Instance2D>& instances = batch.GetInstances();
+    const std::vector<uint32> expected = { 10, 12, 14, 16, 18, 11, 13, 15, 17, 19, 0, 2, 4, 6, 8, 1, 3, 5, 7, 9 };
+    for (uint32 i = 0; i < expected.size(); ++i)
+        REQUIRE(instances[i].color == expected[i]);
+
+    // Neighbouring layers with the same state end up in one draw.
+    batch.Clear();
+    for (int16 layer = 0; layer < 8; ++layer)
+        Record(batch, { layer, BlendMode2D::Additive, 5, (uint32)layer });
+    batch.Build();
+    REQUIRE(batch.GetDraws().size() == 1);
+    REQUIRE(batch.GetDraws()[0].blendMode == BlendMode2D::Additive);
+    REQUIRE(batch.GetDraws()[0].instanceCount == 8);
+}
+
+TEST_CASE("Batch2D matches a stable sort", "[Batch2D]")
+{
+    const uint32 layerCount = GENERATE(1u, 4u, 600u);
+    const uint32 textureCount = GENERATE(1u, 3u, 4000u);
+    const uint32 maxInstancesPerDraw = GENERATE(7u, UINT32_MAX);
+
+    Batch2DSettings settings;
+    settings.maxInstancesPerDraw = maxInstancesPerDraw;
+    Batch2D batch(settings);
+
+    std::vector<Primitive> primitives = CreateRandomPrimitives(5000, layerCount, textureCount, layerCount * 31 + textureCount);
+    for (const Primitive& primitive : primitives)
+        Record(batch, primitive);
+    batch.Build();
+
+    std::stable_sort(primitives.begin(), primitives.end(), [](const Primitive& a, const Primitive& b)
+        {
+            if (a.layer != b.layer)
+                return a.layer < b.layer;
+            if (a.blendMode != b.blendMode)
+                return a.blendMode < b.blendMode;
+            return a.texture < b.texture;
+        });
+
+    const std::vector<Instance2D>& instances = batch.GetInstances();
+    REQUIRE(instances.size() == primitives.size());
+    for (uint64 i = 0; i < primitives.size(); ++i)
+        REQUIRE(instances[i].color == primitives[i].id);
+
+    CheckDraws(batch, maxInstancesPerDraw);
+    for (const Draw2D& draw : batch.GetDraws())
+    {
+        for (uint32 i = draw.firstInstance; i < draw.firstInstance + draw.instanceCount; ++i)
+        {
+            REQUIRE(primitives[i].texture == draw.texture);
+            REQUIRE(primitives[i].blendMode == draw.blendMode);
+        }
+    }
+}
+
+// Hidden by default, run with: UnitTests.exe "[benchmark]"
+TEST_CASE("Batch2D speed", "[.][benchmark][Batch2D]")
+{
+    const uint32 count = 1'000'000;
+    Batch2DSettings settings;
+    settings.maxInstancesPerDraw = (uint32)(_2MB / sizeof(Instance2D));
+    Batch2D batch(settings);
+
+    struct Scenario
+    {
+        const char* pName;
+        uint32 layerCount;
+        uint32 textureCount;
+    };
+    for (const Scenario& scenario : { Scenario{ "one layer and texture", 1, 1 }, Scenario{ "8 layers and 16 textures", 8, 16 }, Scenario{ "256 layers and 1000 textures", 256, 1000 } })
+    {
+        const std::vector<Primitive> primitives = CreateRandomPrimitives(count, scenario.layerCount, scenario.textureCount, 1);
+        for (const Primitive& primitive : primitives)
+            Record(batch, primitive);
+        batch.Build();
+        const uint64 drawCount = batch.GetDraws().size();
+        batch.Clear();
+
+        BENCHMARK(Utils::Format("Record and build {} primitives, {}, {} draws", count, scenario.pName, drawCount))
+        {
+            batch.Clear();
+            for (const Primitive& primitive : primitives)
+                Record(batch, primitive);
+            batch.Build();
+            return batch.GetDraws().size();
+        };
+        batch.Clear();
+    }
+}
@@ -0,0 +1,320 @@
+#define RS_THROW_INSTEAD_OF_ASSERT
+
+#include "RSEngine.h"
+#include "Maths/Batch/BatchMath.h"
+#include "Catch2/catch_amalgamated.hpp"
+
+#include <array>
+#include <random>
+
+using namespace RS;
+
+namespace
+{
+    // Runs func with every lane width the CPU supports, the scalar kernels first.
+    template<typename Func>
+    void ForEachLaneWidth(Func&& func)
+    {
+        for (uint32 width : { 1u, 4u, 8u, 16u })
+        {
+            if (!Batch::SetLaneWidth(width))
+                continue;
+            func(width);
+        }
+        Batch::SetLaneWidth(0);
+    }
+
+    std::vector<float> CreateRandomFloats(std::mt19937& rng, uint64 count, float min, float max)
+    {
+        std::uniform_real_distribution<float> value(min, max);
+        std::vector<float> values(count);
+        for (float& v : values)
+            v = value(rng);
+        return values;
+    }
+
+    // The box from -1 to 1 on every axis.
+    std::array<Batch::Plane, 6> CreateUnitBoxPlanes()
+    {
+        std::array<Batch::Plane, 6> planes;
+        for (uint32 axis = 0; axis < 3; ++axis)
+        {
+            planes[axis * 2] = { { 0.f, 0.f, 0.f }, 1.f };
+            planes[axis * 2].normal[axis] = 1.f;
+            planes[axis * 2 + 1] = { { 0.f, 0.f, 0.f }, 1.f };
+            planes[axis * 2 + 1].normal[axis] = -1.f;
+        }
+        return planes;
+    }
+
+    struct Objects
+    {
+        std::vector<float> x, y, z, radius, extentX, extentY, extentZ;
+
+        Objects(std::mt19937& rng, uint64 count)
+            : x(CreateRandomFloats(rng, count, -2.f, 2.f)), y(CreateRandomFloats(rng, count, -2.f, 2.f)), z(CreateRandomFloats(rng, count, -2.f, 2.f)),
+            radius(CreateRandomFloats(rng, count, 0.f, 0.5f)), extentX(CreateRandomFloats(rng, count, 0.f, 0.5f)),
+            extentY(CreateRandomFloats(rng, count, 0.f, 0.5f)), extentZ(CreateRandomFloats(rng, count, 0.f, 0.5f))
+        {
+        }
+
+        Batch::BoundsSoA GetBounds() const
+        {
+            return { x.data(), y.data(), z.data(), radius.data(), extentX.data(), extentY.data(), extentZ.data() };
+        }
+    };
+
+    // Position, rotation and scale components in the order of TransformsSoA.
+    Batch::TransformsSoA GetTransforms(const std::vector<std::vector<float>>& c)
+    {
+        return { c[0].data(), c[1].data(), c[2].data(), c[3].data(), c[4].data(), c[5].data(), c[6].data(), c[7].data(), c[8].data(), c[9].data() };
+    }
+}
+
+TEST_CASE("Batch compose transforms", "[BatchMath]")
+{
+    // A translation and scale like the entities of a 2D game, and a quarter turn around z which takes x to y.
+    const float sin45 = std::sqrt(0.5f);
+    const float position[3][2] = { { 1.f, -4.f }, { 2.f, 5.f }, { 3.f, 6.f } };
+    const float rotation[4][2] = { { 0.f, 0.f }, { 0.f, 0.f }, { 0.f, sin45 }, { 1.f, sin45 } };
+    const float scale[3][2] = { { 2.f, 1.f }, { 3.f, 2.f }, { 1.f, 1.f } };
+    const Batch::TransformsSoA known = { position[0], position[1], position[2], rotation[0], rotation[1], rotation[2], rotation[3], scale[0], scale[1], scale[2] };
+
+    std::mt19937 rng(5);
+    const uint64 count = 37;
+    std::vector<std::vector<float>> components;
+    for (uint32 i = 0; i < 10; ++i)
+        components.push_back(CreateRandomFloats(rng, count, -3.f, 3.f));
+    for (uint64 i = 0; i < count; ++i)
+    {
+        float length = 0.f;
+        for (uint32 c = 3; c < 7; ++c)
+            length += components[c][i] * components[c][i];
+        for (uint32 c = 3; c < 7; ++c)
+            components[c][i] /= std::sqrt(length);
+    }
+    const Batch::TransformsSoA random = GetTransforms(components);
+
+    std::vector<float> expected;
+    ForEachLaneWidth([&](uint32 width)
+        {
+            float matrices[2][16];
+            Batch::ComposeTransforms(known, 2, matrices);
+            const float translateScale[16] = { 2.f, 0.f, 0.f, 1.f, 0.f, 3.f, 0.f, 2.f, 0.f, 0.f, 1.f, 3.f, 0.f, 0.f, 0.f, 1.f };
+            const float turn[16] = { 0.f, -2.f, 0.f, -4.f, 1.f, 0.f, 0.f, 5.f, 0.f, 0.f, 1.f, 6.f, 0.f, 0.f, 0.f, 1.f };
+            for (uint32 i = 0; i < 16; ++i)
+            {
+                REQUIRE(matrices[0][i] == translateScale[i]);
+                REQUIRE(matrices[1][i] == Catch::Approx(turn[i]).margin(1e-6));
+            }
+
+            // Into a struct like InstanceData, with other members between the matrices.
+            struct Instance
+            {
+                float transform[16];
+                uint32 type;
+            };
+            std::vector<Instance> instances(count, Instance{ {}, 7u });
+            Batch::ComposeTransforms(random, count, &instances[0].transform, sizeof(Instance));
+            std::vector<float> result;
+            for (const Instance& instance : instances)
+            {
+                REQUIRE(instance.type == 7u);
+                result.insert(result.end(), instance.transform, instance.transform + 16);
+            }
+
+            if (width == 1)
+                expected = result;
+            for (uint64 i = 0; i < result.size(); ++i)
+                REQUIRE(result[i] == Catch::Approx(expected[i]).margin(1e-5));
+        });
+
+    REQUIRE_THROWS(Batch::ComposeTransforms(known, 2, nullptr, 32));
+}
+
+TEST_CASE("Batch culling", "[BatchMath]")
+{
+    std::mt19937 rng(9);
+    const uint64 count = 1001;
+    const Objects objects(rng, count);
+    const Batch::BoundsSoA bounds = objects.GetBounds();
+    const std::array<Batch::Plane, 6> planes = CreateUnitBoxPlanes();
+
+    // Against the unit box the tests are per axis.
+    std::vector<uint32> expectedPoints, expectedSpheres, expectedBoxes;
+    for (uint32 i = 0; i < count; ++i)
+    {
+        const float center[3] = { objects.x[i], objects.y[i], objects.z[i] };
+        const float extents[3] = { objects.extentX[i], objects.extentY[i], objects.extentZ[i] };
+        bool isPointInside = true, isSphereInside = true, isBoxInside = true;
+        for (uint32 axis = 0; axis < 3; ++axis)
+        {
+            const float distance = 1.f - std::abs(center[axis]);
+            isPointInside &= distance >= 0.f;
+            isSphereInside &= distance + objects.radius[i] >= 0.f;
+            isBoxInside &= distance + extents[axis] >= 0.f;
+        }
+        if (isPointInside)
+            expectedPoints.push_back(i);
+        if (isSphereInside)
+            expectedSpheres.push_back(i);
+        if (isBoxInside)
+            expectedBoxes.push_back(i);
+    }
+    REQUIRE(expectedPoints.size() < expectedSpheres.size());
+
+    ForEachLaneWidth([&](uint32 width)
+        {
+            std::vector<uint32> visible(count);
+            visible.resize(Batch::CullPoints(planes, bounds, count, visible.data()));
+            REQUIRE(visible == expectedPoints);
+
+            visible.resize(count);
+            visible.resize(Batch::CullSpheres(planes, bounds, count, visible.data()));
+            REQUIRE(visible == expectedSpheres);
+
+            visible.resize(count);
+            visible.resize(Batch::CullAABBs(planes, bounds, count, visible.data()));
+            REQUIRE(visible == expectedBoxes);
+
+            // Fewer objects than lanes.
+            visible.resize(count);
+            REQUIRE(Batch::CullSpheres(planes, bounds, 3, visible.data()) == (uint64)std::count_if(expectedSpheres.begin(), expectedSpheres.end(), [](uint32 i) { return i < 3; }));
+        });
+
+    // The plane through a point, facing the way the normal points.
+    const float point[3] = { 0.f, 2.f, 0.f };
+    const float normal[3] = { 0.f, -1.f, 0.f };
+    const Batch::Plane plane = Batch::Plane::FromPointNormal(point, normal);
+    REQUIRE(plane.distance == 2.f);
+
+    uint32 visible = 0;
+    REQUIRE_THROWS(Batch::CullPoints({}, bounds, count, &visible));
+    REQUIRE_THROWS(Batch::CullSpheres(planes, Batch::BoundsSoA{ objects.x.data(), objects.y.data(), objects.z.data() }, count, &visible));
+}
+
+TEST_CASE("Batch integrate", "[BatchMath]")
+{
+    const uint64 count = 203;
+    const float dt = 1.f / 60.f;
+    std::mt19937 rng(2);
+    const std::vector<float> startPositions = CreateRandomFloats(rng, count * 3, -100.f, 100.f);
+    std::vector<float> startVelocities = CreateRandomFloats(rng, count * 3, -10.f, 10.f);
+    std::vector<float> friction = CreateRandomFloats(rng, count, 0.f, 2.f);
+    for (uint64 i = 0; i < count; i += 5)
+    {
+        friction[i] = 0.f;
+        for (uint32 axis = 0; axis < 3; ++axis)
+            startVelocities[axis * count + i + 1] = 0.01f;
+    }
+
+    for (bool is3D : { false, true })
+    {
+        const uint32 dimensions = is3D ? 3 : 2;
+        const Batch::IntegrateSettings settings;
+
+        // Ten steps of what Game1App::UpdateEntities does per entity.
+        std::vector<float> expectedPositions = startPositions;
+        std::vector<float> expectedVelocities = startVelocities;
+        for (uint32 step = 0; step < 10; ++step)
+        {
+            for (uint64 i = 0; i < count; ++i)
+            {
+                float speedSquared = 0.f;
+                for (uint32 axis = 0; axis < dimensions; ++axis)
+                {
+                    expectedPositions[axis * count + i] += expectedVelocities[axis * count + i] * dt;
+                    speedSquared += expectedVelocities[axis * count + i] * expectedVelocities[axis * count + i];
+                }
+                if (friction[i] > FLT_EPSILON)
+                {
+                    for (uint32 axis = 0; axis < dimensions; ++axis)
+                    {
+                        float& velocity = expectedVelocities[axis * count + i];
+                        velocity = speedSquared > settings.stopSpeedSquared ? velocity - velocity * friction[i] * dt : 0.f;
+                    }
+                }
+            }
+        }
+
+        ForEachLaneWidth([&](uint32 width)
+            {
+                std::vector<float> positions = startPositions;
+                std::vector<float> velocities = startVelocities;
+                Batch::BodiesSoA bodies = { positions.data(), positions.data() + count, nullptr, velocities.data(), velocities.data() + count, nullptr, friction.data() };
+                if (is3D)
+                {
+                    bodies.pPositionZ = positions.data() + count * 2;
+                    bodies.pVelocityZ = velocities.data() + count * 2;
+                }
+                for (uint32 step = 0; step < 10; ++step)
+                    Batch::Integrate(bodies, count, dt, settings);
+
+                for (uint64 i = 0; i < count * dimensions; ++i)
+                {
+                    REQUIRE(positions[i] == Catch::Approx(expectedPositions[i]).margin(1e-4));
+                    REQUIRE(velocities[i] == Catch::Approx(expectedVelocities[i]).margin(1e-5));
+                }
+
+                // Stopped by friction.
+                REQUIRE(velocities[1] == 0.f);
+                REQUIRE(velocities[count + 1] == 0.f);
+            });
+    }
+}
+
+TEST_CASE("Batch lane widths", "[BatchMath]")
+{
+    const uint32 widest = Batch::GetLaneWidth();
+    REQUIRE((widest == 4 || widest == 8 || widest == 16));
+    REQUIRE(Batch::SetLaneWidth(1));
+    REQUIRE(Batch::GetLaneWidth() == 1);
+    REQUIRE_FALSE(Batch::SetLaneWidth(3));
+    REQUIRE(Batch::GetLaneWidth() == 1);
+    REQUIRE(Batch::SetLaneWidth(0));
+    REQUIRE(Batch::GetLaneWidth() == widest);
+}
+
+// Hidden by default, run with: UnitTests.exe "[benchmark]"
+TEST_CASE("Batch math speed", "[.][benchmark][BatchMath]")
+{
+    const uint64 count = 1'000'000;
+    std::mt19937 rng(1);
+    std::vector<std::vector<float>> components;
+    for (uint32 i = 0; i < 10; ++i)
+        components.push_back(CreateRandomFloats(rng, count, -1.f, 1.f));
+    const Batch::TransformsSoA transforms = GetTransforms(components);
+    std::vector<float> matrices(count * 16);
+
+    const Objects objects(rng, count);
+    const Batch::BoundsSoA bounds = objects.GetBounds();
+    const std::array<Batch::Plane, 6> planes = CreateUnitBoxPlanes();
+    std::vector<uint32> visible(count);
+
+    std::vector<float> positions = CreateRandomFloats(rng, count * 2, -100.f, 100.f);
+    std::vector<float> velocities = CreateRandomFloats(rng, count * 2, -10.f, 10.f);
+    const std::vector<float> friction = CreateRandomFloats(rng, count, 0.f, 2.f);
+    const Batch::BodiesSoA bodies = { positions.data(), positions.data() + count, nullptr, velocities.data(), velocities.data() + count, nullptr, friction.data() };
+
+    ForEachLaneWidth([&](uint32 width)
+        {
+            BENCHMARK(Utils::Format("Compose {} transforms, {} lanes", count, width))
+            {
+                Batch::ComposeTransforms(transforms, count, matrices.data());
+                return matrices.back();
+            };
+            BENCHMARK(Utils::Format("Cull {} spheres against a frustum, {} lanes", count, width))
+            {
+                return Batch::CullSpheres(planes, bounds, count, visible.data());
+            };
+            BENCHMARK(Utils::Format("Cull {} boxes against a frustum, {} lanes", count, width))
+            {
+                return Batch::CullAABBs(planes, bounds, count, visible.data());
+            };
+            BENCHMARK(Utils::Format("Integrate {} 2D bodies, {} lanes", count, width))
+            {
+                Batch::Integrate(bodies, count, 1.f / 60.f);
+                return positions.back();
+            };
+        });
+}
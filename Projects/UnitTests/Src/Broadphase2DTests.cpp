@@ -0,0 +1,280 @@
+#define RS_THROW_INSTEAD_OF_ASSERT
+
+#include "RSEngine.h"
+#include "Maths/Broadphase/SpatialHashGrid2D.h"
+#include "Maths/Broadphase/LooseQuadtree2D.h"
+#include "Core/ThreadPool.h"
+#include "Catch2/catch_amalgamated.hpp"
+
+#include <random>
+
+using namespace RS;
+
+namespace
+{
+    using SpatialHashGrid = std::integral_constant<uint32, 0>;
+    using LooseQuadtree = std::integral_constant<uint32, 1>;
+
+    const float WorldHalfSize = 100.f;
+
+    template<typename Type>
+    std::unique_ptr<Broadphase2D> CreateBroadphase(float cellSize)
+    {
+        if constexpr (Type::value == SpatialHashGrid::value)
+            return std::make_unique<SpatialHashGrid2D>(cellSize, 1u << 12);
+        else
+            return std::make_unique<LooseQuadtree2D>(AABB2D{ { -WorldHalfSize, -WorldHalfSize }, { WorldHalfSize, WorldHalfSize } }, 7);
+    }
+
+    // Mostly small boxes, some large ones, and a few outside of the world.
+    AABB2D CreateRandomBox(std::mt19937& rng)
+    {
+        std::uniform_real_distribution<float> position(-WorldHalfSize * 1.2f, WorldHalfSize * 1.2f);
+        std::uniform_real_distribution<float> size(0.1f, 2.f);
+        const float scale = std::uniform_int_distribution<uint32>(0, 20)(rng) == 0 ? 20.f : 1.f;
+        return AABB2D::FromCenterSize(position(rng), position(rng), size(rng) * scale, size(rng) * scale);
+    }
+
+    std::vector<uint32> BruteForceQuery(const std::vector<AABB2D>& boxes, const std::vector<bool>& alive, const AABB2D& box)
+    {
+        std::vector<uint32> result;
+        for (uint32 i = 0; i < (uint32)boxes.size(); ++i)
+        {
+            if (alive[i] && boxes[i].Overlaps(box))
+                result.push_back(i);
+        }
+        return result;
+    }
+
+    std::vector<uint32> Sorted(std::vector<uint32> proxies)
+    {
+        std::sort(proxies.begin(), proxies.end());
+        return proxies;
+    }
+
+    void CheckQueries(const Broadphase2D& broadphase, const std::vector<AABB2D>& boxes, const std::vector<bool>& alive, std::mt19937& rng)
+    {
+        for (uint32 i = 0; i < 50; ++i)
+        {
+            const AABB2D box = CreateRandomBox(rng);
+            std::vector<uint32> proxies;
+            broadphase.Query(box, proxies);
+            REQUIRE(Sorted(proxies) == BruteForceQuery(boxes, alive, box));
+        }
+    }
+
+    std::vector<OverlapPair> BruteForcePairs(const std::vector<AABB2D>& boxes)
+    {
+        std::vector<OverlapPair> pairs;
+        for (uint32 a = 0; a < (uint32)boxes.size(); ++a)
+        {
+            for (uint32 b = a + 1; b < (uint32)boxes.size(); ++b)
+            {
+                if (boxes[a].Overlaps(boxes[b]))
+                    pairs.push_back({ a, b });
+            }
+        }
+        return pairs;
+    }
+}
+
+TEMPLATE_TEST_CASE("Broadphase2D matches brute force", "[Broadphase2D]", SpatialHashGrid, LooseQuadtree)
+{
+    std::mt19937 rng(13);
+    std::vector<AABB2D> boxes(2000);
+    for (AABB2D& box : boxes)
+        box = CreateRandomBox(rng);
+    std::vector<bool> alive(boxes.size(), true);
+
+    std::unique_ptr<Broadphase2D> pBroadphase = CreateBroadphase<TestType>(4.f);
+
+    SECTION("Build")
+    {
+        pBroadphase->Build(boxes);
+        REQUIRE(pBroadphase->GetProxyCount() == boxes.size());
+        CheckQueries(*pBroadphase, boxes, alive, rng);
+
+        // A query that covers everything.
+        std::vector<uint32> proxies;
+        pBroadphase->Query({ { -FLT_MAX, -FLT_MAX }, { FLT_MAX, FLT_MAX } }, proxies);
+        REQUIRE(Sorted(proxies).size() == boxes.size());
+
+        std::vector<OverlapPair> pairs;
+        pBroadphase->FindOverlappingPairs(pairs);
+        const std::vector<OverlapPair> expected = BruteForcePairs(boxes);
+        REQUIRE(pairs.size() == expected.size());
+        for (uint64 i = 0; i < pairs.size(); ++i)
+        {
+            REQUIRE(pairs[i].a == expected[i].a);
+            REQUIRE(pairs[i].b == expected[i].b);
+        }
+    }
+
+    SECTION("Same result for any thread count")
+    {
+        pBroadphase->Build(boxes, 1);
+        std::vector<OverlapPair> singleThreaded;
+        pBroadphase->FindOverlappingPairs(singleThreaded, 1);
+
+        pBroadphase->Build(boxes);
+        std::vector<OverlapPair> multiThreaded;
+        pBroadphase->FindOverlappingPairs(multiThreaded);
+        REQUIRE(singleThreaded.size() == multiThreaded.size());
+        REQUIRE(std::memcmp(singleThreaded.data(), multiThreaded.data(), singleThreaded.size() * sizeof(OverlapPair)) == 0);
+    }
+
+    SECTION("Insert, update and remove")
+    {
+        for (const AABB2D& box : boxes)
+            pBroadphase->Insert(box);
+
+        // Move every box a bit, some of them into other buckets.
+        std::uniform_real_distribution<float> offset(-3.f, 3.f);
+        for (uint32 frame = 0; frame < 5; ++frame)
+        {
+            for (uint32 proxy = 0; proxy < (uint32)boxes.size(); ++proxy)
+            {
+                if (!alive[proxy])
+                    continue;
+
+                const float dx = offset(rng);
+                const float dy = offset(rng);
+                AABB2D& box = boxes[proxy];
+                box = { { box.min[0] + dx, box.min[1] + dy }, { box.max[0] + dx, box.max[1] + dy } };
+                pBroadphase->Update(proxy, box);
+            }
+            pBroadphase->CommitUpdates();
+
+            for (uint32 i = 0; i < 100; ++i)
+            {
+                const uint32 proxy = std::uniform_int_distribution<uint32>(0, (uint32)boxes.size() - 1)(rng);
+                if (alive[proxy])
+                {
+                    pBroadphase->Remove(proxy);
+                    alive[proxy] = false;
+                }
+            }
+            CheckQueries(*pBroadphase, boxes, alive, rng);
+        }
+        REQUIRE(pBroadphase->GetProxyCount() == (uint32)std::count(alive.begin(), alive.end(), true));
+
+        // Removed proxies are reused.
+        const uint32 proxy = pBroadphase->Insert(boxes[0]);
+        REQUIRE_FALSE(alive[proxy]);
+        REQUIRE_THROWS(pBroadphase->Remove((uint32)boxes.size()));
+    }
+
+    SECTION("Radius and batch queries")
+    {
+        pBroadphase->Build(boxes);
+
+        const float center[2] = { 10.f, -20.f };
+        const float radius = 15.f;
+        std::vector<uint32> proxies;
+        pBroadphase->QueryRadius(center, radius, proxies);
+        std::vector<uint32> expected;
+        for (uint32 i = 0; i < (uint32)boxes.size(); ++i)
+        {
+            if (boxes[i].Overlaps(center, radius))
+                expected.push_back(i);
+        }
+        REQUIRE_FALSE(expected.empty());
+        REQUIRE(Sorted(proxies) == expected);
+
+        std::vector<AABB2D> queries(300);
+        for (AABB2D& query : queries)
+            query = CreateRandomBox(rng);
+        std::vector<std::vector<uint32>> results;
+        pBroadphase->QueryBatch(queries, results);
+        REQUIRE(results.size() == queries.size());
+        for (uint64 i = 0; i < queries.size(); ++i)
+            REQUIRE(Sorted(results[i]) == BruteForceQuery(boxes, alive, queries[i]));
+    }
+}
+
+// Hidden by default, run with: UnitTests.exe "[benchmark]"
+TEST_CASE("Broadphase2D speed", "[.][benchmark][Broadphase2D]")
+{
+    for (uint32 count : { 10'000u, 100'000u, 1'000'000u })
+    {
+        // The same density for every count, about ten neighbours per box.
+        const float halfSize = std::sqrt((float)count) * 0.5f;
+        std::mt19937 rng(21);
+        std::uniform_real_distribution<float> position(-halfSize, halfSize);
+        std::uniform_real_distribution<float> direction(-1.f, 1.f);
+        std::vector<AABB2D> boxes(count);
+        std::vector<float> velocities(count * 2);
+        for (uint32 i = 0; i < count; ++i)
+        {
+            boxes[i] = AABB2D::FromCenterSize(position(rng), position(rng), 1.f, 1.f);
+            velocities[i * 2 + 0] = direction(rng);
+            velocities[i * 2 + 1] = direction(rng);
+        }
+
+        // One step of 1/60 of a second for every box, updated in parallel like an entity system would. The boxes bounce
+        // off the edges, so the density stays the same however long the benchmark runs.
+        auto Move = [&](Broadphase2D& broadphase)
+        {
+            ThreadPool::Get()->ParallelFor((count + 4095) / 4096, [&](uint64 block)
+                {
+                    const uint32 last = std::min((uint32)(block + 1) * 4096, count);
+                    for (uint32 i = (uint32)block * 4096; i < last; ++i)
+                    {
+                        AABB2D& box = boxes[i];
+                        for (uint32 axis = 0; axis < 2; ++axis)
+                        {
+                            float& velocity = velocities[i * 2 + axis];
+                            if ((box.min[axis] < -halfSize && velocity < 0.f) || (box.max[axis] > halfSize && velocity > 0.f))
+                                velocity = -velocity;
+                            box.min[axis] += velocity / 60.f;
+                            box.max[axis] += velocity / 60.f;
+                        }
+                        broadphase.Update(i, box);
+                    }
+                });
+            broadphase.CommitUpdates();
+        };
+
+        SpatialHashGrid2D grid(2.f, 1u << 18);
+        LooseQuadtree2D quadtree({ { -halfSize, -halfSize }, { halfSize, halfSize } }, 10);
+        std::vector<OverlapPair> pairs;
+
+        BENCHMARK(Utils::Format("Grid build {} boxes", count))
+        {
+            grid.Build(boxes);
+            return grid.GetProxyCount();
+        };
+        BENCHMARK(Utils::Format("Grid move {} boxes", count))
+        {
+            Move(grid);
+        };
+        BENCHMARK(Utils::Format("Grid pairs of {} boxes", count))
+        {
+            grid.FindOverlappingPairs(pairs);
+            return pairs.size();
+        };
+
+        BENCHMARK(Utils::Format("Quadtree build {} boxes", count))
+        {
+            quadtree.Build(boxes);
+            return quadtree.GetProxyCount();
+        };
+        BENCHMARK(Utils::Format("Quadtree move {} boxes", count))
+        {
+            Move(quadtree);
+        };
+        BENCHMARK(Utils::Format("Quadtree pairs of {} boxes", count))
+        {
+            quadtree.FindOverlappingPairs(pairs);
+            return pairs.size();
+        };
+
+        if (count <= 10'000)
+        {
+            BENCHMARK(Utils::Format("Brute force pairs of {} boxes", count))
+            {
+                return BruteForcePairs(boxes).size();
+            };
+        }
+    }
+}
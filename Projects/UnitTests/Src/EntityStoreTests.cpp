@@ -0,0 +1,328 @@
+#define RS_THROW_INSTEAD_OF_ASSERT
+
+#include "RSEngine.h"
+#include "ECS/EntityStore.h"
+#include "Catch2/catch_amalgamated.hpp"
+
+#include <atomic>
+#include <random>
+#include <set>
+
+using namespace RS;
+using namespace RS::ECS;
+
+namespace
+{
+    struct Position
+    {
+        float x = 0.f;
+        float y = 0.f;
+    };
+
+    struct Velocity
+    {
+        float x = 0.f;
+        float y = 0.f;
+    };
+
+    struct Health
+    {
+        float value = 100.f;
+    };
+
+    uint64 CountEntities(const EntityStore& store)
+    {
+        uint64 count = 0;
+        store.ForEachChunk([&](const Chunk& chunk) { count += chunk.GetCount(); });
+        return count;
+    }
+}
+
+TEST_CASE("EntityStore handles", "[EntityStore]")
+{
+    EntityStore store;
+    const EntityHandle a = store.Create(Position{ 1.f, 2.f }, Health{ 50.f });
+    const EntityHandle b = store.Create(Position{ 3.f, 4.f });
+
+    REQUIRE(store.GetCount() == 2);
+    REQUIRE(store.IsAlive(a));
+    REQUIRE(store.IsAlive(b));
+    REQUIRE_FALSE(store.IsAlive(InvalidEntity));
+    REQUIRE(store.Get<Position>(a)->y == 2.f);
+    REQUIRE(store.Get<Health>(a)->value == 50.f);
+    REQUIRE(store.Get<Health>(b) == nullptr);
+    REQUIRE(store.Get<Velocity>(a) == nullptr);
+
+    SECTION("Destroyed handles stay invalid after the slot is reused")
+    {
+        REQUIRE(store.Destroy(a));
+        REQUIRE_FALSE(store.IsAlive(a));
+        REQUIRE_FALSE(store.Destroy(a));
+        REQUIRE(store.Get<Position>(a) == nullptr);
+
+        const EntityHandle c = store.Create(Position{ 5.f, 6.f }, Health{});
+        REQUIRE(c.index == a.index);
+        REQUIRE(c.generation != a.generation);
+        REQUIRE_FALSE(store.IsAlive(a));
+        REQUIRE(store.Get<Position>(c)->x == 5.f);
+    }
+
+    SECTION("Clear")
+    {
+        store.Clear();
+        REQUIRE(store.GetCount() == 0);
+        REQUIRE(CountEntities(store) == 0);
+        REQUIRE_FALSE(store.IsAlive(a));
+        REQUIRE_FALSE(store.IsAlive(b));
+    }
+
+    SECTION("A component type can only be used once")
+    {
+        REQUIRE_THROWS(store.Create(Position{}, Position{}));
+    }
+}
+
+TEST_CASE("EntityStore removal keeps the other entities", "[EntityStore]")
+{
+    // Enough entities for several chunks.
+    const uint32 count = 5000;
+    EntityStore store;
+    std::vector<EntityHandle> entities;
+    for (uint32 i = 0; i < count; ++i)
+        entities.push_back(store.Create(Position{ (float)i, 0.f }, Velocity{ 0.f, (float)i }));
+
+    std::mt19937 rng(5);
+    std::shuffle(entities.begin(), entities.end(), rng);
+    std::vector<EntityHandle> destroyed(entities.begin(), entities.begin() + count / 2);
+    std::vector<EntityHandle> alive(entities.begin() + count / 2, entities.end());
+    for (EntityHandle entity : destroyed)
+        REQUIRE(store.Destroy(entity));
+
+    REQUIRE(store.GetCount() == alive.size());
+    REQUIRE(CountEntities(store) == alive.size());
+    for (EntityHandle entity : destroyed)
+        REQUIRE_FALSE(store.IsAlive(entity));
+
+    // The components moved along with their entities.
+    for (EntityHandle entity : alive)
+    {
+        REQUIRE(store.IsAlive(entity));
+        REQUIRE(store.Get<Position>(entity)->x == store.Get<Velocity>(entity)->y);
+    }
+
+    // Every chunk but the last is full, and the handles in them match the slots.
+    std::set<uint32> seen;
+    store.ForEach<Position>([&](EntityHandle entity, Position& position)
+        {
+            REQUIRE(store.Get<Position>(entity) == &position);
+            seen.insert(entity.index);
+        });
+    REQUIRE(seen.size() == alive.size());
+
+    uint32 partialChunks = 0;
+    uint32 fullCount = 0;
+    store.ForEachChunk([&](const Chunk& chunk)
+        {
+            fullCount = std::max(fullCount, chunk.GetCount());
+            REQUIRE(chunk.GetCount() > 0);
+        });
+    store.ForEachChunk([&](const Chunk& chunk) { partialChunks += chunk.GetCount() < fullCount ? 1 : 0; });
+    REQUIRE(partialChunks <= 1);
+
+    SECTION("Destroying while iterating is not allowed")
+    {
+        REQUIRE_THROWS(store.ForEachChunk([&](const Chunk&) { store.Destroy(alive[0]); }));
+    }
+
+    SECTION("Queued destruction")
+    {
+        store.ForEach<Position>([&](EntityHandle entity, Position& position)
+            {
+                if ((uint32)position.x % 2 == 0)
+                    store.QueueDestroy(entity);
+            });
+        const uint64 remaining = std::count_if(alive.begin(), alive.end(), [&](EntityHandle entity) { return (uint32)store.Get<Position>(entity)->x % 2 == 1; });
+        REQUIRE(store.FlushDestroyed() == alive.size() - remaining);
+        REQUIRE(store.GetCount() == remaining);
+        REQUIRE(store.FlushDestroyed() == 0);
+    }
+}
+
+TEST_CASE("EntityStore destroy callback", "[EntityStore]")
+{
+    // Enough entities for several chunks, queued from a parallel loop like Game1 does.
+    EntityStore store;
+    std::vector<EntityHandle> entities;
+    for (uint32 i = 0; i < 5000; ++i)
+        entities.push_back(store.Create(Position{ (float)i, 0.f }, Health{}));
+
+    store.ForEachChunkParallel<Position>([&](const Chunk& chunk)
+        {
+            const EntityHandle* pEntities = chunk.GetEntities();
+            const Position* pPositions = chunk.Get<Position>();
+            for (uint32 i = 0; i < chunk.GetCount(); ++i)
+            {
+                if ((uint32)pPositions[i].x % 3 == 0)
+                    store.QueueDestroy(pEntities[i]);
+            }
+        });
+    const uint64 queuedCount = (5000 + 2) / 3;
+
+    // Queued twice, still destroyed and reported once.
+    store.QueueDestroy(entities[0]);
+    store.QueueDestroy(entities[3]);
+
+    std::set<uint32> called;
+    uint64 wrongCount = 0;
+    const uint64 destroyedCount = store.FlushDestroyed([&](EntityHandle entity)
+        {
+            // The components are still there when the callback runs.
+            wrongCount += store.IsAlive(entity) && (uint32)store.Get<Position>(entity)->x % 3 == 0 ? 0 : 1;
+            wrongCount += called.insert(entity.index).second ? 0 : 1;
+        });
+    REQUIRE(destroyedCount == queuedCount);
+    REQUIRE(called.size() == queuedCount);
+    REQUIRE(wrongCount == 0);
+    REQUIRE(store.GetCount() == 5000 - queuedCount);
+    REQUIRE(CountEntities(store) == 5000 - queuedCount);
+    REQUIRE(store.FlushDestroyed([&](EntityHandle) { ++wrongCount; }) == 0);
+    REQUIRE(wrongCount == 0);
+}
+
+TEST_CASE("EntityStore queries", "[EntityStore]")
+{
+    EntityStore store;
+    for (uint32 i = 0; i < 100; ++i)
+    {
+        store.Create(Position{}, Velocity{ 1.f, 2.f });
+        store.Create(Position{}, Velocity{ 1.f, 2.f }, Health{});
+        store.Create(Position{}, Health{});
+    }
+
+    uint64 movingCount = 0;
+    store.ForEach<Position, Velocity>([&](EntityHandle, Position& position, Velocity& velocity)
+        {
+            position.x += velocity.x;
+            position.y += velocity.y;
+            ++movingCount;
+        });
+    REQUIRE(movingCount == 200);
+
+    uint64 healthCount = 0;
+    store.ForEach<Health>([&](EntityHandle, Health&) { ++healthCount; });
+    REQUIRE(healthCount == 200);
+
+    float sum = 0.f;
+    store.ForEach<Position>([&](EntityHandle, Position& position) { sum += position.y; });
+    REQUIRE(sum == 400.f);
+}
+
+TEST_CASE("EntityStore parallel iteration", "[EntityStore]")
+{
+    const uint32 count = 100'000;
+    EntityStore store;
+    for (uint32 i = 0; i < count; ++i)
+        store.Create(Position{ (float)i, 0.f }, Velocity{ 1.f, 0.f }, Health{ (float)(i % 10) });
+
+    std::atomic<uint64> visited = 0;
+    store.ForEachChunkParallel<Position, Velocity, Health>([&](const Chunk& chunk)
+        {
+            Position* pPositions = chunk.Get<Position>();
+            const Velocity* pVelocities = chunk.Get<Velocity>();
+            const Health* pHealths = chunk.Get<Health>();
+            const EntityHandle* pEntities = chunk.GetEntities();
+            for (uint32 i = 0; i < chunk.GetCount(); ++i)
+            {
+                pPositions[i].x += pVelocities[i].x;
+                if (pHealths[i].value == 0.f)
+                    store.QueueDestroy(pEntities[i]);
+            }
+            visited += chunk.GetCount();
+        });
+    REQUIRE(visited == count);
+    REQUIRE(store.FlushDestroyed() == count / 10);
+    REQUIRE(store.GetCount() == count - count / 10);
+
+    std::atomic<uint64> wrong = 0;
+    store.ForEachChunkParallel<Position>([&](const Chunk& chunk)
+        {
+            const Position* pPositions = chunk.Get<Position>();
+            for (uint32 i = 0; i < chunk.GetCount(); ++i)
+                wrong += ((uint32)pPositions[i].x % 10 == 1) ? 1 : 0;
+        });
+    REQUIRE(wrong == 0);
+}
+
+// Hidden by default, run with: UnitTests.exe "[benchmark]"
+TEST_CASE("EntityStore speed", "[.][benchmark][EntityStore]")
+{
+    const uint32 count = 1'000'000;
+
+    BENCHMARK(Utils::Format("Spawn {} entities", count))
+    {
+        EntityStore store;
+        for (uint32 i = 0; i < count; ++i)
+            store.Create(Position{ (float)i, 0.f }, Velocity{ 1.f, 1.f }, Health{});
+        return store.GetCount();
+    };
+
+    EntityStore store;
+    std::vector<EntityHandle> entities;
+    entities.reserve(count);
+    for (uint32 i = 0; i < count; ++i)
+        entities.push_back(store.Create(Position{ (float)i, 0.f }, Velocity{ 1.f, 1.f }, Health{}));
+
+    auto Move = [](const Chunk& chunk)
+    {
+        Position* pPositions = chunk.Get<Position>();
+        const Velocity* pVelocities = chunk.Get<Velocity>();
+        for (uint32 i = 0; i < chunk.GetCount(); ++i)
+        {
+            pPositions[i].x += pVelocities[i].x * 0.016f;
+            pPositions[i].y += pVelocities[i].y * 0.016f;
+        }
+    };
+
+    BENCHMARK(Utils::Format("Move {} entities", count))
+    {
+        store.ForEachChunk<Position, Velocity>(Move);
+    };
+    BENCHMARK(Utils::Format("Move {} entities in parallel", count))
+    {
+        store.ForEachChunkParallel<Position, Velocity>(Move);
+    };
+
+    // The same work on an array of structures, like Game1 used to store its entities.
+    struct EntityAoS
+    {
+        uint32 type;
+        Position position;
+        Velocity velocity;
+        float friction;
+        Health health;
+        float scale;
+    };
+    std::vector<EntityAoS> entitiesAoS(count);
+    BENCHMARK(Utils::Format("Move {} AoS entities", count))
+    {
+        for (EntityAoS& entity : entitiesAoS)
+        {
+            entity.position.x += entity.velocity.x * 0.016f;
+            entity.position.y += entity.velocity.y * 0.016f;
+        }
+    };
+
+    // Handles of a new store are deterministic, so they can be shuffled up front.
+    std::mt19937 rng(9);
+    std::shuffle(entities.begin(), entities.end(), rng);
+    entities.resize(count / 2);
+    BENCHMARK(Utils::Format("Spawn {} entities and destroy half of them in random order", count))
+    {
+        EntityStore randomStore;
+        for (uint32 i = 0; i < count; ++i)
+            randomStore.Create(Position{ (float)i, 0.f }, Velocity{ 1.f, 1.f }, Health{});
+        for (EntityHandle entity : entities)
+            randomStore.Destroy(entity);
+        return randomStore.GetCount();
+    };
+}
@@ -0,0 +1,205 @@
+#define RS_THROW_INSTEAD_OF_ASSERT
+
+#include "RSEngine.h"
+#include "Core/FrameHistory.h"
+#include "Catch2/catch_amalgamated.hpp"
+
+#include <fstream>
+#include <sstream>
+
+using namespace RS;
+
+namespace
+{
+    FrameSample MakeSample(uint64 frame, float frameMs, float gpuMs = 0.f, uint64 memoryBytes = 0)
+    {
+        FrameSample sample = {};
+        sample.frame = frame;
+        sample.frameMs = frameMs;
+        sample.cpuMs = frameMs * 0.5f;
+        sample.gpuMs = gpuMs;
+        sample.fixedTicks = 1;
+        sample.memoryBytes = memoryBytes;
+        return sample;
+    }
+}
+
+TEST_CASE("DurationHistogram percentiles", "[FrameHistory]")
+{
+    DurationHistogram histogram;
+    REQUIRE(histogram.GetPercentileMs(50.f) == 0.f);
+    REQUIRE(histogram.GetMeanOfLongestMs(0.01f) == 0.f);
+
+    SECTION("Short durations are exact")
+    {
+        for (uint32 us = 1; us <= 100; ++us)
+            histogram.Record((float)us / 1000.f);
+        REQUIRE(histogram.GetPercentileMs(50.f) == Catch::Approx(0.050f));
+        REQUIRE(histogram.GetPercentileMs(99.f) == Catch::Approx(0.099f));
+        REQUIRE(histogram.GetPercentileMs(100.f) == Catch::Approx(0.100f));
+    }
+
+    SECTION("Long durations are within the bucket precision")
+    {
+        // Shuffled, the order they are recorded in does not matter.
+        for (uint32 i = 0; i < 1000; ++i)
+            histogram.Record((float)((i * 7919) % 1000 + 1));
+
+        const float precision = 1.f / (float)DurationHistogram::SubBucketHalfCount;
+        REQUIRE(histogram.GetCount() == 1000);
+        REQUIRE(histogram.GetPercentileMs(50.f) == Catch::Approx(500.f).epsilon(precision));
+        REQUIRE(histogram.GetPercentileMs(95.f) == Catch::Approx(950.f).epsilon(precision));
+        REQUIRE(histogram.GetPercentileMs(99.f) == Catch::Approx(990.f).epsilon(precision));
+        REQUIRE(histogram.GetPercentileMs(100.f) <= histogram.GetMaxMs());
+        REQUIRE(histogram.GetMaxMs() == Catch::Approx(1000.f));
+        REQUIRE(histogram.GetMeanMs() == Catch::Approx(500.5f));
+
+        // The 10 longest are 991 to 1000.
+        REQUIRE(histogram.GetMeanOfLongestMs(0.01f) == Catch::Approx(995.5f).epsilon(precision));
+    }
+
+    SECTION("Out of range durations are clamped")
+    {
+        histogram.Record(-1.f);
+        histogram.Record(1e12f);
+        REQUIRE(histogram.GetPercentileMs(0.f) == 0.f);
+        REQUIRE(histogram.GetMaxMs() == Catch::Approx((float)DurationHistogram::MaxUs / 1000.f));
+    }
+
+    histogram.Reset();
+    REQUIRE(histogram.GetCount() == 0);
+    REQUIRE(histogram.GetMaxMs() == 0.f);
+}
+
+TEST_CASE("FrameHistory keeps the last samples", "[FrameHistory]")
+{
+    FrameHistory history(4);
+    for (uint64 frame = 0; frame < 6; ++frame)
+        history.Record(MakeSample(frame, 10.f + (float)frame, frame % 2 == 0 ? 5.f : 0.f, frame * 100));
+
+    REQUIRE(history.GetCapacity() == 4);
+    REQUIRE(history.GetSampleCount() == 4);
+    for (uint32 i = 0; i < 4; ++i)
+        REQUIRE(history.GetSample(i).frame == 5 - i);
+    REQUIRE_THROWS(history.GetSample(4));
+
+    // The percentiles are over every frame, not only the ones that are kept.
+    const FrameHistorySummary summary = history.GetSummary();
+    REQUIRE(summary.frameCount == 6);
+    REQUIRE(summary.frame.p50Ms == Catch::Approx(12.f).epsilon(0.02));
+    REQUIRE(summary.frame.maxMs == Catch::Approx(15.f));
+    REQUIRE(summary.cpu.maxMs == Catch::Approx(7.5f));
+    REQUIRE(summary.peakMemoryBytes == 500);
+
+    // Frames without a GPU time are not part of its percentiles.
+    REQUIRE(summary.gpu.p50Ms == Catch::Approx(5.f));
+    REQUIRE(summary.gpu.maxMs == Catch::Approx(5.f));
+
+    history.Reset();
+    REQUIRE(history.GetSampleCount() == 0);
+    REQUIRE(history.GetSummary().frameCount == 0);
+}
+
+TEST_CASE("FrameHistory 1% low FPS", "[FrameHistory]")
+{
+    FrameHistory history;
+    for (uint64 frame = 0; frame < 990; ++frame)
+        history.Record(MakeSample(frame, 10.f));
+    for (uint64 frame = 990; frame < 1000; ++frame)
+        history.Record(MakeSample(frame, 50.f));
+
+    const FrameHistorySummary summary = history.GetSummary();
+    REQUIRE(summary.onePercentLowFPS == Catch::Approx(20.f).epsilon(0.01));
+    REQUIRE(summary.averageFPS == Catch::Approx(1000.f / 10.4f).epsilon(0.01));
+    REQUIRE(summary.frame.p95Ms == Catch::Approx(10.f).epsilon(0.01));
+    REQUIRE(summary.frame.p99Ms == Catch::Approx(10.f).epsilon(0.01));
+    REQUIRE(summary.frame.maxMs == Catch::Approx(50.f));
+}
+
+TEST_CASE("PerfBudget", "[FrameHistory]")
+{
+    PerfBudget budget;
+
+    SECTION("Parse")
+    {
+        REQUIRE(PerfBudget::Parse("frameP99=33.3, CPUp95 = 12 ,gpuP99=8,lowFPS=30,memoryMB=2", budget));
+        REQUIRE(budget.frameP99Ms == Catch::Approx(33.3f));
+        REQUIRE(budget.cpuP95Ms == Catch::Approx(12.f));
+        REQUIRE(budget.gpuP99Ms == Catch::Approx(8.f));
+        REQUIRE(budget.minOnePercentLowFPS == Catch::Approx(30.f));
+        REQUIRE(budget.maxMemoryBytes == 2 * 1024 * 1024);
+        REQUIRE(budget.frameP95Ms == 0.f);
+
+        REQUIRE(PerfBudget::Parse("", budget));
+        REQUIRE(budget.frameP99Ms == 0.f);
+
+        REQUIRE_FALSE(PerfBudget::Parse("frameP99", budget));
+        REQUIRE_FALSE(PerfBudget::Parse("frameP99=fast", budget));
+        REQUIRE_FALSE(PerfBudget::Parse("frameP99=-1", budget));
+        REQUIRE_FALSE(PerfBudget::Parse("frameP98=10", budget));
+    }
+
+    SECTION("Check")
+    {
+        FrameHistory history;
+        for (uint64 frame = 0; frame < 100; ++frame)
+            history.Record(MakeSample(frame, frame == 99 ? 100.f : 10.f, 4.f, 1024 * 1024));
+        const FrameHistorySummary summary = history.GetSummary();
+
+        std::vector<std::string> failures;
+        REQUIRE(PerfBudget::Parse("frameP95=11,cpuP99=6,gpuP95=5,memoryMB=1", budget));
+        REQUIRE(budget.Check(summary, failures));
+        REQUIRE(failures.empty());
+
+        // The one slow frame is the slowest 1%.
+        REQUIRE(PerfBudget::Parse("frameP95=11,lowFPS=30,gpuP99=3,memoryMB=0.5", budget));
+        REQUIRE_FALSE(budget.Check(summary, failures));
+        REQUIRE(failures.size() == 3);
+
+        failures.clear();
+        REQUIRE_FALSE(PerfBudget().Check(FrameHistory().GetSummary(), failures));
+        REQUIRE(failures.size() == 1);
+
+        // Frames without GPU times can not pass a GPU limit.
+        FrameHistory cpuOnly;
+        for (uint64 frame = 0; frame < 10; ++frame)
+            cpuOnly.Record(MakeSample(frame, 10.f));
+        REQUIRE(cpuOnly.GetSummary().gpuFrameCount == 0);
+        REQUIRE(summary.gpuFrameCount == 100);
+
+        failures.clear();
+        REQUIRE(PerfBudget::Parse("frameP95=11", budget));
+        REQUIRE(budget.Check(cpuOnly.GetSummary(), failures));
+        REQUIRE(PerfBudget::Parse("frameP95=11,gpuP99=8", budget));
+        REQUIRE_FALSE(budget.Check(cpuOnly.GetSummary(), failures));
+        REQUIRE(failures == std::vector<std::string>{ "No GPU samples were recorded" });
+    }
+}
+
+TEST_CASE("FrameHistory export", "[FrameHistory]")
+{
+    FrameHistory history(2);
+    history.Record(MakeSample(7, 16.f, 0.f, 10));
+    history.Record(MakeSample(8, 17.f, 3.f, 20));
+    history.Record(MakeSample(9, 18.f, 4.f, 30));
+
+    std::ostringstream csv;
+    history.ExportCSV(csv);
+    REQUIRE(csv.str() ==
+        "frame,frameMs,cpuMs,gpuMs,fixedTicks,memoryBytes\n"
+        "8,17.000,8.500,3.000,1,20\n"
+        "9,18.000,9.000,4.000,1,30\n");
+
+    std::ostringstream json;
+    history.ExportJSON(json);
+    const std::string text = json.str();
+    REQUIRE(text.starts_with("{\"summary\":{\"frameCount\":3,\"frame\":{\"p50Ms\":"));
+    REQUIRE(text.find("\"peakMemoryBytes\":30},\n\"samples\":[\n{\"frame\":8,\"frameMs\":17.000,") != std::string::npos);
+    REQUIRE(text.find("},\n{\"frame\":9,") != std::string::npos);
+    REQUIRE(text.ends_with("\"memoryBytes\":30}\n]}\n"));
+
+    const std::string path = Engine::GetTempFilePath() + "FrameHistoryTests/FrameStats.csv";
+    REQUIRE(history.ExportCSV(path));
+    std::ifstream file(path);
+    REQUIRE(std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()) == csv.str());
+}
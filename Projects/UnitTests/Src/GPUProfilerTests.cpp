@@ -0,0 +1,305 @@
+#define RS_THROW_INSTEAD_OF_ASSERT
+
+#include "RSEngine.h"
+#include "Render/GPUProfiler.h"
+#include "Catch2/catch_amalgamated.hpp"
+
+using namespace RS;
+
+namespace
+{
+    // Timestamps are set by the test, resolves complete when the test says so.
+    class FakeTimestampQueue : public IGPUTimestampQueue
+    {
+    public:
+        inline static constexpr uint64 Frequency = 1'000'000;
+        inline static constexpr uint64 GPUCalibration = 5'000;
+        inline static constexpr uint64 CPUCalibration = 1'000'000'000;
+
+        struct ResolveCall
+        {
+            uint32 firstQuery;
+            uint32 count;
+        };
+
+    public:
+        explicit FakeTimestampQueue(uint32 queryCount) : timestamps(queryCount, 0) {}
+
+        uint64 GetTimestampFrequency() const override { return Frequency; }
+
+        void GetClockCalibration(uint64& gpuTimestamp, uint64& cpuTick) const override
+        {
+            gpuTimestamp = GPUCalibration;
+            cpuTick = CPUCalibration;
+        }
+
+        uint64 Resolve(uint32 firstQuery, uint32 count) override
+        {
+            REQUIRE(firstQuery + count <= (uint32)timestamps.size());
+            resolves.push_back({ firstQuery, count });
+            return ++lastFence;
+        }
+
+        bool IsComplete(uint64 fenceValue) const override { return fenceValue <= completedFence; }
+
+        const uint64* MapTimestamps(uint32 firstQuery, uint32 count) override
+        {
+            REQUIRE(firstQuery + count <= (uint32)timestamps.size());
+            mapCount++;
+            return timestamps.data() + firstQuery;
+        }
+
+        void UnmapTimestamps() override {}
+
+        // Writes the timestamps of a zone the way the GPU would, in microseconds after the calibration.
+        void WriteZone(uint32 beginQuery, uint64 beginUs, uint64 endUs)
+        {
+            timestamps[beginQuery] = GPUCalibration + beginUs;
+            timestamps[beginQuery + 1] = GPUCalibration + endUs;
+        }
+
+        void CompleteAll() { completedFence = lastFence; }
+
+    public:
+        std::vector<uint64>         timestamps;
+        std::vector<ResolveCall>    resolves;
+        uint64                      lastFence = 0;
+        uint64                      completedFence = 0;
+        uint32                      mapCount = 0;
+    };
+
+    GPUProfilerSettings MakeSettings(uint32 framesInFlight, uint32 maxZonesPerFrame)
+    {
+        GPUProfilerSettings settings;
+        settings.framesInFlight = framesInFlight;
+        settings.maxZonesPerFrame = maxZonesPerFrame;
+        settings.trackName = "GPU Test Queue";
+        return settings;
+    }
+
+    uint32 RecordZone(GPUProfiler& profiler, FakeTimestampQueue& queue, const char* pName, uint64 beginUs, uint64 endUs)
+    {
+        const uint32 query = profiler.BeginZone(pName);
+        if (query != GPUProfiler::InvalidQuery)
+        {
+            queue.WriteZone(query, beginUs, endUs);
+            profiler.EndZone(query);
+        }
+        return query;
+    }
+}
+
+TEST_CASE("GPUProfiler gives each frame in flight its own queries", "[GPUProfiler]")
+{
+    const GPUProfilerSettings settings = MakeSettings(3, 4);
+    auto pQueue = std::make_shared<FakeTimestampQueue>(GPUProfiler::GetQueryCount(settings));
+    GPUProfiler profiler(pQueue, settings);
+    REQUIRE(GPUProfiler::GetQueryCount(settings) == 24);
+
+    // Two queries per zone, one range of 8 per frame.
+    for (uint32 frame = 0; frame < 3; ++frame)
+    {
+        REQUIRE(RecordZone(profiler, *pQueue, "A", 0, 1) == frame * 8);
+        REQUIRE(RecordZone(profiler, *pQueue, "B", 1, 2) == frame * 8 + 2);
+        profiler.EndFrame();
+        pQueue->CompleteAll();
+    }
+
+    // Only the queries that were used are resolved.
+    REQUIRE(pQueue->resolves.size() == 3);
+    for (uint32 frame = 0; frame < 3; ++frame)
+    {
+        REQUIRE(pQueue->resolves[frame].firstQuery == frame * 8);
+        REQUIRE(pQueue->resolves[frame].count == 4);
+    }
+
+    // Back to the first range.
+    REQUIRE(RecordZone(profiler, *pQueue, "A", 0, 1) == 0);
+    REQUIRE(profiler.GetDroppedZoneCount() == 0);
+}
+
+TEST_CASE("GPUProfiler reads frames back when the GPU is done", "[GPUProfiler]")
+{
+    const GPUProfilerSettings settings = MakeSettings(3, 4);
+    auto pQueue = std::make_shared<FakeTimestampQueue>(GPUProfiler::GetQueryCount(settings));
+    GPUProfiler profiler(pQueue, settings);
+
+    RecordZone(profiler, *pQueue, "Frame 0", 0, 10);
+    profiler.EndFrame();
+    RecordZone(profiler, *pQueue, "Frame 1", 20, 30);
+    profiler.EndFrame();
+    REQUIRE(pQueue->mapCount == 0);
+    REQUIRE(profiler.GetResolvedZones().empty());
+
+    // Both frames are done, the newer one is read back last.
+    pQueue->CompleteAll();
+    RecordZone(profiler, *pQueue, "Frame 2", 40, 50);
+    profiler.EndFrame();
+    REQUIRE(pQueue->mapCount == 2);
+    REQUIRE(profiler.GetResolvedFrameIndex() == 1);
+    REQUIRE(profiler.GetResolvedZones().size() == 1);
+    REQUIRE(std::string(profiler.GetResolvedZones()[0].pName) == "Frame 1");
+
+    // Frames without zones resolve nothing.
+    profiler.EndFrame();
+    REQUIRE(pQueue->resolves.size() == 3);
+    pQueue->CompleteAll();
+    profiler.EndFrame();
+    REQUIRE(pQueue->mapCount == 3);
+    REQUIRE(profiler.GetResolvedFrameIndex() == 2);
+    REQUIRE(std::string(profiler.GetResolvedZones()[0].pName) == "Frame 2");
+}
+
+TEST_CASE("GPUProfiler moves timestamps to CPU ticks", "[GPUProfiler]")
+{
+    const GPUProfilerSettings settings = MakeSettings(2, 4);
+    auto pQueue = std::make_shared<FakeTimestampQueue>(GPUProfiler::GetQueryCount(settings));
+    GPUProfiler profiler(pQueue, settings);
+
+    RecordZone(profiler, *pQueue, "Draw", 1'000, 3'500);
+    profiler.EndFrame();
+    pQueue->CompleteAll();
+    profiler.EndFrame();
+
+    REQUIRE(profiler.GetResolvedZones().size() == 1);
+    const Profiler::Zone& zone = profiler.GetResolvedZones()[0];
+    REQUIRE(zone.begin > FakeTimestampQueue::CPUCalibration);
+    REQUIRE(Profiler::TicksToMs(zone.begin - FakeTimestampQueue::CPUCalibration) == Catch::Approx(1.0));
+    REQUIRE(Profiler::TicksToMs(zone.end - zone.begin) == Catch::Approx(2.5));
+    REQUIRE(zone.thread == profiler.GetTrack());
+
+    // Timestamps from before the calibration end up before it too.
+    const uint32 query = profiler.BeginZone("Before");
+    pQueue->timestamps[query] = FakeTimestampQueue::GPUCalibration - 2'000;
+    pQueue->timestamps[query + 1] = FakeTimestampQueue::GPUCalibration - 1'000;
+    profiler.EndZone(query);
+    profiler.EndFrame();
+    pQueue->CompleteAll();
+    profiler.EndFrame();
+
+    const Profiler::Zone& before = profiler.GetResolvedZones()[0];
+    REQUIRE(before.end < FakeTimestampQueue::CPUCalibration);
+    REQUIRE(Profiler::TicksToMs(FakeTimestampQueue::CPUCalibration - before.begin) == Catch::Approx(2.0));
+}
+
+TEST_CASE("GPUProfiler nests zones by time", "[GPUProfiler]")
+{
+    const GPUProfilerSettings settings = MakeSettings(2, 8);
+    auto pQueue = std::make_shared<FakeTimestampQueue>(GPUProfiler::GetQueryCount(settings));
+    GPUProfiler profiler(pQueue, settings);
+
+    // Recorded out of order, like command lists that were recorded on other threads.
+    RecordZone(profiler, *pQueue, "Second", 60, 90);
+    RecordZone(profiler, *pQueue, "Inner", 10, 20);
+    RecordZone(profiler, *pQueue, "Outer", 0, 50);
+    RecordZone(profiler, *pQueue, "Innermost", 12, 18);
+    RecordZone(profiler, *pQueue, "Same Begin", 0, 5);
+    RecordZone(profiler, *pQueue, "Inside Second", 60, 70);
+    profiler.EndFrame();
+    pQueue->CompleteAll();
+    profiler.EndFrame();
+
+    const std::vector<Profiler::Zone>& zones = profiler.GetResolvedZones();
+    const std::vector<std::string> names = { "Outer", "Same Begin", "Inner", "Innermost", "Second", "Inside Second" };
+    const std::vector<uint32> depths = { 0, 1, 1, 2, 0, 1 };
+    REQUIRE(zones.size() == names.size());
+    for (uint32 i = 0; i < (uint32)zones.size(); ++i)
+    {
+        REQUIRE(names[i] == zones[i].pName);
+        REQUIRE(zones[i].depth == depths[i]);
+    }
+
+    // Only the outermost zones count as GPU time, and only once.
+    REQUIRE(profiler.TakeResolvedGPUMs() == Catch::Approx(0.08f));
+    REQUIRE(profiler.TakeResolvedGPUMs() == 0.f);
+}
+
+TEST_CASE("GPUProfiler drops zones it has no queries for", "[GPUProfiler]")
+{
+    const GPUProfilerSettings settings = MakeSettings(2, 2);
+    auto pQueue = std::make_shared<FakeTimestampQueue>(GPUProfiler::GetQueryCount(settings));
+    GPUProfiler profiler(pQueue, settings);
+
+    SECTION("Full frame")
+    {
+        RecordZone(profiler, *pQueue, "A", 0, 1);
+        RecordZone(profiler, *pQueue, "B", 1, 2);
+        REQUIRE(RecordZone(profiler, *pQueue, "C", 2, 3) == GPUProfiler::InvalidQuery);
+        REQUIRE(profiler.GetDroppedZoneCount() == 1);
+
+        profiler.EndFrame();
+        REQUIRE(pQueue->resolves.back().count == 4);
+        pQueue->CompleteAll();
+        profiler.EndFrame();
+        REQUIRE(profiler.GetResolvedZones().size() == 2);
+    }
+
+    SECTION("Queries still in flight")
+    {
+        RecordZone(profiler, *pQueue, "Frame 0", 0, 1);
+        profiler.EndFrame();
+        RecordZone(profiler, *pQueue, "Frame 1", 0, 1);
+        profiler.EndFrame();
+
+        // The range of frame 0 is not read back yet, so frame 2 can not use it.
+        REQUIRE(RecordZone(profiler, *pQueue, "Frame 2", 0, 1) == GPUProfiler::InvalidQuery);
+        REQUIRE(profiler.GetDroppedZoneCount() == 1);
+        profiler.EndFrame();
+        REQUIRE(pQueue->resolves.size() == 2);
+
+        pQueue->CompleteAll();
+        profiler.EndFrame();
+        REQUIRE(profiler.GetResolvedFrameIndex() == 1);
+        REQUIRE(RecordZone(profiler, *pQueue, "Frame 4", 0, 1) != GPUProfiler::InvalidQuery);
+    }
+
+    SECTION("Never ended")
+    {
+        profiler.BeginZone("Open");
+        RecordZone(profiler, *pQueue, "Closed", 0, 1);
+        profiler.EndFrame();
+        pQueue->CompleteAll();
+        profiler.EndFrame();
+
+        REQUIRE(profiler.GetResolvedZones().size() == 1);
+        REQUIRE(std::string(profiler.GetResolvedZones()[0].pName) == "Closed");
+        REQUIRE(profiler.GetDroppedZoneCount() == 1);
+    }
+
+    REQUIRE_THROWS(profiler.EndZone(GPUProfiler::InvalidQuery));
+}
+
+TEST_CASE("GPUProfiler zones are recorded on a Profiler track", "[GPUProfiler]")
+{
+    Profiler* pProfiler = Profiler::Get();
+    pProfiler->SetPaused(false);
+    pProfiler->EndFrame();
+
+    const GPUProfilerSettings settings = MakeSettings(2, 4);
+    auto pQueue = std::make_shared<FakeTimestampQueue>(GPUProfiler::GetQueryCount(settings));
+    GPUProfiler profiler(pQueue, settings);
+
+    const std::vector<std::string> threadNames = pProfiler->GetThreadNames();
+    REQUIRE(profiler.GetTrack() < (uint32)threadNames.size());
+    REQUIRE(threadNames[profiler.GetTrack()] == "GPU Test Queue");
+
+    RecordZone(profiler, *pQueue, "GPU Outer", 0, 10);
+    RecordZone(profiler, *pQueue, "GPU Inner", 2, 4);
+    profiler.EndFrame();
+    pQueue->CompleteAll();
+    profiler.EndFrame();
+    pProfiler->EndFrame();
+
+    std::vector<Profiler::Zone> gpuZones;
+    for (const Profiler::Zone& zone : pProfiler->GetFrame(0).zones)
+    {
+        if (zone.thread == profiler.GetTrack())
+            gpuZones.push_back(zone);
+    }
+    REQUIRE(gpuZones.size() == 2);
+    REQUIRE(std::string(gpuZones[0].pName) == "GPU Outer");
+    REQUIRE(gpuZones[0].depth == 0);
+    REQUIRE(std::string(gpuZones[1].pName) == "GPU Inner");
+    REQUIRE(gpuZones[1].depth == 1);
+    REQUIRE(gpuZones[1].begin == profiler.GetResolvedZones()[1].begin);
+}
@@ -0,0 +1,434 @@
+#define RS_THROW_INSTEAD_OF_ASSERT
+
+#include "RSEngine.h"
+#include "Graphics/GlyphAtlas.h"
+#include "Utils/Misc/StringUtils.h"
+#include "Catch2/catch_amalgamated.hpp"
+
+#include <random>
+#include <unordered_set>
+
+using namespace RS;
+
+namespace
+{
+    // Boxes whose size and value come from the codepoint, so the atlas content can be checked without a font.
+    class BoxRasterizer : public IGlyphRasterizer
+    {
+    public:
+        std::unordered_set<uint32> missing;
+        uint32 rasterizeCount = 0;
+
+        bool Rasterize(uint32 codepoint, GlyphBitmap& bitmap) override
+        {
+            if (missing.contains(codepoint))
+                return false;
+
+            rasterizeCount++;
+            bitmap.advance = 10.f + (float)(codepoint % 5);
+            if (codepoint == ' ')
+                return true;
+
+            bitmap.width = GetWidth(codepoint);
+            bitmap.height = GetHeight(codepoint);
+            bitmap.bearingX = (int32)(codepoint % 3);
+            bitmap.bearingY = (int32)bitmap.height - (int32)(codepoint % 4);
+            bitmap.pixels.resize((uint64)bitmap.width * bitmap.height);
+            for (uint32 i = 0; i < bitmap.pixels.size(); ++i)
+                bitmap.pixels[i] = GetPixel(codepoint, i);
+            return true;
+        }
+
+        float GetLineHeight() const override { return 20.f; }
+
+        static uint32 GetWidth(uint32 codepoint) { return 4 + codepoint % 13; }
+        static uint32 GetHeight(uint32 codepoint) { return 6 + codepoint % 9; }
+        static uint8 GetPixel(uint32 codepoint, uint32 index) { return (uint8)(1 + (codepoint * 7 + index) % 255); }
+    };
+
+    // Every texel is covered by at most one rectangle and all of them are inside the area.
+    void CheckNoOverlap(uint32 width, uint32 height, const std::vector<std::array<uint32, 4>>& rects)
+    {
+        std::vector<uint8> covered((uint64)width * height, 0);
+        for (const std::array<uint32, 4>& rect : rects)
+        {
+            REQUIRE(rect[0] + rect[2] <= width);
+            REQUIRE(rect[1] + rect[3] <= height);
+            for (uint32 y = rect[1]; y < rect[1] + rect[3]; ++y)
+            {
+                for (uint32 x = rect[0]; x < rect[0] + rect[2]; ++x)
+                {
+                    REQUIRE(covered[(uint64)y * width + x] == 0);
+                    covered[(uint64)y * width + x] = 1;
+                }
+            }
+        }
+    }
+
+    // The texels of the glyph are the ones the rasterizer made and the padding around it is empty.
+    void CheckGlyphPixels(const GlyphAtlas& atlas, uint32 codepoint, const AtlasGlyph& glyph, uint32 padding)
+    {
+        REQUIRE(glyph.width == BoxRasterizer::GetWidth(codepoint));
+        REQUIRE(glyph.height == BoxRasterizer::GetHeight(codepoint));
+        REQUIRE(glyph.page < atlas.GetPageCount());
+
+        const GlyphAtlas::Page& page = atlas.GetPage(glyph.page);
+        REQUIRE(glyph.x >= padding);
+        REQUIRE(glyph.y >= padding);
+        REQUIRE(glyph.x + glyph.width + padding <= page.width);
+        REQUIRE(glyph.y + glyph.height + padding <= page.height);
+        for (uint32 y = 0; y < glyph.height; ++y)
+        {
+            for (uint32 x = 0; x < glyph.width; ++x)
+                REQUIRE(page.pixels[(uint64)(glyph.y + y) * page.width + glyph.x + x] == BoxRasterizer::GetPixel(codepoint, y * glyph.width + x));
+        }
+        for (uint32 x = 0; x < glyph.width; ++x)
+        {
+            REQUIRE(page.pixels[(uint64)(glyph.y - 1) * page.width + glyph.x + x] == 0);
+            REQUIRE(page.pixels[(uint64)(glyph.y + glyph.height) * page.width + glyph.x + x] == 0);
+        }
+        for (uint32 y = 0; y < glyph.height; ++y)
+        {
+            REQUIRE(page.pixels[(uint64)(glyph.y + y) * page.width + glyph.x - 1] == 0);
+            REQUIRE(page.pixels[(uint64)(glyph.y + y) * page.width + glyph.x + glyph.width] == 0);
+        }
+    }
+
+    std::string EncodeUTF8(uint32 codepoint)
+    {
+        std::string text;
+        if (codepoint < 0x80)
+        {
+            text += (char)codepoint;
+        }
+        else if (codepoint < 0x800)
+        {
+            text += (char)(0xC0 | (codepoint >> 6));
+            text += (char)(0x80 | (codepoint & 0x3F));
+        }
+        else if (codepoint < 0x10000)
+        {
+            text += (char)(0xE0 | (codepoint >> 12));
+            text += (char)(0x80 | ((codepoint >> 6) & 0x3F));
+            text += (char)(0x80 | (codepoint & 0x3F));
+        }
+        else
+        {
+            text += (char)(0xF0 | (codepoint >> 18));
+            text += (char)(0x80 | ((codepoint >> 12) & 0x3F));
+            text += (char)(0x80 | ((codepoint >> 6) & 0x3F));
+            text += (char)(0x80 | (codepoint & 0x3F));
+        }
+        return text;
+    }
+
+    std::vector<uint32> DecodeAll(std::string_view text)
+    {
+        std::vector<uint32> codepoints;
+        size_t offset = 0;
+        while (offset < text.size())
+            codepoints.push_back(Utils::DecodeUTF8(text, offset));
+        return codepoints;
+    }
+}
+
+TEST_CASE("Skyline packer keeps rectangles apart and inside", "[GlyphAtlas]")
+{
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<uint32> size(1, 24);
+
+    SkylinePacker packer(256, 256);
+    std::vector<std::array<uint32, 4>> rects;
+    uint64 area = 0;
+    for (uint32 i = 0; i < 2000; ++i)
+    {
+        const uint32 width = size(rng);
+        const uint32 height = size(rng);
+        uint32 x = 0, y = 0;
+        if (!packer.Pack(width, height, x, y))
+            continue;
+        rects.push_back({ x, y, width, height });
+        area += (uint64)width * height;
+    }
+
+    CheckNoOverlap(256, 256, rects);
+    REQUIRE(packer.GetUsedArea() == area);
+    // Random sizes up to 24 texels should fill most of the area before nothing fits anymore.
+    CHECK((double)area / (256.0 * 256.0) > 0.75);
+
+    uint32 x = 0, y = 0;
+    CHECK_FALSE(packer.Pack(257, 1, x, y));
+    CHECK_FALSE(packer.Pack(1, 257, x, y));
+}
+
+TEST_CASE("Skyline packer grows without moving rectangles", "[GlyphAtlas]")
+{
+    SkylinePacker packer(64, 64);
+    std::vector<std::array<uint32, 4>> rects;
+    uint32 x = 0, y = 0;
+    while (packer.Pack(16, 16, x, y))
+        rects.push_back({ x, y, 16, 16 });
+    REQUIRE(rects.size() == 16);
+
+    packer.Grow(128, 64);
+    while (packer.Pack(16, 16, x, y))
+        rects.push_back({ x, y, 16, 16 });
+    REQUIRE(rects.size() == 32);
+
+    packer.Grow(128, 128);
+    while (packer.Pack(16, 16, x, y))
+        rects.push_back({ x, y, 16, 16 });
+    REQUIRE(rects.size() == 64);
+
+    CheckNoOverlap(128, 128, rects);
+    REQUIRE(packer.GetUsedArea() == 128 * 128);
+    REQUIRE_THROWS(packer.Grow(64, 128));
+}
+
+TEST_CASE("UTF-8 decoding", "[GlyphAtlas]")
+{
+    REQUIRE(DecodeAll("Ab 9") == std::vector<uint32>{ 'A', 'b', ' ', '9' });
+    REQUIRE(DecodeAll("\xC3\xA5\xE2\x82\xAC\xF0\x9F\x98\x80") == std::vector<uint32>{ 0xE5, 0x20AC, 0x1F600 });
+
+    for (uint32 codepoint : { 0x7Fu, 0x80u, 0x7FFu, 0x800u, 0xD7FFu, 0xE000u, 0xFFFDu, 0x10000u, 0x10FFFFu })
+        REQUIRE(DecodeAll(EncodeUTF8(codepoint)) == std::vector<uint32>{ codepoint });
+
+    // Broken input becomes U+FFFD one byte at a time, so the text after it still decodes.
+    REQUIRE(DecodeAll("\x80x") == std::vector<uint32>{ 0xFFFD, 'x' });
+    REQUIRE(DecodeAll("\xE2\x82x") == std::vector<uint32>{ 0xFFFD, 0xFFFD, 'x' });
+    REQUIRE(DecodeAll("\xC0\xAF") == std::vector<uint32>{ 0xFFFD, 0xFFFD });            // Overlong '/'.
+    REQUIRE(DecodeAll("\xED\xA0\x80") == std::vector<uint32>{ 0xFFFD, 0xFFFD, 0xFFFD });    // Surrogate.
+    REQUIRE(DecodeAll("\xF4\x90\x80\x80") == std::vector<uint32>{ 0xFFFD, 0xFFFD, 0xFFFD, 0xFFFD }); // Above U+10FFFF.
+    REQUIRE(DecodeAll("\xF0\x9F\x98") == std::vector<uint32>{ 0xFFFD, 0xFFFD, 0xFFFD });
+}
+
+TEST_CASE("Glyph atlas packs, grows and pages glyphs", "[GlyphAtlas]")
+{
+    GlyphAtlasSettings settings;
+    settings.initialPageSize = 32;
+    settings.maxPageSize = 128;
+    settings.padding = 1;
+
+    auto pRasterizer = std::make_unique<BoxRasterizer>();
+    BoxRasterizer* pBoxes = pRasterizer.get();
+    GlyphAtlas atlas(std::move(pRasterizer), settings);
+
+    // Glyphs are only rasterised when they are used.
+    REQUIRE(atlas.GetPageCount() == 0);
+    REQUIRE(pBoxes->rasterizeCount == 0);
+
+    std::vector<uint32> codepoints;
+    for (uint32 codepoint = 33; codepoint < 127; ++codepoint)
+        codepoints.push_back(codepoint);
+    for (uint32 codepoint = 0x400; codepoint < 0x500; ++codepoint)
+        codepoints.push_back(codepoint);
+    for (uint32 codepoint = 0x4E00; codepoint < 0x4F00; ++codepoint)
+        codepoints.push_back(codepoint);
+
+    std::vector<uint32> versions;
+    for (uint32 codepoint : codepoints)
+    {
+        const AtlasGlyph& glyph = atlas.GetGlyph(codepoint);
+        CheckGlyphPixels(atlas, codepoint, glyph, settings.padding);
+        REQUIRE(glyph.page == atlas.GetPageCount() - 1);
+
+        // Every page change is seen through a new version.
+        versions.resize(atlas.GetPageCount(), 0);
+        REQUIRE(atlas.GetPage(glyph.page).version > versions[glyph.page]);
+        versions[glyph.page] = atlas.GetPage(glyph.page).version;
+    }
+    REQUIRE(pBoxes->rasterizeCount == codepoints.size());
+    REQUIRE(atlas.GetGlyphCount() == codepoints.size());
+
+    // The glyphs need more than one full page, and only the last page is allowed to be smaller than the maximum.
+    REQUIRE(atlas.GetPageCount() > 1);
+    for (uint32 pageIndex = 0; pageIndex + 1 < atlas.GetPageCount(); ++pageIndex)
+    {
+        REQUIRE(atlas.GetPage(pageIndex).width == settings.maxPageSize);
+        REQUIRE(atlas.GetPage(pageIndex).height == settings.maxPageSize);
+    }
+
+    // Growing moved no glyph and lost no pixels, and the glyphs are not rasterised again.
+    for (uint32 codepoint : codepoints)
+        CheckGlyphPixels(atlas, codepoint, atlas.GetGlyph(codepoint), settings.padding);
+    REQUIRE(pBoxes->rasterizeCount == codepoints.size());
+
+    for (uint32 pageIndex = 0; pageIndex < atlas.GetPageCount(); ++pageIndex)
+    {
+        std::vector<std::array<uint32, 4>> rects;
+        for (uint32 codepoint : codepoints)
+        {
+            const AtlasGlyph& glyph = atlas.GetGlyph(codepoint);
+            if (glyph.page == pageIndex)
+                rects.push_back({ glyph.x - 1u, glyph.y - 1u, glyph.width + 2u, glyph.height + 2u });
+        }
+        CheckNoOverlap(atlas.GetPage(pageIndex).width, atlas.GetPage(pageIndex).height, rects);
+    }
+
+    // Too big for any page, it keeps its metrics but has no texels.
+    GlyphAtlasSettings tinySettings;
+    tinySettings.initialPageSize = 8;
+    tinySettings.maxPageSize = 16;
+    GlyphAtlas tinyAtlas(std::make_unique<BoxRasterizer>(), tinySettings);
+    const AtlasGlyph& bigGlyph = tinyAtlas.GetGlyph(12);
+    REQUIRE(bigGlyph.width == 0);
+    REQUIRE(bigGlyph.advance == 12.f);
+
+    GlyphAtlasSettings badSettings;
+    badSettings.initialPageSize = 64;
+    badSettings.maxPageSize = 32;
+    REQUIRE_THROWS(GlyphAtlas(std::make_unique<BoxRasterizer>(), badSettings));
+}
+
+TEST_CASE("Glyph atlas falls back for missing glyphs", "[GlyphAtlas]")
+{
+    SECTION("U+FFFD first")
+    {
+        auto pRasterizer = std::make_unique<BoxRasterizer>();
+        pRasterizer->missing = { 0x3000, 0x3001 };
+        GlyphAtlas atlas(std::move(pRasterizer));
+
+        const AtlasGlyph replacement = atlas.GetGlyph(0xFFFD);
+        const AtlasGlyph missing = atlas.GetGlyph(0x3000);
+        REQUIRE(atlas.GetGlyphCount() == 1);
+        REQUIRE(missing.page == replacement.page);
+        REQUIRE(missing.x == replacement.x);
+        REQUIRE(missing.y == replacement.y);
+        REQUIRE(missing.advance == replacement.advance);
+
+        // Every missing codepoint shares the glyph.
+        REQUIRE(atlas.GetGlyph(0x3001).x == replacement.x);
+        REQUIRE(atlas.GetGlyphCount() == 1);
+    }
+
+    SECTION("Then '?'")
+    {
+        auto pRasterizer = std::make_unique<BoxRasterizer>();
+        pRasterizer->missing = { 0x3000, 0xFFFD };
+        GlyphAtlas atlas(std::move(pRasterizer));
+
+        const AtlasGlyph missing = atlas.GetGlyph(0x3000);
+        CheckGlyphPixels(atlas, '?', missing, 1);
+        const AtlasGlyph question = atlas.GetGlyph('?');
+        REQUIRE(question.x == missing.x);
+        REQUIRE(question.y == missing.y);
+    }
+
+    SECTION("Else nothing")
+    {
+        auto pRasterizer = std::make_unique<BoxRasterizer>();
+        pRasterizer->missing = { 0x3000, 0xFFFD, '?' };
+        GlyphAtlas atlas(std::move(pRasterizer));
+
+        const AtlasGlyph missing = atlas.GetGlyph(0x3000);
+        REQUIRE(missing.width == 0);
+        REQUIRE(missing.advance == 0.f);
+        REQUIRE(atlas.GetPageCount() == 0);
+    }
+}
+
+TEST_CASE("Glyph atlas lays out text into per page instances", "[GlyphAtlas]")
+{
+    GlyphAtlasSettings settings;
+    settings.initialPageSize = 32;
+    settings.maxPageSize = 64;
+    GlyphAtlas atlas(std::make_unique<BoxRasterizer>(), settings);
+
+    const std::string text = "Hi \xC3\xA5\xE2\x82\xAC!";
+    const std::vector<uint32> codepoints = { 'H', 'i', ' ', 0xE5, 0x20AC, '!' };
+    const float scale = 2.f;
+    const uint32 color = 0xFF8000FF;
+
+    GlyphBatch batch;
+    const float endX = atlas.AppendText(text, 100.f, 50.f, scale, color, batch);
+
+    // The space has no quad but still moves the pen.
+    REQUIRE(batch.GetInstanceCount() == 5);
+
+    float x = 100.f;
+    std::vector<uint64> nextInstance(batch.pages.size(), 0);
+    for (uint32 codepoint : codepoints)
+    {
+        const AtlasGlyph& glyph = atlas.GetGlyph(codepoint);
+        if (glyph.width > 0)
+        {
+            REQUIRE(glyph.page < batch.pages.size());
+            const GlyphInstance& instance = batch.pages[glyph.page][nextInstance[glyph.page]++];
+            REQUIRE(instance.x == Catch::Approx(x + glyph.bearingX * scale));
+            REQUIRE(instance.y == Catch::Approx(50.f - (glyph.height - glyph.bearingY) * scale));
+            REQUIRE(instance.width == glyph.width * scale);
+            REQUIRE(instance.height == glyph.height * scale);
+            REQUIRE(instance.texelX == glyph.x);
+            REQUIRE(instance.texelY == glyph.y);
+            REQUIRE(instance.texelWidth == glyph.width);
+            REQUIRE(instance.texelHeight == glyph.height);
+            REQUIRE(instance.color == color);
+        }
+        x += glyph.advance * scale;
+    }
+    REQUIRE(endX == Catch::Approx(x));
+
+    // Enough glyphs to spill into more pages, every instance lands in the list of its page.
+    std::string manyGlyphs;
+    for (uint32 codepoint = 0x400; codepoint < 0x480; ++codepoint)
+        manyGlyphs += EncodeUTF8(codepoint);
+    batch.Clear();
+    REQUIRE(batch.GetInstanceCount() == 0);
+    atlas.AppendText(manyGlyphs, 0.f, 0.f, 1.f, color, batch);
+    REQUIRE(atlas.GetPageCount() > 1);
+    REQUIRE(batch.pages.size() == atlas.GetPageCount());
+    REQUIRE(batch.GetInstanceCount() == 0x80);
+    for (uint32 pageIndex = 0; pageIndex < batch.pages.size(); ++pageIndex)
+    {
+        for (const GlyphInstance& instance : batch.pages[pageIndex])
+        {
+            REQUIRE(instance.texelX + instance.texelWidth <= atlas.GetPage(pageIndex).width);
+            REQUIRE(instance.texelY + instance.texelHeight <= atlas.GetPage(pageIndex).height);
+        }
+    }
+}
+
+// Hidden by default, run with: UnitTests.exe "[benchmark]"
+TEST_CASE("Glyph layout speed", "[.][benchmark][GlyphAtlas]")
+{
+    GlyphAtlas atlas(std::make_unique<BoxRasterizer>());
+
+    // Mostly ASCII with some Latin-1 and Cyrillic, like UI text in a few languages.
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<uint32> pick(0, 99);
+    std::string text;
+    uint32 glyphCount = 0;
+    while (glyphCount < 100'000)
+    {
+        const uint32 roll = pick(rng);
+        const uint32 codepoint = roll < 80 ? 32 + roll : (roll < 90 ? 0xC0 + roll : 0x400 + roll);
+        text += EncodeUTF8(codepoint);
+        glyphCount++;
+    }
+    // Rasterising is a one time cost, only the layout is measured.
+    GlyphBatch batch;
+    atlas.AppendText(text, 0.f, 0.f, 1.f, 0xFFFFFFFF, batch);
+
+    BENCHMARK(Utils::Format("Layout of {} glyphs, {} bytes of UTF-8, into {} atlas pages", glyphCount, text.size(), atlas.GetPageCount()))
+    {
+        batch.Clear();
+        return atlas.AppendText(text, 0.f, 0.f, 1.f, 0xFFFFFFFF, batch);
+    };
+
+    // The same text as 1000 draws of 100 glyphs, the way a UI submits it.
+    BENCHMARK(Utils::Format("Layout of {} strings of 100 glyphs", glyphCount / 100))
+    {
+        batch.Clear();
+        float y = 0.f;
+        size_t offset = 0;
+        for (uint32 line = 0; line < glyphCount / 100; ++line)
+        {
+            const size_t begin = offset;
+            for (uint32 i = 0; i < 100; ++i)
+                Utils::DecodeUTF8(text, offset);
+            atlas.AppendText(std::string_view(text).substr(begin, offset - begin), 0.f, y, 1.f, 0xFFFFFFFF, batch);
+            y += 50.f;
+        }
+        return batch.GetInstanceCount();
+    };
+}
@@ -0,0 +1,154 @@
+#define RS_THROW_INSTEAD_OF_ASSERT
+
+#include "RSEngine.h"
+#include "Core/InputRecording.h"
+#include "Catch2/catch_amalgamated.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+using namespace RS;
+
+namespace
+{
+    std::string GetTestDirectory()
+    {
+        std::string path = Engine::GetTempFilePath() + "InputRecordingTests/";
+        std::filesystem::create_directories(path);
+        return path;
+    }
+
+    // Random events, some frames have none and some have several.
+    std::vector<InputEvent> CreateEvents(uint32 frameCount)
+    {
+        std::mt19937 rng(11);
+        std::uniform_real_distribution<float> position(0.f, 1920.f);
+        std::uniform_int_distribution<int32> eventsPerFrame(0, 3);
+        std::vector<InputEvent> events;
+        for (uint32 frame = 0; frame < frameCount; ++frame)
+        {
+            const int32 count = eventsPerFrame(rng);
+            for (int32 i = 0; i < count; ++i)
+            {
+                InputEvent event;
+                event.frame = frame;
+                event.type = (InputEvent::Type)(rng() % 4);
+                event.code = (int32)(rng() % 300);
+                event.action = (int32)(rng() % 2);
+                event.mods = (int32)(rng() % 16);
+                event.x = position(rng);
+                event.y = position(rng);
+                events.push_back(event);
+            }
+        }
+        return events;
+    }
+}
+
+TEST_CASE("Input logs replay the recorded events", "[InputRecording]")
+{
+    REQUIRE(sizeof(InputEvent) == 32);
+
+    const std::string path = GetTestDirectory() + "Recording.rsinput";
+    const std::vector<InputEvent> events = CreateEvents(1000);
+    const uint64 endFrame = events.back().frame + 60;
+    {
+        InputRecorder recorder;
+        REQUIRE(recorder.Open(path));
+        for (const InputEvent& event : events)
+            recorder.Write(event);
+        recorder.Close(endFrame);
+        REQUIRE_FALSE(recorder.IsOpen());
+    }
+
+    InputPlayer player;
+    REQUIRE(player.Load(path));
+    REQUIRE(player.GetEventCount() == events.size() + 1);
+    REQUIRE(player.GetFrameCount() == endFrame);
+
+    SECTION("Every event once, in the frame it was recorded in")
+    {
+        std::vector<InputEvent> replayed;
+        uint64 frame = 0;
+        while (!player.IsFinished())
+        {
+            // Exactly the events of this frame, never the ones of the next, so a press and a release stay apart.
+            const std::span<const InputEvent> frameEvents = player.Advance(frame);
+            const uint64 expected = (uint64)std::count_if(events.begin(), events.end(), [frame](const InputEvent& event) { return event.frame == frame; });
+            REQUIRE(frameEvents.size() == expected + (frame == endFrame ? 1 : 0));
+            for (const InputEvent& event : frameEvents)
+            {
+                REQUIRE(event.frame == frame);
+                replayed.push_back(event);
+            }
+            frame++;
+        }
+
+        REQUIRE(frame == endFrame + 1);
+        REQUIRE(replayed.size() == events.size() + 1);
+        REQUIRE(replayed.back().type == InputEvent::Type::End);
+        REQUIRE(std::memcmp(replayed.data(), events.data(), events.size() * sizeof(InputEvent)) == 0);
+        REQUIRE(player.Advance(frame).empty());
+    }
+
+    SECTION("Loading again starts over")
+    {
+        REQUIRE(player.Advance(endFrame).size() == events.size() + 1);
+        REQUIRE(player.IsFinished());
+        REQUIRE(player.Load(path));
+        REQUIRE_FALSE(player.IsFinished());
+        REQUIRE(player.Advance(events.back().frame).size() == events.size());
+    }
+}
+
+TEST_CASE("Input logs from runs that did not stop cleanly", "[InputRecording]")
+{
+    const std::string path = GetTestDirectory() + "Crashed.rsinput";
+    const std::vector<InputEvent> events = CreateEvents(100);
+    {
+        InputRecorder recorder;
+        REQUIRE(recorder.Open(path));
+        for (const InputEvent& event : events)
+            recorder.Write(event);
+
+        // Events have to be in order.
+        InputEvent late = events.back();
+        late.frame -= 1;
+        REQUIRE_THROWS(recorder.Write(late));
+    }
+
+    SECTION("Closed by the destructor")
+    {
+        InputPlayer player;
+        REQUIRE(player.Load(path));
+        REQUIRE(player.GetEventCount() == events.size() + 1);
+        REQUIRE(player.GetFrameCount() == events.back().frame);
+    }
+
+    SECTION("A partly written last event is dropped")
+    {
+        std::filesystem::resize_file(path, std::filesystem::file_size(path) - sizeof(InputEvent) - 5);
+        InputPlayer player;
+        REQUIRE(player.Load(path));
+        REQUIRE(player.GetEventCount() == events.size() - 1);
+    }
+}
+
+TEST_CASE("Files that are not input logs", "[InputRecording]")
+{
+    InputPlayer player;
+    REQUIRE_FALSE(player.Load(GetTestDirectory() + "Missing.rsinput"));
+
+    const std::string path = GetTestDirectory() + "Wrong.rsinput";
+    {
+        std::ofstream stream(path, std::ios::out | std::ios::binary | std::ios::trunc);
+        const uint32 header[2] = { 0x12345678, InputLogHeader::Version };
+        stream.write((const char*)header, sizeof(header));
+    }
+    REQUIRE_FALSE(player.Load(path));
+    REQUIRE(player.IsFinished());
+
+    std::filesystem::resize_file(path, 3);
+    REQUIRE_FALSE(player.Load(path));
+}
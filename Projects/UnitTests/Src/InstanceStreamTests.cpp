@@ -0,0 +1,142 @@
+#define RS_THROW_INSTEAD_OF_ASSERT
+
+#include "RSEngine.h"
+#include "Graphics/InstanceStream.h"
+#include "Catch2/catch_amalgamated.hpp"
+
+#include <random>
+
+using namespace RS;
+
+namespace
+{
+    struct Instance
+    {
+        float x;
+        float y;
+        uint32 color;
+    };
+
+    // Applies the dirty ranges of a copy to a mirror of it, like Commit does with the mapped buffer.
+    uint64 Apply(InstanceStreamData& data, uint32 copy, std::vector<uint8>& mirror)
+    {
+        std::vector<InstanceStreamData::Range> ranges;
+        data.TakeDirtyRanges(copy, ranges);
+
+        mirror.resize(std::max<uint64>(mirror.size(), data.GetSize()));
+        uint64 bytes = 0;
+        for (const InstanceStreamData::Range& range : ranges)
+        {
+            REQUIRE(range.offset + range.size <= data.GetSize());
+            std::memcpy(mirror.data() + range.offset, data.GetData() + range.offset, range.size);
+            bytes += range.size;
+        }
+        return bytes;
+    }
+
+    bool Matches(const InstanceStreamData& data, const std::vector<uint8>& mirror)
+    {
+        return std::memcmp(data.GetData(), mirror.data(), data.GetSize()) == 0;
+    }
+}
+
+TEST_CASE("InstanceStreamData tracks dirty ranges", "[InstanceStream]")
+{
+    const uint32 count = InstanceStreamData::BlockSize * 100;
+    InstanceStreamData data(sizeof(Instance), 3);
+    data.Resize(count);
+    REQUIRE(data.GetSize() == count * sizeof(Instance));
+
+    // New instances are uploaded to every copy.
+    std::vector<std::vector<uint8>> mirrors(3);
+    for (uint32 copy = 0; copy < 3; ++copy)
+        REQUIRE(Apply(data, copy, mirrors[copy]) == data.GetSize());
+    std::vector<uint8>& mirror = mirrors[0];
+
+    SECTION("Writing the same data uploads nothing")
+    {
+        const Instance instance = {};
+        for (uint32 i = 0; i < count; ++i)
+            data.Write(i, &instance);
+        REQUIRE(Apply(data, 0, mirror) == 0);
+    }
+
+    SECTION("Only the blocks with changes are uploaded, adjacent ones merged")
+    {
+        const Instance instance = { 1.f, 2.f, 0xFF00FF00 };
+        data.Write(3, &instance);
+        data.Write(InstanceStreamData::BlockSize * 4, &instance);
+        data.Write(InstanceStreamData::BlockSize * 5 + 1, &instance);
+
+        std::vector<InstanceStreamData::Range> ranges;
+        data.TakeDirtyRanges(0, ranges);
+        const uint64 blockBytes = InstanceStreamData::BlockSize * sizeof(Instance);
+        REQUIRE(ranges.size() == 2);
+        REQUIRE(ranges[0].offset == 0);
+        REQUIRE(ranges[0].size == blockBytes);
+        REQUIRE(ranges[1].offset == blockBytes * 4);
+        REQUIRE(ranges[1].size == blockBytes * 2);
+
+        // Taken once per copy.
+        data.TakeDirtyRanges(0, ranges);
+        REQUIRE(ranges.empty());
+        data.TakeDirtyRanges(1, ranges);
+        REQUIRE(ranges.size() == 2);
+    }
+
+    SECTION("Every copy ends up with the latest data")
+    {
+        std::mt19937 rng(3);
+        std::uniform_int_distribution<uint32> index(0, count - 1);
+        for (uint32 frame = 0; frame < 20; ++frame)
+        {
+            for (uint32 i = 0; i < 30; ++i)
+            {
+                const Instance instance = { (float)frame, (float)i, rng() };
+                data.Write(index(rng), &instance);
+            }
+
+            // A partial last block, and instances that come back zeroed after shrinking.
+            if (frame == 7)
+                data.Resize(count - 10);
+            if (frame == 12)
+                data.Resize(count);
+
+            const uint32 copy = frame % 3;
+            REQUIRE(Apply(data, copy, mirrors[copy]) < data.GetSize());
+            REQUIRE(Matches(data, mirrors[copy]));
+        }
+    }
+
+    SECTION("A recreated copy gets everything")
+    {
+        data.MarkCopyDirty(1);
+        REQUIRE(Apply(data, 1, mirrors[1]) == data.GetSize());
+        REQUIRE(Apply(data, 2, mirrors[2]) == 0);
+        REQUIRE(Apply(data, 0, mirror) == 0);
+    }
+
+    SECTION("Out of range")
+    {
+        const Instance instance = {};
+        REQUIRE_THROWS(data.Write(count, &instance));
+        REQUIRE_THROWS(data.MarkDirty(count - 1, 2));
+        std::vector<InstanceStreamData::Range> ranges;
+        REQUIRE_THROWS(data.TakeDirtyRanges(3, ranges));
+    }
+}
+
+TEST_CASE("PackedInstance2D packs to 16 bytes", "[InstanceStream]")
+{
+    REQUIRE(sizeof(PackedInstance2D) == 16);
+
+    const PackedInstance2D instance = PackedInstance2D::Pack(1.5f, -2.f, 0.5f, 2.f, 1.f, 0.f, 0.5f, 2);
+    REQUIRE(instance.x == 1.5f);
+    REQUIRE(instance.y == -2.f);
+    REQUIRE((instance.size & 0xFFFF) == 0x3800);   // 0.5 as a half float.
+    REQUIRE((instance.size >> 16) == 0x4000);      // 2.0 as a half float.
+    REQUIRE((instance.colorAndType & 0xFF) == 0xFF);
+    REQUIRE(((instance.colorAndType >> 8) & 0xFF) == 0);
+    REQUIRE(((instance.colorAndType >> 16) & 0xFF) == 128);
+    REQUIRE((instance.colorAndType >> 24) == 2);
+}
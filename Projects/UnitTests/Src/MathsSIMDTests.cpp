@@ -0,0 +1,259 @@
+#define RS_THROW_INSTEAD_OF_ASSERT
+
+#include "RSEngine.h"
+#include "Maths/RSVector.h"
+#include "Maths/RSMatrix.h"
+#include "Maths/GLMDefines.h"
+#include <glm/glm.hpp>
+#include "Catch2/catch_amalgamated.hpp"
+
+#include <random>
+
+using namespace RS;
+
+namespace
+{
+    using Mat4d = Mat<double, 4, 4>;
+    using Vec4d = Vec<double, 4>;
+
+    // Diagonally dominant, so the inverse is well conditioned.
+    Mat4 CreateRandomMat4(std::mt19937& rng)
+    {
+        std::uniform_real_distribution<float> value(-1.f, 1.f);
+        Mat4 mat;
+        for (uint32 row = 0; row < 4; ++row)
+        {
+            for (uint32 col = 0; col < 4; ++col)
+                mat.At(row, col) = value(rng) + (row == col ? 4.f : 0.f);
+        }
+        return mat;
+    }
+
+    Vec4 CreateRandomVec4(std::mt19937& rng)
+    {
+        std::uniform_real_distribution<float> value(-10.f, 10.f);
+        Vec4 result;
+        for (uint32 i = 0; i < 4; ++i)
+            result[i] = value(rng);
+        return result;
+    }
+
+    // The double matrices take the scalar path.
+    void CheckMat4(const Mat4& mat, const Mat4d& expected)
+    {
+        for (uint32 row = 0; row < 4; ++row)
+        {
+            for (uint32 col = 0; col < 4; ++col)
+                REQUIRE(mat.AtConst(row, col) == Catch::Approx(expected.AtConst(row, col)).epsilon(1e-5).margin(1e-5));
+        }
+    }
+
+    void CheckVec4(const Vec4& v, const Vec4d& expected)
+    {
+        for (uint32 i = 0; i < 4; ++i)
+            REQUIRE(v.AtConst(i) == Catch::Approx(expected.AtConst(i)).epsilon(1e-5).margin(1e-4));
+    }
+
+    glm::mat4 ToGLM(const Mat4& mat)
+    {
+        glm::mat4 result;
+        for (uint32 row = 0; row < 4; ++row)
+        {
+            for (uint32 col = 0; col < 4; ++col)
+                result[col][row] = mat.AtConst(row, col);
+        }
+        return result;
+    }
+}
+
+TEST_CASE("Mat4 SIMD matches the scalar path", "[MathsSIMD]")
+{
+    std::mt19937 rng(7);
+    for (uint32 i = 0; i < 100; ++i)
+    {
+        const Mat4 a = CreateRandomMat4(rng);
+        const Mat4 b = CreateRandomMat4(rng);
+        const Mat4d ad = a;
+        const Mat4d bd = b;
+
+        CheckMat4(a * b, ad * bd);
+        CheckMat4(Transpose(a), Transpose(ad));
+        CheckMat4(Inverse(a), Inverse(ad));
+        CheckMat4(a * Inverse(a), Mat4d::IDENTITY);
+
+        Mat4 c = a;
+        c *= b;
+        CheckMat4(c, ad * bd);
+
+        const Vec4 v = CreateRandomVec4(rng);
+        CheckVec4(Transform(a, v), Transform(ad, Vec4d(v)));
+    }
+
+    SECTION("Same layout as glm")
+    {
+        const Mat4 a = CreateRandomMat4(rng);
+        const Mat4 b = CreateRandomMat4(rng);
+        const Vec4 v = CreateRandomVec4(rng);
+        const glm::mat4 product = ToGLM(a) * ToGLM(b);
+        const glm::mat4 inverse = glm::inverse(ToGLM(a));
+        const glm::vec4 transformed = ToGLM(a) * glm::vec4(v.x, v.y, v.z, v.w);
+        const Mat4 rsProduct = a * b;
+        const Mat4 rsInverse = Inverse(a);
+        const Vec4 rsTransformed = Transform(a, v);
+        for (uint32 row = 0; row < 4; ++row)
+        {
+            for (uint32 col = 0; col < 4; ++col)
+            {
+                REQUIRE(rsProduct.AtConst(row, col) == Catch::Approx(product[col][row]).epsilon(1e-5));
+                REQUIRE(rsInverse.AtConst(row, col) == Catch::Approx(inverse[col][row]).epsilon(1e-4).margin(1e-5));
+            }
+            REQUIRE(rsTransformed.AtConst(row) == Catch::Approx(transformed[row]).epsilon(1e-5));
+        }
+    }
+
+    SECTION("Batches")
+    {
+        const Mat4 mat = CreateRandomMat4(rng);
+        std::vector<Vec4> points(37);
+        for (Vec4& point : points)
+            point = CreateRandomVec4(rng);
+
+        std::vector<Vec4> transformed(points.size());
+        TransformBatch(mat, points.data(), transformed.data(), points.size());
+        for (uint64 i = 0; i < points.size(); ++i)
+            CheckVec4(transformed[i], Transform(Mat4d(mat), Vec4d(points[i])));
+
+        // In place.
+        TransformBatch(mat, points.data(), points.data(), points.size());
+        for (uint64 i = 0; i < points.size(); ++i)
+        {
+            for (uint32 j = 0; j < 4; ++j)
+                REQUIRE(points[i][j] == transformed[i][j]);
+        }
+    }
+
+    SECTION("Singular")
+    {
+        Mat4 singular = CreateRandomMat4(rng);
+        for (uint32 col = 0; col < 4; ++col)
+            singular.At(3, col) = singular.AtConst(1, col) * 2.f;
+        REQUIRE_THROWS(Inverse(singular));
+    }
+}
+
+TEST_CASE("Vec4 SIMD matches the scalar path", "[MathsSIMD]")
+{
+    using Vec4f = RS_New::VecNew<4u, float>;
+    using Vec4dNew = RS_New::VecNew<4u, double>;
+
+    auto Check = [](const Vec4f& v, const Vec4dNew& expected)
+    {
+        for (uint32 i = 0; i < 4; ++i)
+            REQUIRE(v[i] == Catch::Approx(expected[i]).epsilon(1e-6));
+    };
+
+    std::mt19937 rng(11);
+    for (uint32 i = 0; i < 100; ++i)
+    {
+        // b is kept away from zero for the division.
+        const Vec4 randomA = CreateRandomVec4(rng);
+        const Vec4 randomB = CreateRandomVec4(rng) + 20.f;
+        const Vec4f a(4u, &randomA.values[0]);
+        const Vec4f b(4u, &randomB.values[0]);
+        const Vec4dNew ad(a);
+        const Vec4dNew bd(b);
+
+        Check(a + b, ad + bd);
+        Check(a - b, ad - bd);
+        Check(a * b, ad * bd);
+        Check(a / b, ad / bd);
+        Check(a * 3.f, ad * 3.0);
+        Check(a / 3.f, ad / 3.0);
+        Check(a.Normalize(), ad.Normalize());
+        REQUIRE(a.Dot(b) == Catch::Approx(ad.Dot(bd)).epsilon(1e-5));
+        REQUIRE(a.Length2() == Catch::Approx(ad.Length2()).epsilon(1e-6));
+        REQUIRE(a.Normalize().Length<float>() == Catch::Approx(1.f));
+    }
+}
+
+// Hidden by default, run with: UnitTests.exe "[benchmark]"
+TEST_CASE("Maths SIMD speed", "[.][benchmark][MathsSIMD]")
+{
+    const uint32 count = 4096;
+    std::mt19937 rng(3);
+    std::vector<Mat4> mats(count);
+    std::vector<glm::mat4> glmMats(count);
+    for (uint32 i = 0; i < count; ++i)
+    {
+        mats[i] = CreateRandomMat4(rng);
+        glmMats[i] = ToGLM(mats[i]);
+    }
+
+    BENCHMARK(Utils::Format("RS Mat4 multiply x{}", count))
+    {
+        Mat4 result = Mat4::IDENTITY;
+        for (const Mat4& mat : mats)
+            result = result * mat;
+        return result;
+    };
+    BENCHMARK(Utils::Format("glm mat4 multiply x{}", count))
+    {
+        glm::mat4 result(1.f);
+        for (const glm::mat4& mat : glmMats)
+            result = result * mat;
+        return result;
+    };
+
+    BENCHMARK(Utils::Format("RS Mat4 transpose x{}", count))
+    {
+        float sum = 0.f;
+        for (const Mat4& mat : mats)
+            sum += Transpose(mat).AtConst(0, 1);
+        return sum;
+    };
+    BENCHMARK(Utils::Format("glm mat4 transpose x{}", count))
+    {
+        float sum = 0.f;
+        for (const glm::mat4& mat : glmMats)
+            sum += glm::transpose(mat)[1][0];
+        return sum;
+    };
+
+    BENCHMARK(Utils::Format("RS Mat4 inverse x{}", count))
+    {
+        float sum = 0.f;
+        for (const Mat4& mat : mats)
+            sum += Inverse(mat).AtConst(0, 0);
+        return sum;
+    };
+    BENCHMARK(Utils::Format("glm mat4 inverse x{}", count))
+    {
+        float sum = 0.f;
+        for (const glm::mat4& mat : glmMats)
+            sum += glm::inverse(mat)[0][0];
+        return sum;
+    };
+
+    const uint32 pointCount = 1'000'000;
+    std::vector<Vec4> points(pointCount);
+    std::vector<glm::vec4> glmPoints(pointCount);
+    for (uint32 i = 0; i < pointCount; ++i)
+    {
+        points[i] = CreateRandomVec4(rng);
+        glmPoints[i] = glm::vec4(points[i].x, points[i].y, points[i].z, points[i].w);
+    }
+    std::vector<Vec4> transformed(pointCount);
+    std::vector<glm::vec4> glmTransformed(pointCount);
+
+    BENCHMARK(Utils::Format("RS Mat4 transform batch of {} points", pointCount))
+    {
+        TransformBatch(mats[0], points.data(), transformed.data(), pointCount);
+        return transformed.back().x;
+    };
+    BENCHMARK(Utils::Format("glm mat4 transform of {} points", pointCount))
+    {
+        for (uint32 i = 0; i < pointCount; ++i)
+            glmTransformed[i] = glmMats[0] * glmPoints[i];
+        return glmTransformed.back()[0];
+    };
+}
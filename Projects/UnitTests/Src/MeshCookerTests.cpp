@@ -0,0 +1,327 @@
+#define RS_THROW_INSTEAD_OF_ASSERT
+
+#include "RSEngine.h"
+#include "Core/VFS.h"
+#include "Loaders/openfbx/FBXLoader.h"
+#include "Loaders/Mesh/MeshFile.h"
+#include "Loaders/Mesh/MeshCooker.h"
+#include "Catch2/catch_amalgamated.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <cmath>
+
+using namespace RS;
+
+namespace
+{
+    Vertex MakeVertex(float x, float y, float z, float nx, float ny, float nz, float u, float v)
+    {
+        Vertex vertex;
+        vertex.position = Vec3(x, y, z);
+        vertex.normal = Vec3(nx, ny, nz);
+        vertex.uv = Vec2(u, v);
+        return vertex;
+    }
+
+    // Unindexed, the way the FBX loader outputs it. Each face has its own normal, so the corners are only shared within a face.
+    Mesh CreateCubeSoup()
+    {
+        const float faces[6][3] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+        Mesh mesh;
+        for (const float* n : faces)
+        {
+            // Two axes spanning the face.
+            const float a[3] = { n[1] != 0 || n[2] != 0 ? 1.f : 0.f, n[0] != 0 ? 1.f : 0.f, 0.f };
+            const float b[3] = { n[1] * a[2] - n[2] * a[1], n[2] * a[0] - n[0] * a[2], n[0] * a[1] - n[1] * a[0] };
+            auto corner = [&](float s, float t)
+            {
+                return MakeVertex(n[0] + a[0] * s + b[0] * t, n[1] + a[1] * s + b[1] * t, n[2] + a[2] * s + b[2] * t, n[0], n[1], n[2], (s + 1) * 0.5f, (t + 1) * 0.5f);
+            };
+            const Vertex corners[4] = { corner(-1, -1), corner(1, -1), corner(1, 1), corner(-1, 1) };
+            for (uint32 i : { 0, 1, 2, 0, 2, 3 })
+                mesh.vertices.push_back(corners[i]);
+        }
+        return mesh;
+    }
+
+    // A bumpy grid, gridSize x gridSize quads.
+    Mesh CreateGridSoup(uint32 gridSize)
+    {
+        Mesh mesh;
+        auto gridVertex = [&](uint32 x, uint32 y)
+        {
+            const float fx = (float)x / gridSize;
+            const float fy = (float)y / gridSize;
+            const float height = 0.3f * std::sin(fx * 7.f) * std::cos(fy * 5.f);
+            const float dx = 0.3f * 7.f * std::cos(fx * 7.f) * std::cos(fy * 5.f);
+            const float dy = -0.3f * 5.f * std::sin(fx * 7.f) * std::sin(fy * 5.f);
+            const float length = std::sqrt(dx * dx + dy * dy + 1.f);
+            return MakeVertex(fx * 10.f - 5.f, height, fy * 10.f - 5.f, -dx / length, 1.f / length, -dy / length, fx * 4.f, fy * 4.f);
+        };
+        for (uint32 y = 0; y < gridSize; ++y)
+        {
+            for (uint32 x = 0; x < gridSize; ++x)
+            {
+                const Vertex v00 = gridVertex(x, y), v10 = gridVertex(x + 1, y), v11 = gridVertex(x + 1, y + 1), v01 = gridVertex(x, y + 1);
+                mesh.vertices.insert(mesh.vertices.end(), { v00, v01, v11, v00, v11, v10 });
+            }
+        }
+        return mesh;
+    }
+
+    float Distance(const Vec3& a, const Vec3& b)
+    {
+        const float dx = a.x - b.x, dy = a.y - b.y, dz = a.z - b.z;
+        return std::sqrt(dx * dx + dy * dy + dz * dz);
+    }
+}
+
+TEST_CASE("Mesh indexing", "[MeshCooker]")
+{
+    const Mesh soup = CreateCubeSoup();
+    REQUIRE(soup.vertices.size() == 36);
+
+    const Mesh indexed = MeshCooker::Index(soup);
+    CHECK(indexed.vertices.size() == 24);
+    REQUIRE(indexed.indices.size() == 36);
+    for (uint64 i = 0; i < soup.vertices.size(); ++i)
+        CHECK(std::memcmp(&indexed.vertices[indexed.indices[i]], &soup.vertices[i], sizeof(Vertex)) == 0);
+
+    // Indexing an indexed mesh does not change it.
+    const Mesh again = MeshCooker::Index(indexed);
+    CHECK(again.vertices.size() == indexed.vertices.size());
+    CHECK(again.indices == indexed.indices);
+
+    SECTION("Grid")
+    {
+        const Mesh grid = MeshCooker::Index(CreateGridSoup(32));
+        CHECK(grid.vertices.size() == 33 * 33);
+        CHECK(grid.indices.size() == 32 * 32 * 6);
+    }
+}
+
+TEST_CASE("Mesh tangents", "[MeshCooker]")
+{
+    SECTION("Cube faces follow the UVs")
+    {
+        const Mesh cube = MeshCooker::Index(CreateCubeSoup());
+        const std::vector<Vec4> tangents = MeshCooker::GenerateTangents(cube);
+        REQUIRE(tangents.size() == cube.vertices.size());
+        for (uint64 i = 0; i < cube.vertices.size(); ++i)
+        {
+            const Vec3 tangent(tangents[i].x, tangents[i].y, tangents[i].z);
+            CHECK(std::abs(tangent.Length() - 1.f) < 1e-4f);
+            CHECK(std::abs(tangent.Dot(cube.vertices[i].normal)) < 1e-4f);
+            CHECK(std::abs(tangents[i].w) == 1.f);
+        }
+
+        // The +Z face has u along +X and v along +Y.
+        for (uint64 i = 0; i < cube.vertices.size(); ++i)
+        {
+            if (cube.vertices[i].normal.z > 0.5f)
+            {
+                CHECK(tangents[i].x > 0.999f);
+                CHECK(tangents[i].w == 1.f);
+            }
+        }
+    }
+
+    SECTION("Mirrored UVs flip the handedness")
+    {
+        Mesh mesh;
+        mesh.vertices = { MakeVertex(0, 0, 0, 0, 0, 1, 0, 0), MakeVertex(1, 0, 0, 0, 0, 1, 1, 0), MakeVertex(0, 1, 0, 0, 0, 1, 0, 1) };
+        mesh.indices = { 0, 1, 2 };
+        CHECK(MeshCooker::GenerateTangents(mesh)[0].w == 1.f);
+
+        for (Vertex& vertex : mesh.vertices)
+            vertex.uv.x = 1.f - vertex.uv.x;
+        const std::vector<Vec4> mirrored = MeshCooker::GenerateTangents(mesh);
+        CHECK(mirrored[0].x < -0.999f);
+        CHECK(mirrored[0].w == -1.f);
+    }
+
+    SECTION("Degenerate UVs still give a tangent")
+    {
+        Mesh mesh;
+        mesh.vertices = { MakeVertex(0, 0, 0, 0, 1, 0, 0, 0), MakeVertex(1, 0, 0, 0, 1, 0, 0, 0), MakeVertex(0, 0, 1, 0, 1, 0, 0, 0) };
+        mesh.indices = { 0, 1, 2 };
+        const Vec4 tangent = MeshCooker::GenerateTangents(mesh)[0];
+        CHECK(std::abs(tangent.x * tangent.x + tangent.y * tangent.y + tangent.z * tangent.z - 1.f) < 1e-4f);
+        CHECK(std::abs(tangent.y) < 1e-4f);
+    }
+
+    SECTION("Missing normals are generated")
+    {
+        Mesh mesh;
+        mesh.vertices = { MakeVertex(0, 0, 0, 0, 0, 0, 0, 0), MakeVertex(0, 0, 1, 0, 0, 0, 1, 0), MakeVertex(1, 0, 0, 0, 0, 0, 0, 1) };
+        mesh.indices = { 0, 1, 2 };
+        MeshCooker::GenerateMissingNormals(mesh);
+        for (const Vertex& vertex : mesh.vertices)
+            CHECK(vertex.normal.y > 0.999f);
+    }
+}
+
+TEST_CASE("Cooked mesh files", "[MeshCooker]")
+{
+    MeshCookSettings settings;
+    settings.optimize = false;
+    const Mesh grid = MeshCooker::Index(CreateGridSoup(32));
+    const std::vector<uint8> file = MeshCooker::CookMesh(grid, settings, 0x1234567890ULL);
+
+    CookedMeshView view;
+    REQUIRE(MeshFile::Parse(file, view));
+    CHECK(view.cookHash == 0x1234567890ULL);
+    CHECK(view.indexSize == 2);
+    REQUIRE(view.vertices.size() == grid.vertices.size());
+    REQUIRE(view.GetIndexCount() == grid.indices.size());
+    REQUIRE(view.lods.size() == 1);
+    CHECK(view.lods[0].indexCount == grid.indices.size());
+    // The data is a view into the file and aligned for the upload.
+    CHECK((const uint8*)view.vertices.data() >= file.data());
+    CHECK((((const uint8*)view.vertices.data() - file.data()) % 16) == 0);
+    CHECK(((view.indices.data() - file.data()) % 16) == 0);
+    CHECK(file.size() < grid.vertices.size() * sizeof(Vertex) + grid.indices.size() * sizeof(uint32));
+
+    std::vector<Vec4> tangents;
+    const Mesh decoded = MeshFile::Decode(view, &tangents);
+    CHECK(decoded.indices == grid.indices);
+
+    // Positions are 16 bits over a 10 unit box, normals are octahedral 16 bits and UVs are halfs.
+    float maxPositionError = 0.f, maxNormalError = 0.f, maxUVError = 0.f;
+    for (uint64 i = 0; i < grid.vertices.size(); ++i)
+    {
+        maxPositionError = std::max(maxPositionError, Distance(decoded.vertices[i].position, grid.vertices[i].position));
+        maxNormalError = std::max(maxNormalError, Distance(decoded.vertices[i].normal, grid.vertices[i].normal));
+        maxUVError = std::max(maxUVError, std::max(std::abs(decoded.vertices[i].uv.x - grid.vertices[i].uv.x), std::abs(decoded.vertices[i].uv.y - grid.vertices[i].uv.y)));
+        CHECK(std::abs(tangents[i].x * decoded.vertices[i].normal.x + tangents[i].y * decoded.vertices[i].normal.y + tangents[i].z * decoded.vertices[i].normal.z) < 0.02f);
+    }
+    CHECK(maxPositionError < 10.f / 65535.f);
+    CHECK(maxNormalError < 1e-4f);
+    CHECK(maxUVError <= 4.f / 2048.f);
+
+    SECTION("Normals in every octant")
+    {
+        const float bounds[3] = { 0.f, 0.f, 0.f };
+        for (float x : { -0.8f, -0.1f, 0.f, 0.3f })
+        {
+            for (float y : { -0.5f, 0.f, 0.9f })
+            {
+                for (float z : { -0.7f, 0.f, 0.2f })
+                {
+                    const float length = std::sqrt(x * x + y * y + z * z);
+                    if (length == 0.f)
+                        continue;
+                    const Vertex vertex = MakeVertex(0, 0, 0, x / length, y / length, z / length, 0, 0);
+                    const Vertex result = MeshFile::DecodeVertex(MeshFile::EncodeVertex(vertex, Vec4(1.f, 0.f, 0.f, 1.f), bounds, bounds), bounds, bounds);
+                    CHECK(Distance(result.normal, vertex.normal) < 1e-4f);
+                }
+            }
+        }
+    }
+
+    SECTION("Large meshes use 32 bit indices")
+    {
+        const Mesh large = MeshCooker::Index(CreateGridSoup(256));
+        REQUIRE(large.vertices.size() > 0xFFFF);
+        const std::vector<uint8> largeFile = MeshCooker::CookMesh(large, settings);
+        REQUIRE(MeshFile::Parse(largeFile, view));
+        CHECK(view.indexSize == 4);
+        CHECK(view.cookHash == 0);
+        CHECK(MeshFile::Decode(view).indices == large.indices);
+    }
+
+    SECTION("Optimized meshes have LODs")
+    {
+        settings.optimize = true;
+        const std::vector<uint8> optimizedFile = MeshCooker::CookMesh(grid, settings);
+        REQUIRE(MeshFile::Parse(optimizedFile, view));
+        REQUIRE(view.lods.size() > 1);
+        CHECK(view.lods[0].firstIndex == 0);
+        CHECK(view.lods[0].indexCount == grid.indices.size());
+        for (uint64 i = 1; i < view.lods.size(); ++i)
+        {
+            CHECK(view.lods[i].firstIndex == view.lods[i - 1].firstIndex + view.lods[i - 1].indexCount);
+            CHECK(view.lods[i].indexCount < view.lods[i - 1].indexCount);
+            CHECK(view.lods[i].error <= settings.optimizer.lodMaxError);
+        }
+        CHECK(view.GetIndexCount() == view.lods.back().firstIndex + view.lods.back().indexCount);
+        CHECK(view.vertices.size() == grid.vertices.size());
+    }
+
+    SECTION("Truncated files are rejected")
+    {
+        CHECK_FALSE(MeshFile::Parse(std::span<const uint8>(file.data(), file.size() - 1), view));
+        CHECK_FALSE(MeshFile::Parse(std::span<const uint8>(file.data(), 16), view));
+    }
+}
+
+TEST_CASE("Mesh cooking is skipped when nothing changed", "[MeshCooker]")
+{
+    const std::string modelPath = Engine::GetDataFilePath(true) + RS_MODEL_PATH;
+    const std::string directory = Engine::GetTempFilePath() + "MeshCookerTests/";
+    std::filesystem::create_directories(directory);
+    const std::string sourcePath = directory + "Suzanne.fbx";
+    const std::string cookedPath = MeshCooker::GetCookedPath(sourcePath);
+    CHECK(cookedPath == directory + "Suzanne.rsmesh");
+    std::filesystem::remove(cookedPath);
+    std::filesystem::copy_file(modelPath + "Suzanne.fbx", sourcePath, std::filesystem::copy_options::overwrite_existing);
+
+    MeshCookSettings settings;
+
+    CHECK(MeshCooker::Cook(sourcePath, cookedPath, settings) == MeshCooker::Result::Cooked);
+    CHECK(MeshCooker::Cook(sourcePath, cookedPath, settings) == MeshCooker::Result::UpToDate);
+    CHECK(MeshCooker::Cook(sourcePath, cookedPath, settings, true) == MeshCooker::Result::Cooked);
+
+    settings.optimizer.lodCount = 2;
+    CHECK(MeshCooker::Cook(sourcePath, cookedPath, settings) == MeshCooker::Result::Cooked);
+    CHECK(MeshCooker::Cook(sourcePath, cookedPath, settings) == MeshCooker::Result::UpToDate);
+
+    std::shared_ptr<CookedMesh> pMesh = CookedMesh::Load(cookedPath);
+    REQUIRE(pMesh);
+    std::unique_ptr<Mesh> pSource(FBXLoader::Load("Suzanne.fbx", true));
+    REQUIRE(pSource);
+    CHECK(pMesh->GetView().lods[0].indexCount == pSource->vertices.size());
+    CHECK(pMesh->GetView().vertices.size() < pSource->vertices.size());
+    pMesh.reset();
+
+    CHECK(MeshCooker::Cook(directory + "Missing.fbx", cookedPath, settings) == MeshCooker::Result::Failed);
+}
+
+// Hidden by default, run with: UnitTests.exe "[benchmark]"
+TEST_CASE("Mesh import and cooked load", "[.][benchmark][MeshCooker]")
+{
+    const std::string directory = Engine::GetTempFilePath() + "MeshCookerTests/";
+    std::filesystem::create_directories(directory);
+
+    for (const char* pName : { "Terrain.fbx", "Boxhouse.fbx" })
+    {
+        std::unique_ptr<Mesh> pSource(FBXLoader::Load(pName, true));
+        REQUIRE(pSource);
+        const Mesh indexed = MeshCooker::Index(*pSource);
+
+        const std::string cookedPath = MeshCooker::GetCookedPath(directory + pName);
+        REQUIRE(MeshCooker::Cook(Engine::GetDataFilePath(true) + RS_MODEL_PATH + pName, cookedPath, MeshCookSettings(), true) == MeshCooker::Result::Cooked);
+        const uint64 cookedSize = std::filesystem::file_size(cookedPath);
+
+        BENCHMARK(Utils::Format("{} FBX import, {} vertices, {} KiB", pName, pSource->vertices.size(), pSource->vertices.size() * sizeof(Vertex) / 1024))
+        {
+            return std::unique_ptr<Mesh>(FBXLoader::Load(pName, true))->vertices.size();
+        };
+
+        BENCHMARK(Utils::Format("{} cook, {} -> {} vertices", pName, pSource->vertices.size(), indexed.vertices.size()))
+        {
+            return MeshCooker::CookMesh(*pSource, MeshCookSettings()).size();
+        };
+
+        BENCHMARK(Utils::Format("{} cooked load, {} vertices, {} indices, {} KiB", pName, indexed.vertices.size(), indexed.indices.size(), cookedSize / 1024))
+        {
+            std::shared_ptr<CookedMesh> pMesh = CookedMesh::Load(cookedPath);
+            // Touch the data like an upload would.
+            uint64 sum = 0;
+            for (const CookedVertex& vertex : pMesh->GetView().vertices)
+                sum += vertex.position[0];
+            return sum + pMesh->GetView().indices.size();
+        };
+    }
+}
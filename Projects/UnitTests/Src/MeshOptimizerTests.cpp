@@ -0,0 +1,276 @@
+#define RS_THROW_INSTEAD_OF_ASSERT
+
+#include "RSEngine.h"
+#include "Loaders/openfbx/FBXLoader.h"
+#include "Loaders/Mesh/MeshCooker.h"
+#include "Loaders/Mesh/MeshOptimizer.h"
+#include "Catch2/catch_amalgamated.hpp"
+#include "MeshTestUtils.h"
+
+#include <array>
+#include <map>
+
+using namespace RS;
+using namespace RS::MeshTestUtils;
+
+namespace
+{
+    // The same triangles, compared by the vertices instead of the indices.
+    std::vector<std::array<uint32, 3>> GetTrianglesByVertex(const Mesh& mesh, const Mesh& reference)
+    {
+        using VertexBytes = std::array<uint8, sizeof(Vertex)>;
+        std::map<VertexBytes, uint32> referenceVertices;
+        for (uint32 v = 0; v < (uint32)reference.vertices.size(); ++v)
+        {
+            VertexBytes bytes;
+            std::memcpy(bytes.data(), &reference.vertices[v], sizeof(Vertex));
+            referenceVertices.emplace(bytes, v);
+        }
+
+        std::vector<uint32> referenceIndices(mesh.indices.size());
+        for (uint64 i = 0; i < mesh.indices.size(); ++i)
+        {
+            VertexBytes bytes;
+            std::memcpy(bytes.data(), &mesh.vertices[mesh.indices[i]], sizeof(Vertex));
+            auto it = referenceVertices.find(bytes);
+            REQUIRE(it != referenceVertices.end());
+            referenceIndices[i] = it->second;
+        }
+        return GetCanonicalTriangles(referenceIndices);
+    }
+
+    Mesh CreateGrid(uint32 gridSize)
+    {
+        Mesh mesh;
+        for (uint32 y = 0; y <= gridSize; ++y)
+        {
+            for (uint32 x = 0; x <= gridSize; ++x)
+            {
+                Vertex vertex;
+                vertex.position = Vec3((float)x, 0.f, (float)y);
+                vertex.normal = Vec3(0.f, 1.f, 0.f);
+                vertex.uv = Vec2(0.f, 0.f);
+                mesh.vertices.push_back(vertex);
+            }
+        }
+        for (uint32 y = 0; y < gridSize; ++y)
+        {
+            for (uint32 x = 0; x < gridSize; ++x)
+            {
+                const uint32 v00 = y * (gridSize + 1) + x;
+                const uint32 v10 = v00 + 1;
+                const uint32 v01 = v00 + gridSize + 1;
+                const uint32 v11 = v01 + 1;
+                mesh.indices.insert(mesh.indices.end(), { v00, v01, v11, v00, v11, v10 });
+            }
+        }
+        return mesh;
+    }
+}
+
+TEST_CASE("Vertex cache analysis", "[MeshOptimizer]")
+{
+    const std::vector<uint32> triangle = { 0, 1, 2 };
+    VertexCacheStats stats = MeshOptimizer::AnalyzeVertexCache(triangle, 3);
+    CHECK(stats.vertexTransforms == 3);
+    CHECK(stats.acmr == 3.f);
+    CHECK(stats.atvr == 1.f);
+
+    // The second triangle only adds one vertex. Hits do not move vertices in a FIFO, so the third triangle misses all of them.
+    const std::vector<uint32> strip = { 0, 1, 2, 2, 1, 3, 0, 1, 2 };
+    stats = MeshOptimizer::AnalyzeVertexCache(strip, 4, 3);
+    CHECK(stats.vertexTransforms == 7);
+    CHECK(stats.atvr == 7.f / 4.f);
+
+    const VertexFetchStats fetch = MeshOptimizer::AnalyzeVertexFetch(triangle, 3, 16);
+    CHECK(fetch.bytesFetched == 64);
+    CHECK(fetch.overfetch == 64.f / 48.f);
+}
+
+TEST_CASE("Vertex cache optimization", "[MeshOptimizer]")
+{
+    for (const char* pName : { "Suzanne.fbx", "Terrain.fbx", "Boxhouse.fbx", "Barrel.fbx" })
+    {
+        INFO(pName);
+        const Mesh mesh = LoadIndexed(pName);
+        const uint32 vertexCount = (uint32)mesh.vertices.size();
+
+        std::vector<uint32> indices = mesh.indices;
+        MeshOptimizer::OptimizeVertexCache(indices, vertexCount);
+        CHECK(GetCanonicalTriangles(indices) == GetCanonicalTriangles(mesh.indices));
+
+        const VertexCacheStats before = MeshOptimizer::AnalyzeVertexCache(mesh.indices, vertexCount);
+        const VertexCacheStats after = MeshOptimizer::AnalyzeVertexCache(indices, vertexCount);
+        CHECK(after.acmr <= before.acmr);
+        CHECK(after.atvr < 1.5f);
+
+        std::vector<uint32> again = mesh.indices;
+        MeshOptimizer::OptimizeVertexCache(again, vertexCount);
+        CHECK(again == indices);
+    }
+
+    SECTION("Grid")
+    {
+        // A grid in row order misses every vertex of the row above again, the optimized order gets close to the 0.5 limit.
+        const Mesh grid = CreateGrid(64);
+        std::vector<uint32> indices = grid.indices;
+        MeshOptimizer::OptimizeVertexCache(indices, (uint32)grid.vertices.size());
+        CHECK(MeshOptimizer::AnalyzeVertexCache(grid.indices, (uint32)grid.vertices.size()).acmr > 0.95f);
+        CHECK(MeshOptimizer::AnalyzeVertexCache(indices, (uint32)grid.vertices.size()).acmr < 0.75f);
+    }
+}
+
+TEST_CASE("Overdraw optimization", "[MeshOptimizer]")
+{
+    for (const char* pName : { "Suzanne.fbx", "Boxhouse.fbx", "Barrel.fbx" })
+    {
+        INFO(pName);
+        const Mesh mesh = LoadIndexed(pName);
+        const uint32 vertexCount = (uint32)mesh.vertices.size();
+
+        std::vector<uint32> indices = mesh.indices;
+        MeshOptimizer::OptimizeVertexCache(indices, vertexCount);
+        const VertexCacheStats before = MeshOptimizer::AnalyzeVertexCache(indices, vertexCount);
+
+        std::vector<uint32> reordered = indices;
+        MeshOptimizer::OptimizeOverdraw(reordered, mesh.vertices, 1.05f);
+        CHECK(GetCanonicalTriangles(reordered) == GetCanonicalTriangles(mesh.indices));
+        // The clusters start with a cold cache, so the ACMR can get somewhat worse than the threshold.
+        CHECK(MeshOptimizer::AnalyzeVertexCache(reordered, vertexCount).acmr <= before.acmr * 1.2f);
+
+        std::vector<uint32> again = indices;
+        MeshOptimizer::OptimizeOverdraw(again, mesh.vertices, 1.05f);
+        CHECK(again == reordered);
+    }
+}
+
+TEST_CASE("Vertex fetch optimization", "[MeshOptimizer]")
+{
+    for (const char* pName : { "Suzanne.fbx", "Terrain.fbx" })
+    {
+        INFO(pName);
+        const Mesh mesh = LoadIndexed(pName);
+        Mesh optimized = mesh;
+        MeshOptimizer::OptimizeVertexCache(optimized.indices, (uint32)optimized.vertices.size());
+        const VertexFetchStats before = MeshOptimizer::AnalyzeVertexFetch(optimized.indices, (uint32)optimized.vertices.size(), sizeof(Vertex));
+
+        MeshOptimizer::OptimizeVertexFetch(optimized);
+        const VertexFetchStats after = MeshOptimizer::AnalyzeVertexFetch(optimized.indices, (uint32)optimized.vertices.size(), sizeof(Vertex));
+        CHECK(after.overfetch <= before.overfetch);
+        CHECK(optimized.vertices.size() == mesh.vertices.size());
+
+        // The vertices are in the order they are first used.
+        uint32 nextVertex = 0;
+        for (uint32 index : optimized.indices)
+        {
+            CHECK(index <= nextVertex);
+            if (index == nextVertex)
+                nextVertex++;
+        }
+        CHECK(GetTrianglesByVertex(optimized, mesh) == GetCanonicalTriangles(mesh.indices));
+    }
+
+    SECTION("Unused vertices are removed")
+    {
+        Mesh mesh = CreateGrid(2);
+        mesh.indices = { 8, 4, 5 };
+        MeshOptimizer::OptimizeVertexFetch(mesh);
+        CHECK(mesh.vertices.size() == 3);
+        CHECK(mesh.indices == std::vector<uint32>{ 0, 1, 2 });
+        CHECK(mesh.vertices[0].position.x == 2.f);
+    }
+}
+
+TEST_CASE("Mesh simplification", "[MeshOptimizer]")
+{
+    SECTION("A flat grid keeps its outline")
+    {
+        const Mesh grid = CreateGrid(16);
+        float error = 1.f;
+        const std::vector<uint32> simplified = MeshOptimizer::Simplify(grid.indices, grid.vertices, 6, 0.01f, &error);
+        CHECK(simplified.size() <= grid.indices.size() / 8);
+        CHECK(error < 1e-4f);
+
+        // Only border vertices move along the border, so the area stays the same.
+        float area = 0.f;
+        for (uint64 i = 0; i < simplified.size(); i += 3)
+        {
+            const Vec3& p0 = grid.vertices[simplified[i]].position;
+            const Vec3& p1 = grid.vertices[simplified[i + 1]].position;
+            const Vec3& p2 = grid.vertices[simplified[i + 2]].position;
+            const float cross = (p1.z - p0.z) * (p2.x - p0.x) - (p1.x - p0.x) * (p2.z - p0.z);
+            CHECK(cross > 0.f);
+            area += cross * 0.5f;
+        }
+        CHECK(std::abs(area - 16.f * 16.f) < 1e-3f);
+    }
+
+    for (const char* pName : { "Suzanne.fbx", "Terrain.fbx", "Boxhouse.fbx" })
+    {
+        INFO(pName);
+        const Mesh mesh = LoadIndexed(pName);
+        const uint32 targetIndexCount = (uint32)(mesh.indices.size() / 6) * 3;
+
+        float error = 0.f;
+        const std::vector<uint32> simplified = MeshOptimizer::Simplify(mesh.indices, mesh.vertices, targetIndexCount, 0.05f, &error);
+        CHECK(simplified.size() % 3 == 0);
+        CHECK(simplified.size() < mesh.indices.size());
+        CHECK(error <= 0.05f);
+        for (uint64 i = 0; i < simplified.size(); i += 3)
+        {
+            CHECK(simplified[i] < mesh.vertices.size());
+            CHECK(simplified[i] != simplified[i + 1]);
+            CHECK(simplified[i + 1] != simplified[i + 2]);
+            CHECK(simplified[i] != simplified[i + 2]);
+        }
+
+        float againError = 0.f;
+        CHECK(MeshOptimizer::Simplify(mesh.indices, mesh.vertices, targetIndexCount, 0.05f, &againError) == simplified);
+        CHECK(againError == error);
+
+        // Nothing moves without an error budget, except collapses that cost nothing.
+        float zeroError = 1.f;
+        MeshOptimizer::Simplify(mesh.indices, mesh.vertices, targetIndexCount, 0.f, &zeroError);
+        CHECK(zeroError == 0.f);
+    }
+}
+
+TEST_CASE("Mesh optimization pipeline", "[MeshOptimizer]")
+{
+    for (const char* pName : { "Suzanne.fbx", "Terrain.fbx", "Boxhouse.fbx" })
+    {
+        INFO(pName);
+        Mesh mesh = LoadIndexed(pName);
+        const Mesh original = mesh;
+
+        MeshOptimizerSettings settings;
+        MeshOptimizerReport report;
+        const std::vector<MeshLOD> lods = MeshOptimizer::Optimize(mesh, settings, &report);
+        REQUIRE(!lods.empty());
+        REQUIRE(lods.size() <= settings.lodCount);
+        CHECK(lods[0].firstIndex == 0);
+        CHECK(lods[0].indexCount == original.indices.size());
+        CHECK(lods.back().firstIndex + lods.back().indexCount == mesh.indices.size());
+        CHECK(GetTrianglesByVertex(Mesh{ mesh.vertices, std::vector<uint32>(mesh.indices.begin(), mesh.indices.begin() + lods[0].indexCount) }, original)
+            == GetCanonicalTriangles(original.indices));
+
+        REQUIRE(report.stages.size() == lods.size() + 2);
+        CHECK(report.stages[0].name == "Vertex cache");
+        CHECK(report.stages[0].cacheAfter.acmr <= report.stages[0].cacheBefore.acmr);
+        CHECK(report.stages[1].name == "Overdraw");
+        CHECK(report.stages.back().name == "Vertex fetch");
+        CHECK(report.stages.back().fetchAfter.overfetch <= report.stages.back().fetchBefore.overfetch);
+        CHECK(report.stages.back().cacheAfter.vertexTransforms == report.stages.back().cacheBefore.vertexTransforms);
+        for (uint64 i = 1; i < lods.size(); ++i)
+        {
+            CHECK(lods[i].indexCount < lods[i - 1].indexCount);
+            CHECK(lods[i].error <= settings.lodMaxError);
+            CHECK(report.stages[i + 1].name == Utils::Format("LOD {}", i));
+        }
+
+        Mesh again = original;
+        CHECK(MeshOptimizer::Optimize(again, settings).size() == lods.size());
+        CHECK(again.indices == mesh.indices);
+        CHECK(std::memcmp(again.vertices.data(), mesh.vertices.data(), mesh.vertices.size() * sizeof(Vertex)) == 0);
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "RSEngine.h"
+#include "Loaders/openfbx/FBXLoader.h"
+#include "Loaders/Mesh/MeshCooker.h"
+#include "Catch2/catch_amalgamated.hpp"
+
+#include <array>
+
+namespace RS::MeshTestUtils
+{
+    inline Mesh LoadIndexed(const std::string& name)
+    {
+        std::unique_ptr<Mesh> pMesh(FBXLoader::Load(name, true));
+        REQUIRE(pMesh);
+        return MeshCooker::Index(*pMesh);
+    }
+
+    // Each triangle rotated to start at its smallest index, which keeps the winding, then sorted.
+    inline std::vector<std::array<uint32, 3>> GetCanonicalTriangles(std::span<const uint32> indices)
+    {
+        std::vector<std::array<uint32, 3>> triangles;
+        for (uint64 i = 0; i < indices.size(); i += 3)
+        {
+            std::array<uint32, 3> triangle = { indices[i], indices[i + 1], indices[i + 2] };
+            while (triangle[0] != std::min({ triangle[0], triangle[1], triangle[2] }))
+                std::rotate(triangle.begin(), triangle.begin() + 1, triangle.end());
+            triangles.push_back(triangle);
+        }
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    }
+}
@@ -0,0 +1,336 @@
+#define RS_THROW_INSTEAD_OF_ASSERT
+
+#include "RSEngine.h"
+#include "Loaders/openfbx/FBXLoader.h"
+#include "Loaders/Mesh/MeshCooker.h"
+#include "Loaders/Mesh/MeshletBuilder.h"
+#include "Maths/GLMDefines.h"
+#include "Catch2/catch_amalgamated.hpp"
+#include "MeshTestUtils.h"
+
+#include <array>
+#include <glm/glm.hpp>
+#include <random>
+
+using namespace RS;
+using namespace RS::MeshTestUtils;
+
+namespace
+{
+    // Indexed and optimized the way the cooker does it, so the meshlets are built from the same order.
+    Mesh LoadOptimized(const std::string& name)
+    {
+        Mesh mesh = LoadIndexed(name);
+        MeshOptimizerSettings settings;
+        settings.lodCount = 1;
+        MeshOptimizer::Optimize(mesh, settings);
+        return mesh;
+    }
+
+    Mesh CreateGrid(uint32 gridSize)
+    {
+        Mesh mesh;
+        for (uint32 y = 0; y <= gridSize; ++y)
+        {
+            for (uint32 x = 0; x <= gridSize; ++x)
+            {
+                Vertex vertex;
+                vertex.position = Vec3((float)x, 0.f, (float)y);
+                vertex.normal = Vec3(0.f, 1.f, 0.f);
+                vertex.uv = Vec2(0.f, 0.f);
+                mesh.vertices.push_back(vertex);
+            }
+        }
+        for (uint32 y = 0; y < gridSize; ++y)
+        {
+            for (uint32 x = 0; x < gridSize; ++x)
+            {
+                const uint32 v00 = y * (gridSize + 1) + x;
+                const uint32 v10 = v00 + 1;
+                const uint32 v01 = v00 + gridSize + 1;
+                const uint32 v11 = v01 + 1;
+                mesh.indices.insert(mesh.indices.end(), { v00, v01, v11, v00, v11, v10 });
+            }
+        }
+        return mesh;
+    }
+
+    std::vector<uint32> GetMeshletIndices(const MeshletData& data, const Meshlet& meshlet)
+    {
+        std::vector<uint32> indices;
+        for (uint32 i = 0; i < meshlet.triangleCount; ++i)
+        {
+            const uint32 triangle = data.triangles[meshlet.triangleOffset + i];
+            for (uint32 corner = 0; corner < 3; ++corner)
+                indices.push_back(data.vertices[meshlet.vertexOffset + MeshletBuilder::UnpackIndex(triangle, corner)]);
+        }
+        return indices;
+    }
+
+    void CheckBounds(const MeshletBounds& bounds, std::span<const uint32> indices, std::span<const Vertex> vertices, std::mt19937& random)
+    {
+        const glm::vec3 center(bounds.center[0], bounds.center[1], bounds.center[2]);
+        for (uint32 index : indices)
+            REQUIRE(glm::length(glm::vec3(vertices[index].position) - center) <= bounds.radius * (1.f + 1e-5f) + 1e-6f);
+
+        // Every camera the cone culls must be behind every triangle.
+        std::uniform_real_distribution<float> offset(-4.f, 4.f);
+        const float scale = std::max(bounds.radius, 1e-3f);
+        for (uint32 i = 0; i < 64; ++i)
+        {
+            const glm::vec3 camera = center + glm::vec3(offset(random), offset(random), offset(random)) * scale;
+            if (!MeshletBuilder::IsBackfacing(bounds, Vec3(camera.x, camera.y, camera.z)))
+                continue;
+
+            for (uint64 t = 0; t < indices.size(); t += 3)
+            {
+                const glm::vec3 p0 = vertices[indices[t]].position;
+                const glm::vec3 normal = glm::cross(glm::vec3(vertices[indices[t + 1]].position) - p0, glm::vec3(vertices[indices[t + 2]].position) - p0);
+                const glm::vec3 toTriangle = p0 - camera;
+                REQUIRE(glm::dot(toTriangle, normal) >= -1e-4f * glm::length(toTriangle) * glm::length(normal));
+            }
+        }
+    }
+
+    // Coverage, limits and bounds of the meshlets of one index list.
+    void CheckMeshlets(const MeshletData& data, std::span<const uint32> indices, std::span<const Vertex> vertices, const MeshletSettings& settings)
+    {
+        REQUIRE(data.bounds.size() == data.meshlets.size());
+
+        std::vector<uint32> meshletIndices;
+        uint32 expectedVertexOffset = 0;
+        uint32 expectedTriangleOffset = 0;
+        std::mt19937 random(1234);
+        for (const Meshlet& meshlet : data.meshlets)
+        {
+            // Tightly packed, in order.
+            REQUIRE(meshlet.vertexOffset == expectedVertexOffset);
+            REQUIRE(meshlet.triangleOffset == expectedTriangleOffset);
+            expectedVertexOffset += meshlet.vertexCount;
+            expectedTriangleOffset += meshlet.triangleCount;
+
+            REQUIRE(meshlet.triangleCount > 0);
+            REQUIRE(meshlet.triangleCount <= settings.maxTriangles);
+            REQUIRE(meshlet.vertexCount <= settings.maxVertices);
+
+            // Every vertex of a meshlet is different and used.
+            std::vector<uint8> isUsed(meshlet.vertexCount, 0);
+            for (uint32 i = 0; i < meshlet.triangleCount; ++i)
+            {
+                for (uint32 corner = 0; corner < 3; ++corner)
+                {
+                    const uint32 local = MeshletBuilder::UnpackIndex(data.triangles[meshlet.triangleOffset + i], corner);
+                    REQUIRE(local < meshlet.vertexCount);
+                    isUsed[local] = 1;
+                }
+            }
+            CHECK(std::count(isUsed.begin(), isUsed.end(), 1) == meshlet.vertexCount);
+            std::vector<uint32> meshletVertices(data.vertices.begin() + meshlet.vertexOffset, data.vertices.begin() + meshlet.vertexOffset + meshlet.vertexCount);
+            std::sort(meshletVertices.begin(), meshletVertices.end());
+            CHECK(std::adjacent_find(meshletVertices.begin(), meshletVertices.end()) == meshletVertices.end());
+
+            const std::vector<uint32> triangles = GetMeshletIndices(data, meshlet);
+            CheckBounds(data.bounds[&meshlet - data.meshlets.data()], triangles, vertices, random);
+            meshletIndices.insert(meshletIndices.end(), triangles.begin(), triangles.end());
+        }
+        CHECK(expectedVertexOffset == data.vertices.size());
+        CHECK(expectedTriangleOffset == data.triangles.size());
+
+        // Every triangle is in exactly one meshlet, with the same winding.
+        CHECK(GetCanonicalTriangles(meshletIndices) == GetCanonicalTriangles(indices));
+    }
+}
+
+TEST_CASE("Meshlet building", "[Meshlets]")
+{
+    const MeshletSettings settings;
+
+    SECTION("Grid")
+    {
+        const Mesh grid = CreateGrid(32);
+        const MeshletData data = MeshletBuilder::Build({ grid.indices, grid.vertices }, settings);
+        CheckMeshlets(data, grid.indices, grid.vertices, settings);
+
+        // A flat grid only reuses vertices inside a meshlet, so they should be close to full.
+        CHECK(data.meshlets.size() <= 2 * (grid.indices.size() / 3 + settings.maxTriangles - 1) / settings.maxTriangles);
+        CHECK((float)data.vertices.size() / data.meshlets.size() > 0.75f * settings.maxVertices);
+    }
+
+    for (const char* pName : { "Suzanne.fbx", "Terrain.fbx", "Boxhouse.fbx", "Barrel.fbx" })
+    {
+        DYNAMIC_SECTION(pName)
+        {
+            const Mesh mesh = LoadOptimized(pName);
+            const MeshletData data = MeshletBuilder::Build({ mesh.indices, mesh.vertices }, settings);
+            CheckMeshlets(data, mesh.indices, mesh.vertices, settings);
+
+            // Each vertex is in about one meshlet, the ones on the borders between meshlets are in more.
+            CHECK(data.vertices.size() < 2 * mesh.vertices.size());
+        }
+    }
+
+    SECTION("Small limits")
+    {
+        const Mesh mesh = LoadOptimized("Suzanne.fbx");
+        MeshletSettings smallSettings;
+        smallSettings.maxVertices = 3;
+        smallSettings.maxTriangles = 1;
+        const MeshletData data = MeshletBuilder::Build({ mesh.indices, mesh.vertices }, smallSettings);
+        CHECK(data.meshlets.size() == mesh.indices.size() / 3);
+        CheckMeshlets(data, mesh.indices, mesh.vertices, smallSettings);
+
+        smallSettings.maxVertices = 16;
+        smallSettings.maxTriangles = 256;
+        CheckMeshlets(MeshletBuilder::Build({ mesh.indices, mesh.vertices }, smallSettings), mesh.indices, mesh.vertices, smallSettings);
+    }
+
+    SECTION("Limits of mesh shaders")
+    {
+        const Mesh grid = CreateGrid(2);
+        MeshletSettings invalidSettings;
+        invalidSettings.maxVertices = 257;
+        CHECK_THROWS(MeshletBuilder::Build({ grid.indices, grid.vertices }, invalidSettings));
+        invalidSettings.maxVertices = 64;
+        invalidSettings.maxTriangles = 0;
+        CHECK_THROWS(MeshletBuilder::Build({ grid.indices, grid.vertices }, invalidSettings));
+    }
+
+    SECTION("Empty")
+    {
+        const Mesh grid = CreateGrid(2);
+        CHECK(MeshletBuilder::Build({ std::span<const uint32>(), grid.vertices }).meshlets.empty());
+    }
+}
+
+TEST_CASE("Meshlet culling", "[Meshlets]")
+{
+    const Mesh grid = CreateGrid(16);
+    const MeshletData data = MeshletBuilder::Build({ grid.indices, grid.vertices });
+    REQUIRE_FALSE(data.meshlets.empty());
+
+    // The grid faces up, so every meshlet is culled from below and none from above. A flat meshlet has a 90 degree cone.
+    for (const MeshletBounds& bounds : data.bounds)
+    {
+        CHECK(bounds.coneCutoff <= 1);
+        CHECK(bounds.coneAxis[1] == 127);
+        CHECK(MeshletBuilder::IsBackfacing(bounds, Vec3(8.f, -10.f, 8.f)));
+        CHECK_FALSE(MeshletBuilder::IsBackfacing(bounds, Vec3(8.f, 10.f, 8.f)));
+        CHECK_FALSE(MeshletBuilder::IsBackfacing(bounds, Vec3(8.f, 1e-3f, 8.f)));
+    }
+
+    SECTION("Triangles facing every way are never culled")
+    {
+        const std::vector<uint32> indices = { 0, 1, 2, 0, 2, 1 };
+        const MeshletBounds bounds = MeshletBuilder::ComputeBounds(indices, grid.vertices);
+        CHECK(bounds.coneCutoff == 127);
+        CHECK_FALSE(MeshletBuilder::IsBackfacing(bounds, Vec3(0.f, -10.f, 0.f)));
+        CHECK_FALSE(MeshletBuilder::IsBackfacing(bounds, Vec3(0.f, 10.f, 0.f)));
+    }
+}
+
+TEST_CASE("Meshlets are built in parallel", "[Meshlets]")
+{
+    std::vector<Mesh> meshes;
+    for (const char* pName : { "Suzanne.fbx", "Terrain.fbx", "Boxhouse.fbx", "Barrel.fbx" })
+        meshes.push_back(LoadOptimized(pName));
+
+    std::vector<MeshletSource> sources;
+    for (const Mesh& mesh : meshes)
+        sources.push_back({ mesh.indices, mesh.vertices });
+
+    const std::vector<MeshletData> results = MeshletBuilder::Build(sources);
+    REQUIRE(results.size() == meshes.size());
+    for (uint64 i = 0; i < meshes.size(); ++i)
+    {
+        const MeshletData serial = MeshletBuilder::Build(sources[i]);
+        REQUIRE(results[i].meshlets.size() == serial.meshlets.size());
+        CHECK(results[i].vertices == serial.vertices);
+        CHECK(results[i].triangles == serial.triangles);
+        CHECK(std::memcmp(results[i].bounds.data(), serial.bounds.data(), serial.bounds.size() * sizeof(MeshletBounds)) == 0);
+    }
+}
+
+TEST_CASE("Cooked meshlets", "[Meshlets]")
+{
+    std::unique_ptr<Mesh> pSource(FBXLoader::Load("Suzanne.fbx", true));
+    REQUIRE(pSource);
+    const MeshCookSettings settings;
+    const std::vector<uint8> file = MeshCooker::CookMesh(*pSource, settings);
+
+    CookedMeshView view;
+    REQUIRE(MeshFile::Parse(file, view));
+    REQUIRE_FALSE(view.meshlets.empty());
+    REQUIRE(view.meshletBounds.size() == view.meshlets.size());
+    CHECK((((const uint8*)view.meshlets.data() - file.data()) % 16) == 0);
+    CHECK((((const uint8*)view.meshletBounds.data() - file.data()) % 16) == 0);
+    CHECK((((const uint8*)view.meshletVertices.data() - file.data()) % 16) == 0);
+    CHECK((((const uint8*)view.meshletTriangles.data() - file.data()) % 16) == 0);
+
+    MeshletData data;
+    data.meshlets.assign(view.meshlets.begin(), view.meshlets.end());
+    data.bounds.assign(view.meshletBounds.begin(), view.meshletBounds.end());
+    data.vertices.assign(view.meshletVertices.begin(), view.meshletVertices.end());
+    data.triangles.assign(view.meshletTriangles.begin(), view.meshletTriangles.end());
+
+    // The meshlets of each LOD cover its triangles, and the bounds fit the quantized positions.
+    const Mesh decoded = MeshFile::Decode(view);
+    uint32 nextMeshlet = 0;
+    for (const MeshLOD& lod : view.lods)
+    {
+        REQUIRE(lod.firstMeshlet == nextMeshlet);
+        REQUIRE(lod.meshletCount > 0);
+        nextMeshlet += lod.meshletCount;
+
+        MeshletData lodData;
+        for (uint32 i = lod.firstMeshlet; i < lod.firstMeshlet + lod.meshletCount; ++i)
+        {
+            MeshletData single;
+            const Meshlet& meshlet = data.meshlets[i];
+            single.meshlets.push_back({ 0, 0, meshlet.vertexCount, meshlet.triangleCount });
+            single.bounds.push_back(data.bounds[i]);
+            single.vertices.assign(data.vertices.begin() + meshlet.vertexOffset, data.vertices.begin() + meshlet.vertexOffset + meshlet.vertexCount);
+            single.triangles.assign(data.triangles.begin() + meshlet.triangleOffset, data.triangles.begin() + meshlet.triangleOffset + meshlet.triangleCount);
+            MeshletBuilder::Append(lodData, single);
+        }
+        CheckMeshlets(lodData, std::span<const uint32>(decoded.indices).subspan(lod.firstIndex, lod.indexCount), decoded.vertices, settings.meshlets);
+    }
+    CHECK(nextMeshlet == view.meshlets.size());
+
+    SECTION("Without meshlets")
+    {
+        MeshCookSettings noMeshletSettings;
+        noMeshletSettings.buildMeshlets = false;
+        const std::vector<uint8> noMeshletFile = MeshCooker::CookMesh(*pSource, noMeshletSettings);
+        REQUIRE(MeshFile::Parse(noMeshletFile, view));
+        CHECK(view.meshlets.empty());
+        CHECK(view.lods[0].meshletCount == 0);
+        CHECK(MeshCooker::ComputeCookHash({}, noMeshletSettings) != MeshCooker::ComputeCookHash({}, settings));
+    }
+}
+
+// Hidden by default, run with: UnitTests.exe "[benchmark]"
+TEST_CASE("Meshlet building speed", "[.][benchmark][Meshlets]")
+{
+    std::vector<Mesh> meshes;
+    std::vector<MeshletSource> sources;
+    for (const char* pName : { "Terrain.fbx", "Boxhouse.fbx", "Suzanne.fbx", "Barrel.fbx" })
+        meshes.push_back(LoadOptimized(pName));
+    for (const Mesh& mesh : meshes)
+        sources.push_back({ mesh.indices, mesh.vertices });
+
+    for (uint64 i = 0; i < meshes.size(); ++i)
+    {
+        const MeshletData data = MeshletBuilder::Build(sources[i]);
+        const uint64 cullableCount = std::count_if(data.bounds.begin(), data.bounds.end(), [](const MeshletBounds& bounds) { return bounds.coneCutoff < 127; });
+        BENCHMARK(Utils::Format("{} triangles, {} meshlets, {} vertices and {} triangles on average, {} with a cone", meshes[i].indices.size() / 3, data.meshlets.size(),
+            data.vertices.size() / data.meshlets.size(), data.triangles.size() / data.meshlets.size(), cullableCount))
+        {
+            return MeshletBuilder::Build(sources[i]).meshlets.size();
+        };
+    }
+
+    BENCHMARK(Utils::Format("{} meshes in parallel", meshes.size()))
+    {
+        return MeshletBuilder::Build(sources).size();
+    };
+}
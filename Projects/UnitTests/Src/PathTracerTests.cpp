@@ -0,0 +1,373 @@
+#define RS_THROW_INSTEAD_OF_ASSERT
+
+#include "RSEngine.h"
+#include "Loaders/openfbx/FBXLoader.h"
+#include "Loaders/Mesh/MeshCooker.h"
+#include "Render/PathTracer.h"
+#include "Core/VFS.h"
+#include "Catch2/catch_amalgamated.hpp"
+
+#include <filesystem>
+
+using namespace RS;
+
+namespace
+{
+    // The triangle EngineLoop::BuildGeometry gives the DXR path, clockwise seen from z = 0.
+    Mesh CreateDXRTriangle(bool reverseWinding = false)
+    {
+        Mesh mesh;
+        for (const Vec3& position : { Vec3(0.f, -1.f, 1.f), Vec3(-1.f, 1.f, 1.f), Vec3(1.f, 1.f, 1.f) })
+        {
+            Vertex vertex;
+            vertex.position = position;
+            mesh.vertices.push_back(vertex);
+        }
+        mesh.indices = reverseWinding ? std::vector<uint32>{ 0, 2, 1 } : std::vector<uint32>{ 0, 1, 2 };
+        return mesh;
+    }
+
+    // A square at depth z facing -z.
+    Mesh CreateQuad(float size, float z)
+    {
+        Mesh mesh;
+        for (const Vec3& position : { Vec3(-size, -size, z), Vec3(size, -size, z), Vec3(size, size, z), Vec3(-size, size, z) })
+        {
+            Vertex vertex;
+            vertex.position = position;
+            vertex.normal = Vec3(0.f, 0.f, -1.f);
+            mesh.vertices.push_back(vertex);
+        }
+        mesh.indices = { 0, 2, 1, 0, 3, 2 };
+        return mesh;
+    }
+
+    ReferenceImage CreateTestImage(uint32 width, uint32 height)
+    {
+        ReferenceImage image(width, height);
+        for (uint32 y = 0; y < height; ++y)
+        {
+            for (uint32 x = 0; x < width; ++x)
+            {
+                float* pPixel = image.GetPixel(x, y);
+                pPixel[0] = (float)x / width;
+                pPixel[1] = (float)y / height;
+                pPixel[2] = x == y ? 10.f : -0.5f;
+                pPixel[3] = 1.f;
+            }
+        }
+        return image;
+    }
+
+    PathTracerCamera CreateCamera(const PathTracerScene& scene)
+    {
+        const AABB& bounds = scene.GetBounds();
+        PathTracerCamera camera;
+        camera.isPerspective = true;
+        camera.position[0] = (bounds.min[0] + bounds.max[0]) * 0.5f;
+        camera.position[1] = bounds.max[1] + (bounds.max[1] - bounds.min[1]) * 0.5f;
+        camera.position[2] = bounds.min[2] - (bounds.max[2] - bounds.min[2]) * 1.5f;
+        camera.forward[1] = -0.4f;
+        return camera;
+    }
+
+    void CreateModelScene(PathTracerScene& scene, const std::string& name)
+    {
+        std::unique_ptr<Mesh> pMesh(FBXLoader::Load(name, true));
+        REQUIRE(pMesh);
+        const uint32 mesh = scene.AddMesh(MeshCooker::Index(*pMesh));
+        const uint32 material = scene.AddMaterial(PathTracerMaterial());
+        scene.AddInstance(mesh, material);
+        scene.Build();
+    }
+
+    PathTracerSettings CreateLitSettings()
+    {
+        PathTracerSettings settings;
+        settings.samplesPerPixel = 4;
+        settings.skyColor[0] = 0.3f;
+        settings.skyColor[1] = 0.4f;
+        settings.skyColor[2] = 0.5f;
+        settings.sunDirection[0] = 0.3f;
+        settings.sunDirection[2] = -0.5f;
+        settings.sunColor[0] = settings.sunColor[1] = settings.sunColor[2] = 2.f;
+        return settings;
+    }
+}
+
+TEST_CASE("Reference image files and diffs", "[PathTracer]")
+{
+    const ReferenceImage image = CreateTestImage(37, 21);
+
+    SECTION("EXR round trip")
+    {
+        ReferenceImage result;
+        REQUIRE(ReferenceImage::DecodeEXR(image.EncodeEXR(), result));
+        REQUIRE(result.GetWidth() == 37);
+        REQUIRE(result.GetHeight() == 21);
+        CHECK(std::equal(result.GetData().begin(), result.GetData().end(), image.GetData().begin()));
+
+        const std::string directory = Engine::GetTempFilePath() + "PathTracerTests/";
+        std::filesystem::remove_all(directory);
+        REQUIRE(image.WriteEXR(directory + "Image.exr"));
+        REQUIRE(ReferenceImage::ReadEXR(directory + "Image.exr", result));
+        CHECK(ReferenceImage::Compare(result, image).badPixelCount == 0);
+        CHECK(image.WritePNG(directory + "Image.png"));
+        {
+            std::shared_ptr<VFSFile> pPNG = VFS::Get()->Open(directory + "Image.png");
+            REQUIRE(pPNG);
+            REQUIRE(pPNG->GetData().size() >= 8);
+            CHECK(std::memcmp(pPNG->GetData().data(), "\x89PNG", 4) == 0);
+        }
+        std::filesystem::remove_all(directory);
+    }
+
+    SECTION("Bad EXR data")
+    {
+        std::vector<uint8> data = image.EncodeEXR();
+        ReferenceImage result;
+        CHECK_FALSE(ReferenceImage::DecodeEXR(std::span<const uint8>(data).first(data.size() / 2), result));
+        CHECK_FALSE(ReferenceImage::DecodeEXR(std::span<const uint8>(data).first(100), result));
+        data[0] = 0;
+        CHECK_FALSE(ReferenceImage::DecodeEXR(data, result));
+        CHECK_FALSE(ReferenceImage::DecodeEXR({}, result));
+    }
+
+    SECTION("Compare")
+    {
+        ImageDiffResult result = ReferenceImage::Compare(image, image);
+        CHECK(result.passed);
+        CHECK(result.badPixelCount == 0);
+        CHECK(result.maxError == 0.f);
+        CHECK(result.psnr == FLT_MAX);
+
+        ReferenceImage changed = image;
+        changed.GetPixel(3, 4)[1] += 0.5f;
+        changed.GetPixel(5, 6)[0] += 1.f / 255.f;
+        ReferenceImage diffImage;
+        result = ReferenceImage::Compare(changed, image, ImageDiffSettings(), &diffImage);
+        CHECK_FALSE(result.passed);
+        CHECK(result.badPixelCount == 1);
+        CHECK(result.maxError == Catch::Approx(0.5f));
+        CHECK(result.psnr > 20.f);
+        CHECK(diffImage.GetPixel(3, 4)[1] == Catch::Approx(0.5f));
+        CHECK(diffImage.GetPixel(3, 4)[3] == 1.f);
+        CHECK(diffImage.GetPixel(0, 0)[0] == 0.f);
+
+        ImageDiffSettings settings;
+        settings.maxBadPixelRatio = 0.01f;
+        CHECK(ReferenceImage::Compare(changed, image, settings).passed);
+        settings.tolerance = 0.5f;
+        settings.maxBadPixelRatio = 0.f;
+        CHECK(ReferenceImage::Compare(changed, image, settings).passed);
+
+        changed.GetPixel(0, 0)[2] = std::nanf("");
+        CHECK_FALSE(ReferenceImage::Compare(changed, image, settings).passed);
+        CHECK_FALSE(ReferenceImage::Compare(CreateTestImage(36, 21), image).isSameSize);
+    }
+}
+
+TEST_CASE("Path tracer matches the DXR shaders", "[PathTracer]")
+{
+    // Stencil from EngineLoop::UpdateForSizeChange with a square window.
+    PathTracerCamera camera;
+    camera.rayGen.stencil = { -0.9f, -0.9f, 0.9f, 0.9f };
+    PathTracerSettings settings;
+    settings.mode = PathTracerMode::Barycentrics;
+
+    auto render = [&](const Mesh& mesh)
+    {
+        PathTracerScene scene;
+        scene.AddInstance(scene.AddMesh(mesh), scene.AddMaterial(PathTracerMaterial()));
+        scene.Build();
+        PathTracer tracer;
+        tracer.Resize(64, 48);
+        tracer.Render(scene, camera, settings);
+        return tracer.GetImage();
+    };
+
+    const ReferenceImage image = render(CreateDXRTriangle());
+    uint32 hitCount = 0, stencilCount = 0;
+    for (uint32 y = 0; y < image.GetHeight(); ++y)
+    {
+        for (uint32 x = 0; x < image.GetWidth(); ++x)
+        {
+            const float lerpX = (float)x / image.GetWidth(), lerpY = (float)y / image.GetHeight();
+            const float originX = -1.f + 2.f * lerpX, originY = -1.f + 2.f * lerpY;
+            const float* pPixel = image.GetPixel(x, y);
+            CHECK(pPixel[3] == 1.f);
+            if (std::abs(originX) > 0.9f || std::abs(originY) > 0.9f)
+            {
+                stencilCount++;
+                CHECK(pPixel[0] == Catch::Approx(lerpX));
+                CHECK(pPixel[1] == Catch::Approx(lerpY));
+                CHECK(pPixel[2] == 0.f);
+                continue;
+            }
+
+            const float u = ((originY + 1.f) * 0.5f - originX) * 0.5f;
+            const float v = ((originY + 1.f) * 0.5f + originX) * 0.5f;
+            const float w = 1.f - u - v;
+            if (std::min({ u, v, w }) < -1e-4f)
+            {
+                CHECK(pPixel[0] == 0.f);
+                CHECK(pPixel[1] == 0.f);
+                CHECK(pPixel[2] == 0.f);
+            }
+            else if (std::min({ u, v, w }) > 1e-4f)
+            {
+                hitCount++;
+                CHECK(pPixel[0] == Catch::Approx(w).margin(1e-5));
+                CHECK(pPixel[1] == Catch::Approx(u).margin(1e-5));
+                CHECK(pPixel[2] == Catch::Approx(v).margin(1e-5));
+            }
+        }
+    }
+    CHECK(hitCount > 500);
+    CHECK(stencilCount > 500);
+
+    // The TraceRay call culls back faces.
+    const ReferenceImage backFacing = render(CreateDXRTriangle(true));
+    CHECK(backFacing.GetPixel(32, 30)[0] == 0.f);
+    CHECK(backFacing.GetPixel(32, 30)[1] == 0.f);
+    settings.cullBackFacing = false;
+    const ReferenceImage twoSided = render(CreateDXRTriangle(true));
+    CHECK(twoSided.GetPixel(32, 30)[1] > 0.f);
+}
+
+TEST_CASE("Path tracer lighting", "[PathTracer]")
+{
+    // Nothing but the sky above the quad, so every sample gives the same value.
+    PathTracerScene scene;
+    PathTracerMaterial material;
+    material.albedo[0] = 0.5f;
+    material.albedo[1] = 0.25f;
+    material.albedo[2] = 1.f;
+    material.emission[2] = 0.125f;
+    scene.AddInstance(scene.AddMesh(CreateQuad(0.45f, 1.f)), scene.AddMaterial(material));
+    scene.Build();
+
+    PathTracerCamera camera;
+    PathTracerSettings settings;
+    settings.samplesPerPixel = 3;
+    settings.skyColor[0] = settings.skyColor[1] = settings.skyColor[2] = 0.25f;
+    settings.sunDirection[1] = 0.f;
+    settings.sunDirection[2] = -1.f;
+    settings.sunColor[0] = settings.sunColor[1] = settings.sunColor[2] = std::numbers::pi_v<float>;
+
+    PathTracer tracer;
+    tracer.Resize(16, 16);
+    const PathTracerStats stats = tracer.Render(scene, camera, settings);
+    const ReferenceImage image = tracer.GetImage();
+    CHECK(tracer.GetSampleCount() == 3);
+
+    // albedo * sky + albedo * sun + emission.
+    const float* pCenter = image.GetPixel(8, 8);
+    CHECK(pCenter[0] == Catch::Approx(0.5f * 0.25f + 0.5f));
+    CHECK(pCenter[1] == Catch::Approx(0.25f * 0.25f + 0.25f));
+    CHECK(pCenter[2] == Catch::Approx(0.25f + 1.f + 0.125f));
+    CHECK(pCenter[3] == 1.f);
+    const float* pSky = image.GetPixel(0, 0);
+    CHECK(pSky[0] == 0.25f);
+    CHECK(pSky[2] == 0.25f);
+
+    // Jittered samples on the quad have a camera, a bounce and a shadow ray, the rest only a camera ray.
+    CHECK(stats.rayCount >= 3 * (256 + 36 * 2));
+    CHECK(stats.rayCount <= 3 * (256 + 64 * 2));
+    CHECK(stats.threadCount >= 1);
+    CHECK(stats.GetRaysPerSecondPerCore() > 0.0);
+
+    // A sun below the horizon, and a blocker in front of the sun. Mirrored, the camera sees its back face and culls it.
+    settings.sunDirection[2] = 1.f;
+    tracer.Reset();
+    tracer.Render(scene, camera, settings);
+    CHECK(tracer.GetImage().GetPixel(8, 8)[0] == Catch::Approx(0.5f * 0.25f));
+
+    PathTracerScene shadowedScene;
+    const uint32 shadowMaterial = shadowedScene.AddMaterial(material);
+    shadowedScene.AddInstance(shadowedScene.AddMesh(CreateQuad(0.45f, 1.f)), shadowMaterial);
+    const float blockerTransform[3][4] = { { 1.f, 0.f, 0.f, 0.f }, { 0.f, 1.f, 0.f, 0.f }, { 0.f, 0.f, -1.f, 0.5f } };
+    shadowedScene.AddInstance(shadowedScene.AddMesh(CreateQuad(10.f, 0.f)), shadowMaterial, blockerTransform);
+    shadowedScene.Build();
+    settings.sunDirection[2] = -1.f;
+    settings.skyColor[0] = 0.f;
+    tracer.Reset();
+    tracer.Render(shadowedScene, camera, settings);
+    CHECK(tracer.GetImage().GetPixel(8, 8)[0] == 0.f);
+}
+
+TEST_CASE("Path tracer is deterministic and progressive", "[PathTracer]")
+{
+    PathTracerScene scene;
+    CreateModelScene(scene, "Suzanne.fbx");
+    const PathTracerCamera camera = CreateCamera(scene);
+    PathTracerSettings settings = CreateLitSettings();
+    settings.tileSize = 8;
+
+    PathTracer tracer;
+    tracer.Resize(48, 40);
+    tracer.Render(scene, camera, settings);
+    const ReferenceImage parallel = tracer.GetImage();
+
+    settings.maxThreads = 1;
+    settings.samplesPerPixel = 2;
+    tracer.Reset();
+    tracer.Render(scene, camera, settings);
+    settings.tileSize = 13;
+    tracer.Render(scene, camera, settings);
+    REQUIRE(tracer.GetSampleCount() == 4);
+    const ReferenceImage serial = tracer.GetImage();
+    CHECK(std::memcmp(serial.GetData().data(), parallel.GetData().data(), parallel.GetData().size_bytes()) == 0);
+
+    // Lit, not flat and no NaN.
+    float minValue = FLT_MAX, maxValue = 0.f;
+    for (float value : parallel.GetData())
+    {
+        REQUIRE(std::isfinite(value));
+        minValue = std::min(minValue, value);
+        maxValue = std::max(maxValue, value);
+    }
+    CHECK(minValue >= 0.f);
+    CHECK(maxValue > 0.3f);
+
+    // More samples converge, a different seed has different noise.
+    settings.samplesPerPixel = 60;
+    tracer.Render(scene, camera, settings);
+    const ReferenceImage converged = tracer.GetImage();
+    settings.seed = 1;
+    tracer.Reset();
+    tracer.Render(scene, camera, settings);
+    const ImageDiffResult noisy = ReferenceImage::Compare(parallel, converged);
+    const ImageDiffResult lessNoisy = ReferenceImage::Compare(tracer.GetImage(), converged);
+    CHECK(lessNoisy.badPixelCount > 0);
+    CHECK(lessNoisy.meanError < noisy.meanError);
+}
+
+namespace
+{
+    void RunPathTracerBenchmark(const std::string& name)
+    {
+        PathTracerScene scene;
+        CreateModelScene(scene, name);
+        const PathTracerCamera camera = CreateCamera(scene);
+        const PathTracerSettings settings = CreateLitSettings();
+
+        PathTracer tracer;
+        tracer.Resize(256, 256);
+        const PathTracerStats stats = tracer.Render(scene, camera, settings);
+
+        BENCHMARK(Utils::Format("{} 256x256, {} spp, {:.2f} Mrays/s, {:.2f} Mrays/s per core on {} threads",
+            name, settings.samplesPerPixel, stats.GetRaysPerSecond() / 1e6, stats.GetRaysPerSecondPerCore() / 1e6, stats.threadCount))
+        {
+            return tracer.Render(scene, camera, settings).rayCount;
+        };
+    }
+}
+
+// Hidden by default, run with: UnitTests.exe "[benchmark]"
+TEST_CASE("Path tracer throughput", "[.][benchmark][PathTracer]")
+{
+    RunPathTracerBenchmark("Suzanne.fbx");
+    RunPathTracerBenchmark("Terrain.fbx");
+    RunPathTracerBenchmark("Boxhouse.fbx");
+}
@@ -0,0 +1,316 @@
+#define RS_THROW_INSTEAD_OF_ASSERT
+
+#include "RSEngine.h"
+#include "DX12/Final/DXPipelineCacheIndex.h"
+#include "DX12/Final/DXPipelineKey.h"
+#include "DX12/Final/DXPipelineStateMap.h"
+#include "Catch2/catch_amalgamated.hpp"
+
+#include <atomic>
+#include <thread>
+
+using namespace RS::DX12;
+
+namespace
+{
+    const uint8 s_RootSignature[] = { 0x44, 0x58, 0x42, 0x43, 1, 2, 3, 4 };
+    const uint8 s_VertexShader[] = { 10, 11, 12, 13, 14, 15 };
+    const uint8 s_PixelShader[] = { 20, 21, 22 };
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC CreateGraphicsDesc(const std::vector<D3D12_INPUT_ELEMENT_DESC>& elements)
+    {
+        D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = {};
+        desc.VS = { s_VertexShader, sizeof(s_VertexShader) };
+        desc.PS = { s_PixelShader, sizeof(s_PixelShader) };
+        desc.SampleMask = 0xFFFFFFFF;
+        desc.RasterizerState.FillMode = D3D12_FILL_MODE_SOLID;
+        desc.RasterizerState.CullMode = D3D12_CULL_MODE_BACK;
+        desc.DepthStencilState.DepthEnable = TRUE;
+        desc.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_GREATER_EQUAL;
+        desc.DepthStencilState.StencilReadMask = 0xFF;
+        desc.InputLayout = { elements.data(), (uint32)elements.size() };
+        desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+        desc.NumRenderTargets = 1;
+        desc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+        desc.DSVFormat = DXGI_FORMAT_D32_FLOAT;
+        desc.SampleDesc.Count = 1;
+        desc.NodeMask = 1;
+        return desc;
+    }
+}
+
+TEST_CASE("Pipeline description serialization", "[PipelineCache]")
+{
+    // The names are copied into new strings, the content should matter and not the pointers.
+    std::string position = "POSITION";
+    std::string normal = "NORMAL";
+    const std::vector<D3D12_INPUT_ELEMENT_DESC> elements = {
+        { position.c_str(), 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+        { normal.c_str(), 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+    };
+    const D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = CreateGraphicsDesc(elements);
+
+    std::vector<uint8> data;
+    REQUIRE(DXPipelineDescSerializer::SerializeGraphics(desc, s_RootSignature, sizeof(s_RootSignature), data));
+
+    SECTION("Graphics round trip")
+    {
+        DXPipelineDescSerializer::GraphicsDesc result;
+        REQUIRE(DXPipelineDescSerializer::DeserializeGraphics(data, result));
+        CHECK(result.rootSignature == std::vector<uint8>(std::begin(s_RootSignature), std::end(s_RootSignature)));
+        CHECK(result.desc.VS.BytecodeLength == sizeof(s_VertexShader));
+        CHECK(std::memcmp(result.desc.VS.pShaderBytecode, s_VertexShader, sizeof(s_VertexShader)) == 0);
+        CHECK(result.desc.PS.BytecodeLength == sizeof(s_PixelShader));
+        CHECK(result.desc.GS.pShaderBytecode == nullptr);
+        CHECK(result.desc.InputLayout.NumElements == 2);
+        CHECK(std::string(result.desc.InputLayout.pInputElementDescs[1].SemanticName) == "NORMAL");
+        CHECK(result.desc.InputLayout.pInputElementDescs[1].AlignedByteOffset == 12);
+        CHECK(result.desc.DepthStencilState.DepthFunc == D3D12_COMPARISON_FUNC_GREATER_EQUAL);
+        CHECK(result.desc.RTVFormats[0] == DXGI_FORMAT_R8G8B8A8_UNORM);
+        CHECK(result.desc.DSVFormat == DXGI_FORMAT_D32_FLOAT);
+
+        // Serializing the deserialized description gives the same bytes.
+        std::vector<uint8> data2;
+        REQUIRE(DXPipelineDescSerializer::SerializeGraphics(result.desc, result.rootSignature.data(), result.rootSignature.size(), data2));
+        CHECK(data == data2);
+    }
+
+    SECTION("Wrong type and truncated data is rejected")
+    {
+        DXPipelineDescSerializer::ComputeDesc computeDesc;
+        CHECK_FALSE(DXPipelineDescSerializer::DeserializeCompute(data, computeDesc));
+
+        DXPipelineDescSerializer::GraphicsDesc result;
+        std::vector<uint8> truncated(data.begin(), data.end() - 1);
+        CHECK_FALSE(DXPipelineDescSerializer::DeserializeGraphics(truncated, result));
+    }
+}
+
+TEST_CASE("Pipeline cache index", "[PipelineCache]")
+{
+    D3D12_COMPUTE_PIPELINE_STATE_DESC computeDesc = {};
+    computeDesc.CS = { s_PixelShader, sizeof(s_PixelShader) };
+    computeDesc.NodeMask = 1;
+
+    std::vector<uint8> description;
+    REQUIRE(DXPipelineDescSerializer::SerializeCompute(computeDesc, s_RootSignature, sizeof(s_RootSignature), description));
+    const DXPipelineHash key = DXPipelineKey::FromCompute(computeDesc, s_RootSignature, sizeof(s_RootSignature)).GetHash();
+
+    DXPipelineCacheIndex index;
+    CHECK(index.Add(key, DXPipelineCacheIndex::PipelineType::Compute, "Compute PSO", description));
+    CHECK_FALSE(index.Add(key, DXPipelineCacheIndex::PipelineType::Compute, "Compute PSO", description));
+    CHECK(index.GetCount() == 1);
+
+    DXPipelineCacheIndex::DeviceIdentity identity;
+    identity.vendorID = 0x10DE;
+    identity.deviceID = 0x2684;
+    identity.driverVersion = 0x0020001E000E0F1A;
+    const std::vector<uint8> data = index.Serialize(identity);
+
+    SECTION("Round trip on the same device")
+    {
+        DXPipelineCacheIndex loaded;
+        REQUIRE(loaded.Deserialize(data.data(), data.size(), identity));
+        REQUIRE(loaded.GetCount() == 1);
+
+        const DXPipelineCacheIndex::Entry* pEntry = loaded.Find(key);
+        REQUIRE(pEntry != nullptr);
+        CHECK(pEntry->name == "Compute PSO");
+        CHECK(pEntry->type == DXPipelineCacheIndex::PipelineType::Compute);
+        CHECK(pEntry->description == description);
+
+        DXPipelineDescSerializer::ComputeDesc result;
+        REQUIRE(DXPipelineDescSerializer::DeserializeCompute(pEntry->description, result));
+        CHECK(result.desc.CS.BytecodeLength == sizeof(s_PixelShader));
+        CHECK(result.desc.NodeMask == 1);
+    }
+
+    SECTION("Other driver is rejected")
+    {
+        DXPipelineCacheIndex::DeviceIdentity newDriver = identity;
+        newDriver.driverVersion++;
+
+        DXPipelineCacheIndex loaded;
+        loaded.Add(DXPipelineHash{ .low = 1 }, DXPipelineCacheIndex::PipelineType::Graphics, "Old", {});
+        CHECK_FALSE(loaded.Deserialize(data.data(), data.size(), newDriver));
+        CHECK(loaded.GetCount() == 0);
+    }
+
+    SECTION("Corrupt file is rejected")
+    {
+        std::vector<uint8> corrupt = data;
+        corrupt[corrupt.size() / 2] ^= 0xFF;
+
+        DXPipelineCacheIndex loaded;
+        CHECK_FALSE(loaded.Deserialize(corrupt.data(), corrupt.size(), identity));
+        CHECK_FALSE(loaded.Deserialize(data.data(), data.size() - 1, identity));
+        CHECK(loaded.GetCount() == 0);
+    }
+}
+
+TEST_CASE("Pipeline key hashes content and not pointers", "[PipelineCache]")
+{
+    const std::vector<D3D12_INPUT_ELEMENT_DESC> elements = {
+        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+        { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+    };
+    const D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = CreateGraphicsDesc(elements);
+    const DXPipelineKey key = DXPipelineKey::FromGraphics(desc, s_RootSignature, sizeof(s_RootSignature));
+
+    // Same content, but every pointer in the description points to another allocation.
+    std::string position = "POSITION";
+    std::string texcoord = "TEXCOORD";
+    std::vector<D3D12_INPUT_ELEMENT_DESC> elements2 = elements;
+    elements2[0].SemanticName = position.c_str();
+    elements2[1].SemanticName = texcoord.c_str();
+    std::vector<uint8> vertexShader(std::begin(s_VertexShader), std::end(s_VertexShader));
+    std::vector<uint8> pixelShader(std::begin(s_PixelShader), std::end(s_PixelShader));
+    std::vector<uint8> rootSignature(std::begin(s_RootSignature), std::end(s_RootSignature));
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC desc2 = CreateGraphicsDesc(elements2);
+    desc2.VS = { vertexShader.data(), vertexShader.size() };
+    desc2.PS = { pixelShader.data(), pixelShader.size() };
+    desc2.pRootSignature = (ID3D12RootSignature*)0x1234; // Only the blob is part of the key.
+
+    // Padding in the state blocks should not matter. The blend state of desc is all zero, clear every member but leave the padding.
+    std::memset(&desc2.BlendState, 0xCD, sizeof(desc2.BlendState));
+    desc2.BlendState.AlphaToCoverageEnable = FALSE;
+    desc2.BlendState.IndependentBlendEnable = FALSE;
+    for (D3D12_RENDER_TARGET_BLEND_DESC& target : desc2.BlendState.RenderTarget)
+        target = { FALSE, FALSE, (D3D12_BLEND)0, (D3D12_BLEND)0, (D3D12_BLEND_OP)0, (D3D12_BLEND)0, (D3D12_BLEND)0, (D3D12_BLEND_OP)0, (D3D12_LOGIC_OP)0, 0 };
+
+    SECTION("Identical PSOs map to one entry")
+    {
+        const DXPipelineKey key2 = DXPipelineKey::FromGraphics(desc2, rootSignature.data(), rootSignature.size());
+        CHECK(key.GetHash() == key2.GetHash());
+        CHECK(key == key2);
+
+        DXPipelineStateMap map;
+        bool reserved = false;
+        ComPtr<ID3D12PipelineState>* pSlot = map.FindOrReserve(key, L"PSO", reserved);
+        CHECK(reserved);
+        CHECK(map.FindOrReserve(key2, L"PSO 2", reserved) == pSlot);
+        CHECK_FALSE(reserved);
+        CHECK(map.GetCount() == 1);
+    }
+
+    SECTION("Any state change gives another key")
+    {
+        D3D12_GRAPHICS_PIPELINE_STATE_DESC changed = desc2;
+        changed.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;
+        CHECK_FALSE(key == DXPipelineKey::FromGraphics(changed, rootSignature.data(), rootSignature.size()));
+
+        std::string normal = "NORMAL";
+        elements2[1].SemanticName = normal.c_str();
+        CHECK_FALSE(key == DXPipelineKey::FromGraphics(desc2, rootSignature.data(), rootSignature.size()));
+        elements2[1].SemanticName = texcoord.c_str();
+
+        vertexShader.back()++;
+        CHECK_FALSE(key == DXPipelineKey::FromGraphics(desc2, rootSignature.data(), rootSignature.size()));
+        vertexShader.back()--;
+
+        rootSignature.back()++;
+        CHECK_FALSE(key == DXPipelineKey::FromGraphics(desc2, rootSignature.data(), rootSignature.size()));
+        rootSignature.back()--;
+    }
+
+    SECTION("Stream output declarations are part of the key")
+    {
+        std::string positionOut = "SV_Position";
+        std::string texcoordOut = "TEXCOORD";
+        D3D12_SO_DECLARATION_ENTRY entries[] = {
+            { 0, positionOut.c_str(), 0, 0, 4, 0 },
+            { 0, texcoordOut.c_str(), 0, 0, 2, 1 },
+        };
+        UINT strides[] = { 16, 8 };
+
+        D3D12_GRAPHICS_PIPELINE_STATE_DESC streamOut = desc2;
+        streamOut.StreamOutput = { entries, 2, strides, 2, 0 };
+        const DXPipelineKey soKey = DXPipelineKey::FromGraphics(streamOut, rootSignature.data(), rootSignature.size());
+        CHECK_FALSE(key == soKey);
+
+        // Only the semantic name content matters, not where it is stored.
+        std::string texcoordOut2 = texcoordOut;
+        entries[1].SemanticName = texcoordOut2.c_str();
+        CHECK(soKey == DXPipelineKey::FromGraphics(streamOut, rootSignature.data(), rootSignature.size()));
+
+        // Same number of entries, any other content gives another key.
+        std::string colorOut = "COLOR";
+        entries[1].SemanticName = colorOut.c_str();
+        CHECK_FALSE(soKey == DXPipelineKey::FromGraphics(streamOut, rootSignature.data(), rootSignature.size()));
+        entries[1].SemanticName = texcoordOut.c_str();
+
+        entries[1].ComponentCount = 3;
+        CHECK_FALSE(soKey == DXPipelineKey::FromGraphics(streamOut, rootSignature.data(), rootSignature.size()));
+        entries[1].ComponentCount = 2;
+
+        strides[1] = 12;
+        CHECK_FALSE(soKey == DXPipelineKey::FromGraphics(streamOut, rootSignature.data(), rootSignature.size()));
+        strides[1] = 8;
+
+        streamOut.StreamOutput.RasterizedStream = D3D12_SO_NO_RASTERIZED_STREAM;
+        CHECK_FALSE(soKey == DXPipelineKey::FromGraphics(streamOut, rootSignature.data(), rootSignature.size()));
+    }
+
+    SECTION("Graphics and compute keys differ")
+    {
+        D3D12_COMPUTE_PIPELINE_STATE_DESC computeDesc = {};
+        computeDesc.CS = desc.VS;
+        computeDesc.NodeMask = 1;
+        CHECK_FALSE(key == DXPipelineKey::FromCompute(computeDesc, s_RootSignature, sizeof(s_RootSignature)));
+    }
+}
+
+TEST_CASE("Pipeline state map", "[PipelineCache]")
+{
+    const std::vector<D3D12_INPUT_ELEMENT_DESC> elements = {
+        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+    };
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = CreateGraphicsDesc(elements);
+    const DXPipelineKey key = DXPipelineKey::FromGraphics(desc, s_RootSignature, sizeof(s_RootSignature));
+    desc.RasterizerState.CullMode = D3D12_CULL_MODE_FRONT;
+    const DXPipelineKey otherKey = DXPipelineKey::FromGraphics(desc, s_RootSignature, sizeof(s_RootSignature));
+
+    DXPipelineStateMap map;
+    bool reserved = false;
+    ComPtr<ID3D12PipelineState>* pSlot = map.FindOrReserve(key, L"PSO", reserved);
+    REQUIRE(reserved);
+    REQUIRE(pSlot != nullptr);
+
+    SECTION("Other keys get their own slot and slots do not move")
+    {
+        ComPtr<ID3D12PipelineState>* pOtherSlot = map.FindOrReserve(otherKey, L"Other PSO", reserved);
+        CHECK(reserved);
+        CHECK(pOtherSlot != pSlot);
+        CHECK(map.GetCount() == 2);
+
+        CHECK(map.FindOrReserve(key, L"PSO", reserved) == pSlot);
+        CHECK_FALSE(reserved);
+        CHECK(map.FindOrReserve(otherKey, L"Other PSO", reserved) == pOtherSlot);
+        CHECK_FALSE(reserved);
+    }
+
+    SECTION("Only one caller reserves a key")
+    {
+        std::atomic<uint32> reservedCount = 0;
+        std::vector<std::thread> threads;
+        for (uint32 i = 0; i < 8; ++i)
+        {
+            threads.emplace_back([&]()
+                {
+                    bool threadReserved = false;
+                    if (map.FindOrReserve(otherKey, L"Other PSO", threadReserved) != nullptr && threadReserved)
+                        reservedCount++;
+                });
+        }
+        for (std::thread& thread : threads)
+            thread.join();
+        CHECK(reservedCount == 1);
+        CHECK(map.GetCount() == 2);
+    }
+
+    map.Clear();
+    CHECK(map.GetCount() == 0);
+    map.FindOrReserve(key, L"PSO", reserved);
+    CHECK(reserved);
+}
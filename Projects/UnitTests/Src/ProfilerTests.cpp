@@ -0,0 +1,358 @@
+#define RS_THROW_INSTEAD_OF_ASSERT
+
+#include "RSEngine.h"
+#include "Core/Profiler.h"
+#include "Catch2/catch_amalgamated.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <latch>
+#include <sstream>
+#include <thread>
+
+using namespace RS;
+
+namespace
+{
+    // The profiler is shared by all tests, this drops what the tests before left in it.
+    Profiler* StartProfiling()
+    {
+        Profiler* pProfiler = Profiler::Get();
+        pProfiler->SetPaused(false);
+        pProfiler->EndFrame();
+        pProfiler->SetFrameHistorySize(Profiler::DefaultFrameHistorySize);
+        return pProfiler;
+    }
+
+    void RecordZones(uint32 count, const char* pName)
+    {
+        for (uint32 i = 0; i < count; ++i)
+        {
+            RS_PROFILE_SCOPE(pName);
+        }
+    }
+}
+
+TEST_CASE("Profiler zones nest", "[Profiler]")
+{
+    Profiler* pProfiler = StartProfiling();
+    {
+        RS_PROFILE_SCOPE("Outer");
+        {
+            RS_PROFILE_SCOPE("Middle");
+            RecordZones(3, "Inner");
+        }
+        RecordZones(1, "Sibling");
+    }
+    pProfiler->EndFrame();
+
+    REQUIRE(pProfiler->GetFrameCount() == 1);
+    const Profiler::Frame& frame = pProfiler->GetFrame(0);
+    REQUIRE(frame.zones.size() == 6);
+
+    // Sorted by begin, a zone begins before the zones inside of it.
+    const std::vector<std::string> names = { "Outer", "Middle", "Inner", "Inner", "Inner", "Sibling" };
+    const std::vector<uint32> depths = { 0, 1, 2, 2, 2, 1 };
+    for (uint32 i = 0; i < 6; ++i)
+    {
+        const Profiler::Zone& zone = frame.zones[i];
+        REQUIRE(names[i] == zone.pName);
+        REQUIRE(zone.depth == depths[i]);
+        REQUIRE(zone.thread == frame.zones[0].thread);
+        REQUIRE(zone.begin <= zone.end);
+        REQUIRE(zone.begin >= frame.zones[0].begin);
+        REQUIRE(zone.end <= frame.zones[0].end);
+        REQUIRE(zone.end <= frame.end);
+    }
+    REQUIRE(frame.zones[2].end <= frame.zones[1].end);
+    REQUIRE(frame.zones[5].begin >= frame.zones[1].end);
+
+    // The zones were taken out of the ring buffer.
+    const uint64 frameIndex = frame.index;
+    pProfiler->EndFrame();
+    REQUIRE(pProfiler->GetFrame(0).zones.empty());
+    REQUIRE(pProfiler->GetFrame(0).index == frameIndex + 1);
+    REQUIRE(pProfiler->GetFrame(0).begin == pProfiler->GetFrame(1).end);
+}
+
+TEST_CASE("Profiler zones from many threads", "[Profiler]")
+{
+    Profiler* pProfiler = StartProfiling();
+
+    const uint32 threadCount = 4;
+    const uint32 zonesPerThread = 1000;
+    std::vector<std::thread> threads;
+    // None of them exits before all have a buffer, so none gets the buffer and the name of another.
+    std::latch named(threadCount);
+    for (uint32 i = 0; i < threadCount; ++i)
+    {
+        threads.emplace_back([i, &named]()
+            {
+                Profiler::Get()->SetThreadName(Utils::Format("Profiler Test Worker {}", i));
+                named.arrive_and_wait();
+                RS_PROFILE_SCOPE("Worker");
+                RecordZones(zonesPerThread, "Work");
+            });
+    }
+
+    // Frames can end while the threads are still recording, every zone ends up in exactly one of them.
+    uint64 zoneCount = 0;
+    for (uint32 i = 0; i < 10; ++i)
+    {
+        pProfiler->EndFrame();
+        zoneCount += pProfiler->GetFrame(0).zones.size();
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+    pProfiler->EndFrame();
+    zoneCount += pProfiler->GetFrame(0).zones.size();
+    REQUIRE(zoneCount == threadCount * (zonesPerThread + 1));
+
+    const std::vector<std::string> threadNames = pProfiler->GetThreadNames();
+    for (uint32 i = 0; i < threadCount; ++i)
+        REQUIRE(std::find(threadNames.begin(), threadNames.end(), Utils::Format("Profiler Test Worker {}", i)) != threadNames.end());
+
+    const Profiler::Frame& frame = pProfiler->GetFrame(0);
+    for (uint64 i = 1; i < frame.zones.size(); ++i)
+    {
+        const Profiler::Zone& previous = frame.zones[i - 1];
+        const Profiler::Zone& zone = frame.zones[i];
+        REQUIRE((previous.thread < zone.thread || (previous.thread == zone.thread && previous.begin <= zone.begin)));
+        REQUIRE(zone.thread < threadNames.size());
+    }
+}
+
+TEST_CASE("Profiler reuses the buffers of threads that exited", "[Profiler]")
+{
+    Profiler* pProfiler = StartProfiling();
+
+    // Like an audio stream that starts a new callback thread every time it plays.
+    const size_t threadCount = pProfiler->GetThreadNames().size();
+    for (uint32 i = 0; i < 8; ++i)
+    {
+        std::thread thread([]() { RecordZones(10, "Short Lived"); });
+        thread.join();
+    }
+    REQUIRE(pProfiler->GetThreadNames().size() <= threadCount + 1);
+
+    // What the threads recorded before they exited is still collected.
+    pProfiler->EndFrame();
+    REQUIRE(pProfiler->GetFrame(0).zones.size() == 80);
+
+    // A thread that gets a buffer does not get the name of the one that had it before.
+    std::thread thread([]()
+        {
+            Profiler::Get()->SetThreadName("Profiler Test Named");
+            RecordZones(1, "Named");
+        });
+    thread.join();
+    std::thread([]() { RecordZones(1, "Unnamed"); }).join();
+    pProfiler->EndFrame();
+
+    const Profiler::Frame& frame = pProfiler->GetFrame(0);
+    REQUIRE(frame.zones.size() == 2);
+    const std::vector<std::string> threadNames = pProfiler->GetThreadNames();
+    REQUIRE(frame.zones[0].thread == frame.zones[1].thread);
+    REQUIRE(threadNames[frame.zones[1].thread] != "Profiler Test Named");
+}
+
+TEST_CASE("Profiler tracks recorded without the lock", "[Profiler]")
+{
+    Profiler* pProfiler = StartProfiling();
+
+    // Like the audio callback, the track is looked up up front and the thread only writes into it.
+    const uint32 track = pProfiler->AddTrack("Profiler Test Track");
+    const Profiler::TrackHandle handle = pProfiler->GetTrackHandle(track);
+    std::thread([handle]()
+        {
+            for (uint64 i = 0; i < 5; ++i)
+                Profiler::RecordZone(handle, "Track Zone", i * 10, i * 10 + 5, 0);
+        }).join();
+    pProfiler->RecordZone(track, "Track Zone", 50, 55, 0);
+    pProfiler->EndFrame();
+
+    const Profiler::Frame& frame = pProfiler->GetFrame(0);
+    REQUIRE(frame.zones.size() == 6);
+    for (uint32 i = 0; i < 6; ++i)
+    {
+        REQUIRE(frame.zones[i].thread == track);
+        REQUIRE(frame.zones[i].begin == i * 10);
+    }
+    REQUIRE(pProfiler->GetThreadNames()[track] == "Profiler Test Track");
+}
+
+TEST_CASE("Profiler zone stats", "[Profiler]")
+{
+    Profiler* pProfiler = StartProfiling();
+
+    // Equal names at different addresses are the same zone.
+    static const char s_Copy[] = "Stats Update";
+    RecordZones(10, "Stats Update");
+    RecordZones(5, s_Copy);
+    {
+        RS_PROFILE_SCOPE("Stats Frame");
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    pProfiler->EndFrame();
+
+    std::vector<Profiler::ZoneStats> stats;
+    Profiler::GetZoneStats(pProfiler->GetFrame(0), stats);
+    REQUIRE(stats.size() == 2);
+    REQUIRE(std::string(stats[0].pName) == "Stats Frame");
+    REQUIRE(stats[0].count == 1);
+    REQUIRE(stats[0].totalMs >= 2.0);
+    REQUIRE(stats[0].maxMs == stats[0].totalMs);
+    REQUIRE(std::string(stats[1].pName) == "Stats Update");
+    REQUIRE(stats[1].count == 15);
+    REQUIRE(stats[1].maxMs <= stats[1].totalMs);
+    REQUIRE(stats[0].totalMs > stats[1].totalMs);
+}
+
+TEST_CASE("Profiler drops zones it has no room for", "[Profiler]")
+{
+    Profiler* pProfiler = StartProfiling();
+
+    SECTION("Full ring buffer")
+    {
+        const uint64 dropped = pProfiler->GetDroppedZoneCount();
+        RecordZones(Profiler::RingSize + 100, "Overflow");
+        pProfiler->EndFrame();
+        REQUIRE(pProfiler->GetFrame(0).zones.size() == Profiler::RingSize);
+        REQUIRE(pProfiler->GetDroppedZoneCount() == dropped + 100);
+
+        // The oldest zones are the ones that are gone.
+        RecordZones(1, "After Overflow");
+        pProfiler->EndFrame();
+        REQUIRE(pProfiler->GetFrame(0).zones.size() == 1);
+        REQUIRE(pProfiler->GetDroppedZoneCount() == dropped + 100);
+    }
+
+    SECTION("Too deep")
+    {
+        const uint64 dropped = pProfiler->GetDroppedZoneCount();
+        for (uint32 i = 0; i < Profiler::MaxDepth + 2; ++i)
+            Profiler::BeginZone("Deep");
+        for (uint32 i = 0; i < Profiler::MaxDepth + 2; ++i)
+            Profiler::EndZone();
+        pProfiler->EndFrame();
+
+        const Profiler::Frame& frame = pProfiler->GetFrame(0);
+        REQUIRE(frame.zones.size() == Profiler::MaxDepth);
+        REQUIRE(frame.zones.back().depth == Profiler::MaxDepth - 1);
+        REQUIRE(pProfiler->GetDroppedZoneCount() == dropped + 2);
+    }
+}
+
+TEST_CASE("Profiler frame history", "[Profiler]")
+{
+    Profiler* pProfiler = StartProfiling();
+    pProfiler->SetFrameHistorySize(3);
+
+    for (uint32 i = 0; i < 5; ++i)
+    {
+        RecordZones(i, "History");
+        pProfiler->EndFrame();
+    }
+    REQUIRE(pProfiler->GetFrameCount() == 3);
+    for (uint32 i = 0; i < 3; ++i)
+    {
+        REQUIRE(pProfiler->GetFrame(i).zones.size() == 4 - i);
+        REQUIRE(pProfiler->GetFrame(i).index + i == pProfiler->GetFrame(0).index);
+    }
+    REQUIRE_THROWS(pProfiler->GetFrame(3));
+
+    SECTION("Paused")
+    {
+        const uint64 newest = pProfiler->GetFrame(0).index;
+        pProfiler->SetPaused(true);
+        RecordZones(10, "Paused");
+        pProfiler->EndFrame();
+        REQUIRE(pProfiler->GetFrame(0).index == newest);
+        REQUIRE(pProfiler->GetFrame(0).zones.size() == 4);
+
+        // The zones from while it was paused are not kept for later either.
+        pProfiler->SetPaused(false);
+        pProfiler->EndFrame();
+        REQUIRE(pProfiler->GetFrame(0).index == newest + 2);
+        REQUIRE(pProfiler->GetFrame(0).zones.empty());
+    }
+
+    SECTION("Cleared")
+    {
+        pProfiler->ClearFrames();
+        REQUIRE(pProfiler->GetFrameCount() == 0);
+        REQUIRE_THROWS(pProfiler->GetFrame(0));
+    }
+}
+
+TEST_CASE("Profiler Chrome trace export", "[Profiler]")
+{
+    Profiler* pProfiler = StartProfiling();
+    std::thread thread([]()
+        {
+            Profiler::Get()->SetThreadName("Profiler \"Export\" Thread");
+            RecordZones(1, "Exported Zone");
+        });
+    thread.join();
+    RecordZones(2, "Exported \\ Zone");
+    pProfiler->EndFrame();
+
+    std::ostringstream stream;
+    pProfiler->ExportChromeTrace(stream);
+    const std::string json = stream.str();
+
+    REQUIRE(json.starts_with("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+    REQUIRE(json.ends_with("]}\n"));
+    REQUIRE(json.find("\"args\":{\"name\":\"Profiler \\\"Export\\\" Thread\"}") != std::string::npos);
+    REQUIRE(json.find("{\"name\":\"Exported Zone\",\"ph\":\"X\"") != std::string::npos);
+    REQUIRE(json.find("\"Exported \\\\ Zone\"") != std::string::npos);
+    REQUIRE(json.find("\"name\":\"Frame ") != std::string::npos);
+
+    // One event per line, each a complete object.
+    std::istringstream lines(json);
+    std::string line;
+    uint32 zoneEventCount = 0;
+    std::getline(lines, line);
+    while (std::getline(lines, line) && line != "]}")
+    {
+        REQUIRE(line.starts_with("{\"name\":"));
+        REQUIRE((line.ends_with("},") || line.ends_with("}")));
+        if (line.find("Exported") != std::string::npos && line.find("\"ph\":\"X\"") != std::string::npos)
+            zoneEventCount++;
+    }
+    REQUIRE(zoneEventCount == 3);
+
+    const std::string path = Engine::GetTempFilePath() + "ProfilerTests/Profile.json";
+    REQUIRE(pProfiler->ExportChromeTrace(path));
+    std::ifstream file(path);
+    REQUIRE(std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()) == json);
+}
+
+// Hidden by default, run with: UnitTests.exe "[benchmark]"
+TEST_CASE("Profiler zone speed", "[.][benchmark][Profiler]")
+{
+    Profiler* pProfiler = StartProfiling();
+    pProfiler->SetPaused(true);
+
+    const uint32 count = 1000;
+    BENCHMARK(Utils::Format("{} zones", count))
+    {
+        RecordZones(count, "Benchmark");
+        return count;
+    };
+
+    BENCHMARK(Utils::Format("{} zones, 4 deep", count))
+    {
+        for (uint32 i = 0; i < count / 4; ++i)
+        {
+            RS_PROFILE_SCOPE("Benchmark 0");
+            RS_PROFILE_SCOPE("Benchmark 1");
+            RS_PROFILE_SCOPE("Benchmark 2");
+            RS_PROFILE_SCOPE("Benchmark 3");
+        }
+        return count;
+    };
+
+    pProfiler->EndFrame();
+    pProfiler->SetPaused(false);
+}
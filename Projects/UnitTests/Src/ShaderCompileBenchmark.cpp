@@ -0,0 +1,56 @@
+#define RS_THROW_INSTEAD_OF_ASSERT
+
+#include "RSEngine.h"
+#include "Core/ThreadPool.h"
+#include "DX12/Final/DXShader.h"
+#include "Catch2/catch_amalgamated.hpp"
+
+// Hidden by default, run with: UnitTests.exe "[benchmark]"
+TEST_CASE("Shader compilation at 1..N threads", "[.][benchmark][DXShader]")
+{
+    using namespace RS::DX12;
+
+    const std::vector<std::string> shaderPaths = {
+        "Core/MeshShader.hlsl",
+        "Core/TextRenderShader.hlsl",
+        "Core/ResizeShader.hlsl",
+        "Core/SDRPresentShader.hlsl",
+        "ImGui/ImGuiShader.hlsl",
+    };
+
+    auto compileAll = [&]() -> uint32
+    {
+        uint32 compiledCount = 0;
+        for (const std::string& path : shaderPaths)
+        {
+            DXShader shader;
+            DXShader::Description desc;
+            desc.path = path;
+            desc.isInternalPath = true;
+            if (shader.Create(desc))
+                compiledCount++;
+            shader.Release();
+        }
+        return compiledCount;
+    };
+
+    const uint oldThreadCount = DXShader::GetCompileThreadCount();
+    const uint maxThreadCount = RS::ThreadPool::Get()->GetThreadCount() + 1;
+    std::vector<uint> threadCounts;
+    for (uint threadCount = 1; threadCount < maxThreadCount; threadCount *= 2)
+        threadCounts.push_back(threadCount);
+    threadCounts.push_back(maxThreadCount);
+
+    for (uint threadCount : threadCounts)
+    {
+        DXShader::SetCompileThreadCount(threadCount);
+        REQUIRE(compileAll() == (uint32)shaderPaths.size());
+
+        const std::string name = RS::Utils::Format("Compile {} shaders, {} threads", shaderPaths.size(), threadCount);
+        BENCHMARK(name)
+        {
+            return compileAll();
+        };
+    }
+    DXShader::SetCompileThreadCount(oldThreadCount);
+}
@@ -0,0 +1,38 @@
+#define RS_THROW_INSTEAD_OF_ASSERT
+
+#include "RSEngine.h"
+#include "DX12/Final/DXShaderDependencyGraph.h"
+#include "Catch2/catch_amalgamated.hpp"
+
+using RS::DX12::DXShaderDependencyGraph;
+
+TEST_CASE("Shader dependency graph", "[DXShaderDependencyGraph]")
+{
+    DXShaderDependencyGraph graph;
+    graph.SetDependencies("Shaders/Core/SDRPresentShader.hlsl", { "Shaders/Core/./PresentRS.hlsli" });
+    graph.SetDependencies("Shaders/Core/BufferCopyPS.hlsl", { "Shaders/Core/PresentRS.hlsli" });
+    graph.SetDependencies("Shaders/Core/GenerateMipsCS.hlsl", { "Shaders/Core/CommonRootSignature.hlsli" });
+
+    SECTION("Include maps to every shader that uses it")
+    {
+        CHECK(graph.GetDependents("Shaders/Core/PresentRS.hlsli") == std::vector<std::string>{ "Shaders/Core/BufferCopyPS.hlsl", "Shaders/Core/SDRPresentShader.hlsl" });
+        CHECK(graph.GetDependents("Shaders/Core/CommonRootSignature.hlsli") == std::vector<std::string>{ "Shaders/Core/GenerateMipsCS.hlsl" });
+        CHECK(graph.GetDependents("Shaders/Core/Unused.hlsli").empty());
+    }
+
+    SECTION("Recompiling replaces the include set")
+    {
+        uint64 version = graph.GetVersion();
+        graph.SetDependencies("Shaders/Core/BufferCopyPS.hlsl", { "Shaders/Core/CommonRootSignature.hlsli" });
+        CHECK(graph.GetVersion() != version);
+        CHECK(graph.GetDependents("Shaders/Core/PresentRS.hlsli") == std::vector<std::string>{ "Shaders/Core/SDRPresentShader.hlsl" });
+        CHECK(graph.GetDependencies("Shaders/Core/BufferCopyPS.hlsl") == std::vector<std::string>{ "Shaders/Core/CommonRootSignature.hlsli" });
+    }
+
+    SECTION("Removed shaders are not dependents")
+    {
+        graph.RemoveShader("Shaders/Core/GenerateMipsCS.hlsl");
+        CHECK(graph.GetDependents("Shaders/Core/CommonRootSignature.hlsli").empty());
+        CHECK(graph.GetDependencies("Shaders/Core/GenerateMipsCS.hlsl").empty());
+    }
+}
@@ -0,0 +1,268 @@
+#define RS_THROW_INSTEAD_OF_ASSERT
+
+#include "RSEngine.h"
+#include "ECS/SimulationHistory.h"
+#include "Utils/Misc/RandomUtils.h"
+#include "Catch2/catch_amalgamated.hpp"
+
+#include <random>
+
+using namespace RS;
+using namespace RS::ECS;
+
+namespace
+{
+    struct Position
+    {
+        float x;
+        float y;
+    };
+
+    struct Velocity
+    {
+        float x;
+        float y;
+    };
+
+    struct Health
+    {
+        float value;
+    };
+
+    // What a player did in one tick, this is all that has to be recorded to replay a run.
+    struct TickInput
+    {
+        float targetX;
+        float targetY;
+        bool spawn;
+    };
+
+    struct WorldState
+    {
+        Utils::DeterministicRandom random;
+        uint64 spawnCount = 0;
+        uint64 killCount = 0;
+    };
+
+    const float DT = 1.f / 60.f;
+
+    struct World
+    {
+        EntityStore entities;
+        WorldState state;
+
+        World() { state.random.state = 42; }
+
+        void Spawn(uint32 count)
+        {
+            for (uint32 i = 0; i < count; ++i)
+            {
+                const float angle = state.random.NextRad();
+                const Position position = { std::cos(angle) * 10.f, std::sin(angle) * 10.f };
+                entities.Create(position, Previous<Position>{ position }, Velocity{ 0.f, 0.f }, Health{ 50.f + state.random.Next01() * 50.f });
+                ++state.spawnCount;
+            }
+        }
+
+        // Runs on the thread pool, so it also checks that the result does not depend on how the threads were scheduled.
+        void Tick(const TickInput& input)
+        {
+            StorePrevious<Position>(entities);
+
+            if (input.spawn)
+                Spawn(20);
+
+            std::atomic<uint64> killCount = 0;
+            entities.ForEachChunkParallel<Position, Velocity, Health>([&](const Chunk& chunk)
+                {
+                    const EntityHandle* pEntities = chunk.GetEntities();
+                    Position* pPositions = chunk.Get<Position>();
+                    Velocity* pVelocities = chunk.Get<Velocity>();
+                    Health* pHealths = chunk.Get<Health>();
+                    for (uint32 i = 0; i < chunk.GetCount(); ++i)
+                    {
+                        const float dx = input.targetX - pPositions[i].x;
+                        const float dy = input.targetY - pPositions[i].y;
+                        pVelocities[i].x += dx * DT;
+                        pVelocities[i].y += dy * DT;
+                        pPositions[i].x += pVelocities[i].x * DT;
+                        pPositions[i].y += pVelocities[i].y * DT;
+
+                        // Close to the target hurts.
+                        if (dx * dx + dy * dy < 4.f)
+                            pHealths[i].value -= 10.f;
+                        if (pHealths[i].value <= 0.f)
+                        {
+                            entities.QueueDestroy(pEntities[i]);
+                            ++killCount;
+                        }
+                    }
+                }, 4);
+            entities.FlushDestroyed();
+            state.killCount += killCount;
+        }
+
+        // Every byte of simulation state, in the order it is stored.
+        std::vector<uint8> GetBytes() const
+        {
+            std::vector<uint8> bytes;
+            auto Append = [&](const auto& value)
+            {
+                const uint8* pBytes = reinterpret_cast<const uint8*>(&value);
+                bytes.insert(bytes.end(), pBytes, pBytes + sizeof(value));
+            };
+            entities.ForEach<Position, Previous<Position>, Velocity, Health>([&](EntityHandle entity, const Position& position, const Previous<Position>& previous, const Velocity& velocity, const Health& health)
+                {
+                    Append(entity);
+                    Append(position);
+                    Append(previous);
+                    Append(velocity);
+                    Append(health);
+                });
+            Append(state.random.state);
+            Append(state.spawnCount);
+            Append(state.killCount);
+            return bytes;
+        }
+    };
+
+    std::vector<TickInput> RecordInputs(uint32 tickCount)
+    {
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<float> target(-8.f, 8.f);
+        std::vector<TickInput> inputs(tickCount);
+        for (uint32 tick = 0; tick < tickCount; ++tick)
+            inputs[tick] = { target(rng), target(rng), tick % 15 == 0 };
+        return inputs;
+    }
+}
+
+TEST_CASE("SimulationHistory replays recorded inputs bit exactly", "[SimulationHistory]")
+{
+    const uint32 tickCount = 300;
+    const std::vector<TickInput> inputs = RecordInputs(tickCount);
+
+    // The original run, which saves every tick and remembers the bytes of the state after every tick.
+    World world;
+    world.Spawn(200);
+    SimulationHistory history(world.entities, 64);
+    history.AddState(world.state);
+
+    std::vector<std::vector<uint8>> states(tickCount);
+    for (uint32 tick = 0; tick < tickCount; ++tick)
+    {
+        history.Save(tick);
+        world.Tick(inputs[tick]);
+        states[tick] = world.GetBytes();
+    }
+    REQUIRE(world.state.killCount > 0);
+    REQUIRE(world.entities.GetCount() > 0);
+
+    SECTION("A second run from the start")
+    {
+        World other;
+        other.Spawn(200);
+        for (uint32 tick = 0; tick < tickCount; ++tick)
+        {
+            other.Tick(inputs[tick]);
+            REQUIRE(other.GetBytes() == states[tick]);
+        }
+    }
+
+    SECTION("Rolling back and running the same inputs again")
+    {
+        const uint32 rollbackTick = tickCount - 40;
+        REQUIRE(history.Restore(rollbackTick));
+        REQUIRE(world.GetBytes() == states[rollbackTick - 1]);
+        for (uint32 tick = rollbackTick; tick < tickCount; ++tick)
+        {
+            history.Save(tick);
+            world.Tick(inputs[tick]);
+            REQUIRE(world.GetBytes() == states[tick]);
+        }
+    }
+
+    SECTION("Only the last ticks are kept")
+    {
+        REQUIRE(history.Contains(tickCount - 1));
+        REQUIRE(history.Contains(tickCount - 64));
+        REQUIRE_FALSE(history.Contains(tickCount - 65));
+        REQUIRE_FALSE(history.Restore(0));
+        REQUIRE(history.GetSize() > 0);
+
+        // Ticks after a restored one belong to the old timeline.
+        REQUIRE(history.Restore(tickCount - 10));
+        REQUIRE_FALSE(history.Contains(tickCount - 9));
+        REQUIRE(history.Contains(tickCount - 11));
+    }
+}
+
+TEST_CASE("EntityStore snapshots", "[SimulationHistory]")
+{
+    EntityStore store;
+    std::vector<EntityHandle> entities;
+    for (uint32 i = 0; i < 2000; ++i)
+        entities.push_back(store.Create(Position{ (float)i, 0.f }, Health{ 1.f }));
+
+    EntityStoreSnapshot snapshot;
+    store.SaveSnapshot(snapshot);
+    REQUIRE(snapshot.GetSize() >= 2000 * (sizeof(Position) + sizeof(Health)));
+
+    // Structural changes after the snapshot, including a new archetype, are undone by loading it.
+    for (uint32 i = 0; i < 2000; i += 3)
+        store.Destroy(entities[i]);
+    const EntityHandle created = store.Create(Position{ -1.f, -1.f }, Velocity{ 1.f, 1.f });
+    store.Get<Position>(entities[1])->x = 1000.f;
+    store.QueueDestroy(entities[2]);
+
+    store.LoadSnapshot(snapshot);
+    REQUIRE(store.GetCount() == 2000);
+    REQUIRE_FALSE(store.IsAlive(created));
+    for (uint32 i = 0; i < 2000; ++i)
+    {
+        REQUIRE(store.IsAlive(entities[i]));
+        REQUIRE(store.Get<Position>(entities[i])->x == (float)i);
+    }
+    REQUIRE(store.FlushDestroyed() == 0);
+
+    // The slots were restored too, new entities do not reuse live ones.
+    const EntityHandle next = store.Create(Position{}, Health{});
+    REQUIRE(std::find(entities.begin(), entities.end(), next) == entities.end());
+
+    EntityStore other;
+    REQUIRE_THROWS(other.LoadSnapshot(snapshot));
+}
+
+TEST_CASE("Previous components interpolate between ticks", "[SimulationHistory]")
+{
+    EntityStore store;
+    const EntityHandle entity = store.Create(Position{ 0.f, 0.f }, Previous<Position>{ { 0.f, 0.f } });
+    const EntityHandle withoutPrevious = store.Create(Position{ 5.f, 5.f });
+
+    store.Get<Position>(entity)->x = 2.f;
+    StorePrevious<Position>(store);
+    store.Get<Position>(entity)->x = 4.f;
+
+    const float previous = store.Get<Previous<Position>>(entity)->value.x;
+    const float current = store.Get<Position>(entity)->x;
+    REQUIRE(previous == 2.f);
+    REQUIRE(previous + (current - previous) * 0.25f == 2.5f);
+    REQUIRE(store.Get<Position>(withoutPrevious)->x == 5.f);
+}
+
+TEST_CASE("DeterministicRandom", "[SimulationHistory]")
+{
+    Utils::DeterministicRandom a{ 1 };
+    Utils::DeterministicRandom b{ 1 };
+    for (uint32 i = 0; i < 1000; ++i)
+    {
+        const float value = a.Next01();
+        REQUIRE(value == b.Next01());
+        REQUIRE(value >= 0.f);
+        REQUIRE(value < 1.f);
+    }
+
+    // Copying the state copies the sequence.
+    Utils::DeterministicRandom c = a;
+    REQUIRE(c.Next() == a.Next());
+}
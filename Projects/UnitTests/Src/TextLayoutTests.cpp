@@ -0,0 +1,271 @@
+#define RS_THROW_INSTEAD_OF_ASSERT
+
+#include "RSEngine.h"
+#include "Graphics/TextLayout.h"
+#include "Catch2/catch_amalgamated.hpp"
+
+#include <random>
+
+using namespace RS;
+
+namespace
+{
+    // Every glyph is 8x10 with an advance of 10, space advances 5 and "AV" and "VA" are kerned together by 2.
+    class FixedRasterizer : public IGlyphRasterizer
+    {
+    public:
+        uint32 kerningQueryCount = 0;
+
+        bool Rasterize(uint32 codepoint, GlyphBitmap& bitmap) override
+        {
+            if (codepoint == ' ')
+            {
+                bitmap.advance = 5.f;
+                return true;
+            }
+
+            bitmap.width = 8;
+            bitmap.height = 10;
+            bitmap.bearingX = 1;
+            bitmap.bearingY = 10;
+            bitmap.advance = 10.f;
+            bitmap.pixels.assign(80, 255);
+            return true;
+        }
+
+        float GetLineHeight() const override { return 16.f; }
+        bool HasKerning() const override { return true; }
+
+        float GetKerning(uint32 left, uint32 right) override
+        {
+            kerningQueryCount++;
+            return (left == 'A' && right == 'V') || (left == 'V' && right == 'A') ? -2.f : 0.f;
+        }
+    };
+
+    struct Quad
+    {
+        float x;
+        float y;
+    };
+
+    // The pen positions of the glyphs of the layout, in page and then layout order.
+    std::vector<Quad> GetPens(const TextLayout& layout, float scale = 1.f)
+    {
+        std::vector<Quad> pens;
+        for (const std::vector<GlyphInstance>& page : layout.glyphs.pages)
+        {
+            for (const GlyphInstance& instance : page)
+                pens.push_back({ instance.x - 1.f * scale, instance.y });
+        }
+        return pens;
+    }
+}
+
+TEST_CASE("Text layout kerns glyphs on a line", "[TextLayout]")
+{
+    auto pRasterizer = std::make_unique<FixedRasterizer>();
+    FixedRasterizer* pFixed = pRasterizer.get();
+    GlyphAtlas atlas(std::move(pRasterizer));
+
+    TextLayout layout;
+    TextLayout::Build(atlas, "AVA x", TextLayoutSettings(), layout);
+    const std::vector<Quad> pens = GetPens(layout);
+    REQUIRE(pens.size() == 4);
+    REQUIRE(pens[0].x == 0.f);
+    REQUIRE(pens[1].x == 8.f);
+    REQUIRE(pens[2].x == 16.f);
+    REQUIRE(pens[3].x == 31.f);
+    for (const Quad& pen : pens)
+        REQUIRE(pen.y == 0.f);
+    REQUIRE(layout.lineCount == 1);
+    REQUIRE(layout.width == 41.f);
+    REQUIRE(layout.height == 16.f);
+
+    // Kerning pairs are asked for once, and the line API kerns the same way.
+    const uint32 queryCount = pFixed->kerningQueryCount;
+    GlyphBatch batch;
+    REQUIRE(atlas.AppendText("AVA x", 0.f, 0.f, 1.f, 0, batch) == 41.f);
+    REQUIRE(pFixed->kerningQueryCount == queryCount);
+
+    TextLayoutSettings settings;
+    settings.scale = 2.f;
+    TextLayout::Build(atlas, "AVA x", settings, layout);
+    REQUIRE(GetPens(layout, 2.f)[3].x == 62.f);
+    REQUIRE(layout.width == 82.f);
+    REQUIRE(layout.glyphs.pages[0][0].width == 16.f);
+
+    TextLayout::Build(atlas, "", TextLayoutSettings(), layout);
+    REQUIRE(layout.lineCount == 0);
+    REQUIRE(layout.glyphs.GetInstanceCount() == 0);
+}
+
+TEST_CASE("Text layout breaks lines", "[TextLayout]")
+{
+    GlyphAtlas atlas(std::make_unique<FixedRasterizer>());
+    TextLayout layout;
+
+    SECTION("New lines")
+    {
+        TextLayoutSettings settings;
+        settings.lineSpacing = 1.5f;
+        TextLayout::Build(atlas, "ab\n\ncd", settings, layout);
+        const std::vector<Quad> pens = GetPens(layout);
+        REQUIRE(pens.size() == 4);
+        REQUIRE(pens[2].x == 0.f);
+        REQUIRE(pens[2].y == -48.f);
+        REQUIRE(layout.lineCount == 3);
+        REQUIRE(layout.height == 72.f);
+    }
+
+    SECTION("At spaces")
+    {
+        // "aaa bbb" is 65 wide, the c would end at 80.
+        TextLayoutSettings settings;
+        settings.maxWidth = 70.f;
+        TextLayout::Build(atlas, "aaa bbb ccc dd", settings, layout);
+        const std::vector<Quad> pens = GetPens(layout);
+        REQUIRE(pens.size() == 11);
+        REQUIRE(layout.lineCount == 2);
+        REQUIRE(pens[5].x == 55.f);
+        REQUIRE(pens[5].y == 0.f);
+        REQUIRE(pens[6].x == 0.f);
+        REQUIRE(pens[6].y == -16.f);
+        REQUIRE(pens[9].x == 35.f);
+        REQUIRE(layout.width == 65.f);
+    }
+
+    SECTION("Inside long words")
+    {
+        TextLayoutSettings settings;
+        settings.maxWidth = 35.f;
+        TextLayout::Build(atlas, "abcdefghij", settings, layout);
+        REQUIRE(layout.lineCount == 4);
+        const std::vector<Quad> pens = GetPens(layout);
+        for (uint32 i = 0; i < pens.size(); ++i)
+        {
+            REQUIRE(pens[i].x == (float)(i % 3) * 10.f);
+            REQUIRE(pens[i].y == -(float)(i / 3) * 16.f);
+        }
+    }
+
+    SECTION("Every line fits")
+    {
+        std::mt19937 rng(7);
+        std::uniform_int_distribution<uint32> wordLength(1, 8);
+        std::string text;
+        for (uint32 word = 0; word < 200; ++word)
+        {
+            text += std::string(wordLength(rng), 'w');
+            text += ' ';
+        }
+
+        TextLayoutSettings settings;
+        settings.maxWidth = 123.f;
+        TextLayout::Build(atlas, text, settings, layout);
+        REQUIRE(layout.glyphs.GetInstanceCount() == text.size() - 200);
+        REQUIRE(layout.width <= settings.maxWidth);
+        for (const Quad& pen : GetPens(layout))
+            REQUIRE(pen.x + 10.f <= settings.maxWidth);
+    }
+}
+
+TEST_CASE("Text layout is copied into batches", "[TextLayout]")
+{
+    GlyphAtlas atlas(std::make_unique<FixedRasterizer>());
+
+    TextLayout layout;
+    TextLayout::Build(atlas, "H\xC3\xA9\xE2\x82\xAC", TextLayoutSettings(), layout);
+    REQUIRE(layout.glyphs.GetInstanceCount() == 3);
+
+    GlyphBatch batch;
+    layout.AppendTo(batch, 100.f, 200.f, 0x00FF00FF);
+    layout.AppendTo(batch, 0.f, 0.f, 0xFF0000FF);
+    REQUIRE(batch.GetInstanceCount() == 6);
+
+    const std::vector<GlyphInstance>& source = layout.glyphs.pages[0];
+    const std::vector<GlyphInstance>& instances = batch.pages[0];
+    for (uint32 i = 0; i < 3; ++i)
+    {
+        REQUIRE(instances[i].x == source[i].x + 100.f);
+        REQUIRE(instances[i].y == source[i].y + 200.f);
+        REQUIRE(instances[i].color == 0x00FF00FF);
+        REQUIRE(instances[i].texelX == source[i].texelX);
+        REQUIRE(instances[i + 3].x == source[i].x);
+        REQUIRE(instances[i + 3].color == 0xFF0000FF);
+    }
+}
+
+TEST_CASE("Text layout cache keeps recently used layouts", "[TextLayout]")
+{
+    GlyphAtlas atlas(std::make_unique<FixedRasterizer>());
+    TextLayoutCache cache(2);
+
+    TextLayoutSettings settings;
+    const TextLayout* pFirst = &cache.Get(atlas, 0, "Score: 10", settings);
+    REQUIRE(cache.GetMissCount() == 1);
+    REQUIRE(&cache.Get(atlas, 0, "Score: 10", settings) == pFirst);
+    REQUIRE(cache.GetHitCount() == 1);
+
+    // The font and every setting are part of the key.
+    cache.Get(atlas, 1, "Score: 10", settings);
+    REQUIRE(cache.GetMissCount() == 2);
+    settings.maxWidth = 60.f;
+    REQUIRE(cache.Get(atlas, 0, "Score: 10", settings).lineCount == 2);
+    REQUIRE(cache.GetMissCount() == 3);
+    REQUIRE(cache.GetSize() == 2);
+
+    // "Score: 10" without wrapping was the least recently used, so it is the one that is gone.
+    settings.maxWidth = 0.f;
+    cache.Get(atlas, 1, "Score: 10", settings);
+    REQUIRE(cache.GetHitCount() == 2);
+    REQUIRE(cache.Get(atlas, 0, "Score: 10", settings).lineCount == 1);
+    REQUIRE(cache.GetMissCount() == 4);
+    settings.maxWidth = 60.f;
+    cache.Get(atlas, 0, "Score: 10", settings);
+    REQUIRE(cache.GetMissCount() == 5);
+    REQUIRE(cache.GetSize() == 2);
+
+    cache.Clear();
+    REQUIRE(cache.GetSize() == 0);
+    REQUIRE_THROWS(TextLayoutCache(0));
+}
+
+// Hidden by default, run with: UnitTests.exe "[benchmark]"
+TEST_CASE("Text layout speed", "[.][benchmark][TextLayout]")
+{
+    GlyphAtlas atlas(std::make_unique<FixedRasterizer>());
+    TextLayoutCache cache(1024);
+
+    // A HUD worth of labels, most of them the same every frame.
+    std::vector<std::string> texts;
+    uint64 glyphCount = 0;
+    for (uint32 i = 0; i < 500; ++i)
+    {
+        texts.push_back(Utils::Format("Label {} of the heads up display: {}", i, i * 37));
+        glyphCount += texts.back().size();
+    }
+
+    TextLayoutSettings settings;
+    settings.maxWidth = 200.f;
+    GlyphBatch batch;
+    BENCHMARK(Utils::Format("Layout of {} texts with {} glyphs", texts.size(), glyphCount))
+    {
+        batch.Clear();
+        TextLayout layout;
+        for (const std::string& text : texts)
+        {
+            TextLayout::Build(atlas, text, settings, layout);
+            layout.AppendTo(batch, 0.f, 0.f, 0xFFFFFFFF);
+        }
+        return batch.GetInstanceCount();
+    };
+
+    BENCHMARK(Utils::Format("Cached layout of {} texts with {} glyphs", texts.size(), glyphCount))
+    {
+        batch.Clear();
+        for (const std::string& text : texts)
+            cache.Get(atlas, 0, text, settings).AppendTo(batch, 0.f, 0.f, 0xFFFFFFFF);
+        return batch.GetInstanceCount();
+    };
+}
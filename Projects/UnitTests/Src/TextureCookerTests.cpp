@@ -0,0 +1,283 @@
+#define RS_THROW_INSTEAD_OF_ASSERT
+
+#include "RSEngine.h"
+#include "Core/ThreadPool.h"
+#include "Loaders/Texture/TextureMips.h"
+#include "Loaders/Texture/BCCompression.h"
+#include "Loaders/Texture/DDSFile.h"
+#include "Loaders/Texture/TextureCooker.h"
+#include "Catch2/catch_amalgamated.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <cmath>
+
+using namespace RS;
+
+namespace
+{
+    // Smooth gradients with some detail, close to what a photo texture looks like to the block compressors.
+    TextureImage CreateTestImage(uint32 width, uint32 height)
+    {
+        TextureImage image;
+        image.width = width;
+        image.height = height;
+        image.pixels.resize((uint64)width * height * 4);
+        for (uint32 y = 0; y < height; ++y)
+        {
+            for (uint32 x = 0; x < width; ++x)
+            {
+                uint8* pPixel = image.pixels.data() + ((uint64)y * width + x) * 4;
+                pPixel[0] = (uint8)(x * 255 / std::max(1u, width - 1));
+                pPixel[1] = (uint8)(y * 255 / std::max(1u, height - 1));
+                pPixel[2] = (uint8)(128 + 100 * std::sin(x * 0.2f) * std::cos(y * 0.15f));
+                pPixel[3] = (uint8)((x + y) * 255 / std::max(1u, width + height - 2));
+            }
+        }
+        return image;
+    }
+
+    double ComputePSNR(const TextureImage& a, const TextureImage& b, uint32 channelCount)
+    {
+        double error = 0.0;
+        for (uint64 i = 0; i < (uint64)a.width * a.height; ++i)
+        {
+            for (uint32 c = 0; c < channelCount; ++c)
+            {
+                const double d = (double)a.pixels[i * 4 + c] - b.pixels[i * 4 + c];
+                error += d * d;
+            }
+        }
+        const double mse = error / ((double)a.width * a.height * channelCount);
+        return mse == 0.0 ? 100.0 : 10.0 * std::log10(255.0 * 255.0 / mse);
+    }
+
+    double CompressAndMeasure(BCFormat format, const TextureImage& image, uint32 channelCount)
+    {
+        std::vector<uint8> compressed = BCCompressor::Compress(format, image);
+        REQUIRE(compressed.size() == BCCompressor::GetCompressedSize(format, image.width, image.height));
+        return ComputePSNR(image, BCCompressor::Decompress(format, compressed.data(), image.width, image.height), channelCount);
+    }
+}
+
+TEST_CASE("Mip chain generation", "[TextureCooker]")
+{
+    SECTION("Sizes")
+    {
+        CHECK(TextureMipGenerator::GetMipCount(1, 1) == 1);
+        CHECK(TextureMipGenerator::GetMipCount(256, 256) == 9);
+        CHECK(TextureMipGenerator::GetMipCount(300, 20) == 9);
+
+        std::vector<TextureImage> mips = TextureMipGenerator::Generate(CreateTestImage(37, 10), false, MipFilter::Kaiser);
+        REQUIRE(mips.size() == 6);
+        const uint32 expectedSizes[6][2] = { { 37, 10 }, { 18, 5 }, { 9, 2 }, { 4, 1 }, { 2, 1 }, { 1, 1 } };
+        for (uint32 mip = 0; mip < 6; ++mip)
+        {
+            CHECK(mips[mip].width == expectedSizes[mip][0]);
+            CHECK(mips[mip].height == expectedSizes[mip][1]);
+            CHECK(mips[mip].pixels.size() == (uint64)mips[mip].width * mips[mip].height * 4);
+        }
+    }
+
+    SECTION("Box filter averages linear data")
+    {
+        TextureImage image;
+        image.width = 2;
+        image.height = 2;
+        image.pixels = { 0, 10, 200, 255,   100, 30, 200, 0,   50, 50, 0, 255,   150, 70, 0, 0 };
+        std::vector<TextureImage> mips = TextureMipGenerator::Generate(image, false, MipFilter::Box);
+        REQUIRE(mips.size() == 2);
+        CHECK(mips[1].pixels == std::vector<uint8>{ 75, 40, 100, 128 });
+    }
+
+    SECTION("sRGB is filtered in linear space")
+    {
+        // Black and white checkers average to linear 0.5, which is 188 in sRGB and not 128.
+        TextureImage image;
+        image.width = 8;
+        image.height = 8;
+        for (uint32 i = 0; i < 64; ++i)
+        {
+            const uint8 value = ((i % 8) + (i / 8)) % 2 == 0 ? 0 : 255;
+            image.pixels.insert(image.pixels.end(), { value, value, value, value });
+        }
+
+        for (MipFilter filter : { MipFilter::Box, MipFilter::Kaiser })
+        {
+            std::vector<TextureImage> mips = TextureMipGenerator::Generate(image, true, filter);
+            const uint8* pPixel = mips[1].pixels.data() + (1 * mips[1].width + 1) * 4;
+            CHECK(std::abs((int32)pPixel[0] - 188) <= 2);
+            // Alpha is linear.
+            CHECK(std::abs((int32)pPixel[3] - 128) <= 2);
+        }
+    }
+
+    SECTION("Thread count does not change the result")
+    {
+        const TextureImage image = CreateTestImage(129, 67);
+        std::vector<TextureImage> singleThreaded = TextureMipGenerator::Generate(image, true, MipFilter::Kaiser, 1);
+        std::vector<TextureImage> multiThreaded = TextureMipGenerator::Generate(image, true, MipFilter::Kaiser, 0);
+        REQUIRE(singleThreaded.size() == multiThreaded.size());
+        for (uint64 mip = 0; mip < singleThreaded.size(); ++mip)
+            CHECK(singleThreaded[mip].pixels == multiThreaded[mip].pixels);
+    }
+}
+
+TEST_CASE("Block compression quality", "[TextureCooker]")
+{
+    const TextureImage image = CreateTestImage(64, 64);
+
+    CHECK(CompressAndMeasure(BCFormat::BC1, image, 3) > 32.0);
+    CHECK(CompressAndMeasure(BCFormat::BC3, image, 4) > 32.0);
+    CHECK(CompressAndMeasure(BCFormat::BC5, image, 2) > 40.0);
+    CHECK(CompressAndMeasure(BCFormat::BC7, image, 4) > 38.0);
+
+    SECTION("Solid blocks are exact")
+    {
+        TextureImage solid;
+        solid.width = 4;
+        solid.height = 4;
+        for (uint32 i = 0; i < 16; ++i)
+            solid.pixels.insert(solid.pixels.end(), { 255, 0, 255, 255 });
+        CHECK(CompressAndMeasure(BCFormat::BC1, solid, 4) == 100.0);
+        CHECK(CompressAndMeasure(BCFormat::BC3, solid, 4) == 100.0);
+        // Mode 6 shares the lowest bit between all channels of an endpoint, so it can be off by one.
+        CHECK(CompressAndMeasure(BCFormat::BC7, solid, 4) > 48.0);
+    }
+
+    SECTION("Sizes that are not a multiple of four")
+    {
+        CHECK(BCCompressor::GetCompressedSize(BCFormat::BC7, 7, 3) == 2 * 16);
+        CHECK(BCCompressor::GetCompressedSize(BCFormat::BC1, 1, 1) == 8);
+        CHECK(CompressAndMeasure(BCFormat::BC7, CreateTestImage(67, 35), 4) > 35.0);
+    }
+}
+
+TEST_CASE("Cooked DDS files", "[TextureCooker]")
+{
+    const TextureImage image = CreateTestImage(40, 24);
+
+    TextureCookSettings settings;
+    settings.format = CookedFormat::BC7;
+    const std::vector<uint8> dds = TextureCooker::CookImage(image, settings, 0x1234567890ULL);
+
+    DDSTexture texture;
+    REQUIRE(DDSFile::Parse(dds, texture));
+    CHECK(texture.width == 40);
+    CHECK(texture.height == 24);
+    CHECK(texture.dxgiFormat == DDSFile::GetDXGIFormat(CookedFormat::BC7, true));
+    CHECK(texture.cookHash == 0x1234567890ULL);
+    REQUIRE(texture.mips.size() == TextureMipGenerator::GetMipCount(40, 24));
+
+    for (uint32 mip = 0; mip < (uint32)texture.mips.size(); ++mip)
+    {
+        const DDSTexture::Mip& layout = texture.mips[mip];
+        CHECK(layout.data.size() == BCCompressor::GetCompressedSize(BCFormat::BC7, layout.width, layout.height));
+        CHECK(layout.data.size() == layout.rowPitch * layout.rowCount);
+        // The mips are views into the file.
+        CHECK(layout.data.data() >= dds.data());
+        CHECK(layout.data.data() + layout.data.size() <= dds.data() + dds.size());
+    }
+
+    SECTION("Truncated files are rejected")
+    {
+        CHECK_FALSE(DDSFile::Parse(std::span<const uint8>(dds.data(), dds.size() - 1), texture));
+        CHECK_FALSE(DDSFile::Parse(std::span<const uint8>(dds.data(), 16), texture));
+    }
+
+    SECTION("Uncompressed")
+    {
+        settings.format = CookedFormat::RGBA8;
+        settings.generateMips = false;
+        const std::vector<uint8> uncompressed = TextureCooker::CookImage(image, settings);
+        REQUIRE(DDSFile::Parse(uncompressed, texture));
+        REQUIRE(texture.mips.size() == 1);
+        CHECK(std::equal(image.pixels.begin(), image.pixels.end(), texture.mips[0].data.begin()));
+        CHECK(texture.cookHash == 0);
+    }
+}
+
+TEST_CASE("Textures that are not whole blocks are cooked uncompressed", "[TextureCooker]")
+{
+    const TextureImage image = CreateTestImage(13, 7);
+
+    TextureCookSettings settings;
+    settings.format = CookedFormat::BC7;
+    const std::vector<uint8> dds = TextureCooker::CookImage(image, settings);
+
+    DDSTexture texture;
+    REQUIRE(DDSFile::Parse(dds, texture));
+    CHECK(texture.width == 13);
+    CHECK(texture.height == 7);
+    CHECK(texture.dxgiFormat == DDSFile::GetDXGIFormat(CookedFormat::RGBA8, true));
+    CHECK_FALSE(DDSFile::IsBlockCompressed(texture.dxgiFormat));
+    REQUIRE(texture.mips.size() == TextureMipGenerator::GetMipCount(13, 7));
+    CHECK(std::equal(image.pixels.begin(), image.pixels.end(), texture.mips[0].data.begin()));
+    for (const DDSTexture::Mip& mip : texture.mips)
+        CHECK(mip.data.size() == (uint64)mip.width * mip.height * 4);
+
+    // Linear data like normal maps keeps its format without sRGB.
+    settings.format = CookedFormat::BC5;
+    settings.isSRGB = false;
+    REQUIRE(DDSFile::Parse(TextureCooker::CookImage(image, settings), texture));
+    CHECK(texture.dxgiFormat == DDSFile::GetDXGIFormat(CookedFormat::RGBA8, false));
+}
+
+TEST_CASE("Texture cooking is skipped when nothing changed", "[TextureCooker]")
+{
+    const std::string directory = Engine::GetTempFilePath() + "TextureCookerTests/";
+    std::filesystem::create_directories(directory);
+    const std::string sourcePath = directory + "Source.ppm";
+    const std::string cookedPath = TextureCooker::GetCookedPath(sourcePath);
+    CHECK(cookedPath == directory + "Source.dds");
+    std::filesystem::remove(cookedPath);
+
+    auto writeSource = [&](uint8 value)
+    {
+        std::ofstream stream(sourcePath, std::ios::out | std::ios::binary | std::ios::trunc);
+        stream << "P6\n8 8\n255\n";
+        for (uint32 i = 0; i < 8 * 8; ++i)
+        {
+            const char pixel[3] = { (char)value, (char)(i * 4), (char)(255 - value) };
+            stream.write(pixel, sizeof(pixel));
+        }
+    };
+
+    TextureCookSettings settings;
+    writeSource(10);
+    CHECK(TextureCooker::Cook(sourcePath, cookedPath, settings) == TextureCooker::Result::Cooked);
+    CHECK(TextureCooker::Cook(sourcePath, cookedPath, settings) == TextureCooker::Result::UpToDate);
+    CHECK(TextureCooker::Cook(sourcePath, cookedPath, settings, true) == TextureCooker::Result::Cooked);
+
+    settings.format = CookedFormat::BC1;
+    CHECK(TextureCooker::Cook(sourcePath, cookedPath, settings) == TextureCooker::Result::Cooked);
+
+    writeSource(20);
+    CHECK(TextureCooker::Cook(sourcePath, cookedPath, settings) == TextureCooker::Result::Cooked);
+    CHECK(TextureCooker::Cook(sourcePath, cookedPath, settings) == TextureCooker::Result::UpToDate);
+
+    CHECK(TextureCooker::Cook(directory + "Missing.png", cookedPath, settings) == TextureCooker::Result::Failed);
+}
+
+// Hidden by default, run with: UnitTests.exe "[benchmark]"
+TEST_CASE("Texture cooking throughput", "[.][benchmark][TextureCooker]")
+{
+    const TextureImage image = CreateTestImage(1024, 1024);
+
+    const uint maxThreadCount = ThreadPool::Get()->GetThreadCount() + 1;
+    for (uint threadCount : { 1u, maxThreadCount })
+    {
+        BENCHMARK(Utils::Format("Kaiser mips 1024x1024, {} threads", threadCount))
+        {
+            return TextureMipGenerator::Generate(image, true, MipFilter::Kaiser, threadCount).size();
+        };
+
+        for (BCFormat format : { BCFormat::BC1, BCFormat::BC7 })
+        {
+            BENCHMARK(Utils::Format("BC{} 1024x1024, {} threads", (uint32)format, threadCount))
+            {
+                return BCCompressor::Compress(format, image, threadCount).size();
+            };
+        }
+    }
+}
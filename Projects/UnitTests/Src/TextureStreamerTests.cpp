@@ -0,0 +1,353 @@
+#define RS_THROW_INSTEAD_OF_ASSERT
+
+#include "RSEngine.h"
+#include "Render/TextureStreamer.h"
+#include "Catch2/catch_amalgamated.hpp"
+
+#include <map>
+
+using namespace RS;
+
+namespace
+{
+    constexpr uint64 BytesPerPixel = 4;
+
+    // Square textures named by their size, "1024" is a 1024x1024 texture with 11 mips. Paths starting with "Broken" fail to read their mips
+    // and paths starting with "BC" are block compressed.
+    class FakeSource : public ITextureStreamingSource
+    {
+    public:
+        bool ReadInfo(const std::string& path, StreamedTextureInfo& info) override
+        {
+            const uint32 size = (uint32)std::stoul(path.substr(path.find_first_of("0123456789")));
+            info.width = size;
+            info.height = size;
+            info.blockDimension = path.starts_with("BC") ? 4 : 1;
+            info.mipSizes.clear();
+            for (uint32 mip = 0; (size >> mip) > 0; ++mip)
+                info.mipSizes.push_back(GetMipSize(size, mip));
+            return true;
+        }
+
+        bool ReadMip(const std::string& path, uint32 mip, std::vector<uint8>& data) override
+        {
+            if (path.starts_with("Broken"))
+                return false;
+
+            StreamedTextureInfo info;
+            ReadInfo(path, info);
+            data.assign(info.mipSizes[mip], (uint8)mip);
+            return true;
+        }
+
+        static uint64 GetMipSize(uint32 size, uint32 mip) { return (uint64)(size >> mip) * (size >> mip) * BytesPerPixel; }
+    };
+
+    // Keeps track of what would be in video memory and checks that the streamer only changes the resident range at the detailed end.
+    class FakeDevice : public ITextureStreamingDevice
+    {
+    public:
+        struct Texture
+        {
+            StreamedTextureInfo info;
+            uint32 firstMip = UINT32_MAX;
+        };
+
+        void CreateTexture(StreamedTextureID id, const StreamedTextureInfo& info) override
+        {
+            CHECK(textures.count(id) == 0);
+            textures[id].info = info;
+        }
+
+        void UploadMips(StreamedTextureID id, uint32 firstMip, const std::vector<std::vector<uint8>>& mips) override
+        {
+            REQUIRE(textures.count(id) == 1);
+            Texture& texture = textures[id];
+            const uint32 endMip = texture.firstMip == UINT32_MAX ? (uint32)texture.info.mipSizes.size() : texture.firstMip;
+            CHECK(firstMip + mips.size() == endMip);
+            for (uint32 i = 0; i < (uint32)mips.size(); ++i)
+            {
+                CHECK(mips[i].size() == texture.info.mipSizes[firstMip + i]);
+                CHECK(mips[i].front() == firstMip + i);
+            }
+            CheckFirstMip(texture.info, firstMip);
+            texture.firstMip = firstMip;
+            uploadCount++;
+        }
+
+        void EvictMips(StreamedTextureID id, uint32 firstMip) override
+        {
+            REQUIRE(textures.count(id) == 1);
+            CHECK(firstMip > textures[id].firstMip);
+            CheckFirstMip(textures[id].info, firstMip);
+            textures[id].firstMip = firstMip;
+        }
+
+        void DestroyTexture(StreamedTextureID id) override
+        {
+            CHECK(textures.erase(id) == 1);
+        }
+
+        // The same rule as D3D12 has for the top mip of block compressed textures.
+        static void CheckFirstMip(const StreamedTextureInfo& info, uint32 firstMip)
+        {
+            CHECK((info.width >> firstMip) % info.blockDimension == 0);
+            CHECK((info.height >> firstMip) % info.blockDimension == 0);
+        }
+
+        uint64 GetResidentBytes() const
+        {
+            uint64 bytes = 0;
+            for (auto& [id, texture] : textures)
+            {
+                for (uint32 mip = texture.firstMip; mip < (uint32)texture.info.mipSizes.size(); ++mip)
+                    bytes += texture.info.mipSizes[mip];
+            }
+            return bytes;
+        }
+
+        std::map<StreamedTextureID, Texture> textures;
+        uint32 uploadCount = 0;
+    };
+
+    struct StreamerFixture
+    {
+        StreamerFixture(TextureStreamerSettings settings = TextureStreamerSettings())
+        {
+            pDevice = std::make_shared<FakeDevice>();
+            pSource = std::make_shared<FakeSource>();
+            pStreamer = std::make_unique<TextureStreamer>(pDevice, pSource, settings);
+        }
+
+        // Runs frames until nothing is being read any more, feedback is called at the start of every frame.
+        void RunUntilIdle(const std::function<void()>& feedback = []() {}, uint32 maxFrames = 1000)
+        {
+            for (uint32 frame = 0; frame < maxFrames; ++frame)
+            {
+                feedback();
+                pStreamer->Update();
+                pStreamer->WaitForReads();
+                CHECK(pStreamer->GetStats().residentBytes == pDevice->GetResidentBytes());
+                if (pStreamer->GetStats().requestsInFlight == 0)
+                    return;
+            }
+            FAIL("The streamer never became idle");
+        }
+
+        std::shared_ptr<FakeDevice> pDevice;
+        std::shared_ptr<FakeSource> pSource;
+        std::unique_ptr<TextureStreamer> pStreamer;
+    };
+
+    TextureStreamerSettings SynchronousSettings()
+    {
+        TextureStreamerSettings settings;
+        settings.ioThreadCount = 0;
+        return settings;
+    }
+}
+
+TEST_CASE("Texture streaming loads the mip tail first", "[TextureStreamer]")
+{
+    StreamerFixture fixture(SynchronousSettings());
+    TextureStreamer& streamer = *fixture.pStreamer;
+
+    const StreamedTextureID id = streamer.Register("1024");
+    const StreamedTextureID smallID = streamer.Register("32");
+    REQUIRE(id != InvalidStreamedTextureID);
+    CHECK(streamer.GetFirstResidentMip(id) == UINT32_MAX);
+
+    fixture.RunUntilIdle();
+
+    // 64x64 and smaller is the tail.
+    CHECK(streamer.GetFirstResidentMip(id) == 4);
+    CHECK(streamer.GetFirstResidentMip(smallID) == 0);
+    CHECK(fixture.pDevice->uploadCount == 2);
+
+    // Without feedback nothing more is read.
+    fixture.RunUntilIdle();
+    CHECK(streamer.GetFirstResidentMip(id) == 4);
+
+    streamer.Unregister(smallID);
+    CHECK(fixture.pDevice->textures.count(smallID) == 0);
+    CHECK(streamer.GetStats().residentBytes == fixture.pDevice->GetResidentBytes());
+}
+
+TEST_CASE("Texture streaming keeps block compressed mips whole blocks", "[TextureStreamer]")
+{
+    StreamerFixture fixture(SynchronousSettings());
+    TextureStreamer& streamer = *fixture.pStreamer;
+
+    // 1000 >> 2 is 250, which is not a multiple of 4, so mip 1 is the smallest one that can be the first resident mip.
+    const StreamedTextureID id = streamer.Register("BC1000");
+    const StreamedTextureID powerOfTwoID = streamer.Register("BC1024");
+    fixture.RunUntilIdle();
+    CHECK(streamer.GetFirstResidentMip(id) == 1);
+    CHECK(streamer.GetFirstResidentMip(powerOfTwoID) == 4);
+
+    // The tail is never evicted, even when the budget is too small for it.
+    streamer.SetBudget(0);
+    fixture.RunUntilIdle();
+    CHECK(streamer.GetFirstResidentMip(id) == 1);
+
+    streamer.SetBudget(TextureStreamerSettings().budgetBytes);
+    fixture.RunUntilIdle([&]() { streamer.ReportDesiredMip(id, 0); });
+    CHECK(streamer.GetFirstResidentMip(id) == 0);
+}
+
+TEST_CASE("Texture streaming follows the feedback", "[TextureStreamer]")
+{
+    TextureStreamerSettings settings = SynchronousSettings();
+    settings.maxRequestsInFlight = 1;
+    StreamerFixture fixture(settings);
+    TextureStreamer& streamer = *fixture.pStreamer;
+
+    const StreamedTextureID near = streamer.Register("1024");
+    const StreamedTextureID far = streamer.Register("1024");
+    fixture.RunUntilIdle();
+
+    SECTION("Screen size picks the mip")
+    {
+        fixture.RunUntilIdle([&]() { streamer.ReportScreenSize(near, 1000.f); streamer.ReportScreenSize(far, 200.f); });
+        CHECK(streamer.GetFirstResidentMip(near) == 0);
+        CHECK(streamer.GetFirstResidentMip(far) == 2);
+        CHECK(streamer.GetDesiredMip(far) == 2);
+    }
+
+    SECTION("The most blurry texture goes first")
+    {
+        auto feedback = [&]() { streamer.ReportDesiredMip(near, 0); streamer.ReportDesiredMip(far, 2); };
+
+        // near is 4 mips away and far is 2, so far only gets a read once near is as close as it is.
+        std::vector<std::pair<uint32, uint32>> order;
+        for (uint32 frame = 0; frame < 20; ++frame)
+        {
+            feedback();
+            streamer.Update();
+            order.emplace_back(streamer.GetFirstResidentMip(near), streamer.GetFirstResidentMip(far));
+        }
+        CHECK(order[0] == std::make_pair(4u, 4u));
+        CHECK(order[1] == std::make_pair(3u, 4u));
+        CHECK(order[2] == std::make_pair(2u, 4u));
+        CHECK(order.back() == std::make_pair(0u, 2u));
+    }
+
+    SECTION("Mips stay when the feedback stops and there is room")
+    {
+        fixture.RunUntilIdle([&]() { streamer.ReportDesiredMip(near, 0); });
+        fixture.RunUntilIdle();
+        CHECK(streamer.GetFirstResidentMip(near) == 0);
+        CHECK(streamer.GetStats().evictedMipCount == 0);
+    }
+}
+
+TEST_CASE("Texture streaming stays under the budget", "[TextureStreamer]")
+{
+    const uint64 fullTextureBytes = 1024 * 1024 * 4 * 4 / 3 + 4;
+
+    TextureStreamerSettings settings = SynchronousSettings();
+    settings.budgetBytes = fullTextureBytes + 512 * 1024;
+    StreamerFixture fixture(settings);
+    TextureStreamer& streamer = *fixture.pStreamer;
+
+    const StreamedTextureID a = streamer.Register("1024");
+    const StreamedTextureID b = streamer.Register("1024");
+    const StreamedTextureID c = streamer.Register("1024");
+
+    fixture.RunUntilIdle([&]() { streamer.ReportDesiredMip(a, 0); });
+    CHECK(streamer.GetFirstResidentMip(a) == 0);
+    CHECK(streamer.GetStats().residentBytes <= settings.budgetBytes);
+
+    SECTION("Unused mips are evicted to make room")
+    {
+        fixture.RunUntilIdle([&]() { streamer.ReportDesiredMip(b, 0); });
+        CHECK(streamer.GetFirstResidentMip(b) == 0);
+        CHECK(streamer.GetFirstResidentMip(a) > 0);
+        CHECK(streamer.GetStats().evictedMipCount > 0);
+        CHECK(streamer.GetStats().residentBytes <= settings.budgetBytes);
+        // The tail is never evicted.
+        CHECK(streamer.GetFirstResidentMip(a) <= 4);
+    }
+
+    SECTION("Least recently used goes first")
+    {
+        // a and b fit at mip 1, then c needs room. b was used more recently, so a loses more.
+        streamer.SetBudget(3 * 1024 * 1024);
+        fixture.RunUntilIdle([&]() { streamer.ReportDesiredMip(a, 1); streamer.ReportDesiredMip(b, 1); });
+        streamer.ReportDesiredMip(a, 1);
+        streamer.Update();
+        streamer.ReportDesiredMip(b, 1);
+        streamer.Update();
+        fixture.RunUntilIdle([&]() { streamer.ReportDesiredMip(c, 1); });
+        CHECK(streamer.GetFirstResidentMip(c) == 1);
+        CHECK(streamer.GetFirstResidentMip(a) > streamer.GetFirstResidentMip(b));
+        CHECK(streamer.GetStats().residentBytes <= settings.budgetBytes);
+    }
+
+    SECTION("Mips that are asked for are not evicted")
+    {
+        // Both want everything, only one fits. The first one keeps what it has and the other waits at a lower mip.
+        fixture.RunUntilIdle([&]() { streamer.ReportDesiredMip(a, 0); streamer.ReportDesiredMip(b, 0); });
+        CHECK(streamer.GetFirstResidentMip(a) == 0);
+        CHECK(streamer.GetFirstResidentMip(b) > 0);
+        CHECK(streamer.GetStats().evictedMipCount == 0);
+    }
+
+    SECTION("Lowering the budget evicts")
+    {
+        streamer.SetBudget(1024 * 1024);
+        fixture.RunUntilIdle();
+        CHECK(streamer.GetStats().residentBytes <= 1024 * 1024);
+        CHECK(streamer.GetFirstResidentMip(a) == 2);
+    }
+}
+
+TEST_CASE("Texture streaming handles reads that fail or are not needed", "[TextureStreamer]")
+{
+    StreamerFixture fixture(SynchronousSettings());
+    TextureStreamer& streamer = *fixture.pStreamer;
+
+    const StreamedTextureID broken = streamer.Register("Broken256");
+    const StreamedTextureID id = streamer.Register("256");
+    fixture.RunUntilIdle([&]() { streamer.ReportDesiredMip(broken, 0); });
+    CHECK(streamer.GetFirstResidentMip(broken) == UINT32_MAX);
+    CHECK(streamer.GetFirstResidentMip(id) == 2);
+
+    // The read is started in the Update and the texture is gone before the result is uploaded.
+    streamer.ReportDesiredMip(id, 0);
+    streamer.Update();
+    streamer.Unregister(id);
+    fixture.RunUntilIdle();
+    CHECK(streamer.GetStats().pendingBytes == 0);
+    CHECK(streamer.GetStats().residentBytes == 0);
+}
+
+TEST_CASE("Texture streaming reads on background threads", "[TextureStreamer]")
+{
+    TextureStreamerSettings settings;
+    settings.ioThreadCount = 2;
+    settings.maxUploadBytesPerUpdate = 1024 * 1024;
+    settings.budgetBytes = 8 * 1024 * 1024;
+    StreamerFixture fixture(settings);
+    TextureStreamer& streamer = *fixture.pStreamer;
+
+    std::vector<StreamedTextureID> ids;
+    for (uint32 i = 0; i < 32; ++i)
+        ids.push_back(streamer.Register(i % 2 == 0 ? "512" : "1024"));
+
+    // Different textures are close to the camera over time.
+    uint32 frame = 0;
+    fixture.RunUntilIdle([&]()
+        {
+            for (uint32 i = 0; i < 32; ++i)
+                streamer.ReportScreenSize(ids[i], (float)((i + std::min(frame, 200u) / 10) % 32) * 32.f);
+            frame++;
+        });
+
+    const TextureStreamerStats stats = streamer.GetStats();
+    CHECK(stats.residentBytes <= settings.budgetBytes);
+    CHECK(stats.pendingBytes == 0);
+    CHECK(stats.uploadedMipCount > 32);
+    for (StreamedTextureID id : ids)
+        CHECK(streamer.GetFirstResidentMip(id) != UINT32_MAX);
+}
@@ -0,0 +1,60 @@
+#define RS_THROW_INSTEAD_OF_ASSERT
+
+#include "RSEngine.h"
+#include "Core/ThreadPool.h"
+#include "Catch2/catch_amalgamated.hpp"
+
+#include <atomic>
+#include <stdexcept>
+
+TEST_CASE("ParallelFor visits every index once", "[ThreadPool]")
+{
+    std::shared_ptr<RS::ThreadPool> pThreadPool = RS::ThreadPool::Get();
+
+    for (uint maxThreads : { 1u, 2u, 0u })
+    {
+        std::vector<std::atomic<uint32>> visits(10000);
+        pThreadPool->ParallelFor(visits.size(), [&](uint64 index) { visits[index]++; }, maxThreads);
+
+        bool allVisitedOnce = std::all_of(visits.begin(), visits.end(), [](const std::atomic<uint32>& v) { return v.load() == 1; });
+        CHECK(allVisitedOnce);
+    }
+
+    SECTION("Nested ParallelFor does not dead lock")
+    {
+        std::atomic<uint64> sum = 0;
+        pThreadPool->ParallelFor(64, [&](uint64)
+            {
+                pThreadPool->ParallelFor(64, [&](uint64 index) { sum += index; });
+            });
+        CHECK(sum.load() == 64 * (63 * 64 / 2));
+    }
+
+    SECTION("Submit returns the result")
+    {
+        std::future<int> future = pThreadPool->Submit([]() { return 42; });
+        CHECK(future.get() == 42);
+    }
+}
+
+TEST_CASE("ParallelFor rethrows on the calling thread", "[ThreadPool]")
+{
+    std::shared_ptr<RS::ThreadPool> pThreadPool = RS::ThreadPool::Get();
+
+    for (uint maxThreads : { 1u, 2u, 0u })
+    {
+        std::atomic<uint64> calls = 0;
+        REQUIRE_THROWS_AS(pThreadPool->ParallelFor(1000, [&](uint64 index)
+            {
+                calls++;
+                if (index == 10)
+                    throw std::runtime_error("ParallelFor test");
+            }, maxThreads), std::runtime_error);
+        CHECK(calls.load() <= 1000);
+    }
+
+    // Every job was counted as done, the pool is still usable.
+    std::atomic<uint64> sum = 0;
+    pThreadPool->ParallelFor(100, [&](uint64 index) { sum += index; });
+    CHECK(sum.load() == 99 * 100 / 2);
+}
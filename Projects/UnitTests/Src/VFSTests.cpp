@@ -0,0 +1,293 @@
+#define RS_THROW_INSTEAD_OF_ASSERT
+
+#include "RSEngine.h"
+#include "Core/VFS.h"
+#include "Core/PakFile.h"
+#include "Utils/Misc/LZ4Utils.h"
+#include "Catch2/catch_amalgamated.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <chrono>
+#include <functional>
+
+using namespace RS;
+
+namespace
+{
+    std::string GetTestDirectory()
+    {
+        std::string path = Engine::GetTempFilePath() + "VFSTests/";
+        std::filesystem::create_directories(path);
+        return path;
+    }
+
+    void WriteFile(const std::string& path, const std::vector<uint8>& data)
+    {
+        std::filesystem::create_directories(std::filesystem::path(path).parent_path());
+        std::ofstream stream(path, std::ios::out | std::ios::binary | std::ios::trunc);
+        stream.write((const char*)data.data(), data.size());
+    }
+
+    std::vector<uint8> CreateTextData(uint64 size)
+    {
+        const std::string text = "float4 main(float4 position : SV_POSITION) : SV_TARGET { return position; }\n";
+        std::vector<uint8> data(size);
+        for (uint64 i = 0; i < size; ++i)
+            data[i] = (uint8)text[i % text.size()];
+        return data;
+    }
+
+    std::vector<uint8> CreateNoiseData(uint64 size)
+    {
+        std::vector<uint8> data(size);
+        uint32 state = 0x12345678;
+        for (uint8& value : data)
+        {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            value = (uint8)state;
+        }
+        return data;
+    }
+
+    bool IsEqual(const std::shared_ptr<VFSFile>& pFile, const std::vector<uint8>& data)
+    {
+        return pFile && pFile->GetSize() == data.size() && std::equal(data.begin(), data.end(), pFile->GetPtr());
+    }
+}
+
+TEST_CASE("LZ4 round trip", "[VFS]")
+{
+    for (const std::vector<uint8>& data : { std::vector<uint8>(), CreateTextData(5), CreateTextData(100000), CreateNoiseData(70000), std::vector<uint8>(1 << 20, 7) })
+    {
+        std::vector<uint8> compressed(Utils::LZ4CompressBound(data.size()));
+        uint64 compressedSize = Utils::LZ4Compress(data.data(), data.size(), compressed.data(), compressed.size());
+        REQUIRE((compressedSize > 0 || data.empty()));
+        compressed.resize(compressedSize);
+
+        std::vector<uint8> decompressed(data.size());
+        CHECK(Utils::LZ4Decompress(compressed.data(), compressed.size(), decompressed.data(), decompressed.size()));
+        CHECK(decompressed == data);
+    }
+
+    SECTION("Repetitive data gets smaller")
+    {
+        std::vector<uint8> data = CreateTextData(100000);
+        std::vector<uint8> compressed(Utils::LZ4CompressBound(data.size()));
+        CHECK(Utils::LZ4Compress(data.data(), data.size(), compressed.data(), compressed.size()) < data.size() / 4);
+    }
+
+    SECTION("Corrupt data is rejected")
+    {
+        std::vector<uint8> data = CreateTextData(4096);
+        std::vector<uint8> compressed(Utils::LZ4CompressBound(data.size()));
+        compressed.resize(Utils::LZ4Compress(data.data(), data.size(), compressed.data(), compressed.size()));
+
+        std::vector<uint8> decompressed(data.size());
+        CHECK_FALSE(Utils::LZ4Decompress(compressed.data(), compressed.size() / 2, decompressed.data(), decompressed.size()));
+        CHECK_FALSE(Utils::LZ4Decompress(compressed.data(), compressed.size(), decompressed.data(), decompressed.size() - 1));
+    }
+}
+
+TEST_CASE("Pak write and read", "[VFS]")
+{
+    const std::string pakPath = GetTestDirectory() + "Test.pak";
+    const std::vector<uint8> text = CreateTextData(20000);
+    const std::vector<uint8> noise = CreateNoiseData(3000);
+
+    PakWriter writer;
+    writer.SetAlignment(64);
+    writer.AddData("Shaders/Text.hlsl", text, PakCompression::LZ4);
+    writer.AddData("Textures/Noise.bin", noise, PakCompression::LZ4);
+    writer.AddData("Textures/Raw.bin", text);
+    writer.AddData("Empty.txt", {});
+    writer.AddData("./Textures/../Replaced.bin", noise);
+    writer.AddData("Replaced.bin", text);
+    CHECK(writer.GetEntryCount() == 5);
+    REQUIRE(writer.Write(pakPath));
+
+    PakFileProvider pak;
+    REQUIRE(pak.Load(pakPath));
+    CHECK(pak.GetEntryCount() == 5);
+
+    CHECK(pak.FindEntry("Shaders/Text.hlsl")->compression == PakCompression::LZ4);
+    CHECK(pak.FindEntry("Shaders/Text.hlsl")->storedSize < text.size());
+    // Noise does not compress, so it is stored as it is.
+    CHECK(pak.FindEntry("Textures/Noise.bin")->compression == PakCompression::None);
+
+    for (const char* pPath : { "Shaders/Text.hlsl", "Textures/Noise.bin", "Textures/Raw.bin", "Empty.txt", "Replaced.bin" })
+        CHECK(pak.FindEntry(pPath)->dataOffset % 64 == 0);
+
+    CHECK(IsEqual(pak.Open("Shaders/Text.hlsl"), text));
+    CHECK(IsEqual(pak.Open("Textures/Noise.bin"), noise));
+    CHECK(IsEqual(pak.Open("Textures/Raw.bin"), text));
+    CHECK(IsEqual(pak.Open("Empty.txt"), {}));
+    CHECK(IsEqual(pak.Open("Replaced.bin"), text));
+    CHECK(pak.Open("Missing.bin") == nullptr);
+    CHECK_FALSE(pak.Exists("Missing.bin"));
+
+    SECTION("Uncompressed entries point into the mapping")
+    {
+        std::shared_ptr<VFSFile> pFirst = pak.Open("Textures/Raw.bin");
+        std::shared_ptr<VFSFile> pSecond = pak.Open("Textures/Raw.bin");
+        CHECK(pFirst->GetPtr() == pSecond->GetPtr());
+    }
+
+    SECTION("Files outlive the provider")
+    {
+        std::shared_ptr<VFSFile> pFile;
+        {
+            PakFileProvider scopedPak;
+            REQUIRE(scopedPak.Load(pakPath));
+            pFile = scopedPak.Open("Textures/Raw.bin");
+        }
+        CHECK(IsEqual(pFile, text));
+    }
+
+    SECTION("Corrupt table of contents is rejected")
+    {
+        std::vector<uint8> pakData;
+        {
+            std::shared_ptr<VFSFile> pFile = VFS::Get()->Open(pakPath);
+            pakData.assign(pFile->GetPtr(), pFile->GetPtr() + pFile->GetSize());
+        }
+        pakData[pakData.size() - 3] ^= 0xFF;
+
+        const std::string corruptPath = GetTestDirectory() + "Corrupt.pak";
+        WriteFile(corruptPath, pakData);
+        PakFileProvider corruptPak;
+        CHECK_FALSE(corruptPak.Load(corruptPath));
+    }
+}
+
+TEST_CASE("VFS mount priority and disk fallback", "[VFS]")
+{
+    const std::string directory = GetTestDirectory() + "Mounts/";
+    const std::vector<uint8> diskData = CreateTextData(100);
+    const std::vector<uint8> pakData = CreateTextData(200);
+    WriteFile(directory + "Loose/File.txt", diskData);
+    WriteFile(directory + "Loose/OnlyLoose.txt", diskData);
+
+    PakWriter writer;
+    writer.AddData("File.txt", pakData);
+    REQUIRE(writer.Write(directory + "Data.pak"));
+
+    VFS vfs;
+    // Without mounts the paths are read from disk as they are.
+    CHECK(IsEqual(vfs.Open(directory + "Loose/File.txt"), diskData));
+
+    REQUIRE(vfs.MountDirectory("Data", directory + "Loose"));
+    CHECK(IsEqual(vfs.Open("Data/File.txt"), diskData));
+
+    REQUIRE(vfs.MountPak("Data/", directory + "Data.pak"));
+    CHECK(IsEqual(vfs.Open("Data/File.txt"), pakData));
+    CHECK(IsEqual(vfs.Open("./Data/Sub/../File.txt"), pakData));
+    CHECK(IsEqual(vfs.Open("Data/OnlyLoose.txt"), diskData));
+    CHECK(vfs.Exists("Data/OnlyLoose.txt"));
+    CHECK_FALSE(vfs.Exists("Data/Missing.txt"));
+
+    vfs.SetDiskFallback(false);
+    CHECK(vfs.Open(directory + "Loose/File.txt") == nullptr);
+    vfs.SetDiskFallback(true);
+
+    vfs.Unmount("Data");
+    CHECK(vfs.Open("Data/File.txt") == nullptr);
+    CHECK(IsEqual(vfs.Open(directory + "Loose/File.txt"), diskData));
+}
+
+// Hidden by default, run with: UnitTests.exe "[benchmark]"
+// The first pass is only cold if the OS file cache has been flushed before the run, e.g. with RAMMap "Empty Standby List".
+TEST_CASE("Asset load times, fread vs VFS", "[.][benchmark][VFS]")
+{
+    const std::string dataPath = Engine::GetDataFilePath(true);
+    std::vector<std::string> paths;
+    for (const std::string& directory : { std::string(RS_TEXTURE_PATH), std::string(RS_MODEL_PATH), std::string(RS_FONT_PATH) })
+    {
+        if (!std::filesystem::is_directory(dataPath + directory))
+            continue;
+        for (const std::filesystem::directory_entry& entry : std::filesystem::recursive_directory_iterator(dataPath + directory))
+        {
+            if (entry.is_regular_file())
+                paths.push_back(std::filesystem::relative(entry.path(), dataPath).generic_string());
+        }
+    }
+    REQUIRE_FALSE(paths.empty());
+
+    const std::string directory = GetTestDirectory();
+    for (PakCompression compression : { PakCompression::None, PakCompression::LZ4 })
+    {
+        PakWriter writer;
+        REQUIRE(writer.AddDirectory(dataPath, compression));
+        REQUIRE(writer.Write(directory + (compression == PakCompression::None ? "Stored.pak" : "LZ4.pak")));
+    }
+
+    // What CorePlatform::LoadBinaryFile used to do.
+    auto loadFread = [&]() -> uint64
+    {
+        uint64 checksum = 0;
+        for (const std::string& path : paths)
+        {
+            FILE* pFile = fopen((dataPath + path).c_str(), "rb");
+            fseek(pFile, 0, SEEK_END);
+            uint64 size = (uint64)ftell(pFile);
+            fseek(pFile, 0, SEEK_SET);
+            std::unique_ptr<uint8[]> pData = std::make_unique<uint8[]>(size);
+            fread(pData.get(), 1, size, pFile);
+            fclose(pFile);
+            checksum += size > 0 ? pData[size - 1] : 0;
+        }
+        return checksum;
+    };
+
+    // Touches the last byte, so the pages that are read are the same for all of them.
+    auto loadVFS = [&](VFS& vfs, const std::string& prefix) -> uint64
+    {
+        uint64 checksum = 0;
+        for (const std::string& path : paths)
+        {
+            std::shared_ptr<VFSFile> pFile = vfs.Open(prefix + path);
+            checksum += pFile->GetSize() > 0 ? pFile->GetPtr()[pFile->GetSize() - 1] : 0;
+        }
+        return checksum;
+    };
+
+    VFS looseVFS;
+    VFS storedVFS;
+    VFS lz4VFS;
+    REQUIRE(storedVFS.MountPak("Data", directory + "Stored.pak"));
+    REQUIRE(lz4VFS.MountPak("Data", directory + "LZ4.pak"));
+    storedVFS.SetDiskFallback(false);
+    lz4VFS.SetDiskFallback(false);
+
+    struct Loader
+    {
+        std::string name;
+        std::function<uint64()> load;
+    };
+    const std::vector<Loader> loaders = {
+        { "fread", loadFread },
+        { "VFS loose", [&]() { return loadVFS(looseVFS, dataPath); } },
+        { "VFS pak", [&]() { return loadVFS(storedVFS, "Data/"); } },
+        { "VFS pak LZ4", [&]() { return loadVFS(lz4VFS, "Data/"); } },
+    };
+
+    const uint64 expectedChecksum = loadFread();
+    for (const Loader& loader : loaders)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        const uint64 checksum = loader.load();
+        auto duration = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start);
+        CHECK(checksum == expectedChecksum);
+        LOG_INFO("First pass, {} files, {}: {:.3f} ms", paths.size(), loader.name, duration.count());
+    }
+
+    for (const Loader& loader : loaders)
+    {
+        BENCHMARK(Utils::Format("Warm, {} files, {}", paths.size(), loader.name))
+        {
+            return loader.load();
+        };
+    }
+}